@@ -39,6 +39,27 @@ typedef struct {
   void *ptr;
 } AddrSpace;
 
+// An access to the device register @reg, submitted by ioe_batch()
+typedef struct {
+  int reg;
+  void *buf;
+} IOEOp;
+
+// A FIFO spinlock: take a ticket from @next, wait until @owner reaches it
+typedef struct {
+  int next, owner;
+} TicketLock;
+
+// A queue spinlock, where each CPU spins on its own MCSNode
+typedef struct MCSNode {
+  struct MCSNode *next;
+  int locked;
+} MCSNode;
+
+typedef struct {
+  MCSNode *tail;
+} MCSLock;
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -52,6 +73,7 @@ void     halt        (int code) __attribute__((__noreturn__));
 bool     ioe_init    (void);
 void     ioe_read    (int reg, void *buf);
 void     ioe_write   (int reg, void *buf);
+void     ioe_batch   (IOEOp *ops, int n);
 #include "amdev.h"
 
 // ---------- CTE: Interrupt Handling and Context Switching ----------
@@ -73,6 +95,14 @@ bool     mpe_init    (void (*entry)());
 int      cpu_count   (void);
 int      cpu_current (void);
 int      atomic_xchg (int *addr, int newval);
+int      atomic_xadd (int *addr, int delta);
+int      atomic_load_acq (int *addr);
+void     atomic_store_rel(int *addr, int val);
+void     cpu_relax   (void);
+void     ticket_lock (TicketLock *lk);
+void     ticket_unlock(TicketLock *lk);
+void     mcs_lock    (MCSLock *lk, MCSNode *node);
+void     mcs_unlock  (MCSLock *lk, MCSNode *node);
 
 #ifdef __cplusplus
 }
@@ -1,4 +1,7 @@
+#define _GNU_SOURCE
 #include <sys/time.h>
+#include <time.h>
+#include <unistd.h>
 #include <string.h>
 #include "platform.h"
 
@@ -83,10 +86,24 @@ static void setup_stack(uintptr_t event, ucontext_t *uc) {
   AM_REG_SP(uc)   = (uintptr_t)c;
 }
 
+#ifdef __x86_64__
+// getcontext() points the FPU context into the ucontext itself,
+// so this only holds for the contexts saved by yield()
+static bool saved_by_yield(Context *c) {
+  return c->uc.uc_mcontext.fpregs == &c->uc.__fpregs_mem;
+}
+#endif
+
 static void iret(ucontext_t *uc) {
   Context *c = (void *)AM_REG_GPR1(uc);
   // restore the context
   *uc = c->uc;
+#ifdef __x86_64__
+  // getcontext() does not save the FPU context in the format of a signal
+  // frame, so reset the FPU, whose registers are caller-saved across the
+  // call to yield() anyway
+  if (saved_by_yield(c)) uc->uc_mcontext.fpregs = NULL;
+#endif
   thiscpu->ksp = c->ksp;
   if (__am_in_userspace((void *)AM_REG_PC(uc))) __am_pmem_protect();
 }
@@ -153,6 +170,26 @@ void __am_init_timer_irq() {
   it.it_value.tv_sec = 0;
   it.it_value.tv_usec = 1000000 / TIMER_HZ;
   it.it_interval = it.it_value;
+  if (__am_mpe_thread) {
+    // ITIMER_VIRTUAL is shared by the threads, so each CPU thread has a
+    // timer of its own CPU time, sending the signal to that thread
+    struct itimerval off = {};
+    int ret = setitimer(ITIMER_VIRTUAL, &off, NULL);
+    assert(ret == 0);
+    struct sigevent sev = {};
+    sev.sigev_notify = SIGEV_THREAD_ID;
+    sev.sigev_signo = SIGVTALRM;
+    sev._sigev_un._tid = gettid();
+    timer_t timer;
+    ret = timer_create(CLOCK_THREAD_CPUTIME_ID, &sev, &timer);
+    assert(ret == 0);
+    struct itimerspec its = {};
+    its.it_value.tv_nsec = it.it_value.tv_usec * 1000;
+    its.it_interval = its.it_value;
+    ret = timer_settime(timer, 0, &its, NULL);
+    assert(ret == 0);
+    return;
+  }
   int ret = setitimer(ITIMER_VIRTUAL, &it, NULL);
   assert(ret == 0);
 }
@@ -183,7 +220,48 @@ Context* kcontext(Area kstack, void (*entry)(void *), void *arg) {
 }
 
 void yield() {
+#ifdef __x86_64__
+  // yield() is a function call, so it is enough to save the callee-saved
+  // registers and the return point, which getcontext() does without going
+  // through the signal delivery of the kernel
+  Context c;
+  volatile bool resumed = false;
+  // getcontext() leaves the segment registers and the flags untouched,
+  // take them from the example context to be restorable by a signal return
+  __am_get_example_uc(&c);
+  int ret = getcontext(&c.uc);
+  // the return value is undefined if resumed by a signal return
+  if (resumed) return;
+  assert(ret == 0);
+  resumed = true;
+
+  iset(0);
+  c.vm_head = thiscpu->vm_head;
+  c.ksp = thiscpu->ksp;
+  thiscpu->ev = (Event) { .event = EVENT_YIELD };
+  Context *next = user_handler(thiscpu->ev, &c);
+  assert(next != NULL);
+
+  __am_switch(next);
+
+  if (next == &c) {
+    // restore the interrupt state saved by getcontext()
+    ret = sigprocmask(SIG_SETMASK, &c.uc.uc_sigmask, NULL);
+    assert(ret == 0);
+    return;
+  }
+  if (saved_by_yield(next)) {
+    thiscpu->ksp = next->ksp;
+    setcontext(&next->uc);
+    __am_panic_on_return();
+  }
+  // the context is saved by a signal, all registers should be restored
+  void (*p)(Context *c) = (void *)(uintptr_t)0x100008;
+  p(next);
+  __am_panic_on_return();
+#else
   raise(SIGUSR2);
+#endif
 }
 
 bool ienabled() {
@@ -10,6 +10,7 @@ void __am_input_init();
 void __am_uart_init();
 void __am_audio_init();
 void __am_disk_init();
+void __am_net_init();
 void __am_input_config(AM_INPUT_CONFIG_T *);
 void __am_timer_config(AM_TIMER_CONFIG_T *);
 void __am_timer_rtc(AM_TIMER_RTC_T *);
@@ -28,7 +29,10 @@ void __am_audio_play(AM_AUDIO_PLAY_T *);
 void __am_disk_config(AM_DISK_CONFIG_T *cfg);
 void __am_disk_status(AM_DISK_STATUS_T *stat);
 void __am_disk_blkio(AM_DISK_BLKIO_T *io);
-static void __am_net_config (AM_NET_CONFIG_T *cfg)    { cfg->present = false; }
+void __am_net_config(AM_NET_CONFIG_T *cfg);
+void __am_net_status(AM_NET_STATUS_T *stat);
+void __am_net_tx(AM_NET_TX_T *tx);
+void __am_net_rx(AM_NET_RX_T *rx);
 
 typedef void (*handler_t)(void *buf);
 static void *lut[128] = {
@@ -51,6 +55,9 @@ static void *lut[128] = {
   [AM_DISK_STATUS ] = __am_disk_status,
   [AM_DISK_BLKIO  ] = __am_disk_blkio,
   [AM_NET_CONFIG  ] = __am_net_config,
+  [AM_NET_STATUS  ] = __am_net_status,
+  [AM_NET_TX      ] = __am_net_tx,
+  [AM_NET_RX      ] = __am_net_rx,
 };
 
 bool ioe_init() {
@@ -71,6 +78,7 @@ void __am_ioe_init() {
   __am_uart_init();
   __am_audio_init();
   __am_disk_init();
+  __am_net_init();
   ioe_init_done = true;
 }
 
@@ -83,3 +91,10 @@ static void do_io(int reg, void *buf) {
 
 void ioe_read (int reg, void *buf) { do_io(reg, buf); }
 void ioe_write(int reg, void *buf) { do_io(reg, buf); }
+
+void ioe_batch(IOEOp *ops, int n) {
+  if (!ioe_init_done) {
+    __am_ioe_init();
+  }
+  for (int i = 0; i < n; i++) ((handler_t)lut[ops[i].reg])(ops[i].buf);
+}
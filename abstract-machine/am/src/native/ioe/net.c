@@ -0,0 +1,58 @@
+#include <am.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+// Frames go through a UNIX datagram socket bound at $net, and are sent
+// to the last peer which has sent one to it. They are copied once, by
+// the socket calls on the buffers of the callers.
+static int net_fd = -1;
+static struct sockaddr_un peer = {};
+static socklen_t peer_len = 0;
+
+void __am_net_init() {
+  const char *path = getenv("net");
+  if (path == NULL) return;
+  net_fd = socket(AF_UNIX, SOCK_DGRAM, 0);
+  if (net_fd < 0) return;
+  struct sockaddr_un addr = { .sun_family = AF_UNIX };
+  strncpy(addr.sun_path, path, sizeof(addr.sun_path) - 1);
+  unlink(path);
+  if (bind(net_fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+    close(net_fd);
+    net_fd = -1;
+  }
+}
+
+void __am_net_config(AM_NET_CONFIG_T *cfg) {
+  cfg->present = (net_fd >= 0);
+}
+
+void __am_net_status(AM_NET_STATUS_T *stat) {
+  int n = 0;
+  if (net_fd >= 0 && ioctl(net_fd, FIONREAD, &n) != 0) n = 0;
+  stat->rx_len = n;
+  stat->tx_len = 0;
+}
+
+void __am_net_tx(AM_NET_TX_T *tx) {
+  if (net_fd < 0 || peer_len == 0) return;
+  sendto(net_fd, tx->buf.start, tx->buf.end - tx->buf.start, 0, (struct sockaddr *)&peer, peer_len);
+}
+
+// the end of the buffer is moved to the end of the frame received,
+// which is the start of the buffer if no frame is pending
+void __am_net_rx(AM_NET_RX_T *rx) {
+  ssize_t n = -1;
+  if (net_fd >= 0) {
+    struct sockaddr_un from;
+    socklen_t from_len = sizeof(from);
+    n = recvfrom(net_fd, rx->buf.start, rx->buf.end - rx->buf.start, MSG_DONTWAIT,
+        (struct sockaddr *)&from, &from_len);
+    if (n >= 0 && from_len > sizeof(sa_family_t)) { peer = from; peer_len = from_len; }
+  }
+  rx->buf.end = rx->buf.start + (n > 0 ? n : 0);
+}
@@ -1,12 +1,57 @@
 #include <stdatomic.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
 #include "platform.h"
 
 int __am_mpe_init = 0;
+bool __am_mpe_thread = false;
 extern bool __am_has_ioe;
 void __am_ioe_init();
 
+/* With `mpe=thread`, the CPUs are threads of one process instead of
+ * processes forked from CPU #0. Switching between them and sending them
+ * signals is cheaper, but they share the address space, so VME can not be
+ * used with more than one CPU. */
+static void (*mpe_entry)() = NULL;
+static pthread_barrier_t mpe_barrier;
+
+static void *cpu_thread(void *arg) {
+  __am_init_cpu((intptr_t)arg);
+  __am_init_timer_irq();
+  pthread_barrier_wait(&mpe_barrier);
+  mpe_entry();
+  panic("MP entry should not return\n");
+}
+
+static bool mpe_init_thread(void (*entry)()) {
+  mpe_entry = entry;
+  int ret = pthread_barrier_init(&mpe_barrier, NULL, cpu_count());
+  assert(ret == 0);
+  // move the timer of CPU #0 from the process to its thread
+  __am_init_timer_irq();
+  for (intptr_t i = 1; i < cpu_count(); i++) {
+    pthread_t t;
+    ret = pthread_create(&t, NULL, cpu_thread, (void *)i);
+    assert(ret == 0);
+  }
+
+  if (__am_has_ioe) {
+    __am_ioe_init();
+  }
+  pthread_barrier_wait(&mpe_barrier);
+
+  entry();
+  panic("MP entry should not return\n");
+}
+
 bool mpe_init(void (*entry)()) {
   __am_mpe_init = 1;
+  const char *mode = getenv("mpe");
+  if (mode && strcmp(mode, "thread") == 0) {
+    __am_mpe_thread = true;
+    return mpe_init_thread(entry);
+  }
 
   int sync_pipe[2];
   assert(0 == pipe(sync_pipe));
@@ -49,3 +94,59 @@ int cpu_current() {
 int atomic_xchg(int *addr, int newval) {
   return atomic_exchange((int *)addr, newval);
 }
+
+int atomic_xadd(int *addr, int delta) {
+  return atomic_fetch_add(addr, delta);
+}
+
+int atomic_load_acq(int *addr) {
+  return atomic_load_explicit(addr, memory_order_acquire);
+}
+
+void atomic_store_rel(int *addr, int val) {
+  atomic_store_explicit(addr, val, memory_order_release);
+}
+
+void cpu_relax() {
+#if defined(__x86_64__)
+  asm volatile ("pause");
+#elif defined(__aarch64__)
+  asm volatile ("yield");
+#endif
+}
+
+void ticket_lock(TicketLock *lk) {
+  int ticket = atomic_xadd(&lk->next, 1);
+  while (atomic_load_acq(&lk->owner) != ticket) {
+    cpu_relax();
+  }
+}
+
+void ticket_unlock(TicketLock *lk) {
+  atomic_store_rel(&lk->owner, lk->owner + 1);
+}
+
+void mcs_lock(MCSLock *lk, MCSNode *node) {
+  node->next = NULL;
+  node->locked = 1;
+  MCSNode *prev = atomic_exchange(&lk->tail, node);
+  if (prev == NULL) return;
+  // wait on our own node, so the lock word is not bounced among the CPUs
+  atomic_store_explicit(&prev->next, node, memory_order_release);
+  while (atomic_load_acq(&node->locked)) {
+    cpu_relax();
+  }
+}
+
+void mcs_unlock(MCSLock *lk, MCSNode *node) {
+  MCSNode *next = atomic_load_explicit(&node->next, memory_order_acquire);
+  if (next == NULL) {
+    MCSNode *expected = node;
+    if (atomic_compare_exchange_strong(&lk->tail, &expected, NULL)) return;
+    // a successor has taken the tail, but not linked itself yet
+    while ((next = atomic_load_explicit(&node->next, memory_order_acquire)) == NULL) {
+      cpu_relax();
+    }
+  }
+  atomic_store_rel(&next->locked, 0);
+}
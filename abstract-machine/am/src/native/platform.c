@@ -10,13 +10,16 @@
 #define MAX_CPU 16
 #define TRAP_PAGE_START (void *)0x100000
 #define PMEM_START (void *)0x1000000  // for nanos-lite with vme disabled
-#define PMEM_SIZE (128 * 1024 * 1024) // 128MB
+#define PMEM_SIZE_DEFAULT 128         // MB, can be set by the environment variable `pmemsize`
+#define HUGE_PAGE_SIZE (2 * 1024 * 1024)
 static int pmem_fd = 0;
 static void *pmem = NULL;
+static size_t pmem_size = 0;
+static bool pmem_huge = false;
 static ucontext_t uc_example = {};
 static void *(*memcpy_libc)(void *, const void *, size_t) = NULL;
 sigset_t __am_intr_sigmask = {};
-__am_cpu_t *__am_cpu_struct = NULL;
+__thread __am_cpu_t *__am_cpu_struct = NULL;
 int __am_ncpu = 0;
 int __am_pgsize = 0;
 
@@ -46,6 +49,53 @@ static void save_example_context() {
   assert(ret == 0);
 }
 
+static void setup_sigaltstack();
+
+// allocate the private per-cpu structure of the calling CPU
+void __am_init_cpu(int cpuid) {
+  thiscpu = mmap(NULL, sizeof(*thiscpu), PROT_READ | PROT_WRITE,
+      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  assert(thiscpu != (void *)-1);
+  thiscpu->cpuid = cpuid;
+  thiscpu->vm_head = NULL;
+  setup_sigaltstack();
+}
+
+/* With `hugepage=1`, pmem is backed by huge pages, which saves most TLB
+ * misses of the host for programs touching a lot of memory. It needs huge
+ * pages reserved in /proc/sys/vm/nr_hugepages, and falls back to regular
+ * pages otherwise. */
+static void create_pmem() {
+  const char *size = getenv("pmemsize");
+  pmem_size = (size_t)(size ? atoi(size) : PMEM_SIZE_DEFAULT) * 1024 * 1024;
+  assert(pmem_size > 0);
+  // use dynamic linking to avoid linking to the same function in RT-Thread
+  int (*ftruncate_libc)(int, off_t) = dlsym(RTLD_NEXT, "ftruncate");
+  assert(ftruncate_libc != NULL);
+
+  const char *huge = getenv("hugepage");
+  if (huge && atoi(huge)) {
+    pmem_size = ROUNDUP(pmem_size, HUGE_PAGE_SIZE);
+    pmem_fd = memfd_create("pmem", MFD_HUGETLB);
+    if (pmem_fd != -1 && ftruncate_libc(pmem_fd, pmem_size) == 0) {
+      pmem = mmap(PMEM_START, pmem_size, PROT_READ | PROT_WRITE | PROT_EXEC,
+          MAP_SHARED | MAP_FIXED, pmem_fd, 0);
+      if (pmem != (void *)-1) { pmem_huge = true; return; }
+    }
+    if (pmem_fd != -1) close(pmem_fd);
+    printf("Can not allocate %zu MB of huge pages for pmem, using regular pages\n",
+        pmem_size >> 20);
+  }
+
+  pmem_fd = memfd_create("pmem", 0);
+  assert(pmem_fd != -1);
+  int ret = ftruncate_libc(pmem_fd, pmem_size);
+  assert(ret == 0);
+  pmem = mmap(PMEM_START, pmem_size, PROT_READ | PROT_WRITE | PROT_EXEC,
+      MAP_SHARED | MAP_FIXED, pmem_fd, 0);
+  assert(pmem != (void *)-1);
+}
+
 static void setup_sigaltstack() {
   assert(sizeof(thiscpu->sigstack) >= SIGSTKSZ);
   stack_t ss;
@@ -61,24 +111,8 @@ int main(const char *args);
 static void init_platform() __attribute__((constructor));
 static void init_platform() {
   // create memory object and set up mapping to simulate the physical memory
-  pmem_fd = memfd_create("pmem", 0);
-  assert(pmem_fd != -1);
-  // use dynamic linking to avoid linking to the same function in RT-Thread
-  int (*ftruncate_libc)(int, off_t) = dlsym(RTLD_NEXT, "ftruncate");
-  assert(ftruncate_libc != NULL);
-  int ret2 = ftruncate_libc(pmem_fd, PMEM_SIZE);
-  assert(ret2 == 0);
-
-  pmem = mmap(PMEM_START, PMEM_SIZE, PROT_READ | PROT_WRITE | PROT_EXEC,
-      MAP_SHARED | MAP_FIXED, pmem_fd, 0);
-  assert(pmem != (void *)-1);
-
-  // allocate private per-cpu structure
-  thiscpu = mmap(NULL, sizeof(*thiscpu), PROT_READ | PROT_WRITE,
-      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
-  assert(thiscpu != (void *)-1);
-  thiscpu->cpuid = 0;
-  thiscpu->vm_head = NULL;
+  create_pmem();
+  int ret2;
 
   // create trap page to receive syscall and yield by SIGSEGV
   int sys_pgsz = sysconf(_SC_PAGESIZE);
@@ -135,7 +169,7 @@ static void init_platform() {
   }
 
   // set up the AM heap
-  heap = RANGE(pmem, pmem + PMEM_SIZE);
+  heap = RANGE(pmem, pmem + pmem_size);
 
   // initialize sigmask for interrupts
   ret2 = sigemptyset(&__am_intr_sigmask);
@@ -145,8 +179,8 @@ static void init_platform() {
   ret2 = sigaddset(&__am_intr_sigmask, SIGUSR1);
   assert(ret2 == 0);
 
-  // setup alternative signal stack
-  setup_sigaltstack();
+  // allocate the per-cpu structure of CPU #0, and set up its alternative signal stack
+  __am_init_cpu(0);
 
   // save the context template
   save_example_context();
@@ -167,6 +201,9 @@ static void init_platform() {
   const char *pgsize = getenv("pgsize");
   __am_pgsize = pgsize ? atoi(pgsize) : sys_pgsz;
   assert(__am_pgsize > 0 && __am_pgsize % sys_pgsz == 0);
+  if (pmem_huge && __am_pgsize % HUGE_PAGE_SIZE != 0) {
+    printf("VME is not available with hugepage=1 unless pgsize is a multiple of %d\n", HUGE_PAGE_SIZE);
+  }
 
   // set stdout unbuffered
   setbuf(stdout, NULL);
@@ -178,24 +215,25 @@ static void init_platform() {
 void __am_exit_platform(int code) {
   // let Linux clean up other resource
   extern int __am_mpe_init;
-  if (__am_mpe_init && cpu_count() > 1) kill(0, SIGKILL);
+  if (__am_mpe_init && cpu_count() > 1 && !__am_mpe_thread) kill(0, SIGKILL);
   exit(code);
 }
 
-void __am_pmem_map(void *va, void *pa, int prot) {
+// map `len` bytes of pmem from `pa` at `va`, which is a single syscall
+void __am_pmem_map(void *va, void *pa, size_t len, int prot) {
   // translate AM prot to mmap prot
   int mmap_prot = PROT_NONE;
   // we do not support executable bit, so mark
   // all readable pages executable as well
   if (prot & MMAP_READ) mmap_prot |= PROT_READ | PROT_EXEC;
   if (prot & MMAP_WRITE) mmap_prot |= PROT_WRITE;
-  void *ret = mmap(va, __am_pgsize, mmap_prot,
+  void *ret = mmap(va, len, mmap_prot,
       MAP_SHARED | MAP_FIXED, pmem_fd, (uintptr_t)(pa - pmem));
   assert(ret != (void *)-1);
 }
 
-void __am_pmem_unmap(void *va) {
-  int ret = munmap(va, __am_pgsize);
+void __am_pmem_unmap(void *va, size_t len) {
+  int ret = munmap(va, len);
   assert(ret == 0);
 }
 
@@ -216,12 +254,12 @@ void __am_send_kbd_intr() {
 }
 
 void __am_pmem_protect() {
-//  int ret = mprotect(PMEM_START, PMEM_SIZE, PROT_NONE);
+//  int ret = mprotect(PMEM_START, pmem_size, PROT_NONE);
 //  assert(ret == 0);
 }
 
 void __am_pmem_unprotect() {
-//  int ret = mprotect(PMEM_START, PMEM_SIZE, PROT_READ | PROT_WRITE | PROT_EXEC);
+//  int ret = mprotect(PMEM_START, pmem_size, PROT_READ | PROT_WRITE | PROT_EXEC);
 //  assert(ret == 0);
 }
 
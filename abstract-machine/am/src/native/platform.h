@@ -27,8 +27,10 @@ void __am_get_example_uc(Context *r);
 void __am_get_intr_sigmask(sigset_t *s);
 int __am_is_sigmask_sti(sigset_t *s);
 void __am_init_timer_irq();
-void __am_pmem_map(void *va, void *pa, int prot);
-void __am_pmem_unmap(void *va);
+void __am_pmem_map(void *va, void *pa, size_t len, int prot);
+void __am_pmem_unmap(void *va, size_t len);
+void __am_init_cpu(int cpuid);
+extern bool __am_mpe_thread;
 
 // per-cpu structure
 typedef struct {
@@ -38,7 +40,7 @@ typedef struct {
   Event ev; // similar to cause register in mips/riscv
   uint8_t sigstack[32768];
 } __am_cpu_t;
-extern __am_cpu_t *__am_cpu_struct;
+extern __thread __am_cpu_t *__am_cpu_struct;
 #define thiscpu __am_cpu_struct
 
 #endif
@@ -1,26 +1,31 @@
 #define _GNU_SOURCE
-#include <search.h>
 #include "platform.h"
 
 #define USER_SPACE RANGE(0x40000000, 0xc0000000)
 
-typedef struct PageMap {
+/* An address space is kept as a list of regions, each of which is a run
+ * of pages contiguous in both va and pa, with the same prot. A region is
+ * mapped by a single mmap() of pmem, so switching address spaces costs one
+ * munmap() of the user space plus one mmap() per region, instead of a
+ * syscall per page. Loading a program maps its pages in order, which
+ * usually extends the region mapped last. */
+typedef struct Region {
   void *va;
   void *pa;
-  struct PageMap *next;
+  uintptr_t len;
   int prot;
-  int is_mapped;
-  char key[32];  // used for hsearch_r()
-} PageMap;
+  struct Region *next;
+} Region;
 
 typedef struct VMHead {
-  PageMap *head;
-  struct hsearch_data hash;
-  int nr_page;
+  Region *head;
+  Region *last;   // the region mapped last
+  Region *pool;   // free slots for regions
+  int nr_pool;
 } VMHead;
 
 #define list_foreach(p, head) \
-  for (p = (PageMap *)(head); p != NULL; p = p->next)
+  for (p = (head); p != NULL; p = p->next)
 
 extern int __am_pgsize;
 static int vme_enable = 0;
@@ -36,12 +41,11 @@ bool vme_init(void* (*pgalloc_f)(int), void (*pgfree_f)(void*)) {
 
 void protect(AddrSpace *as) {
   assert(as != NULL);
-  VMHead *h = pgalloc(__am_pgsize); // used as head of the list
+  VMHead *h = pgalloc(__am_pgsize); // the rest of the page holds regions
   assert(h != NULL);
   memset(h, 0, sizeof(*h));
-  int max_pg = (USER_SPACE.end - USER_SPACE.start) / __am_pgsize;
-  int ret = hcreate_r(max_pg, &h->hash);
-  assert(ret != 0);
+  h->pool = (Region *)(h + 1);
+  h->nr_pool = (__am_pgsize - sizeof(*h)) / sizeof(Region);
 
   as->ptr = h;
   as->pgsize = __am_pgsize;
@@ -53,28 +57,20 @@ void unprotect(AddrSpace *as) {
 
 void __am_switch(Context *c) {
   if (!vme_enable) return;
+  panic_on(__am_mpe_thread && cpu_count() > 1, "VME is not supported with mpe=thread");
 
   VMHead *head = c->vm_head;
   VMHead *now_head = thiscpu->vm_head;
   if (head == now_head) goto end;
 
-  PageMap *pp;
   if (now_head != NULL) {
-    // munmap all mappings
-    list_foreach(pp, now_head->head) {
-      if (pp->is_mapped) {
-        __am_pmem_unmap(pp->va);
-        pp->is_mapped = false;
-      }
-    }
+    __am_pmem_unmap(USER_SPACE.start, USER_SPACE.end - USER_SPACE.start);
   }
 
   if (head != NULL) {
-    // mmap all mappings
-    list_foreach(pp, head->head) {
-      assert(IN_RANGE(pp->va, USER_SPACE));
-      __am_pmem_map(pp->va, pp->pa, pp->prot);
-      pp->is_mapped = true;
+    Region *r;
+    list_foreach(r, head->head) {
+      __am_pmem_map(r->va, r->pa, r->len, r->prot);
     }
   }
 
@@ -82,41 +78,76 @@ end:
   thiscpu->vm_head = head;
 }
 
+static Region *new_region(VMHead *h) {
+  if (h->nr_pool == 0) {
+    h->pool = pgalloc(__am_pgsize);
+    assert(h->pool != NULL);
+    h->nr_pool = __am_pgsize / sizeof(Region);
+  }
+  h->nr_pool --;
+  Region *r = h->pool ++;
+  r->next = h->head;
+  h->head = r;
+  return r;
+}
+
+static Region *find_region(VMHead *h, void *va) {
+  Region *r = h->last;
+  if (r != NULL && IN_RANGE(va, RANGE(r->va, r->va + r->len))) return r;
+  list_foreach(r, h->head) {
+    if (IN_RANGE(va, RANGE(r->va, r->va + r->len))) return r;
+  }
+  return NULL;
+}
+
+// cut the page at `va` out of `r` as a region of its own
+static Region *split_region(VMHead *h, Region *r, void *va) {
+  uintptr_t off = va - r->va;
+  if (off > 0) {
+    Region *t = new_region(h);
+    *t = (Region) { .va = va, .pa = r->pa + off, .len = r->len - off, .prot = r->prot, .next = t->next };
+    r->len = off;
+    r = t;
+  }
+  if (r->len > __am_pgsize) {
+    Region *t = new_region(h);
+    *t = (Region) { .va = va + __am_pgsize, .pa = r->pa + __am_pgsize,
+      .len = r->len - __am_pgsize, .prot = r->prot, .next = t->next };
+    r->len = __am_pgsize;
+  }
+  return r;
+}
+
 void map(AddrSpace *as, void *va, void *pa, int prot) {
   assert(IN_RANGE(va, USER_SPACE));
   assert((uintptr_t)va % __am_pgsize == 0);
   assert((uintptr_t)pa % __am_pgsize == 0);
   assert(as != NULL);
-  PageMap *pp = NULL;
   VMHead *vm_head = as->ptr;
   assert(vm_head != NULL);
-  char buf[32];
-  snprintf(buf, 32, "%x", va);
-  ENTRY item = { .key = buf };
-  ENTRY *item_find;
-  hsearch_r(item, FIND, &item_find, &vm_head->hash);
-  if (item_find == NULL) {
-    pp = pgalloc(__am_pgsize); // this will waste memory, any better idea?
-    snprintf(pp->key, 32, "%x", va);
-    item.key = pp->key;
-    item.data = pp;
-    int ret = hsearch_r(item, ENTER, &item_find, &vm_head->hash);
-    assert(ret != 0);
-    vm_head->nr_page ++;
+
+  Region *r = find_region(vm_head, va);
+  if (r != NULL) {
+    // remap a page
+    if (r->pa + (va - r->va) == pa && r->prot == prot) return;
+    r = split_region(vm_head, r, va);
+    r->pa = pa;
+    r->prot = prot;
+  } else if ((r = vm_head->last) != NULL && r->va + r->len == va &&
+      r->pa + r->len == pa && r->prot == prot) {
+    r->len += __am_pgsize;
   } else {
-    pp = item_find->data;
+    r = new_region(vm_head);
+    r->va = va;
+    r->pa = pa;
+    r->len = __am_pgsize;
+    r->prot = prot;
   }
-  pp->va = va;
-  pp->pa = pa;
-  pp->prot = prot;
-  pp->is_mapped = false;
-  pp->next = vm_head->head;
-  vm_head->head = pp;
+  vm_head->last = r;
 
   if (vm_head == thiscpu->vm_head) {
     // enforce the map immediately
-    __am_pmem_map(pp->va, pp->pa, pp->prot);
-    pp->is_mapped = true;
+    __am_pmem_map(va, pa, __am_pgsize, prot);
   }
 }
 
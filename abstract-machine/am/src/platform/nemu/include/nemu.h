@@ -18,6 +18,18 @@
 # error unsupported ISA __ISA__
 #endif
 
+#if defined(__riscv)
+// host file I/O of NEMU built with CONFIG_SEMIHOSTING, `arg` points to the parameter block
+static inline long nemu_semihost(long op, void *arg) {
+  register long a0 asm("a0") = op;
+  register void *a1 asm("a1") = arg;
+  asm volatile(".balign 16; .option push; .option norvc;"
+      "slli x0, x0, 0x1f; ebreak; srai x0, x0, 7; .option pop"
+      : "+r"(a0) : "r"(a1) : "memory");
+  return a0;
+}
+#endif
+
 #if defined(__ARCH_X86_NEMU)
 # define DEVICE_BASE 0x0
 #else
@@ -32,6 +44,9 @@
 #define VGACTL_ADDR     (DEVICE_BASE + 0x0000100)
 #define AUDIO_ADDR      (DEVICE_BASE + 0x0000200)
 #define DISK_ADDR       (DEVICE_BASE + 0x0000300)
+#define PVIO_ADDR       (DEVICE_BASE + 0x0000400)
+#define NET_ADDR        (DEVICE_BASE + 0x0000500)
+#define HART_ADDR       (DEVICE_BASE + 0x0000600)
 #define FB_ADDR         (MMIO_BASE   + 0x1000000)
 #define AUDIO_SBUF_ADDR (MMIO_BASE   + 0x1200000)
 
@@ -1,5 +1,6 @@
 #include <am.h>
 #include <nemu.h>
+#include <klib.h>
 
 #define AUDIO_FREQ_ADDR      (AUDIO_ADDR + 0x00)
 #define AUDIO_CHANNELS_ADDR  (AUDIO_ADDR + 0x04)
@@ -8,19 +9,63 @@
 #define AUDIO_INIT_ADDR      (AUDIO_ADDR + 0x10)
 #define AUDIO_COUNT_ADDR     (AUDIO_ADDR + 0x14)
 
+// guest instructions burnt between two polls of a full ring
+#define POLL_DELAY 4096
+
+static uint8_t *sbuf = (uint8_t *)AUDIO_SBUF_ADDR;
+static uint32_t sbuf_size = 0; // set by the first AM_AUDIO_CONFIG
+static uint32_t wpos = 0; // bytes written since the last init
+
 void __am_audio_init() {
 }
 
+// the registers are only touched by programs using audio, since NEMU may
+// be built without the device
 void __am_audio_config(AM_AUDIO_CONFIG_T *cfg) {
-  cfg->present = false;
+  sbuf_size = inl(AUDIO_SBUF_SIZE_ADDR);
+  cfg->present = true;
+  cfg->bufsize = sbuf_size;
 }
 
 void __am_audio_ctrl(AM_AUDIO_CTRL_T *ctrl) {
+  outl(AUDIO_FREQ_ADDR, ctrl->freq);
+  outl(AUDIO_CHANNELS_ADDR, ctrl->channels);
+  outl(AUDIO_SAMPLES_ADDR, ctrl->samples);
+  outl(AUDIO_INIT_ADDR, 1);
+  wpos = 0;
 }
 
 void __am_audio_status(AM_AUDIO_STATUS_T *stat) {
-  stat->count = 0;
+  stat->count = inl(AUDIO_COUNT_ADDR);
 }
 
+/* Samples are appended to the sbuf ring with memcpy() and committed by
+ * writing the count read plus the bytes appended, see the audio device of
+ * NEMU. When the ring is full, reg_count is polled with a delay between
+ * the polls, and only once a quarter of the ring, or all the remaining
+ * samples, fit, so that a long playback costs a few MMIO exits per chunk
+ * instead of a tight loop of them. */
 void __am_audio_play(AM_AUDIO_PLAY_T *ctl) {
+  const uint8_t *buf = ctl->buf.start;
+  uint32_t len = (uint8_t *)ctl->buf.end - buf;
+  if (sbuf_size == 0) return;
+  while (len > 0) {
+    uint32_t want = (len < sbuf_size / 4 ? len : sbuf_size / 4);
+    uint32_t count, free;
+    for (;;) {
+      count = inl(AUDIO_COUNT_ADDR);
+      free = sbuf_size - count;
+      if (free >= want) break;
+      for (int i = 0; i < POLL_DELAY; i ++) asm volatile ("");
+    }
+    uint32_t n = (len < free ? len : free);
+    uint32_t pos = wpos % sbuf_size;
+    uint32_t first = (n < sbuf_size - pos ? n : sbuf_size - pos);
+    memcpy(sbuf + pos, buf, first);
+    memcpy(sbuf, buf + first, n - first);
+    outl(AUDIO_COUNT_ADDR, count + n);
+    wpos += n;
+    buf += n;
+    len -= n;
+  }
 }
@@ -1,12 +1,44 @@
 #include <am.h>
 #include <nemu.h>
 
+#define DISK_PRESENT_ADDR (DISK_ADDR + 0x00)
+#define DISK_BLKSZ_ADDR   (DISK_ADDR + 0x04)
+#define DISK_BLKCNT_ADDR  (DISK_ADDR + 0x08)
+#define DISK_BUF_ADDR     (DISK_ADDR + 0x0c)
+#define DISK_BLKNO_ADDR   (DISK_ADDR + 0x10)
+#define DISK_COUNT_ADDR   (DISK_ADDR + 0x14)
+#define DISK_CMD_ADDR     (DISK_ADDR + 0x18)
+#define DISK_STATUS_ADDR  (DISK_ADDR + 0x1c)
+
+#define DISK_CMD_READ  1
+#define DISK_CMD_WRITE 2
+
+#define DISK_BUSY      2
+
+bool __am_pvio_present();
+bool __am_pvio_blkio(bool write, void *buf, int blkno, int blkcnt);
+
 void __am_disk_config(AM_DISK_CONFIG_T *cfg) {
-  cfg->present = false;
+  cfg->present = inl(DISK_PRESENT_ADDR);
+  cfg->blksz = inl(DISK_BLKSZ_ADDR);
+  cfg->blkcnt = inl(DISK_BLKCNT_ADDR);
 }
 
 void __am_disk_status(AM_DISK_STATUS_T *stat) {
+  // NEMU runs the transfer on a worker thread with CONFIG_DEVICE_ASYNC
+  stat->ready = (inl(DISK_STATUS_ADDR) != DISK_BUSY);
 }
 
 void __am_disk_blkio(AM_DISK_BLKIO_T *io) {
+  if (__am_pvio_present()) {
+    __am_pvio_blkio(io->write, io->buf, io->blkno, io->blkcnt);
+    return;
+  }
+  outl(DISK_BUF_ADDR, (uintptr_t)io->buf);
+  outl(DISK_BLKNO_ADDR, io->blkno);
+  outl(DISK_COUNT_ADDR, io->blkcnt);
+  outl(DISK_CMD_ADDR, io->write ? DISK_CMD_WRITE : DISK_CMD_READ);
+  // callers use the buffer right after returning, so wait for an asynchronous
+  // transfer, which NEMU copies directly into the buffer
+  while (inl(DISK_STATUS_ADDR) == DISK_BUSY);
 }
@@ -1,25 +1,64 @@
 #include <am.h>
 #include <nemu.h>
+#include <klib.h>
 
 #define SYNC_ADDR (VGACTL_ADDR + 4)
 
+bool __am_pvio_present();
+void __am_pvio_fbdraw(int x, int y, uint32_t *pixels, int w, int h, bool sync);
+bool __am_pvio_has_accel();
+bool __am_pvio_gpu_memcpy(uint32_t dest, void *src, int size);
+bool __am_pvio_gpu_render(uint32_t root);
+
+static int screen_w = 0, screen_h = 0;
+
 void __am_gpu_init() {
+  uint32_t vgactl = inl(VGACTL_ADDR);
+  screen_w = vgactl >> 16;
+  screen_h = vgactl & 0xffff;
 }
 
 void __am_gpu_config(AM_GPU_CONFIG_T *cfg) {
   *cfg = (AM_GPU_CONFIG_T) {
-    .present = true, .has_accel = false,
-    .width = 0, .height = 0,
-    .vmemsz = 0
+    .present = true, .has_accel = __am_pvio_has_accel(),
+    .width = screen_w, .height = screen_h,
+    .vmemsz = screen_w * screen_h * sizeof(uint32_t)
   };
 }
 
 void __am_gpu_fbdraw(AM_GPU_FBDRAW_T *ctl) {
+  if (__am_pvio_present()) {
+    __am_pvio_fbdraw(ctl->x, ctl->y, ctl->pixels, ctl->w, ctl->h, ctl->sync);
+    return;
+  }
+  // copy a row at a time with the word-wise memcpy(), clipped to the screen
+  int x = ctl->x, y = ctl->y, w = ctl->w, h = ctl->h;
+  if (x >= 0 && y >= 0 && x < screen_w && y < screen_h && w > 0) {
+    int cw = (w < screen_w - x ? w : screen_w - x);
+    int ch = (h < screen_h - y ? h : screen_h - y);
+    uint32_t *fb = (uint32_t *)(uintptr_t)FB_ADDR + y * screen_w + x;
+    const uint32_t *pixels = ctl->pixels;
+    int j;
+    for (j = 0; j < ch; j ++, fb += screen_w, pixels += w) {
+      memcpy(fb, pixels, cw * sizeof(uint32_t));
+    }
+  }
   if (ctl->sync) {
     outl(SYNC_ADDR, 1);
   }
 }
 
+// the accelerator runs on NEMU as requests of the paravirtual I/O device
+void __am_gpu_memcpy(AM_GPU_MEMCPY_T *params) {
+  panic_on(!__am_pvio_has_accel(), "no GPU accelerator");
+  panic_on(!__am_pvio_gpu_memcpy(params->dest, params->src, params->size), "bad GPU_MEMCPY");
+}
+
+void __am_gpu_render(AM_GPU_RENDER_T *ren) {
+  panic_on(!__am_pvio_has_accel(), "no GPU accelerator");
+  panic_on(!__am_pvio_gpu_render(ren->root), "bad GPU_RENDER");
+}
+
 void __am_gpu_status(AM_GPU_STATUS_T *status) {
   status->ready = true;
 }
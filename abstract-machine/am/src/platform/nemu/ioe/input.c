@@ -3,7 +3,16 @@
 
 #define KEYDOWN_MASK 0x8000
 
+static void decode(AM_INPUT_KEYBRD_T *kbd, uint32_t k) {
+  kbd->keydown = (k & KEYDOWN_MASK) != 0;
+  kbd->keycode = k & ~KEYDOWN_MASK;
+}
+
 void __am_input_keybrd(AM_INPUT_KEYBRD_T *kbd) {
-  kbd->keydown = 0;
-  kbd->keycode = AM_KEY_NONE;
+  decode(kbd, inl(KBD_ADDR));
+}
+
+// ioe_batch() lets the device write the raw key into `keycode`
+void __am_input_keybrd_decode(AM_INPUT_KEYBRD_T *kbd) {
+  decode(kbd, kbd->keycode);
 }
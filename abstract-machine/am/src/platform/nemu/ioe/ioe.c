@@ -4,12 +4,16 @@
 void __am_timer_init();
 void __am_gpu_init();
 void __am_audio_init();
+void __am_pvio_init();
+void __am_net_init();
 void __am_input_keybrd(AM_INPUT_KEYBRD_T *);
 void __am_timer_rtc(AM_TIMER_RTC_T *);
 void __am_timer_uptime(AM_TIMER_UPTIME_T *);
 void __am_gpu_config(AM_GPU_CONFIG_T *);
 void __am_gpu_status(AM_GPU_STATUS_T *);
 void __am_gpu_fbdraw(AM_GPU_FBDRAW_T *);
+void __am_gpu_memcpy(AM_GPU_MEMCPY_T *);
+void __am_gpu_render(AM_GPU_RENDER_T *);
 void __am_audio_config(AM_AUDIO_CONFIG_T *);
 void __am_audio_ctrl(AM_AUDIO_CTRL_T *);
 void __am_audio_status(AM_AUDIO_STATUS_T *);
@@ -17,11 +21,19 @@ void __am_audio_play(AM_AUDIO_PLAY_T *);
 void __am_disk_config(AM_DISK_CONFIG_T *cfg);
 void __am_disk_status(AM_DISK_STATUS_T *stat);
 void __am_disk_blkio(AM_DISK_BLKIO_T *io);
+void __am_net_config(AM_NET_CONFIG_T *cfg);
+void __am_net_status(AM_NET_STATUS_T *stat);
+void __am_net_tx(AM_NET_TX_T *tx);
+void __am_net_rx(AM_NET_RX_T *rx);
+void __am_input_keybrd_decode(AM_INPUT_KEYBRD_T *);
+bool __am_pvio_present();
+void __am_pvio_keybrd(uint32_t *dst);
+void __am_pvio_uptime(uint64_t *dst);
+void __am_pvio_flush();
 
 static void __am_timer_config(AM_TIMER_CONFIG_T *cfg) { cfg->present = true; cfg->has_rtc = true; }
 static void __am_input_config(AM_INPUT_CONFIG_T *cfg) { cfg->present = true;  }
 static void __am_uart_config(AM_UART_CONFIG_T *cfg)   { cfg->present = false; }
-static void __am_net_config (AM_NET_CONFIG_T *cfg)    { cfg->present = false; }
 
 typedef void (*handler_t)(void *buf);
 static void *lut[128] = {
@@ -33,6 +45,8 @@ static void *lut[128] = {
   [AM_GPU_CONFIG  ] = __am_gpu_config,
   [AM_GPU_FBDRAW  ] = __am_gpu_fbdraw,
   [AM_GPU_STATUS  ] = __am_gpu_status,
+  [AM_GPU_MEMCPY  ] = __am_gpu_memcpy,
+  [AM_GPU_RENDER  ] = __am_gpu_render,
   [AM_UART_CONFIG ] = __am_uart_config,
   [AM_AUDIO_CONFIG] = __am_audio_config,
   [AM_AUDIO_CTRL  ] = __am_audio_ctrl,
@@ -42,6 +56,9 @@ static void *lut[128] = {
   [AM_DISK_STATUS ] = __am_disk_status,
   [AM_DISK_BLKIO  ] = __am_disk_blkio,
   [AM_NET_CONFIG  ] = __am_net_config,
+  [AM_NET_STATUS  ] = __am_net_status,
+  [AM_NET_TX      ] = __am_net_tx,
+  [AM_NET_RX      ] = __am_net_rx,
 };
 
 static void fail(void *buf) { panic("access nonexist register"); }
@@ -49,11 +66,41 @@ static void fail(void *buf) { panic("access nonexist register"); }
 bool ioe_init() {
   for (int i = 0; i < LENGTH(lut); i++)
     if (!lut[i]) lut[i] = fail;
+  __am_pvio_init();
   __am_gpu_init();
   __am_timer_init();
   __am_audio_init();
+  __am_net_init();
   return true;
 }
 
 void ioe_read (int reg, void *buf) { ((handler_t)lut[reg])(buf); }
 void ioe_write(int reg, void *buf) { ((handler_t)lut[reg])(buf); }
+
+// Keyboard and uptime reads, and the draws which are not synced, are queued
+// in the pvio ring, so a batch of them takes a single doorbell write. Other
+// registers flush the ring first to keep the order of the accesses.
+void ioe_batch(IOEOp *ops, int n) {
+  if (!__am_pvio_present()) {
+    for (int i = 0; i < n; i++) ((handler_t)lut[ops[i].reg])(ops[i].buf);
+    return;
+  }
+  bool has_keybrd = false;
+  for (int i = 0; i < n; i++) {
+    void *buf = ops[i].buf;
+    switch (ops[i].reg) {
+      case AM_INPUT_KEYBRD:
+        __am_pvio_keybrd((uint32_t *)&((AM_INPUT_KEYBRD_T *)buf)->keycode);
+        has_keybrd = true;
+        break;
+      case AM_TIMER_UPTIME: __am_pvio_uptime(&((AM_TIMER_UPTIME_T *)buf)->us); break;
+      case AM_GPU_FBDRAW: __am_gpu_fbdraw(buf); break;
+      default: __am_pvio_flush(); ((handler_t)lut[ops[i].reg])(buf); break;
+    }
+  }
+  __am_pvio_flush();
+  if (!has_keybrd) return;
+  for (int i = 0; i < n; i++) {
+    if (ops[i].reg == AM_INPUT_KEYBRD) __am_input_keybrd_decode(ops[i].buf);
+  }
+}
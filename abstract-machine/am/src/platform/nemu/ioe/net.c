@@ -0,0 +1,68 @@
+#include <am.h>
+#include <nemu.h>
+
+#define NET_PRESENT_ADDR     (NET_ADDR + 0x00)
+#define NET_RX_PENDING_ADDR  (NET_ADDR + 0x04)
+#define NET_TX_RING_ADDR     (NET_ADDR + 0x08)
+#define NET_TX_SIZE_ADDR     (NET_ADDR + 0x0c)
+#define NET_TX_DOORBELL_ADDR (NET_ADDR + 0x10)
+#define NET_RX_RING_ADDR     (NET_ADDR + 0x14)
+#define NET_RX_SIZE_ADDR     (NET_ADDR + 0x18)
+#define NET_RX_DOORBELL_ADDR (NET_ADDR + 0x1c)
+
+typedef struct {
+  uint32_t addr;
+  uint32_t len;
+  uint32_t status;
+  uint32_t pad;
+} NetDesc;
+
+// The descriptors point to the buffers of the callers, and NEMU copies the
+// frames directly between them and the host before the doorbell write
+// returns, so a single entry in flight is enough for each ring.
+#define RING_SIZE 4
+
+static NetDesc tx_ring[RING_SIZE], rx_ring[RING_SIZE];
+static uint32_t tx_tail = 0, rx_tail = 0;
+static bool present = false;
+
+void __am_net_init() {
+  present = inl(NET_PRESENT_ADDR);
+  if (present) {
+    outl(NET_TX_RING_ADDR, (uintptr_t)tx_ring);
+    outl(NET_TX_SIZE_ADDR, RING_SIZE);
+    outl(NET_RX_RING_ADDR, (uintptr_t)rx_ring);
+    outl(NET_RX_SIZE_ADDR, RING_SIZE);
+  }
+}
+
+void __am_net_config(AM_NET_CONFIG_T *cfg) {
+  cfg->present = present;
+}
+
+void __am_net_status(AM_NET_STATUS_T *stat) {
+  stat->rx_len = (present ? inl(NET_RX_PENDING_ADDR) : 0);
+  stat->tx_len = 0;
+}
+
+static NetDesc *submit(NetDesc *ring, uint32_t *tail, uintptr_t doorbell, Area buf) {
+  NetDesc *d = &ring[*tail % RING_SIZE];
+  d->addr = (uintptr_t)buf.start;
+  d->len = buf.end - buf.start;
+  d->status = 0;
+  outl(doorbell, ++ *tail);
+  return d;
+}
+
+void __am_net_tx(AM_NET_TX_T *tx) {
+  if (!present) return;
+  submit(tx_ring, &tx_tail, NET_TX_DOORBELL_ADDR, tx->buf);
+}
+
+// the end of the buffer is moved to the end of the frame received,
+// which is the start of the buffer if no frame is pending
+void __am_net_rx(AM_NET_RX_T *rx) {
+  if (!present) { rx->buf.end = rx->buf.start; return; }
+  NetDesc *d = submit(rx_ring, &rx_tail, NET_RX_DOORBELL_ADDR, rx->buf);
+  rx->buf.end = rx->buf.start + d->len;
+}
@@ -0,0 +1,126 @@
+#include <am.h>
+#include <nemu.h>
+
+#define PVIO_PRESENT_ADDR  (PVIO_ADDR + 0x00)
+#define PVIO_RING_ADDR     (PVIO_ADDR + 0x04)
+#define PVIO_SIZE_ADDR     (PVIO_ADDR + 0x08)
+#define PVIO_DOORBELL_ADDR (PVIO_ADDR + 0x0c)
+
+enum {
+  PVIO_OP_NOP,
+  PVIO_OP_FBDRAW,
+  PVIO_OP_DISK_READ,
+  PVIO_OP_DISK_WRITE,
+  PVIO_OP_AUDIO_PLAY,
+  PVIO_OP_GPU_MEMCPY,
+  PVIO_OP_GPU_RENDER,
+  PVIO_OP_KEYBRD,
+  PVIO_OP_UPTIME,
+};
+
+enum { PVIO_FEAT_PRESENT = 1, PVIO_FEAT_GPU_ACCEL = 2 };
+
+typedef struct {
+  uint32_t op;
+  uint32_t status;
+  uint32_t arg[6];
+} PvioReq;
+
+// Requests are queued in the ring and submitted with a single doorbell
+// write once a request must be completed before returning to the caller.
+// Pixels of queued draws are copied to `stage`, since the caller may reuse
+// its buffer after returning.
+#define RING_SIZE 64
+#define STAGE_SIZE (16 * 1024)
+
+static PvioReq ring[RING_SIZE];
+static uint32_t tail = 0, submitted = 0;
+static uint32_t stage[STAGE_SIZE];
+static int stage_used = 0;
+static uint32_t present = 0;
+
+void __am_pvio_init() {
+  present = inl(PVIO_PRESENT_ADDR);
+  if (present) {
+    outl(PVIO_RING_ADDR, (uintptr_t)ring);
+    outl(PVIO_SIZE_ADDR, RING_SIZE);
+  }
+}
+
+bool __am_pvio_present() {
+  return present & PVIO_FEAT_PRESENT;
+}
+
+bool __am_pvio_has_accel() {
+  return present & PVIO_FEAT_GPU_ACCEL;
+}
+
+static void kick() {
+  if (tail == submitted) return;
+  outl(PVIO_DOORBELL_ADDR, tail);
+  submitted = tail;
+  stage_used = 0;
+}
+
+static PvioReq *alloc(uint32_t op) {
+  if (tail - submitted == RING_SIZE) kick();
+  PvioReq *req = &ring[tail % RING_SIZE];
+  tail ++;
+  req->op = op;
+  req->status = 0;
+  return req;
+}
+
+void __am_pvio_fbdraw(int x, int y, uint32_t *pixels, int w, int h, bool sync) {
+  int n = w * h;
+  bool staged = (!sync && n <= STAGE_SIZE);
+  if (staged && stage_used + n > STAGE_SIZE) kick();
+  PvioReq *req = alloc(PVIO_OP_FBDRAW);
+  if (staged) {
+    uint32_t *dst = stage + stage_used;
+    for (int i = 0; i < n; i ++) dst[i] = pixels[i];
+    stage_used += n;
+    pixels = dst;
+  }
+  req->arg[0] = x; req->arg[1] = y; req->arg[2] = (uintptr_t)pixels;
+  req->arg[3] = w; req->arg[4] = h; req->arg[5] = sync;
+  // the caller's pixels must be consumed before returning
+  if (!staged) kick();
+}
+
+bool __am_pvio_blkio(bool write, void *buf, int blkno, int blkcnt) {
+  PvioReq *req = alloc(write ? PVIO_OP_DISK_WRITE : PVIO_OP_DISK_READ);
+  req->arg[0] = (uintptr_t)buf; req->arg[1] = blkno; req->arg[2] = blkcnt;
+  kick();
+  return req->status == 0;
+}
+
+bool __am_pvio_gpu_memcpy(uint32_t dest, void *src, int size) {
+  PvioReq *req = alloc(PVIO_OP_GPU_MEMCPY);
+  req->arg[0] = dest; req->arg[1] = (uintptr_t)src; req->arg[2] = size;
+  kick();
+  return req->status == 0;
+}
+
+// The results of the following are written to `dst` by the device
+// once the ring is flushed.
+void __am_pvio_keybrd(uint32_t *dst) {
+  PvioReq *req = alloc(PVIO_OP_KEYBRD);
+  req->arg[0] = (uintptr_t)dst;
+}
+
+void __am_pvio_uptime(uint64_t *dst) {
+  PvioReq *req = alloc(PVIO_OP_UPTIME);
+  req->arg[0] = (uintptr_t)dst;
+}
+
+void __am_pvio_flush() {
+  kick();
+}
+
+bool __am_pvio_gpu_render(uint32_t root) {
+  PvioReq *req = alloc(PVIO_OP_GPU_RENDER);
+  req->arg[0] = root;
+  kick();
+  return req->status == 0;
+}
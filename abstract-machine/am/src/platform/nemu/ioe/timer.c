@@ -5,7 +5,14 @@ void __am_timer_init() {
 }
 
 void __am_timer_uptime(AM_TIMER_UPTIME_T *uptime) {
-  uptime->us = 0;
+#if defined(__riscv) && __riscv_xlen == 64
+  uptime->us = *(volatile uint64_t *)RTC_ADDR;
+#else
+  // reading the low word latches the counter for the high word
+  uint32_t lo = inl(RTC_ADDR);
+  uint32_t hi = inl(RTC_ADDR + 4);
+  uptime->us = ((uint64_t)hi << 32) | lo;
+#endif
 }
 
 void __am_timer_rtc(AM_TIMER_RTC_T *rtc) {
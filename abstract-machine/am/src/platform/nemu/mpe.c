@@ -1,20 +1,150 @@
 #include <am.h>
+#include <nemu.h>
 #include <stdatomic.h>
 #include <klib-macros.h>
 
+#define HART_NR_ADDR    (HART_ADDR + 0x00)
+#define HART_ID_ADDR    (HART_ADDR + 0x04)
+#define HART_ENTRY_ADDR (HART_ADDR + 0x08)
+#define HART_STACK_ADDR (HART_ADDR + 0x0c)
+#define HART_START_ADDR (HART_ADDR + 0x10)
+
+#define HART_STACK_SIZE (32 * 1024)
+
+#if !defined(__GCC_HAVE_SYNC_COMPARE_AND_SWAP_4) && !defined(__ISA_X86__)
+#define NO_ATOMIC
+#endif
+
+static void (*mpe_entry)() = NULL;
+
+// the other harts start here with their own stacks
+static void hart_entry() {
+  mpe_entry();
+  panic("MPE entry returns");
+}
+
 bool mpe_init(void (*entry)()) {
+  mpe_entry = entry;
+  int n = cpu_count();
+  // the stacks of the other harts are taken from the end of the heap
+  heap.end = (char *)heap.end - (n - 1) * HART_STACK_SIZE;
+  for (int i = 1; i < n; i++) {
+    outl(HART_ENTRY_ADDR, (uintptr_t)hart_entry);
+    outl(HART_STACK_ADDR, (uintptr_t)heap.end + i * HART_STACK_SIZE);
+    outl(HART_START_ADDR, i);
+  }
   entry();
   panic("MPE entry returns");
 }
 
 int cpu_count() {
+#ifdef NO_ATOMIC
+  // the other harts stay parked, since nothing is atomic among harts
   return 1;
+#else
+  return inl(HART_NR_ADDR);
+#endif
 }
 
 int cpu_current() {
-  return 0;
+  return inl(HART_ID_ADDR);
 }
 
 int atomic_xchg(int *addr, int newval) {
   return atomic_exchange(addr, newval);
 }
+
+#if defined(__GCC_HAVE_SYNC_COMPARE_AND_SWAP_4)
+// AMOs or LR/SC on riscv, LL/SC on mips32 and loongarch32r
+int atomic_xadd(int *addr, int delta) {
+  return atomic_fetch_add(addr, delta);
+}
+
+static bool cas_ptr(MCSNode **addr, MCSNode *oldval, MCSNode *newval) {
+  return atomic_compare_exchange_strong(addr, &oldval, newval);
+}
+#elif defined(__ISA_X86__)
+// i386 is not told to have cmpxchg, use the locked instructions directly
+int atomic_xadd(int *addr, int delta) {
+  return xadd(addr, delta);
+}
+
+static bool cas_ptr(MCSNode **addr, MCSNode *oldval, MCSNode *newval) {
+  return cmpxchg_ptr((void **)addr, oldval, newval) == oldval;
+}
+#else
+// The ISA (e.g. riscv without the A extension) has no instruction for them,
+// and there is no libatomic to call. cpu_count() keeps to a single hart, so
+// it is enough to keep interrupts away.
+int atomic_xadd(int *addr, int delta) {
+  bool enable = ienabled();
+  iset(false);
+  int old = *addr;
+  *addr = old + delta;
+  if (enable) iset(true);
+  return old;
+}
+
+static bool cas_ptr(MCSNode **addr, MCSNode *oldval, MCSNode *newval) {
+  bool enable = ienabled();
+  iset(false);
+  bool success = (*addr == oldval);
+  if (success) *addr = newval;
+  if (enable) iset(true);
+  return success;
+}
+#endif
+
+// NEMU runs the harts in turns on one host thread, so every hart observes
+// the memory accesses in order, and acquire and release only need a compiler
+// barrier. This also keeps fence instructions away, which are not
+// implemented by NEMU.
+int atomic_load_acq(int *addr) {
+  int val = atomic_load_explicit(addr, memory_order_relaxed);
+  atomic_signal_fence(memory_order_acquire);
+  return val;
+}
+
+void atomic_store_rel(int *addr, int val) {
+  atomic_signal_fence(memory_order_release);
+  atomic_store_explicit(addr, val, memory_order_relaxed);
+}
+
+void cpu_relax() {
+}
+
+void ticket_lock(TicketLock *lk) {
+  int ticket = atomic_xadd(&lk->next, 1);
+  while (atomic_load_acq(&lk->owner) != ticket) {
+    cpu_relax();
+  }
+}
+
+void ticket_unlock(TicketLock *lk) {
+  atomic_store_rel(&lk->owner, lk->owner + 1);
+}
+
+void mcs_lock(MCSLock *lk, MCSNode *node) {
+  node->next = NULL;
+  node->locked = 1;
+  MCSNode *prev = atomic_exchange(&lk->tail, node);
+  if (prev == NULL) return;
+  // wait on our own node, so the lock word is not bounced among the CPUs
+  atomic_signal_fence(memory_order_release);
+  atomic_store_explicit(&prev->next, node, memory_order_relaxed);
+  while (atomic_load_acq(&node->locked)) {
+    cpu_relax();
+  }
+}
+
+void mcs_unlock(MCSLock *lk, MCSNode *node) {
+  MCSNode *next = atomic_load_explicit(&node->next, memory_order_relaxed);
+  if (next == NULL) {
+    if (cas_ptr(&lk->tail, node, NULL)) return;
+    // a successor has taken the tail, but not linked itself yet
+    while ((next = atomic_load_explicit(&node->next, memory_order_relaxed)) == NULL) {
+      cpu_relax();
+    }
+  }
+  atomic_store_rel(&next->locked, 0);
+}
@@ -32,3 +32,7 @@ bool ioe_init() {
 
 void ioe_read (int reg, void *buf) { ((handler_t)lut[reg])(buf); }
 void ioe_write(int reg, void *buf) { ((handler_t)lut[reg])(buf); }
+
+void ioe_batch(IOEOp *ops, int n) {
+  for (int i = 0; i < n; i++) ((handler_t)lut[ops[i].reg])(ops[i].buf);
+}
@@ -15,3 +15,30 @@ int cpu_current() {
 int atomic_xchg(int *addr, int newval) {
   return 0;
 }
+
+int atomic_xadd(int *addr, int delta) {
+  return 0;
+}
+
+int atomic_load_acq(int *addr) {
+  return *addr;
+}
+
+void atomic_store_rel(int *addr, int val) {
+  *addr = val;
+}
+
+void cpu_relax() {
+}
+
+void ticket_lock(TicketLock *lk) {
+}
+
+void ticket_unlock(TicketLock *lk) {
+}
+
+void mcs_lock(MCSLock *lk, MCSNode *node) {
+}
+
+void mcs_unlock(MCSLock *lk, MCSNode *node) {
+}
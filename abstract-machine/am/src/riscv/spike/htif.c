@@ -43,40 +43,26 @@ static void __set_tohost(uintptr_t dev, uintptr_t cmd, uintptr_t data)
   tohost = TOHOST_CMD(dev, cmd, data);
 }
 
-int htif_console_getchar()
+static void __do_tohost_fromhost(uintptr_t dev, uintptr_t cmd, uintptr_t data)
 {
-#if __riscv_xlen == 32
-  // HTIF devices are not supported on RV32
-  return -1;
-#endif
+  __set_tohost(dev, cmd, data);
 
-  spinlock_lock(&htif_lock);
-    __check_fromhost();
-    int ch = htif_console_buf;
-    if (ch >= 0) {
-      htif_console_buf = -1;
-      __set_tohost(1, 0, 0);
+  while (1) {
+    uint64_t fh = fromhost;
+    if (fh) {
+      if (FROMHOST_DEV(fh) == dev && FROMHOST_CMD(fh) == cmd) {
+        fromhost = 0;
+        break;
+      }
+      __check_fromhost();
     }
-  spinlock_unlock(&htif_lock);
-
-  return ch - 1;
+  }
 }
 
 static void do_tohost_fromhost(uintptr_t dev, uintptr_t cmd, uintptr_t data)
 {
   spinlock_lock(&htif_lock);
-    __set_tohost(dev, cmd, data);
-
-    while (1) {
-      uint64_t fh = fromhost;
-      if (fh) {
-        if (FROMHOST_DEV(fh) == dev && FROMHOST_CMD(fh) == cmd) {
-          fromhost = 0;
-          break;
-        }
-        __check_fromhost();
-      }
-    }
+    __do_tohost_fromhost(dev, cmd, data);
   spinlock_unlock(&htif_lock);
 }
 
@@ -85,25 +71,67 @@ void htif_syscall(uintptr_t arg)
   do_tohost_fromhost(0, 0, arg);
 }
 
-void htif_console_putchar(uint8_t ch)
+/* The console output is buffered, and written by a single write system
+ * call proxied by the host when a line ends, when the buffer is full, or
+ * before powering off or reading the console. Each handshake with the host
+ * is expensive, while the length of a write costs nearly nothing. */
+#define CONSOLE_BUF_SIZE 256
+static char console_out[CONSOLE_BUF_SIZE];
+static int console_out_len = 0;
+
+static void __console_flush()
 {
-#if __riscv_xlen == 32
-  // HTIF devices are not supported on RV32, so proxy a write system call
-  volatile uint64_t magic_mem[8];
+  if (console_out_len == 0)
+    return;
+  volatile uint64_t magic_mem[8] __attribute__((aligned(64)));
   magic_mem[0] = SYS_write;
   magic_mem[1] = 1;
-  magic_mem[2] = (uintptr_t)&ch;
-  magic_mem[3] = 1;
-  do_tohost_fromhost(0, 0, (uintptr_t)magic_mem);
-#else
+  magic_mem[2] = (uintptr_t)console_out;
+  magic_mem[3] = console_out_len;
+  __do_tohost_fromhost(0, 0, (uintptr_t)magic_mem);
+  console_out_len = 0;
+}
+
+void htif_console_flush()
+{
+  spinlock_lock(&htif_lock);
+    __console_flush();
+  spinlock_unlock(&htif_lock);
+}
+
+void htif_console_putchar(uint8_t ch)
+{
   spinlock_lock(&htif_lock);
-    __set_tohost(1, 1, ch);
+    console_out[console_out_len ++] = ch;
+    if (ch == '\n' || console_out_len == CONSOLE_BUF_SIZE)
+      __console_flush();
   spinlock_unlock(&htif_lock);
+}
+
+int htif_console_getchar()
+{
+#if __riscv_xlen == 32
+  // HTIF devices are not supported on RV32
+  return -1;
 #endif
+
+  spinlock_lock(&htif_lock);
+    // show the prompt before waiting for the input
+    __console_flush();
+    __check_fromhost();
+    int ch = htif_console_buf;
+    if (ch >= 0) {
+      htif_console_buf = -1;
+      __set_tohost(1, 0, 0);
+    }
+  spinlock_unlock(&htif_lock);
+
+  return ch - 1;
 }
 
 void htif_poweroff()
 {
+  htif_console_flush();
   while (1) {
     fromhost = 0;
     tohost = 1;
@@ -17,7 +17,11 @@
 #define FROMHOST_CMD(fromhost_value) ((uint64_t)(fromhost_value) << 8 >> 56)
 #define FROMHOST_DATA(fromhost_value) ((uint64_t)(fromhost_value) << 16 >> 16)
 
+// the number of the write system call proxied by the host
+#define SYS_write 64
+
 void htif_console_putchar(uint8_t);
+void htif_console_flush();
 int htif_console_getchar();
 void htif_poweroff() __attribute__((noreturn));
 
@@ -5,30 +5,35 @@
 #define SECTSIZE 512
 #define ARGSIZE  1024
 
+#define MULTSECT 16 // sectors in a block of READ MULTIPLE, the maximum and default of QEMU
+
 static inline void wait_disk(void) {
   while ((inb(0x1f7) & 0xc0) != 0x40);
 }
 
-static inline void read_disk(void *buf, int sect) {
-  wait_disk();
-  outb(0x1f2, 1);
+static inline void insl(int port, void *addr, int cnt) {
+  asm volatile ("cld; rep insl" : "+D"(addr), "+c"(cnt) : "d"(port) : "memory");
+}
+
+/* Read `n` sectors, at most a block, with one command. The disk is ready
+ * for the next command once the data of the last one is read. */
+static inline void read_disk(void *buf, int sect, int n) {
+  outb(0x1f2, n);
   outb(0x1f3, sect);
   outb(0x1f4, sect >> 8);
   outb(0x1f5, sect >> 16);
   outb(0x1f6, (sect >> 24) | 0xE0);
-  outb(0x1f7, 0x20);
+  outb(0x1f7, 0xc4);
   wait_disk();
-  for (int i = 0; i < SECTSIZE / 4; i ++) {
-    ((uint32_t *)buf)[i] = inl(0x1f0);
-  }
+  insl(0x1f0, buf, n * SECTSIZE / 4);
 }
 
 static inline void copy_from_disk(void *buf, int nbytes, int disk_offset) {
   uint32_t cur  = (uint32_t)buf & ~(SECTSIZE - 1);
-  uint32_t ed   = (uint32_t)buf + nbytes;
+  int n         = ((uint32_t)buf + nbytes - cur + SECTSIZE - 1) / SECTSIZE;
   uint32_t sect = (disk_offset / SECTSIZE) + (ARGSIZE / SECTSIZE) + 1;
-  for(; cur < ed; cur += SECTSIZE, sect ++)
-    read_disk((void *)cur, sect);
+  for(; n > 0; n -= MULTSECT, cur += MULTSECT * SECTSIZE, sect += MULTSECT)
+    read_disk((void *)cur, sect, (n < MULTSECT ? n : MULTSECT));
 }
 
 static void load_program(uint32_t filesz, uint32_t memsz, uint32_t paddr, uint32_t offset) {
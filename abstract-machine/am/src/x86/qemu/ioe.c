@@ -469,3 +469,7 @@ void __am_ioapic_enable(int irq, int cpunum) {
   ioapicwrite(REG_TABLE+2*irq, T_IRQ0 + irq);
   ioapicwrite(REG_TABLE+2*irq+1, cpunum << 24);
 }
+
+void ioe_batch(IOEOp *ops, int n) {
+  for (int i = 0; i < n; i++) ((handler_t)lut[ops[i].reg])(ops[i].buf);
+}
@@ -45,6 +45,62 @@ int atomic_xchg(int *addr, int newval) {
   return xchg(addr, newval);
 }
 
+int atomic_xadd(int *addr, int delta) {
+  return xadd(addr, delta);
+}
+
+// x86 does not reorder a load with older loads, or a store with older
+// memory accesses, so acquire and release only need a compiler barrier
+int atomic_load_acq(int *addr) {
+  int val = *(volatile int *)addr;
+  asm volatile ("" ::: "memory");
+  return val;
+}
+
+void atomic_store_rel(int *addr, int val) {
+  asm volatile ("" ::: "memory");
+  *(volatile int *)addr = val;
+}
+
+void cpu_relax() {
+  pause();
+}
+
+void ticket_lock(TicketLock *lk) {
+  int ticket = xadd(&lk->next, 1);
+  while (atomic_load_acq(&lk->owner) != ticket) {
+    pause();
+  }
+}
+
+void ticket_unlock(TicketLock *lk) {
+  atomic_store_rel(&lk->owner, lk->owner + 1);
+}
+
+void mcs_lock(MCSLock *lk, MCSNode *node) {
+  node->next = NULL;
+  node->locked = 1;
+  MCSNode *prev = xchg_ptr((void **)&lk->tail, node);
+  if (prev == NULL) return;
+  // wait on our own node, so the lock word is not bounced among the CPUs
+  *(MCSNode * volatile *)&prev->next = node;
+  while (atomic_load_acq(&node->locked)) {
+    pause();
+  }
+}
+
+void mcs_unlock(MCSLock *lk, MCSNode *node) {
+  MCSNode * volatile *pnext = &node->next;
+  if (*pnext == NULL) {
+    if (cmpxchg_ptr((void **)&lk->tail, node, NULL) == node) return;
+    // a successor has taken the tail, but not linked itself yet
+    while (*pnext == NULL) {
+      pause();
+    }
+  }
+  atomic_store_rel(&(*pnext)->locked, 0);
+}
+
 void __am_stop_the_world() {
   boot_record()->jmp_code = 0x0000feeb; // (16-bit) jmp .
   for (int cpu_ = 0; cpu_ < __am_ncpu; cpu_++) {
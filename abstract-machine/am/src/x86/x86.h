@@ -327,6 +327,26 @@ static inline int xchg(int *addr, int newval) {
   return result;
 }
 
+static inline int xadd(int *addr, int delta) {
+  asm volatile ("lock xadd %0, %1":
+    "+r"(delta), "+m"(*addr) : : "cc", "memory");
+  return delta;
+}
+
+static inline void *xchg_ptr(void **addr, void *newval) {
+  void *result;
+  asm volatile ("lock xchg %0, %1":
+    "+m"(*addr), "=a"(result) : "1"(newval) : "cc", "memory");
+  return result;
+}
+
+static inline void *cmpxchg_ptr(void **addr, void *oldval, void *newval) {
+  void *result;
+  asm volatile ("lock cmpxchg %2, %0":
+    "+m"(*addr), "=a"(result) : "r"(newval), "1"(oldval) : "cc", "memory");
+  return result;
+}
+
 static inline uint64_t rdtsc() {
   uint32_t lo, hi;
   asm volatile ("rdtsc": "=a"(lo), "=d"(hi));
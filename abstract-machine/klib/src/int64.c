@@ -409,22 +409,55 @@ __umoddi3(du_int a, du_int b)
 #endif
 
 
+/* Divide u1:u0 by v with u1 < v, so that the quotient fits in 32 bits.
+ * This is divlu() of Hacker's Delight: v is normalized so that each
+ * 16-bit quotient digit is estimated by one 32-bit hardware division and
+ * corrected at most twice, instead of producing one bit per iteration. */
+static su_int
+udiv64_32(su_int u1, su_int u0, su_int v, su_int *r)
+{
+    const su_int b = 0x10000;
+    int s = __builtin_clz(v);
+    v <<= s;
+    su_int vn1 = v >> 16, vn0 = v & 0xffff;
+    su_int un32 = (u1 << s) | (s == 0 ? 0 : u0 >> (32 - s));
+    su_int un10 = u0 << s;
+    su_int un1 = un10 >> 16, un0 = un10 & 0xffff;
+
+    su_int q1 = un32 / vn1, rhat = un32 - q1 * vn1;
+    while (q1 >= b || q1 * vn0 > b * rhat + un1) {
+        q1 --;
+        rhat += vn1;
+        if (rhat >= b) break;
+    }
+    su_int un21 = un32 * b + un1 - q1 * v;
+
+    su_int q0 = un21 / vn1;
+    rhat = un21 - q0 * vn1;
+    while (q0 >= b || q0 * vn0 > b * rhat + un0) {
+        q0 --;
+        rhat += vn1;
+        if (rhat >= b) break;
+    }
+    if (r)
+        *r = (un21 * b + un0 - q0 * v) >> s;
+    return q1 * b + q0;
+}
+
+
 COMPILER_RT_ABI du_int
 __udivmoddi4(du_int a, du_int b, du_int* rem)
 {
     const unsigned n_uword_bits = sizeof(su_int) * CHAR_BIT;
-    const unsigned n_udword_bits = sizeof(du_int) * CHAR_BIT;
     udwords n;
     n.all = a;
     udwords d;
     d.all = b;
     udwords q;
-    udwords r;
     unsigned sr;
-    /* special cases, X is unknown, K != 0 */
-    if (n.s.high == 0)
+    if (d.s.high == 0)
     {
-        if (d.s.high == 0)
+        if (n.s.high == 0)
         {
             /* 0 X
              * ---
@@ -434,18 +467,7 @@ __udivmoddi4(du_int a, du_int b, du_int* rem)
                 *rem = n.s.low % d.s.low;
             return n.s.low / d.s.low;
         }
-        /* 0 X
-         * ---
-         * K X
-         */
-        if (rem)
-            *rem = n.s.low;
-        return 0;
-    }
-    /* n.s.high != 0 */
-    if (d.s.low == 0)
-    {
-        if (d.s.high == 0)
+        if (d.s.low == 0)
         {
             /* K X
              * ---
@@ -455,168 +477,72 @@ __udivmoddi4(du_int a, du_int b, du_int* rem)
                 *rem = n.s.high % d.s.low;
             return n.s.high / d.s.low;
         }
-        /* d.s.high != 0 */
-        if (n.s.low == 0)
-        {
-            /* K 0
-             * ---
-             * K 0
-             */
-            if (rem)
-            {
-                r.s.high = n.s.high % d.s.high;
-                r.s.low = 0;
-                *rem = r.all;
-            }
-            return n.s.high / d.s.high;
-        }
-        /* K K
-         * ---
-         * K 0
-         */
-        if ((d.s.high & (d.s.high - 1)) == 0)     /* if d is a power of 2 */
+        if ((d.s.low & (d.s.low - 1)) == 0)     /* if d is a power of 2 */
         {
             if (rem)
-            {
-                r.s.low = n.s.low;
-                r.s.high = n.s.high & (d.s.high - 1);
-                *rem = r.all;
-            }
-            return n.s.high >> __builtin_ctz(d.s.high);
+                *rem = n.s.low & (d.s.low - 1);
+            if (d.s.low == 1)
+                return n.all;
+            sr = __builtin_ctz(d.s.low);
+            q.s.high = n.s.high >> sr;
+            q.s.low = (n.s.high << (n_uword_bits - sr)) | (n.s.low >> sr);
+            return q.all;
         }
-        /* K K
+        /* K X
          * ---
-         * K 0
+         * 0 K
+         *
+         * Divide the high word by hardware, and the rest by one normalized
+         * long division.
          */
-        sr = __builtin_clz(d.s.high) - __builtin_clz(n.s.high);
-        /* 0 <= sr <= n_uword_bits - 2 or sr large */
-        if (sr > n_uword_bits - 2)
-        {
-           if (rem)
-                *rem = n.all;
-            return 0;
-        }
-        ++sr;
-        /* 1 <= sr <= n_uword_bits - 1 */
-        /* q.all = n.all << (n_udword_bits - sr); */
-        q.s.low = 0;
-        q.s.high = n.s.low << (n_uword_bits - sr);
-        /* r.all = n.all >> sr; */
-        r.s.high = n.s.high >> sr;
-        r.s.low = (n.s.high << (n_uword_bits - sr)) | (n.s.low >> sr);
+        su_int r;
+        q.s.high = n.s.high / d.s.low;
+        q.s.low = udiv64_32(n.s.high % d.s.low, n.s.low, d.s.low, &r);
+        if (rem)
+            *rem = r;
+        return q.all;
     }
-    else  /* d.s.low != 0 */
+    /* d.s.high != 0, so the quotient fits in a word */
+    if (n.s.high < d.s.high)
     {
-        if (d.s.high == 0)
-        {
-            /* K X
-             * ---
-             * 0 K
-             */
-            if ((d.s.low & (d.s.low - 1)) == 0)     /* if d is a power of 2 */
-            {
-                if (rem)
-                    *rem = n.s.low & (d.s.low - 1);
-                if (d.s.low == 1)
-                    return n.all;
-                sr = __builtin_ctz(d.s.low);
-                q.s.high = n.s.high >> sr;
-                q.s.low = (n.s.high << (n_uword_bits - sr)) | (n.s.low >> sr);
-                return q.all;
-            }
-            /* K X
-             * ---
-             * 0 K
-             */
-            sr = 1 + n_uword_bits + __builtin_clz(d.s.low) - __builtin_clz(n.s.high);
-            /* 2 <= sr <= n_udword_bits - 1
-             * q.all = n.all << (n_udword_bits - sr);
-             * r.all = n.all >> sr;
-             */
-            if (sr == n_uword_bits)
-            {
-                q.s.low = 0;
-                q.s.high = n.s.low;
-                r.s.high = 0;
-                r.s.low = n.s.high;
-            }
-            else if (sr < n_uword_bits)  // 2 <= sr <= n_uword_bits - 1
-            {
-                q.s.low = 0;
-                q.s.high = n.s.low << (n_uword_bits - sr);
-                r.s.high = n.s.high >> sr;
-                r.s.low = (n.s.high << (n_uword_bits - sr)) | (n.s.low >> sr);
-            }
-            else              // n_uword_bits + 1 <= sr <= n_udword_bits - 1
-            {
-                q.s.low = n.s.low << (n_udword_bits - sr);
-                q.s.high = (n.s.high << (n_udword_bits - sr)) |
-                           (n.s.low >> (sr - n_uword_bits));
-                r.s.high = 0;
-                r.s.low = n.s.high >> (sr - n_uword_bits);
-            }
-        }
-        else
+        if (rem)
+            *rem = n.all;
+        return 0;
+    }
+    if (d.s.low == 0 && (d.s.high & (d.s.high - 1)) == 0)     /* if d is a power of 2 */
+    {
+        if (rem)
         {
-            /* K X
-             * ---
-             * K K
-             */
-            sr = __builtin_clz(d.s.high) - __builtin_clz(n.s.high);
-            /* 0 <= sr <= n_uword_bits - 1 or sr large */
-            if (sr > n_uword_bits - 1)
-            {
-                if (rem)
-                    *rem = n.all;
-                return 0;
-            }
-            ++sr;
-            /* 1 <= sr <= n_uword_bits */
-            /*  q.all = n.all << (n_udword_bits - sr); */
-            q.s.low = 0;
-            if (sr == n_uword_bits)
-            {
-                q.s.high = n.s.low;
-                r.s.high = 0;
-                r.s.low = n.s.high;
-            }
-            else
-            {
-                q.s.high = n.s.low << (n_uword_bits - sr);
-                r.s.high = n.s.high >> sr;
-                r.s.low = (n.s.high << (n_uword_bits - sr)) | (n.s.low >> sr);
-            }
+            udwords r;
+            r.s.low = n.s.low;
+            r.s.high = n.s.high & (d.s.high - 1);
+            *rem = r.all;
         }
+        return n.s.high >> __builtin_ctz(d.s.high);
     }
-    /* Not a special case
-     * q and r are initialized with:
-     * q.all = n.all << (n_udword_bits - sr);
-     * r.all = n.all >> sr;
-     * 1 <= sr <= n_udword_bits - 1
+    /* K X
+     * ---
+     * K K
+     *
+     * Estimate the quotient from the top word of the normalized divisor,
+     * which gives a value at most one too large (Hacker's Delight, divDu).
      */
-    su_int carry = 0;
-    for (; sr > 0; --sr)
+    sr = __builtin_clz(d.s.high);
+    udwords dn, n1;
+    dn.all = d.all << sr;
+    n1.all = n.all >> 1;
+    su_int q0 = udiv64_32(n1.s.high, n1.s.low, dn.s.high, 0) >> (n_uword_bits - 1 - sr);
+    if (q0 != 0)
+        q0 --;
+    du_int r = n.all - (du_int)q0 * d.all;
+    if (r >= d.all)
     {
-        /* r:q = ((r:q)  << 1) | carry */
-        r.s.high = (r.s.high << 1) | (r.s.low  >> (n_uword_bits - 1));
-        r.s.low  = (r.s.low  << 1) | (q.s.high >> (n_uword_bits - 1));
-        q.s.high = (q.s.high << 1) | (q.s.low  >> (n_uword_bits - 1));
-        q.s.low  = (q.s.low  << 1) | carry;
-        /* carry = 0;
-         * if (r.all >= d.all)
-         * {
-         *      r.all -= d.all;
-         *      carry = 1;
-         * }
-         */
-        const di_int s = (di_int)(d.all - r.all - 1) >> (n_udword_bits - 1);
-        carry = s & 1;
-        r.all -= d.all & s;
+        q0 ++;
+        r -= d.all;
     }
-    q.all = (q.all << 1) | carry;
     if (rem)
-        *rem = r.all;
-    return q.all;
+        *rem = r;
+    return q0;
 }
 
 // Returns: the number of leading 0-bits
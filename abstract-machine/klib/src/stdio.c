@@ -5,24 +5,254 @@
 
 #if !defined(__ISA_NATIVE__) || defined(__NATIVE_USE_KLIB__)
 
+/* All the functions share one formatter, which writes through a Sink.
+ * printf() collects the output in a buffer on the stack and passes it to
+ * putch() in bursts, while the others write into the string they are given
+ * and count what does not fit. */
+typedef struct {
+  char *buf;
+  size_t size;   // for a string, the room left including the '\0'
+  size_t pos;
+  int total;
+  bool to_putch;
+} Sink;
+
+static void sink_flush(Sink *o) {
+  size_t i;
+  for (i = 0; i < o->pos; i ++) putch(o->buf[i]);
+  o->pos = 0;
+}
+
+static inline void out_char(Sink *o, char c) {
+  o->total ++;
+  if (o->pos + 1 < o->size) { o->buf[o->pos ++] = c; return; }
+  if (o->to_putch) {
+    o->buf[o->pos ++] = c;
+    sink_flush(o);
+  }
+}
+
+static void out_str(Sink *o, const char *s, int len) {
+  for (; len > 0; len --) out_char(o, *s ++);
+}
+
+static void out_pad(Sink *o, char c, int len) {
+  for (; len > 0; len --) out_char(o, c);
+}
+
+static const char digit_pairs[201] =
+  "00010203040506070809" "10111213141516171819" "20212223242526272829"
+  "30313233343536373839" "40414243444546474849" "50515253545556575859"
+  "60616263646566676869" "70717273747576777879" "80818283848586878889"
+  "90919293949596979899";
+
+// write the digits backward ending at `end`, and return where they start
+static char *utoa_dec(char *end, unsigned long long v) {
+  // divide by 100 to emit two digits at a time, and keep 64-bit division,
+  // which is a library call on 32-bit ISAs, off the common path
+  while (v >> 32) {
+    int r = v % 100;
+    v /= 100;
+    end -= 2; end[0] = digit_pairs[2 * r]; end[1] = digit_pairs[2 * r + 1];
+  }
+  uint32_t w = v;
+  while (w >= 100) {
+    int r = w % 100;
+    w /= 100;
+    end -= 2; end[0] = digit_pairs[2 * r]; end[1] = digit_pairs[2 * r + 1];
+  }
+  if (w >= 10) {
+    end -= 2; end[0] = digit_pairs[2 * w]; end[1] = digit_pairs[2 * w + 1];
+  } else {
+    *-- end = '0' + w;
+  }
+  return end;
+}
+
+static char *utoa_pow2(char *end, unsigned long long v, int shift, bool upper) {
+  const char *digits = upper ? "0123456789ABCDEF" : "0123456789abcdef";
+  int mask = (1 << shift) - 1;
+  do {
+    *-- end = digits[v & mask];
+    v >>= shift;
+  } while (v != 0);
+  return end;
+}
+
+enum { F_LEFT = 1, F_ZERO = 2, F_PLUS = 4, F_SPACE = 8, F_ALT = 16 };
+
+static void format(Sink *o, const char *fmt, va_list ap) {
+  char tmp[24]; // enough for 2^64 in octal
+  char *tmp_end = tmp + sizeof(tmp);
+  for (; *fmt != '\0'; fmt ++) {
+    if (*fmt != '%') {
+      // copy the literal run at once
+      const char *p = fmt;
+      while (p[1] != '\0' && p[1] != '%') p ++;
+      out_str(o, fmt, p - fmt + 1);
+      fmt = p;
+      continue;
+    }
+
+    int flags = 0;
+    for (;;) {
+      switch (*++ fmt) {
+        case '-': flags |= F_LEFT; continue;
+        case '0': flags |= F_ZERO; continue;
+        case '+': flags |= F_PLUS; continue;
+        case ' ': flags |= F_SPACE; continue;
+        case '#': flags |= F_ALT; continue;
+      }
+      break;
+    }
+
+    int width = 0;
+    if (*fmt == '*') {
+      width = va_arg(ap, int);
+      if (width < 0) { flags |= F_LEFT; width = -width; }
+      fmt ++;
+    } else {
+      for (; *fmt >= '0' && *fmt <= '9'; fmt ++) width = width * 10 + *fmt - '0';
+    }
+
+    int prec = -1;
+    if (*fmt == '.') {
+      fmt ++;
+      if (*fmt == '*') {
+        prec = va_arg(ap, int);
+        fmt ++;
+      } else {
+        for (prec = 0; *fmt >= '0' && *fmt <= '9'; fmt ++) prec = prec * 10 + *fmt - '0';
+      }
+    }
+
+    int lng = 0; // -2: hh, -1: h, 1: l, 2: ll, 3: z
+    for (;; fmt ++) {
+      if (*fmt == 'l') lng = (lng == 1 ? 2 : 1);
+      else if (*fmt == 'h') lng = (lng == -1 ? -2 : -1);
+      else if (*fmt == 'z') lng = 3;
+      else break;
+    }
+
+    unsigned long long v;
+    bool neg = false;
+    const char *prefix = "";
+    char *s;
+    int len, pad;
+    switch (*fmt) {
+      case '%': out_char(o, '%'); continue;
+      case '\0': return;
+      case 'c':
+        tmp[0] = va_arg(ap, int);
+        s = tmp; len = 1; prec = -1;
+        goto emit;
+      case 's':
+        s = va_arg(ap, char *);
+        if (s == NULL) s = "(null)";
+        for (len = 0; s[len] != '\0' && (prec < 0 || len < prec); len ++);
+        prec = -1;
+        goto emit;
+      case 'd': case 'i': {
+        long long x;
+        switch (lng) {
+          case 1: x = va_arg(ap, long); break;
+          case 2: x = va_arg(ap, long long); break;
+          case 3: x = va_arg(ap, ptrdiff_t); break;
+          default: x = va_arg(ap, int);
+                   x = (lng == -1 ? (short)x : lng == -2 ? (signed char)x : x);
+        }
+        neg = x < 0;
+        v = neg ? -(unsigned long long)x : x;
+        prefix = neg ? "-" : (flags & F_PLUS) ? "+" : (flags & F_SPACE) ? " " : "";
+        s = utoa_dec(tmp_end, v);
+        break;
+      }
+      case 'u': case 'x': case 'X': case 'o': case 'p':
+        if (*fmt == 'p') { v = (uintptr_t)va_arg(ap, void *); flags |= F_ALT; }
+        else switch (lng) {
+          case 1: v = va_arg(ap, unsigned long); break;
+          case 2: v = va_arg(ap, unsigned long long); break;
+          case 3: v = va_arg(ap, size_t); break;
+          default: v = va_arg(ap, unsigned);
+                   v = (lng == -1 ? (unsigned short)v : lng == -2 ? (unsigned char)v : v);
+        }
+        if (*fmt == 'u') s = utoa_dec(tmp_end, v);
+        else if (*fmt == 'o') {
+          s = utoa_pow2(tmp_end, v, 3, false);
+          if ((flags & F_ALT) && *s != '0') *-- s = '0';
+        } else {
+          s = utoa_pow2(tmp_end, v, 4, *fmt == 'X');
+          if ((flags & F_ALT) && v != 0) prefix = (*fmt == 'X' ? "0X" : "0x");
+        }
+        break;
+      default:
+        // not supported, print it as is
+        out_char(o, '%');
+        out_char(o, *fmt);
+        continue;
+    }
+
+    // numbers: the precision is the minimum number of digits
+    len = tmp_end - s;
+    // no digit for 0 with the precision 0, but the leading 0 of %#o
+    if (prec == 0 && v == 0 && !(*fmt == 'o' && (flags & F_ALT))) len = 0;
+    int zeros = (prec > len ? prec - len : 0);
+    int plen = (prefix[0] == '\0' ? 0 : prefix[1] == '\0' ? 1 : 2);
+    if (prec < 0 && (flags & (F_ZERO | F_LEFT)) == F_ZERO && width > plen + len) {
+      zeros = width - plen - len;
+    }
+    pad = width - plen - zeros - len;
+    if (!(flags & F_LEFT)) out_pad(o, ' ', pad);
+    out_str(o, prefix, plen);
+    out_pad(o, '0', zeros);
+    out_str(o, s, len);
+    if (flags & F_LEFT) out_pad(o, ' ', pad);
+    continue;
+
+emit:
+    pad = width - len;
+    if (!(flags & F_LEFT)) out_pad(o, ' ', pad);
+    out_str(o, s, len);
+    if (flags & F_LEFT) out_pad(o, ' ', pad);
+  }
+}
+
 int printf(const char *fmt, ...) {
-  panic("Not implemented");
+  char buf[256];
+  Sink o = { .buf = buf, .size = sizeof(buf), .to_putch = true };
+  va_list ap;
+  va_start(ap, fmt);
+  format(&o, fmt, ap);
+  va_end(ap);
+  sink_flush(&o);
+  return o.total;
+}
+
+int vsnprintf(char *out, size_t n, const char *fmt, va_list ap) {
+  Sink o = { .buf = out, .size = n };
+  format(&o, fmt, ap);
+  if (n > 0) out[o.pos] = '\0';
+  return o.total;
 }
 
 int vsprintf(char *out, const char *fmt, va_list ap) {
-  panic("Not implemented");
+  return vsnprintf(out, (size_t)-1 / 2, fmt, ap);
 }
 
 int sprintf(char *out, const char *fmt, ...) {
-  panic("Not implemented");
+  va_list ap;
+  va_start(ap, fmt);
+  int ret = vsprintf(out, fmt, ap);
+  va_end(ap);
+  return ret;
 }
 
 int snprintf(char *out, size_t n, const char *fmt, ...) {
-  panic("Not implemented");
-}
-
-int vsnprintf(char *out, size_t n, const char *fmt, va_list ap) {
-  panic("Not implemented");
+  va_list ap;
+  va_start(ap, fmt);
+  int ret = vsnprintf(out, n, fmt, ap);
+  va_end(ap);
+  return ret;
 }
 
 #endif
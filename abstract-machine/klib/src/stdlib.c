@@ -29,17 +29,167 @@ int atoi(const char* nptr) {
   return x;
 }
 
-void *malloc(size_t size) {
-  // On native, malloc() will be called during initializaion of C runtime.
-  // Therefore do not call panic() here, else it will yield a dead recursion:
-  //   panic() -> putchar() -> (glibc) -> malloc() -> panic()
-#if !(defined(__ISA_NATIVE__) && defined(__NATIVE_USE_KLIB__))
-  panic("Not implemented");
+/* A size-class allocator over `heap`. Every block starts with a header
+ * keeping its size, so free() finds the list of a block without searching.
+ * Small blocks are powers of two from 16 to 2048 bytes, carved from slabs
+ * and recycled on one free list per class. Large blocks come from the same
+ * bump pointer with their exact size, and freed ones are kept on lists
+ * indexed by log2 of the size. Memory is never returned to the bump
+ * pointer, which is fine for the programs running on AM.
+ *
+ * Define KLIB_MALLOC_NR_CPU to the maximum number of CPUs to give each CPU
+ * its own lists of small blocks, which are then used without the lock. */
+#ifndef KLIB_MALLOC_NR_CPU
+#define KLIB_MALLOC_NR_CPU 1
 #endif
-  return NULL;
+
+#define ALIGN      (2 * sizeof(size_t))
+#define MIN_SHIFT  4
+#define NR_SMALL   8
+#define MAX_SMALL  (1 << (MIN_SHIFT + NR_SMALL - 1))
+#define SLAB_SIZE  4096
+#define NR_LARGE   (8 * sizeof(size_t))
+
+typedef struct Block {
+  size_t size;          // including the header
+  struct Block *next;   // only meaningful on a free list
+} Block;
+
+typedef struct {
+  Block *small[NR_SMALL];
+} Cache;
+
+static Cache cache[KLIB_MALLOC_NR_CPU];
+static Block *large[NR_LARGE];
+static uintptr_t heap_brk = 0;
+static int lock = 0;
+
+static inline void acquire() { while (atomic_xchg(&lock, 1)); }
+static inline void release() { atomic_xchg(&lock, 0); }
+
+#if KLIB_MALLOC_NR_CPU > 1
+static inline Cache *my_cache() { return &cache[cpu_current()]; }
+#define small_acquire()
+#define small_release()
+#else
+static inline Cache *my_cache() { return &cache[0]; }
+#define small_acquire() acquire()
+#define small_release() release()
+#endif
+
+// ceil(log2(size / 16)) for the sizes of small blocks
+static inline int small_class(size_t size) {
+  int c = 0;
+  for (size = (size - 1) >> MIN_SHIFT; size != 0; size >>= 1) c ++;
+  return c;
+}
+
+static inline int floor_log2(size_t x) {
+  int k = 0;
+  while (x >>= 1) k ++;
+  return k;
+}
+
+// called with the lock held
+static void *sbrk_locked(size_t size) {
+  if (heap_brk == 0) heap_brk = ROUNDUP(heap.start, ALIGN);
+  if (heap_brk == 0 || size > (uintptr_t)heap.end - heap_brk) return NULL;
+  void *p = (void *)heap_brk;
+  heap_brk += size;
+  return p;
+}
+
+static Block *refill(Cache *c, int cls) {
+  size_t bsize = (size_t)1 << (MIN_SHIFT + cls);
+  size_t n = SLAB_SIZE / bsize;
+  acquire();
+  uint8_t *slab = sbrk_locked(n * bsize);
+  release();
+  if (slab == NULL) return NULL;
+  // keep the first block, and put the others on the list
+  size_t i;
+  for (i = 0; i < n; i ++) {
+    Block *b = (Block *)(slab + i * bsize);
+    b->size = bsize;
+    b->next = (Block *)(slab + (i + 1) * bsize);
+  }
+  if (n > 1) {
+    Block *last = (Block *)(slab + (n - 1) * bsize);
+    small_acquire();
+    last->next = c->small[cls];
+    c->small[cls] = (Block *)(slab + bsize);
+    small_release();
+  }
+  return (Block *)slab;
+}
+
+static Block *alloc_large(size_t size) {
+  int k = floor_log2(size);
+  Block *b = NULL;
+  acquire();
+  // the blocks on large[k] may be smaller than size, but those on
+  // large[k + 1] and above are not
+  if (large[k] != NULL && large[k]->size >= size) {
+    b = large[k];
+    large[k] = b->next;
+  } else if (k + 1 < NR_LARGE && large[k + 1] != NULL) {
+    b = large[k + 1];
+    large[k + 1] = b->next;
+  } else if ((b = sbrk_locked(size)) != NULL) {
+    b->size = size;
+  } else {
+    for (k += 2; k < NR_LARGE; k ++) {
+      if (large[k] != NULL) {
+        b = large[k];
+        large[k] = b->next;
+        break;
+      }
+    }
+  }
+  release();
+  return b;
+}
+
+void *malloc(size_t size) {
+  if (size == 0 || size > (size_t)-1 / 2) return NULL;
+  size = ROUNDUP(size + sizeof(Block), ALIGN);
+  Block *b;
+  if (size <= MAX_SMALL) {
+    int cls = small_class(size);
+    Cache *c = my_cache();
+    small_acquire();
+    b = c->small[cls];
+    if (b != NULL) c->small[cls] = b->next;
+    small_release();
+    if (b == NULL) {
+      b = refill(c, cls);
+      // on native, malloc() is called before `heap` is set
+      if (b == NULL) return NULL;
+    }
+  } else {
+    b = alloc_large(size);
+    if (b == NULL) return NULL;
+  }
+  return b + 1;
 }
 
 void free(void *ptr) {
+  if (ptr == NULL) return;
+  Block *b = (Block *)ptr - 1;
+  if (b->size <= MAX_SMALL) {
+    int cls = small_class(b->size);
+    Cache *c = my_cache();
+    small_acquire();
+    b->next = c->small[cls];
+    c->small[cls] = b;
+    small_release();
+  } else {
+    int k = floor_log2(b->size);
+    acquire();
+    b->next = large[k];
+    large[k] = b;
+    release();
+  }
 }
 
 #endif
@@ -4,44 +4,225 @@
 
 #if !defined(__ISA_NATIVE__) || defined(__NATIVE_USE_KLIB__)
 
+/* The string and memory functions are the hottest functions of most
+ * programs running on AM, and every guest instruction here costs many host
+ * instructions on NEMU, so they work a word at a time once the pointers
+ * are aligned. Only aligned words are accessed, since riscv is built with
+ * -mstrict-align and mips traps on unaligned loads. An aligned word never
+ * crosses a page, so reading the whole word holding the '\0' is safe. */
+typedef uintptr_t __attribute__((may_alias)) word;
+#define WSIZE sizeof(word)
+#define WMASK (WSIZE - 1)
+#define ALIGNED(p) (((uintptr_t)(p) & WMASK) == 0)
+#define SAME_ALIGN(p, q) ((((uintptr_t)(p) ^ (uintptr_t)(q)) & WMASK) == 0)
+#define ONES  ((word)-1 / 0xff)
+#define HIGHS (ONES << 7)
+// nonzero iff some byte of w is 0
+#define HAS_ZERO(w) (((w) - ONES) & ~(w) & HIGHS)
+
+// keep gcc from turning the loops below into calls to themselves
+#if defined(__GNUC__) && !defined(__clang__)
+#define NO_LIBCALL __attribute__((optimize("no-tree-loop-distribute-patterns")))
+#else
+#define NO_LIBCALL
+#endif
+
+// `rep movs/stos` is fast on real x86, but NEMU does not implement it
+#ifdef __ARCH_X86_QEMU
+#define USE_REP_STRING
+#endif
+
+/* NEMU built with CONFIG_PV_MEM does bulk copies and fills on the host when
+ * asked by a semihosting call with its own operation numbers. It answers
+ * non-zero when a range is not in pmem, and then the loops here are taken. */
+#if defined(__PLATFORM_NEMU) && defined(__riscv) && defined(__NEMU_PV_MEM__)
+enum { PV_MEMCPY = 0x100, PV_MEMSET = 0x101, PV_MEMMOVE = 0x102 };
+// shorter ones are faster in the guest than a trip to the host
+#define PV_MEM_MIN 64
+
+static inline long pv_mem(long op, void *dst, uintptr_t src, size_t n) {
+  register long a0 asm("a0") = op;
+  register void *a1 asm("a1") = dst;
+  register uintptr_t a2 asm("a2") = src;
+  register size_t a3 asm("a3") = n;
+  asm volatile(".balign 16; .option push; .option norvc;"
+      "slli x0, x0, 0x1f; ebreak; srai x0, x0, 7; .option pop"
+      : "+r"(a0) : "r"(a1), "r"(a2), "r"(a3) : "memory");
+  return a0;
+}
+#define PV_MEM(op, dst, src, n) ((n) >= PV_MEM_MIN && pv_mem(op, dst, (uintptr_t)(src), n) == 0)
+#else
+#define PV_MEM(op, dst, src, n) 0
+#endif
+
+NO_LIBCALL
 size_t strlen(const char *s) {
-  panic("Not implemented");
+  const char *p = s;
+  for (; !ALIGNED(p); p ++) if (*p == '\0') return p - s;
+  const word *wp = (const word *)p;
+  while (!HAS_ZERO(*wp)) wp ++;
+  for (p = (const char *)wp; *p != '\0'; p ++);
+  return p - s;
 }
 
+NO_LIBCALL
 char *strcpy(char *dst, const char *src) {
-  panic("Not implemented");
+  char *d = dst;
+  if (SAME_ALIGN(d, src)) {
+    for (; !ALIGNED(src); d ++, src ++) if ((*d = *src) == '\0') return dst;
+    word *wd = (word *)d;
+    const word *ws = (const word *)src;
+    while (!HAS_ZERO(*ws)) *wd ++ = *ws ++;
+    d = (char *)wd; src = (const char *)ws;
+  }
+  while ((*d ++ = *src ++) != '\0');
+  return dst;
 }
 
+NO_LIBCALL
 char *strncpy(char *dst, const char *src, size_t n) {
-  panic("Not implemented");
+  size_t i;
+  for (i = 0; i < n && src[i] != '\0'; i ++) dst[i] = src[i];
+  if (i < n) memset(dst + i, 0, n - i);
+  return dst;
 }
 
 char *strcat(char *dst, const char *src) {
-  panic("Not implemented");
+  strcpy(dst + strlen(dst), src);
+  return dst;
 }
 
 int strcmp(const char *s1, const char *s2) {
-  panic("Not implemented");
+  if (SAME_ALIGN(s1, s2)) {
+    for (; !ALIGNED(s1); s1 ++, s2 ++) {
+      if (*s1 != *s2 || *s1 == '\0') return (uint8_t)*s1 - (uint8_t)*s2;
+    }
+    const word *w1 = (const word *)s1, *w2 = (const word *)s2;
+    while (*w1 == *w2 && !HAS_ZERO(*w1)) { w1 ++; w2 ++; }
+    s1 = (const char *)w1; s2 = (const char *)w2;
+  }
+  for (; *s1 == *s2 && *s1 != '\0'; s1 ++, s2 ++);
+  return (uint8_t)*s1 - (uint8_t)*s2;
 }
 
 int strncmp(const char *s1, const char *s2, size_t n) {
-  panic("Not implemented");
+  for (; n > 0; n --, s1 ++, s2 ++) {
+    if (*s1 != *s2 || *s1 == '\0') return (uint8_t)*s1 - (uint8_t)*s2;
+  }
+  return 0;
 }
 
+NO_LIBCALL
 void *memset(void *s, int c, size_t n) {
-  panic("Not implemented");
+  if (PV_MEM(PV_MEMSET, s, (uint8_t)c, n)) return s;
+  uint8_t *p = s;
+#ifdef USE_REP_STRING
+  asm volatile ("rep stosb" : "+D"(p), "+c"(n) : "a"(c) : "memory");
+#else
+  for (; n > 0 && !ALIGNED(p); n --) *p ++ = c;
+  if (n >= WSIZE) {
+    word w = (word)-1 / 0xff * (uint8_t)c;
+    word *wp = (word *)p;
+    for (; n >= 4 * WSIZE; n -= 4 * WSIZE, wp += 4) {
+      wp[0] = w; wp[1] = w; wp[2] = w; wp[3] = w;
+    }
+    for (; n >= WSIZE; n -= WSIZE) *wp ++ = w;
+    p = (uint8_t *)wp;
+  }
+  for (; n > 0; n --) *p ++ = c;
+#endif
+  return s;
+}
+
+/* Copy forward with the destination aligned. When the source is not aligned
+ * the same way, each destination word is merged from two aligned source
+ * words. All the ISAs of AM are little-endian here. The aligned words read
+ * may cover a few bytes outside [src, src + n), but never cross a word
+ * boundary, so they are in the same page. */
+NO_LIBCALL
+static void copy_fwd(uint8_t *d, const uint8_t *s, size_t n) {
+  for (; n > 0 && !ALIGNED(d); n --) *d ++ = *s ++;
+  if (n >= WSIZE) {
+    word *wd = (word *)d;
+    size_t off = (uintptr_t)s & WMASK;
+    if (off == 0) {
+      const word *ws = (const word *)s;
+      for (; n >= 4 * WSIZE; n -= 4 * WSIZE, wd += 4, ws += 4) {
+        word a = ws[0], b = ws[1], c = ws[2], e = ws[3];
+        wd[0] = a; wd[1] = b; wd[2] = c; wd[3] = e;
+      }
+      for (; n >= WSIZE; n -= WSIZE) *wd ++ = *ws ++;
+      s = (const uint8_t *)ws;
+    } else {
+      int rs = off * 8, ls = WSIZE * 8 - rs;
+      const word *ws = (const word *)(s - off);
+      word lo = *ws ++;
+      for (; n >= 2 * WSIZE; n -= 2 * WSIZE, wd += 2, ws += 2) {
+        word a = ws[0], b = ws[1];
+        wd[0] = (lo >> rs) | (a << ls);
+        wd[1] = (a >> rs) | (b << ls);
+        lo = b;
+      }
+      for (; n >= WSIZE; n -= WSIZE) {
+        word a = *ws ++;
+        *wd ++ = (lo >> rs) | (a << ls);
+        lo = a;
+      }
+      s = (const uint8_t *)ws - WSIZE + off;
+    }
+    d = (uint8_t *)wd;
+  }
+  for (; n > 0; n --) *d ++ = *s ++;
+}
+
+// the mirror of copy_fwd() from the end, only taken when both ends line up
+NO_LIBCALL
+static void copy_bwd(uint8_t *d, const uint8_t *s, size_t n) {
+  d += n; s += n;
+  if ((((uintptr_t)d ^ (uintptr_t)s) & WMASK) == 0) {
+    for (; n > 0 && !ALIGNED(d); n --) *-- d = *-- s;
+    word *wd = (word *)d;
+    const word *ws = (const word *)s;
+    for (; n >= 4 * WSIZE; n -= 4 * WSIZE) {
+      wd -= 4; ws -= 4;
+      word a = ws[0], b = ws[1], c = ws[2], e = ws[3];
+      wd[0] = a; wd[1] = b; wd[2] = c; wd[3] = e;
+    }
+    for (; n >= WSIZE; n -= WSIZE) *-- wd = *-- ws;
+    d = (uint8_t *)wd; s = (const uint8_t *)ws;
+  }
+  for (; n > 0; n --) *-- d = *-- s;
 }
 
 void *memmove(void *dst, const void *src, size_t n) {
-  panic("Not implemented");
+  // unsigned distance: copying forward is safe unless dst is inside [src, src + n)
+  if ((uintptr_t)dst - (uintptr_t)src >= n) return memcpy(dst, src, n);
+  if (PV_MEM(PV_MEMMOVE, dst, src, n)) return dst;
+  copy_bwd(dst, src, n);
+  return dst;
 }
 
 void *memcpy(void *out, const void *in, size_t n) {
-  panic("Not implemented");
+  if (PV_MEM(PV_MEMCPY, out, in, n)) return out;
+#ifdef USE_REP_STRING
+  void *d = out;
+  asm volatile ("rep movsb" : "+D"(d), "+S"(in), "+c"(n) : : "memory");
+#else
+  copy_fwd(out, in, n);
+#endif
+  return out;
 }
 
 int memcmp(const void *s1, const void *s2, size_t n) {
-  panic("Not implemented");
+  const uint8_t *p1 = s1, *p2 = s2;
+  if (n >= WSIZE && SAME_ALIGN(p1, p2)) {
+    for (; !ALIGNED(p1); n --, p1 ++, p2 ++) if (*p1 != *p2) return *p1 - *p2;
+    const word *w1 = (const word *)p1, *w2 = (const word *)p2;
+    for (; n >= WSIZE && *w1 == *w2; n -= WSIZE) { w1 ++; w2 ++; }
+    p1 = (const uint8_t *)w1; p2 = (const uint8_t *)w2;
+  }
+  for (; n > 0; n --, p1 ++, p2 ++) if (*p1 != *p2) return *p1 - *p2;
+  return 0;
 }
 
 #endif
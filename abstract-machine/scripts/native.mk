@@ -11,11 +11,12 @@ AM_SRCS := native/trm.c \
            native/ioe/uart.c \
            native/ioe/audio.c \
            native/ioe/disk.c \
+           native/ioe/net.c \
 
 CFLAGS  += -fpie $(shell sdl2-config --cflags)
 ASFLAGS += -fpie -pie
 comma = ,
-LDFLAGS_CXX = $(addprefix -Wl$(comma), $(LDFLAGS)) -pie -ldl $(shell sdl2-config --libs)
+LDFLAGS_CXX = $(addprefix -Wl$(comma), $(LDFLAGS)) -pie -ldl -lpthread -lrt $(shell sdl2-config --libs)
 
 run: image
 	$(IMAGE).elf
@@ -5,9 +5,15 @@ AM_SRCS := platform/nemu/trm.c \
            platform/nemu/ioe/gpu.c \
            platform/nemu/ioe/audio.c \
            platform/nemu/ioe/disk.c \
+           platform/nemu/ioe/pvio.c \
+           platform/nemu/ioe/net.c \
            platform/nemu/mpe.c
 
 CFLAGS    += -fdata-sections -ffunction-sections
+# `make PV_MEM=1` for NEMU with CONFIG_PV_MEM, which does memcpy() and friends of klib on the host
+ifdef PV_MEM
+CFLAGS    += -D__NEMU_PV_MEM__
+endif
 CFLAGS    += -I$(AM_HOME)/am/src/platform/nemu/include
 LDSCRIPTS += $(AM_HOME)/scripts/linker.ld
 LDFLAGS   += --defsym=_pmem_start=0x80000000 --defsym=_entry_offset=0x0
@@ -5,6 +5,8 @@ export PATH := $(PATH):$(abspath $(AM_HOME)/tools/rvmini)
 CC = rvmini-gcc
 AS = rvmini-gcc
 CXX = rvmini-g++
+# layout of the lookup tables, byte or nibble, see tools/rvmini/gen-lut.c
+export RVMINI_LUT ?= byte
 
 CFLAGS  += -DISA_H=\"riscv/riscv.h\"
 COMMON_CFLAGS += -march=rv32i_zicsr -mabi=ilp32  # overwrite
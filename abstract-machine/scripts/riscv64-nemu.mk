@@ -1,6 +1,7 @@
 include $(AM_HOME)/scripts/isa/riscv.mk
 include $(AM_HOME)/scripts/platform/nemu.mk
 CFLAGS  += -DISA_H=\"riscv/riscv.h\"
+COMMON_CFLAGS += -march=rv64ima_zicsr -mabi=lp64   # overwrite
 
 AM_SRCS += riscv/nemu/start.S \
            riscv/nemu/cte.c \
@@ -0,0 +1,118 @@
+#include <am.h>
+#include <klib.h>
+#include <klib-macros.h>
+
+/* Time the device operations seen by the guest, each repeated a number of
+ * times between two reads of the uptime timer. `mainargs` names the one to
+ * run, or all of them if it is empty. A result is printed as
+ *   devbench: NAME ITERS US
+ * with the time of all the iterations, which is the host time on NEMU
+ * without CONFIG_TIMER_VIRTUAL. A device is only touched by its own
+ * operation, since NEMU aborts on the registers of a device not built in,
+ * so running one operation at a time gives the others without it.
+ *
+ * With CONFIG_IDLE_SLEEP, NEMU takes a tight loop reading the timer or the
+ * keyboard as idle and sleeps, so build it without for these numbers. */
+
+#define FB_MAX (800 * 600)
+#define AUDIO_CHUNK 64
+
+static uint32_t pixels[FB_MAX];
+static uint8_t blk[4096];
+static uint8_t chunk[AUDIO_CHUNK];
+
+static uint64_t uptime() {
+  return io_read(AM_TIMER_UPTIME).us;
+}
+
+static void report(const char *name, int iters, uint64_t t0) {
+  printf("devbench: %s %d %d\n", name, iters, (int)(uptime() - t0));
+}
+
+static void bench_none() {
+  report("none", 0, uptime());
+}
+
+static void bench_serial() {
+  int i, n = 100000;
+  uint64_t t0 = uptime();
+  // NUL is written, which the harness drops from the output
+  for (i = 0; i < n; i ++) putch('\0');
+  report("serial", n, t0);
+}
+
+static void bench_rtc() {
+  int i, n = 100000;
+  uint64_t t0 = uptime();
+  for (i = 0; i < n; i ++) io_read(AM_TIMER_RTC);
+  report("rtc", n, t0);
+}
+
+static void bench_keyboard() {
+  int i, n = 100000;
+  uint64_t t0 = uptime();
+  for (i = 0; i < n; i ++) io_read(AM_INPUT_KEYBRD);
+  report("keyboard", n, t0);
+}
+
+static void bench_fbdraw() {
+  AM_GPU_CONFIG_T cfg = io_read(AM_GPU_CONFIG);
+  int w = cfg.width, h = cfg.height, i, n = 200;
+  if (!cfg.present || w * h > FB_MAX) { printf("devbench: fbdraw skipped\n"); return; }
+  uint64_t t0 = uptime();
+  for (i = 0; i < n; i ++) {
+    // a different color each time, so that nothing is skipped as unchanged
+    pixels[0] = i;
+    io_write(AM_GPU_FBDRAW, 0, 0, pixels, w, h, true);
+  }
+  report("fbdraw", n, t0);
+}
+
+static void bench_disk() {
+  AM_DISK_CONFIG_T cfg = io_read(AM_DISK_CONFIG);
+  int i, n = 10000;
+  if (!cfg.present || cfg.blksz > (int)sizeof(blk)) { printf("devbench: disk skipped\n"); return; }
+  uint64_t t0 = uptime();
+  for (i = 0; i < n; i ++) {
+    io_write(AM_DISK_BLKIO, false, blk, i % cfg.blkcnt, 1);
+    while (!io_read(AM_DISK_STATUS).ready) ;
+  }
+  report("disk", n, t0);
+}
+
+static void bench_audio() {
+  AM_AUDIO_CONFIG_T cfg = io_read(AM_AUDIO_CONFIG);
+  if (!cfg.present) { printf("devbench: audio skipped\n"); return; }
+  io_write(AM_AUDIO_CTRL, 44100, 2, 1024);
+  // only the chunks fitting in the buffer, so that playing never waits for the host
+  int i, n = cfg.bufsize / AUDIO_CHUNK / 2;
+  uint64_t t0 = uptime();
+  for (i = 0; i < n; i ++) io_write(AM_AUDIO_PLAY, RANGE(chunk, chunk + AUDIO_CHUNK));
+  report("audio", n, t0);
+}
+
+static struct {
+  const char *name;
+  void (*func)();
+} bench[] = {
+  { "none", bench_none },
+  { "serial", bench_serial },
+  { "rtc", bench_rtc },
+  { "keyboard", bench_keyboard },
+  { "fbdraw", bench_fbdraw },
+  { "disk", bench_disk },
+  { "audio", bench_audio },
+};
+
+int main(const char *args) {
+  ioe_init();
+  int i, found = 0;
+  for (i = 0; i < LENGTH(bench); i ++) {
+    if (args[0] == '\0' || strcmp(args, bench[i].name) == 0) {
+      bench[i].func();
+      found ++;
+    }
+  }
+  if (found == 0) printf("devbench: unknown operation '%s'\n", args);
+  return found == 0;
+}
@@ -0,0 +1,546 @@
+// generated by gen-ref.py, do not edit
+// a, b, mul, mulh, mulhsu, mulhu, div, divu, rem, remu
+{ 0x00000000, 0x00000000, { 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0xffffffff, 0xffffffff, 0x00000000, 0x00000000 } },
+{ 0x00000000, 0x00000001, { 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000 } },
+{ 0x00000000, 0x00000002, { 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000 } },
+{ 0x00000000, 0x00000003, { 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000 } },
+{ 0x00000000, 0x00000007, { 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000 } },
+{ 0x00000000, 0x7fffffff, { 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000 } },
+{ 0x00000000, 0x80000000, { 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000 } },
+{ 0x00000000, 0x80000001, { 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000 } },
+{ 0x00000000, 0xfffffffe, { 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000 } },
+{ 0x00000000, 0xffffffff, { 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000 } },
+{ 0x00000000, 0x00010000, { 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000 } },
+{ 0x00000000, 0x0000ffff, { 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000 } },
+{ 0x00000001, 0x00000000, { 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0xffffffff, 0xffffffff, 0x00000001, 0x00000001 } },
+{ 0x00000001, 0x00000001, { 0x00000001, 0x00000000, 0x00000000, 0x00000000, 0x00000001, 0x00000001, 0x00000000, 0x00000000 } },
+{ 0x00000001, 0x00000002, { 0x00000002, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000001, 0x00000001 } },
+{ 0x00000001, 0x00000003, { 0x00000003, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000001, 0x00000001 } },
+{ 0x00000001, 0x00000007, { 0x00000007, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000001, 0x00000001 } },
+{ 0x00000001, 0x7fffffff, { 0x7fffffff, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000001, 0x00000001 } },
+{ 0x00000001, 0x80000000, { 0x80000000, 0xffffffff, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000001, 0x00000001 } },
+{ 0x00000001, 0x80000001, { 0x80000001, 0xffffffff, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000001, 0x00000001 } },
+{ 0x00000001, 0xfffffffe, { 0xfffffffe, 0xffffffff, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000001, 0x00000001 } },
+{ 0x00000001, 0xffffffff, { 0xffffffff, 0xffffffff, 0x00000000, 0x00000000, 0xffffffff, 0x00000000, 0x00000000, 0x00000001 } },
+{ 0x00000001, 0x00010000, { 0x00010000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000001, 0x00000001 } },
+{ 0x00000001, 0x0000ffff, { 0x0000ffff, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000001, 0x00000001 } },
+{ 0x00000002, 0x00000000, { 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0xffffffff, 0xffffffff, 0x00000002, 0x00000002 } },
+{ 0x00000002, 0x00000001, { 0x00000002, 0x00000000, 0x00000000, 0x00000000, 0x00000002, 0x00000002, 0x00000000, 0x00000000 } },
+{ 0x00000002, 0x00000002, { 0x00000004, 0x00000000, 0x00000000, 0x00000000, 0x00000001, 0x00000001, 0x00000000, 0x00000000 } },
+{ 0x00000002, 0x00000003, { 0x00000006, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000002, 0x00000002 } },
+{ 0x00000002, 0x00000007, { 0x0000000e, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000002, 0x00000002 } },
+{ 0x00000002, 0x7fffffff, { 0xfffffffe, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000002, 0x00000002 } },
+{ 0x00000002, 0x80000000, { 0x00000000, 0xffffffff, 0x00000001, 0x00000001, 0x00000000, 0x00000000, 0x00000002, 0x00000002 } },
+{ 0x00000002, 0x80000001, { 0x00000002, 0xffffffff, 0x00000001, 0x00000001, 0x00000000, 0x00000000, 0x00000002, 0x00000002 } },
+{ 0x00000002, 0xfffffffe, { 0xfffffffc, 0xffffffff, 0x00000001, 0x00000001, 0xffffffff, 0x00000000, 0x00000000, 0x00000002 } },
+{ 0x00000002, 0xffffffff, { 0xfffffffe, 0xffffffff, 0x00000001, 0x00000001, 0xfffffffe, 0x00000000, 0x00000000, 0x00000002 } },
+{ 0x00000002, 0x00010000, { 0x00020000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000002, 0x00000002 } },
+{ 0x00000002, 0x0000ffff, { 0x0001fffe, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000002, 0x00000002 } },
+{ 0x00000003, 0x00000000, { 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0xffffffff, 0xffffffff, 0x00000003, 0x00000003 } },
+{ 0x00000003, 0x00000001, { 0x00000003, 0x00000000, 0x00000000, 0x00000000, 0x00000003, 0x00000003, 0x00000000, 0x00000000 } },
+{ 0x00000003, 0x00000002, { 0x00000006, 0x00000000, 0x00000000, 0x00000000, 0x00000001, 0x00000001, 0x00000001, 0x00000001 } },
+{ 0x00000003, 0x00000003, { 0x00000009, 0x00000000, 0x00000000, 0x00000000, 0x00000001, 0x00000001, 0x00000000, 0x00000000 } },
+{ 0x00000003, 0x00000007, { 0x00000015, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000003, 0x00000003 } },
+{ 0x00000003, 0x7fffffff, { 0x7ffffffd, 0x00000001, 0x00000001, 0x00000001, 0x00000000, 0x00000000, 0x00000003, 0x00000003 } },
+{ 0x00000003, 0x80000000, { 0x80000000, 0xfffffffe, 0x00000001, 0x00000001, 0x00000000, 0x00000000, 0x00000003, 0x00000003 } },
+{ 0x00000003, 0x80000001, { 0x80000003, 0xfffffffe, 0x00000001, 0x00000001, 0x00000000, 0x00000000, 0x00000003, 0x00000003 } },
+{ 0x00000003, 0xfffffffe, { 0xfffffffa, 0xffffffff, 0x00000002, 0x00000002, 0xffffffff, 0x00000000, 0x00000001, 0x00000003 } },
+{ 0x00000003, 0xffffffff, { 0xfffffffd, 0xffffffff, 0x00000002, 0x00000002, 0xfffffffd, 0x00000000, 0x00000000, 0x00000003 } },
+{ 0x00000003, 0x00010000, { 0x00030000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000003, 0x00000003 } },
+{ 0x00000003, 0x0000ffff, { 0x0002fffd, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000003, 0x00000003 } },
+{ 0x00000007, 0x00000000, { 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0xffffffff, 0xffffffff, 0x00000007, 0x00000007 } },
+{ 0x00000007, 0x00000001, { 0x00000007, 0x00000000, 0x00000000, 0x00000000, 0x00000007, 0x00000007, 0x00000000, 0x00000000 } },
+{ 0x00000007, 0x00000002, { 0x0000000e, 0x00000000, 0x00000000, 0x00000000, 0x00000003, 0x00000003, 0x00000001, 0x00000001 } },
+{ 0x00000007, 0x00000003, { 0x00000015, 0x00000000, 0x00000000, 0x00000000, 0x00000002, 0x00000002, 0x00000001, 0x00000001 } },
+{ 0x00000007, 0x00000007, { 0x00000031, 0x00000000, 0x00000000, 0x00000000, 0x00000001, 0x00000001, 0x00000000, 0x00000000 } },
+{ 0x00000007, 0x7fffffff, { 0x7ffffff9, 0x00000003, 0x00000003, 0x00000003, 0x00000000, 0x00000000, 0x00000007, 0x00000007 } },
+{ 0x00000007, 0x80000000, { 0x80000000, 0xfffffffc, 0x00000003, 0x00000003, 0x00000000, 0x00000000, 0x00000007, 0x00000007 } },
+{ 0x00000007, 0x80000001, { 0x80000007, 0xfffffffc, 0x00000003, 0x00000003, 0x00000000, 0x00000000, 0x00000007, 0x00000007 } },
+{ 0x00000007, 0xfffffffe, { 0xfffffff2, 0xffffffff, 0x00000006, 0x00000006, 0xfffffffd, 0x00000000, 0x00000001, 0x00000007 } },
+{ 0x00000007, 0xffffffff, { 0xfffffff9, 0xffffffff, 0x00000006, 0x00000006, 0xfffffff9, 0x00000000, 0x00000000, 0x00000007 } },
+{ 0x00000007, 0x00010000, { 0x00070000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000007, 0x00000007 } },
+{ 0x00000007, 0x0000ffff, { 0x0006fff9, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000007, 0x00000007 } },
+{ 0x7fffffff, 0x00000000, { 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0xffffffff, 0xffffffff, 0x7fffffff, 0x7fffffff } },
+{ 0x7fffffff, 0x00000001, { 0x7fffffff, 0x00000000, 0x00000000, 0x00000000, 0x7fffffff, 0x7fffffff, 0x00000000, 0x00000000 } },
+{ 0x7fffffff, 0x00000002, { 0xfffffffe, 0x00000000, 0x00000000, 0x00000000, 0x3fffffff, 0x3fffffff, 0x00000001, 0x00000001 } },
+{ 0x7fffffff, 0x00000003, { 0x7ffffffd, 0x00000001, 0x00000001, 0x00000001, 0x2aaaaaaa, 0x2aaaaaaa, 0x00000001, 0x00000001 } },
+{ 0x7fffffff, 0x00000007, { 0x7ffffff9, 0x00000003, 0x00000003, 0x00000003, 0x12492492, 0x12492492, 0x00000001, 0x00000001 } },
+{ 0x7fffffff, 0x7fffffff, { 0x00000001, 0x3fffffff, 0x3fffffff, 0x3fffffff, 0x00000001, 0x00000001, 0x00000000, 0x00000000 } },
+{ 0x7fffffff, 0x80000000, { 0x80000000, 0xc0000000, 0x3fffffff, 0x3fffffff, 0x00000000, 0x00000000, 0x7fffffff, 0x7fffffff } },
+{ 0x7fffffff, 0x80000001, { 0xffffffff, 0xc0000000, 0x3fffffff, 0x3fffffff, 0xffffffff, 0x00000000, 0x00000000, 0x7fffffff } },
+{ 0x7fffffff, 0xfffffffe, { 0x00000002, 0xffffffff, 0x7ffffffe, 0x7ffffffe, 0xc0000001, 0x00000000, 0x00000001, 0x7fffffff } },
+{ 0x7fffffff, 0xffffffff, { 0x80000001, 0xffffffff, 0x7ffffffe, 0x7ffffffe, 0x80000001, 0x00000000, 0x00000000, 0x7fffffff } },
+{ 0x7fffffff, 0x00010000, { 0xffff0000, 0x00007fff, 0x00007fff, 0x00007fff, 0x00007fff, 0x00007fff, 0x0000ffff, 0x0000ffff } },
+{ 0x7fffffff, 0x0000ffff, { 0x7fff0001, 0x00007fff, 0x00007fff, 0x00007fff, 0x00008000, 0x00008000, 0x00007fff, 0x00007fff } },
+{ 0x80000000, 0x00000000, { 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0xffffffff, 0xffffffff, 0x80000000, 0x80000000 } },
+{ 0x80000000, 0x00000001, { 0x80000000, 0xffffffff, 0xffffffff, 0x00000000, 0x80000000, 0x80000000, 0x00000000, 0x00000000 } },
+{ 0x80000000, 0x00000002, { 0x00000000, 0xffffffff, 0xffffffff, 0x00000001, 0xc0000000, 0x40000000, 0x00000000, 0x00000000 } },
+{ 0x80000000, 0x00000003, { 0x80000000, 0xfffffffe, 0xfffffffe, 0x00000001, 0xd5555556, 0x2aaaaaaa, 0xfffffffe, 0x00000002 } },
+{ 0x80000000, 0x00000007, { 0x80000000, 0xfffffffc, 0xfffffffc, 0x00000003, 0xedb6db6e, 0x12492492, 0xfffffffe, 0x00000002 } },
+{ 0x80000000, 0x7fffffff, { 0x80000000, 0xc0000000, 0xc0000000, 0x3fffffff, 0xffffffff, 0x00000001, 0xffffffff, 0x00000001 } },
+{ 0x80000000, 0x80000000, { 0x00000000, 0x40000000, 0xc0000000, 0x40000000, 0x00000001, 0x00000001, 0x00000000, 0x00000000 } },
+{ 0x80000000, 0x80000001, { 0x80000000, 0x3fffffff, 0xbfffffff, 0x40000000, 0x00000001, 0x00000000, 0xffffffff, 0x80000000 } },
+{ 0x80000000, 0xfffffffe, { 0x00000000, 0x00000001, 0x80000001, 0x7fffffff, 0x40000000, 0x00000000, 0x00000000, 0x80000000 } },
+{ 0x80000000, 0xffffffff, { 0x80000000, 0x00000000, 0x80000000, 0x7fffffff, 0x80000000, 0x00000000, 0x00000000, 0x80000000 } },
+{ 0x80000000, 0x00010000, { 0x00000000, 0xffff8000, 0xffff8000, 0x00008000, 0xffff8000, 0x00008000, 0x00000000, 0x00000000 } },
+{ 0x80000000, 0x0000ffff, { 0x80000000, 0xffff8000, 0xffff8000, 0x00007fff, 0xffff8000, 0x00008000, 0xffff8000, 0x00008000 } },
+{ 0x80000001, 0x00000000, { 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0xffffffff, 0xffffffff, 0x80000001, 0x80000001 } },
+{ 0x80000001, 0x00000001, { 0x80000001, 0xffffffff, 0xffffffff, 0x00000000, 0x80000001, 0x80000001, 0x00000000, 0x00000000 } },
+{ 0x80000001, 0x00000002, { 0x00000002, 0xffffffff, 0xffffffff, 0x00000001, 0xc0000001, 0x40000000, 0xffffffff, 0x00000001 } },
+{ 0x80000001, 0x00000003, { 0x80000003, 0xfffffffe, 0xfffffffe, 0x00000001, 0xd5555556, 0x2aaaaaab, 0xffffffff, 0x00000000 } },
+{ 0x80000001, 0x00000007, { 0x80000007, 0xfffffffc, 0xfffffffc, 0x00000003, 0xedb6db6e, 0x12492492, 0xffffffff, 0x00000003 } },
+{ 0x80000001, 0x7fffffff, { 0xffffffff, 0xc0000000, 0xc0000000, 0x3fffffff, 0xffffffff, 0x00000001, 0x00000000, 0x00000002 } },
+{ 0x80000001, 0x80000000, { 0x80000000, 0x3fffffff, 0xc0000000, 0x40000000, 0x00000000, 0x00000001, 0x80000001, 0x00000001 } },
+{ 0x80000001, 0x80000001, { 0x00000001, 0x3fffffff, 0xc0000000, 0x40000001, 0x00000001, 0x00000001, 0x00000000, 0x00000000 } },
+{ 0x80000001, 0xfffffffe, { 0xfffffffe, 0x00000000, 0x80000001, 0x7fffffff, 0x3fffffff, 0x00000000, 0xffffffff, 0x80000001 } },
+{ 0x80000001, 0xffffffff, { 0x7fffffff, 0x00000000, 0x80000001, 0x80000000, 0x7fffffff, 0x00000000, 0x00000000, 0x80000001 } },
+{ 0x80000001, 0x00010000, { 0x00010000, 0xffff8000, 0xffff8000, 0x00008000, 0xffff8001, 0x00008000, 0xffff0001, 0x00000001 } },
+{ 0x80000001, 0x0000ffff, { 0x8000ffff, 0xffff8000, 0xffff8000, 0x00007fff, 0xffff8000, 0x00008000, 0xffff8001, 0x00008001 } },
+{ 0xfffffffe, 0x00000000, { 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0xffffffff, 0xffffffff, 0xfffffffe, 0xfffffffe } },
+{ 0xfffffffe, 0x00000001, { 0xfffffffe, 0xffffffff, 0xffffffff, 0x00000000, 0xfffffffe, 0xfffffffe, 0x00000000, 0x00000000 } },
+{ 0xfffffffe, 0x00000002, { 0xfffffffc, 0xffffffff, 0xffffffff, 0x00000001, 0xffffffff, 0x7fffffff, 0x00000000, 0x00000000 } },
+{ 0xfffffffe, 0x00000003, { 0xfffffffa, 0xffffffff, 0xffffffff, 0x00000002, 0x00000000, 0x55555554, 0xfffffffe, 0x00000002 } },
+{ 0xfffffffe, 0x00000007, { 0xfffffff2, 0xffffffff, 0xffffffff, 0x00000006, 0x00000000, 0x24924924, 0xfffffffe, 0x00000002 } },
+{ 0xfffffffe, 0x7fffffff, { 0x00000002, 0xffffffff, 0xffffffff, 0x7ffffffe, 0x00000000, 0x00000002, 0xfffffffe, 0x00000000 } },
+{ 0xfffffffe, 0x80000000, { 0x00000000, 0x00000001, 0xffffffff, 0x7fffffff, 0x00000000, 0x00000001, 0xfffffffe, 0x7ffffffe } },
+{ 0xfffffffe, 0x80000001, { 0xfffffffe, 0x00000000, 0xfffffffe, 0x7fffffff, 0x00000000, 0x00000001, 0xfffffffe, 0x7ffffffd } },
+{ 0xfffffffe, 0xfffffffe, { 0x00000004, 0x00000000, 0xfffffffe, 0xfffffffc, 0x00000001, 0x00000001, 0x00000000, 0x00000000 } },
+{ 0xfffffffe, 0xffffffff, { 0x00000002, 0x00000000, 0xfffffffe, 0xfffffffd, 0x00000002, 0x00000000, 0x00000000, 0xfffffffe } },
+{ 0xfffffffe, 0x00010000, { 0xfffe0000, 0xffffffff, 0xffffffff, 0x0000ffff, 0x00000000, 0x0000ffff, 0xfffffffe, 0x0000fffe } },
+{ 0xfffffffe, 0x0000ffff, { 0xfffe0002, 0xffffffff, 0xffffffff, 0x0000fffe, 0x00000000, 0x00010000, 0xfffffffe, 0x0000fffe } },
+{ 0xffffffff, 0x00000000, { 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff } },
+{ 0xffffffff, 0x00000001, { 0xffffffff, 0xffffffff, 0xffffffff, 0x00000000, 0xffffffff, 0xffffffff, 0x00000000, 0x00000000 } },
+{ 0xffffffff, 0x00000002, { 0xfffffffe, 0xffffffff, 0xffffffff, 0x00000001, 0x00000000, 0x7fffffff, 0xffffffff, 0x00000001 } },
+{ 0xffffffff, 0x00000003, { 0xfffffffd, 0xffffffff, 0xffffffff, 0x00000002, 0x00000000, 0x55555555, 0xffffffff, 0x00000000 } },
+{ 0xffffffff, 0x00000007, { 0xfffffff9, 0xffffffff, 0xffffffff, 0x00000006, 0x00000000, 0x24924924, 0xffffffff, 0x00000003 } },
+{ 0xffffffff, 0x7fffffff, { 0x80000001, 0xffffffff, 0xffffffff, 0x7ffffffe, 0x00000000, 0x00000002, 0xffffffff, 0x00000001 } },
+{ 0xffffffff, 0x80000000, { 0x80000000, 0x00000000, 0xffffffff, 0x7fffffff, 0x00000000, 0x00000001, 0xffffffff, 0x7fffffff } },
+{ 0xffffffff, 0x80000001, { 0x7fffffff, 0x00000000, 0xffffffff, 0x80000000, 0x00000000, 0x00000001, 0xffffffff, 0x7ffffffe } },
+{ 0xffffffff, 0xfffffffe, { 0x00000002, 0x00000000, 0xffffffff, 0xfffffffd, 0x00000000, 0x00000001, 0xffffffff, 0x00000001 } },
+{ 0xffffffff, 0xffffffff, { 0x00000001, 0x00000000, 0xffffffff, 0xfffffffe, 0x00000001, 0x00000001, 0x00000000, 0x00000000 } },
+{ 0xffffffff, 0x00010000, { 0xffff0000, 0xffffffff, 0xffffffff, 0x0000ffff, 0x00000000, 0x0000ffff, 0xffffffff, 0x0000ffff } },
+{ 0xffffffff, 0x0000ffff, { 0xffff0001, 0xffffffff, 0xffffffff, 0x0000fffe, 0x00000000, 0x00010001, 0xffffffff, 0x00000000 } },
+{ 0x00010000, 0x00000000, { 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0xffffffff, 0xffffffff, 0x00010000, 0x00010000 } },
+{ 0x00010000, 0x00000001, { 0x00010000, 0x00000000, 0x00000000, 0x00000000, 0x00010000, 0x00010000, 0x00000000, 0x00000000 } },
+{ 0x00010000, 0x00000002, { 0x00020000, 0x00000000, 0x00000000, 0x00000000, 0x00008000, 0x00008000, 0x00000000, 0x00000000 } },
+{ 0x00010000, 0x00000003, { 0x00030000, 0x00000000, 0x00000000, 0x00000000, 0x00005555, 0x00005555, 0x00000001, 0x00000001 } },
+{ 0x00010000, 0x00000007, { 0x00070000, 0x00000000, 0x00000000, 0x00000000, 0x00002492, 0x00002492, 0x00000002, 0x00000002 } },
+{ 0x00010000, 0x7fffffff, { 0xffff0000, 0x00007fff, 0x00007fff, 0x00007fff, 0x00000000, 0x00000000, 0x00010000, 0x00010000 } },
+{ 0x00010000, 0x80000000, { 0x00000000, 0xffff8000, 0x00008000, 0x00008000, 0x00000000, 0x00000000, 0x00010000, 0x00010000 } },
+{ 0x00010000, 0x80000001, { 0x00010000, 0xffff8000, 0x00008000, 0x00008000, 0x00000000, 0x00000000, 0x00010000, 0x00010000 } },
+{ 0x00010000, 0xfffffffe, { 0xfffe0000, 0xffffffff, 0x0000ffff, 0x0000ffff, 0xffff8000, 0x00000000, 0x00000000, 0x00010000 } },
+{ 0x00010000, 0xffffffff, { 0xffff0000, 0xffffffff, 0x0000ffff, 0x0000ffff, 0xffff0000, 0x00000000, 0x00000000, 0x00010000 } },
+{ 0x00010000, 0x00010000, { 0x00000000, 0x00000001, 0x00000001, 0x00000001, 0x00000001, 0x00000001, 0x00000000, 0x00000000 } },
+{ 0x00010000, 0x0000ffff, { 0xffff0000, 0x00000000, 0x00000000, 0x00000000, 0x00000001, 0x00000001, 0x00000001, 0x00000001 } },
+{ 0x0000ffff, 0x00000000, { 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0xffffffff, 0xffffffff, 0x0000ffff, 0x0000ffff } },
+{ 0x0000ffff, 0x00000001, { 0x0000ffff, 0x00000000, 0x00000000, 0x00000000, 0x0000ffff, 0x0000ffff, 0x00000000, 0x00000000 } },
+{ 0x0000ffff, 0x00000002, { 0x0001fffe, 0x00000000, 0x00000000, 0x00000000, 0x00007fff, 0x00007fff, 0x00000001, 0x00000001 } },
+{ 0x0000ffff, 0x00000003, { 0x0002fffd, 0x00000000, 0x00000000, 0x00000000, 0x00005555, 0x00005555, 0x00000000, 0x00000000 } },
+{ 0x0000ffff, 0x00000007, { 0x0006fff9, 0x00000000, 0x00000000, 0x00000000, 0x00002492, 0x00002492, 0x00000001, 0x00000001 } },
+{ 0x0000ffff, 0x7fffffff, { 0x7fff0001, 0x00007fff, 0x00007fff, 0x00007fff, 0x00000000, 0x00000000, 0x0000ffff, 0x0000ffff } },
+{ 0x0000ffff, 0x80000000, { 0x80000000, 0xffff8000, 0x00007fff, 0x00007fff, 0x00000000, 0x00000000, 0x0000ffff, 0x0000ffff } },
+{ 0x0000ffff, 0x80000001, { 0x8000ffff, 0xffff8000, 0x00007fff, 0x00007fff, 0x00000000, 0x00000000, 0x0000ffff, 0x0000ffff } },
+{ 0x0000ffff, 0xfffffffe, { 0xfffe0002, 0xffffffff, 0x0000fffe, 0x0000fffe, 0xffff8001, 0x00000000, 0x00000001, 0x0000ffff } },
+{ 0x0000ffff, 0xffffffff, { 0xffff0001, 0xffffffff, 0x0000fffe, 0x0000fffe, 0xffff0001, 0x00000000, 0x00000000, 0x0000ffff } },
+{ 0x0000ffff, 0x00010000, { 0xffff0000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x0000ffff, 0x0000ffff } },
+{ 0x0000ffff, 0x0000ffff, { 0xfffe0001, 0x00000000, 0x00000000, 0x00000000, 0x00000001, 0x00000001, 0x00000000, 0x00000000 } },
+{ 0x81854f8a, 0xd6f18134, { 0xb912b208, 0x1448cf9d, 0x95ce1f27, 0x6cbfa05b, 0x00000003, 0x00000000, 0xfcb0cbee, 0x81854f8a } },
+{ 0x740a7798, 0x568cec2b, { 0x9b223688, 0x273b64f3, 0x273b64f3, 0x273b64f3, 0x00000001, 0x00000001, 0x1d7d8b6d, 0x1d7d8b6d } },
+{ 0x8ed72d0d, 0x88126eb0, { 0xbc348ef0, 0x3502fd15, 0xc3da2a22, 0x4bec98d2, 0x00000000, 0x00000001, 0x8ed72d0d, 0x06c4be5d } },
+{ 0x625c4cbc, 0x7a9abd2a, { 0x08e362d8, 0x2f1b70c6, 0x2f1b70c6, 0x2f1b70c6, 0x00000000, 0x00000000, 0x625c4cbc, 0x625c4cbc } },
+{ 0xd5a32d77, 0x047128af, { 0x772dac59, 0xff43d301, 0xff43d301, 0x03b4fbb0, 0xfffffff7, 0x00000030, 0xfd9d9b9e, 0x006b8ca7 } },
+{ 0x28cf032c, 0x261b0d40, { 0x948e0700, 0x06130a6a, 0x06130a6a, 0x06130a6a, 0x00000001, 0x00000001, 0x02b3f5ec, 0x02b3f5ec } },
+{ 0x7349547b, 0xac3f03de, { 0x43d9b3aa, 0xda485111, 0x4d91a58c, 0x4d91a58c, 0xffffffff, 0x00000000, 0x1f885859, 0x7349547b } },
+{ 0xc34f77a7, 0xd7b56f8b, { 0x5b1a60ad, 0x098d4294, 0xccdcba3b, 0xa49229c6, 0x00000001, 0x00000000, 0xeb9a081c, 0xc34f77a7 } },
+{ 0x9b28f0f8, 0x005de8cd, { 0xe441b698, 0xffdb022b, 0xffdb022b, 0x0038eaf8, 0xfffffeee, 0x000001a6, 0xffac1c62, 0x005b2f0a } },
+{ 0xe7e74676, 0x5130c499, { 0x374b7486, 0xf85b9627, 0xf85b9627, 0x498c5ac0, 0x00000000, 0x00000002, 0xe7e74676, 0x4585bd44 } },
+{ 0x49e6d34c, 0xb8758ca7, { 0xa2dd6694, 0xeb5903ab, 0x353fd6f7, 0x353fd6f7, 0xffffffff, 0x00000000, 0x025c5ff3, 0x49e6d34c } },
+{ 0x5b9eafa0, 0x38ba4b39, { 0x7e08faa0, 0x144d62a2, 0x144d62a2, 0x144d62a2, 0x00000001, 0x00000001, 0x22e46467, 0x22e46467 } },
+{ 0x4e03769e, 0xaebb7fcd, { 0x3a085e86, 0xe73c077b, 0x353f7e19, 0x353f7e19, 0x00000000, 0x00000000, 0x4e03769e, 0x4e03769e } },
+{ 0x21da5c3e, 0x9a6fbb39, { 0x55e1d3ce, 0xf291c5af, 0x146c21ed, 0x146c21ed, 0x00000000, 0x00000000, 0x21da5c3e, 0x21da5c3e } },
+{ 0x13492926, 0x36328e64, { 0x2ad326d8, 0x04153db2, 0x04153db2, 0x04153db2, 0x00000000, 0x00000000, 0x13492926, 0x13492926 } },
+{ 0x8390d8c8, 0xc016bda5, { 0x5d9760e8, 0x1f10bc12, 0xa2a194da, 0x62b8527f, 0x00000001, 0x00000000, 0xc37a1b23, 0x8390d8c8 } },
+{ 0x4c43b249, 0xe00e8221, { 0xd5410d69, 0xf67bdc2e, 0x42bf8e77, 0x42bf8e77, 0xfffffffe, 0x00000000, 0x0c60b68b, 0x4c43b249 } },
+{ 0x9471dbaf, 0x8f1e4527, { 0xcd10a2a9, 0x2f6d0651, 0xc3dee200, 0x52fd2727, 0x00000000, 0x00000001, 0x9471dbaf, 0x05539688 } },
+{ 0xf6071d66, 0x2e02370f, { 0x8087a2fa, 0xfe353131, 0xfe353131, 0x2c376840, 0x00000000, 0x00000005, 0xf6071d66, 0x0ffc0a1b } },
+{ 0xfea52977, 0xdbc20c44, { 0x9afe979c, 0x00311a1a, 0xfed64391, 0xda984fd5, 0x00000000, 0x00000001, 0xfea52977, 0x22e31d33 } },
+{ 0xc753dad5, 0xb7def09f, { 0x71f29a4b, 0x0ff7bc0c, 0xd74b96e1, 0x8f2a8780, 0x00000000, 0x00000001, 0xc753dad5, 0x0f74ea36 } },
+{ 0x54bed04d, 0x2f53d047, { 0x3621555b, 0x0faac70e, 0x0faac70e, 0x0faac70e, 0x00000001, 0x00000001, 0x256b0006, 0x256b0006 } },
+{ 0x6247f846, 0xe3bc3a00, { 0xb3a7dc00, 0xf5261bfe, 0x576e1444, 0x576e1444, 0xfffffffd, 0x00000000, 0x0d7ca646, 0x6247f846 } },
+{ 0xe60b6c06, 0xc591fe22, { 0xb0184ccc, 0x05ec90ce, 0xebf7fcd4, 0xb189faf6, 0x00000000, 0x00000001, 0xe60b6c06, 0x20796de4 } },
+{ 0x3be2670f, 0xa67be674, { 0xc9632ccc, 0xeb0f6374, 0x26f1ca83, 0x26f1ca83, 0x00000000, 0x00000000, 0x3be2670f, 0x3be2670f } },
+{ 0xd2ef9267, 0x72ce906b, { 0x995e210d, 0xebca528d, 0xebca528d, 0x5e98e2f8, 0x00000000, 0x00000001, 0xd2ef9267, 0x602101fc } },
+{ 0x3ecf4b07, 0xb265e1d9, { 0xe66abfef, 0xecf5d655, 0x2bc5215c, 0x2bc5215c, 0x00000000, 0x00000000, 0x3ecf4b07, 0x3ecf4b07 } },
+{ 0x72a7e9d6, 0x04923c6c, { 0x6db0ce48, 0x020c1e7a, 0x020c1e7a, 0x020c1e7a, 0x00000019, 0x00000019, 0x0060034a, 0x0060034a } },
+{ 0x8eb4959a, 0xe9fc4a37, { 0x49a2a816, 0x09be1f7a, 0x9872b514, 0x826eff4b, 0x00000005, 0x00000000, 0xfcc72287, 0x8eb4959a } },
+{ 0xf5aaede6, 0xb741c475, { 0xf6a8d21e, 0x02ef9aa1, 0xf89a8887, 0xafdc4cfc, 0x00000000, 0x00000001, 0xf5aaede6, 0x3e692971 } },
+{ 0xbb46d66b, 0xee83cf20, { 0xe2fc5260, 0x04b1a291, 0xbff878fc, 0xae7c481c, 0x00000003, 0x00000000, 0xefbb690b, 0xbb46d66b } },
+{ 0xd6e8d6c7, 0x6edd209e, { 0xaa586ed2, 0xee348e0e, 0xee348e0e, 0x5d11aeac, 0x00000000, 0x00000001, 0xd6e8d6c7, 0x680bb629 } },
+{ 0x596e6224, 0x4a8c7faa, { 0x39ad07e8, 0x1a0afd55, 0x1a0afd55, 0x1a0afd55, 0x00000001, 0x00000001, 0x0ee1e27a, 0x0ee1e27a } },
+{ 0x596b45c2, 0xbd926334, { 0xa8683168, 0xe8cc0e92, 0x42375454, 0x42375454, 0xffffffff, 0x00000000, 0x16fda8f6, 0x596b45c2 } },
+{ 0xdeb49080, 0x462ffe86, { 0x4162a300, 0xf6df218f, 0xf6df218f, 0x3d0f2015, 0x00000000, 0x00000003, 0xdeb49080, 0x0c2494ee } },
+{ 0x95cdbdca, 0x590c6b8e, { 0x35eab40c, 0xdb0f6002, 0xdb0f6002, 0x341bcb90, 0xffffffff, 0x00000001, 0xeeda2958, 0x3cc1523c } },
+{ 0xb8327a1e, 0xc75aba50, { 0x7d0bf560, 0x0fe3504c, 0xc815ca6a, 0x8f7084ba, 0x00000001, 0x00000000, 0xf0d7bfce, 0xb8327a1e } },
+{ 0x19244e80, 0x29c60a36, { 0xefb98f00, 0x041a43a7, 0x041a43a7, 0x041a43a7, 0x00000000, 0x00000000, 0x19244e80, 0x19244e80 } },
+{ 0x0fdc8d93, 0xf89e8cb2, { 0x6d80d436, 0xff8aee6a, 0x0f677bfd, 0x0f677bfd, 0xfffffffe, 0x00000000, 0x0119a6f7, 0x0fdc8d93 } },
+{ 0x6d6e8e48, 0xa9e16a9f, { 0x53dc2eb8, 0xdb2fc964, 0x489e57ac, 0x489e57ac, 0xffffffff, 0x00000000, 0x174ff8e7, 0x6d6e8e48 } },
+{ 0x4e9c101b, 0xdfd77858, { 0x38df3148, 0xf6200bf2, 0x44bc1c0d, 0x44bc1c0d, 0xfffffffe, 0x00000000, 0x0e4b00cb, 0x4e9c101b } },
+{ 0x44209dca, 0xde3ba4e6, { 0xa3f12b7c, 0xf7038a71, 0x3b24283b, 0x3b24283b, 0xfffffffe, 0x00000000, 0x0097e796, 0x44209dca } },
+{ 0xd0db3490, 0x2e7877ce, { 0x79533be0, 0xf7713422, 0xf7713422, 0x25e9abf0, 0xffffffff, 0x00000004, 0xff53ac5e, 0x16f95558 } },
+{ 0xeb7df3b6, 0xdc07bfeb, { 0x376d8212, 0x02e1aacc, 0xee5f9e82, 0xca675e6d, 0x00000000, 0x00000001, 0xeb7df3b6, 0x0f7633cb } },
+{ 0x396a5944, 0x7661b77c, { 0x0016d8f0, 0x1a8cef98, 0x1a8cef98, 0x1a8cef98, 0x00000000, 0x00000000, 0x396a5944, 0x396a5944 } },
+{ 0x19af1a9a, 0x39fa8eb4, { 0x74442048, 0x05d1203d, 0x05d1203d, 0x05d1203d, 0x00000000, 0x00000000, 0x19af1a9a, 0x19af1a9a } },
+{ 0x305a196e, 0x1d4273c2, { 0x220faf5c, 0x0586c1f9, 0x0586c1f9, 0x0586c1f9, 0x00000001, 0x00000001, 0x1317a5ac, 0x1317a5ac } },
+{ 0x2f27b50f, 0x9fb88be1, { 0x74fd472f, 0xee43f2b3, 0x1d6ba7c2, 0x1d6ba7c2, 0x00000000, 0x00000000, 0x2f27b50f, 0x2f27b50f } },
+{ 0xb952f057, 0x4c60c887, { 0x7b20b5e1, 0xeae9e717, 0xeae9e717, 0x374aaf9e, 0x00000000, 0x00000002, 0xb952f057, 0x20915f49 } },
+{ 0x61bc195f, 0xd9ce10c6, { 0x4a838f7a, 0xf16b03e6, 0x53271d45, 0x53271d45, 0xfffffffe, 0x00000000, 0x15583aeb, 0x61bc195f } },
+{ 0xfa859aad, 0x0947dfdc, { 0xa7889fac, 0xffcd28b3, 0xffcd28b3, 0x0915088f, 0x00000000, 0x0000001a, 0xfa859aad, 0x0938de55 } },
+{ 0x04c709e1, 0x642396c2, { 0x7c625282, 0x01de69e2, 0x01de69e2, 0x01de69e2, 0x00000000, 0x00000000, 0x04c709e1, 0x04c709e1 } },
+{ 0x89080d2f, 0x2c441b17, { 0xbd992439, 0xeb6dbbd0, 0xeb6dbbd0, 0x17b1d6e7, 0xfffffffe, 0x00000003, 0xe190435d, 0x043bbbea } },
+{ 0x220c6220, 0x1f3699d3, { 0x099a0060, 0x0426c2f4, 0x0426c2f4, 0x0426c2f4, 0x00000001, 0x00000001, 0x02d5c84d, 0x02d5c84d } },
+{ 0xd9588871, 0xe92c8801, { 0x2e409071, 0x0372526c, 0xdccadadd, 0xc5f762de, 0x00000001, 0x00000000, 0xf02c0070, 0xd9588871 } },
+{ 0x6199dbab, 0x638ec4f4, { 0xccae4afc, 0x25f4ee61, 0x25f4ee61, 0x25f4ee61, 0x00000000, 0x00000000, 0x6199dbab, 0x6199dbab } },
+{ 0x3d9b92b2, 0x092ee73e, { 0xeb08251c, 0x0235c1c2, 0x0235c1c2, 0x0235c1c2, 0x00000006, 0x00000006, 0x0682273e, 0x0682273e } },
+{ 0x953fa9ff, 0x59a3afc1, { 0xee917a3f, 0xda9ee058, 0xda9ee058, 0x34429019, 0xffffffff, 0x00000001, 0xeee359c0, 0x3b9bfa3e } },
+{ 0xdf67b763, 0xedef71f8, { 0x10d95ae8, 0x024cd0b5, 0xe1b48818, 0xcfa3fa10, 0x00000001, 0x00000000, 0xf178456b, 0xdf67b763 } },
+{ 0x03eac0d8, 0xb07f74bd, { 0x6eda3f78, 0xfec896fb, 0x02b357d3, 0x02b357d3, 0x00000000, 0x00000000, 0x03eac0d8, 0x03eac0d8 } },
+{ 0x3afc3b7d, 0x5ede6e7b, { 0x35264b0f, 0x15dbde08, 0x15dbde08, 0x15dbde08, 0x00000000, 0x00000000, 0x3afc3b7d, 0x3afc3b7d } },
+{ 0xe72495a8, 0x7401cc5e, { 0xbc58d3b0, 0xf4bc671c, 0xf4bc671c, 0x68be337a, 0x00000000, 0x00000001, 0xe72495a8, 0x7322c94a } },
+{ 0x6b91d083, 0x4e414bd3, { 0x3c883cf9, 0x20e1dd6a, 0x20e1dd6a, 0x20e1dd6a, 0x00000001, 0x00000001, 0x1d5084b0, 0x1d5084b0 } },
+{ 0x18a6007c, 0x6b0ffb16, { 0xbc019ea8, 0x0a4eec1a, 0x0a4eec1a, 0x0a4eec1a, 0x00000000, 0x00000000, 0x18a6007c, 0x18a6007c } },
+{ 0xee65aaf8, 0xb76ce622, { 0x69bb84f0, 0x04fd8550, 0xf3633048, 0xaad0166a, 0x00000000, 0x00000001, 0xee65aaf8, 0x36f8c4d6 } },
+{ 0xf26adbbd, 0x08e3c362, { 0xf2e0155a, 0xff874140, 0xff874140, 0x086b04a2, 0xffffffff, 0x0000001b, 0xfb4e9f1f, 0x02654067 } },
+{ 0x6d3e7e7c, 0xd14ee400, { 0x6e6e7000, 0xec13311d, 0x5951af99, 0x5951af99, 0xfffffffe, 0x00000000, 0x0fdc467c, 0x6d3e7e7c } },
+{ 0x32267d71, 0x18e23993, { 0xb3ca30e3, 0x04dfed04, 0x04dfed04, 0x04dfed04, 0x00000002, 0x00000002, 0x00620a4b, 0x00620a4b } },
+{ 0x06d3f316, 0x86d5fce9, { 0x9f7fe706, 0xfcc4b33f, 0x0398a655, 0x0398a655, 0x00000000, 0x00000000, 0x06d3f316, 0x06d3f316 } },
+{ 0xbe2136f5, 0xa9f3c6a8, { 0x5ddc8ec8, 0x1623fcbc, 0xd44533b1, 0x7e38fa59, 0x00000000, 0x00000001, 0xbe2136f5, 0x142d704d } },
+{ 0xc575e874, 0xc1a893db, { 0xa078773c, 0x0e416f5c, 0xd3b757d0, 0x955febab, 0x00000000, 0x00000001, 0xc575e874, 0x03cd5499 } },
+{ 0xbcd273aa, 0x78f65154, { 0x6102bdc8, 0xe042031b, 0xe042031b, 0x5938546f, 0x00000000, 0x00000001, 0xbcd273aa, 0x43dc2256 } },
+{ 0xb0f5e6f1, 0x30aa570b, { 0xb816d35b, 0xf0f983b8, 0xf0f983b8, 0x21a3dac3, 0xffffffff, 0x00000003, 0xe1a03dfc, 0x1ef6e1d0 } },
+{ 0x5a75b742, 0xdac705cf, { 0x1a11785e, 0xf2d8da5b, 0x4d4e919d, 0x4d4e919d, 0xfffffffe, 0x00000000, 0x1003c2e0, 0x5a75b742 } },
+{ 0x4992ca22, 0xe2bf764c, { 0x541dae18, 0xf797d2d4, 0x412a9cf6, 0x412a9cf6, 0xfffffffe, 0x00000000, 0x0f11b6ba, 0x4992ca22 } },
+{ 0x932a523c, 0x9160f7ae, { 0xae9bc8c8, 0x2f076cea, 0xc231bf26, 0x5392b6d4, 0x00000000, 0x00000001, 0x932a523c, 0x01c95a8e } },
+{ 0xcb23ecd1, 0x04c722d3, { 0x8e86f243, 0xff03716f, 0xff03716f, 0x03ca9442, 0xfffffff5, 0x0000002a, 0xffb26be2, 0x02783633 } },
+{ 0x78759ece, 0xd8c1e4a1, { 0x0cb6578e, 0xed88db71, 0x65fe7a3f, 0x65fe7a3f, 0xfffffffd, 0x00000000, 0x02bb4cb1, 0x78759ece } },
+{ 0x83e44ef4, 0xe84501d8, { 0x94b591e0, 0x0b81243d, 0x8f657331, 0x77aa7509, 0x00000005, 0x00000000, 0xfa8b45bc, 0x83e44ef4 } },
+{ 0x63849a68, 0x81ea1aa8, { 0x51c3e440, 0xcefc38f8, 0x3280d360, 0x3280d360, 0x00000000, 0x00000000, 0x63849a68, 0x63849a68 } },
+{ 0xd288a2ff, 0x5599f025, { 0x9bf59edb, 0xf0cc0721, 0xf0cc0721, 0x4665f746, 0x00000000, 0x00000002, 0xd288a2ff, 0x2754c2b5 } },
+{ 0xf4dafcac, 0x3005370f, { 0x9479c214, 0xfde8d541, 0xfde8d541, 0x2dee0c50, 0x00000000, 0x00000005, 0xf4dafcac, 0x04c0e961 } },
+{ 0x46392de8, 0xdc95cf3e, { 0x55ffb630, 0xf6490dac, 0x3c823b94, 0x3c823b94, 0xffffffff, 0x00000000, 0x22cefd26, 0x46392de8 } },
+{ 0xf5bafa03, 0xe4f8099c, { 0x2fa274d4, 0x01159967, 0xf6d0936a, 0xdbc89d06, 0x00000000, 0x00000001, 0xf5bafa03, 0x10c2f067 } },
+{ 0xd01990be, 0xeb249512, { 0x47c2c35c, 0x03e70ed4, 0xd4009f92, 0xbf2534a4, 0x00000002, 0x00000000, 0xf9d0669a, 0xd01990be } },
+{ 0x677a70cb, 0xeeaaa729, { 0x12fe7d83, 0xf8fe5ef2, 0x6078cfbd, 0x6078cfbd, 0xfffffffb, 0x00000000, 0x10cfb498, 0x677a70cb } },
+{ 0x40d5b7f0, 0x6e00abe6, { 0x21e091a0, 0x1bdc0092, 0x1bdc0092, 0x1bdc0092, 0x00000000, 0x00000000, 0x40d5b7f0, 0x40d5b7f0 } },
+{ 0xaf47000b, 0xc4fd814e, { 0xa5868e5a, 0x129b6c62, 0xc1e26c6d, 0x86dfedbb, 0x00000001, 0x00000000, 0xea497ebd, 0xaf47000b } },
+{ 0x8ae94401, 0xc20bb316, { 0xb8a38b16, 0x1c5627a4, 0xa73f6ba5, 0x694b1ebb, 0x00000001, 0x00000000, 0xc8dd90eb, 0x8ae94401 } },
+{ 0x9745b270, 0x247fae6c, { 0x763f6740, 0xf1119150, 0xf1119150, 0x15913fbc, 0xfffffffe, 0x00000004, 0xe0450f48, 0x0546f8c0 } },
+{ 0xfe6982f5, 0xe088132d, { 0x7f6c3411, 0x0031f790, 0xfe9b7a85, 0xdf238db2, 0x00000000, 0x00000001, 0xfe6982f5, 0x1de16fc8 } },
+{ 0xfb20d778, 0x95367a07, { 0xcfe51448, 0x02083c8b, 0xfd291403, 0x925f8e0a, 0x00000000, 0x00000001, 0xfb20d778, 0x65ea5d71 } },
+{ 0xb4115ae1, 0x0a90a127, { 0x415c5947, 0xfcddc783, 0xfcddc783, 0x076e68aa, 0xfffffff9, 0x00000011, 0xfe05c2f2, 0x0076a74a } },
+{ 0x84b6b82a, 0x0ab1d0e6, { 0xaad595bc, 0xfad980ec, 0xfad980ec, 0x058b51d2, 0xfffffff5, 0x0000000c, 0xfa5ab20c, 0x0460ed62 } },
+{ 0x2aa64d96, 0xb7d51c2f, { 0xccd2a68a, 0xf3fa14f0, 0x1ea06286, 0x1ea06286, 0x00000000, 0x00000000, 0x2aa64d96, 0x2aa64d96 } },
+{ 0x13450dc1, 0x3ea16fe2, { 0x584dd362, 0x04b6e02e, 0x04b6e02e, 0x04b6e02e, 0x00000000, 0x00000000, 0x13450dc1, 0x13450dc1 } },
+{ 0xd2067147, 0xf1ad16da, { 0xcb339076, 0x0292899c, 0xd498fae3, 0xc64611bd, 0x00000003, 0x00000000, 0xfcff2cb9, 0xd2067147 } },
+{ 0x416c1544, 0x0e1e02c2, { 0xa20aa588, 0x039b9488, 0x039b9488, 0x039b9488, 0x00000004, 0x00000004, 0x08f40a3c, 0x08f40a3c } },
+{ 0xae79d0c8, 0xc4b31709, { 0x2fe24f08, 0x12e26ae8, 0xc15c3bb0, 0x860f52b9, 0x00000001, 0x00000000, 0xe9c6b9bf, 0xae79d0c8 } },
+{ 0x4dd85e2f, 0x8370f520, { 0x0ebec0e0, 0xda1fb336, 0x27f81165, 0x27f81165, 0x00000000, 0x00000000, 0x4dd85e2f, 0x4dd85e2f } },
+{ 0x36ecec65, 0x294efb63, { 0xbd2c720f, 0x08dce3fb, 0x08dce3fb, 0x08dce3fb, 0x00000001, 0x00000001, 0x0d9df102, 0x0d9df102 } },
+{ 0xaf110157, 0x72294756, { 0x7c04943a, 0xdbe885c4, 0xdbe885c4, 0x4e11cd1a, 0x00000000, 0x00000001, 0xaf110157, 0x3ce7ba01 } },
+{ 0x2bec002e, 0xba38e589, { 0x13853e9e, 0xf4073af5, 0x1ff33b23, 0x1ff33b23, 0x00000000, 0x00000000, 0x2bec002e, 0x2bec002e } },
+{ 0x1206f568, 0x3c02bbf2, { 0x6aa6f450, 0x0439d2ce, 0x0439d2ce, 0x0439d2ce, 0x00000000, 0x00000000, 0x1206f568, 0x1206f568 } },
+{ 0xfedec19a, 0x93bb813c, { 0xd541fa18, 0x007a53b6, 0xff591550, 0x9314968c, 0x00000000, 0x00000001, 0xfedec19a, 0x6b23405e } },
+{ 0x6624eb0a, 0x4f9cd3c9, { 0xf0cdc8da, 0x1fc3f787, 0x1fc3f787, 0x1fc3f787, 0x00000001, 0x00000001, 0x16881741, 0x16881741 } },
+{ 0x5c4f7e2b, 0xb02fb057, { 0xbfa6709d, 0xe3385ac0, 0x3f87d8eb, 0x3f87d8eb, 0xffffffff, 0x00000000, 0x0c7f2e82, 0x5c4f7e2b } },
+{ 0xca2130c9, 0xe427ba3a, { 0x5b96178a, 0x05dc0288, 0xcffd3351, 0xb424ed8b, 0x00000001, 0x00000000, 0xe5f9768f, 0xca2130c9 } },
+{ 0x360bdfe5, 0xfefa84c2, { 0xf013bf8a, 0xffc8cbdf, 0x35d4abc4, 0x35d4abc4, 0xffffffcc, 0x00000000, 0x00eed74d, 0x360bdfe5 } },
+{ 0xcb3bda6d, 0x3a6eada2, { 0x9b51e1fa, 0xf3f4bf6a, 0xf3f4bf6a, 0x2e636d0c, 0x00000000, 0x00000003, 0xcb3bda6d, 0x1befd187 } },
+{ 0x3b87ace9, 0x553249ea, { 0x3cd47dfa, 0x13cfbe19, 0x13cfbe19, 0x13cfbe19, 0x00000000, 0x00000000, 0x3b87ace9, 0x3b87ace9 } },
+{ 0xba04fac2, 0x58631b92, { 0x464f78a4, 0xe7d69e96, 0xe7d69e96, 0x4039ba28, 0x00000000, 0x00000002, 0xba04fac2, 0x093ec39e } },
+{ 0xc074baa1, 0x8307f3d3, { 0xeac3a5b3, 0x1f05078a, 0xdf79c22b, 0x6281b5fe, 0x00000000, 0x00000001, 0xc074baa1, 0x3d6cc6ce } },
+{ 0x1bc9a0bc, 0x4ed41e32, { 0x71e76cb8, 0x088e7539, 0x088e7539, 0x088e7539, 0x00000000, 0x00000000, 0x1bc9a0bc, 0x1bc9a0bc } },
+{ 0x620fb006, 0xc0fc1225, { 0x0c8cdcde, 0xe7dca263, 0x49ec5269, 0x49ec5269, 0xffffffff, 0x00000000, 0x230bc22b, 0x620fb006 } },
+{ 0xd8bddd57, 0x4e96c75a, { 0xfcc87196, 0xf3f2ba1d, 0xf3f2ba1d, 0x42898177, 0x00000000, 0x00000002, 0xd8bddd57, 0x3b904ea3 } },
+{ 0x7dc356f0, 0x165ed00a, { 0x2c646560, 0x0afd5d66, 0x0afd5d66, 0x0afd5d66, 0x00000005, 0x00000005, 0x0de946be, 0x0de946be } },
+{ 0x6ea7b51c, 0x1f094d35, { 0x1c2deacc, 0x0d6a5433, 0x0d6a5433, 0x0d6a5433, 0x00000003, 0x00000003, 0x118bcd7d, 0x118bcd7d } },
+{ 0x11022eb4, 0xa6006aed, { 0x5e5bc4a4, 0xfa0542af, 0x0b077163, 0x0b077163, 0x00000000, 0x00000000, 0x11022eb4, 0x11022eb4 } },
+{ 0x27b1977d, 0x5ef0d32f, { 0x94a6d6f3, 0x0eb88cdc, 0x0eb88cdc, 0x0eb88cdc, 0x00000000, 0x00000000, 0x27b1977d, 0x27b1977d } },
+{ 0xf24d8b2e, 0x3651863d, { 0x10e23df6, 0xfd17feb6, 0xfd17feb6, 0x336984f3, 0x00000000, 0x00000004, 0xf24d8b2e, 0x1907723a } },
+{ 0xfd3bbdf1, 0x415c162d, { 0x196f195d, 0xff4b2c75, 0xff4b2c75, 0x40a742a2, 0x00000000, 0x00000003, 0xfd3bbdf1, 0x39277b6a } },
+{ 0x852315d9, 0x91f9773f, { 0x3bdb3f67, 0x34ce0f6c, 0xb9f12545, 0x4bea9c84, 0x00000001, 0x00000000, 0xf3299e9a, 0x852315d9 } },
+{ 0xa9cc3f94, 0x74c8869f, { 0x1ac2f4ec, 0xd8ad070c, 0xd8ad070c, 0x4d758dab, 0x00000000, 0x00000001, 0xa9cc3f94, 0x3503b8f5 } },
+{ 0x21f62995, 0x9b70c2c6, { 0x3817133e, 0xf2a8d721, 0x149f00b6, 0x149f00b6, 0x00000000, 0x00000000, 0x21f62995, 0x21f62995 } },
+{ 0xf1eb7acd, 0x321e1f31, { 0x3ff7543d, 0xfd3e55dd, 0xfd3e55dd, 0x2f5c750e, 0x00000000, 0x00000004, 0xf1eb7acd, 0x2972fe09 } },
+{ 0xa0e32b48, 0x08d4cb69, { 0x381ed888, 0xfcb809e7, 0xfcb809e7, 0x058cd550, 0xfffffff6, 0x00000012, 0xf9331d62, 0x01ecdde6 } },
+{ 0xba8e077b, 0x9f1075af, { 0x4d325415, 0x1a4bb81e, 0xd4d9bf99, 0x73ea3548, 0x00000000, 0x00000001, 0xba8e077b, 0x1b7d91cc } },
+{ 0xdba14236, 0x6b32b9b1, { 0xe3e3cd56, 0xf0c531c9, 0xf0c531c9, 0x5bf7eb7a, 0x00000000, 0x00000002, 0xdba14236, 0x053bced4 } },
+{ 0x3d51cf05, 0x704d1eff, { 0x1f40cbfb, 0x1ae6439a, 0x1ae6439a, 0x1ae6439a, 0x00000000, 0x00000000, 0x3d51cf05, 0x3d51cf05 } },
+{ 0xb29ed0a7, 0xf1731883, { 0x3cd96d75, 0x0465e7b5, 0xb704b85c, 0xa877d0df, 0x00000005, 0x00000000, 0xfb5f5618, 0xb29ed0a7 } },
+{ 0x787f657c, 0x1b033a41, { 0xb9cadc7c, 0x0cb6f49d, 0x0cb6f49d, 0x0cb6f49d, 0x00000004, 0x00000004, 0x0c727c78, 0x0c727c78 } },
+{ 0x4da20189, 0xadcf5f30, { 0x7fb920b0, 0xe7135c5d, 0x34b55de6, 0x34b55de6, 0x00000000, 0x00000000, 0x4da20189, 0x4da20189 } },
+{ 0x2c685e78, 0x7d046d31, { 0x02132cf8, 0x15afbab3, 0x15afbab3, 0x15afbab3, 0x00000000, 0x00000000, 0x2c685e78, 0x2c685e78 } },
+{ 0xb7532bc7, 0x0b1e55cd, { 0x1975215b, 0xfcd7f645, 0xfcd7f645, 0x07f64c12, 0xfffffffa, 0x00000010, 0xfa092e95, 0x056dcef7 } },
+{ 0x30312439, 0x3c53c7eb, { 0x8abf8f53, 0x0b5b4a0e, 0x0b5b4a0e, 0x0b5b4a0e, 0x00000000, 0x00000000, 0x30312439, 0x30312439 } },
+{ 0x2a9a1304, 0xdf6731d7, { 0x67a5bc5c, 0xfa934fd5, 0x252d62d9, 0x252d62d9, 0xffffffff, 0x00000000, 0x0a0144db, 0x2a9a1304 } },
+{ 0x616a6f23, 0x707370de, { 0x47a4b05a, 0x2aca7e62, 0x2aca7e62, 0x2aca7e62, 0x00000000, 0x00000000, 0x616a6f23, 0x616a6f23 } },
+{ 0x6dba6f55, 0xe5ca6cfc, { 0x8c8f73ac, 0xf4c41a14, 0x627e8969, 0x627e8969, 0xfffffffc, 0x00000000, 0x04e42345, 0x6dba6f55 } },
+{ 0x7143538e, 0xcb26c000, { 0x7fbe8000, 0xe89e34a4, 0x59e18832, 0x59e18832, 0xfffffffe, 0x00000000, 0x0790d38e, 0x7143538e } },
+{ 0x393ebe3f, 0x266f1c8b, { 0xc9313035, 0x089828d3, 0x089828d3, 0x089828d3, 0x00000001, 0x00000001, 0x12cfa1b4, 0x12cfa1b4 } },
+{ 0xf9d73b74, 0xe33fffd4, { 0xc801c810, 0x00b11413, 0xfa884f87, 0xddc84f5b, 0x00000000, 0x00000001, 0xf9d73b74, 0x16973ba0 } },
+{ 0x19159c67, 0xbfd13c03, { 0xe4fff935, 0xf9b603cf, 0x12cba036, 0x12cba036, 0x00000000, 0x00000000, 0x19159c67, 0x19159c67 } },
+{ 0xcbfa6717, 0x74c14593, { 0xc2e96535, 0xe846305a, 0xe846305a, 0x5d0775ed, 0x00000000, 0x00000001, 0xcbfa6717, 0x57392184 } },
+{ 0xc1222c67, 0xc0edffc5, { 0x04e1c443, 0x0f7d02ba, 0xd09f2f21, 0x918d2ee6, 0x00000000, 0x00000001, 0xc1222c67, 0x00342ca2 } },
+{ 0x75338de9, 0x4116d189, { 0x2a782ab1, 0x1dcc8964, 0x1dcc8964, 0x1dcc8964, 0x00000001, 0x00000001, 0x341cbc60, 0x341cbc60 } },
+{ 0x4d2bc300, 0x4f5083f0, { 0xadcfd000, 0x17e8c69f, 0x17e8c69f, 0x17e8c69f, 0x00000000, 0x00000000, 0x4d2bc300, 0x4d2bc300 } },
+{ 0xd7a1f54c, 0x8d331848, { 0x8eb01d60, 0x121a303e, 0xe9bc258a, 0x76ef3dd2, 0x00000000, 0x00000001, 0xd7a1f54c, 0x4a6edd04 } },
+{ 0xbf65666b, 0x5b6feb08, { 0x81946c58, 0xe8eccd0f, 0xe8eccd0f, 0x445cb817, 0x00000000, 0x00000002, 0xbf65666b, 0x0885905b } },
+{ 0x3f623b3e, 0x5c16b0a1, { 0xc4d5e1fe, 0x16cceb76, 0x16cceb76, 0x16cceb76, 0x00000000, 0x00000000, 0x3f623b3e, 0x3f623b3e } },
+{ 0xe0b62a55, 0xab3fc28d, { 0x0254bad1, 0x0a5bb8ff, 0xeb11e354, 0x9651a5e1, 0x00000000, 0x00000001, 0xe0b62a55, 0x357667c8 } },
+{ 0xa35d2be2, 0x43ba8a23, { 0x9798d3e6, 0xe77de231, 0xe77de231, 0x2b386c54, 0xffffffff, 0x00000002, 0xe717b605, 0x1be8179c } },
+{ 0x2c2add48, 0x38900c25, { 0x9d115b68, 0x09c23a9c, 0x09c23a9c, 0x09c23a9c, 0x00000000, 0x00000000, 0x2c2add48, 0x2c2add48 } },
+{ 0xf4e01808, 0x11213a54, { 0xc001b2a0, 0xff416ff2, 0xff416ff2, 0x1062aa46, 0x00000000, 0x0000000e, 0xf4e01808, 0x050ee770 } },
+{ 0x5d56dd64, 0x00855c16, { 0x41faf698, 0x00309fb4, 0x00309fb4, 0x00309fb4, 0x000000b3, 0x000000b3, 0x00177a02, 0x00177a02 } },
+{ 0x259bf8e1, 0x522fc2a9, { 0xc9e0ce89, 0x0c12f9f3, 0x0c12f9f3, 0x0c12f9f3, 0x00000000, 0x00000000, 0x259bf8e1, 0x259bf8e1 } },
+{ 0xf5142acb, 0xe31ad389, { 0x20ae37a3, 0x013b922d, 0xf64fbcf8, 0xd96a9081, 0x00000000, 0x00000001, 0xf5142acb, 0x11f95742 } },
+{ 0xc0eeb0a1, 0x3b9596b2, { 0xea2a25f2, 0xf1522881, 0xf1522881, 0x2ce7bf33, 0xffffffff, 0x00000003, 0xfc844753, 0x0e2dec8b } },
+{ 0x76d7050c, 0x998fd6ef, { 0xaea9be34, 0xd07242da, 0x474947e6, 0x474947e6, 0xffffffff, 0x00000000, 0x1066dbfb, 0x76d7050c } },
+{ 0x8d05898b, 0x3c2ab3d1, { 0x257f7b7b, 0xe4fa1e62, 0xe4fa1e62, 0x2124d233, 0xffffffff, 0x00000002, 0xc9303d5c, 0x14b021e9 } },
+{ 0x8196aa32, 0x762dcbd7, { 0x454895fe, 0xc5a4d547, 0xc5a4d547, 0x3bd2a11e, 0xffffffff, 0x00000001, 0xf7c47609, 0x0b68de5b } },
+{ 0x817801b5, 0xf72a7e35, { 0xc9617079, 0x045dc73f, 0x85d5c8f4, 0x7d004729, 0x0000000e, 0x00000000, 0xfd251acf, 0x817801b5 } },
+{ 0x15c7b708, 0xa1a34f42, { 0xd110a810, 0xf7f8c7fb, 0x0dc07f03, 0x0dc07f03, 0x00000000, 0x00000000, 0x15c7b708, 0x15c7b708 } },
+{ 0xa3f3a438, 0x47058ce2, { 0xb7fd9970, 0xe67693a5, 0xe67693a5, 0x2d7c2087, 0xffffffff, 0x00000002, 0xeaf9311a, 0x15e88a74 } },
+{ 0x5b3d2a56, 0xd7568dc9, { 0xc63b9b86, 0xf1820d4c, 0x4cbf37a2, 0x4cbf37a2, 0xfffffffe, 0x00000000, 0x09ea45e8, 0x5b3d2a56 } },
+{ 0x2acf0b35, 0x01834362, { 0x8450294a, 0x0040c242, 0x0040c242, 0x0040c242, 0x0000001c, 0x0000001c, 0x0073ac7d, 0x0073ac7d } },
+{ 0x5c381d1c, 0x57e527c9, { 0x828a1efc, 0x1fa99e6b, 0x1fa99e6b, 0x1fa99e6b, 0x00000001, 0x00000001, 0x0452f553, 0x0452f553 } },
+{ 0x66791895, 0x43e3b0b5, { 0x7fa3d159, 0x1b2cd58b, 0x1b2cd58b, 0x1b2cd58b, 0x00000001, 0x00000001, 0x229567e0, 0x229567e0 } },
+{ 0x0dbe7e50, 0x8b7c761e, { 0x094bad60, 0xf9be9ee2, 0x077d1d32, 0x077d1d32, 0x00000000, 0x00000000, 0x0dbe7e50, 0x0dbe7e50 } },
+{ 0x485265c5, 0x5374c95d, { 0xf41aa591, 0x1793b537, 0x1793b537, 0x1793b537, 0x00000000, 0x00000000, 0x485265c5, 0x485265c5 } },
+{ 0x4ee0391c, 0x7f3f08cd, { 0x1d3a9b6c, 0x2734a839, 0x2734a839, 0x2734a839, 0x00000000, 0x00000000, 0x4ee0391c, 0x4ee0391c } },
+{ 0x259bf3da, 0xe5183aee, { 0x2aac18ac, 0xfc0c1c8f, 0x21a81069, 0x21a81069, 0xffffffff, 0x00000000, 0x0ab42ec8, 0x259bf3da } },
+{ 0x6c3e1a05, 0xa8c936e0, { 0x85c0d260, 0xdb1fbb04, 0x475dd509, 0x475dd509, 0xffffffff, 0x00000000, 0x150750e5, 0x6c3e1a05 } },
+{ 0x0d1f45b2, 0x10b174fc, { 0x666f4338, 0x00db0cf9, 0x00db0cf9, 0x00db0cf9, 0x00000000, 0x00000000, 0x0d1f45b2, 0x0d1f45b2 } },
+{ 0x7dc37f05, 0xbfc8374d, { 0xcaff4781, 0xe073b8a5, 0x5e3737aa, 0x5e3737aa, 0xffffffff, 0x00000000, 0x3d8bb652, 0x7dc37f05 } },
+{ 0x57444b32, 0xc6f47af0, { 0xb38452e0, 0xec8dddf6, 0x43d22928, 0x43d22928, 0xffffffff, 0x00000000, 0x1e38c622, 0x57444b32 } },
+{ 0x4ab2a726, 0x129ff714, { 0xb1d4b8f8, 0x056f3cce, 0x056f3cce, 0x056f3cce, 0x00000004, 0x00000004, 0x0032cad6, 0x0032cad6 } },
+{ 0xa7344526, 0x15fbc5a7, { 0x369159ca, 0xf85ff55d, 0xf85ff55d, 0x0e5bbb04, 0xfffffffc, 0x00000007, 0xff235bc2, 0x0d51dd95 } },
+{ 0xa3070ae5, 0x85215da1, { 0x76e80b05, 0x2c9f7fab, 0xcfa68a90, 0x54c7e831, 0x00000000, 0x00000001, 0xa3070ae5, 0x1de5ad44 } },
+{ 0x1e66900c, 0x580dfe21, { 0x1ec0798c, 0x0a74eae7, 0x0a74eae7, 0x0a74eae7, 0x00000000, 0x00000000, 0x1e66900c, 0x1e66900c } },
+{ 0x1e2bde0a, 0x19530f94, { 0xfa9cf3c8, 0x02fc12bd, 0x02fc12bd, 0x02fc12bd, 0x00000001, 0x00000001, 0x04d8ce76, 0x04d8ce76 } },
+{ 0xa7db304e, 0x2128232e, { 0xbb2d5804, 0xf4956f5c, 0xf4956f5c, 0x15bd928a, 0xfffffffe, 0x00000005, 0xea2b76aa, 0x02128068 } },
+{ 0x5dec82b4, 0x8052aca3, { 0x9310289c, 0xd12813be, 0x2f149672, 0x2f149672, 0x00000000, 0x00000000, 0x5dec82b4, 0x5dec82b4 } },
+{ 0x294d32f3, 0xa42c1fd2, { 0xa8433856, 0xf12f6017, 0x1a7c930a, 0x1a7c930a, 0x00000000, 0x00000000, 0x294d32f3, 0x294d32f3 } },
+{ 0x469f6f41, 0xa66e7871, { 0xdc7493b1, 0xe74a6c9e, 0x2de9dbdf, 0x2de9dbdf, 0x00000000, 0x00000000, 0x469f6f41, 0x469f6f41 } },
+{ 0x45bed087, 0x82b399a4, { 0x1543457c, 0xdddd03a5, 0x239bd42c, 0x239bd42c, 0x00000000, 0x00000000, 0x45bed087, 0x45bed087 } },
+{ 0x3d91b716, 0x67a68f46, { 0xcd615a04, 0x18edaf9b, 0x18edaf9b, 0x18edaf9b, 0x00000000, 0x00000000, 0x3d91b716, 0x3d91b716 } },
+{ 0x08984e48, 0xd6feaa82, { 0x5cc39090, 0xfe9f8fff, 0x0737de47, 0x0737de47, 0x00000000, 0x00000000, 0x08984e48, 0x08984e48 } },
+{ 0x57f26261, 0x61dc49ca, { 0xcfab498a, 0x219e84ec, 0x219e84ec, 0x219e84ec, 0x00000000, 0x00000000, 0x57f26261, 0x57f26261 } },
+{ 0xdf1bf7e3, 0x0d5021c3, { 0x8b3214e9, 0xfe4a1ffd, 0xfe4a1ffd, 0x0b9a41c0, 0xfffffffe, 0x00000010, 0xf9bc3b69, 0x0a19dbb3 } },
+{ 0x001f9f10, 0xdc50c757, { 0x14647e70, 0xfffb979c, 0x001b36ac, 0x001b36ac, 0x00000000, 0x00000000, 0x001f9f10, 0x001f9f10 } },
+{ 0x066b09f4, 0xfe5af88c, { 0xcbf5d170, 0xfff571c8, 0x06607bbc, 0x06607bbc, 0xfffffffd, 0x00000000, 0x017bf398, 0x066b09f4 } },
+{ 0x27015b44, 0x0e6c60c2, { 0x49f0a988, 0x0232964e, 0x0232964e, 0x0232964e, 0x00000002, 0x00000002, 0x0a2899c0, 0x0a2899c0 } },
+{ 0x8ba24fd9, 0x89328c33, { 0x4e62943b, 0x360092db, 0xc1a2e2b4, 0x4ad56ee7, 0x00000000, 0x00000001, 0x8ba24fd9, 0x026fc3a6 } },
+{ 0x53da3943, 0x702173f4, { 0xa55aacdc, 0x24ba6e29, 0x24ba6e29, 0x24ba6e29, 0x00000000, 0x00000000, 0x53da3943, 0x53da3943 } },
+{ 0xb6f0c36b, 0x93fbfd17, { 0x6bab4d9d, 0x1ed392a0, 0xd5c4560b, 0x69c05322, 0x00000000, 0x00000001, 0xb6f0c36b, 0x22f4c654 } },
+{ 0xbb46e141, 0xf606a166, { 0xef6da0e6, 0x02ad7388, 0xbdf454c9, 0xb3faf62f, 0x00000006, 0x00000000, 0xf71f18dd, 0xbb46e141 } },
+{ 0xa787a869, 0xb7f9ba7a, { 0x44238c0a, 0x18e4037b, 0xc06babe4, 0x7865665e, 0x00000001, 0x00000000, 0xef8dedef, 0xa787a869 } },
+{ 0x7b495ddc, 0x059c3d1c, { 0x7573b010, 0x02b3acf8, 0x02b3acf8, 0x02b3acf8, 0x00000015, 0x00000015, 0x05785a90, 0x05785a90 } },
+{ 0xdc16fc48, 0x475d51ea, { 0x10fd61d0, 0xf5fd48d4, 0xf5fd48d4, 0x3d5a9abe, 0x00000000, 0x00000003, 0xdc16fc48, 0x05ff068a } },
+{ 0xfd011690, 0x0000000c, { 0xdc0d0ec0, 0xffffffff, 0xffffffff, 0x0000000b, 0xffc01737, 0x15156c8c, 0xfffffffc, 0x00000000 } },
+{ 0x643821f7, 0x00000def, { 0x6a214099, 0x00000574, 0x00000574, 0x00000574, 0x00073150, 0x00073150, 0x00000847, 0x00000847 } },
+{ 0x9afad0ed, 0x000019c9, { 0x2d552f15, 0xfffff5d3, 0xfffff5d3, 0x00000f9c, 0xfffc150e, 0x000602ab, 0xffffeaef, 0x000005aa } },
+{ 0x7578ae78, 0x00000011, { 0xcd0395f8, 0x00000007, 0x00000007, 0x00000007, 0x06e8fb34, 0x06e8fb34, 0x00000004, 0x00000004 } },
+{ 0xd40c6486, 0x00000002, { 0xa818c90c, 0xffffffff, 0xffffffff, 0x00000001, 0xea063243, 0x6a063243, 0x00000000, 0x00000000 } },
+{ 0x1ad0c1a4, 0x000036dd, { 0x2f0fc294, 0x000005bf, 0x000005bf, 0x000005bf, 0x00007d1f, 0x00007d1f, 0x000033e1, 0x000033e1 } },
+{ 0xc76ef793, 0x0000007c, { 0x99bfeb34, 0xffffffe4, 0xffffffe4, 0x00000060, 0xff8b37ad, 0x019bbbcd, 0xffffffc7, 0x00000047 } },
+{ 0x822cd838, 0x000000b0, { 0x7ed4a680, 0xffffffa9, 0xffffffa9, 0x00000059, 0xff48fb6a, 0x00bd5880, 0xffffff58, 0x00000038 } },
+{ 0xd2c00bcd, 0x00000003, { 0x78402367, 0xffffffff, 0xffffffff, 0x00000002, 0xf0eaae9a, 0x464003ef, 0xffffffff, 0x00000000 } },
+{ 0x3220e049, 0x00000001, { 0x3220e049, 0x00000000, 0x00000000, 0x00000000, 0x3220e049, 0x3220e049, 0x00000000, 0x00000000 } },
+{ 0x89802a94, 0x00000350, { 0x788d0a40, 0xfffffe77, 0xfffffe77, 0x000001c7, 0xffdc3a04, 0x00298277, 0xfffffd54, 0x00000064 } },
+{ 0x573ba037, 0x00000001, { 0x573ba037, 0x00000000, 0x00000000, 0x00000000, 0x573ba037, 0x573ba037, 0x00000000, 0x00000000 } },
+{ 0x1d53f24f, 0x00001301, { 0x584fcf4f, 0x0000022d, 0x0000022d, 0x0000022d, 0x00018b12, 0x00018b12, 0x0000113d, 0x0000113d } },
+{ 0x4e376b04, 0x00000001, { 0x4e376b04, 0x00000000, 0x00000000, 0x00000000, 0x4e376b04, 0x4e376b04, 0x00000000, 0x00000000 } },
+{ 0x3693a885, 0x00000063, { 0x1b1a2b6f, 0x00000015, 0x00000015, 0x00000015, 0x008d20bb, 0x008d20bb, 0x00000034, 0x00000034 } },
+{ 0xf9411a34, 0x00000000, { 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0xffffffff, 0xffffffff, 0xf9411a34, 0xf9411a34 } },
+{ 0x6ca64fc5, 0x00007150, { 0x5d2ee290, 0x00003017, 0x00003017, 0x00003017, 0x0000f577, 0x0000f577, 0x00001395, 0x00001395 } },
+{ 0xbf33c4a4, 0x00000001, { 0xbf33c4a4, 0xffffffff, 0xffffffff, 0x00000000, 0xbf33c4a4, 0xbf33c4a4, 0x00000000, 0x00000000 } },
+{ 0x54a78df4, 0x0000159d, { 0xa96712a4, 0x00000725, 0x00000725, 0x00000725, 0x0003eab2, 0x0003eab2, 0x000004ca, 0x000004ca } },
+{ 0x72cac820, 0x0000003d, { 0x5a51afa0, 0x0000001b, 0x0000001b, 0x0000001b, 0x01e1c022, 0x01e1c022, 0x00000006, 0x00000006 } },
+{ 0xbd66ca88, 0x00003557, { 0xa5dcfc38, 0xfffff21f, 0xfffff21f, 0x00002776, 0xfffec05e, 0x00038d04, 0xfffff496, 0x00000a2c } },
+{ 0xd7a3bb4e, 0x00000ca4, { 0xd1aba5f8, 0xfffffe01, 0xfffffe01, 0x00000aa5, 0xfffcce9e, 0x00110f2a, 0xfffff616, 0x00000c66 } },
+{ 0x16267f1e, 0x00000011, { 0x788e70fe, 0x00000001, 0x00000001, 0x00000001, 0x014d8f01, 0x014d8f01, 0x0000000d, 0x0000000d } },
+{ 0x9dc1d9ee, 0x00000146, { 0xe4db8514, 0xffffff82, 0xffffff82, 0x000000c8, 0xffb2da31, 0x007be20a, 0xffffff88, 0x00000132 } },
+{ 0xc5d9e45d, 0x00000001, { 0xc5d9e45d, 0xffffffff, 0xffffffff, 0x00000000, 0xc5d9e45d, 0xc5d9e45d, 0x00000000, 0x00000000 } },
+{ 0x5531ecfa, 0x00000001, { 0x5531ecfa, 0x00000000, 0x00000000, 0x00000000, 0x5531ecfa, 0x5531ecfa, 0x00000000, 0x00000000 } },
+{ 0x7cb081f8, 0x00000001, { 0x7cb081f8, 0x00000000, 0x00000000, 0x00000000, 0x7cb081f8, 0x7cb081f8, 0x00000000, 0x00000000 } },
+{ 0xa68c9577, 0x00000000, { 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0xffffffff, 0xffffffff, 0xa68c9577, 0xa68c9577 } },
+{ 0xcf391de2, 0x0000590f, { 0xffbc523e, 0xffffef07, 0xffffef07, 0x00004816, 0xffff73cb, 0x000253aa, 0xffffc1fd, 0x00001cec } },
+{ 0x67d602c0, 0x00000046, { 0x6484c080, 0x0000001c, 0x0000001c, 0x0000001c, 0x017bbe35, 0x017bbe35, 0x00000042, 0x00000042 } },
+{ 0x883b3409, 0x0000034e, { 0x33a5f5be, 0xfffffe74, 0xfffffe74, 0x000001c2, 0xffdbc208, 0x00293940, 0xfffffd99, 0x00000289 } },
+{ 0x5bb93a9a, 0x000022c0, { 0x64b46780, 0x00000c73, 0x00000c73, 0x00000c73, 0x0002a3b8, 0x0002a3b8, 0x0000009a, 0x0000009a } },
+{ 0xfa57fd57, 0x00000001, { 0xfa57fd57, 0xffffffff, 0xffffffff, 0x00000000, 0xfa57fd57, 0xfa57fd57, 0x00000000, 0x00000000 } },
+{ 0x30f404de, 0x00001f0b, { 0xa713178a, 0x000005ef, 0x000005ef, 0x000005ef, 0x000193b2, 0x000193b2, 0x00001e38, 0x00001e38 } },
+{ 0xe79b94cf, 0x00000008, { 0x3cdca678, 0xffffffff, 0xffffffff, 0x00000007, 0xfcf3729a, 0x1cf37299, 0xffffffff, 0x00000007 } },
+{ 0x2d7e02a9, 0x0000008f, { 0x69637c67, 0x00000019, 0x00000019, 0x00000019, 0x005170cd, 0x005170cd, 0x00000026, 0x00000026 } },
+{ 0x02b58500, 0x000007f6, { 0x9110ce00, 0x00000015, 0x00000015, 0x00000015, 0x0000571d, 0x0000571d, 0x00000422, 0x00000422 } },
+{ 0xf2bb26f5, 0x0000002f, { 0x905c26fb, 0xfffffffd, 0xfffffffd, 0x0000002c, 0xffb7ba06, 0x052a1c10, 0xffffffdb, 0x00000005 } },
+{ 0x0519b3ab, 0x0000003e, { 0x3c39836a, 0x00000001, 0x00000001, 0x00000001, 0x00150f48, 0x00150f48, 0x0000003b, 0x0000003b } },
+{ 0xcb035bb9, 0x0000005f, { 0x563f09a7, 0xffffffec, 0xffffffec, 0x0000004b, 0xff7136dd, 0x02231122, 0xffffffb6, 0x0000001b } },
+{ 0x5efbec2f, 0x00000000, { 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0xffffffff, 0xffffffff, 0x5efbec2f, 0x5efbec2f } },
+{ 0xafbe7dfe, 0x00000001, { 0xafbe7dfe, 0xffffffff, 0xffffffff, 0x00000000, 0xafbe7dfe, 0xafbe7dfe, 0x00000000, 0x00000000 } },
+{ 0x3df3e492, 0x0000013c, { 0x790e2438, 0x0000004c, 0x0000004c, 0x0000004c, 0x00323085, 0x00323085, 0x00000066, 0x00000066 } },
+{ 0x47339fb7, 0x00000149, { 0x8158422f, 0x0000005b, 0x0000005b, 0x0000005b, 0x00376732, 0x00376732, 0x00000075, 0x00000075 } },
+{ 0x941d474c, 0x00000c2c, { 0xd45fd110, 0xfffffade, 0xfffffade, 0x0000070a, 0xfff722f1, 0x000c2b27, 0xfffff9e0, 0x00000898 } },
+{ 0xd9970187, 0x00000002, { 0xb32e030e, 0xffffffff, 0xffffffff, 0x00000001, 0xeccb80c4, 0x6ccb80c3, 0xffffffff, 0x00000001 } },
+{ 0x9cc39dc6, 0x00000001, { 0x9cc39dc6, 0xffffffff, 0xffffffff, 0x00000000, 0x9cc39dc6, 0x9cc39dc6, 0x00000000, 0x00000000 } },
+{ 0xf958dc39, 0x00000067, { 0x52c09aef, 0xfffffffd, 0xfffffffd, 0x00000064, 0xffef76f5, 0x026bbc8b, 0xffffffa6, 0x0000004c } },
+{ 0xa31ae799, 0x0000007d, { 0xa42315b5, 0xffffffd2, 0xffffffd2, 0x0000004f, 0xff41c052, 0x014e0a0b, 0xffffff8f, 0x0000003a } },
+{ 0x7a96c732, 0x00000037, { 0x5664cbbe, 0x0000001a, 0x0000001a, 0x0000001a, 0x023a9891, 0x023a9891, 0x0000000b, 0x0000000b } },
+{ 0x267a39a8, 0x00000005, { 0xc0632048, 0x00000000, 0x00000000, 0x00000000, 0x07b20b88, 0x07b20b88, 0x00000000, 0x00000000 } },
+{ 0xeb06d2d2, 0x00000079, { 0x1639a542, 0xfffffff6, 0xfffffff6, 0x0000006f, 0xffd3a06c, 0x01f13f19, 0xffffffc6, 0x00000001 } },
+{ 0x108fbb23, 0x0000003d, { 0xf23f9757, 0x00000003, 0x00000003, 0x00000003, 0x004580f8, 0x004580f8, 0x0000000b, 0x0000000b } },
+{ 0x1c6b71c3, 0x00000013, { 0x1bf97179, 0x00000002, 0x00000002, 0x00000002, 0x017eeb0a, 0x017eeb0a, 0x00000005, 0x00000005 } },
+{ 0xb978996d, 0x0000016a, { 0x4488f422, 0xffffff9c, 0xffffff9c, 0x00000106, 0xffce1f8b, 0x00832970, 0xfffffedf, 0x0000010d } },
+{ 0xaf966f3b, 0x0000000c, { 0x3b0d36c4, 0xfffffffc, 0xfffffffc, 0x00000008, 0xf94c8945, 0x0ea1de9a, 0xffffffff, 0x00000003 } },
+{ 0x6efdc13f, 0x00000002, { 0xddfb827e, 0x00000000, 0x00000000, 0x00000000, 0x377ee09f, 0x377ee09f, 0x00000001, 0x00000001 } },
+{ 0x196bdf78, 0x000001d4, { 0x79348760, 0x0000002e, 0x0000002e, 0x0000002e, 0x000de7dc, 0x000de7dc, 0x00000148, 0x00000148 } },
+{ 0x05deeb38, 0x000003e6, { 0xe308fc50, 0x00000016, 0x00000016, 0x00000016, 0x00018184, 0x00018184, 0x000002a0, 0x000002a0 } },
+{ 0x53d9fe40, 0x000001d2, { 0xa2d0d080, 0x00000098, 0x00000098, 0x00000098, 0x002e107a, 0x002e107a, 0x0000002c, 0x0000002c } },
+{ 0xdf8a16d7, 0x00000084, { 0x4333c6dc, 0xffffffef, 0xffffffef, 0x00000073, 0xffc10bd0, 0x01b187ee, 0xffffff97, 0x0000001f } },
+{ 0xb7b90504, 0x0000302b, { 0x8d0497ac, 0xfffff266, 0xfffff266, 0x00002291, 0xfffe7fde, 0x0003d070, 0xffffeaba, 0x00000234 } },
+{ 0x3cbac544, 0x00000040, { 0x2eb15100, 0x0000000f, 0x0000000f, 0x0000000f, 0x00f2eb15, 0x00f2eb15, 0x00000004, 0x00000004 } },
+{ 0x9a37e924, 0x0000008b, { 0xbc5b968c, 0xffffffc8, 0xffffffc8, 0x00000053, 0xff448bcf, 0x011c0733, 0xffffffbf, 0x00000073 } },
+{ 0x551f3a48, 0x0000000c, { 0xfd76bb60, 0x00000003, 0x00000003, 0x00000003, 0x0717ef86, 0x0717ef86, 0x00000000, 0x00000000 } },
+{ 0x5e47213a, 0x00000ed7, { 0x118e13b6, 0x00000577, 0x00000577, 0x00000577, 0x00065a5f, 0x00065a5f, 0x00000971, 0x00000971 } },
+{ 0x09218f83, 0x000024a6, { 0xa3f17af2, 0x0000014e, 0x0000014e, 0x0000014e, 0x00003fc8, 0x00003fc8, 0x000013d3, 0x000013d3 } },
+{ 0xcaa13d37, 0x00000a19, { 0x1623205f, 0xfffffde5, 0xfffffde5, 0x000007fe, 0xfffab6f0, 0x00141128, 0xffffffc7, 0x0000004f } },
+{ 0x9304ab6a, 0x00000001, { 0x9304ab6a, 0xffffffff, 0xffffffff, 0x00000000, 0x9304ab6a, 0x9304ab6a, 0x00000000, 0x00000000 } },
+{ 0x43139b1f, 0x00000845, { 0xb121c75b, 0x0000022a, 0x0000022a, 0x0000022a, 0x00081c7d, 0x00081c7d, 0x0000056e, 0x0000056e } },
+{ 0x949bee85, 0x00000499, { 0x40eba17d, 0xfffffe12, 0xfffffe12, 0x000002ab, 0xffe8a46b, 0x002052a2, 0xfffffe92, 0x000003b3 } },
+{ 0xb756b145, 0x0000016d, { 0x669abf61, 0xffffff98, 0xffffff98, 0x00000105, 0xffcd099b, 0x00809694, 0xffffff46, 0x00000041 } },
+{ 0xe9915530, 0x0000000c, { 0xf2cffe40, 0xfffffffe, 0xfffffffe, 0x0000000a, 0xfe2171c4, 0x1376c719, 0x00000000, 0x00000004 } },
+{ 0x9ae18466, 0x00000019, { 0x2005edf6, 0xfffffff6, 0xfffffff6, 0x0000000f, 0xfbf48a6b, 0x0631fb0e, 0xfffffff3, 0x00000008 } },
+{ 0xf998be26, 0x00000002, { 0xf3317c4c, 0xffffffff, 0xffffffff, 0x00000001, 0xfccc5f13, 0x7ccc5f13, 0x00000000, 0x00000000 } },
+{ 0x833dae9b, 0x000002dd, { 0xc79cf1cf, 0xfffffe9a, 0xfffffe9a, 0x00000177, 0xffd46d8e, 0x002dd5fa, 0xffffff05, 0x000001c9 } },
+{ 0x12647e63, 0x00001d9a, { 0x72c53e8e, 0x00000220, 0x00000220, 0x00000220, 0x00009f0f, 0x00009f0f, 0x00001c5d, 0x00001c5d } },
+{ 0x6f9848e5, 0x00003ac9, { 0x1f151dcd, 0x000019a0, 0x000019a0, 0x000019a0, 0x0001e5fa, 0x0001e5fa, 0x0000139b, 0x0000139b } },
+{ 0x76a4ccc9, 0x00000001, { 0x76a4ccc9, 0x00000000, 0x00000000, 0x00000000, 0x76a4ccc9, 0x76a4ccc9, 0x00000000, 0x00000000 } },
+{ 0xd0c0c038, 0x000009b3, { 0xbd885f28, 0xfffffe35, 0xfffffe35, 0x000007e8, 0xfffb20f8, 0x001585cc, 0xfffffad0, 0x00000694 } },
+{ 0x4cf74c11, 0x00000001, { 0x4cf74c11, 0x00000000, 0x00000000, 0x00000000, 0x4cf74c11, 0x4cf74c11, 0x00000000, 0x00000000 } },
+{ 0xfd1760b9, 0x0000000d, { 0xda2fe965, 0xffffffff, 0xffffffff, 0x0000000c, 0xffc6b8ac, 0x1377f3bf, 0xfffffffd, 0x00000006 } },
+{ 0xef283e70, 0x00000003, { 0xcd78bb50, 0xffffffff, 0xffffffff, 0x00000002, 0xfa62bf7b, 0x4fb814d0, 0xffffffff, 0x00000000 } },
+{ 0x4229be9c, 0x00000567, { 0x6f84bcc4, 0x00000165, 0x00000165, 0x00000165, 0x000c3f42, 0x000c3f42, 0x0000010e, 0x0000010e } },
+{ 0x2fe68c28, 0x00000064, { 0xb60ebfa0, 0x00000012, 0x00000012, 0x00000012, 0x007aa01f, 0x007aa01f, 0x0000000c, 0x0000000c } },
+{ 0x92dafa86, 0x00003e7a, { 0x0507d7dc, 0xffffe55d, 0xffffe55d, 0x000023d7, 0xfffe40c7, 0x000259be, 0xffffe9b0, 0x000031fa } },
+{ 0xfa917ef8, 0x00000001, { 0xfa917ef8, 0xffffffff, 0xffffffff, 0x00000000, 0xfa917ef8, 0xfa917ef8, 0x00000000, 0x00000000 } },
+{ 0xc75951e5, 0x00000001, { 0xc75951e5, 0xffffffff, 0xffffffff, 0x00000000, 0xc75951e5, 0xc75951e5, 0x00000000, 0x00000000 } },
+{ 0xd42009ad, 0x00001c9b, { 0xf074c7bf, 0xfffffb18, 0xfffffb18, 0x000017b3, 0xfffe775a, 0x00076a61, 0xffffee2f, 0x000004f2 } },
+{ 0x979e64af, 0x00000003, { 0xc6db2e0d, 0xfffffffe, 0xfffffffe, 0x00000001, 0xdd34cc3b, 0x328a218f, 0xfffffffe, 0x00000002 } },
+{ 0xcc0fa7ed, 0x00000011, { 0x8d0a26bd, 0xfffffffc, 0xfffffffc, 0x0000000d, 0xfcf1dcb4, 0x0c00ebc2, 0xfffffff9, 0x0000000b } },
+{ 0x8e17e881, 0x0000000c, { 0xa91ee60c, 0xfffffffa, 0xfffffffa, 0x00000006, 0xf681fe0b, 0x0bd75360, 0xfffffffd, 0x00000001 } },
+{ 0x8eb09d24, 0x0000004f, { 0x08807e1c, 0xffffffdd, 0xffffffdd, 0x0000002c, 0xfe90d162, 0x01ce6334, 0xffffffe6, 0x00000018 } },
+{ 0xd279d50e, 0x00000b5b, { 0x0d7655fa, 0xfffffdfb, 0xfffffdfb, 0x00000956, 0xfffbfdb3, 0x00128902, 0xfffff56d, 0x00000b58 } },
+{ 0x72d386ab, 0x00000004, { 0xcb4e1aac, 0x00000001, 0x00000001, 0x00000001, 0x1cb4e1aa, 0x1cb4e1aa, 0x00000003, 0x00000003 } },
+{ 0x46ae13f8, 0x00000b18, { 0x1b2d8740, 0x00000310, 0x00000310, 0x00000310, 0x00065f03, 0x00065f03, 0x00000ab0, 0x00000ab0 } },
+{ 0x17715e83, 0x0000001c, { 0x90665654, 0x00000002, 0x00000002, 0x00000002, 0x00d655a9, 0x00d655a9, 0x00000007, 0x00000007 } },
+{ 0x6722fc0d, 0x00000454, { 0x636ae844, 0x000001be, 0x000001be, 0x000001be, 0x0017d454, 0x0017d454, 0x0000007d, 0x0000007d } },
+{ 0xed6cc64d, 0x00000871, { 0x3335effd, 0xffffff63, 0xffffff63, 0x000007d4, 0xfffdccae, 0x001c2050, 0xfffffd7f, 0x000002fd } },
+{ 0xb7077469, 0x0000016a, { 0xd08a9c7a, 0xffffff98, 0xffffff98, 0x00000102, 0xffcc6573, 0x00816f59, 0xffffffcb, 0x0000008f } },
+{ 0x543de048, 0x00001509, { 0x0992ca88, 0x000006ec, 0x000006ec, 0x000006ec, 0x0004013a, 0x0004013a, 0x0000133e, 0x0000133e } },
+{ 0xa552c22d, 0x0000025c, { 0x0f42222c, 0xffffff2a, 0xffffff2a, 0x00000186, 0xffd99147, 0x0046121f, 0xfffffea9, 0x00000109 } },
+{ 0x51a00559, 0x000000ff, { 0x4e6553a7, 0x00000051, 0x00000051, 0x00000051, 0x0051f1f7, 0x0051f1f7, 0x00000050, 0x00000050 } },
+{ 0xc457adcf, 0x00000000, { 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0xffffffff, 0xffffffff, 0xc457adcf, 0xc457adcf } },
+{ 0xcf56d85f, 0x00000004, { 0x3d5b617c, 0xffffffff, 0xffffffff, 0x00000003, 0xf3d5b618, 0x33d5b617, 0xffffffff, 0x00000003 } },
+{ 0xcecad6ee, 0x0000067f, { 0x57aa3412, 0xfffffec0, 0xfffffec0, 0x0000053f, 0xfff86cd0, 0x001fd555, 0xfffffbbe, 0x000003c3 } },
+{ 0xef07b6b5, 0x00000000, { 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0xffffffff, 0xffffffff, 0xef07b6b5, 0xef07b6b5 } },
+{ 0xc821f838, 0x00000633, { 0xaa95c328, 0xfffffea5, 0xfffffea5, 0x000004d8, 0xfff6fcef, 0x00204895, 0xfffffa9b, 0x00000489 } },
+{ 0x2dad0a12, 0x000059d7, { 0x84d3b71e, 0x00001007, 0x00001007, 0x00001007, 0x00008227, 0x00008227, 0x00002c51, 0x00002c51 } },
+{ 0x4be1027a, 0x00000008, { 0x5f0813d0, 0x00000002, 0x00000002, 0x00000002, 0x097c204f, 0x097c204f, 0x00000002, 0x00000002 } },
+{ 0x33aa1bef, 0x0000009c, { 0x7ba905a4, 0x0000001f, 0x0000001f, 0x0000001f, 0x0054c862, 0x0054c862, 0x00000037, 0x00000037 } },
+{ 0x5a04c45d, 0x0000012f, { 0x8ba46a13, 0x0000006a, 0x0000006a, 0x0000006a, 0x004c0e2a, 0x004c0e2a, 0x000000a7, 0x000000a7 } },
+{ 0x16d09a5b, 0x00000003, { 0x4471cf11, 0x00000000, 0x00000000, 0x00000000, 0x079ade1e, 0x079ade1e, 0x00000001, 0x00000001 } },
+{ 0x120ab462, 0x00000005, { 0x5a3585ea, 0x00000000, 0x00000000, 0x00000000, 0x039bbdad, 0x039bbdad, 0x00000001, 0x00000001 } },
+{ 0xea975344, 0x00000076, { 0x21c06158, 0xfffffff6, 0xfffffff6, 0x0000006c, 0xffd18db9, 0x01fcf184, 0xfffffffe, 0x0000006c } },
+{ 0x64ee3937, 0x0000001a, { 0x4031cf96, 0x0000000a, 0x0000000a, 0x0000000a, 0x03e1c71f, 0x03e1c71f, 0x00000011, 0x00000011 } },
+{ 0x8c20f579, 0x000034d0, { 0x8ca40650, 0xffffe818, 0xffffe818, 0x00001ce8, 0xfffdce56, 0x0002a740, 0xffffd799, 0x00001179 } },
+{ 0x91d8aace, 0x00006ea1, { 0xd2a7ef8e, 0xffffd065, 0xffffd065, 0x00003f06, 0xffff011a, 0x0001517e, 0xffffcd74, 0x00004690 } },
+{ 0x91363a0e, 0x0000002d, { 0x86883476, 0xffffffec, 0xffffffec, 0x00000019, 0xfd89bd06, 0x033a180b, 0x00000000, 0x0000001f } },
+{ 0x07e5245a, 0x00000001, { 0x07e5245a, 0x00000000, 0x00000000, 0x00000000, 0x07e5245a, 0x07e5245a, 0x00000000, 0x00000000 } },
+{ 0x561258a4, 0x00000007, { 0x5a806c7c, 0x00000002, 0x00000002, 0x00000002, 0x0c4bc385, 0x0c4bc385, 0x00000001, 0x00000001 } },
+{ 0xc1a48e4f, 0x0000009a, { 0x7cfd9b86, 0xffffffda, 0xffffffda, 0x00000074, 0xff98575e, 0x0141e653, 0xffffffc3, 0x00000061 } },
+{ 0x4eb18c0c, 0x00000633, { 0xd6a72e64, 0x000001e7, 0x000001e7, 0x000001e7, 0x000cb1b0, 0x000cb1b0, 0x000005fc, 0x000005fc } },
+{ 0x211af65c, 0x00000081, { 0xae96245c, 0x00000010, 0x00000010, 0x00000010, 0x0041b287, 0x0041b287, 0x00000055, 0x00000055 } },
+{ 0x5f268acb, 0x00000001, { 0x5f268acb, 0x00000000, 0x00000000, 0x00000000, 0x5f268acb, 0x5f268acb, 0x00000000, 0x00000000 } },
+{ 0x032478a0, 0x0000006b, { 0x503e6ae0, 0x00000001, 0x00000001, 0x00000001, 0x000784b7, 0x000784b7, 0x00000023, 0x00000023 } },
+{ 0x6766bc04, 0x0000bfe7, { 0xf3faa39c, 0x00004d82, 0x00004d82, 0x00004d82, 0x000089f0, 0x000089f0, 0x00003474, 0x00003474 } },
+{ 0xfb0079a1, 0x00000d9e, { 0xf0783e5e, 0xffffffbb, 0xffffffbb, 0x00000d59, 0xffffa20a, 0x00126ec6, 0xfffff575, 0x00000d6d } },
+{ 0x68294b08, 0x00000f09, { 0x14d91b48, 0x0000061e, 0x0000061e, 0x0000061e, 0x0006ed87, 0x0006ed87, 0x00000849, 0x00000849 } },
+{ 0x66622cbb, 0x00000003, { 0x33268631, 0x00000001, 0x00000001, 0x00000001, 0x2220b993, 0x2220b993, 0x00000002, 0x00000002 } },
+{ 0x681f7edd, 0x00000354, { 0x88d23784, 0x0000015a, 0x0000015a, 0x0000015a, 0x001f4929, 0x001f4929, 0x00000269, 0x00000269 } },
+{ 0xae7ec452, 0x000006a1, { 0xb6536392, 0xfffffde3, 0xfffffde3, 0x00000484, 0xfff3b464, 0x001a52c8, 0xfffff96e, 0x0000048a } },
+{ 0xf4be929d, 0x00000015, { 0x13a206e1, 0xffffffff, 0xffffffff, 0x00000014, 0xff76ca08, 0x0ba78d13, 0xfffffff5, 0x0000000e } },
+{ 0xb9c41b0f, 0x00004fcf, { 0xb9eb8221, 0xffffea1a, 0xffffea1a, 0x000039e9, 0xffff1eb7, 0x000253e0, 0xffffcc16, 0x000028ef } },
+{ 0x2ca96708, 0x00000000, { 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0xffffffff, 0xffffffff, 0x2ca96708, 0x2ca96708 } },
+{ 0xb3ce20b0, 0x0000fbe3, { 0x89d38c10, 0xffffb507, 0xffffb507, 0x0000b0ea, 0xffffb290, 0x0000b6bd, 0xffff9b00, 0x0000c819 } },
+{ 0x95af56ef, 0x00000f1c, { 0xa5458324, 0xfffff9b9, 0xfffff9b9, 0x000008d5, 0xfff8f6b1, 0x0009e821, 0xfffffc93, 0x00000453 } },
+{ 0xeb0cc92f, 0x000000e8, { 0x03965298, 0xffffffed, 0xffffffed, 0x000000d5, 0xffe8e1f9, 0x01035d8e, 0xffffff87, 0x0000007f } },
+{ 0x22fd9753, 0x000001b5, { 0xbae350af, 0x0000003b, 0x0000003b, 0x0000003b, 0x00147f77, 0x00147f77, 0x00000130, 0x00000130 } },
+{ 0x06cb2e75, 0x0000094f, { 0x3d55731b, 0x0000003f, 0x0000003f, 0x0000003f, 0x0000bad6, 0x0000bad6, 0x0000006b, 0x0000006b } },
+{ 0xfc2dbb51, 0x000015b1, { 0x1bfc2801, 0xffffffad, 0xffffffad, 0x0000155e, 0xffffd2e7, 0x000ba030, 0xfffff69a, 0x00000a21 } },
+{ 0x2c836cfe, 0x00000002, { 0x5906d9fc, 0x00000000, 0x00000000, 0x00000000, 0x1641b67f, 0x1641b67f, 0x00000000, 0x00000000 } },
+{ 0x9cb35227, 0x0000037f, { 0xd6ec3659, 0xfffffea4, 0xfffffea4, 0x00000223, 0xffe398d6, 0x002cd253, 0xfffffdfd, 0x000001fa } },
+{ 0xbf20d2b6, 0x000028bc, { 0x7d072da8, 0xfffff5ad, 0xfffff5ad, 0x00001e69, 0xfffe684f, 0x0004b12a, 0xffffe0b2, 0x000027de } },
+{ 0x4a37dd5c, 0x00000039, { 0x8670497c, 0x00000010, 0x00000010, 0x00000010, 0x014d54b9, 0x014d54b9, 0x0000002b, 0x0000002b } },
+{ 0x15449c84, 0x00000002, { 0x2a893908, 0x00000000, 0x00000000, 0x00000000, 0x0aa24e42, 0x0aa24e42, 0x00000000, 0x00000000 } },
+{ 0x9962c7f4, 0x00005fe8, { 0xa9b8c120, 0xffffd98e, 0xffffd98e, 0x00003976, 0xfffeee19, 0x0001996d, 0xffffba4c, 0x00004a2c } },
+{ 0x8bf8fd4f, 0x00000001, { 0x8bf8fd4f, 0xffffffff, 0xffffffff, 0x00000000, 0x8bf8fd4f, 0x8bf8fd4f, 0x00000000, 0x00000000 } },
+{ 0x75997c0a, 0x000073a7, { 0xa9d86886, 0x00003520, 0x00003520, 0x00003520, 0x0001044f, 0x0001044f, 0x00002f81, 0x00002f81 } },
+{ 0xd3c61b4b, 0x00000009, { 0x71f6f5a3, 0xfffffffe, 0xfffffffe, 0x00000007, 0xfb160309, 0x1787ca24, 0xfffffffa, 0x00000007 } },
+{ 0xdffe118c, 0x00000001, { 0xdffe118c, 0xffffffff, 0xffffffff, 0x00000000, 0xdffe118c, 0xdffe118c, 0x00000000, 0x00000000 } },
+{ 0x830f2dd6, 0x000016cf, { 0x4736740a, 0xfffff4de, 0xfffff4de, 0x00000bad, 0xfffa85b0, 0x0005befd, 0xfffff486, 0x00000143 } },
+{ 0xc25b6bd8, 0x00000001, { 0xc25b6bd8, 0xffffffff, 0xffffffff, 0x00000000, 0xc25b6bd8, 0xc25b6bd8, 0x00000000, 0x00000000 } },
+{ 0xe79974d7, 0x0000f56b, { 0xa9f598dd, 0xffffe89b, 0xffffe89b, 0x0000de06, 0xffffe68d, 0x0000f195, 0xffff26e8, 0x0000e290 } },
+{ 0x3be989ea, 0x00000003, { 0xb3bc9dbe, 0x00000000, 0x00000000, 0x00000000, 0x13f8834e, 0x13f8834e, 0x00000000, 0x00000000 } },
+{ 0x2457b8d1, 0x0000006e, { 0x9db169ce, 0x0000000f, 0x0000000f, 0x0000000f, 0x0054944c, 0x0054944c, 0x00000029, 0x00000029 } },
+{ 0x5fa037b3, 0x0000031d, { 0xb5cd6847, 0x00000129, 0x00000129, 0x00000129, 0x001eb728, 0x001eb728, 0x0000002b, 0x0000002b } },
+{ 0xb44333a3, 0x00000009, { 0x565cd0bb, 0xfffffffd, 0xfffffffd, 0x00000006, 0xf795b068, 0x14077783, 0xfffffffb, 0x00000008 } },
+{ 0x42bc47b0, 0x00000001, { 0x42bc47b0, 0x00000000, 0x00000000, 0x00000000, 0x42bc47b0, 0x42bc47b0, 0x00000000, 0x00000000 } },
+{ 0x6ecb3797, 0x00000005, { 0x29f815f3, 0x00000002, 0x00000002, 0x00000002, 0x1628a4b7, 0x1628a4b7, 0x00000004, 0x00000004 } },
+{ 0x1866a19b, 0x00000006, { 0x9267c9a2, 0x00000000, 0x00000000, 0x00000000, 0x04111aef, 0x04111aef, 0x00000001, 0x00000001 } },
+{ 0x598303cf, 0x00000e19, { 0xe800b137, 0x000004ed, 0x000004ed, 0x000004ed, 0x00065972, 0x00065972, 0x00000bad, 0x00000bad } },
+{ 0x2f6826c2, 0x0000078e, { 0x24d4cd9c, 0x00000166, 0x00000166, 0x00000166, 0x00064670, 0x00064670, 0x000004a2, 0x000004a2 } },
+{ 0xb76d2b87, 0x0000009d, { 0x7df3b1cb, 0xffffffd3, 0xffffffd3, 0x00000070, 0xff89a9dc, 0x012b171a, 0xffffff9b, 0x00000095 } },
+{ 0x2135d8a0, 0x00002ac5, { 0x63f9f320, 0x0000058c, 0x0000058c, 0x0000058c, 0x0000c6c8, 0x0000c6c8, 0x000010b8, 0x000010b8 } },
+{ 0x6557fd68, 0x00000000, { 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0xffffffff, 0xffffffff, 0x6557fd68, 0x6557fd68 } },
+{ 0x1be6c179, 0x00000653, { 0x7459903b, 0x000000b0, 0x000000b0, 0x000000b0, 0x0004696d, 0x0004696d, 0x00000522, 0x00000522 } },
+{ 0x305243e5, 0x00000ccd, { 0x8d0f1a61, 0x0000026a, 0x0000026a, 0x0000026a, 0x0003c65e, 0x0003c65e, 0x0000029f, 0x0000029f } },
+{ 0xa6493a17, 0x000000d9, { 0xf4123d7f, 0xffffffb3, 0xffffffb3, 0x0000008c, 0xff96298f, 0x00c42bea, 0xffffffe0, 0x000000bd } },
+{ 0xaaeee61b, 0x00000002, { 0x55ddcc36, 0xffffffff, 0xffffffff, 0x00000001, 0xd577730e, 0x5577730d, 0xffffffff, 0x00000001 } },
+{ 0x9b471832, 0x00000007, { 0x3ef1a95e, 0xfffffffd, 0xfffffffd, 0x00000004, 0xf19c712c, 0x162eba50, 0xfffffffe, 0x00000002 } },
+{ 0x66babbe3, 0x00000ca6, { 0x5de47932, 0x00000513, 0x00000513, 0x00000513, 0x00081f35, 0x00081f35, 0x00000385, 0x00000385 } },
+{ 0xc31e48b5, 0x00000000, { 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0xffffffff, 0xffffffff, 0xc31e48b5, 0xc31e48b5 } },
+{ 0xca576abf, 0x00000026, { 0x08f9d85a, 0xfffffff8, 0xfffffff8, 0x0000001e, 0xfe9682d0, 0x0553247e, 0xffffffdf, 0x0000000b } },
+{ 0x2442158d, 0x0000b104, { 0x41eed334, 0x00001912, 0x00001912, 0x00001912, 0x0000346f, 0x0000346f, 0x000084d1, 0x000084d1 } },
+{ 0xa4af732d, 0x000013cd, { 0xe60b9209, 0xfffff8ef, 0xfffff8ef, 0x00000cbc, 0xfffb636a, 0x0008512e, 0xfffff94b, 0x00000757 } },
+{ 0xa105e48b, 0x00000042, { 0x8384ebd6, 0xffffffe7, 0xffffffe7, 0x00000029, 0xfe8f9abd, 0x027092fa, 0xffffffd1, 0x00000017 } },
+{ 0x41eec0b8, 0x00000001, { 0x41eec0b8, 0x00000000, 0x00000000, 0x00000000, 0x41eec0b8, 0x41eec0b8, 0x00000000, 0x00000000 } },
+{ 0xf59e8fca, 0x0000000c, { 0x836ebd78, 0xffffffff, 0xffffffff, 0x0000000b, 0xff228bfc, 0x1477e150, 0xfffffffa, 0x0000000a } },
+{ 0x2a6bd255, 0x00001b69, { 0xc5683bdd, 0x0000048a, 0x0000048a, 0x0000048a, 0x00018c32, 0x00018c32, 0x00000bd3, 0x00000bd3 } },
+{ 0xc0d1960d, 0x00000002, { 0x81a32c1a, 0xffffffff, 0xffffffff, 0x00000001, 0xe068cb07, 0x6068cb06, 0xffffffff, 0x00000001 } },
+{ 0x5aae10a7, 0x00000000, { 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0xffffffff, 0xffffffff, 0x5aae10a7, 0x5aae10a7 } },
+{ 0x3f70cb0d, 0x000009aa, { 0x180a4ba2, 0x00000265, 0x00000265, 0x00000265, 0x00069088, 0x00069088, 0x000008bd, 0x000008bd } },
+{ 0x4ab4dec0, 0x0000001e, { 0xc1321a80, 0x00000008, 0x00000008, 0x00000008, 0x027d7ee4, 0x027d7ee4, 0x00000008, 0x00000008 } },
+{ 0x6762876d, 0x000003f1, { 0x7b57c49d, 0x00000197, 0x00000197, 0x00000197, 0x001a3aff, 0x001a3aff, 0x0000005e, 0x0000005e } },
+{ 0xae14c487, 0x00003d49, { 0x96c0357f, 0xffffec63, 0xffffec63, 0x000029ac, 0xfffea9d0, 0x0002d72b, 0xffffc837, 0x00002a44 } },
+{ 0x6dce1bcc, 0x0000001d, { 0x7059261c, 0x0000000c, 0x0000000c, 0x0000000c, 0x03c95068, 0x03c95068, 0x00000004, 0x00000004 } },
+{ 0xbcd9421e, 0x00000007, { 0x29f0ced2, 0xfffffffe, 0xfffffffe, 0x00000005, 0xf6682e05, 0x1afa7728, 0xfffffffb, 0x00000006 } },
+{ 0xf1a38700, 0x00000006, { 0xa9d52a00, 0xffffffff, 0xffffffff, 0x00000005, 0xfd9b412b, 0x2845ebd5, 0xfffffffe, 0x00000002 } },
+{ 0x421a7242, 0x0000b3b2, { 0x744797e4, 0x00002e66, 0x00002e66, 0x00002e66, 0x00005e2c, 0x00005e2c, 0x000033aa, 0x000033aa } },
+{ 0x188e34c5, 0x00000036, { 0x2dff218e, 0x00000005, 0x00000005, 0x00000005, 0x00746946, 0x00746946, 0x00000001, 0x00000001 } },
+{ 0x0f5a9f9f, 0x0000004b, { 0x7f8cc395, 0x00000004, 0x00000004, 0x00000004, 0x00346887, 0x00346887, 0x00000012, 0x00000012 } },
+{ 0x9a4c263e, 0x00000002, { 0x34984c7c, 0xffffffff, 0xffffffff, 0x00000001, 0xcd26131f, 0x4d26131f, 0x00000000, 0x00000000 } },
+{ 0x33aede94, 0x000000e3, { 0xd40f5d3c, 0x0000002d, 0x0000002d, 0x0000002d, 0x003a4928, 0x003a4928, 0x0000001c, 0x0000001c } },
+{ 0xd4e99f88, 0x00001095, { 0x85f25a28, 0xfffffd35, 0xfffffd35, 0x00000dca, 0xfffd66cd, 0x000cd707, 0xfffffa37, 0x00000875 } },
+{ 0x6139e287, 0x00001581, { 0xbdc03907, 0x0000082a, 0x0000082a, 0x0000082a, 0x00048575, 0x00048575, 0x00000992, 0x00000992 } },
+{ 0x6e80573d, 0x000001a2, { 0x6d8e719a, 0x000000b4, 0x000000b4, 0x000000b4, 0x0043acea, 0x0043acea, 0x00000129, 0x00000129 } },
+{ 0x513d6635, 0x000001d9, { 0x1a71d7ed, 0x00000096, 0x00000096, 0x00000096, 0x002bf819, 0x002bf819, 0x00000004, 0x00000004 } },
+{ 0x8014a3f0, 0x0000001a, { 0x0218a660, 0xfffffff3, 0xfffffff3, 0x0000000d, 0xfb147c76, 0x04ed19ff, 0xfffffff4, 0x0000000a } },
+{ 0xf5b6c1ff, 0x00001d03, { 0x951e28fd, 0xfffffed5, 0xfffffed5, 0x00001bd8, 0xffffa53d, 0x0008782f, 0xffffe948, 0x00000672 } },
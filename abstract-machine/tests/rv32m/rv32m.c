@@ -0,0 +1,54 @@
+#include <am.h>
+#include <klib.h>
+#include <klib-macros.h>
+
+/* Check the RV32M instructions against a table of results computed by the
+ * definitions of the spec, including the divisions by zero and the overflow
+ * of INT_MIN / -1. The table is generated by gen-ref.py. */
+
+#if defined(__riscv) && __riscv_xlen == 32
+typedef struct {
+  uint32_t a, b;
+  uint32_t res[8];
+} Ref;
+
+static const Ref ref[] = {
+#include "ref.h"
+};
+
+static const char *name[] = { "mul", "mulh", "mulhsu", "mulhu", "div", "divu", "rem", "remu" };
+
+#define OP(op) ({ uint32_t r; asm volatile (op " %0, %1, %2" : "=r"(r) : "r"(a), "r"(b)); r; })
+
+static void exec(uint32_t a, uint32_t b, uint32_t *res) {
+  res[0] = OP("mul");
+  res[1] = OP("mulh");
+  res[2] = OP("mulhsu");
+  res[3] = OP("mulhu");
+  res[4] = OP("div");
+  res[5] = OP("divu");
+  res[6] = OP("rem");
+  res[7] = OP("remu");
+}
+#endif
+
+int main(const char *args) {
+#if defined(__riscv) && __riscv_xlen == 32
+  int i, j, nr_fail = 0;
+  for (i = 0; i < LENGTH(ref); i ++) {
+    uint32_t res[8];
+    exec(ref[i].a, ref[i].b, res);
+    for (j = 0; j < 8; j ++) {
+      if (res[j] == ref[i].res[j]) continue;
+      printf("rv32m: %s 0x%08x, 0x%08x = 0x%08x, expected 0x%08x\n",
+          name[j], ref[i].a, ref[i].b, res[j], ref[i].res[j]);
+      nr_fail ++;
+    }
+  }
+  printf("rv32m: %d cases, %d failed\n", (int)LENGTH(ref) * 8, nr_fail);
+  return nr_fail != 0;
+#else
+  printf("rv32m: skipped, not riscv32\n");
+  return 0;
+#endif
+}
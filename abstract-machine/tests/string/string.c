@@ -0,0 +1,150 @@
+#include <am.h>
+#include <klib.h>
+#include <klib-macros.h>
+
+/* Check the word-at-a-time string and memory functions of klib against
+ * byte-wise references. Every source and destination offset from 0 to 15 is
+ * crossed with lengths on both sides of the word size and a few longer ones,
+ * memmove() is run on overlapping ranges in both directions, and the bytes
+ * around a destination are checked to be untouched. */
+
+#define WSIZE sizeof(uintptr_t)
+#define NR_OFF 16
+#define GUARD 16
+#define MAX_LEN 272
+#define BUF_SIZE (GUARD + NR_OFF + MAX_LEN + NR_OFF + GUARD)
+
+static uint8_t src[BUF_SIZE], dst[BUF_SIZE], ref[BUF_SIZE];
+static size_t lens[4 * WSIZE + 4 + 6];
+static int nr_len, nr_case, nr_fail;
+
+static void init_lens() {
+  size_t n;
+  for (n = 0; n <= 4 * WSIZE + 3; n ++) lens[nr_len ++] = n;
+  static const size_t longer[] = { 63, 64, 65, 255, 256, 257 };
+  for (n = 0; n < LENGTH(longer); n ++) lens[nr_len ++] = longer[n];
+}
+
+// a pattern without '\0', different for each seed
+static void fill(uint8_t *buf, int seed) {
+  for (int i = 0; i < BUF_SIZE; i ++) buf[i] = (i * 13 + seed * 7) % 255 + 1;
+}
+
+static void ref_copy(uint8_t *d, const uint8_t *s, size_t n) {
+  for (size_t i = 0; i < n; i ++) d[i] = s[i];
+}
+
+static void ref_move(uint8_t *d, const uint8_t *s, size_t n) {
+  uint8_t tmp[MAX_LEN];
+  for (size_t i = 0; i < n; i ++) tmp[i] = s[i];
+  for (size_t i = 0; i < n; i ++) d[i] = tmp[i];
+}
+
+static void ref_set(uint8_t *d, int c, size_t n) {
+  for (size_t i = 0; i < n; i ++) d[i] = c;
+}
+
+static int sign(int x) {
+  return (x > 0) - (x < 0);
+}
+
+static void check(const char *name, const uint8_t *buf, int so, int doff, size_t n) {
+  nr_case ++;
+  for (int i = 0; i < BUF_SIZE; i ++) {
+    if (buf[i] == ref[i]) continue;
+    printf("string: %s src +%d, dst +%d, len %d: byte %d is 0x%02x, expected 0x%02x\n",
+        name, so, doff, (int)n, i, buf[i], ref[i]);
+    nr_fail ++;
+    return;
+  }
+}
+
+static void check_ret(const char *name, int ok, int so, int doff, size_t n) {
+  nr_case ++;
+  if (ok) return;
+  printf("string: %s src +%d, dst +%d, len %d: wrong result\n", name, so, doff, (int)n);
+  nr_fail ++;
+}
+
+static void test_memcpy(int so, int doff, size_t n) {
+  uint8_t *d = dst + GUARD + doff, *s = src + GUARD + so;
+  fill(dst, 1); fill(ref, 1);
+  ref_copy(ref + GUARD + doff, s, n);
+  check_ret("memcpy", memcpy(d, s, n) == d, so, doff, n);
+  check("memcpy", dst, so, doff, n);
+}
+
+static void test_memset(int doff, size_t n) {
+  uint8_t *d = dst + GUARD + doff;
+  fill(dst, 2); fill(ref, 2);
+  ref_set(ref + GUARD + doff, 0xa5, n);
+  check_ret("memset", memset(d, 0x1a5, n) == d, 0, doff, n);
+  check("memset", dst, 0, doff, n);
+}
+
+// src and dst are in the same buffer, and overlap unless n is short
+static void test_memmove(int so, int doff, size_t n) {
+  uint8_t *d = dst + GUARD + doff, *s = dst + GUARD + so;
+  fill(dst, 3); fill(ref, 3);
+  ref_move(ref + GUARD + doff, ref + GUARD + so, n);
+  check_ret("memmove", memmove(d, s, n) == d, so, doff, n);
+  check("memmove", dst, so, doff, n);
+}
+
+static void test_memcmp(int so, int doff, size_t n) {
+  uint8_t *d = dst + GUARD + doff, *s = src + GUARD + so;
+  fill(src, 4);
+  ref_copy(d, s, n);
+  check_ret("memcmp", memcmp(d, s, n) == 0, so, doff, n);
+  if (n == 0) return;
+  // a difference in the first, the middle or the last byte
+  size_t at[] = { 0, n / 2, n - 1 };
+  for (int i = 0; i < LENGTH(at); i ++) {
+    d[at[i]] = s[at[i]] ^ 0x80;
+    check_ret("memcmp", sign(memcmp(d, s, n)) == sign(d[at[i]] - s[at[i]]), so, doff, n);
+    d[at[i]] = s[at[i]];
+  }
+}
+
+// the string in src + GUARD + so of length n
+static void test_str(int so, int doff, size_t n) {
+  char *s = (char *)src + GUARD + so, *d = (char *)dst + GUARD + doff;
+  fill(src, 5);
+  s[n] = '\0';
+  check_ret("strlen", strlen(s) == n, so, doff, n);
+
+  fill(dst, 6); fill(ref, 6);
+  ref_copy(ref + GUARD + doff, (uint8_t *)s, n + 1);
+  check_ret("strcpy", strcpy(d, s) == d, so, doff, n);
+  check("strcpy", dst, so, doff, n);
+
+  check_ret("strcmp", strcmp(d, s) == 0, so, doff, n);
+  if (n == 0) return;
+  size_t at[] = { 0, n / 2, n - 1 };
+  for (int i = 0; i < LENGTH(at); i ++) {
+    // a byte differing in the highest bit, or a string ending early
+    d[at[i]] = s[at[i]] ^ 0x80;
+    check_ret("strcmp", sign(strcmp(d, s)) == sign((uint8_t)d[at[i]] - (uint8_t)s[at[i]]), so, doff, n);
+    d[at[i]] = '\0';
+    check_ret("strcmp", strcmp(d, s) < 0 && strcmp(s, d) > 0, so, doff, n);
+    d[at[i]] = s[at[i]];
+  }
+}
+
+int main(const char *args) {
+  init_lens();
+  for (int so = 0; so < NR_OFF; so ++) {
+    for (int doff = 0; doff < NR_OFF; doff ++) {
+      for (int i = 0; i < nr_len; i ++) {
+        size_t n = lens[i];
+        test_memcpy(so, doff, n);
+        test_memmove(so, doff, n);
+        test_memcmp(so, doff, n);
+        test_str(so, doff, n);
+        if (so == 0) test_memset(doff, n);
+      }
+    }
+  }
+  printf("string: %d cases, %d failed\n", nr_case, nr_fail);
+  return nr_fail != 0;
+}
@@ -0,0 +1,48 @@
+#include <am.h>
+#include <klib.h>
+
+// A workload of logic and shift operations, which are replaced by table
+// lookups under riscv32mini. See run.sh for comparing the table layouts.
+
+#define N 4096
+
+static uint32_t xorshift(uint32_t *s) {
+  uint32_t x = *s;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  return *s = x;
+}
+
+static uint32_t crc32(const uint8_t *buf, int len) {
+  uint32_t crc = 0xffffffff;
+  for (int i = 0; i < len; i ++) {
+    crc ^= buf[i];
+    for (int j = 0; j < 8; j ++) {
+      crc = (crc >> 1) ^ (0xedb88320 & (0 - (crc & 1)));
+    }
+  }
+  return ~crc;
+}
+
+static int popcount(uint32_t x) {
+  x = x - ((x >> 1) & 0x55555555);
+  x = (x & 0x33333333) + ((x >> 2) & 0x33333333);
+  x = (x + (x >> 4)) & 0x0f0f0f0f;
+  return (x + (x >> 8) + (x >> 16) + (x >> 24)) & 0x3f;
+}
+
+static uint8_t buf[N];
+
+int main(const char *args) {
+  uint32_t seed = 0x12345678, sum = 0;
+  for (int i = 0; i < N; i ++) {
+    buf[i] = xorshift(&seed);
+  }
+  for (int i = 0; i < N; i ++) {
+    sum += popcount(xorshift(&seed) | (seed & 0xff00ff));
+  }
+  sum ^= crc32(buf, N);
+  printf("checksum = 0x%08x\n", sum);
+  return sum != 0x614083a6;
+}
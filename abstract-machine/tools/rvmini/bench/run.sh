@@ -0,0 +1,16 @@
+#!/bin/bash
+
+# Compare the layouts of the lookup tables of rvmini by running bench.c under
+# NEMU for riscv32. Build NEMU with CONFIG_TIMING to get the cycles estimated
+# with a data cache, which is what the layouts are about.
+
+cd `dirname $0`
+for lut in byte nibble; do
+  # objects do not depend on the layout, rebuild everything
+  make -s -C $AM_HOME/am clean
+  make -s -C $AM_HOME/klib clean
+  make -s clean
+  echo "== RVMINI_LUT=$lut"
+  NEMUFLAGS=-b RVMINI_LUT=$lut make -s ARCH=riscv32mini-nemu run 2>&1 | \
+    grep -E "checksum|HIT|ABORT|total guest instructions|estimated cycles"
+done
@@ -1,10 +1,22 @@
 #include <stdio.h>
+#include <string.h>
 #include <assert.h>
 
-#define LUT_BIN "lut.bin"
-
-int main() {
-  FILE *fp = fopen(LUT_BIN, "w");
+/* The layouts of the tables are known by inst-replace.h.
+ *
+ * byte: 256x256 tables of 8-bit and, or, xor, indexed by (a << 8 | b).
+ *
+ * nibble: 256-byte tables of 4-bit operations indexed by (a << 4 | b), and
+ * the tables to split a byte into such indices. An operation on a byte
+ * takes two lookups, which keeps the working set in a few cache lines.
+ *   -1024: x & 0xf0     -768: x >> 4     -512: (x & 0xf) << 4     -256: x & 0xf
+ *       0: and4          256: and4 << 4   512: or4   768: or4 << 4
+ *    1024: xor4         1280: xor4 << 4  1536: ~x (8-bit)   1792: x & 0x1f
+ *
+ * The shift tables of both layouts follow. */
+int main(int argc, char *argv[]) {
+  int nibble = (argc > 1 && strcmp(argv[1], "nibble") == 0);
+  FILE *fp = fopen(nibble ? "lut-nibble.bin" : "lut.bin", "w");
   assert(fp != NULL);
 
 #define gen_table(name, row, col, entry_size, expr) do { \
@@ -16,9 +28,24 @@ int main() {
   } \
 } while (0)
 
-  gen_table(_and8_table, 256, 256, 1, j & i);
-  gen_table(_or8_table,  256, 256, 1, j | i);
-  gen_table(_xor8_table, 256, 256, 1, j ^ i);
+  if (nibble) {
+    gen_table(_hi_x16_table, 1, 256, 1, i & 0xf0);
+    gen_table(_hi_table,     1, 256, 1, i >> 4);
+    gen_table(_lo_x16_table, 1, 256, 1, (i & 0xf) << 4);
+    gen_table(_lo_table,     1, 256, 1, i & 0xf);
+    gen_table(_and4_table,    16, 16, 1, j & i);
+    gen_table(_and4_hi_table, 16, 16, 1, (j & i) << 4);
+    gen_table(_or4_table,     16, 16, 1, j | i);
+    gen_table(_or4_hi_table,  16, 16, 1, (j | i) << 4);
+    gen_table(_xor4_table,    16, 16, 1, j ^ i);
+    gen_table(_xor4_hi_table, 16, 16, 1, (j ^ i) << 4);
+    gen_table(_not8_table,  1, 256, 1, ~i & 0xff);
+    gen_table(_shamt_table, 1, 256, 1, i & 0x1f);
+  } else {
+    gen_table(_and8_table, 256, 256, 1, j & i);
+    gen_table(_or8_table,  256, 256, 1, j | i);
+    gen_table(_xor8_table, 256, 256, 1, j ^ i);
+  }
   gen_table(_sll8_table, 32, 256, 4, (unsigned)i << j);
   gen_table(_srl8_table, 32, 256, 4, ((unsigned)i << 24) >> j);
   gen_table(_sra8_table, 32, 256, 4, (int)((unsigned)i << 24) >> j);
@@ -72,10 +72,27 @@ _or1_table: .byte 0, 1, 1, 1
 _logic_shift_table:
 .incbin _LUT_BIN_PATH  # defined in command line flags
 
+#ifdef _LUT_NIBBLE
+# tables of 4-bit operations, see gen-lut.c for the layout
+#define _nibble_table (_logic_shift_table + 1024)
+#define NIB_HI_X16  (-1024)
+#define NIB_HI      (-768)
+#define NIB_LO_X16  (-512)
+#define NIB_LO      (-256)
+#define _and4_table 0
+#define _or4_table  512
+#define _xor4_table 1024
+#define _not8_table  (_nibble_table + 1536)
+#define _shamt_table (_not8_table + 256)
+#define _sll8_table  (_shamt_table + 256)
+#else
 #define _and8_table _logic_shift_table
 #define _or8_table  (_and8_table + 256 * 256)
 #define _xor8_table (_or8_table  + 256 * 256)
+#define _not8_table  (_xor8_table + (0xff << 8))
+#define _shamt_table (_and8_table + (0x1f << 8))
 #define _sll8_table (_xor8_table + 256 * 256)
+#endif
 #define _srl8_table (_sll8_table + 32 * 256 * 4)
 #define _sra8_table (_srl8_table + 32 * 256 * 4)
 
@@ -160,6 +177,67 @@ _logic_shift_table:
   slt_template _sltu1_table, \rd, \rs1, \rs2
 .endm
 
+#ifdef _LUT_NIBBLE
+# op(a, b) = op4_hi[(a & 0xf0) + (b >> 4)] + op4[((a & 0xf) << 4) + (b & 0xf)]
+.macro logic4_byte_internal base, op, boffset
+  lbu tp, SP_VAR_BYTE(VAR_A, \boffset)
+  add tp, \base, tp
+  lbu gp, NIB_HI_X16(tp)
+  lbu tp, SP_VAR_BYTE(VAR_B, \boffset)
+  add tp, \base, tp
+  lbu tp, NIB_HI(tp)
+  add gp, gp, tp
+  add gp, \base, gp
+  lbu gp, (\op + 256)(gp)
+  sb gp, SP_VAR_BYTE(VAR_C, \boffset)
+
+  lbu tp, SP_VAR_BYTE(VAR_A, \boffset)
+  add tp, \base, tp
+  lbu gp, NIB_LO_X16(tp)
+  lbu tp, SP_VAR_BYTE(VAR_B, \boffset)
+  add tp, \base, tp
+  lbu tp, NIB_LO(tp)
+  add gp, gp, tp
+  add gp, \base, gp
+  lbu gp, \op(gp)
+  lbu tp, SP_VAR_BYTE(VAR_C, \boffset)
+  add gp, gp, tp
+  sb gp, SP_VAR_BYTE(VAR_C, \boffset)
+.endm
+
+.macro logic op, rd, rs1, rs2
+  .if \rd == x0
+    .exitm
+  .endif
+  .if \rd == sp || \rs1 == sp || \rs2 == sp
+    .abort
+  .endif
+  .if \rd == gp || \rs1 == gp || \rs2 == gp
+    .abort
+  .endif
+  .if \rd == tp || \rs1 == tp
+    .abort
+  .endif
+  PUSH(gp, 3)
+  sw \rs1, SP_VAR(VAR_A)
+  sw \rs2, SP_VAR(VAR_B)
+  la \rd, _nibble_table
+
+  logic4_byte_internal \rd, \op, 3
+  logic4_byte_internal \rd, \op, 2
+  logic4_byte_internal \rd, \op, 1
+  logic4_byte_internal \rd, \op, 0
+
+  POP(gp, 3)
+  lw \rd, SP_VAR(VAR_C)
+.endm
+
+#define def_logic(name) \
+  .macro name rd, rs1, rs2 ;\
+    SET_DEBUG_LABEL(name); \
+    logic concat(_, concat(name, 4_table)), \rd, \rs1, \rs2; \
+  .endm
+#else
 .macro logic8_byte_internal lut_reg, boffset
   lbu tp, SP_VAR_BYTE(VAR_A, \boffset)
   sb tp, SP_VAR_BYTE(VAR_D, 1)
@@ -203,6 +281,8 @@ _logic_shift_table:
     logic concat(_, concat(name, 8_table)), \rd, \rs1, \rs2; \
   .endm
 
+#endif
+
 def_logic(and)
 def_logic(or)
 def_logic(xor)
@@ -382,7 +462,7 @@ LABEL_NAME:
 .macro getshamt rd, rs1
   sb \rs1, SP_VAR_BYTE(VAR_B, 0)
   lbu \rd, SP_VAR_BYTE(VAR_B, 0)
-  la tp, (_and8_table + (0x1f << 8))
+  la tp, _shamt_table
   add \rd, \rd, tp
   lbu \rd, (\rd)
 .endm
@@ -626,7 +706,7 @@ def_itype(xori, xor)
 .macro not rd, rs1
   PUSH(gp, 3)
   sw \rs1, SP_VAR(VAR_C)
-  la tp, (_xor8_table + (0xff << 8))
+  la tp, _not8_table
 
   lbu gp, SP_VAR_BYTE(VAR_C, 3)
   add gp, gp, tp
@@ -22,9 +22,17 @@ sed -E -i -e "s/(l[bhw]u?)${sp}(${reg})${comma}(${symbol})(${sp}[-+]${sp}${symbo
 
 # insert inst-replace.h to each .h files
 rvmini_path=$AM_HOME/tools/rvmini
-lut_bin_path=$rvmini_path/lut.bin
 sed -i "1i#include \"$rvmini_path/inst-replace.h\"" $dst_S
-flock $rvmini_path/.lock -c "test -e $lut_bin_path || (cd $rvmini_path && gcc gen-lut.c && ./a.out && rm a.out)"
+
+# layout of the lookup tables: byte (default), or nibble for smaller tables
+if [[ "$RVMINI_LUT" == nibble ]] then
+  lut_bin_path=$rvmini_path/lut-nibble.bin
+  lut_flags=-D_LUT_NIBBLE
+else
+  lut_bin_path=$rvmini_path/lut.bin
+  lut_flags=
+fi
+flock $rvmini_path/.lock -c "test -e $lut_bin_path || (cd $rvmini_path && gcc gen-lut.c && ./a.out $RVMINI_LUT && rm a.out)"
 
 src_dir=`dirname $src`
-riscv64-linux-gnu-gcc -I$src_dir $flags -D_LUT_BIN_PATH=\"$lut_bin_path\" -Wno-trigraphs -c -o $dst $dst_S
+riscv64-linux-gnu-gcc -I$src_dir $flags $lut_flags -D_LUT_BIN_PATH=\"$lut_bin_path\" -Wno-trigraphs -c -o $dst $dst_S
@@ -0,0 +1,68 @@
+/***************************************************************************************
+* Copyright (c) 2014-2024 Zihao Yu, Nanjing University
+*
+* NEMU is licensed under Mulan PSL v2.
+* You can use this software according to the terms and conditions of the Mulan PSL v2.
+* You may obtain a copy of Mulan PSL v2 at:
+*          http://license.coscl.org.cn/MulanPSL2
+*
+* THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+* EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+* MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+*
+* See the Mulan PSL v2 for more details.
+***************************************************************************************/
+
+#ifndef __BLOG_DEF_H__
+#define __BLOG_DEF_H__
+
+#include <stdint.h>
+#include <string.h>
+
+/* A binary log, written by src/utils/log.c with CONFIG_LOG_BINARY, and
+ * formatted by tools/nemu-trace. It is the magic followed by records of
+ *
+ *   BLogRecord r;
+ *   uint8_t payload[r.len - sizeof(r)];
+ *
+ * in host byte order. A record with BLOG_DEF set in `id` defines the format
+ * string with the rest of `id` as the payload. A message of format `id`
+ * carries the arguments of its conversions, each integer, pointer and
+ * double as 8 bytes, and each string as a uint32_t length and the bytes.
+ * A message of id 0 is the text already formatted. */
+#define BLOG_MAGIC "NEMULOGB"
+#define BLOG_DEF 0x80000000u
+
+typedef struct {
+  uint32_t len;
+  uint32_t id;
+} BLogRecord;
+
+enum { BLOG_ARG_NONE, BLOG_ARG_INT, BLOG_ARG_LONG, BLOG_ARG_PTR, BLOG_ARG_DOUBLE, BLOG_ARG_STR, BLOG_ARG_BAD };
+
+// return the length of the conversion at `s` starting with '%', and its kind of argument
+static inline int blog_conversion(const char *s, int *kind) {
+  const char *p = s + 1;
+  if (*p == '%') { *kind = BLOG_ARG_NONE; return 2; }
+  while (*p != '\0' && strchr("-+ #0123456789.'", *p) != NULL) p ++;
+  // h and hh are promoted to int, the others are 64-bit on the host except L
+  int is_long = 0, wide = 0;
+  for (; *p != '\0' && strchr("hlLqjzt", *p) != NULL; p ++) {
+    if (*p == 'L') wide = 1;
+    else if (*p != 'h') is_long = 1;
+  }
+  switch (*p) {
+    case 'd': case 'i': case 'u': case 'o': case 'x': case 'X': case 'c':
+      *kind = (is_long ? (*p == 'c' ? BLOG_ARG_BAD : BLOG_ARG_LONG) : BLOG_ARG_INT);
+      break;
+    case 'e': case 'E': case 'f': case 'F': case 'g': case 'G': case 'a': case 'A':
+      *kind = (wide ? BLOG_ARG_BAD : BLOG_ARG_DOUBLE); break;
+    case 's': *kind = (is_long ? BLOG_ARG_BAD : BLOG_ARG_STR); break;
+    case 'p': *kind = BLOG_ARG_PTR; break;
+    // such as '*' of the width and %n
+    default: *kind = BLOG_ARG_BAD; return p - s;
+  }
+  return p - s + 1;
+}
+
+#endif
@@ -44,6 +44,13 @@ typedef MUXDEF(PMEM64, uint64_t, uint32_t) paddr_t;
 #define FMT_PADDR MUXDEF(PMEM64, "0x%016" PRIx64, "0x%08" PRIx32)
 typedef uint16_t ioaddr_t;
 
+// state kept by each host thread running a hart, see cpu/hart.h
+#ifdef CONFIG_HART_THREAD
+#define HART_LOCAL __thread
+#else
+#define HART_LOCAL
+#endif
+
 #include <debug.h>
 
 #endif
@@ -0,0 +1,59 @@
+/***************************************************************************************
+* Copyright (c) 2014-2024 Zihao Yu, Nanjing University
+*
+* NEMU is licensed under Mulan PSL v2.
+* You can use this software according to the terms and conditions of the Mulan PSL v2.
+* You may obtain a copy of Mulan PSL v2 at:
+*          http://license.coscl.org.cn/MulanPSL2
+*
+* THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+* EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+* MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+*
+* See the Mulan PSL v2 for more details.
+***************************************************************************************/
+
+
+#ifndef __CPU_BBV_H__
+#define __CPU_BBV_H__
+
+#include <common.h>
+
+/* Basic block vectors for SimPoint. The execution is split into intervals
+ * of CONFIG_BBV_INTERVAL instructions by g_nr_guest_inst, and a line of
+ * the standard ".bb" format is written for each interval, with the number
+ * of instructions executed in each block. A block runs from its entry
+ * until the control flow is changed, and is numbered from 1 in the order
+ * of its first execution. */
+#ifdef CONFIG_BBV
+extern bool bbv_on;
+extern vaddr_t bbv_pc;
+extern uint64_t bbv_len;
+
+void bbv_block(vaddr_t pc, uint64_t len);
+
+// called after executing `n` instructions from `pc`, ending with a jump or not
+static inline void bbv_exec(vaddr_t pc, uint64_t n, bool jump) {
+  if (!bbv_on) return;
+  if (bbv_len == 0) bbv_pc = pc;
+  bbv_len += n;
+  if (jump) {
+    bbv_block(bbv_pc, bbv_len);
+    bbv_len = 0;
+  }
+}
+
+// called by the execution loop around each run of at most `n` instructions
+uint64_t bbv_limit(uint64_t n);
+void bbv_advance();
+#endif
+
+/* With the intervals chosen by SimPoint, the program is run untraced and a
+ * snapshot is saved at the start of each interval chosen, which can be
+ * loaded to run the interval in detail. */
+#ifdef CONFIG_SIMPOINT
+uint64_t simpoint_limit(uint64_t n);
+void simpoint_advance();
+#endif
+
+#endif
@@ -0,0 +1,51 @@
+/***************************************************************************************
+* Copyright (c) 2014-2024 Zihao Yu, Nanjing University
+*
+* NEMU is licensed under Mulan PSL v2.
+* You can use this software according to the terms and conditions of the Mulan PSL v2.
+* You may obtain a copy of Mulan PSL v2 at:
+*          http://license.coscl.org.cn/MulanPSL2
+*
+* THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+* EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+* MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+*
+* See the Mulan PSL v2 for more details.
+***************************************************************************************/
+
+
+#ifndef __CPU_BREAKPOINT_H__
+#define __CPU_BREAKPOINT_H__
+
+#include <common.h>
+
+/* The pc of breakpoints are kept in an open-addressing hash set, so that the
+ * execution loop only tests `nr_bp` when there is no breakpoint, and probes
+ * the set once for each instruction, or each block with the block engine
+ * and the JIT, otherwise. A breakpoint stops the execution before the
+ * instruction at it. */
+#define NR_BP 32
+#define BP_SET_SIZE 128 // power of 2, larger than NR_BP
+#define BP_EMPTY ((vaddr_t)-1)
+
+extern int nr_bp;
+extern vaddr_t bp_set[BP_SET_SIZE];
+
+static inline bool bp_probe(vaddr_t pc) {
+  uint32_t i = (pc ^ (pc >> 7)) % BP_SET_SIZE;
+  for (; bp_set[i] != BP_EMPTY; i = (i + 1) % BP_SET_SIZE) {
+    if (bp_set[i] == pc) return true;
+  }
+  return false;
+}
+
+// report the breakpoint at `pc` and stop the execution, always return true
+bool bp_stop(vaddr_t pc);
+
+#ifndef CONFIG_TARGET_AM
+#define BP_HIT(pc) (unlikely(nr_bp > 0) && bp_probe(pc) && bp_stop(pc))
+#else
+#define BP_HIT(pc) false
+#endif
+
+#endif
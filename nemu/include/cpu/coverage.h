@@ -0,0 +1,73 @@
+/***************************************************************************************
+* Copyright (c) 2014-2024 Zihao Yu, Nanjing University
+*
+* NEMU is licensed under Mulan PSL v2.
+* You can use this software according to the terms and conditions of the Mulan PSL v2.
+* You may obtain a copy of Mulan PSL v2 at:
+*          http://license.coscl.org.cn/MulanPSL2
+*
+* THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+* EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+* MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+*
+* See the Mulan PSL v2 for more details.
+***************************************************************************************/
+
+
+#ifndef __CPU_COVERAGE_H__
+#define __CPU_COVERAGE_H__
+
+#include <common.h>
+
+/* The coverage of guest code, kept in bitmaps for each page of code with a
+ * bit for each halfword, which is the start of an instruction. `exec` is set
+ * for the instructions executed, and `taken` and `fall` for the ways they
+ * went, so that both ways of a conditional branch can be told.
+ *
+ * The block engine marks the instructions of a block when it is recorded,
+ * which is when it is first executed, since every instruction before the
+ * last one of a block falls through. Afterwards only the way of the last
+ * one is checked, against the ways the block has already seen. */
+#ifdef CONFIG_COVERAGE
+#define COV_PAGE_SHIFT 12
+#define COV_NR_HALF ((1 << COV_PAGE_SHIFT) / 2)
+
+typedef struct {
+  vaddr_t base;
+  uint8_t exec[COV_NR_HALF / 8];
+  uint8_t taken[COV_NR_HALF / 8];
+  uint8_t fall[COV_NR_HALF / 8];
+} CovPage;
+
+extern bool cov_on;
+// the page marked last time, which is never NULL
+extern CovPage *cov_last;
+
+CovPage* cov_page_slow(vaddr_t base);
+
+static inline CovPage* cov_page(vaddr_t pc) {
+  vaddr_t base = pc & ~(vaddr_t)((1 << COV_PAGE_SHIFT) - 1);
+  return (likely(cov_last->base == base) ? cov_last : cov_page_slow(base));
+}
+
+#define COV_SET(map, pc) \
+  ((map)[((pc) & ((1 << COV_PAGE_SHIFT) - 1)) >> 4] |= 1 << ((((pc) & ((1 << COV_PAGE_SHIFT) - 1)) >> 1) & 7))
+
+// the way taken by the instruction at `pc`
+static inline void cov_branch(vaddr_t pc, bool taken) {
+  CovPage *p = cov_page(pc);
+  if (taken) COV_SET(p->taken, pc);
+  else COV_SET(p->fall, pc);
+}
+
+// called after executing the instruction at `pc`
+static inline void cov_inst(vaddr_t pc, bool taken) {
+  if (!cov_on) return;
+  CovPage *p = cov_page(pc);
+  COV_SET(p->exec, pc);
+  if (taken) COV_SET(p->taken, pc);
+  else COV_SET(p->fall, pc);
+}
+#endif
+
+#endif
@@ -23,6 +23,19 @@ void cpu_exec(uint64_t n);
 void set_nemu_state(int state, vaddr_t pc, int halt_ret);
 void invalid_inst(vaddr_t thispc);
 
+/* serve the semihosting call `op` with the parameter block at `arg`, and
+ * return its result; `arg2` and `arg3` are only used by NEMU's own operations */
+word_t semihost_call(word_t op, word_t arg, word_t arg2, word_t arg3);
+// serve the Linux system call `nr` of the guest in the user mode, and return its result
+word_t user_syscall(word_t nr, word_t a0, word_t a1, word_t a2, word_t a3, word_t a4, word_t a5);
+
+#ifdef CONFIG_MEM_EXCEPTION
+/* Raise the guest exception NO from anywhere inside the execution of an
+ * instruction. The instruction is abandoned without retiring, and the guest
+ * goes to its handler with the pc of the instruction as the return address. */
+__attribute__((noreturn)) void cpu_raise_exception(word_t NO);
+#endif
+
 #define NEMUTRAP(thispc, code) set_nemu_state(NEMU_END, thispc, code)
 #define INV(thispc) invalid_inst(thispc)
 
@@ -23,7 +23,14 @@ typedef struct Decode {
   vaddr_t snpc; // static next pc
   vaddr_t dnpc; // dynamic next pc
   ISADecodeInfo isa;
-  IFDEF(CONFIG_ITRACE, char logbuf[128]);
+#ifdef CONFIG_DECODE_FUSION
+  // the number of instructions the ISA may execute at once, set by the
+  // loop, and then the number executed
+  uint8_t ninst;
+#endif
+#if defined(CONFIG_ITRACE) && !defined(CONFIG_ITRACE_BINARY)
+  char logbuf[128];
+#endif
 } Decode;
 
 // --- pattern matching mechanism ---
@@ -86,8 +93,142 @@ finish:
 }
 
 
+#ifdef CONFIG_INST_STAT
+typedef struct {
+  const char *pat;
+  const char *pattern; // tells patterns of the same name apart
+  uint64_t count;
+  uint64_t taken; // dnpc is not snpc
+#ifdef CONFIG_INST_COST
+  uint64_t cost; // host time spent in the instructions, in COST_UNIT
+#endif
+} InstStat;
+
+#ifdef CONFIG_INST_COST
+// the counter of the pattern executed by the last instruction
+extern InstStat *inst_stat_last;
+#define INSTPAT_COST(stat) (inst_stat_last = &(stat))
+#else
+#define INSTPAT_COST(stat)
+#endif
+
+// the pattern string of the INSTPAT being expanded, for INSTPAT_STAT()
+#define INSTPAT_KEY(pattern) \
+  static const char __instpat_key[] __attribute__((unused)) = pattern
+
+// Count the pattern `name` after executing it. The counter is created at
+// the expansion and collected from its section by inst_stat_report().
+#define INSTPAT_STAT(s, name) do { \
+  static InstStat __stat __attribute__((section("inst_stat"), used, aligned(8))) = \
+    { .pat = str(name), .pattern = __instpat_key }; \
+  __stat.count ++; \
+  __stat.taken += ((s)->dnpc != (s)->snpc); \
+  INSTPAT_COST(__stat); \
+} while (0)
+#else
+#define INSTPAT_KEY(pattern)
+#define INSTPAT_STAT(s, name)
+#endif
+
 // --- pattern matching wrappers for decode ---
+#ifdef CONFIG_INSTPAT_TREE
+// Instead of testing the patterns one by one, the first decoding pass only
+// registers the patterns in the tree below. Each later decoding jumps to the
+// body selected by the bits in INSTPAT_TREE_MASK, which are packed into an
+// index by INSTPAT_TREE_KEY(). Both are provided by the ISA.
+//
+// An ISA whose opcodes are of many lengths provides INSTPAT_TREE_LEVELS
+// instead, the lowest bits of consecutive fields starting from bit 31. The
+// first level is indexed by the first field, and an entry only leads to a
+// table of the next field if the first pattern which may match still tests
+// bits in the next fields.
+#define INSTPAT_TREE_MAX 255 // pattern indices are kept in uint8_t
+
+typedef struct {
+  uint64_t key, mask; // not shifted
+  const void *body;
+  bool exact; // the pattern only tests bits in INSTPAT_TREE_MASK
+} InstPat;
+
+typedef struct {
+  int nr_pat;
+  InstPat pat[INSTPAT_TREE_MAX + 1]; // the last one is the end of decoding
+  union { // NULL before the tree is built
+    uint8_t *first; // index of the first pattern which may match a key
+    uint32_t *node; // the tables of all levels, with entries as below
+  };
+} InstPatTree;
+
+void instpat_tree_add(InstPatTree *t, uint64_t key, uint64_t mask, uint64_t shift, const void *body);
+void instpat_tree_build(InstPatTree *t, uint64_t tree_mask, const void *end);
+void instpat_tree_build_levels(InstPatTree *t, const int *lo, int nr_level, const void *end);
+const void* instpat_tree_check(InstPatTree *t, uint64_t inst, const void *body);
+
+// with INSTPAT_TREE_LEVELS, an entry of `node' is the index of the first
+// pattern which may match, or the offset of the table of the next level
+#define INSTPAT_NODE  0x80000000u // the entry leads to a table of the next level
+#define INSTPAT_CHECK 0x40000000u // the pattern tests bits not in the levels walked
+
+#ifndef INSTPAT_TREE_LEVELS
+static inline const void* instpat_tree_lookup(InstPatTree *t, uint64_t inst, uint32_t key) {
+  InstPat *p = &t->pat[t->first[key]];
+  if (unlikely(!p->exact)) {
+    // only bits in INSTPAT_TREE_MASK are known to match, check the others
+    while (((inst ^ p->key) & p->mask) != 0) p ++;
+  }
+  IFDEF(CONFIG_INSTPAT_TREE_CHECK, return instpat_tree_check(t, inst, p->body));
+  return p->body;
+}
+
+#define INSTPAT_TREE_BUILD(t, end) instpat_tree_build(t, INSTPAT_TREE_MASK, end)
+#define INSTPAT_TREE_LOOKUP(t, inst) instpat_tree_lookup(t, inst, INSTPAT_TREE_KEY(inst))
+#else
+static const int instpat_tree_lo[] = { INSTPAT_TREE_LEVELS };
+
+static inline const void* instpat_tree_lookup_levels(InstPatTree *t, uint64_t inst) {
+  uint32_t e = t->node[BITS(inst, 31, instpat_tree_lo[0])];
+  int l;
+  for (l = 1; e & INSTPAT_NODE; l ++) {
+    e = t->node[(e & ~INSTPAT_NODE) + BITS(inst, instpat_tree_lo[l - 1] - 1, instpat_tree_lo[l])];
+  }
+  InstPat *p = &t->pat[e & ~INSTPAT_CHECK];
+  if (unlikely(e & INSTPAT_CHECK)) {
+    while (((inst ^ p->key) & p->mask) != 0) p ++;
+  }
+  IFDEF(CONFIG_INSTPAT_TREE_CHECK, return instpat_tree_check(t, inst, p->body));
+  return p->body;
+}
+
+#define INSTPAT_TREE_BUILD(t, end) instpat_tree_build_levels(t, instpat_tree_lo, ARRLEN(instpat_tree_lo), end)
+#define INSTPAT_TREE_LOOKUP(t, inst) instpat_tree_lookup_levels(t, inst)
+#endif
+
 #define INSTPAT(pattern, ...) do { \
+  INSTPAT_KEY(pattern); \
+  if (unlikely(__instpat_tree.first == NULL)) { \
+    uint64_t key, mask, shift; \
+    pattern_decode(pattern, STRLEN(pattern), &key, &mask, &shift); \
+    instpat_tree_add(&__instpat_tree, key, mask, shift, &&concat(__instpat_, __LINE__)); \
+  } else { \
+    concat(__instpat_, __LINE__): \
+    INSTPAT_MATCH(s, ##__VA_ARGS__); \
+    goto *(__instpat_end); \
+  } \
+} while (0)
+
+#define INSTPAT_START(name) { \
+  static const void * const __instpat_end = &&concat(__instpat_end_, name); \
+  static InstPatTree __instpat_tree = {}; \
+  if (likely(__instpat_tree.first != NULL)) goto concat(__instpat_dispatch_, name);
+
+#define INSTPAT_END(name) \
+  INSTPAT_TREE_BUILD(&__instpat_tree, __instpat_end); \
+  concat(__instpat_dispatch_, name): \
+  goto *INSTPAT_TREE_LOOKUP(&__instpat_tree, INSTPAT_INST(s)); \
+  concat(__instpat_end_, name): ; }
+#else
+#define INSTPAT(pattern, ...) do { \
+  INSTPAT_KEY(pattern); \
   uint64_t key, mask, shift; \
   pattern_decode(pattern, STRLEN(pattern), &key, &mask, &shift); \
   if ((((uint64_t)INSTPAT_INST(s) >> shift) & mask) == key) { \
@@ -96,7 +237,8 @@ finish:
   } \
 } while (0)
 
-#define INSTPAT_START(name) { const void * __instpat_end = &&concat(__instpat_end_, name);
+#define INSTPAT_START(name) { static const void * const __instpat_end = &&concat(__instpat_end_, name);
 #define INSTPAT_END(name)   concat(__instpat_end_, name): ; }
+#endif
 
 #endif
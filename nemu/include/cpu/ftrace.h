@@ -0,0 +1,60 @@
+/***************************************************************************************
+* Copyright (c) 2014-2024 Zihao Yu, Nanjing University
+*
+* NEMU is licensed under Mulan PSL v2.
+* You can use this software according to the terms and conditions of the Mulan PSL v2.
+* You may obtain a copy of Mulan PSL v2 at:
+*          http://license.coscl.org.cn/MulanPSL2
+*
+* THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+* EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+* MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+*
+* See the Mulan PSL v2 for more details.
+***************************************************************************************/
+
+
+#ifndef __CPU_FTRACE_H__
+#define __CPU_FTRACE_H__
+
+#include <stdint.h>
+
+/* A binary ftrace file, which may be compressed by zlib, is
+ *
+ *   FTraceHeader h;
+ *   struct { uint64_t start, size; uint32_t len; char name[len]; } sym[h.nr_sym];
+ *   FTraceRecord record[];
+ *
+ * in host byte order. It is turned into call trees or folded stacks by
+ * tools/nemu-trace. */
+#define FTRACE_MAGIC "NEMUFTRC"
+
+enum { FTRACE_CALL, FTRACE_RET };
+
+typedef struct {
+  char magic[8];
+  uint32_t word_bytes;
+  uint32_t nr_sym;
+} FTraceHeader;
+
+typedef struct {
+  uint64_t pc;      // of the instruction calling or returning
+  uint64_t nr_inst; // instructions executed before it
+  uint32_t sym;     // the function called or returning
+  uint32_t type;
+} FTraceRecord;
+
+#ifdef CONFIG_FTRACE
+#include <common.h>
+
+extern bool ftrace_on;
+void ftrace_transfer(vaddr_t pc, vaddr_t snpc, vaddr_t dnpc);
+// only instructions transferring control are checked
+#define FTRACE(pc, snpc, dnpc) \
+  do { if (unlikely(ftrace_on) && (dnpc) != (snpc)) ftrace_transfer(pc, snpc, dnpc); } while (0)
+bool ftrace_open(const char *file);
+#else
+#define FTRACE(pc, snpc, dnpc) do { } while (0)
+#endif
+
+#endif
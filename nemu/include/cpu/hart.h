@@ -0,0 +1,47 @@
+/***************************************************************************************
+* Copyright (c) 2014-2024 Zihao Yu, Nanjing University
+*
+* NEMU is licensed under Mulan PSL v2.
+* You can use this software according to the terms and conditions of the Mulan PSL v2.
+* You may obtain a copy of Mulan PSL v2 at:
+*          http://license.coscl.org.cn/MulanPSL2
+*
+* THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+* EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+* MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+*
+* See the Mulan PSL v2 for more details.
+***************************************************************************************/
+
+
+#ifndef __CPU_HART_H__
+#define __CPU_HART_H__
+
+#include <common.h>
+
+/* CONFIG_NR_HART harts share pmem and the devices, and take turns to run
+ * for CONFIG_HART_QUANTUM instructions on the host thread. `cpu` is the
+ * state of the running hart, and the others are kept aside. Only hart 0
+ * runs from reset, the others are parked until the guest starts them with
+ * the hart controller. With CONFIG_HART_THREAD, the harts run at once on
+ * host threads of their own instead, each with `cpu`, the decode cache and
+ * the TLB local to its thread. */
+#ifdef CONFIG_MULTI_HART
+void init_hart();
+int hart_current();
+// start the parked hart `id` from `pc` with the stack pointer at `sp`
+void hart_start(int id, vaddr_t pc, word_t sp);
+// called by the execution loop around each run of at most `n` instructions
+uint64_t hart_limit(uint64_t n);
+void hart_advance(uint64_t n);
+void hart_display();
+#ifdef CONFIG_HART_THREAD
+// called by cpu_exec() before and after running hart 0
+void hart_resume();
+void hart_pause();
+// called when a page cached by the decode cache is written
+void hart_code_written();
+#endif
+#endif
+
+#endif
@@ -0,0 +1,66 @@
+/***************************************************************************************
+* Copyright (c) 2014-2024 Zihao Yu, Nanjing University
+*
+* NEMU is licensed under Mulan PSL v2.
+* You can use this software according to the terms and conditions of the Mulan PSL v2.
+* You may obtain a copy of Mulan PSL v2 at:
+*          http://license.coscl.org.cn/MulanPSL2
+*
+* THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+* EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+* MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+*
+* See the Mulan PSL v2 for more details.
+***************************************************************************************/
+
+
+#ifndef __CPU_ITRACE_H__
+#define __CPU_ITRACE_H__
+
+#include <stdint.h>
+
+/* A binary itrace file starts with a header telling how to disassemble the
+ * records, followed by a plain array of records in host byte order, and
+ * the whole file may be compressed by zlib. It is decoded by
+ * tools/nemu-trace. */
+#define ITRACE_MAGIC "NEMUITRC"
+
+// x86: the bytes are shown in memory order, and disassembled at the next pc
+#define ITRACE_FLAG_X86 1
+
+typedef struct {
+  char magic[8];
+  uint32_t cs_arch, cs_mode, cs_syntax; // for capstone, cs_syntax is 0 if not set
+  uint32_t word_bytes;
+  uint32_t flags;
+} ITraceHeader;
+
+typedef struct {
+  uint64_t pc;
+  uint8_t ilen;
+  uint8_t inst[15];
+} ITraceRecord;
+
+#ifdef CONFIG_ITRACE_BINARY
+#include <common.h>
+
+#define ITRACE_RING_SIZE 65536
+
+extern ITraceRecord itrace_ring[ITRACE_RING_SIZE];
+extern uint64_t itrace_nr;
+void itrace_flush();
+
+static inline void itrace_record(vaddr_t pc, int ilen, const void *inst) {
+  ITraceRecord *r = &itrace_ring[itrace_nr % ITRACE_RING_SIZE];
+  r->pc = pc;
+  r->ilen = ilen;
+  memcpy(r->inst, inst, MUXDEF(CONFIG_ISA_x86, sizeof(r->inst), 4));
+  if (++ itrace_nr % (ITRACE_RING_SIZE / 2) == 0) itrace_flush();
+}
+
+bool itrace_open(const char *file);
+// disassemble the last `n` records into the log
+void itrace_dump(int n);
+#endif
+
+#endif
@@ -0,0 +1,35 @@
+/***************************************************************************************
+* Copyright (c) 2014-2024 Zihao Yu, Nanjing University
+*
+* NEMU is licensed under Mulan PSL v2.
+* You can use this software according to the terms and conditions of the Mulan PSL v2.
+* You may obtain a copy of Mulan PSL v2 at:
+*          http://license.coscl.org.cn/MulanPSL2
+*
+* THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+* EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+* MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+*
+* See the Mulan PSL v2 for more details.
+***************************************************************************************/
+
+#ifndef __CPU_LOCKSTEP_H__
+#define __CPU_LOCKSTEP_H__
+
+#include <common.h>
+
+/* With --lockstep=FAULTS, the image is run by a golden instance and by an
+ * instance for each fault in FAULTS, which take turns every
+ * CONFIG_LOCKSTEP_QUANTUM instructions. Each instance has its own registers
+ * and pmem, and they share everything else, including the decode cache. */
+#ifdef CONFIG_LOCKSTEP
+void lockstep_set_faults(const char *file);
+// return false if not in the lockstep mode
+bool lockstep_run();
+// called when instructions are cached from `page` written by an instance
+void lockstep_private_code(paddr_t page);
+// called on an access out of pmem, which ends the running instance as a crash
+void lockstep_crash();
+#endif
+
+#endif
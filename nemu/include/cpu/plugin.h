@@ -0,0 +1,36 @@
+/***************************************************************************************
+* Copyright (c) 2014-2024 Zihao Yu, Nanjing University
+*
+* NEMU is licensed under Mulan PSL v2.
+* You can use this software according to the terms and conditions of the Mulan PSL v2.
+* You may obtain a copy of Mulan PSL v2 at:
+*          http://license.coscl.org.cn/MulanPSL2
+*
+* THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+* EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+* MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+*
+* See the Mulan PSL v2 for more details.
+***************************************************************************************/
+
+#ifndef __CPU_PLUGIN_H__
+#define __CPU_PLUGIN_H__
+
+#include <common.h>
+
+/* The side of NEMU of the plugins in nemu-plugin.h. The execution loop
+ * tells the start and the end of each instruction, and the memory accesses
+ * traced by MTRACE() are passed to plugin_mem() while `plugin_mem_on`. */
+#ifdef CONFIG_PLUGIN
+extern bool plugin_on; // some plugin wants blocks
+extern bool plugin_mem_on; // the instruction running has memory hooks
+
+bool plugin_load(const char *spec);
+void plugin_insn_start(vaddr_t pc);
+void plugin_insn_end(vaddr_t pc, int len, const void *data, bool jump);
+void plugin_mem(paddr_t addr, int len, bool is_write);
+// drop the blocks with instructions in `page`, since it is written
+void plugin_flush_page(paddr_t page);
+#endif
+
+#endif
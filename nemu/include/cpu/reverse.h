@@ -0,0 +1,40 @@
+/***************************************************************************************
+* Copyright (c) 2014-2024 Zihao Yu, Nanjing University
+*
+* NEMU is licensed under Mulan PSL v2.
+* You can use this software according to the terms and conditions of the Mulan PSL v2.
+* You may obtain a copy of Mulan PSL v2 at:
+*          http://license.coscl.org.cn/MulanPSL2
+*
+* THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+* EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+* MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+*
+* See the Mulan PSL v2 for more details.
+***************************************************************************************/
+
+
+#ifndef __CPU_REVERSE_H__
+#define __CPU_REVERSE_H__
+
+#include <common.h>
+
+/* Checkpoints are taken every CONFIG_REVERSE_INTERVAL instructions, and
+ * going back in time restores the nearest checkpoint before the target and
+ * replays the instructions from there, with the inputs of devices recorded
+ * by DEVICE_INPUT(). Positions in time count the instructions executed
+ * since reverse_reset(). */
+#ifdef CONFIG_REVERSE
+// called by the execution loop around each run of at most `n` instructions
+uint64_t reverse_limit(uint64_t n);
+void reverse_advance(uint64_t n);
+
+void reverse_reset();
+uint64_t reverse_icount();
+// return false if nothing is executed
+bool reverse_step(uint64_t n);
+bool reverse_continue();
+void reverse_display();
+#endif
+
+#endif
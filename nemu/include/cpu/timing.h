@@ -0,0 +1,65 @@
+/***************************************************************************************
+* Copyright (c) 2014-2024 Zihao Yu, Nanjing University
+*
+* NEMU is licensed under Mulan PSL v2.
+* You can use this software according to the terms and conditions of the Mulan PSL v2.
+* You may obtain a copy of Mulan PSL v2 at:
+*          http://license.coscl.org.cn/MulanPSL2
+*
+* THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+* EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+* MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+*
+* See the Mulan PSL v2 for more details.
+***************************************************************************************/
+
+#ifndef __CPU_TIMING_H__
+#define __CPU_TIMING_H__
+
+#include <common.h>
+
+/* A first-order timing model, which annotates the functional execution
+ * with cycles. Each instruction takes CONFIG_TIMING_LAT_BASE cycles, and
+ * loads and stores take their latencies on top of it. Data accesses go
+ * through a direct-mapped cache indexed by the virtual address, and a
+ * miss adds CONFIG_TIMING_MISS_PENALTY. A taken control transfer whose
+ * target differs from the one last seen at its pc in a direct-mapped
+ * branch target buffer adds CONFIG_TIMING_JUMP_PENALTY. Instruction
+ * fetches and devices take no extra cycles. */
+#ifdef CONFIG_TIMING
+#define TIMING_LINE_SHIFT 6
+#define TIMING_NR_LINE ((CONFIG_TIMING_CACHE_KB * 1024) >> TIMING_LINE_SHIFT)
+#define TIMING_NR_BTB 1024
+
+extern uint64_t timing_cycle;
+extern vaddr_t timing_tag[TIMING_NR_LINE];
+extern vaddr_t timing_btb[TIMING_NR_BTB];
+
+static inline void timing_mem(vaddr_t addr, bool is_write) {
+  vaddr_t line = addr >> TIMING_LINE_SHIFT;
+  vaddr_t *tag = &timing_tag[line % TIMING_NR_LINE];
+  timing_cycle += (is_write ? CONFIG_TIMING_LAT_STORE : CONFIG_TIMING_LAT_LOAD);
+  // tags hold line + 1, so that 0 stands for an invalid line
+  if (unlikely(*tag != line + 1)) {
+    *tag = line + 1;
+    timing_cycle += CONFIG_TIMING_MISS_PENALTY;
+  }
+}
+
+// called after executing the instruction at `pc`, which goes to `dnpc`
+static inline void timing_inst(vaddr_t pc, vaddr_t snpc, vaddr_t dnpc) {
+  timing_cycle += CONFIG_TIMING_LAT_BASE;
+  if (dnpc == snpc) return;
+  vaddr_t *target = &timing_btb[(pc >> 2) % TIMING_NR_BTB];
+  if (unlikely(*target != dnpc)) {
+    *target = dnpc;
+    timing_cycle += CONFIG_TIMING_JUMP_PENALTY;
+  }
+}
+
+#define TIMING_MEM(addr, is_write) timing_mem(addr, is_write)
+#else
+#define TIMING_MEM(addr, is_write)
+#endif
+
+#endif
@@ -20,16 +20,32 @@
 #include <stdio.h>
 #include <utils.h>
 
-#define Log(format, ...) \
-    _Log(ANSI_FMT("[%s:%d %s] " format, ANSI_FG_BLUE) "\n", \
-        __FILE__, __LINE__, __func__, ## __VA_ARGS__)
+/* A message above CONFIG_LOG_LEVEL is compiled out, and one above the level
+ * set by --log-level is skipped at runtime. */
+#define LOG_WARN  1
+#define LOG_INFO  2
+#define LOG_DEBUG 3
+
+extern int log_level;
+
+#define Log_at(level, color, format, ...) \
+  do { \
+    if ((level) <= CONFIG_LOG_LEVEL && (level) <= log_level) \
+      _Log(ANSI_FMT("[%s:%d %s] " format, color) "\n", \
+          __FILE__, __LINE__, __func__, ## __VA_ARGS__); \
+  } while (0)
+
+#define Log(format, ...) Log_at(LOG_INFO, ANSI_FG_BLUE, format, ## __VA_ARGS__)
+#define Log_warn(format, ...) Log_at(LOG_WARN, ANSI_FG_YELLOW, format, ## __VA_ARGS__)
+#define Log_debug(format, ...) Log_at(LOG_DEBUG, ANSI_FG_CYAN, format, ## __VA_ARGS__)
 
 #define Assert(cond, format, ...) \
   do { \
     if (!(cond)) { \
       MUXDEF(CONFIG_TARGET_AM, printf(ANSI_FMT(format, ANSI_FG_RED) "\n", ## __VA_ARGS__), \
         (fflush(stdout), fprintf(stderr, ANSI_FMT(format, ANSI_FG_RED) "\n", ##  __VA_ARGS__))); \
-      IFNDEF(CONFIG_TARGET_AM, extern FILE* log_fp; fflush(log_fp)); \
+      IFNDEF(CONFIG_TARGET_AM, MUXDEF(CONFIG_LOG_ASYNC, log_flush(), \
+        extern FILE* log_fp; fflush(log_fp))); \
       extern void assert_fail_msg(); \
       assert_fail_msg(); \
       assert(cond); \
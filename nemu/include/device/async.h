@@ -0,0 +1,30 @@
+/***************************************************************************************
+* Copyright (c) 2014-2024 Zihao Yu, Nanjing University
+*
+* NEMU is licensed under Mulan PSL v2.
+* You can use this software according to the terms and conditions of the Mulan PSL v2.
+* You may obtain a copy of Mulan PSL v2 at:
+*          http://license.coscl.org.cn/MulanPSL2
+*
+* THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+* EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+* MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+*
+* See the Mulan PSL v2 for more details.
+***************************************************************************************/
+
+#ifndef __DEVICE_ASYNC_H__
+#define __DEVICE_ASYNC_H__
+
+/* Long operations of devices run on a pool of host threads. `work` runs on
+ * a worker, and must only touch the host resources and the guest memory
+ * handed to it. `done` runs later on the CPU thread, when the completions
+ * are reaped by device_update() or dev_async_reap(), to update the
+ * registers of the device and raise the interrupt. The workers are only
+ * created by the first operation, so that NEMU stays single-threaded, e.g.
+ * for snapshots, until then. */
+typedef void (*dev_work_t)(void *arg);
+void dev_async(dev_work_t work, dev_work_t done, void *arg);
+void dev_async_reap();
+
+#endif
@@ -0,0 +1,42 @@
+/***************************************************************************************
+* Copyright (c) 2014-2024 Zihao Yu, Nanjing University
+*
+* NEMU is licensed under Mulan PSL v2.
+* You can use this software according to the terms and conditions of the Mulan PSL v2.
+* You may obtain a copy of Mulan PSL v2 at:
+*          http://license.coscl.org.cn/MulanPSL2
+*
+* THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+* EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+* MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+*
+* See the Mulan PSL v2 for more details.
+***************************************************************************************/
+
+#ifndef __DEVICE_EVENT_H__
+#define __DEVICE_EVENT_H__
+
+#include <common.h>
+
+/* Events of devices scheduled at a time in the future, which are kept in a
+ * min-heap by their deadlines in guest instructions. The CPU loop counts
+ * down the instructions to the earliest deadline, and only then calls
+ * device_update(), which runs the events due. A delay is given in us, and
+ * turned into instructions by CONFIG_TIMER_VIRTUAL_MIPS in virtual time, or
+ * by the speed measured so far in host time, where an event found early by
+ * the host clock is put off for the rest of its delay. Each device keeps
+ * its own events at its own pace, one-shot or periodic, so a device with
+ * nothing to do is never called. */
+typedef void (*dev_event_t)(void *arg);
+// return the id of a new event, which is not scheduled
+int dev_event_new(const char *name, dev_event_t handler, void *arg);
+// run the event once `delay_us` later, replacing the deadline if it is pending
+void dev_event_schedule(int id, uint64_t delay_us);
+/* Run the event every `period_us` from now on. It keeps the pace without
+ * catching up with the periods missed, e.g. while stopping in sdb. */
+void dev_event_periodic(int id, uint64_t period_us);
+void dev_event_cancel(int id);
+// run the events due, called when the countdown of the CPU loop runs out
+void device_update();
+
+#endif
@@ -19,15 +19,35 @@
 #include <cpu/difftest.h>
 
 typedef void(*io_callback_t)(uint32_t, int, bool);
+typedef void(*io_init_t)();
 uint8_t* new_space(int size);
+uint8_t* new_space_aligned(int size, int align);
+// return the i-th space allocated, or NULL if there is not
+uint8_t* io_space_get(int i, size_t *size);
 
-typedef struct {
+/* Defer the costly part of initializing a device, such as opening a host
+ * file, to the first access of any map of `space`, so that images never
+ * touching the device do not pay for it. It is set before adding the maps. */
+void io_space_set_init(void *space, io_init_t init);
+// the initialization deferred for `space`, or NULL if there is none
+io_init_t io_space_get_init(void *space);
+// run the initialization deferred for `space`, if it has not run
+void io_space_init(void *space);
+
+typedef struct IOMap {
   const char *name;
   // we treat ioaddr_t as paddr_t here
   paddr_t low;
   paddr_t high;
   void *space;
   io_callback_t callback;
+  io_init_t init; // run by the first access, then cleared
+#ifdef CONFIG_LIVE
+  int live_id; // the index of the live counters
+#endif
+#ifdef CONFIG_INST_COST
+  uint64_t nr_access, cost; // host time spent in the accesses, in COST_UNIT
+#endif
 } IOMap;
 
 static inline bool map_inside(IOMap *map, paddr_t addr) {
@@ -53,4 +73,16 @@ void add_mmio_map(const char *name, paddr_t addr,
 word_t map_read(paddr_t addr, int len, IOMap *map);
 void map_write(paddr_t addr, int len, word_t data, IOMap *map);
 
+/* The harts running on several host threads access the devices one at a
+ * time, including the events updating them. */
+#ifdef CONFIG_HART_THREAD
+#include <pthread.h>
+extern pthread_mutex_t device_lock;
+#define DEVICE_LOCK()   pthread_mutex_lock(&device_lock)
+#define DEVICE_UNLOCK() pthread_mutex_unlock(&device_lock)
+#else
+#define DEVICE_LOCK()
+#define DEVICE_UNLOCK()
+#endif
+
 #endif
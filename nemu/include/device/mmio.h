@@ -20,5 +20,7 @@
 
 word_t mmio_read(paddr_t addr, int len);
 void mmio_write(paddr_t addr, int len, word_t data);
+// whether an MMIO map covers `addr`, without telling difftest to skip
+bool mmio_map_exists(paddr_t addr);
 
 #endif
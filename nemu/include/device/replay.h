@@ -0,0 +1,58 @@
+/***************************************************************************************
+* Copyright (c) 2014-2024 Zihao Yu, Nanjing University
+*
+* NEMU is licensed under Mulan PSL v2.
+* You can use this software according to the terms and conditions of the Mulan PSL v2.
+* You may obtain a copy of Mulan PSL v2 at:
+*          http://license.coscl.org.cn/MulanPSL2
+*
+* THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+* EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+* MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+*
+* See the Mulan PSL v2 for more details.
+***************************************************************************************/
+
+
+#ifndef __DEVICE_REPLAY_H__
+#define __DEVICE_REPLAY_H__
+
+#include <common.h>
+
+/* Values the guest reads from the host, such as the time, the keys pressed
+ * and the serial input, are recorded for reverse execution, and the values
+ * recorded are returned instead when the instructions are replayed, so that
+ * replaying is deterministic. The host is not read while replaying. */
+#ifdef CONFIG_INPUT_LOG
+/* With --input-record, each value read from the host and each interrupt
+ * raised by a device are also logged to a file with the instruction count
+ * they come at. With --input-replay, the values are taken from the file in
+ * order, and the interrupts are raised at the counts logged instead of by
+ * the devices, until the file ends. */
+extern bool input_replaying;
+
+uint64_t input_log_value(uint64_t value);
+uint64_t input_log_next();
+void input_log_intr();
+#define HOST_INPUT(expr) (input_replaying ? input_log_next() : input_log_value(expr))
+#define DEVICE_INTR(stmt) do { if (!input_replaying) { input_log_intr(); stmt; } } while (0)
+#else
+#define HOST_INPUT(expr) (expr)
+#define DEVICE_INTR(stmt) stmt
+#endif
+
+#ifdef CONFIG_REVERSE
+/* set while reverse execution replays the instructions up to a point in the
+ * past, during which the output of devices is dropped, and breakpoints and
+ * watchpoints stop the execution without being reported */
+extern bool reverse_replaying;
+
+bool replay_pending();
+uint64_t replay_input();
+uint64_t record_input(uint64_t value);
+#define DEVICE_INPUT(expr) (replay_pending() ? replay_input() : record_input(HOST_INPUT(expr)))
+#else
+#define DEVICE_INPUT(expr) HOST_INPUT(expr)
+#endif
+
+#endif
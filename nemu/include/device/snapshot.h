@@ -0,0 +1,38 @@
+/***************************************************************************************
+* Copyright (c) 2014-2024 Zihao Yu, Nanjing University
+*
+* NEMU is licensed under Mulan PSL v2.
+* You can use this software according to the terms and conditions of the Mulan PSL v2.
+* You may obtain a copy of Mulan PSL v2 at:
+*          http://license.coscl.org.cn/MulanPSL2
+*
+* THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+* EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+* MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+*
+* See the Mulan PSL v2 for more details.
+***************************************************************************************/
+
+
+#ifndef __DEVICE_SNAPSHOT_H__
+#define __DEVICE_SNAPSHOT_H__
+
+#include <common.h>
+
+/* A device keeping state outside its registers and the memory returned by
+ * new_space() registers a hook, which is called with a snapshot being saved
+ * or loaded. The hook passes its state in the same order either way with
+ * snapshot_io(), which copies the state in or out of the snapshot.
+ * Checkpoints of reverse execution are also snapshots, for which the
+ * inputs from the host, such as the time and the keys pressed, are
+ * replayed instead, and should not be restored. */
+typedef struct Snapshot Snapshot;
+typedef void (*snapshot_hook_t)(Snapshot *s);
+void snapshot_register(const char *name, snapshot_hook_t hook);
+void snapshot_io(Snapshot *s, void *buf, size_t len);
+bool snapshot_is_load(Snapshot *s);
+bool snapshot_is_replay(Snapshot *s);
+
+#define SNAPSHOT_VAR(s, x) snapshot_io(s, &(x), sizeof(x))
+
+#endif
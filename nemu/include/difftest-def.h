@@ -23,14 +23,23 @@
 #define __EXPORT __attribute__((visibility("default")))
 enum { DIFFTEST_TO_DUT, DIFFTEST_TO_REF };
 
+/* difftest_regcpy() copies the first DIFFTEST_REG_SIZE bytes of CPU_state,
+ * which every ISA keeps in the order listed below. REF exports the version
+ * of this view as `difftest_reg_version`, bump it when the view changes. */
+#define DIFFTEST_REG_VERSION 2
+
 #if defined(CONFIG_ISA_x86)
-# define DIFFTEST_REG_SIZE (sizeof(uint32_t) * 9) // GPRs + pc
+# define DIFFTEST_REG_SIZE (sizeof(uint32_t) * 10) // GPRs + pc + eflags
 #elif defined(CONFIG_ISA_mips32)
 # define DIFFTEST_REG_SIZE (sizeof(uint32_t) * 38) // GPRs + status + lo + hi + badvaddr + cause + pc
 #elif defined(CONFIG_ISA_riscv)
 #define RISCV_GPR_TYPE MUXDEF(CONFIG_RV64, uint64_t, uint32_t)
 #define RISCV_GPR_NUM  MUXDEF(CONFIG_RVE , 16, 32)
-#define DIFFTEST_REG_SIZE (sizeof(RISCV_GPR_TYPE) * (RISCV_GPR_NUM + 1)) // GPRs + pc
+typedef struct {
+  RISCV_GPR_TYPE gpr[RISCV_GPR_NUM];
+  RISCV_GPR_TYPE pc;
+} riscv_DiffRegs;
+#define DIFFTEST_REG_SIZE sizeof(riscv_DiffRegs) // GPRs + pc
 #elif defined(CONFIG_ISA_loongarch32r)
 # define DIFFTEST_REG_SIZE (sizeof(uint32_t) * 33) // GPRs + pc
 #else
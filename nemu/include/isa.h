@@ -27,20 +27,36 @@ typedef concat(__GUEST_ISA__, _ISADecodeInfo) ISADecodeInfo;
 // monitor
 extern unsigned char isa_logo[];
 void init_isa();
+// tell the hart started that its id is `id`, and set its stack pointer to `sp`
+void isa_hart_init(int id, word_t sp);
 
 // reg
-extern CPU_state cpu;
+extern HART_LOCAL CPU_state cpu;
 void isa_reg_display();
 word_t isa_reg_str2val(const char *name, bool *success);
 
 // exec
 struct Decode;
 int isa_exec_once(struct Decode *s);
+void isa_flush_decode_cache(paddr_t page);
+#ifdef CONFIG_ENGINE_BLOCK
+/* The instructions of a block are kept as copies of the decode cache, and
+ * run again without looking them up. isa_block_save() saves the instruction
+ * just executed by isa_exec_once(), and fails if it is not cached. A block
+ * ends with an instruction for which isa_block_end() is true. */
+typedef concat(__GUEST_ISA__, _DecodeCacheEntry) BlockInst;
+bool isa_block_save(struct Decode *s, BlockInst *bi);
+bool isa_block_end(const BlockInst *bi);
+int isa_block_exec(struct Decode *s, const BlockInst *bi);
+#endif
 
 // memory
 enum { MMU_DIRECT, MMU_TRANSLATE, MMU_FAIL };
 enum { MEM_TYPE_IFETCH, MEM_TYPE_READ, MEM_TYPE_WRITE };
 enum { MEM_RET_OK, MEM_RET_FAIL, MEM_RET_CROSS_PAGE };
+// or'ed into MEM_RET_OK if the translation is the same for the whole
+// superpage of SUPERPAGE_SIZE containing the address, such as a megapage
+#define MEM_RET_SUPERPAGE 0x100
 #ifndef isa_mmu_check
 int isa_mmu_check(vaddr_t vaddr, int len, int type);
 #endif
@@ -48,10 +64,27 @@ paddr_t isa_mmu_translate(vaddr_t vaddr, int len, int type);
 
 // interrupt/exception
 vaddr_t isa_raise_intr(word_t NO, vaddr_t epc);
+#ifdef CONFIG_MEM_EXCEPTION
+// the exception of an access of `type` to `addr` failing by a page fault or
+// not, where the ISA also records `addr` as the faulting address
+word_t isa_mem_exception(vaddr_t addr, int type, bool page_fault);
+#endif
 #define INTR_EMPTY ((word_t)-1)
 word_t isa_query_intr();
+// non-zero if an interrupt may be taken, which is or'ed with INTR_DEV by a
+// device raising one, and with INTR_ISA by the ISA when its state enables
+// one; cleared once an interrupt is taken
+extern uint32_t intr_pending;
+#define INTR_DEV 1
+#define INTR_ISA 2
 
 // difftest
+#ifndef isa_sync_regs
+// bring the registers in the view of difftest up to date in the CPU_state
+// `s` before it is read or written as bytes, for ISAs computing some of them
+// lazily
+#define isa_sync_regs(s)
+#endif
 bool isa_difftest_checkregs(CPU_state *ref_r, vaddr_t pc);
 void isa_difftest_attach();
 
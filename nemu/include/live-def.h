@@ -0,0 +1,66 @@
+/***************************************************************************************
+* Copyright (c) 2014-2024 Zihao Yu, Nanjing University
+*
+* NEMU is licensed under Mulan PSL v2.
+* You can use this software according to the terms and conditions of the Mulan PSL v2.
+* You may obtain a copy of Mulan PSL v2 at:
+*          http://license.coscl.org.cn/MulanPSL2
+*
+* THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+* EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+* MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+*
+* See the Mulan PSL v2 for more details.
+***************************************************************************************/
+
+
+#ifndef __LIVE_DEF_H__
+#define __LIVE_DEF_H__
+
+#include <stdint.h>
+
+/* The counters of a running NEMU, published in the shared memory named
+ * LIVE_SHM_PREFIX followed by its pid, i.e. /dev/shm/nemu-live-PID, and
+ * shown by tools/nemu-top. NEMU is the only writer, and every field is
+ * accessed with relaxed atomics, so that neither side takes a lock. */
+#define LIVE_SHM_PREFIX "/nemu-live-"
+#define LIVE_MAGIC "NEMULIVE"
+#define LIVE_VERSION 2
+#define LIVE_NR_DEV 16 // the devices after these are counted in the last one
+#define LIVE_NAME_LEN 16
+#define LIVE_NR_MEM 16
+
+enum { LIVE_IFETCH, LIVE_READ, LIVE_WRITE, LIVE_NR_TLB };
+
+typedef struct {
+  char magic[8];
+  uint32_t version;
+  uint32_t state;        // nemu_state.state
+  uint64_t update_ns;    // CLOCK_MONOTONIC of the last update
+  uint64_t guest_inst;
+  uint64_t inst_per_sec; // in the last interval
+  uint64_t difftest_step;
+  uint64_t tlb_hit[LIVE_NR_TLB], tlb_miss[LIVE_NR_TLB];
+  uint64_t decode_miss;  // instructions not found in the decode cache
+  uint32_t nr_dev;
+  uint32_t pad;
+  struct {
+    char name[LIVE_NAME_LEN];
+    uint64_t read, write;
+  } dev[LIVE_NR_DEV];
+  // host memory of each subsystem with CONFIG_FOOTPRINT, updated every second
+  uint64_t rss;
+  uint32_t nr_mem;
+  uint32_t pad2;
+  struct {
+    char name[LIVE_NAME_LEN];
+    uint64_t reserved, resident;
+  } mem[LIVE_NR_MEM];
+} LiveCounters;
+
+#define LIVE_LOAD(x) __atomic_load_n(&(x), __ATOMIC_RELAXED)
+#define LIVE_STORE(x, v) __atomic_store_n(&(x), (v), __ATOMIC_RELAXED)
+// without a read-modify-write instruction, since there is only one writer
+#define LIVE_ADD(x, n) LIVE_STORE(x, LIVE_LOAD(x) + (n))
+
+#endif
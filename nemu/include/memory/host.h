@@ -18,22 +18,31 @@
 
 #include <common.h>
 
+// the widths of memory accesses in bytes and bits, used with MAP()
+#define MEM_ACCESS_WIDTH(f) f(1, 8) f(2, 16) f(4, 32) IFDEF(CONFIG_ISA64, f(8, 64))
+
+#define HOST_ACCESS(bytes, bits) \
+  static inline word_t host_read_##bytes(void *addr) { return *(uint##bits##_t *)addr; } \
+  static inline void host_write_##bytes(void *addr, word_t data) { *(uint##bits##_t *)addr = data; }
+
+MAP(MEM_ACCESS_WIDTH, HOST_ACCESS)
+
 static inline word_t host_read(void *addr, int len) {
   switch (len) {
-    case 1: return *(uint8_t  *)addr;
-    case 2: return *(uint16_t *)addr;
-    case 4: return *(uint32_t *)addr;
-    IFDEF(CONFIG_ISA64, case 8: return *(uint64_t *)addr);
+    case 1: return host_read_1(addr);
+    case 2: return host_read_2(addr);
+    case 4: return host_read_4(addr);
+    IFDEF(CONFIG_ISA64, case 8: return host_read_8(addr));
     default: MUXDEF(CONFIG_RT_CHECK, assert(0), return 0);
   }
 }
 
 static inline void host_write(void *addr, int len, word_t data) {
   switch (len) {
-    case 1: *(uint8_t  *)addr = data; return;
-    case 2: *(uint16_t *)addr = data; return;
-    case 4: *(uint32_t *)addr = data; return;
-    IFDEF(CONFIG_ISA64, case 8: *(uint64_t *)addr = data; return);
+    case 1: host_write_1(addr, data); return;
+    case 2: host_write_2(addr, data); return;
+    case 4: host_write_4(addr, data); return;
+    IFDEF(CONFIG_ISA64, case 8: host_write_8(addr, data); return);
     IFDEF(CONFIG_RT_CHECK, default: assert(0));
   }
 }
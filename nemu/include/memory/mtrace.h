@@ -0,0 +1,76 @@
+/***************************************************************************************
+* Copyright (c) 2014-2024 Zihao Yu, Nanjing University
+*
+* NEMU is licensed under Mulan PSL v2.
+* You can use this software according to the terms and conditions of the Mulan PSL v2.
+* You may obtain a copy of Mulan PSL v2 at:
+*          http://license.coscl.org.cn/MulanPSL2
+*
+* THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+* EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+* MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+*
+* See the Mulan PSL v2 for more details.
+***************************************************************************************/
+
+
+#ifndef __MEMORY_MTRACE_H__
+#define __MEMORY_MTRACE_H__
+
+#include <common.h>
+#include <cpu/plugin.h>
+
+/* A record written to the trace file for each traced physical access.
+ * The file is a plain array of records in host byte order. */
+typedef struct {
+  word_t pc;
+  word_t data;
+  paddr_t addr;
+  uint8_t len;
+  uint8_t is_write; // or MTRACE_IFETCH
+} MTraceRecord;
+
+// an instruction fetch, only recorded for the cache simulator
+#define MTRACE_IFETCH 2
+
+// also passes the access to the plugins hooking the instruction
+#define MTRACE(addr, len, data, is_write) do { \
+  IFDEF(CONFIG_MTRACE, if (unlikely(mtrace_on)) mtrace_record(addr, len, data, is_write)); \
+  IFDEF(CONFIG_PLUGIN, if (unlikely(plugin_mem_on)) plugin_mem(addr, len, is_write)); \
+} while (0)
+
+#ifdef CONFIG_MTRACE
+extern bool mtrace_on;
+void mtrace_record(paddr_t addr, int len, word_t data, int is_write);
+
+/* Records go to a ring buffer drained into `file` by a writer thread,
+ * which also feeds the cache simulator if it is on. */
+bool mtrace_start(const char *file);
+void mtrace_stop();
+/* Only accesses inside one of the address ranges and issued inside one of
+ * the PC ranges are traced. An empty set of ranges matches everything. */
+bool mtrace_add_filter(bool is_pc, word_t lo, word_t hi);
+void mtrace_clear_filter();
+void mtrace_display();
+#endif
+
+#ifdef CONFIG_CACHESIM
+extern bool mtrace_ifetch_on;
+// the fetch is recorded at the pc, which is taken as a physical address
+#define MTRACE_FETCH(pc, len) \
+  do { if (unlikely(mtrace_ifetch_on)) mtrace_record(pc, len, 0, MTRACE_IFETCH); } while (0)
+
+/* Feed the accesses in the ring to the caches, configured by `spec`, or
+ * stop feeding them if `spec` is NULL. */
+bool mtrace_cachesim(const char *spec);
+// report the caches after the records in the ring are consumed
+void mtrace_cachesim_report();
+
+bool cachesim_init(const char *spec);
+void cachesim_feed(const MTraceRecord *r, int n);
+void cachesim_report();
+#else
+#define MTRACE_FETCH(pc, len) do { } while (0)
+#endif
+
+#endif
@@ -17,6 +17,7 @@
 #define __MEMORY_PADDR_H__
 
 #include <common.h>
+#include <memory/vaddr.h>
 
 #define PMEM_LEFT  ((paddr_t)CONFIG_MBASE)
 #define PMEM_RIGHT ((paddr_t)CONFIG_MBASE + CONFIG_MSIZE - 1)
@@ -31,7 +32,112 @@ static inline bool in_pmem(paddr_t addr) {
   return addr - CONFIG_MBASE < CONFIG_MSIZE;
 }
 
+#ifdef CONFIG_MEM_CODE_PAGE
+/* one flag per page of pmem, set if instructions in the page are cached
+ * by the decoder or translated. Writing to such a page drops them. */
+extern bool pmem_code_page[];
+void paddr_mark_code(paddr_t paddr);
+#endif
+
+#ifdef CONFIG_WATCHPOINT
+/* one flag per page of pmem, set if a watchpoint is in the page. Only
+ * writes to such pages are checked by the watchpoints. */
+extern bool pmem_watch_page[];
+// set while some watchpoint is checked, which stops right after the
+// instruction writing it, so that the block engine runs them one by one
+extern bool wp_active;
+// the number of watchpoints checked by wp_check_each() after each instruction
+extern int wp_nr_each;
+void wp_check_write(paddr_t addr, size_t len);
+void wp_check_each();
+
+static inline void paddr_check_watch(paddr_t addr, int len) {
+  if (unlikely(pmem_watch_page[(addr - CONFIG_MBASE) >> PAGE_SHIFT] ||
+        pmem_watch_page[(addr + len - 1 - CONFIG_MBASE) >> PAGE_SHIFT])) wp_check_write(addr, len);
+}
+#endif
+
+#ifdef CONFIG_PMEM_DIRTY
+/* one bit per page of pmem, set when the page is written through
+ * paddr_write() or the fast paths bypassing it. Consumers looking for
+ * changes since a point in time clear the bits at that point. */
+extern uint64_t pmem_dirty[];
+
+static inline void paddr_mark_dirty(paddr_t paddr) {
+  uint64_t idx = (paddr - CONFIG_MBASE) >> PAGE_SHIFT;
+  pmem_dirty[idx / 64] |= 1ull << (idx % 64);
+}
+
+static inline bool paddr_is_dirty(paddr_t paddr) {
+  uint64_t idx = (paddr - CONFIG_MBASE) >> PAGE_SHIFT;
+  return (pmem_dirty[idx / 64] >> (idx % 64)) & 1;
+}
+
+/* find the first dirty page at or above `*page` and store it to `*page`,
+ * return false if there is none */
+bool paddr_next_dirty(paddr_t *page);
+/* clear the dirty bits of the pages in [addr, addr + size) */
+void paddr_clear_dirty(paddr_t addr, size_t size);
+#endif
+
+/* The region table has an entry for each physical page below 4GiB. `host`
+ * is set if the page can be accessed directly, i.e. it belongs to pmem, or
+ * it is covered by a single MMIO map without callback. `map` is set if the
+ * page is covered by a single MMIO map. Other pages, including those shared
+ * by several maps, fall back to mmio_read() and mmio_write(). */
+struct IOMap;
+void paddr_set_region(paddr_t page, uint8_t *host, struct IOMap *map);
+/* return the host address of `page` if it can be accessed directly, and
+ * whether it belongs to an MMIO map instead of pmem */
+uint8_t* paddr_host_page(paddr_t page, bool *is_io);
+
+#ifdef CONFIG_PMEM_MMAP
+/* map `size` bytes of file `fd` to pmem at `addr` copy-on-write,
+ * return false if this is not possible */
+bool pmem_map_file(paddr_t addr, int fd, size_t size);
+/* map the memory file `fd`, e.g. from paddr_pmem_clone(), to pmem in place
+ * and shared, so that the host addresses of pmem kept by the region table
+ * and the TLB stay valid */
+void paddr_pmem_switch(int fd);
+/* back pmem by a memory file holding its content now, mapped copy-on-write,
+ * return false if this is not possible */
+bool paddr_pmem_freeze();
+/* bring [addr, addr + size) of pmem back to the content when it was frozen,
+ * at the cost of the pages written since; `addr` is aligned to a page */
+void paddr_pmem_restore(paddr_t addr, size_t size);
+#endif
+
+/* return true if the page at `page` is filled with a single byte, which is
+ * stored to `*byte` */
+bool paddr_page_blank(paddr_t page, uint8_t *byte);
+/* fill pmem with `byte`, and give the pages committed back to the host if
+ * possible; the caller calls paddr_host_written() after writing pmem */
+void paddr_fill(uint8_t byte);
+
+#ifdef CONFIG_LOCKSTEP
+/* copy pmem into a new memory file, and return its fd */
+int paddr_pmem_clone();
+#endif
+
+/* called before a system call of the host reads or writes [addr, addr + len)
+ * of pmem through guest_to_host(), which fails with EFAULT on lazy pmem not
+ * touched yet */
+void paddr_host_access(paddr_t addr, size_t len);
+/* called after a device writes [addr, addr + len) of pmem through
+ * guest_to_host(), so that it is handled like a store by the guest */
+void paddr_host_written(paddr_t addr, size_t len);
+/* called after an atomic instruction writes pmem through guest_to_host(),
+ * which REF executes by itself */
+void paddr_atomic_written(paddr_t addr, int len);
+
+word_t paddr_ifetch(paddr_t addr, int len);
 word_t paddr_read(paddr_t addr, int len);
 void paddr_write(paddr_t addr, int len, word_t data);
 
+/* paddr_read_1(), paddr_write_4(), etc. for accesses of a fixed width */
+#define PADDR_ACCESS_DECL(bytes, bits) \
+  word_t paddr_read_##bytes(paddr_t addr); \
+  void paddr_write_##bytes(paddr_t addr, word_t data);
+MAP(MEM_ACCESS_WIDTH, PADDR_ACCESS_DECL)
+
 #endif
@@ -17,13 +17,42 @@
 #define __MEMORY_VADDR_H__
 
 #include <common.h>
+#include <memory/host.h>
 
 word_t vaddr_ifetch(vaddr_t addr, int len);
 word_t vaddr_read(vaddr_t addr, int len);
 void vaddr_write(vaddr_t addr, int len, word_t data);
 
+/* vaddr_read_1(), vaddr_write_4(), etc. for accesses of a fixed width,
+ * which keep the size dispatch out of the fast path */
+#define VADDR_ACCESS_DECL(bytes, bits) \
+  word_t vaddr_read_##bytes(vaddr_t addr); \
+  void vaddr_write_##bytes(vaddr_t addr, word_t data);
+MAP(MEM_ACCESS_WIDTH, VADDR_ACCESS_DECL)
+
+/* The soft TLB caches translations done by isa_mmu_translate(). The ISA
+ * should flush it whenever they may change, i.e. on writing to the register
+ * of the page table base (such as satp) and on fences (such as sfence.vma).
+ *
+ * With a TLB managed by software, as on mips32 and loongarch32r, it is a
+ * cache in front of the TLB of the guest, whose search is then only done on
+ * its misses. Writing a TLB entry (tlbwi, tlbwr, tlbfill) flushes the range
+ * of the entry replaced, the new one can only add translations, while a
+ * change of the ASID in EntryHi or ASID and invtlb flush it all. Since only
+ * the translations succeeding are cached, isa_mmu_translate() still raises
+ * the refill exceptions exactly when the TLB of the guest misses. */
+void vaddr_tlb_flush();
+// flush the translations of the pages in [addr, addr + size)
+void vaddr_tlb_flush_range(vaddr_t addr, word_t size);
+void vaddr_tlb_display();
+
 #define PAGE_SHIFT        12
 #define PAGE_SIZE         (1ul << PAGE_SHIFT)
 #define PAGE_MASK         (PAGE_SIZE - 1)
 
+// the smallest superpage, which is a megapage of Sv32 or of Sv39
+#define SUPERPAGE_SHIFT   MUXDEF(CONFIG_ISA64, 21, 22)
+#define SUPERPAGE_SIZE    (1ul << SUPERPAGE_SHIFT)
+#define SUPERPAGE_MASK    (SUPERPAGE_SIZE - 1)
+
 #endif
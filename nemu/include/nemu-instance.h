@@ -0,0 +1,51 @@
+/***************************************************************************************
+* Copyright (c) 2014-2024 Zihao Yu, Nanjing University
+*
+* NEMU is licensed under Mulan PSL v2.
+* You can use this software according to the terms and conditions of the Mulan PSL v2.
+* You may obtain a copy of Mulan PSL v2 at:
+*          http://license.coscl.org.cn/MulanPSL2
+*
+* THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+* EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+* MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+*
+* See the Mulan PSL v2 for more details.
+***************************************************************************************/
+
+#ifndef __NEMU_INSTANCE_H__
+#define __NEMU_INSTANCE_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Instances of NEMU in the shared library built with TARGET_SHARE. Each
+ * instance is a copy of the library loaded by dlmopen() into a namespace of
+ * its own, with its own registers, pmem, devices and counters, so that the
+ * instances are independent and can run in different threads at the same
+ * time. glibc provides 16 namespaces, one of which is taken by the host
+ * program, so at most 15 instances exist at a time.
+ */
+typedef struct NEMU NEMU;
+
+// create an instance at reset with the built-in image, or NULL on failure
+NEMU *nemu_create();
+void nemu_destroy(NEMU *nemu);
+
+// copy `size` bytes between `buf` and pmem of the instance at `addr`
+void nemu_write_mem(NEMU *nemu, uint64_t addr, const void *buf, size_t size);
+void nemu_read_mem(NEMU *nemu, uint64_t addr, void *buf, size_t size);
+
+// copy the registers in the layout of DIFFTEST_REG_SIZE in difftest-def.h
+void nemu_regcpy(NEMU *nemu, void *regs, bool to_nemu);
+
+/* Run at most `n` instructions, and return the state of the instance after,
+ * which is NEMU_STOP, NEMU_END or NEMU_ABORT in utils.h. */
+int nemu_run(NEMU *nemu, uint64_t n);
+static inline int nemu_step(NEMU *nemu) { return nemu_run(nemu, 1); }
+
+// the number of instructions executed by the instance
+uint64_t nemu_nr_inst(NEMU *nemu);
+
+#endif
@@ -0,0 +1,85 @@
+/***************************************************************************************
+* Copyright (c) 2014-2024 Zihao Yu, Nanjing University
+*
+* NEMU is licensed under Mulan PSL v2.
+* You can use this software according to the terms and conditions of the Mulan PSL v2.
+* You may obtain a copy of Mulan PSL v2 at:
+*          http://license.coscl.org.cn/MulanPSL2
+*
+* THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+* EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+* MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+*
+* See the Mulan PSL v2 for more details.
+***************************************************************************************/
+
+#ifndef __NEMU_PLUGIN_H__
+#define __NEMU_PLUGIN_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Plugins loaded by --plugin=LIB.so[,ARG] into NEMU built with CONFIG_PLUGIN.
+ * A plugin exports
+ *   int nemu_plugin_install(const NEMUPluginAPI *api, const char *arg);
+ * which is called once before running, with ARG or an empty string, and
+ * returns 0 on success. Everything else is reached through `api`, so the
+ * plugin links against nothing of NEMU.
+ *
+ * Instrumentation is decided at translation time. A block runs from its
+ * entry until the control flow is changed, and the callbacks registered by
+ * register_block_trans() are called once for each block when it is first
+ * executed, and again if its code is written. There the plugin looks at
+ * the instructions of the block, and hooks those it is interested in, so
+ * that other blocks cost nearly nothing. A hook is either a callback, or
+ * an inline counter, to which NEMU adds a constant without calling into
+ * the plugin. The hooks of the first execution of a block are run right
+ * after it, since the block is only known after it ends.
+ *
+ * Addresses of instructions are virtual, and those of memory accesses are
+ * physical. Callbacks are called on the thread running the guest.
+ */
+#define NEMU_PLUGIN_VERSION 1
+
+typedef struct nemu_block nemu_block;
+typedef struct nemu_insn nemu_insn;
+
+typedef void (*nemu_block_trans_cb)(nemu_block *block, void *udata);
+typedef void (*nemu_exec_cb)(uint64_t pc, void *udata);
+typedef void (*nemu_mem_cb)(uint64_t pc, uint64_t addr, int len, bool is_write, void *udata);
+typedef void (*nemu_exit_cb)(void *udata);
+
+typedef struct {
+  int version; // NEMU_PLUGIN_VERSION
+
+  // registration
+  void (*register_block_trans)(nemu_block_trans_cb cb, void *udata);
+  void (*register_exit)(nemu_exit_cb cb, void *udata);
+
+  // queries at translation time
+  uint64_t (*block_vaddr)(const nemu_block *block);
+  int (*block_ninsn)(const nemu_block *block);
+  nemu_insn* (*block_insn)(nemu_block *block, int i);
+  uint64_t (*insn_vaddr)(const nemu_insn *insn);
+  int (*insn_size)(const nemu_insn *insn);
+  const uint8_t* (*insn_data)(const nemu_insn *insn);
+
+  // hooks, which can only be added at translation time
+  void (*block_exec_cb)(nemu_block *block, nemu_exec_cb cb, void *udata);
+  void (*block_exec_inline)(nemu_block *block, uint64_t *counter, uint64_t imm);
+  void (*insn_exec_cb)(nemu_insn *insn, nemu_exec_cb cb, void *udata);
+  void (*insn_exec_inline)(nemu_insn *insn, uint64_t *counter, uint64_t imm);
+  void (*insn_mem_cb)(nemu_insn *insn, nemu_mem_cb cb, void *udata);
+  void (*insn_mem_inline)(nemu_insn *insn, uint64_t *counter, uint64_t imm);
+
+  // the state of the guest, which can be read from callbacks
+  uint64_t (*reg)(const char *name, bool *success);
+  uint64_t (*nr_inst)();
+  // the function containing `pc` in the symbol table of --elf, or NULL
+  const char* (*symbol)(uint64_t pc);
+} NEMUPluginAPI;
+
+__attribute__((visibility("default")))
+int nemu_plugin_install(const NEMUPluginAPI *api, const char *arg);
+
+#endif
@@ -0,0 +1,43 @@
+/***************************************************************************************
+* Copyright (c) 2014-2024 Zihao Yu, Nanjing University
+*
+* NEMU is licensed under Mulan PSL v2.
+* You can use this software according to the terms and conditions of the Mulan PSL v2.
+* You may obtain a copy of Mulan PSL v2 at:
+*          http://license.coscl.org.cn/MulanPSL2
+*
+* THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+* EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+* MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+*
+* See the Mulan PSL v2 for more details.
+***************************************************************************************/
+
+
+#ifndef __TRING_DEF_H__
+#define __TRING_DEF_H__
+
+#include <stdint.h>
+
+/* A circular trace file, written by src/utils/tfile.c for a file name ending
+ * with ".ring", and read by tools/nemu-trace. It has a fixed size, and is
+ *
+ *   TRingHeader h;
+ *   uint8_t header[h.header_len]; // the header of the trace, e.g. ITraceHeader
+ *   uint8_t data[h.data_size];    // at h.data_off, aligned to a page
+ *
+ * where the byte at offset X of the trace is data[X % h.data_size]. Bytes
+ * of the trace in [begin, end) are valid, also after NEMU is killed, since
+ * `begin` is raised before the oldest bytes are overwritten, and `end` is
+ * raised after the new ones are written. A reader of fixed-size records
+ * starts from the first record at or after `begin`. */
+#define TRING_MAGIC "NEMURING"
+
+typedef struct {
+  char magic[8];
+  uint64_t header_len;
+  uint64_t data_off, data_size;
+  uint64_t begin, end;
+} TRingHeader;
+
+#endif
@@ -34,6 +34,96 @@ extern NEMUState nemu_state;
 
 uint64_t get_time();
 
+// ----------- statistics -----------
+
+#ifdef CONFIG_STATS
+enum { STATS_DEVICE, STATS_DIFFTEST, STATS_TRACE, NR_STATS };
+// the host time spent in each kind of work while running, unit: ns
+extern uint64_t stats_ns[NR_STATS];
+uint64_t stats_clock();
+#define STATS_TIME(kind, stmt) \
+  do { \
+    uint64_t __t = stats_clock(); \
+    stmt; \
+    stats_ns[kind] += stats_clock() - __t; \
+  } while (0)
+#else
+#define STATS_TIME(kind, stmt) do { stmt; } while (0)
+#endif
+
+#ifdef CONFIG_INST_COST
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define COST_UNIT "cycles"
+static inline uint64_t cost_clock() { return __rdtsc(); }
+#else
+#include <time.h>
+#define COST_UNIT "ns"
+static inline uint64_t cost_clock() {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC_RAW, &now);
+  return now.tv_sec * 1000000000ull + now.tv_nsec;
+}
+#endif
+#endif
+
+// ----------- footprint -----------
+
+#ifdef CONFIG_FOOTPRINT
+/* Account the host memory [addr, addr + size) to the subsystem `name`.
+ * Accounting the same `addr` again replaces it, and size 0 drops it. */
+void footprint_add(const char *name, void *addr, size_t size);
+#define FOOTPRINT(name, addr, size) footprint_add(name, addr, size)
+
+typedef struct {
+  const char *name;
+  uint64_t reserved, resident;
+} Footprint;
+// sum the memory of each subsystem into `fp`, return the number of them
+int footprint_collect(Footprint *fp, int max);
+uint64_t footprint_rss();
+#else
+#define FOOTPRINT(name, addr, size)
+#endif
+
+// ----------- symbol -----------
+
+// return the function containing `pc` and the offset of `pc` in it,
+// or NULL if no symbol is found
+const char *symbol_lookup(vaddr_t pc, word_t *offset);
+// find the function named `name`, return false if not found
+bool symbol_find(const char *name, vaddr_t *start, word_t *size);
+// return the index of the function starting at `addr`, or -1 if none
+int symbol_at(vaddr_t addr);
+int symbol_count();
+const char *symbol_get(int idx, vaddr_t *start, word_t *size);
+
+// ----------- trace window -----------
+
+/* Windows where the log is enabled, replacing CONFIG_TRACE_START and
+ * CONFIG_TRACE_END once armed. An instruction is inside the windows if it
+ * is inside one of the windows by instruction count and one of those by
+ * PC, with no window of a kind matching everything. Outside the windows by
+ * instruction count, the untraced execution loop is selected. */
+// arm a window of `kind` "inst", "pc" or "sym", return an error message or NULL
+const char *trace_window_arm(const char *kind, const char *a, const char *b);
+void trace_window_clear();
+void trace_window_display();
+// return the number of instructions to the next boundary of the windows by
+// instruction count and set `in` if inside, or return 0 if there is none
+uint64_t trace_window_next(bool *in);
+
+// ----------- trace file -----------
+
+/* Used by the writers of trace files and the log. A file whose name ends
+ * with ".gz" is compressed, and files are rotated by CONFIG_TRACE_FILE_MAX.
+ * One ending with ".ring" is overwritten circularly in a fixed size. */
+typedef struct TraceFile TraceFile;
+TraceFile *tfile_open(const char *file, const void *header, size_t header_len);
+void tfile_write(TraceFile *f, const void *buf, size_t len);
+void tfile_flush(TraceFile *f);
+void tfile_close(TraceFile *f);
+
 // ----------- log -----------
 
 #define ANSI_FG_BLACK   "\33[1;30m"
@@ -56,16 +146,40 @@ uint64_t get_time();
 
 #define ANSI_FMT(str, fmt) fmt str ANSI_NONE
 
+/* Whether the log is enabled for the instruction just executed, see the
+ * trace windows above. Only the windows are checked out of line. */
+extern int log_nr_window;
+bool log_enable_window();
+static inline bool log_enable() {
+  if (likely(log_nr_window == 0)) {
+#ifdef CONFIG_TRACE
+    extern uint64_t g_nr_guest_inst;
+    return (g_nr_guest_inst >= CONFIG_TRACE_START) && (g_nr_guest_inst <= CONFIG_TRACE_END);
+#else
+    return false;
+#endif
+  }
+  return log_enable_window();
+}
+
+#ifdef CONFIG_LOG_ASYNC
+void log_write_async(const char *fmt, ...) __attribute__((format(printf, 1, 2)));
+void log_flush();
+#define log_write(...) \
+  do { \
+    if (log_enable()) log_write_async(__VA_ARGS__); \
+  } while (0)
+#else
 #define log_write(...) IFDEF(CONFIG_TARGET_NATIVE_ELF, \
   do { \
     extern FILE* log_fp; \
-    extern bool log_enable(); \
     if (log_enable() && log_fp != NULL) { \
       fprintf(log_fp, __VA_ARGS__); \
       fflush(log_fp); \
     } \
   } while (0) \
 )
+#endif
 
 #define _Log(...) \
   do { \
@@ -35,10 +35,162 @@ run: run-env
 gdb: run-env
 	gdb -s $(BINARY) --args $(NEMU_EXEC)
 
+# Run the intervals saved by --simpoint in parallel by `make -jN simpoint-replay`.
+# Each job loads a snapshot and runs an interval with the sdb script mode,
+# writing the results to CKPT_DIR/INTERVAL.json and the log next to it.
+CKPT_DIR ?= $(BUILD_DIR)/ckpt
+SIMPOINT_INTERVAL ?= $(CONFIG_BBV_INTERVAL)
+SIMPOINT_RESULT = $(patsubst %.snap,%.json,$(wildcard $(CKPT_DIR)/*.snap))
+
+$(CKPT_DIR)/%.json: $(CKPT_DIR)/%.snap run-env
+	@printf 'load %s\nsi %s\n' $< $(SIMPOINT_INTERVAL) | \
+		$(BINARY) --log=$(CKPT_DIR)/$*.log $(ARGS_DIFF) $(ARGS_REPLAY) --script=- > $@
+
+simpoint-replay: $(SIMPOINT_RESULT)
+
+# Run a fixed set of benchmarks of AM by `make bench`, one after another in
+# batch mode without tracing, and write the speed of each to BENCH_RESULT.
+# The benchmarks are built from am-kernels at AM_KERNELS_HOME.
+AM_KERNELS_HOME ?= $(abspath $(NEMU_HOME)/../am-kernels)
+BENCH_DIR = $(BUILD_DIR)/bench
+BENCH_RESULT ?= $(BUILD_DIR)/bench.txt
+BENCH_NAMES ?= microbench coremark dhrystone matrix-mul
+BENCH_PATH_microbench = benchmarks/microbench
+BENCH_PATH_coremark = benchmarks/coremark
+BENCH_PATH_dhrystone = benchmarks/dhrystone
+BENCH_PATH_matrix-mul = tests/cpu-tests
+BENCH_ARGS_microbench = mainargs=ref
+BENCH_ARGS_matrix-mul = ALL=matrix-mul
+BENCH_IMG = $(AM_KERNELS_HOME)/$(BENCH_PATH_$(1))/build/$(1)-$(GUEST_ISA)-nemu.bin
+
+# the log file only records the trace window, so statistic() is read from
+# stdout, with the separators of thousands removed
+define bench_one
+	@+$(MAKE) -s -C $(AM_KERNELS_HOME)/$(BENCH_PATH_$(1)) ARCH=$(GUEST_ISA)-nemu $(BENCH_ARGS_$(1)) > /dev/null
+	@$(BINARY) --batch --no-trace $(call BENCH_IMG,$(1)) > $(BENCH_DIR)/$(1).log 2> $(BENCH_DIR)/$(1).out; true
+	@sed 's/\x1b\[[0-9;]*m//g; s/[,.]\([0-9]\{3\}\)/\1/g' $(BENCH_DIR)/$(1).log | awk -v name=$(1) \
+		'/HIT GOOD TRAP/ { ok = 1 } /total guest instructions/ { n = $$NF } /host time spent/ { t = $$(NF - 1) } \
+		 /simulation frequency/ { f = $$(NF - 1) } \
+		 END { printf "%-12s %14s %12s %10.2f%s\n", name, n, t, f / 1000000, (ok ? "" : "  FAIL") }' >> $(BENCH_RESULT)
+
+endef
+
+ifeq ($(CONFIG_DIFFTEST)$(filter bench,$(MAKECMDGOALS)),ybench)
+$(error "make bench" needs a build without CONFIG_DIFFTEST)
+endif
+
+bench: run-env
+	@mkdir -p $(BENCH_DIR)
+	@printf '# %s %s %s\n' $(NAME) "$$(git -C $(NEMU_HOME) describe --always --dirty 2>/dev/null)" "$$(date '+%F %T')" > $(BENCH_RESULT)
+	@printf '%-12s %14s %12s %10s\n' name guest_inst host_us MIPS >> $(BENCH_RESULT)
+	$(foreach b,$(BENCH_NAMES),$(call bench_one,$(b)))
+	@cat $(BENCH_RESULT)
+
+# Keep the results of BENCH_RUNS runs of `make bench` as the baseline by
+# `make bench-baseline`, keyed by the commit and a hash of the configuration.
+# `make bench-regress` runs them again and compares by tools/bench-cmp, which
+# fails if any benchmark is significantly slower by more than BENCH_THRESHOLD
+# percent. The baseline is the latest one kept, or that of commit BENCH_BASE.
+BENCH_RUNS ?= 5
+BENCH_THRESHOLD ?= 3
+BENCH_STORE ?= $(NEMU_HOME)/bench
+BENCH_KEY = $(BENCH_STORE)/$(NAME)-$(shell md5sum $(NEMU_HOME)/include/config/auto.conf | cut -c1-8)
+BENCH_COMMIT = $(shell git -C $(NEMU_HOME) describe --always --dirty 2>/dev/null)
+BENCH_BASE ?= $(shell cat $(BENCH_KEY)/baseline 2>/dev/null)
+BENCH_CMP = $(NEMU_HOME)/tools/bench-cmp/build/bench-cmp
+
+define bench_runs
+	@mkdir -p $(BENCH_DIR) $(BENCH_KEY)
+	@cp $(NEMU_HOME)/include/config/auto.conf $(BENCH_KEY)/config
+	@rm -f $(1)
+	@+for i in $$(seq $(BENCH_RUNS)); do \
+		echo "+ bench run $$i/$(BENCH_RUNS)"; \
+		$(MAKE) -s bench BENCH_RESULT=$(BENCH_DIR)/run.txt > /dev/null && cat $(BENCH_DIR)/run.txt >> $(1) || exit 1; \
+	done
+endef
+
+bench-baseline: run-env
+	$(call bench_runs,$(BENCH_KEY)/$(BENCH_COMMIT).txt)
+	@echo $(BENCH_COMMIT) > $(BENCH_KEY)/baseline
+	@echo "baseline $(BENCH_COMMIT) kept in $(BENCH_KEY)"
+
+bench-regress: run-env
+	@test -f $(BENCH_KEY)/$(BENCH_BASE).txt || { echo "no baseline in $(BENCH_KEY), run \`make bench-baseline' first"; false; }
+	@$(MAKE) -s -C $(NEMU_HOME)/tools/bench-cmp
+	$(call bench_runs,$(BENCH_DIR)/regress-runs.txt)
+	@$(BENCH_CMP) -t $(BENCH_THRESHOLD) -j $(BUILD_DIR)/bench-regress.json \
+		$(BENCH_KEY)/$(BENCH_BASE).txt $(BENCH_DIR)/regress-runs.txt > $(BUILD_DIR)/bench-regress.txt; \
+		r=$$?; cat $(BUILD_DIR)/bench-regress.txt; exit $$r
+
+# Time the device operations seen by the guest by `make devbench`, with the
+# program of tests/devbench in AM_HOME run once for each operation named by
+# mainargs, so that a device not built in only fails its own line. The host
+# ns are timed by the guest, and the guest instructions are those of the
+# run less those of the run doing nothing, both per operation.
+AM_HOME ?= $(abspath $(NEMU_HOME)/../abstract-machine)
+DEVBENCH_HOME = $(AM_HOME)/tests/devbench
+DEVBENCH_IMG = $(DEVBENCH_HOME)/build/devbench-$(GUEST_ISA)-nemu.bin
+DEVBENCH_OPS ?= serial rtc keyboard fbdraw disk audio
+DEVBENCH_RESULT ?= $(BUILD_DIR)/devbench.txt
+DEVBENCH_ARGS ?= --headless
+# the same as in scripts/platform/nemu.mk of AM
+DEVBENCH_PLACEHOLDER = The insert-arg rule in Makefile will insert mainargs here.
+
+define devbench_one
+	@cp $(DEVBENCH_IMG) $(BENCH_DIR)/devbench-$(1).bin
+	@python3 $(AM_HOME)/tools/insert-arg.py $(BENCH_DIR)/devbench-$(1).bin 64 "$(DEVBENCH_PLACEHOLDER)" $(1) > /dev/null
+	@$(BINARY) --batch --no-trace $(DEVBENCH_ARGS) $(BENCH_DIR)/devbench-$(1).bin > $(BENCH_DIR)/devbench-$(1).log 2> $(BENCH_DIR)/devbench-$(1).out; true
+
+endef
+
+devbench: run-env
+	@mkdir -p $(BENCH_DIR)
+	@+$(MAKE) -s -C $(DEVBENCH_HOME) AM_HOME=$(AM_HOME) ARCH=$(GUEST_ISA)-nemu > /dev/null
+	$(foreach op,none $(DEVBENCH_OPS),$(call devbench_one,$(op)))
+	@printf '# %s %s %s\n' $(NAME) "$$(git -C $(NEMU_HOME) describe --always --dirty 2>/dev/null)" "$$(date '+%F %T')" > $(DEVBENCH_RESULT)
+	@printf '%-10s %10s %12s %14s\n' name iters ns/op inst/op >> $(DEVBENCH_RESULT)
+	@for op in none $(DEVBENCH_OPS); do \
+		inst=$$(sed 's/\x1b\[[0-9;]*m//g; s/[,.]\([0-9]\{3\}\)/\1/g' $(BENCH_DIR)/devbench-$$op.log | \
+			awk '/total guest instructions/ { n = $$NF } END { print n + 0 }'); \
+		tr -d '\000' < $(BENCH_DIR)/devbench-$$op.out | awk -v op=$$op -v inst=$$inst \
+			'$$1 == "devbench:" && $$2 == op { found = 1; if ($$3 == "skipped") { printf "%-10s %10s\n", op, "skipped"; next } \
+			   if (op == "none") { print inst > "$(BENCH_DIR)/devbench-none.inst"; next } \
+			   getline base < "$(BENCH_DIR)/devbench-none.inst"; \
+			   printf "%-10s %10d %12.1f %14.1f\n", op, $$3, $$4 * 1000 / $$3, (inst - base) / $$3 } \
+			 END { if (!found) printf "%-10s %10s\n", op, "FAIL" }' >> $(DEVBENCH_RESULT); \
+	done
+	@cat $(DEVBENCH_RESULT)
+
+# Time the hot functions of NEMU by the hostbench command of sdb, with
+# HOSTBENCH_N calls in each round
+HOSTBENCH_N ?= 100000
+hostbench: run-env
+	@printf 'hostbench %s\nq\n' $(HOSTBENCH_N) | $(BINARY) | sed -n '/^function/,/^(nemu)/{/^(nemu)/!p}'
+
+# With CONFIG_CC_PGO, the objects are first built instrumented at the same
+# paths, since GCC names the profiles after them, and trained by `make bench`.
+# They are built again with the profiles after PGO_DATA is produced.
+ifdef CONFIG_CC_PGO
+ifndef PGO_GEN
+$(OBJS): $(PGO_DATA)
+
+$(PGO_DATA):
+	@echo "+ PGO training $(NAME)"
+	@rm -rf $(PGO_DIR) && mkdir -p $(PGO_DIR)
+	@rm -rf $(OBJ_DIR)
+	@$(MAKE) -s PGO_GEN=1 bench BENCH_RESULT=$(PGO_DIR)/bench.txt
+	$(if $(filter clang,$(CC)),@llvm-profdata merge -o $@ $(PGO_DIR)/*.profraw,@touch $@)
+	@rm -rf $(OBJ_DIR)
+endif
+endif
+
+pgo-clean:
+	-rm -rf $(NEMU_HOME)/pgo
+
 clean-tools = $(dir $(shell find ./tools -maxdepth 2 -mindepth 2 -name "Makefile"))
 $(clean-tools):
 	-@$(MAKE) -s -C $@ clean
 clean-tools: $(clean-tools)
 clean-all: clean distclean clean-tools
 
-.PHONY: run gdb run-env clean-tools clean-all $(clean-tools)
+.PHONY: run gdb run-env simpoint-replay bench bench-baseline bench-regress devbench hostbench pgo-clean clean-tools clean-all $(clean-tools)
@@ -0,0 +1,129 @@
+/***************************************************************************************
+* Copyright (c) 2014-2024 Zihao Yu, Nanjing University
+*
+* NEMU is licensed under Mulan PSL v2.
+* You can use this software according to the terms and conditions of the Mulan PSL v2.
+* You may obtain a copy of Mulan PSL v2 at:
+*          http://license.coscl.org.cn/MulanPSL2
+*
+* THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+* EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+* MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+*
+* See the Mulan PSL v2 for more details.
+***************************************************************************************/
+
+
+#include <cpu/bbv.h>
+
+#define HASH_INIT 4096
+
+bool bbv_on = false;
+vaddr_t bbv_pc = 0;
+uint64_t bbv_len = 0;
+
+// blocks by the pc of their entries, in an open addressing hash table
+static struct {
+  vaddr_t pc;
+  uint32_t id; // 0 for an empty entry
+} *hash = NULL;
+static uint32_t hash_size = 0;
+// the instructions executed in each block during the current interval
+static uint64_t *count = NULL;
+static uint32_t nr_block = 0, max_block = 0;
+
+static FILE *bb_fp = NULL;
+static uint64_t next_interval = CONFIG_BBV_INTERVAL;
+
+static inline uint32_t hash_idx(vaddr_t pc) {
+  return (uint32_t)(pc ^ (pc >> 13)) & (hash_size - 1);
+}
+
+static void hash_insert(vaddr_t pc, uint32_t id) {
+  uint32_t i = hash_idx(pc);
+  while (hash[i].id != 0) i = (i + 1) & (hash_size - 1);
+  hash[i].pc = pc;
+  hash[i].id = id;
+}
+
+static void hash_grow() {
+  uint32_t old_size = hash_size, i;
+  typeof(hash) old = hash;
+  hash_size = (hash_size == 0 ? HASH_INIT : hash_size * 2);
+  hash = calloc(hash_size, sizeof(*hash));
+  assert(hash != NULL);
+  for (i = 0; i < old_size; i ++) {
+    if (old[i].id != 0) hash_insert(old[i].pc, old[i].id);
+  }
+  free(old);
+}
+
+void bbv_block(vaddr_t pc, uint64_t len) {
+  uint32_t i = hash_idx(pc);
+  while (hash[i].id != 0) {
+    if (hash[i].pc == pc) {
+      count[hash[i].id - 1] += len;
+      return;
+    }
+    i = (i + 1) & (hash_size - 1);
+  }
+
+  if (nr_block == max_block) {
+    max_block = (max_block == 0 ? HASH_INIT : max_block * 2);
+    count = realloc(count, sizeof(*count) * max_block);
+    assert(count != NULL);
+  }
+  count[nr_block ++] = len;
+  // keep the table at most half full
+  if (nr_block * 2 > hash_size) hash_grow();
+  hash_insert(pc, nr_block);
+}
+
+static void write_interval() {
+  // the block cut by the interval is counted in the interval
+  if (bbv_len > 0) {
+    bbv_block(bbv_pc, bbv_len);
+    bbv_len = 0;
+  }
+  bool empty = true;
+  uint32_t i;
+  for (i = 0; i < nr_block; i ++) {
+    if (count[i] == 0) continue;
+    fprintf(bb_fp, "%s:%" PRIu32 ":%" PRIu64 " ", (empty ? "T" : ""), i + 1, count[i]);
+    count[i] = 0;
+    empty = false;
+  }
+  if (!empty) fputc('\n', bb_fp);
+}
+
+bool bbv_open(const char *file) {
+  bb_fp = fopen(file, "w");
+  if (bb_fp == NULL) return false;
+  hash_grow();
+  bbv_on = true;
+  return true;
+}
+
+uint64_t bbv_limit(uint64_t n) {
+  if (!bbv_on) return n;
+  extern uint64_t g_nr_guest_inst;
+  uint64_t left = (next_interval > g_nr_guest_inst ? next_interval - g_nr_guest_inst : 1);
+  return (left < n ? left : n);
+}
+
+void bbv_advance() {
+  extern uint64_t g_nr_guest_inst;
+  if (!bbv_on || g_nr_guest_inst < next_interval) return;
+  write_interval();
+  // instructions may be skipped by CONFIG_IDLE_SLEEP
+  while (next_interval <= g_nr_guest_inst) next_interval += CONFIG_BBV_INTERVAL;
+}
+
+// write the last interval, which may be shorter
+void bbv_report() {
+  if (!bbv_on) return;
+  write_interval();
+  fclose(bb_fp);
+  bbv_on = false;
+  Log("basic block vectors of %" PRIu32 " blocks written", nr_block);
+}
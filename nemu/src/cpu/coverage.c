@@ -0,0 +1,514 @@
+/***************************************************************************************
+* Copyright (c) 2014-2024 Zihao Yu, Nanjing University
+*
+* NEMU is licensed under Mulan PSL v2.
+* You can use this software according to the terms and conditions of the Mulan PSL v2.
+* You may obtain a copy of Mulan PSL v2 at:
+*          http://license.coscl.org.cn/MulanPSL2
+*
+* THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+* EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+* MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+*
+* See the Mulan PSL v2 for more details.
+***************************************************************************************/
+
+
+#include <cpu/coverage.h>
+#include <memory/paddr.h>
+#include <elf.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define HASH_INIT 256
+
+#ifdef CONFIG_ISA64
+typedef Elf64_Ehdr Ehdr;
+typedef Elf64_Shdr Shdr;
+#else
+typedef Elf32_Ehdr Ehdr;
+typedef Elf32_Shdr Shdr;
+#endif
+
+bool cov_on = false;
+// never matched, since a base is aligned
+static CovPage dummy = { .base = 1 };
+CovPage *cov_last = &dummy;
+
+// pages by their bases, in an open addressing hash table
+static CovPage **hash = NULL;
+static uint32_t hash_size = 0, nr_page = 0;
+
+static char *cov_file = NULL;
+static char *elf_file = NULL;
+
+static inline uint32_t hash_idx(vaddr_t base) {
+  return (uint32_t)((base >> COV_PAGE_SHIFT) * 0x9e3779b1u) & (hash_size - 1);
+}
+
+static void hash_insert(CovPage *p) {
+  uint32_t i = hash_idx(p->base);
+  while (hash[i] != NULL) i = (i + 1) & (hash_size - 1);
+  hash[i] = p;
+}
+
+static void hash_grow() {
+  uint32_t old_size = hash_size, i;
+  CovPage **old = hash;
+  hash_size = (hash_size == 0 ? HASH_INIT : hash_size * 2);
+  hash = calloc(hash_size, sizeof(*hash));
+  assert(hash != NULL);
+  for (i = 0; i < old_size; i ++) {
+    if (old[i] != NULL) hash_insert(old[i]);
+  }
+  free(old);
+}
+
+static CovPage* cov_find(vaddr_t base) {
+  uint32_t i = hash_idx(base);
+  for (; hash[i] != NULL; i = (i + 1) & (hash_size - 1)) {
+    if (hash[i]->base == base) return hash[i];
+  }
+  return NULL;
+}
+
+CovPage* cov_page_slow(vaddr_t base) {
+  CovPage *p = cov_find(base);
+  if (p == NULL) {
+    p = calloc(1, sizeof(*p));
+    assert(p != NULL);
+    p->base = base;
+    // keep the table at most half full
+    if (++ nr_page * 2 > hash_size) hash_grow();
+    hash_insert(p);
+  }
+  cov_last = p;
+  return p;
+}
+
+bool cov_open(const char *file, const char *elf) {
+  if (elf == NULL) {
+    Log("coverage: --elf is needed for the line table");
+    return false;
+  }
+  FILE *fp = fopen(file, "w");
+  if (fp == NULL) return false;
+  fclose(fp);
+  cov_file = strdup(file);
+  elf_file = strdup(elf);
+  hash_grow();
+  cov_on = true;
+  return true;
+}
+
+static bool cov_test(const uint8_t *map, vaddr_t pc) {
+  uint32_t off = pc & ((1 << COV_PAGE_SHIFT) - 1);
+  return (map[off >> 4] >> ((off >> 1) & 7)) & 1;
+}
+
+/* The line table is read from .debug_line of DWARF 2 to 5 in the ELF given by
+ * --elf, as the rows of address, file and line produced by the line number
+ * programs. A row covers the code up to the address of the next row in its
+ * sequence, and the row ending a sequence only gives that address. */
+typedef struct {
+  vaddr_t addr;
+  uint32_t file;
+  uint32_t line;
+  bool end;
+} Row;
+
+static Row *row = NULL;
+static int nr_row = 0, max_row = 0;
+static char **file_name = NULL;
+static int nr_file = 0, max_file = 0;
+
+typedef struct {
+  const uint8_t *p, *end;
+  bool bad;
+} Reader;
+
+static uint64_t rd_fixed(Reader *r, int n) {
+  if (r->end - r->p < n) { r->bad = true; r->p = r->end; return 0; }
+  uint64_t v = 0;
+  int i;
+  for (i = 0; i < n; i ++) v |= (uint64_t)r->p[i] << (i * 8);
+  r->p += n;
+  return v;
+}
+
+static uint64_t rd_uleb(Reader *r) {
+  uint64_t v = 0;
+  int shift = 0;
+  while (r->p < r->end) {
+    uint8_t b = *r->p ++;
+    if (shift < 64) v |= (uint64_t)(b & 0x7f) << shift;
+    shift += 7;
+    if (!(b & 0x80)) return v;
+  }
+  r->bad = true;
+  return v;
+}
+
+static int64_t rd_sleb(Reader *r) {
+  int64_t v = 0;
+  int shift = 0;
+  while (r->p < r->end) {
+    uint8_t b = *r->p ++;
+    if (shift < 64) v |= (int64_t)(b & 0x7f) << shift;
+    shift += 7;
+    if (!(b & 0x80)) {
+      if (shift < 64 && (b & 0x40)) v |= -((int64_t)1 << shift);
+      return v;
+    }
+  }
+  r->bad = true;
+  return v;
+}
+
+static const char* rd_str(Reader *r) {
+  const char *s = (const char *)r->p;
+  const uint8_t *nul = memchr(r->p, '\0', r->end - r->p);
+  if (nul == NULL) { r->bad = true; r->p = r->end; return ""; }
+  r->p = nul + 1;
+  return s;
+}
+
+typedef struct {
+  const uint8_t *data;
+  size_t size;
+} Section;
+
+static const char* sec_str(const Section *s, uint64_t off) {
+  if (s->data == NULL || off >= s->size || memchr(s->data + off, '\0', s->size - off) == NULL) return NULL;
+  return (const char *)s->data + off;
+}
+
+// the forms of the entries of directories and files in DWARF 5
+enum {
+  FORM_block = 0x09, FORM_data1 = 0x0b, FORM_data2 = 0x05, FORM_data4 = 0x06,
+  FORM_data8 = 0x07, FORM_data16 = 0x1e, FORM_sdata = 0x0d, FORM_string = 0x08,
+  FORM_strp = 0x0e, FORM_udata = 0x0f, FORM_line_strp = 0x1f,
+};
+
+static bool rd_form(Reader *r, uint64_t form, int offset_size, const Section *str,
+    const Section *line_str, const char **s, uint64_t *v) {
+  *s = NULL; *v = 0;
+  switch (form) {
+    case FORM_string: *s = rd_str(r); break;
+    case FORM_strp: *s = sec_str(str, rd_fixed(r, offset_size)); break;
+    case FORM_line_strp: *s = sec_str(line_str, rd_fixed(r, offset_size)); break;
+    case FORM_udata: *v = rd_uleb(r); break;
+    case FORM_sdata: *v = rd_sleb(r); break;
+    case FORM_data1: *v = rd_fixed(r, 1); break;
+    case FORM_data2: *v = rd_fixed(r, 2); break;
+    case FORM_data4: *v = rd_fixed(r, 4); break;
+    case FORM_data8: *v = rd_fixed(r, 8); break;
+    case FORM_data16: rd_fixed(r, 8); rd_fixed(r, 8); break;
+    case FORM_block: { uint64_t n = rd_uleb(r); if (n > (uint64_t)(r->end - r->p)) r->bad = true; else r->p += n; break; }
+    default: return false;
+  }
+  return !r->bad;
+}
+
+static int add_file(const char *dir, const char *name) {
+  if (nr_file == max_file) {
+    max_file = (max_file == 0 ? 64 : max_file * 2);
+    file_name = realloc(file_name, sizeof(*file_name) * max_file);
+    assert(file_name != NULL);
+  }
+  char *path;
+  if (name[0] == '/' || dir == NULL || dir[0] == '\0') path = strdup(name);
+  else {
+    path = malloc(strlen(dir) + strlen(name) + 2);
+    assert(path != NULL);
+    sprintf(path, "%s/%s", dir, name);
+  }
+  // the same file is listed by every unit including it
+  int i;
+  for (i = 0; i < nr_file; i ++) {
+    if (strcmp(file_name[i], path) == 0) { free(path); return i; }
+  }
+  file_name[nr_file] = path;
+  return nr_file ++;
+}
+
+static void add_row(vaddr_t addr, uint32_t file, uint32_t line, bool end) {
+  if (nr_row == max_row) {
+    max_row = (max_row == 0 ? 4096 : max_row * 2);
+    row = realloc(row, sizeof(*row) * max_row);
+    assert(row != NULL);
+  }
+  row[nr_row ++] = (Row) { .addr = addr, .file = file, .line = line, .end = end };
+}
+
+#define MAX_UNIT_DIR  256
+#define MAX_UNIT_FILE 1024
+
+// read the entries of directories or files in DWARF 5 into `path` and `dir`
+static int rd_entries(Reader *r, int offset_size, const Section *str, const Section *line_str,
+    const char **path, uint64_t *dir, int max) {
+  uint64_t format[16][2];
+  int nr_format = rd_fixed(r, 1), i, j;
+  if (nr_format > 16) return -1;
+  for (i = 0; i < nr_format; i ++) { format[i][0] = rd_uleb(r); format[i][1] = rd_uleb(r); }
+  uint64_t n = rd_uleb(r);
+  if (r->bad || n > (uint64_t)max) return -1;
+  for (i = 0; i < (int)n; i ++) {
+    path[i] = ""; dir[i] = 0;
+    for (j = 0; j < nr_format; j ++) {
+      const char *s;
+      uint64_t v;
+      if (!rd_form(r, format[j][1], offset_size, str, line_str, &s, &v)) return -1;
+      if (format[j][0] == 1 && s != NULL) path[i] = s;      // DW_LNCT_path
+      else if (format[j][0] == 2) dir[i] = v;               // DW_LNCT_directory_index
+    }
+  }
+  return n;
+}
+
+// parse a unit of .debug_line in `r`, and return false if it can not be read
+static bool parse_unit(Reader *r, const Section *str, const Section *line_str) {
+  static const char *dir_path[MAX_UNIT_DIR], *path[MAX_UNIT_FILE];
+  static uint64_t dir_of_dir[MAX_UNIT_DIR], dir[MAX_UNIT_FILE];
+  static int file[MAX_UNIT_FILE];
+
+  int offset_size = 4;
+  uint64_t len = rd_fixed(r, 4);
+  if (len == 0xffffffffu) { offset_size = 8; len = rd_fixed(r, 8); }
+  if (r->bad || len > (uint64_t)(r->end - r->p)) return false;
+  Reader u = { .p = r->p, .end = r->p + len };
+  r->p = u.end;
+
+  int version = rd_fixed(&u, 2);
+  if (version < 2 || version > 5) return false;
+  if (version >= 5) rd_fixed(&u, 2); // address_size and segment_selector_size
+  uint64_t hlen = rd_fixed(&u, offset_size);
+  if (u.bad || hlen > (uint64_t)(u.end - u.p)) return false;
+  const uint8_t *prog = u.p + hlen;
+  int min_inst_len = rd_fixed(&u, 1);
+  if (version >= 4) rd_fixed(&u, 1); // maximum_operations_per_instruction, only for VLIW
+  rd_fixed(&u, 1); // default_is_stmt, as all rows are taken
+  int line_base = (int8_t)rd_fixed(&u, 1);
+  int line_range = rd_fixed(&u, 1);
+  int opcode_base = rd_fixed(&u, 1);
+  uint8_t std_len[256] = {};
+  int i;
+  for (i = 1; i < opcode_base; i ++) std_len[i] = rd_fixed(&u, 1);
+  if (u.bad || line_range == 0) return false;
+
+  // files are numbered from 1 before DWARF 5, and from 0 since
+  int nr_dir = 0, nr = 0, first = (version >= 5 ? 0 : 1);
+  if (version >= 5) {
+    nr_dir = rd_entries(&u, offset_size, str, line_str, dir_path, dir_of_dir, MAX_UNIT_DIR);
+    if (nr_dir < 0) return false;
+    nr = rd_entries(&u, offset_size, str, line_str, path, dir, MAX_UNIT_FILE);
+    if (nr < 0) return false;
+  } else {
+    // the compilation directory is not in .debug_line, so relative paths are kept
+    dir_path[nr_dir ++] = "";
+    while (!u.bad && *u.p != '\0' && nr_dir < MAX_UNIT_DIR) dir_path[nr_dir ++] = rd_str(&u);
+    rd_fixed(&u, 1);
+    while (!u.bad && *u.p != '\0' && nr < MAX_UNIT_FILE) {
+      path[nr] = rd_str(&u);
+      dir[nr] = rd_uleb(&u);
+      rd_uleb(&u); rd_uleb(&u); // time and size
+      nr ++;
+    }
+    if (u.bad) return false;
+  }
+  for (i = 0; i < nr; i ++) file[i] = add_file(dir[i] < (uint64_t)nr_dir ? dir_path[dir[i]] : NULL, path[i]);
+
+  // the line number program
+  u.p = prog;
+  vaddr_t addr = 0;
+  uint64_t f = 1;
+  int64_t line = 1;
+#define EMIT(end) do { \
+    if (f - first < (uint64_t)nr) add_row(addr, file[f - first], line, end); \
+  } while (0)
+#define RESET() do { addr = 0; f = 1; line = 1; } while (0)
+  while (u.p < u.end && !u.bad) {
+    int op = *u.p ++;
+    if (op >= opcode_base) {
+      int adj = op - opcode_base;
+      addr += (adj / line_range) * min_inst_len;
+      line += line_base + adj % line_range;
+      EMIT(false);
+      continue;
+    }
+    switch (op) {
+      case 0: { // extended
+        uint64_t n = rd_uleb(&u);
+        if (n == 0 || n > (uint64_t)(u.end - u.p)) return false;
+        const uint8_t *next = u.p + n;
+        int eop = *u.p ++;
+        if (eop == 1) { EMIT(true); RESET(); }        // DW_LNE_end_sequence
+        else if (eop == 2) addr = rd_fixed(&u, n - 1); // DW_LNE_set_address
+        u.p = next;
+        break;
+      }
+      case 1: EMIT(false); break;                                   // DW_LNS_copy
+      case 2: addr += rd_uleb(&u) * min_inst_len; break;            // DW_LNS_advance_pc
+      case 3: line += rd_sleb(&u); break;                           // DW_LNS_advance_line
+      case 4: f = rd_uleb(&u); break;                               // DW_LNS_set_file
+      case 8: addr += ((255 - opcode_base) / line_range) * min_inst_len; break; // DW_LNS_const_add_pc
+      case 9: addr += rd_fixed(&u, 2); break;                       // DW_LNS_fixed_advance_pc
+      default: for (i = 0; i < std_len[op]; i ++) rd_uleb(&u); break;
+    }
+  }
+#undef EMIT
+#undef RESET
+  return !u.bad;
+}
+
+static bool load_lines(const char *file) {
+  int fd = open(file, O_RDONLY);
+  if (fd < 0) return false;
+  struct stat st;
+  int ret = fstat(fd, &st);
+  assert(ret == 0);
+  size_t size = st.st_size;
+  const uint8_t *buf = (size >= sizeof(Ehdr) ? mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED);
+  close(fd);
+  if (buf == MAP_FAILED) return false;
+
+  const Ehdr *eh = (const Ehdr *)buf;
+  Section line = {}, str = {}, line_str = {};
+  if (eh->e_shoff != 0 && eh->e_shstrndx < eh->e_shnum &&
+      eh->e_shoff + (size_t)eh->e_shnum * sizeof(Shdr) <= size) {
+    const Shdr *sh = (const Shdr *)(buf + eh->e_shoff);
+    const Shdr *names = &sh[eh->e_shstrndx];
+    int i;
+    for (i = 0; i < eh->e_shnum; i ++) {
+      if (sh[i].sh_type != SHT_PROGBITS || sh[i].sh_offset + sh[i].sh_size > size ||
+          sh[i].sh_name >= names->sh_size || names->sh_offset + names->sh_size > size) continue;
+      const char *name = (const char *)buf + names->sh_offset + sh[i].sh_name;
+      Section s = { .data = buf + sh[i].sh_offset, .size = sh[i].sh_size };
+      if (strcmp(name, ".debug_line") == 0) line = s;
+      else if (strcmp(name, ".debug_str") == 0) str = s;
+      else if (strcmp(name, ".debug_line_str") == 0) line_str = s;
+    }
+  }
+
+  Reader r = { .p = line.data, .end = line.data + line.size };
+  while (line.data != NULL && r.p < r.end && parse_unit(&r, &str, &line_str)) ;
+  munmap((void *)buf, size);
+  return nr_row > 0;
+}
+
+/* The instruction at `pc` in pmem is read to tell a conditional branch,
+ * whose two ways are reported, and its length. Code out of pmem is taken as
+ * instructions of 2 bytes without branches. */
+static int inst_at(vaddr_t pc, bool *cond) {
+  *cond = false;
+  if (!in_pmem(pc) || !in_pmem(pc + 1)) return 2;
+  uint8_t *p = guest_to_host(pc);
+  uint16_t lo = p[0] | (p[1] << 8);
+  if ((lo & 0x3) != 0x3) {
+    // c.beqz and c.bnez
+    *cond = ((lo & 0xc003) == 0xc001);
+    return 2;
+  }
+  *cond = ((lo & 0x7f) == 0x63);
+  return 4;
+}
+
+typedef struct {
+  uint32_t file, line;
+  vaddr_t pc;
+  int8_t hit, taken, fall; // -1 for a line without a branch
+} Rec;
+
+static int rec_cmp(const void *a, const void *b) {
+  const Rec *x = a, *y = b;
+  if (x->file != y->file) return (x->file > y->file) - (x->file < y->file);
+  if (x->line != y->line) return (x->line > y->line) - (x->line < y->line);
+  if (x->pc != y->pc) return (x->pc > y->pc) - (x->pc < y->pc);
+  return (x->taken > y->taken) - (x->taken < y->taken);
+}
+
+static void write_lcov(FILE *fp, Rec *rec, int n, int *lh, int *lf) {
+  int i = 0;
+  *lh = *lf = 0;
+  while (i < n) {
+    uint32_t f = rec[i].file;
+    int j, k, nf = 0, nh = 0, bf = 0, bh = 0;
+    for (j = i; j < n && rec[j].file == f; j ++) ;
+    fprintf(fp, "TN:\nSF:%s\n", file_name[f]);
+    // a branch is a block of its own, numbered by its order in the file
+    for (k = i; k < j; k ++) {
+      if (rec[k].taken < 0 || (k > i && rec[k - 1].pc == rec[k].pc && rec[k - 1].taken >= 0)) continue;
+      if (!rec[k].hit) fprintf(fp, "BRDA:%u,%d,0,-\nBRDA:%u,%d,1,-\n", rec[k].line, bf / 2, rec[k].line, bf / 2);
+      else fprintf(fp, "BRDA:%u,%d,0,%d\nBRDA:%u,%d,1,%d\n", rec[k].line, bf / 2, rec[k].taken,
+          rec[k].line, bf / 2, rec[k].fall);
+      bf += 2;
+      bh += rec[k].taken + rec[k].fall;
+    }
+    fprintf(fp, "BRF:%d\nBRH:%d\n", bf, bh);
+    for (k = i; k < j; ) {
+      uint32_t line = rec[k].line;
+      bool hit = false;
+      for (; k < j && rec[k].line == line; k ++) hit |= rec[k].hit;
+      fprintf(fp, "DA:%u,%d\n", line, hit);
+      nf ++;
+      nh += hit;
+    }
+    fprintf(fp, "LF:%d\nLH:%d\nend_of_record\n", nf, nh);
+    *lf += nf;
+    *lh += nh;
+    i = j;
+  }
+}
+
+// write the lines and branches covered into the file of --coverage in lcov format
+void cov_report() {
+  if (!cov_on) return;
+  cov_on = false;
+  if (!load_lines(elf_file)) {
+    Log("coverage: no line table in '%s', built without -g?", elf_file);
+    return;
+  }
+
+  Rec *rec = NULL;
+  int n = 0, max = 0, i;
+  for (i = 0; i + 1 < nr_row; i ++) {
+    Row *r = &row[i];
+    vaddr_t pc = r->addr, end = row[i + 1].addr;
+    if (r->end || r->line == 0 || end <= pc) continue;
+    bool hit = false;
+    // the row itself, followed by the conditional branches in it
+    do {
+      if (n + 1 >= max) {
+        max = (max == 0 ? 4096 : max * 2);
+        rec = realloc(rec, sizeof(*rec) * max);
+        assert(rec != NULL);
+      }
+      bool cond;
+      vaddr_t cur = pc;
+      pc += inst_at(cur, &cond);
+      CovPage *p = cov_find(cur & ~(vaddr_t)((1 << COV_PAGE_SHIFT) - 1));
+      bool exec = (p != NULL && cov_test(p->exec, cur));
+      hit |= exec;
+      if (cond) {
+        rec[n ++] = (Rec) { .file = r->file, .line = r->line, .pc = cur, .hit = exec,
+          .taken = exec && cov_test(p->taken, cur), .fall = exec && cov_test(p->fall, cur) };
+      }
+    } while (pc < end);
+    rec[n ++] = (Rec) { .file = r->file, .line = r->line, .pc = r->addr, .hit = hit, .taken = -1, .fall = -1 };
+  }
+  qsort(rec, n, sizeof(*rec), rec_cmp);
+
+  FILE *fp = fopen(cov_file, "w");
+  if (fp == NULL) {
+    Log_warn("coverage: can not open '%s'", cov_file);
+    free(rec);
+    return;
+  }
+  int lh, lf;
+  write_lcov(fp, rec, n, &lh, &lf);
+  fclose(fp);
+  free(rec);
+  Log("coverage: %d of %d lines hit in %d pages of code, written to %s", lh, lf, nr_page, cov_file);
+}
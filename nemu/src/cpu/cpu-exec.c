@@ -16,7 +16,30 @@
 #include <cpu/cpu.h>
 #include <cpu/decode.h>
 #include <cpu/difftest.h>
+#include <cpu/itrace.h>
+#include <cpu/ftrace.h>
+#include <cpu/breakpoint.h>
+#include <cpu/reverse.h>
+#include <cpu/bbv.h>
+#include <cpu/coverage.h>
+#include <cpu/hart.h>
+#include <cpu/timing.h>
+#include <cpu/plugin.h>
+#include <memory/paddr.h>
+#include <memory/mtrace.h>
 #include <locale.h>
+#ifndef CONFIG_TARGET_AM
+#include <signal.h>
+#include <sys/time.h>
+#endif
+#ifdef CONFIG_MEM_EXCEPTION
+#include <setjmp.h>
+#endif
+#if defined(CONFIG_ENGINE_BLOCK)
+#include <block.h>
+#elif defined(CONFIG_ENGINE_JIT)
+#include <jit.h>
+#endif
 
 /* The assembly code of instructions executed is only output to the screen
  * when the number of instructions executed is less than this value.
@@ -25,62 +48,625 @@
  */
 #define MAX_INST_TO_PRINT 10
 
-CPU_state cpu = {};
+// the number of instructions disassembled from the binary itrace when failing
+#define ITRACE_NR_DUMP 16
+
+HART_LOCAL CPU_state cpu = {};
 uint64_t g_nr_guest_inst = 0;
 static uint64_t g_timer = 0; // unit: us
 static bool g_print_step = false;
 
 void device_update();
+extern int64_t device_countdown;
+IFNDEF(CONFIG_TARGET_AM, bool memhash_check());
+
+// count down the instructions to the next event of devices
+static inline void device_tick(uint64_t n) {
+  device_countdown -= n;
+  if (unlikely(device_countdown <= 0)) STATS_TIME(STATS_DEVICE, device_update());
+}
+
+/* The ISA is only asked for an interrupt after a device raises one. The word
+ * stays set while the interrupt is masked, and is cleared once it is taken. */
+static inline void intr_check() {
+  if (likely(__atomic_load_n(&intr_pending, __ATOMIC_RELAXED) == 0)) return;
+  word_t NO = isa_query_intr();
+  if (NO != INTR_EMPTY) {
+    __atomic_store_n(&intr_pending, 0, __ATOMIC_RELAXED);
+    cpu.pc = isa_raise_intr(NO, cpu.pc);
+  }
+}
+
+void format_inst(char *str, int size, vaddr_t pc, uint8_t *inst, int ilen);
+
+// the length of an instruction as traced, where a branch of mips32 is
+// traced without the delay slot executed with it
+#define TRACE_ILEN(s) MUXDEF(CONFIG_ISA_mips32, 4, (s)->snpc - (s)->pc)
+
+// the number of instructions executed by exec_once(), 2 for a fused pair
+#define NR_EXEC(s) MUXDEF(CONFIG_DECODE_FUSION, (s).ninst, 1)
+// whether trace_and_difftest() has anything to do for each instruction
+#define TRACE_EACH_INST (MUXDEF(CONFIG_ITRACE, 1, 0) || MUXDEF(CONFIG_FTRACE, 1, 0) || \
+    MUXDEF(CONFIG_DIFFTEST, 1, 0))
+
+#ifdef CONFIG_STATS
+void stats_exec(bool start);
+uint64_t stats_limit(uint64_t n);
+void stats_sample();
+#endif
+
+IFDEF(CONFIG_INPUT_LOG, uint64_t input_log_limit(uint64_t n));
+
+#ifdef CONFIG_LIVE
+uint64_t live_limit(uint64_t n);
+void live_update(bool force);
+#endif
+
+#ifdef CONFIG_IQUEUE
+/* The last instructions executed, recorded even without tracing, and only
+ * disassembled on failures. */
+#define IQUEUE_SIZE 16
+static struct {
+  vaddr_t pc;
+  uint8_t ilen;
+#ifdef CONFIG_ISA_x86
+  uint8_t inst[16];
+#else
+  uint32_t inst;
+#endif
+} iqueue[IQUEUE_SIZE];
+static uint64_t iqueue_nr = 0;
+
+static inline void iqueue_commit(Decode *s) {
+  int i = iqueue_nr ++ % IQUEUE_SIZE;
+  iqueue[i].pc = s->pc;
+  iqueue[i].ilen = TRACE_ILEN(s);
+#ifdef CONFIG_ISA_x86
+  memcpy(iqueue[i].inst, s->isa.inst, sizeof(s->isa.inst));
+#else
+  iqueue[i].inst = s->isa.inst;
+#endif
+}
+
+void iqueue_dump() {
+  printf("The last instructions executed:\n");
+  uint64_t i = (iqueue_nr > IQUEUE_SIZE ? iqueue_nr - IQUEUE_SIZE : 0);
+  for (; i < iqueue_nr; i ++) {
+    int idx = i % IQUEUE_SIZE;
+    char buf[128];
+    format_inst(buf, sizeof(buf), iqueue[idx].pc, (uint8_t *)&iqueue[idx].inst,
+        iqueue[idx].ilen);
+    printf("  %s\n", buf);
+  }
+}
+#endif
 
 static void trace_and_difftest(Decode *_this, vaddr_t dnpc) {
+  IFDEF(CONFIG_STATS, uint64_t t = stats_clock());
+#if defined(CONFIG_ITRACE_BINARY)
+  int ilen = TRACE_ILEN(_this);
+  if (ITRACE_COND) { itrace_record(_this->pc, ilen, &_this->isa.inst); }
+  if (g_print_step) {
+    char buf[128];
+    format_inst(buf, sizeof(buf), _this->pc, (uint8_t *)&_this->isa.inst, ilen);
+    puts(buf);
+  }
+#else
 #ifdef CONFIG_ITRACE_COND
   if (ITRACE_COND) { log_write("%s\n", _this->logbuf); }
 #endif
   if (g_print_step) { IFDEF(CONFIG_ITRACE, puts(_this->logbuf)); }
-  IFDEF(CONFIG_DIFFTEST, difftest_step(_this->pc, dnpc));
+#endif
+  FTRACE(_this->pc, _this->snpc, dnpc);
+  IFDEF(CONFIG_STATS, stats_ns[STATS_TRACE] += stats_clock() - t);
+  IFDEF(CONFIG_DIFFTEST, STATS_TIME(STATS_DIFFTEST, difftest_step(_this->pc, dnpc)));
 }
 
-static void exec_once(Decode *s, vaddr_t pc) {
+/* Every execution loop below is compiled twice by the always-inline helpers:
+ * with `trace` being true, instructions are traced and checked by
+ * differential testing; with `trace` being false, all these hooks are
+ * stripped. `g_trace_on` selects the loop, and can be switched at runtime
+ * by the `trace' command in sdb or by SIGUSR1.
+ */
+bool g_trace_on = true;
+static volatile bool trace_switch_pending = false;
+
+__attribute__((always_inline))
+static inline void exec_once(Decode *s, vaddr_t pc, bool trace) {
   s->pc = pc;
   s->snpc = pc;
+  IFDEF(CONFIG_PLUGIN, if (unlikely(plugin_on)) plugin_insn_start(pc));
+#ifdef CONFIG_INST_COST
+  uint64_t t = cost_clock();
+  inst_stat_last = NULL;
   isa_exec_once(s);
-  cpu.pc = s->dnpc;
-#ifdef CONFIG_ITRACE
-  char *p = s->logbuf;
-  p += snprintf(p, sizeof(s->logbuf), FMT_WORD ":", s->pc);
-  int ilen = s->snpc - s->pc;
-  int i;
-  uint8_t *inst = (uint8_t *)&s->isa.inst;
-#ifdef CONFIG_ISA_x86
-  for (i = 0; i < ilen; i ++) {
+  if (inst_stat_last != NULL) inst_stat_last->cost += cost_clock() - t;
 #else
-  for (i = ilen - 1; i >= 0; i --) {
+  isa_exec_once(s);
+#endif
+  MTRACE_FETCH(s->pc, s->snpc - s->pc);
+  IFDEF(CONFIG_PLUGIN, if (unlikely(plugin_on)) plugin_insn_end(s->pc, TRACE_ILEN(s),
+      MUXDEF(CONFIG_ISA_x86, s->isa.inst, &s->isa.inst), s->dnpc != s->snpc));
+  cpu.pc = s->dnpc;
+  IFDEF(CONFIG_WATCHPOINT, if (unlikely(wp_nr_each > 0)) wp_check_each());
+  IFDEF(CONFIG_TIMING, timing_inst(s->pc, s->snpc, s->dnpc));
+  IFDEF(CONFIG_IQUEUE, iqueue_commit(s));
+#if defined(CONFIG_ITRACE) && !defined(CONFIG_ITRACE_BINARY)
+  if (!trace) return;
+  STATS_TIME(STATS_TRACE,
+      format_inst(s->logbuf, sizeof(s->logbuf), s->pc, (uint8_t *)&s->isa.inst, TRACE_ILEN(s)));
 #endif
-    p += snprintf(p, 4, " %02x", inst[i]);
+}
+
+#ifdef CONFIG_ENGINE_BLOCK
+// whether exec_once() does more for each instruction than the trace
+#define OBSERVE_EACH_INST (ISDEF(CONFIG_INST_COST) || ISDEF(CONFIG_TIMING) || ISDEF(CONFIG_IQUEUE))
+
+/* The instructions kept by a recorded block run back to back, unless
+ * something needs the state after each of them: difftest, a watchpoint
+ * stopping right after an instruction, or the hooks of exec_once(). */
+static inline bool block_back_to_back(bool trace) {
+  return !OBSERVE_EACH_INST && !(trace && ISDEF(CONFIG_DIFFTEST)) &&
+    !MUXDEF(CONFIG_WATCHPOINT, wp_active, false) && !MUXDEF(CONFIG_PLUGIN, plugin_on, false) &&
+    !MUXDEF(CONFIG_CACHESIM, mtrace_ifetch_on, false);
+}
+
+static BlockInst record_buf[BLOCK_MAX_INST];
+
+/* Execute at most `n` instructions of block `b` one by one, with `*s` left
+ * as the last one, and return the number of instructions executed. If the
+ * block is not recorded yet, record its instructions while executing it.
+ */
+__attribute__((always_inline))
+static inline uint64_t exec_block_each(Block *b, uint64_t n, bool trace, Decode *s) {
+  bool record = (b->ninst == 0);
+  uint64_t limit = (record ? BLOCK_MAX_INST : b->ninst);
+  if (n < limit) limit = n;
+  uint64_t i = 0;
+  uint32_t nr_save = 0;
+  vaddr_t end_pc = 0; // the pc after the last instruction saved
+  bool end = false; // where the block ends is known
+  uint32_t nr_flush = block_nr_flush;
+  while (i < limit) {
+    exec_once(s, cpu.pc, trace);
+    i ++;
+    // the instructions are only marked when the block is recorded
+    IFDEF(CONFIG_COVERAGE, if (record) cov_inst(s->pc, s->dnpc != s->snpc));
+    if (trace) trace_and_difftest(s, cpu.pc);
+    // the block ends before an instruction which can not be kept
+    if (record) {
+      if (!isa_block_save(s, &record_buf[nr_save])) { end = true; break; }
+      nr_save ++;
+      end_pc = s->snpc;
+    }
+    if (s->dnpc != s->snpc || nemu_state.state != NEMU_RUNNING) { end = true; break; }
+    if (record && isa_block_end(&record_buf[nr_save - 1])) { end = true; break; }
+    // split the block before a breakpoint, so that it is checked as a block entry
+    if (record && unlikely(nr_bp > 0) && bp_probe(cpu.pc)) { end = true; break; }
   }
-  int ilen_max = MUXDEF(CONFIG_ISA_x86, 8, 4);
-  int space_len = ilen_max - ilen;
-  if (space_len < 0) space_len = 0;
-  space_len = space_len * 3 + 1;
-  memset(p, ' ', space_len);
-  p += space_len;
+  // a block cut short by `n` does not tell where it ends, and the copies saved
+  // before a write to code may be stale, so record it later
+  if (record && (end || i == BLOCK_MAX_INST) && nr_save > 0 && block_nr_flush == nr_flush)
+    block_record(b, record_buf, nr_save, end_pc);
+  return i;
+}
+
+/* Execute at most `n` instructions kept by the recorded block `b` back to
+ * back, with `*s` left as the last one, and return the number of instructions
+ * executed. The state of the run is only checked after the block, since an
+ * instruction stopping the run ends a block. So is the trace: ITRACE is not
+ * built with this engine, and only the last instruction executed may
+ * transfer control, which is all FTRACE looks at.
+ */
+__attribute__((always_inline))
+static inline uint64_t exec_block_cached(Block *b, uint64_t n, bool trace, Decode *s) {
+  uint64_t limit = (n < b->ninst ? n : b->ninst);
+  const BlockInst *bi = b->inst, *end = b->inst + limit;
+  do {
+    cpu.pc = bi->pc;
+    isa_block_exec(s, bi ++);
+  } while (s->dnpc == s->snpc && bi < end);
+  cpu.pc = s->dnpc;
+  if (trace) trace_and_difftest(s, cpu.pc);
+  return bi - b->inst;
+}
 
-  void disassemble(char *str, int size, uint64_t pc, uint8_t *code, int nbyte);
-  disassemble(p, s->logbuf + sizeof(s->logbuf) - p,
-      MUXDEF(CONFIG_ISA_x86, s->snpc, s->pc), (uint8_t *)&s->isa.inst, ilen);
+// Execute at most `n` instructions of block `b`, and return the number of
+// instructions executed.
+__attribute__((always_inline))
+static inline uint64_t exec_block(Block *b, uint64_t n, bool trace) {
+  Decode s;
+  bool record = (b->ninst == 0);
+  uint64_t i = (!record && block_back_to_back(trace) ?
+      exec_block_cached(b, n, trace, &s) : exec_block_each(b, n, trace, &s));
+  IFDEF(CONFIG_BBV, bbv_exec(b->pc, i, s.dnpc != s.snpc));
+#ifdef CONFIG_COVERAGE
+  if (cov_on) {
+    uint8_t way = (s.dnpc != s.snpc ? 2 : 1);
+    if (s.snpc != b->end) { if (!record && way == 2) cov_branch(s.pc, true); } // left early
+    else if (unlikely(!(b->cov_way & way))) { b->cov_way |= way; cov_branch(s.pc, way == 2); }
+  }
 #endif
+  return i;
+}
+
+/* Execute at most `n` instructions of the superblock headed by `b`, and
+ * return the number of instructions executed. `*last` is set to the last
+ * block executed.
+ */
+__attribute__((always_inline))
+static inline uint64_t exec_super(Block *b, uint64_t n, bool trace, Block **last) {
+  uint64_t nr_exec = exec_block(b, n, trace);
+  *last = b;
+  uint32_t i;
+  for (i = 0; i < b->nsuper && nr_exec < n && nemu_state.state == NEMU_RUNNING; i ++) {
+    Block *s = b->super[i];
+    if (cpu.pc != s->pc) {
+      // side exit
+      if (++ b->nr_exit == BLOCK_HOT_THRESHOLD) { b->nsuper = 0; b->count = 0; }
+      break;
+    }
+    if (BP_HIT(cpu.pc)) break;
+    nr_exec += exec_block(s, n - nr_exec, trace);
+    *last = s;
+  }
+  return nr_exec;
 }
 
+// return the number of instructions left
+__attribute__((always_inline))
+static inline uint64_t execute_loop(uint64_t n, bool trace) {
+  Block *prev = NULL;
+  while (n > 0) {
+    vaddr_t pc = cpu.pc;
+    Block *b = (prev != NULL && prev->next != NULL && prev->next->pc == pc) ? prev->next : NULL;
+    if (b == NULL) {
+      b = block_lookup(pc);
+      if (b == NULL && n < BLOCK_MAX_INST) {
+        /* Stepping by sdb mostly starts in the middle of a block, and a new
+         * block there would take the slot of the block at the head in the
+         * table. Leave it to a longer run. */
+        Decode s;
+        exec_once(&s, pc, trace);
+        IFDEF(CONFIG_BBV, bbv_exec(s.pc, 1, s.dnpc != s.snpc));
+        IFDEF(CONFIG_COVERAGE, cov_inst(s.pc, s.dnpc != s.snpc));
+        if (trace) trace_and_difftest(&s, cpu.pc);
+        g_nr_guest_inst ++;
+        n --;
+        prev = NULL;
+        if (nemu_state.state != NEMU_RUNNING || BP_HIT(cpu.pc)) break;
+        IFDEF(CONFIG_DEVICE, device_tick(1));
+        IFDEF(CONFIG_DEVICE, intr_check());
+        continue;
+      }
+      if (b == NULL) b = block_new(pc);
+      if (prev != NULL) prev->next = b;
+    }
+    if (prev != NULL) block_vote(prev, b);
+    uint64_t nr_exec;
+    if (b->nsuper > 0) nr_exec = exec_super(b, n, trace, &prev);
+    else {
+      nr_exec = exec_block(b, n, trace);
+      prev = b;
+      if (++ b->count == BLOCK_HOT_THRESHOLD) block_form_super(b);
+    }
+    g_nr_guest_inst += nr_exec;
+    n -= nr_exec;
+    if (nemu_state.state != NEMU_RUNNING || BP_HIT(cpu.pc)) break;
+    IFDEF(CONFIG_DEVICE, device_tick(nr_exec));
+    IFDEF(CONFIG_DEVICE, intr_check());
+  }
+  return n;
+}
+#elif defined(CONFIG_ENGINE_JIT)
+__attribute__((always_inline))
+static inline uint64_t execute_loop(uint64_t n, bool trace) {
+  Decode s;
+  while (n > 0) {
+    // execute instructions one by one for differential testing, while blocks
+    // end before breakpoints
+    uint64_t nr_exec = (trace && MUXDEF(CONFIG_DIFFTEST, true, false)) ? 0 : jit_exec(n);
+    if (nr_exec == 0) {
+      exec_once(&s, cpu.pc, trace);
+      if (trace) trace_and_difftest(&s, cpu.pc);
+      nr_exec = 1;
+    }
+    g_nr_guest_inst += nr_exec;
+    n -= nr_exec;
+    if (nemu_state.state != NEMU_RUNNING || BP_HIT(cpu.pc)) break;
+    IFDEF(CONFIG_DEVICE, device_tick(nr_exec));
+    IFDEF(CONFIG_DEVICE, intr_check());
+  }
+  return n;
+}
+#else
+__attribute__((always_inline))
+static inline uint64_t execute_loop(uint64_t n, bool trace) {
+  Decode s;
+  while (n > 0) {
+    // instructions are fused only when none is traced, checked by difftest or
+    // a watchpoint, or stopped at by a breakpoint or the end of the run
+    IFDEF(CONFIG_DECODE_FUSION, s.ninst = ((!trace || !TRACE_EACH_INST) && n > 1 && nr_bp == 0 &&
+        MUXDEF(CONFIG_WATCHPOINT, wp_nr_each == 0, true) ? 2 : 1));
+    exec_once(&s, cpu.pc, trace);
+    IFDEF(CONFIG_BBV, bbv_exec(s.pc, 1, s.dnpc != s.snpc));
+    IFDEF(CONFIG_COVERAGE, cov_inst(s.pc, s.dnpc != s.snpc));
+    g_nr_guest_inst += NR_EXEC(s);
+    n -= NR_EXEC(s);
+    if (trace) trace_and_difftest(&s, cpu.pc);
+    if (nemu_state.state != NEMU_RUNNING || BP_HIT(cpu.pc)) break;
+    IFDEF(CONFIG_DEVICE, device_tick(NR_EXEC(s)));
+    IFDEF(CONFIG_DEVICE, intr_check());
+  }
+  return n;
+}
+#endif
+
+static uint64_t execute_traced(uint64_t n) { return execute_loop(n, true); }
+static uint64_t execute_untraced(uint64_t n) { return execute_loop(n, false); }
+
+#ifdef CONFIG_MEM_EXCEPTION
+/* An exception raised deep inside an instruction, such as by a memory access
+ * through vaddr and paddr, jumps back here by cpu_raise_exception(), so that
+ * the accessors need no path to return a failure. The instruction is
+ * abandoned before it retires, with cpu.pc still pointing to it, and the
+ * execution goes on at the handler of the guest. Nothing but cpu.pc and
+ * g_nr_guest_inst, which the interpreter updates for each instruction,
+ * is needed after the jump. */
+static HART_LOCAL jmp_buf exc_env;
+static HART_LOCAL bool exc_armed = false;
+static HART_LOCAL word_t exc_no;
+
+void cpu_raise_exception(word_t NO) {
+  Assert(exc_armed, "exception %d is raised outside of an instruction at pc = " FMT_WORD, (int)NO, cpu.pc);
+  exc_no = NO;
+  longjmp(exc_env, 1);
+}
+
+// return the number of instructions left
+static uint64_t execute_guarded(uint64_t n, uint64_t (*exec)(uint64_t)) {
+  uint64_t start = g_nr_guest_inst;
+  if (setjmp(exc_env) != 0) {
+    exc_armed = false;
+    // REF is at the same instruction, let it take the exception as well
+    IFDEF(CONFIG_DIFFTEST, if (g_trace_on) ref_difftest_raise_intr(exc_no));
+    cpu.pc = isa_raise_intr(exc_no, cpu.pc);
+    if (g_nr_guest_inst - start >= n) return 0;
+  }
+  exc_armed = true;
+  uint64_t left = exec(n - (g_nr_guest_inst - start));
+  exc_armed = false;
+  return left;
+}
+#define EXECUTE(n, exec) execute_guarded(n, exec)
+#else
+#define EXECUTE(n, exec) (exec)(n)
+#endif
+
+void set_trace(bool on) {
+  if (on == g_trace_on) return;
+  g_trace_on = on;
+  if (on) difftest_attach();
+  else difftest_detach();
+}
+
+/* Fast-forwarding runs the untraced loop with breakpoints and watchpoints
+ * suspended until `g_nr_guest_inst` reaches `ff_target`, then goes back to
+ * the trace state before, with REF brought up to date by difftest_attach().
+ * It is given up if the execution stops earlier.
+ */
+static uint64_t ff_target = 0;
+static bool ff_on = false, ff_trace = false;
+static int ff_nr_bp = 0;
+IFDEF(CONFIG_WATCHPOINT, void wp_suspend(bool suspend));
+
+void cpu_set_ff(uint64_t n) { ff_target = n; }
+
+static void ff_enter() {
+  Log("Fast-forwarding to %" PRIu64 " instructions", ff_target);
+  ff_on = true;
+  ff_trace = g_trace_on;
+  ff_nr_bp = nr_bp;
+  nr_bp = 0;
+  IFDEF(CONFIG_WATCHPOINT, wp_suspend(true));
+  set_trace(false);
+}
+
+static void ff_leave() {
+  Log("Fast-forwarding %s at %" PRIu64 " instructions",
+      (g_nr_guest_inst < ff_target ? "is stopped" : "ends"), g_nr_guest_inst);
+  ff_on = false;
+  ff_target = 0;
+  nr_bp = ff_nr_bp;
+  IFDEF(CONFIG_WATCHPOINT, wp_suspend(false));
+  set_trace(ff_trace);
+}
+
+#ifndef CONFIG_TARGET_AM
+// executed in signal context, only stop the running loop
+static void trace_switch_handler(int sig) {
+  trace_switch_pending = true;
+  if (nemu_state.state == NEMU_RUNNING) nemu_state.state = NEMU_STOP;
+}
+
+void init_trace_switch() {
+  signal(SIGUSR1, trace_switch_handler);
+}
+
+/* Limits of a run by --max-inst and --timeout, and a report of the progress
+ * every --progress seconds, so that a guest running away in CI ends with a
+ * diagnosis. The host timer ticks every second, and only raises a flag and
+ * stops the running loop like SIGUSR1, so nothing is added to the path of
+ * each instruction. */
+static uint64_t max_inst = 0;
+static int timeout_sec = 0, progress_sec = 0;
+static volatile int host_sec = 0;
+static volatile bool host_timer_pending = false;
+static uint64_t progress_time = 0, progress_inst = 0;
+
+void cpu_set_max_inst(uint64_t n) { max_inst = n; }
+void cpu_set_timeout(int sec) { timeout_sec = sec; }
+void cpu_set_progress(int sec) { progress_sec = sec; }
+
+// executed in signal context, only stop the running loop
+static void host_timer_handler(int sig) {
+  int sec = ++ host_sec;
+  if ((timeout_sec > 0 && sec >= timeout_sec) || (progress_sec > 0 && sec % progress_sec == 0)) {
+    host_timer_pending = true;
+    if (nemu_state.state == NEMU_RUNNING) nemu_state.state = NEMU_STOP;
+  }
+}
+
+// also called by the children of the farm, which do not inherit the timer
+void init_host_timer() {
+  progress_time = get_time();
+  host_sec = 0;
+  host_timer_pending = false;
+  if (timeout_sec <= 0 && progress_sec <= 0) return;
+  signal(SIGALRM, host_timer_handler);
+  struct itimerval it = { .it_interval = { .tv_sec = 1 }, .it_value = { .tv_sec = 1 } };
+  int ret = setitimer(ITIMER_REAL, &it, NULL);
+  Assert(ret == 0, "Can not start the host timer");
+}
+
+static void report_progress() {
+  uint64_t now = get_time();
+  double mips = (now > progress_time ? (double)(g_nr_guest_inst - progress_inst) / (now - progress_time) : 0);
+  const char *sym = symbol_lookup(cpu.pc, NULL);
+  Log("progress: %" PRIu64 " instructions, %.2f MIPS, pc = " FMT_WORD "%s%s", g_nr_guest_inst, mips,
+      cpu.pc, (sym != NULL ? " in " : ""), (sym != NULL ? sym : ""));
+  progress_time = now;
+  progress_inst = g_nr_guest_inst;
+}
+
+// stop the guest as aborted by a limit of the run
+static void limit_abort(const char *why) {
+  Log("%s, stopping the guest", why);
+  report_progress();
+  set_nemu_state(NEMU_ABORT, cpu.pc, -1);
+}
+#endif
+
 static void execute(uint64_t n) {
+  while (true) {
+    if (trace_switch_pending) {
+      trace_switch_pending = false;
+      // while fast-forwarding, switch the state to go back to
+      if (ff_on) ff_trace = !ff_trace;
+      else set_trace(!g_trace_on);
+      bool on = (ff_on ? ff_trace : g_trace_on);
+      Log("Trace: %s", on ? ANSI_FMT("ON", ANSI_FG_GREEN) : ANSI_FMT("OFF", ANSI_FG_RED));
+    }
+    uint64_t m = n;
+#ifndef CONFIG_TARGET_AM
+    if (host_timer_pending) {
+      host_timer_pending = false;
+      if (timeout_sec > 0 && host_sec >= timeout_sec) {
+        char why[64];
+        snprintf(why, sizeof(why), "Timeout after %d s", timeout_sec);
+        limit_abort(why);
+        break;
+      }
+      report_progress();
+    }
+    if (max_inst != 0) {
+      if (g_nr_guest_inst >= max_inst) { limit_abort("The limit of instructions is reached"); break; }
+      if (max_inst - g_nr_guest_inst < m) m = max_inst - g_nr_guest_inst;
+    }
+#endif
+    if (ff_target > g_nr_guest_inst) {
+      if (!ff_on) ff_enter();
+      if (ff_target - g_nr_guest_inst < m) m = ff_target - g_nr_guest_inst;
+    }
+    else if (ff_on) ff_leave();
+#ifndef CONFIG_TARGET_AM
+    // windows by instruction count select the loop, and cut the run at their boundaries
+    bool in;
+    uint64_t boundary = (ff_on ? 0 : trace_window_next(&in));
+    if (boundary != 0) {
+      set_trace(in);
+      if (boundary < m) m = boundary;
+    }
+#endif
+    IFDEF(CONFIG_REVERSE, m = reverse_limit(m));
+    IFDEF(CONFIG_STATS, m = stats_limit(m));
+    IFDEF(CONFIG_BBV, m = bbv_limit(m));
+    IFDEF(CONFIG_SIMPOINT, m = simpoint_limit(m));
+    IFDEF(CONFIG_MULTI_HART, m = hart_limit(m));
+    IFDEF(CONFIG_INPUT_LOG, m = input_log_limit(m));
+    IFDEF(CONFIG_LIVE, m = live_limit(m));
+    uint64_t nr_exec = m - EXECUTE(m, g_trace_on ? execute_traced : execute_untraced);
+    n -= nr_exec;
+    IFDEF(CONFIG_REVERSE, reverse_advance(nr_exec));
+    IFDEF(CONFIG_STATS, stats_sample());
+    IFDEF(CONFIG_BBV, bbv_advance());
+    IFDEF(CONFIG_SIMPOINT, simpoint_advance());
+    IFDEF(CONFIG_MULTI_HART, hart_advance(nr_exec));
+    IFDEF(CONFIG_LIVE, live_update(false));
+    if (nemu_state.state == NEMU_RUNNING && n > 0) continue;
+    bool signaled = trace_switch_pending || MUXNDEF(CONFIG_TARGET_AM, host_timer_pending, false);
+    if (!signaled || nemu_state.state != NEMU_STOP) break;
+    // stopped by SIGUSR1 or the host timer, continue after handling it at the top
+    nemu_state.state = NEMU_RUNNING;
+  }
+  if (ff_on) ff_leave();
+}
+
+/* Used by difftest_exec() when NEMU serves as REF, and by the lockstep mode
+ * to run each instance. DUT may call it once for each instruction, so it
+ * goes to the untraced loop directly, skipping the timing and reporting of
+ * cpu_exec().
+ */
+void cpu_exec_ref(uint64_t n) {
+  if (nemu_state.state != NEMU_RUNNING && nemu_state.state != NEMU_STOP) return;
+  nemu_state.state = NEMU_RUNNING;
+  EXECUTE(n, execute_untraced);
+  if (nemu_state.state == NEMU_RUNNING) nemu_state.state = NEMU_STOP;
+}
+
+#ifdef CONFIG_HART_THREAD
+static void execute_hart(uint64_t n) {
   Decode s;
-  for (;n > 0; n --) {
-    exec_once(&s, cpu.pc);
-    g_nr_guest_inst ++;
-    trace_and_difftest(&s, cpu.pc);
-    if (nemu_state.state != NEMU_RUNNING) break;
-    IFDEF(CONFIG_DEVICE, device_update());
+  while (n > 0 && nemu_state.state == NEMU_RUNNING) {
+    IFDEF(CONFIG_DECODE_FUSION, s.ninst = (n > 1 ? 2 : 1));
+    exec_once(&s, cpu.pc, false);
+    n -= NR_EXEC(s);
+  }
+}
+
+/* Used by the host thread of each hart but hart 0 to run at most `n`
+ * instructions while the run of hart 0 goes on. These instructions are
+ * never traced nor counted, do not stop at breakpoints, and leave the
+ * devices and the interrupts to hart 0. An exception ends the call early.
+ */
+void cpu_exec_hart(uint64_t n) {
+#ifdef CONFIG_MEM_EXCEPTION
+  if (setjmp(exc_env) != 0) {
+    exc_armed = false;
+    cpu.pc = isa_raise_intr(exc_no, cpu.pc);
+    return;
   }
+  exc_armed = true;
+#endif
+  execute_hart(n);
+  IFDEF(CONFIG_MEM_EXCEPTION, exc_armed = false);
+}
+#endif
+
+#ifdef CONFIG_REVERSE
+/* Used by reverse execution to replay instructions, skipping the timing and
+ * reporting of cpu_exec(). Return true if the execution is stopped before
+ * `n` instructions, i.e. by a breakpoint or a watchpoint. */
+bool cpu_exec_replay(uint64_t n) {
+  if (nemu_state.state != NEMU_RUNNING && nemu_state.state != NEMU_STOP) return false;
+  g_print_step = false;
+  nemu_state.state = NEMU_RUNNING;
+  execute(n);
+  bool stopped = (nemu_state.state == NEMU_STOP);
+  if (nemu_state.state == NEMU_RUNNING) nemu_state.state = NEMU_STOP;
+  return stopped;
 }
+#endif
 
 static void statistic() {
   IFNDEF(CONFIG_TARGET_AM, setlocale(LC_NUMERIC, ""));
@@ -89,11 +675,48 @@ static void statistic() {
   Log("total guest instructions = " NUMBERIC_FMT, g_nr_guest_inst);
   if (g_timer > 0) Log("simulation frequency = " NUMBERIC_FMT " inst/s", g_nr_guest_inst * 1000000 / g_timer);
   else Log("Finish running in less than 1 us and can not calculate the simulation frequency");
+  IFDEF(CONFIG_PROFILE, void profile_report(); profile_report());
+  IFDEF(CONFIG_INST_STAT, void inst_stat_report(); inst_stat_report());
+  IFDEF(CONFIG_INST_COST, void map_cost_report(); map_cost_report());
+  IFDEF(CONFIG_CACHESIM, mtrace_cachesim_report());
+  IFDEF(CONFIG_STATS, void stats_report(); stats_report());
+  IFDEF(CONFIG_BBV, void bbv_report(); bbv_report());
+  IFDEF(CONFIG_COVERAGE, void cov_report(); cov_report());
+  IFDEF(CONFIG_TIMING, void timing_report(); timing_report());
+  IFDEF(CONFIG_FOOTPRINT, void footprint_report(); footprint_report());
 }
 
+#ifndef CONFIG_TARGET_AM
+// count from zero again, for the next image run in the same process
+void cpu_reset_statistic() {
+  g_nr_guest_inst = 0;
+  g_timer = 0;
+  IFDEF(CONFIG_TIMING, timing_cycle = 0);
+}
+
+// exchange the counters with those in `stat` of another image run in turns
+void cpu_swap_statistic(uint64_t stat[3]) {
+  uint64_t now[3] = { g_nr_guest_inst, g_timer, MUXDEF(CONFIG_TIMING, timing_cycle, 0) };
+  g_nr_guest_inst = stat[0];
+  g_timer = stat[1];
+  IFDEF(CONFIG_TIMING, timing_cycle = stat[2]);
+  memcpy(stat, now, sizeof(now));
+}
+
+void statistic_json(FILE *fp) {
+  fprintf(fp, "{\"host_time_us\":%" PRIu64 ",\"guest_inst\":%" PRIu64 ",\"frequency\":%" PRIu64,
+      g_timer, g_nr_guest_inst, (g_timer > 0 ? g_nr_guest_inst * 1000000 / g_timer : 0));
+  IFDEF(CONFIG_TIMING, fprintf(fp, ",\"cycles\":%" PRIu64, timing_cycle));
+  fprintf(fp, "}");
+}
+#endif
+
 void assert_fail_msg() {
+  IFDEF(CONFIG_IQUEUE, iqueue_dump());
+  IFDEF(CONFIG_ITRACE_BINARY, itrace_dump(ITRACE_NR_DUMP));
   isa_reg_display();
   statistic();
+  IFDEF(CONFIG_LOG_ASYNC, log_flush());
 }
 
 /* Simulate how the CPU works. */
@@ -107,9 +730,15 @@ void cpu_exec(uint64_t n) {
   }
 
   uint64_t timer_start = get_time();
+  IFDEF(CONFIG_STATS, stats_exec(true));
 
+  IFDEF(CONFIG_HART_THREAD, hart_resume());
   execute(n);
+  IFDEF(CONFIG_HART_THREAD, hart_pause());
+  IFDEF(CONFIG_HAS_SERIAL, void serial_flush(); serial_flush());
+  IFDEF(CONFIG_DIFFTEST, STATS_TIME(STATS_DIFFTEST, difftest_sync()));
 
+  IFDEF(CONFIG_STATS, stats_exec(false));
   uint64_t timer_end = get_time();
   g_timer += timer_end - timer_start;
 
@@ -117,12 +746,23 @@ void cpu_exec(uint64_t n) {
     case NEMU_RUNNING: nemu_state.state = NEMU_STOP; break;
 
     case NEMU_END: case NEMU_ABORT:
+#ifndef CONFIG_TARGET_AM
+      // a hash of pmem other than the one expected by --hash-mem fails the guest
+      if (nemu_state.state == NEMU_END && !memhash_check()) nemu_state.halt_ret = 1;
+#endif
       Log("nemu: %s at pc = " FMT_WORD,
           (nemu_state.state == NEMU_ABORT ? ANSI_FMT("ABORT", ANSI_FG_RED) :
            (nemu_state.halt_ret == 0 ? ANSI_FMT("HIT GOOD TRAP", ANSI_FG_GREEN) :
             ANSI_FMT("HIT BAD TRAP", ANSI_FG_RED))),
           nemu_state.halt_pc);
+      if (nemu_state.state == NEMU_ABORT || nemu_state.halt_ret != 0) {
+        IFDEF(CONFIG_ITRACE_BINARY, itrace_dump(ITRACE_NR_DUMP));
+        // an invalid instruction has shown the queue already
+        IFDEF(CONFIG_IQUEUE, if (nemu_state.state != NEMU_ABORT) iqueue_dump());
+      }
       // fall through
     case NEMU_QUIT: statistic();
   }
+  IFDEF(CONFIG_LOG_ASYNC, if (nemu_state.state == NEMU_ABORT) log_flush());
+  IFDEF(CONFIG_LIVE, live_update(true));
 }
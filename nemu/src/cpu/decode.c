@@ -0,0 +1,129 @@
+/***************************************************************************************
+* Copyright (c) 2014-2024 Zihao Yu, Nanjing University
+*
+* NEMU is licensed under Mulan PSL v2.
+* You can use this software according to the terms and conditions of the Mulan PSL v2.
+* You may obtain a copy of Mulan PSL v2 at:
+*          http://license.coscl.org.cn/MulanPSL2
+*
+* THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+* EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+* MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+*
+* See the Mulan PSL v2 for more details.
+***************************************************************************************/
+
+
+#include <cpu/decode.h>
+
+#ifdef CONFIG_INSTPAT_TREE
+void instpat_tree_add(InstPatTree *t, uint64_t key, uint64_t mask, uint64_t shift, const void *body) {
+  Assert(t->nr_pat < INSTPAT_TREE_MAX, "too many patterns");
+  t->pat[t->nr_pat ++] = (InstPat) { .key = key << shift, .mask = mask << shift, .body = body };
+}
+
+// scatter the bits of `key` to the positions of the set bits in `mask`
+static uint64_t deposit(uint64_t key, uint64_t mask) {
+  uint64_t res = 0;
+  int i;
+  for (i = 0; mask != 0; mask &= mask - 1, i ++) {
+    if ((key >> i) & 1) res |= mask & -mask;
+  }
+  return res;
+}
+
+void instpat_tree_build(InstPatTree *t, uint64_t tree_mask, const void *end) {
+  int i;
+  for (i = 0; i < t->nr_pat; i ++) {
+    t->pat[i].exact = (t->pat[i].mask & ~tree_mask) == 0;
+  }
+  // matching nothing reaches the end of decoding
+  t->pat[t->nr_pat] = (InstPat) { .key = 0, .mask = 0, .body = end, .exact = true };
+
+  uint64_t nr_key = 1ull << __builtin_popcountll(tree_mask);
+  uint8_t *first = malloc(nr_key);
+  assert(first);
+  uint64_t k;
+  for (k = 0; k < nr_key; k ++) {
+    uint64_t inst = deposit(k, tree_mask);
+    for (i = 0; i < t->nr_pat; i ++) {
+      InstPat *p = &t->pat[i];
+      if (((inst ^ p->key) & p->mask & tree_mask) == 0) break;
+    }
+    first[k] = i;
+  }
+  t->first = first;
+}
+
+typedef struct {
+  const int *lo;
+  int nr_level;
+  uint32_t *node;
+  uint32_t nr_node, max_node;
+} LevelBuilder;
+
+// the bits of the field indexing level `l`
+static uint64_t level_mask(LevelBuilder *b, int l) {
+  int hi = (l == 0 ? 31 : b->lo[l - 1] - 1);
+  return BITMASK(hi - b->lo[l] + 1) << b->lo[l];
+}
+
+// build the table of level `l` for the instructions with the bits `known`
+// being `key`, and return its offset in b->node
+static uint32_t build_level(InstPatTree *t, LevelBuilder *b, int l, uint64_t key, uint64_t known) {
+  uint64_t field = level_mask(b, l);
+  uint64_t deeper = 0;
+  int i;
+  for (i = l + 1; i < b->nr_level; i ++) deeper |= level_mask(b, i);
+
+  uint32_t n = 1u << __builtin_popcountll(field);
+  uint32_t base = b->nr_node;
+  b->nr_node += n;
+  if (b->nr_node > b->max_node) {
+    while (b->nr_node > b->max_node) b->max_node = (b->max_node == 0 ? 1024 : b->max_node * 2);
+    b->node = realloc(b->node, sizeof(b->node[0]) * b->max_node);
+    assert(b->node);
+  }
+
+  uint32_t k;
+  for (k = 0; k < n; k ++) {
+    uint64_t inst = key | ((uint64_t)k << b->lo[l]);
+    uint64_t m = known | field;
+    for (i = 0; i < t->nr_pat; i ++) {
+      InstPat *p = &t->pat[i];
+      if (((inst ^ p->key) & p->mask & m) == 0) break;
+    }
+    uint64_t rest = t->pat[i].mask & ~m; // nothing for the end of decoding
+    uint32_t e = i;
+    if (rest & deeper) {
+      uint32_t next = build_level(t, b, l + 1, inst, m);
+      assert(next < INSTPAT_CHECK);
+      e = next | INSTPAT_NODE;
+    } else if (rest != 0) {
+      e |= INSTPAT_CHECK;
+    }
+    b->node[base + k] = e;
+  }
+  return base;
+}
+
+void instpat_tree_build_levels(InstPatTree *t, const int *lo, int nr_level, const void *end) {
+  // matching nothing reaches the end of decoding
+  t->pat[t->nr_pat] = (InstPat) { .key = 0, .mask = 0, .body = end, .exact = true };
+
+  LevelBuilder b = { .lo = lo, .nr_level = nr_level };
+  build_level(t, &b, 0, 0, 0);
+  t->node = realloc(b.node, sizeof(b.node[0]) * b.nr_node);
+  assert(t->node);
+}
+
+const void* instpat_tree_check(InstPatTree *t, uint64_t inst, const void *body) {
+  int i;
+  for (i = 0; i < t->nr_pat; i ++) {
+    if (((inst ^ t->pat[i].key) & t->pat[i].mask) == 0) break;
+  }
+  Assert(t->pat[i].body == body, "decode tree selects a wrong pattern for inst = " FMT_WORD
+      ", expected pattern #%d", (word_t)inst, i);
+  return body;
+}
+#endif
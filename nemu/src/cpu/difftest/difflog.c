@@ -0,0 +1,109 @@
+/***************************************************************************************
+* Copyright (c) 2014-2024 Zihao Yu, Nanjing University
+*
+* NEMU is licensed under Mulan PSL v2.
+* You can use this software according to the terms and conditions of the Mulan PSL v2.
+* You may obtain a copy of Mulan PSL v2 at:
+*          http://license.coscl.org.cn/MulanPSL2
+*
+* THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+* EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+* MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+*
+* See the Mulan PSL v2 for more details.
+***************************************************************************************/
+
+
+#include <common.h>
+#include <difftest-def.h>
+#include <zlib.h>
+
+/* The log of REF has one entry for each instruction checked by
+ * difftest_step(), either the registers of REF after it, or a mark that it
+ * is not checked. The registers are seen as 32-bit chunks, and an entry
+ * only keeps the chunks changed since the last entry:
+ *
+ *   uint8_t n;                            // DIFFLOG_SKIP if not checked
+ *   struct { uint8_t idx; uint32_t val; } chunk[n];
+ *
+ * and the whole file is compressed by zlib.
+ */
+#define NR_CHUNK (DIFFTEST_REG_SIZE / sizeof(uint32_t))
+#define DIFFLOG_SKIP 0xff
+#define DIFFLOG_MAGIC "NEMUDLOG"
+
+static_assert(DIFFTEST_REG_SIZE % sizeof(uint32_t) == 0 && NR_CHUNK < DIFFLOG_SKIP,
+    "registers of REF can not be encoded");
+
+static gzFile log_gz = NULL;
+static uint32_t last[NR_CHUNK] = {};
+static uint64_t nr_entry = 0;
+
+static void difflog_close() {
+  if (log_gz == NULL) return;
+  gzclose(log_gz);
+  log_gz = NULL;
+  Log("DiffTest log: %" PRIu64 " entries", nr_entry);
+}
+
+bool difflog_open(const char *file, bool replay) {
+  char magic[8];
+  uint32_t reg_size = DIFFTEST_REG_SIZE;
+  // recording is not worth a slow compression level
+  log_gz = gzopen(file, replay ? "rb" : "wb1");
+  if (log_gz == NULL) return false;
+  gzbuffer(log_gz, 1 << 20);
+  if (replay) {
+    if (gzread(log_gz, magic, sizeof(magic)) != sizeof(magic) ||
+        gzread(log_gz, &reg_size, sizeof(reg_size)) != sizeof(reg_size)) return false;
+    Assert(memcmp(magic, DIFFLOG_MAGIC, sizeof(magic)) == 0 && reg_size == DIFFTEST_REG_SIZE,
+        "'%s' is not a DiffTest log of this ISA", file);
+  } else {
+    gzwrite(log_gz, DIFFLOG_MAGIC, sizeof(magic));
+    gzwrite(log_gz, &reg_size, sizeof(reg_size));
+  }
+  atexit(difflog_close);
+  return true;
+}
+
+// write the registers of REF, or NULL if the instruction is not checked
+void difflog_write(const void *ref_r) {
+  uint8_t buf[1 + NR_CHUNK * 5];
+  int len = 1, i;
+  if (ref_r == NULL) buf[0] = DIFFLOG_SKIP;
+  else {
+    buf[0] = 0;
+    const uint8_t *r = ref_r;
+    for (i = 0; i < NR_CHUNK; i ++) {
+      uint32_t val;
+      memcpy(&val, r + i * sizeof(val), sizeof(val));
+      if (val == last[i]) continue;
+      last[i] = val;
+      buf[len] = i;
+      memcpy(buf + len + 1, &val, sizeof(val));
+      len += 5;
+      buf[0] ++;
+    }
+  }
+  gzwrite(log_gz, buf, len);
+  nr_entry ++;
+}
+
+// read the registers of REF, and return 1 if the instruction is checked,
+// 0 if it is not, or -1 at the end of the log
+int difflog_read(void *ref_r) {
+  int n = gzgetc(log_gz);
+  if (n < 0) return -1;
+  nr_entry ++;
+  if (n == DIFFLOG_SKIP) return 0;
+  Assert(n <= NR_CHUNK, "DiffTest log is broken at entry %" PRIu64, nr_entry);
+  int i;
+  for (i = 0; i < n; i ++) {
+    uint8_t chunk[5];
+    if (gzread(log_gz, chunk, sizeof(chunk)) != sizeof(chunk)) return -1;
+    Assert(chunk[0] < NR_CHUNK, "DiffTest log is broken at entry %" PRIu64, nr_entry);
+    memcpy(&last[chunk[0]], chunk + 1, sizeof(uint32_t));
+  }
+  memcpy(ref_r, last, DIFFTEST_REG_SIZE);
+  return 1;
+}
@@ -20,20 +20,100 @@
 #include <memory/paddr.h>
 #include <utils.h>
 #include <difftest-def.h>
+#ifdef CONFIG_LIVE
+#include <live-def.h>
+extern LiveCounters *live;
+#endif
+#ifdef CONFIG_DIFFTEST_PIPELINE
+#include <pthread.h>
+#include <sched.h>
+#endif
 
 void (*ref_difftest_memcpy)(paddr_t addr, void *buf, size_t n, bool direction) = NULL;
 void (*ref_difftest_regcpy)(void *dut, bool direction) = NULL;
 void (*ref_difftest_exec)(uint64_t n) = NULL;
 void (*ref_difftest_raise_intr)(uint64_t NO) = NULL;
+// optional, NULL if REF does not provide them
+bool (*ref_difftest_run_to)(uint64_t pc) = NULL;
+void (*ref_difftest_dirty_pages)(uint64_t *bitmap) = NULL;
+void (*ref_difftest_exec_log)(uint64_t n, void *log) = NULL;
 
 #ifdef CONFIG_DIFFTEST
 
 static bool is_skip_ref = false;
 static int skip_dut_nr_inst = 0;
+static bool is_detach = false;
+// the state of DUT after a run of instructions skipped, which is only
+// copied to REF right before REF runs again
+static CPU_state skip_state;
+static bool skip_pending = false;
+
+static void sync_skipped() {
+  if (!skip_pending) return;
+  skip_pending = false;
+  isa_sync_regs(&skip_state);
+  ref_difftest_regcpy(&skip_state, DIFFTEST_TO_REF);
+}
+
+#ifdef CONFIG_DIFFTEST_BATCH
+static void batch_check(bool early);
+#endif
+
+#ifdef CONFIG_DIFFTEST_LOG
+/* The states of REF checked by difftest_step() can be recorded to a file,
+ * and DUT can be checked against the file later without loading REF, if
+ * it runs the same instructions with the same input.
+ */
+bool difflog_open(const char *file, bool replay);
+void difflog_write(const void *ref_r);
+int difflog_read(void *ref_r);
+
+static char *log_file = NULL;
+static bool is_record = false, is_replay = false;
+
+void difftest_set_log(char *file, bool replay) {
+  log_file = file;
+  is_record = !replay;
+  is_replay = replay;
+}
+
+static void init_log() {
+  Assert(!is_record || !(ISDEF(CONFIG_DIFFTEST_BATCH) || ISDEF(CONFIG_DIFFTEST_PIPELINE)),
+      "Recording the states of REF needs DiffTest to step REF with DUT");
+  bool ok = difflog_open(log_file, is_replay);
+  Assert(ok, "Can not open '%s'", log_file);
+  Log("DiffTest %s %s", (is_replay ? "checks the states of REF in" : "records the states of REF to"), log_file);
+}
+
+static void log_ref_memcpy(paddr_t addr, void *buf, size_t n, bool direction) {
+  Assert(direction == DIFFTEST_TO_REF, "The memory of REF is not in the log");
+}
+static void log_ref_regcpy(void *dut, bool direction) { }
+static void log_ref_exec(uint64_t n) { }
+static void log_ref_raise_intr(uint64_t NO) { }
+
+static void checkregs(CPU_state *ref, vaddr_t pc);
+
+static void replay_step(vaddr_t pc) {
+  CPU_state ref_r = cpu;
+  int ret = difflog_read(&ref_r);
+  if (ret < 0) {
+    Log("The log of REF ends at pc = " FMT_WORD ", stop checking", pc);
+    is_detach = true;
+  }
+  else if (ret > 0) checkregs(&ref_r, pc);
+}
+
+#define RECORD(ref_r) do { if (is_record) difflog_write(ref_r); } while (0)
+#else
+#define RECORD(ref_r)
+#endif
 
 // this is used to let ref skip instructions which
 // can not produce consistent behavior with NEMU
 void difftest_skip_ref() {
+  // let REF catch up with the instructions before this one
+  IFDEF(CONFIG_DIFFTEST_BATCH, if (!is_detach) batch_check(true));
   is_skip_ref = true;
   // If such an instruction is one of the instruction packing in QEMU
   // (see below), we end the process of catching up with QEMU's pc to
@@ -52,6 +132,8 @@ void difftest_skip_ref() {
 //   Let REF run `nr_ref` instructions first.
 //   We expect that DUT will catch up with REF within `nr_dut` instructions.
 void difftest_skip_dut(int nr_ref, int nr_dut) {
+  IFDEF(CONFIG_DIFFTEST_BATCH, if (!is_detach) batch_check(true));
+  sync_skipped();
   skip_dut_nr_inst += nr_dut;
 
   while (nr_ref -- > 0) {
@@ -59,7 +141,409 @@ void difftest_skip_dut(int nr_ref, int nr_dut) {
   }
 }
 
+#ifdef CONFIG_PMEM_DIRTY
+// call `fn` on each run of dirty pages, and clear them
+static void for_each_dirty_run(void (*fn)(paddr_t addr, size_t len)) {
+  paddr_t page = CONFIG_MBASE;
+  while (paddr_next_dirty(&page)) {
+    paddr_t end = page + PAGE_SIZE;
+    while (in_pmem(end) && paddr_is_dirty(end)) end += PAGE_SIZE;
+    fn(page, end - page);
+    paddr_clear_dirty(page, end - page);
+    if (!in_pmem(end)) break;
+    page = end;
+  }
+}
+#endif
+
+#ifdef CONFIG_DIFFTEST_MEMCHECK
+/* Every DIFFTEST_MEMCHECK_INTERVAL instructions, the pages written since the
+ * last memory check are read back from REF and compared with DUT, so the
+ * cost is proportional to the pages written instead of the size of pmem.
+ * Pages whose dirty bits are consumed by someone else meanwhile, e.g. by a
+ * checkpoint of batched checking, are remembered in `unchecked`.
+ */
+#define NR_PMEM_PAGE (CONFIG_MSIZE / PAGE_SIZE)
+#define MEMCHECK_MAX_REPORT 8
+
+static uint64_t unchecked[(NR_PMEM_PAGE + 63) / 64] = {};
+static uint64_t memcheck_next = CONFIG_DIFFTEST_MEMCHECK_INTERVAL;
+
+static void mark_unchecked(paddr_t addr, size_t len) {
+  uint64_t l = (addr - CONFIG_MBASE) >> PAGE_SHIFT;
+  uint64_t r = (addr - CONFIG_MBASE + len - 1) >> PAGE_SHIFT;
+  for (; l <= r; l ++) unchecked[l / 64] |= 1ull << (l % 64);
+}
+
+// return the number of bytes different in the page, and report it
+static int compare_page(paddr_t page, bool report) {
+  static uint8_t ref_page[PAGE_SIZE];
+  ref_difftest_memcpy(page, ref_page, PAGE_SIZE, DIFFTEST_TO_DUT);
+  uint8_t *dut_page = guest_to_host(page);
+  if (memcmp(ref_page, dut_page, PAGE_SIZE) == 0) return 0;
+  int i, n = 0, first = 0;
+  for (i = PAGE_SIZE - 1; i >= 0; i --) {
+    if (ref_page[i] != dut_page[i]) { n ++; first = i; }
+  }
+  if (report) {
+    Log("pmem page " FMT_PADDR " is different in %d bytes, first at " FMT_PADDR
+        ", right = 0x%02x, wrong = 0x%02x", page, n, page + first, ref_page[first], dut_page[first]);
+  }
+  return n;
+}
+
+// should be called when REF is in step with DUT
+static void memcheck(vaddr_t pc) {
+  extern uint64_t g_nr_guest_inst;
+  if (g_nr_guest_inst < memcheck_next) return;
+  memcheck_next = g_nr_guest_inst + CONFIG_DIFFTEST_MEMCHECK_INTERVAL;
+
+  for_each_dirty_run(mark_unchecked);
+  // pages written by REF only are also different
+  if (ref_difftest_dirty_pages != NULL) ref_difftest_dirty_pages(unchecked);
+  int nr_bad = 0, i;
+  for (i = 0; i < ARRLEN(unchecked); i ++) {
+    while (unchecked[i] != 0) {
+      uint64_t idx = (uint64_t)i * 64 + __builtin_ctzll(unchecked[i]);
+      unchecked[i] &= unchecked[i] - 1;
+      paddr_t page = CONFIG_MBASE + (idx << PAGE_SHIFT);
+      if (compare_page(page, nr_bad < MEMCHECK_MAX_REPORT) > 0) nr_bad ++;
+    }
+  }
+  if (nr_bad > 0) {
+    Log("%d pages are different after executing instruction at pc = " FMT_WORD, nr_bad, pc);
+    nemu_state.state = NEMU_ABORT;
+    nemu_state.halt_pc = pc;
+  }
+}
+#endif
+
+#ifdef CONFIG_DIFFTEST_BATCH
+/* Batched checking. DUT runs ahead and logs its state after each
+ * instruction, and REF catches up by a single ref_difftest_exec() once
+ * `batch` instructions are pending, or right before an instruction REF can
+ * not execute. The batch is doubled after each full batch checked, up to
+ * CONFIG_DIFFTEST_BATCH_MAX, and halved when a check is forced earlier.
+ *
+ * Each successful check is a checkpoint: the pages written since the last
+ * one are copied to `ckpt_mem`. On a mismatch, REF is restored from the
+ * checkpoint and stepped one instruction at a time against the log, to
+ * find the first instruction diverging. If REF provides difftest_exec_log(),
+ * it returns its registers after each of these instructions in one call.
+ *
+ * If REF provides difftest_run_to(), it runs freely to the pc after the
+ * batch when that pc is not executed in the batch. This may be inexact,
+ * e.g. KVM can not patch pushf then. If a batch run freely only mismatches
+ * before stepping again, checking goes on and REF is always stepped later.
+ * REF is not run freely with CONFIG_DIFFTEST_MEMCHECK, since an inexact
+ * run may leave a difference in memory only.
+ */
+static CPU_state *dut_log = NULL;
+static vaddr_t *dut_log_pc = NULL;
+static int nr_pending = 0;
+static int batch = 1;
+static bool free_run = !ISDEF(CONFIG_DIFFTEST_MEMCHECK);
+static CPU_state ckpt_cpu;
+static uint8_t *ckpt_mem = NULL;
+// registers of REF after each instruction, if REF provides difftest_exec_log()
+static uint8_t *ref_log = NULL;
+
+static void copy_to_ckpt(paddr_t addr, size_t len) {
+  memcpy(ckpt_mem + (addr - CONFIG_MBASE), guest_to_host(addr), len);
+  IFDEF(CONFIG_DIFFTEST_MEMCHECK, mark_unchecked(addr, len));
+}
+#endif
+
+#ifdef CONFIG_PMEM_DIRTY
+static void copy_to_ref(paddr_t addr, size_t len) {
+  ref_difftest_memcpy(addr, guest_to_host(addr), len, DIFFTEST_TO_REF);
+  IFDEF(CONFIG_DIFFTEST_BATCH, copy_to_ckpt(addr, len));
+}
+#endif
+
+#ifdef CONFIG_DIFFTEST_BATCH
+static void checkpoint(const CPU_state *state) {
+  ckpt_cpu = *state;
+  for_each_dirty_run(copy_to_ckpt);
+}
+
+static void checkregs(CPU_state *ref, vaddr_t pc);
+
+// compare REF stepping from the checkpoint with each state in the log,
+// return true if they agree
+static bool bisect(bool ran_freely) {
+  Log("Mismatch after a batch of %d instructions, stepping again from the last checkpoint", nr_pending);
+  ref_difftest_memcpy(CONFIG_MBASE, ckpt_mem, CONFIG_MSIZE, DIFFTEST_TO_REF);
+  isa_sync_regs(&ckpt_cpu);
+  ref_difftest_regcpy(&ckpt_cpu, DIFFTEST_TO_REF);
+  CPU_state now = cpu;
+  if (ref_log != NULL) ref_difftest_exec_log(nr_pending, ref_log);
+  int i;
+  for (i = 0; i < nr_pending; i ++) {
+    CPU_state ref_r;
+    if (ref_log != NULL) memcpy(&ref_r, ref_log + i * DIFFTEST_REG_SIZE, DIFFTEST_REG_SIZE);
+    else {
+      ref_difftest_exec(1);
+      ref_difftest_regcpy(&ref_r, DIFFTEST_TO_DUT);
+    }
+    // registers are shown as they were after the instruction diverging,
+    // but the memory of DUT is not rolled back
+    cpu = dut_log[i];
+    checkregs(&ref_r, dut_log_pc[i]);
+    if (nemu_state.state == NEMU_ABORT) return false;
+  }
+  cpu = now;
+  if (ran_freely) {
+    Log_warn("REF can not run freely to the end of a batch exactly, stepping it from now on");
+    free_run = false;
+    return true;
+  }
+  Log_warn("The mismatch in the batch can not be reproduced step by step");
+  nemu_state.state = NEMU_ABORT;
+  nemu_state.halt_pc = dut_log_pc[nr_pending - 1];
+  return false;
+}
+
+// let REF run freely to the pc after the batch, if it is not executed in the batch
+static bool run_to_batch_end() {
+  if (!free_run || ref_difftest_run_to == NULL || nr_pending == 1) return false;
+  vaddr_t end = dut_log[nr_pending - 1].pc;
+  int i;
+  for (i = 0; i < nr_pending; i ++) {
+    if (dut_log_pc[i] == end) return false;
+  }
+  return ref_difftest_run_to(end);
+}
+
+static void batch_check(bool early) {
+  if (nr_pending == 0) return;
+  CPU_state ref_r;
+  bool ran_freely = run_to_batch_end();
+  if (!ran_freely) ref_difftest_exec(nr_pending);
+  ref_difftest_regcpy(&ref_r, DIFFTEST_TO_DUT);
+  CPU_state now = cpu;
+  cpu = dut_log[nr_pending - 1];
+  bool ok = isa_difftest_checkregs(&ref_r, dut_log_pc[nr_pending - 1]);
+  cpu = now;
+  if (!ok) ok = bisect(ran_freely);
+  if (ok) {
+    checkpoint(&dut_log[nr_pending - 1]);
+    IFDEF(CONFIG_DIFFTEST_MEMCHECK, memcheck(dut_log_pc[nr_pending - 1]));
+    if (early) batch = (batch > 1 ? batch / 2 : 1);
+    else batch = (batch * 2 < CONFIG_DIFFTEST_BATCH_MAX ? batch * 2 : CONFIG_DIFFTEST_BATCH_MAX);
+  }
+  nr_pending = 0;
+}
+
+void difftest_sync() {
+  if (!is_detach) batch_check(true);
+}
+
+static void init_batch() {
+  dut_log = malloc(sizeof(*dut_log) * CONFIG_DIFFTEST_BATCH_MAX);
+  dut_log_pc = malloc(sizeof(*dut_log_pc) * CONFIG_DIFFTEST_BATCH_MAX);
+  ckpt_mem = malloc(CONFIG_MSIZE);
+  assert(dut_log && dut_log_pc && ckpt_mem);
+  if (ref_difftest_exec_log != NULL) {
+    ref_log = malloc(DIFFTEST_REG_SIZE * CONFIG_DIFFTEST_BATCH_MAX);
+    assert(ref_log);
+  }
+  FOOTPRINT("difftest", ckpt_mem, CONFIG_MSIZE);
+  memcpy(ckpt_mem, guest_to_host(CONFIG_MBASE), CONFIG_MSIZE);
+  paddr_clear_dirty(CONFIG_MBASE, CONFIG_MSIZE);
+  ckpt_cpu = cpu;
+}
+#elif defined(CONFIG_DIFFTEST_PIPELINE)
+/* Pipelined checking. DUT pushes its state after each instruction into a
+ * single-producer single-consumer ring, and the REF thread steps REF and
+ * compares the states meanwhile. Only the REF thread calls REF while the
+ * ring is not empty: the other requests to REF go through the wrappers
+ * below, which wait for the ring to drain first.
+ *
+ * The REF thread compares the bytes of the registers. On a difference, it
+ * waits for DUT to check them by isa_difftest_checkregs(), which may
+ * tolerate the difference and let the thread go on.
+ */
+#define PIPE_SIZE CONFIG_DIFFTEST_PIPELINE_SIZE
+#define PIPE_HISTORY 16
+
+static_assert((PIPE_SIZE & (PIPE_SIZE - 1)) == 0, "the size of the ring should be a power of 2");
+
+typedef struct {
+  CPU_state state;
+  vaddr_t pc;
+} PipeRecord;
+
+static PipeRecord pipe_ring[PIPE_SIZE];
+static uint64_t pipe_head = 0, pipe_tail = 0;
+// set by the REF thread on a difference, and cleared by DUT if tolerated
+static bool pipe_diff = false;
+static CPU_state pipe_ref_r;
+static vaddr_t pipe_history[PIPE_HISTORY];
+// no more states are checked after a mismatch
+static bool pipe_stopped = false;
+static pthread_t pipe_thread;
+
+static void (*pipe_ref_memcpy)(paddr_t addr, void *buf, size_t n, bool direction) = NULL;
+static void (*pipe_ref_regcpy)(void *dut, bool direction) = NULL;
+static void (*pipe_ref_exec)(uint64_t n) = NULL;
+static void (*pipe_ref_raise_intr)(uint64_t NO) = NULL;
+static void (*pipe_ref_dirty_pages)(uint64_t *bitmap) = NULL;
+
+static void* ref_thread(void *arg) {
+  uint64_t t = 0;
+  while (true) {
+    if (__atomic_load_n(&pipe_head, __ATOMIC_ACQUIRE) == t) {
+      sched_yield();
+      continue;
+    }
+    PipeRecord *r = &pipe_ring[t % PIPE_SIZE];
+    CPU_state ref_r;
+    pipe_ref_exec(1);
+    pipe_ref_regcpy(&ref_r, DIFFTEST_TO_DUT);
+    pipe_history[t % PIPE_HISTORY] = r->pc;
+    if (memcmp(&ref_r, &r->state, DIFFTEST_REG_SIZE) != 0) {
+      pipe_ref_r = ref_r;
+      __atomic_store_n(&pipe_diff, true, __ATOMIC_RELEASE);
+      while (__atomic_load_n(&pipe_diff, __ATOMIC_ACQUIRE)) sched_yield();
+    }
+    t ++;
+    __atomic_store_n(&pipe_tail, t, __ATOMIC_RELEASE);
+  }
+  return NULL;
+}
+
+static void checkregs(CPU_state *ref, vaddr_t pc);
+
+// check the difference found by the REF thread, if any
+static void pipeline_verdict() {
+  if (!__atomic_load_n(&pipe_diff, __ATOMIC_ACQUIRE)) return;
+  uint64_t t = pipe_tail;
+  PipeRecord *r = &pipe_ring[t % PIPE_SIZE];
+  CPU_state now = cpu;
+  // registers are shown as they were after the instruction diverging,
+  // but the memory of DUT is not rolled back
+  cpu = r->state;
+  checkregs(&pipe_ref_r, r->pc);
+  if (nemu_state.state != NEMU_ABORT) {
+    cpu = now;
+    __atomic_store_n(&pipe_diff, false, __ATOMIC_RELEASE);
+    return;
+  }
+  pipe_stopped = true;
+  Log("DUT was %" PRIu64 " instructions ahead. The instructions checked before it are:",
+      pipe_head - t - 1);
+  uint64_t i = (t >= PIPE_HISTORY - 1 ? t - (PIPE_HISTORY - 1) : 0);
+  for (; i < t; i ++) Log("  " FMT_WORD, pipe_history[i % PIPE_HISTORY]);
+}
+
+static void pipeline_push(vaddr_t pc) {
+  pipeline_verdict();
+  if (pipe_stopped) return;
+  uint64_t h = pipe_head;
+  while (h - __atomic_load_n(&pipe_tail, __ATOMIC_ACQUIRE) == PIPE_SIZE) {
+    pipeline_verdict();
+    if (pipe_stopped) return;
+    sched_yield();
+  }
+  // REF compares the bytes of the state
+  isa_sync_regs(&cpu);
+  pipe_ring[h % PIPE_SIZE] = (PipeRecord) { .state = cpu, .pc = pc };
+  __atomic_store_n(&pipe_head, h + 1, __ATOMIC_RELEASE);
+}
+
+// wait until REF catches up with DUT, or stops at a mismatch
+static void pipeline_drain() {
+  while (!pipe_stopped && __atomic_load_n(&pipe_tail, __ATOMIC_ACQUIRE) != pipe_head) {
+    pipeline_verdict();
+    sched_yield();
+  }
+}
+
+void difftest_sync() {
+  pipeline_drain();
+}
+
+static void pipe_memcpy(paddr_t addr, void *buf, size_t n, bool direction) {
+  pipeline_drain();
+  pipe_ref_memcpy(addr, buf, n, direction);
+}
+
+static void pipe_regcpy(void *dut, bool direction) {
+  pipeline_drain();
+  pipe_ref_regcpy(dut, direction);
+}
+
+static void pipe_exec(uint64_t n) {
+  pipeline_drain();
+  pipe_ref_exec(n);
+}
+
+static void pipe_raise_intr(uint64_t NO) {
+  pipeline_drain();
+  pipe_ref_raise_intr(NO);
+}
+
+static void pipe_dirty_pages(uint64_t *bitmap) {
+  pipeline_drain();
+  pipe_ref_dirty_pages(bitmap);
+}
+
+static void init_pipeline() {
+  pipe_ref_memcpy = ref_difftest_memcpy;
+  pipe_ref_regcpy = ref_difftest_regcpy;
+  pipe_ref_exec = ref_difftest_exec;
+  pipe_ref_raise_intr = ref_difftest_raise_intr;
+  pipe_ref_dirty_pages = ref_difftest_dirty_pages;
+  ref_difftest_memcpy = pipe_memcpy;
+  ref_difftest_regcpy = pipe_regcpy;
+  ref_difftest_exec = pipe_exec;
+  ref_difftest_raise_intr = pipe_raise_intr;
+  if (ref_difftest_dirty_pages != NULL) ref_difftest_dirty_pages = pipe_dirty_pages;
+  int ret = pthread_create(&pipe_thread, NULL, ref_thread, NULL);
+  Assert(ret == 0, "Can not create the thread of REF");
+}
+#else
+void difftest_sync() { }
+#endif
+
+// stop checking, e.g. while running the untraced loop
+void difftest_detach() {
+  difftest_sync();
+  is_detach = true;
+  IFDEF(CONFIG_PMEM_DIRTY, paddr_clear_dirty(CONFIG_MBASE, CONFIG_MSIZE));
+}
+
+// continue checking, with the state of REF brought up to date with DUT
+void difftest_attach() {
+  is_detach = false;
+  is_skip_ref = false;
+  skip_pending = false;
+  skip_dut_nr_inst = 0;
+#ifdef CONFIG_PMEM_DIRTY
+  // only the pages written since detaching are out of date
+  for_each_dirty_run(copy_to_ref);
+#else
+  ref_difftest_memcpy(CONFIG_MBASE, guest_to_host(CONFIG_MBASE), CONFIG_MSIZE, DIFFTEST_TO_REF);
+#endif
+  IFDEF(CONFIG_DIFFTEST_BATCH, ckpt_cpu = cpu);
+  IFDEF(CONFIG_DIFFTEST_MEMCHECK, memset(unchecked, 0, sizeof(unchecked)));
+  isa_sync_regs(&cpu);
+  ref_difftest_regcpy(&cpu, DIFFTEST_TO_REF);
+}
+
 void init_difftest(char *ref_so_file, long img_size, int port) {
+#ifdef CONFIG_DIFFTEST_LOG
+  if (log_file != NULL) init_log();
+  if (is_replay) {
+    ref_difftest_memcpy = log_ref_memcpy;
+    ref_difftest_regcpy = log_ref_regcpy;
+    ref_difftest_exec = log_ref_exec;
+    ref_difftest_raise_intr = log_ref_raise_intr;
+    IFDEF(CONFIG_DIFFTEST_BATCH, init_batch());
+    return;
+  }
+#endif
   assert(ref_so_file != NULL);
 
   void *handle;
@@ -78,6 +562,16 @@ void init_difftest(char *ref_so_file, long img_size, int port) {
   ref_difftest_raise_intr = dlsym(handle, "difftest_raise_intr");
   assert(ref_difftest_raise_intr);
 
+  // REFs not built from NEMU do not tell the version
+  const int *ref_reg_version = dlsym(handle, "difftest_reg_version");
+  Assert(ref_reg_version == NULL || *ref_reg_version == DIFFTEST_REG_VERSION,
+      "The registers of %s are in version %d, but %d is expected", ref_so_file,
+      *ref_reg_version, DIFFTEST_REG_VERSION);
+
+  ref_difftest_run_to = dlsym(handle, "difftest_run_to");
+  ref_difftest_dirty_pages = dlsym(handle, "difftest_dirty_pages");
+  ref_difftest_exec_log = dlsym(handle, "difftest_exec_log");
+
   void (*ref_difftest_init)(int) = dlsym(handle, "difftest_init");
   assert(ref_difftest_init);
 
@@ -88,7 +582,10 @@ void init_difftest(char *ref_so_file, long img_size, int port) {
 
   ref_difftest_init(port);
   ref_difftest_memcpy(RESET_VECTOR, guest_to_host(RESET_VECTOR), img_size, DIFFTEST_TO_REF);
+  isa_sync_regs(&cpu);
   ref_difftest_regcpy(&cpu, DIFFTEST_TO_REF);
+  IFDEF(CONFIG_DIFFTEST_BATCH, init_batch());
+  IFDEF(CONFIG_DIFFTEST_PIPELINE, init_pipeline());
 }
 
 static void checkregs(CPU_state *ref, vaddr_t pc) {
@@ -102,13 +599,25 @@ static void checkregs(CPU_state *ref, vaddr_t pc) {
 void difftest_step(vaddr_t pc, vaddr_t npc) {
   CPU_state ref_r;
 
+  if (is_detach) return;
+  IFDEF(CONFIG_LIVE, LIVE_ADD(live->difftest_step, 1));
+
+#ifdef CONFIG_DIFFTEST_LOG
+  if (is_replay) {
+    replay_step(pc);
+    return;
+  }
+#endif
+
   if (skip_dut_nr_inst > 0) {
     ref_difftest_regcpy(&ref_r, DIFFTEST_TO_DUT);
     if (ref_r.pc == npc) {
       skip_dut_nr_inst = 0;
+      RECORD(&ref_r);
       checkregs(&ref_r, npc);
       return;
     }
+    RECORD(NULL);
     skip_dut_nr_inst --;
     if (skip_dut_nr_inst == 0)
       panic("can not catch up with ref.pc = " FMT_WORD " at pc = " FMT_WORD, ref_r.pc, pc);
@@ -116,16 +625,33 @@ void difftest_step(vaddr_t pc, vaddr_t npc) {
   }
 
   if (is_skip_ref) {
-    // to skip the checking of an instruction, just copy the reg state to reference design
-    ref_difftest_regcpy(&cpu, DIFFTEST_TO_REF);
+    // to skip the checking of an instruction, the reg state is copied to
+    // reference design, once for consecutive instructions skipped
+    skip_state = cpu;
+    skip_pending = true;
     is_skip_ref = false;
+    RECORD(NULL);
+    IFDEF(CONFIG_DIFFTEST_BATCH, checkpoint(&cpu));
     return;
   }
 
+  sync_skipped();
+
+#ifdef CONFIG_DIFFTEST_BATCH
+  dut_log[nr_pending] = cpu;
+  dut_log_pc[nr_pending] = pc;
+  if (++ nr_pending >= batch) batch_check(false);
+#elif defined(CONFIG_DIFFTEST_PIPELINE)
+  pipeline_push(pc);
+  IFDEF(CONFIG_DIFFTEST_MEMCHECK, if (!pipe_stopped) memcheck(pc));
+#else
   ref_difftest_exec(1);
   ref_difftest_regcpy(&ref_r, DIFFTEST_TO_DUT);
+  RECORD(&ref_r);
 
   checkregs(&ref_r, pc);
+  IFDEF(CONFIG_DIFFTEST_MEMCHECK, if (nemu_state.state != NEMU_ABORT) memcheck(pc));
+#endif
 }
 #else
 void init_difftest(char *ref_so_file, long img_size, int port) { }
@@ -0,0 +1,96 @@
+/***************************************************************************************
+* Copyright (c) 2014-2024 Zihao Yu, Nanjing University
+*
+* NEMU is licensed under Mulan PSL v2.
+* You can use this software according to the terms and conditions of the Mulan PSL v2.
+* You may obtain a copy of Mulan PSL v2 at:
+*          http://license.coscl.org.cn/MulanPSL2
+*
+* THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+* EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+* MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+*
+* See the Mulan PSL v2 for more details.
+***************************************************************************************/
+
+#define _GNU_SOURCE
+#include <dlfcn.h>
+#include <common.h>
+#include <difftest-def.h>
+#include <memory/paddr.h>
+#include <nemu-instance.h>
+#ifdef CONFIG_PMEM_MMAP
+#include <sys/mman.h>
+#endif
+
+/* The functions of the copy of each instance, found by dlsym(). Those named
+ * nemu_core_*() only run inside the copy, on the globals of it. */
+struct NEMU {
+  void *handle;
+  void (*init)(int port);
+  void (*memcpy)(paddr_t addr, void *buf, size_t n, bool direction);
+  void (*regcpy)(void *dut, bool direction);
+  int (*run)(uint64_t n);
+  uint64_t (*nr_inst)();
+  void (*fini)();
+};
+
+__EXPORT int nemu_core_run(uint64_t n) {
+  void cpu_exec_ref(uint64_t n);
+  cpu_exec_ref(n);
+  return nemu_state.state;
+}
+
+__EXPORT uint64_t nemu_core_nr_inst() {
+  extern uint64_t g_nr_guest_inst;
+  return g_nr_guest_inst;
+}
+
+// the copy is only unloaded by dlclose(), which does not release pmem
+__EXPORT void nemu_core_fini() {
+#if defined(CONFIG_PMEM_MMAP)
+  munmap(guest_to_host(CONFIG_MBASE), CONFIG_MSIZE);
+#elif defined(CONFIG_PMEM_MALLOC)
+  free(guest_to_host(CONFIG_MBASE));
+#endif
+}
+
+__EXPORT NEMU *nemu_create() {
+  Dl_info info;
+  if (dladdr((void *)nemu_create, &info) == 0) return NULL;
+  void *handle = dlmopen(LM_ID_NEWLM, info.dli_fname, RTLD_LAZY | RTLD_LOCAL);
+  if (handle == NULL) return NULL;
+  NEMU *nemu = calloc(1, sizeof(NEMU));
+  assert(nemu);
+  nemu->handle = handle;
+  nemu->init = dlsym(handle, "difftest_init");
+  nemu->memcpy = dlsym(handle, "difftest_memcpy");
+  nemu->regcpy = dlsym(handle, "difftest_regcpy");
+  nemu->run = dlsym(handle, "nemu_core_run");
+  nemu->nr_inst = dlsym(handle, "nemu_core_nr_inst");
+  nemu->fini = dlsym(handle, "nemu_core_fini");
+  assert(nemu->init && nemu->memcpy && nemu->regcpy && nemu->run && nemu->nr_inst && nemu->fini);
+  nemu->init(0);
+  return nemu;
+}
+
+__EXPORT void nemu_destroy(NEMU *nemu) {
+  nemu->fini();
+  dlclose(nemu->handle);
+  free(nemu);
+}
+
+__EXPORT void nemu_write_mem(NEMU *nemu, uint64_t addr, const void *buf, size_t size) {
+  nemu->memcpy(addr, (void *)buf, size, DIFFTEST_TO_REF);
+}
+
+__EXPORT void nemu_read_mem(NEMU *nemu, uint64_t addr, void *buf, size_t size) {
+  nemu->memcpy(addr, buf, size, DIFFTEST_TO_DUT);
+}
+
+__EXPORT void nemu_regcpy(NEMU *nemu, void *regs, bool to_nemu) {
+  nemu->regcpy(regs, to_nemu ? DIFFTEST_TO_REF : DIFFTEST_TO_DUT);
+}
+
+__EXPORT int nemu_run(NEMU *nemu, uint64_t n) { return nemu->run(n); }
+__EXPORT uint64_t nemu_nr_inst(NEMU *nemu) { return nemu->nr_inst(); }
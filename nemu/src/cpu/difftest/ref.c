@@ -19,19 +19,29 @@
 #include <memory/paddr.h>
 
 __EXPORT void difftest_memcpy(paddr_t addr, void *buf, size_t n, bool direction) {
-  assert(0);
+  if (direction == DIFFTEST_TO_REF) {
+    memcpy(guest_to_host(addr), buf, n);
+    // the code decoded from these pages is out of date
+    paddr_host_written(addr, n);
+  }
+  else memcpy(buf, guest_to_host(addr), n);
 }
 
+__EXPORT const int difftest_reg_version = DIFFTEST_REG_VERSION;
+
 __EXPORT void difftest_regcpy(void *dut, bool direction) {
-  assert(0);
+  isa_sync_regs(&cpu);
+  if (direction == DIFFTEST_TO_REF) memcpy(&cpu, dut, DIFFTEST_REG_SIZE);
+  else memcpy(dut, &cpu, DIFFTEST_REG_SIZE);
 }
 
 __EXPORT void difftest_exec(uint64_t n) {
-  assert(0);
+  void cpu_exec_ref(uint64_t n);
+  cpu_exec_ref(n);
 }
 
 __EXPORT void difftest_raise_intr(word_t NO) {
-  assert(0);
+  cpu.pc = isa_raise_intr(NO, cpu.pc);
 }
 
 __EXPORT void difftest_init(int port) {
@@ -0,0 +1,48 @@
+#***************************************************************************************
+# Copyright (c) 2014-2024 Zihao Yu, Nanjing University
+#
+# NEMU is licensed under Mulan PSL v2.
+# You can use this software according to the terms and conditions of the Mulan PSL v2.
+# You may obtain a copy of Mulan PSL v2 at:
+#          http://license.coscl.org.cn/MulanPSL2
+#
+# THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+# EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+# MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+#
+# See the Mulan PSL v2 for more details.
+#**************************************************************************************/
+
+
+ifndef CONFIG_REVERSE
+SRCS-BLACKLIST-y += src/cpu/reverse.c
+endif
+
+ifndef CONFIG_BBV
+SRCS-BLACKLIST-y += src/cpu/bbv.c
+endif
+
+ifndef CONFIG_COVERAGE
+SRCS-BLACKLIST-y += src/cpu/coverage.c
+endif
+
+ifndef CONFIG_SIMPOINT
+SRCS-BLACKLIST-y += src/cpu/simpoint.c
+endif
+
+ifndef CONFIG_MULTI_HART
+SRCS-BLACKLIST-y += src/cpu/hart.c
+endif
+LIBS += $(if $(CONFIG_HART_THREAD),-lpthread,)
+
+ifndef CONFIG_LOCKSTEP
+SRCS-BLACKLIST-y += src/cpu/lockstep.c
+endif
+
+ifndef CONFIG_TIMING
+SRCS-BLACKLIST-y += src/cpu/timing.c
+endif
+
+ifndef CONFIG_PLUGIN
+SRCS-BLACKLIST-y += src/cpu/plugin.c
+endif
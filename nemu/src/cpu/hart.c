@@ -0,0 +1,191 @@
+/***************************************************************************************
+* Copyright (c) 2014-2024 Zihao Yu, Nanjing University
+*
+* NEMU is licensed under Mulan PSL v2.
+* You can use this software according to the terms and conditions of the Mulan PSL v2.
+* You may obtain a copy of Mulan PSL v2 at:
+*          http://license.coscl.org.cn/MulanPSL2
+*
+* THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+* EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+* MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+*
+* See the Mulan PSL v2 for more details.
+***************************************************************************************/
+
+
+#include <isa.h>
+#include <cpu/hart.h>
+#include <memory/vaddr.h>
+#include <device/snapshot.h>
+
+static CPU_state hart[CONFIG_NR_HART];
+static bool parked[CONFIG_NR_HART];
+static HART_LOCAL int cur = 0;
+static uint64_t quantum_left = CONFIG_HART_QUANTUM;
+
+#ifdef CONFIG_HART_THREAD
+#include <pthread.h>
+#include <sched.h>
+
+/* Each hart but hart 0 runs on a host thread of its own, while hart 0 stays
+ * on the thread of NEMU, which alone traces, stops at breakpoints, ticks
+ * the devices and takes interrupts. The other threads only run while
+ * cpu_exec() runs hart 0, loading `cpu` from hart[] when a run begins and
+ * storing it back when the run ends, so that sdb and the snapshots find
+ * every hart in hart[] between runs. `lock` guards parked[], `running` and
+ * `nr_busy`. */
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t cond = PTHREAD_COND_INITIALIZER;
+static bool running = false;
+static int nr_busy = 0; // the threads of harts holding their state in `cpu`
+
+/* A hart writing to a page of instructions only drops its own decode cache.
+ * The others notice by `code_epoch` and drop theirs as a whole, at most
+ * HART_QUANTUM instructions later. */
+static uint64_t code_epoch = 0;
+static HART_LOCAL uint64_t code_epoch_seen = 0;
+
+void cpu_exec_hart(uint64_t n);
+void flush_decode_cache();
+
+void hart_code_written() {
+  __atomic_fetch_add(&code_epoch, 1, __ATOMIC_RELEASE);
+}
+
+static void hart_sync() {
+  uint64_t epoch = __atomic_load_n(&code_epoch, __ATOMIC_ACQUIRE);
+  if (epoch == code_epoch_seen) return;
+  code_epoch_seen = epoch;
+  IFDEF(CONFIG_DECODE_CACHE, flush_decode_cache());
+}
+
+static void* hart_thread(void *arg) {
+  int id = (intptr_t)arg;
+  cur = id;
+  // the decode cache and the TLB of this thread start invalid
+  IFDEF(CONFIG_DECODE_CACHE, flush_decode_cache());
+  vaddr_tlb_flush();
+  pthread_mutex_lock(&lock);
+  while (true) {
+    while (!running || parked[id]) pthread_cond_wait(&cond, &lock);
+    cpu = hart[id];
+    nr_busy ++;
+    pthread_mutex_unlock(&lock);
+    while (__atomic_load_n(&running, __ATOMIC_ACQUIRE)) {
+      hart_sync();
+      // wait for the end of the run once it is stopped by another hart
+      if (nemu_state.state == NEMU_RUNNING) cpu_exec_hart(CONFIG_HART_QUANTUM);
+      else sched_yield();
+    }
+    pthread_mutex_lock(&lock);
+    hart[id] = cpu;
+    nr_busy --;
+    pthread_cond_broadcast(&cond);
+  }
+  return NULL;
+}
+
+void hart_resume() {
+  pthread_mutex_lock(&lock);
+  __atomic_store_n(&running, true, __ATOMIC_RELEASE);
+  pthread_cond_broadcast(&cond);
+  pthread_mutex_unlock(&lock);
+}
+
+void hart_pause() {
+  pthread_mutex_lock(&lock);
+  __atomic_store_n(&running, false, __ATOMIC_RELEASE);
+  while (nr_busy > 0) pthread_cond_wait(&cond, &lock);
+  pthread_mutex_unlock(&lock);
+}
+#endif
+
+static void hart_switch(int next) {
+  hart[cur] = cpu;
+  cur = next;
+  cpu = hart[cur];
+  // translations depend on the state of the MMU of each hart
+  vaddr_tlb_flush();
+}
+
+#ifdef CONFIG_SNAPSHOT
+static void hart_snapshot(Snapshot *s) {
+  // `cpu` itself is saved by the snapshot
+  if (!snapshot_is_load(s)) hart[cur] = cpu;
+  SNAPSHOT_VAR(s, hart);
+  SNAPSHOT_VAR(s, parked);
+  SNAPSHOT_VAR(s, cur);
+  SNAPSHOT_VAR(s, quantum_left);
+}
+#endif
+
+// called after the image is loaded, with `cpu` at reset
+void init_hart() {
+  int i;
+  for (i = 0; i < CONFIG_NR_HART; i ++) {
+    hart[i] = cpu;
+    parked[i] = (i != 0);
+  }
+  IFDEF(CONFIG_SNAPSHOT, snapshot_register("hart", hart_snapshot));
+#ifdef CONFIG_HART_THREAD
+  for (i = 1; i < CONFIG_NR_HART; i ++) {
+    pthread_t t;
+    Assert(pthread_create(&t, NULL, hart_thread, (void *)(intptr_t)i) == 0,
+        "cannot create the thread of hart %d", i);
+    pthread_detach(t);
+  }
+  Log("%d harts, each on a host thread", CONFIG_NR_HART);
+#else
+  Log("%d harts, switching every %d instructions", CONFIG_NR_HART, CONFIG_HART_QUANTUM);
+#endif
+}
+
+int hart_current() {
+  return cur;
+}
+
+void hart_start(int id, vaddr_t pc, word_t sp) {
+  IFDEF(CONFIG_HART_THREAD, pthread_mutex_lock(&lock));
+  if (id >= 0 && id < CONFIG_NR_HART && parked[id]) {
+    CPU_state self = cpu;
+    cpu = hart[id];
+    cpu.pc = pc;
+    isa_hart_init(id, sp);
+    hart[id] = cpu;
+    cpu = self;
+    parked[id] = false;
+    IFDEF(CONFIG_HART_THREAD, pthread_cond_broadcast(&cond));
+  }
+  IFDEF(CONFIG_HART_THREAD, pthread_mutex_unlock(&lock));
+}
+
+uint64_t hart_limit(uint64_t n) {
+#ifdef CONFIG_HART_THREAD
+  // hart 0 checks the decode cache as often as the others
+  hart_sync();
+  return (CONFIG_HART_QUANTUM < n ? CONFIG_HART_QUANTUM : n);
+#else
+  return (quantum_left < n ? quantum_left : n);
+#endif
+}
+
+void hart_advance(uint64_t n) {
+  // each hart runs on by itself
+  IFDEF(CONFIG_HART_THREAD, return);
+  quantum_left = (n < quantum_left ? quantum_left - n : 0);
+  // a hart stopped by sdb is still shown, and switched at the next run
+  if (quantum_left > 0 || nemu_state.state != NEMU_RUNNING) return;
+  quantum_left = CONFIG_HART_QUANTUM;
+  int next = cur;
+  do { next = (next + 1) % CONFIG_NR_HART; } while (parked[next]);
+  if (next != cur) hart_switch(next);
+}
+
+void hart_display() {
+  int i;
+  for (i = 0; i < CONFIG_NR_HART; i ++) {
+    if (parked[i]) printf("  hart %-3d parked\n", i);
+    else printf("%c hart %-3d pc = " FMT_WORD "\n", (i == cur ? '*' : ' '), i, (i == cur ? cpu.pc : hart[i].pc));
+  }
+}
@@ -0,0 +1,301 @@
+/***************************************************************************************
+* Copyright (c) 2014-2024 Zihao Yu, Nanjing University
+*
+* NEMU is licensed under Mulan PSL v2.
+* You can use this software according to the terms and conditions of the Mulan PSL v2.
+* You may obtain a copy of Mulan PSL v2 at:
+*          http://license.coscl.org.cn/MulanPSL2
+*
+* THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+* EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+* MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+*
+* See the Mulan PSL v2 for more details.
+***************************************************************************************/
+
+
+#include <isa.h>
+#include <cpu/cpu.h>
+#include <cpu/lockstep.h>
+#include <memory/paddr.h>
+#include <memory/vaddr.h>
+#include <fcntl.h>
+#include <setjmp.h>
+#include <unistd.h>
+
+/* A campaign of fault injection. Each line of FAULTS gives a fault, as
+ *   INST gpr N BIT     flip bit BIT of general purpose register N
+ *   INST pc BIT        flip bit BIT of pc
+ *   INST mem ADDR BIT  flip bit BIT of the byte of pmem at ADDR
+ * injected before the instruction INST, counting from 0. Blank lines and
+ * those starting with '#' are skipped.
+ *
+ * The instances run CONFIG_LOCKSTEP_QUANTUM instructions in turn, starting
+ * with the golden one. The pmem of each instance is a memory file, mapped
+ * to the address of pmem when it runs, so that the host addresses cached
+ * by the region table and the TLB hold for every instance. The decode
+ * cache and the blocks are shared, so an instance following the path of
+ * the others finds the instructions decoded. Only the pages of code
+ * written since the start may differ between the instances, and the
+ * instructions cached from them are dropped on each switch.
+ *
+ * After each turn, the registers of an instance are compared with those of
+ * the golden one at the same instruction count, to find when the fault
+ * shows. At the end, an instance is
+ *   masked  ending like the golden one, with the same halt_ret, instruction
+ *           count and registers
+ *   sdc     ending otherwise, i.e. silent data corruption
+ *   crash   accessing out of pmem or running into an invalid instruction
+ *   hang    still running after twice the instructions of the golden one
+ * and a line of JSON is printed for it. The devices are left out, so that
+ * the instances are deterministic, and the output of the guest is dropped.
+ */
+
+enum { FAULT_NONE, FAULT_GPR, FAULT_PC, FAULT_MEM };
+enum { OUT_GOLDEN, OUT_MASKED, OUT_SDC, OUT_CRASH, OUT_HANG };
+
+typedef struct {
+  char *spec;
+  int type;
+  uint64_t at;
+  word_t where; // the register or the address
+  int bit;
+  bool injected;
+
+  int fd; // the memory file of pmem
+  CPU_state cpu;
+  NEMUState state;
+  uint64_t nr_inst;
+  uint64_t diverged; // the instruction count when the registers are first found different, or 0
+  bool crash, hang;
+} Instance;
+
+extern uint64_t g_nr_guest_inst;
+
+static char *fault_file = NULL;
+static Instance *instance = NULL;
+static int nr_instance = 0, cur = -1;
+static jmp_buf crash_env;
+static bool crash_armed = false;
+
+#define NR_PAGE (CONFIG_MSIZE / PAGE_SIZE)
+static paddr_t private_code[NR_PAGE];
+static bool is_private_code[NR_PAGE];
+static int nr_private_code = 0;
+
+void lockstep_set_faults(const char *file) {
+  fault_file = strdup(file);
+}
+
+void lockstep_private_code(paddr_t page) {
+  int idx = (page - CONFIG_MBASE) >> PAGE_SHIFT;
+  if (is_private_code[idx]) return;
+  is_private_code[idx] = true;
+  private_code[nr_private_code ++] = page;
+}
+
+void lockstep_crash() {
+  if (!crash_armed) return;
+  longjmp(crash_env, 1);
+}
+
+static bool parse_fault(Instance *in, char *line) {
+  char type[8];
+  uint64_t at, where = 0;
+  int bit, n;
+  if (sscanf(line, "%" SCNu64 " %7s %n", &at, type, &n) != 2) return false;
+  const char *args = line + n;
+  if (strcmp(type, "pc") == 0) {
+    in->type = FAULT_PC;
+    if (sscanf(args, "%d", &bit) != 1) return false;
+  } else {
+    if (sscanf(args, "%" SCNi64 " %d", &where, &bit) != 2) return false;
+    if (strcmp(type, "gpr") == 0) {
+      in->type = FAULT_GPR;
+      if (where >= ARRLEN(cpu.gpr)) return false;
+    } else if (strcmp(type, "mem") == 0) {
+      in->type = FAULT_MEM;
+      if (!in_pmem(where)) return false;
+    } else return false;
+  }
+  if (bit < 0 || bit >= (in->type == FAULT_MEM ? 8 : sizeof(word_t) * 8)) return false;
+  in->at = at;
+  in->where = where;
+  in->bit = bit;
+  in->spec = strdup(line);
+  return true;
+}
+
+static void load_faults() {
+  FILE *fp = fopen(fault_file, "r");
+  Assert(fp != NULL, "Can not open '%s'", fault_file);
+  int size = 16;
+  instance = calloc(size, sizeof(Instance));
+  assert(instance != NULL);
+  instance[0].spec = "golden";
+  nr_instance = 1;
+  char line[256];
+  int lineno = 0;
+  while (fgets(line, sizeof(line), fp) != NULL) {
+    lineno ++;
+    line[strcspn(line, "\r\n")] = '\0';
+    if (line[0] == '\0' || line[0] == '#') continue;
+    if (nr_instance == size) {
+      size *= 2;
+      instance = realloc(instance, sizeof(Instance) * size);
+      assert(instance != NULL);
+    }
+    Instance *in = &instance[nr_instance];
+    memset(in, 0, sizeof(*in));
+    Assert(parse_fault(in, line), "%s:%d: bad fault '%s'", fault_file, lineno, line);
+    nr_instance ++;
+  }
+  fclose(fp);
+}
+
+static void switch_to(int i) {
+  if (i == cur) return;
+  if (cur >= 0) {
+    Instance *in = &instance[cur];
+    in->cpu = cpu;
+    in->state = nemu_state;
+    in->nr_inst = g_nr_guest_inst;
+  }
+  cur = i;
+  Instance *in = &instance[cur];
+  cpu = in->cpu;
+  nemu_state = in->state;
+  g_nr_guest_inst = in->nr_inst;
+  paddr_pmem_switch(in->fd);
+  // the translations depend on the state of the MMU of each instance
+  vaddr_tlb_flush();
+  int j;
+  for (j = 0; j < nr_private_code; j ++) {
+    IFDEF(CONFIG_DECODE_CACHE, isa_flush_decode_cache(private_code[j]));
+  }
+  IFDEF(CONFIG_ENGINE_BLOCK, void block_flush(); if (nr_private_code > 0) block_flush());
+}
+
+static void inject(Instance *in) {
+  word_t mask = (word_t)1 << in->bit;
+  switch (in->type) {
+    case FAULT_GPR: MUXDEF(CONFIG_ISA_x86, cpu.gpr[in->where]._32, cpu.gpr[in->where]) ^= mask; break;
+    case FAULT_PC: cpu.pc ^= mask; break;
+    case FAULT_MEM:
+      *guest_to_host(in->where) ^= mask;
+      paddr_host_written(in->where, 1);
+      break;
+  }
+  in->injected = true;
+}
+
+static inline bool is_running(const NEMUState *s) {
+  return s->state == NEMU_RUNNING || s->state == NEMU_STOP;
+}
+
+// run the current instance until it executes `end` instructions in total
+static void run(Instance *in, uint64_t end) {
+  void cpu_exec_ref(uint64_t n);
+  if (setjmp(crash_env) != 0) {
+    crash_armed = false;
+    in->crash = true;
+    nemu_state.state = NEMU_ABORT;
+    nemu_state.halt_pc = cpu.pc;
+    return;
+  }
+  crash_armed = true;
+  while (g_nr_guest_inst < end && is_running(&nemu_state)) {
+    uint64_t n = end - g_nr_guest_inst;
+    if (in->type != FAULT_NONE && !in->injected) {
+      if (g_nr_guest_inst >= in->at) { inject(in); continue; }
+      if (in->at - g_nr_guest_inst < n) n = in->at - g_nr_guest_inst;
+    }
+    cpu_exec_ref(n);
+  }
+  crash_armed = false;
+  if (nemu_state.state == NEMU_ABORT) in->crash = true;
+}
+
+static int outcome(const Instance *in, const Instance *golden) {
+  if (in == golden) return OUT_GOLDEN;
+  if (in->crash) return OUT_CRASH;
+  if (in->hang) return OUT_HANG;
+  bool same = in->state.state == golden->state.state && in->state.halt_ret == golden->state.halt_ret &&
+    in->nr_inst == golden->nr_inst && memcmp(&in->cpu, &golden->cpu, sizeof(CPU_state)) == 0;
+  return (same ? OUT_MASKED : OUT_SDC);
+}
+
+bool lockstep_run() {
+  if (fault_file == NULL) return false;
+  load_faults();
+  int i;
+  for (i = 0; i < nr_instance; i ++) {
+    instance[i].fd = paddr_pmem_clone();
+    instance[i].cpu = cpu;
+    instance[i].state = nemu_state;
+    instance[i].nr_inst = g_nr_guest_inst;
+  }
+  // every instance starts with the same pmem
+  paddr_clear_dirty(CONFIG_MBASE, CONFIG_MSIZE);
+  Log("lockstep: %d faults, switching every %d instructions", nr_instance - 1, CONFIG_LOCKSTEP_QUANTUM);
+
+  // drop the output of the guest and the messages of invalid instructions
+  fflush(NULL);
+  int out_fd = dup(STDOUT_FILENO), null_fd = open("/dev/null", O_WRONLY);
+  assert(out_fd >= 0 && null_fd >= 0);
+  dup2(null_fd, STDOUT_FILENO);
+  close(null_fd);
+
+  uint64_t start = get_time(), end = 0;
+  Instance *golden = &instance[0];
+  bool left = true;
+  while (left) {
+    left = false;
+    end += CONFIG_LOCKSTEP_QUANTUM;
+    for (i = 0; i < nr_instance; i ++) {
+      Instance *in = &instance[i];
+      if (!is_running(&in->state)) continue;
+      switch_to(i);
+      uint64_t limit = end;
+      bool golden_done = (i != 0 && !is_running(&golden->state));
+      if (golden_done && limit > golden->nr_inst * 2) limit = golden->nr_inst * 2;
+      run(in, limit);
+      if (golden_done && is_running(&nemu_state) && g_nr_guest_inst >= golden->nr_inst * 2) {
+        in->hang = true;
+        nemu_state.state = NEMU_END;
+      }
+      if (i != 0 && in->diverged == 0 && g_nr_guest_inst == golden->nr_inst &&
+          memcmp(&cpu, &golden->cpu, sizeof(CPU_state)) != 0) in->diverged = g_nr_guest_inst;
+      left |= is_running(&nemu_state);
+    }
+  }
+  switch_to(0);
+  uint64_t host_time = get_time() - start;
+
+  fflush(NULL);
+  dup2(out_fd, STDOUT_FILENO);
+  close(out_fd);
+
+  static const char *state_name[] = {
+    [NEMU_RUNNING] = "running", [NEMU_STOP] = "stop", [NEMU_END] = "end",
+    [NEMU_ABORT] = "abort", [NEMU_QUIT] = "quit",
+  };
+  static const char *outcome_name[] = {
+    [OUT_GOLDEN] = "golden", [OUT_MASKED] = "masked", [OUT_SDC] = "sdc", [OUT_CRASH] = "crash", [OUT_HANG] = "hang",
+  };
+  int count[ARRLEN(outcome_name)] = {};
+  for (i = 0; i < nr_instance; i ++) {
+    Instance *in = &instance[i];
+    int o = outcome(in, golden);
+    count[o] ++;
+    printf("{\"instance\":%d,\"fault\":\"%s\",\"outcome\":\"%s\",\"state\":\"%s\",\"halt_ret\":%u,"
+        "\"pc\":%" PRIu64 ",\"inst\":%" PRIu64 ",\"diverged\":%" PRIu64 "}\n",
+        i, in->spec, outcome_name[o], state_name[in->state.state], in->state.halt_ret,
+        (uint64_t)in->state.halt_pc, in->nr_inst, in->diverged);
+    close(in->fd);
+  }
+  Log("lockstep: %d faults in " "%" PRIu64 " us, %d masked, %d sdc, %d crash, %d hang", nr_instance - 1,
+      host_time, count[OUT_MASKED], count[OUT_SDC], count[OUT_CRASH], count[OUT_HANG]);
+  // the golden instance is left as the result
+  return true;
+}
@@ -0,0 +1,312 @@
+/***************************************************************************************
+* Copyright (c) 2014-2024 Zihao Yu, Nanjing University
+*
+* NEMU is licensed under Mulan PSL v2.
+* You can use this software according to the terms and conditions of the Mulan PSL v2.
+* You may obtain a copy of Mulan PSL v2 at:
+*          http://license.coscl.org.cn/MulanPSL2
+*
+* THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+* EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+* MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+*
+* See the Mulan PSL v2 for more details.
+***************************************************************************************/
+
+#include <isa.h>
+#include <cpu/cpu.h>
+#include <cpu/plugin.h>
+#include <memory/paddr.h>
+#include <nemu-plugin.h>
+#include <dlfcn.h>
+
+#define MAX_PLUGIN 8
+#define BLOCK_MAX_INSN 64
+#define BLOCK_HASH_SIZE 4096
+#define MAX_REPLAY_MEM 256
+
+typedef struct Hook {
+  nemu_exec_cb exec;
+  nemu_mem_cb mem;
+  void *udata;
+  uint64_t *counter, imm; // an inline counter if `counter` is not NULL
+  struct Hook *next;
+} Hook;
+
+struct nemu_insn {
+  vaddr_t pc;
+  int size;
+  uint8_t data[16];
+  Hook *exec, *mem;
+};
+
+struct nemu_block {
+  vaddr_t pc;
+  int ninsn;
+  nemu_insn *insn;
+  Hook *exec;
+  struct nemu_block *next; // in the same bucket
+};
+
+typedef struct {
+  void (*fn)();
+  void *udata;
+} Callback;
+
+static Callback trans_cb[MAX_PLUGIN], exit_cb[MAX_PLUGIN];
+static int nr_trans_cb = 0, nr_exit_cb = 0;
+static nemu_block *block_hash[BLOCK_HASH_SIZE] = {};
+
+bool plugin_on = false;
+bool plugin_mem_on = false;
+
+/* The block running and the index of the next instruction in it, or NULL
+ * if the next instruction starts a block. A block not seen before is
+ * recorded while it runs, with its memory accesses, which are replayed to
+ * the hooks once the block is known. */
+static nemu_block *cur = NULL;
+static int cur_idx = 0;
+static nemu_insn *cur_insn = NULL;
+static bool recording = false;
+static nemu_insn rec[BLOCK_MAX_INSN];
+static int nr_rec = 0;
+static vaddr_t rec_next = 0;
+static struct {
+  int idx;
+  paddr_t addr;
+  int len;
+  bool is_write;
+} rec_mem[MAX_REPLAY_MEM];
+static int nr_rec_mem = 0;
+
+static inline uint32_t block_idx(vaddr_t pc) {
+  return (pc ^ (pc >> 12)) % BLOCK_HASH_SIZE;
+}
+
+static nemu_block* block_lookup(vaddr_t pc) {
+  nemu_block *b;
+  for (b = block_hash[block_idx(pc)]; b != NULL; b = b->next) {
+    if (b->pc == pc) return b;
+  }
+  return NULL;
+}
+
+static void hooks_free(Hook *h) {
+  while (h != NULL) { Hook *next = h->next; free(h); h = next; }
+}
+
+static void block_free(nemu_block *b) {
+  int i;
+  for (i = 0; i < b->ninsn; i ++) { hooks_free(b->insn[i].exec); hooks_free(b->insn[i].mem); }
+  hooks_free(b->exec);
+  free(b->insn);
+  free(b);
+}
+
+static inline void run_exec(Hook *h, vaddr_t pc) {
+  for (; h != NULL; h = h->next) {
+    if (h->counter != NULL) *h->counter += h->imm;
+    else h->exec(pc, h->udata);
+  }
+}
+
+static inline void run_mem(Hook *h, vaddr_t pc, paddr_t addr, int len, bool is_write) {
+  for (; h != NULL; h = h->next) {
+    if (h->counter != NULL) *h->counter += h->imm;
+    else h->mem(pc, addr, len, is_write, h->udata);
+  }
+}
+
+static void finish_record() {
+  recording = false;
+  if (nr_rec == 0) return;
+  nemu_block *b = malloc(sizeof(nemu_block));
+  assert(b != NULL);
+  *b = (nemu_block) { .pc = rec[0].pc, .ninsn = nr_rec, .insn = malloc(sizeof(nemu_insn) * nr_rec) };
+  assert(b->insn != NULL);
+  memcpy(b->insn, rec, sizeof(nemu_insn) * nr_rec);
+  uint32_t idx = block_idx(b->pc);
+  b->next = block_hash[idx];
+  block_hash[idx] = b;
+  int i, j;
+#ifdef CONFIG_MEM_CODE_PAGE
+  // vaddr is identical to paddr since isa_mmu_check() always returns MMU_DIRECT
+  for (i = 0; i < nr_rec; i ++) {
+    if (in_pmem(rec[i].pc)) paddr_mark_code(rec[i].pc);
+  }
+#endif
+  for (i = 0; i < nr_trans_cb; i ++) ((nemu_block_trans_cb)trans_cb[i].fn)(b, trans_cb[i].udata);
+
+  run_exec(b->exec, b->pc);
+  for (i = 0, j = 0; i < b->ninsn; i ++) {
+    nemu_insn *insn = &b->insn[i];
+    run_exec(insn->exec, insn->pc);
+    for (; j < nr_rec_mem && rec_mem[j].idx == i; j ++) {
+      run_mem(insn->mem, insn->pc, rec_mem[j].addr, rec_mem[j].len, rec_mem[j].is_write);
+    }
+  }
+}
+
+void plugin_insn_start(vaddr_t pc) {
+  // a block is cut by an exception or an interrupt
+  if (recording && pc != rec_next) finish_record();
+  if (cur != NULL && (cur_idx == cur->ninsn || cur->insn[cur_idx].pc != pc)) cur = NULL;
+  if (cur == NULL && !recording) {
+    cur = block_lookup(pc);
+    cur_idx = 0;
+    if (cur == NULL) {
+      recording = true;
+      nr_rec = nr_rec_mem = 0;
+    } else run_exec(cur->exec, pc);
+  }
+  if (recording) {
+    plugin_mem_on = true;
+    return;
+  }
+  cur_insn = &cur->insn[cur_idx ++];
+  run_exec(cur_insn->exec, pc);
+  plugin_mem_on = (cur_insn->mem != NULL);
+}
+
+void plugin_insn_end(vaddr_t pc, int len, const void *data, bool jump) {
+  plugin_mem_on = false;
+  if (!recording) {
+    if (jump) cur = NULL;
+    return;
+  }
+  nemu_insn *insn = &rec[nr_rec ++];
+  *insn = (nemu_insn) { .pc = pc, .size = len };
+  memcpy(insn->data, data, (len < sizeof(insn->data) ? len : sizeof(insn->data)));
+  rec_next = pc + len;
+  if (jump || nr_rec == BLOCK_MAX_INSN || nemu_state.state != NEMU_RUNNING) finish_record();
+}
+
+void plugin_mem(paddr_t addr, int len, bool is_write) {
+  if (recording) {
+    if (nr_rec_mem < MAX_REPLAY_MEM) {
+      rec_mem[nr_rec_mem ++] = (typeof(rec_mem[0])) { .idx = nr_rec, .addr = addr, .len = len, .is_write = is_write };
+    }
+    return;
+  }
+  run_mem(cur_insn->mem, cur_insn->pc, addr, len, is_write);
+}
+
+void plugin_flush_page(paddr_t page) {
+  int i, j;
+  for (i = 0; i < BLOCK_HASH_SIZE; i ++) {
+    nemu_block **p = &block_hash[i];
+    while (*p != NULL) {
+      nemu_block *b = *p;
+      bool hit = false;
+      for (j = 0; j < b->ninsn && !hit; j ++) hit = ((b->insn[j].pc & ~PAGE_MASK) == page);
+      if (!hit) { p = &b->next; continue; }
+      *p = b->next;
+      if (b == cur) cur = NULL;
+      block_free(b);
+    }
+  }
+}
+
+// --- the API ---
+
+static void api_register_block_trans(nemu_block_trans_cb cb, void *udata) {
+  Assert(nr_trans_cb < MAX_PLUGIN, "Too many callbacks of translation");
+  trans_cb[nr_trans_cb ++] = (Callback) { .fn = (void (*)())cb, .udata = udata };
+  plugin_on = true;
+}
+
+static void api_register_exit(nemu_exit_cb cb, void *udata) {
+  Assert(nr_exit_cb < MAX_PLUGIN, "Too many callbacks of exit");
+  exit_cb[nr_exit_cb ++] = (Callback) { .fn = (void (*)())cb, .udata = udata };
+}
+
+static uint64_t api_block_vaddr(const nemu_block *b) { return b->pc; }
+static int api_block_ninsn(const nemu_block *b) { return b->ninsn; }
+static nemu_insn* api_block_insn(nemu_block *b, int i) { return (i >= 0 && i < b->ninsn ? &b->insn[i] : NULL); }
+static uint64_t api_insn_vaddr(const nemu_insn *insn) { return insn->pc; }
+static int api_insn_size(const nemu_insn *insn) { return insn->size; }
+static const uint8_t* api_insn_data(const nemu_insn *insn) { return insn->data; }
+
+static void hook_add(Hook **list, Hook h) {
+  Hook *p = malloc(sizeof(Hook));
+  assert(p != NULL);
+  *p = h;
+  // keep the order of adding
+  while (*list != NULL) list = &(*list)->next;
+  *list = p;
+}
+
+static void api_block_exec_cb(nemu_block *b, nemu_exec_cb cb, void *udata) {
+  hook_add(&b->exec, (Hook) { .exec = cb, .udata = udata });
+}
+static void api_block_exec_inline(nemu_block *b, uint64_t *counter, uint64_t imm) {
+  hook_add(&b->exec, (Hook) { .counter = counter, .imm = imm });
+}
+static void api_insn_exec_cb(nemu_insn *insn, nemu_exec_cb cb, void *udata) {
+  hook_add(&insn->exec, (Hook) { .exec = cb, .udata = udata });
+}
+static void api_insn_exec_inline(nemu_insn *insn, uint64_t *counter, uint64_t imm) {
+  hook_add(&insn->exec, (Hook) { .counter = counter, .imm = imm });
+}
+static void api_insn_mem_cb(nemu_insn *insn, nemu_mem_cb cb, void *udata) {
+  hook_add(&insn->mem, (Hook) { .mem = cb, .udata = udata });
+}
+static void api_insn_mem_inline(nemu_insn *insn, uint64_t *counter, uint64_t imm) {
+  hook_add(&insn->mem, (Hook) { .counter = counter, .imm = imm });
+}
+
+// by the names in the expressions of sdb
+static uint64_t api_reg(const char *name, bool *success) {
+  if (strcmp(name, "pc") == 0) { *success = true; return cpu.pc; }
+  return isa_reg_str2val(name, success);
+}
+
+static uint64_t api_nr_inst() {
+  extern uint64_t g_nr_guest_inst;
+  return g_nr_guest_inst;
+}
+
+static const char* api_symbol(uint64_t pc) { return symbol_lookup(pc, NULL); }
+
+static const NEMUPluginAPI api = {
+  .version = NEMU_PLUGIN_VERSION,
+  .register_block_trans = api_register_block_trans,
+  .register_exit = api_register_exit,
+  .block_vaddr = api_block_vaddr,
+  .block_ninsn = api_block_ninsn,
+  .block_insn = api_block_insn,
+  .insn_vaddr = api_insn_vaddr,
+  .insn_size = api_insn_size,
+  .insn_data = api_insn_data,
+  .block_exec_cb = api_block_exec_cb,
+  .block_exec_inline = api_block_exec_inline,
+  .insn_exec_cb = api_insn_exec_cb,
+  .insn_exec_inline = api_insn_exec_inline,
+  .insn_mem_cb = api_insn_mem_cb,
+  .insn_mem_inline = api_insn_mem_inline,
+  .reg = api_reg,
+  .nr_inst = api_nr_inst,
+  .symbol = api_symbol,
+};
+
+static void plugin_exit() {
+  int i;
+  for (i = 0; i < nr_exit_cb; i ++) ((nemu_exit_cb)exit_cb[i].fn)(exit_cb[i].udata);
+}
+
+// load the plugin in `spec`, which is LIB.so[,ARG]
+bool plugin_load(const char *spec) {
+  char *lib = strdup(spec), *arg = strchr(lib, ',');
+  if (arg != NULL) *arg ++ = '\0';
+  void *handle = dlopen(lib, RTLD_NOW | RTLD_LOCAL);
+  if (handle == NULL) { Log_warn("Can not load plugin: %s", dlerror()); free(lib); return false; }
+  int (*install)(const NEMUPluginAPI *, const char *) = dlsym(handle, "nemu_plugin_install");
+  if (install == NULL) { Log("%s has no nemu_plugin_install()", lib); free(lib); return false; }
+  int ret = install(&api, arg != NULL ? arg : "");
+  if (ret != 0) Log_warn("Plugin %s fails to install with %d", lib, ret);
+  else Log("Plugin %s is loaded", lib);
+  static bool registered = false;
+  if (!registered) { atexit(plugin_exit); registered = true; }
+  free(lib);
+  return ret == 0;
+}
@@ -0,0 +1,301 @@
+/***************************************************************************************
+* Copyright (c) 2014-2024 Zihao Yu, Nanjing University
+*
+* NEMU is licensed under Mulan PSL v2.
+* You can use this software according to the terms and conditions of the Mulan PSL v2.
+* You may obtain a copy of Mulan PSL v2 at:
+*          http://license.coscl.org.cn/MulanPSL2
+*
+* THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+* EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+* MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+*
+* See the Mulan PSL v2 for more details.
+***************************************************************************************/
+
+
+#include <isa.h>
+#include <cpu/cpu.h>
+#include <cpu/reverse.h>
+#include <device/replay.h>
+#include <memory/paddr.h>
+#include <memory/vaddr.h>
+#include <sys/mman.h>
+
+/* The checkpoints form a ring, where the oldest one is dropped for a new
+ * one. `shadow` holds pmem at the last checkpoint, and each checkpoint
+ * keeps the content at the checkpoint before it of the pages written in
+ * between, as found by the dirty bits of pmem. Restoring a checkpoint
+ * copies back the pages written since the last checkpoint from `shadow`,
+ * and then the pages kept by the later checkpoints, which are dropped.
+ * The checkpoints are taken again while replaying. A page of `shadow` is
+ * only copied when it is not filled with a single byte, so that the host
+ * commits memory for the pages used by the guest only. */
+#define NR_CKPT CONFIG_REVERSE_NR_CKPT
+#define INTERVAL CONFIG_REVERSE_INTERVAL
+#define NR_PAGE (CONFIG_MSIZE / PAGE_SIZE)
+
+typedef struct {
+  uint64_t icount;
+  uint64_t nr_guest_inst;
+  uint64_t input_pos;
+  CPU_state cpu;
+  void *dev;
+  size_t dev_size;
+  int nr_page;
+  paddr_t *page;
+  uint8_t *undo; // content of `page` at the checkpoint before
+} Checkpoint;
+
+static Checkpoint ckpt[NR_CKPT] = {};
+static int ckpt_head = 0, nr_ckpt = 0;
+#define CKPT(i) (&ckpt[(ckpt_head + (i)) % NR_CKPT]) // the i-th oldest one
+static uint8_t *shadow = NULL;
+static bool shadow_kept[NR_PAGE];
+static uint8_t shadow_fill[NR_PAGE]; // the byte filling the page if it is not kept
+static uint64_t icount = 0, next_ckpt = 0;
+bool reverse_replaying = false;
+
+/* The inputs are an array indexed by their positions minus `input_base`.
+ * Those before the oldest checkpoint are dropped with it. Positions below
+ * `nr_input` are replayed. */
+static uint64_t *input = NULL;
+static uint64_t input_base = 0, input_pos = 0, nr_input = 0;
+static size_t input_cap = 0;
+
+extern uint64_t g_nr_guest_inst;
+void* snapshot_save_devices(size_t *size);
+void snapshot_load_devices(void *buf, size_t size);
+bool cpu_exec_replay(uint64_t n);
+
+bool replay_pending() { return input_pos < nr_input; }
+
+uint64_t replay_input() { return input[input_pos ++ - input_base]; }
+
+uint64_t record_input(uint64_t value) {
+  if (nr_input - input_base == input_cap) {
+    input_cap = (input_cap == 0 ? 1024 : input_cap * 2);
+    input = realloc(input, input_cap * sizeof(*input));
+    assert(input);
+  }
+  input[nr_input ++ - input_base] = value;
+  input_pos = nr_input;
+  return value;
+}
+
+static void ckpt_free_pages(Checkpoint *c) {
+  FOOTPRINT("snapshot", c->page, 0);
+  FOOTPRINT("snapshot", c->undo, 0);
+  free(c->page);
+  free(c->undo);
+  c->page = NULL;
+  c->undo = NULL;
+  c->nr_page = 0;
+}
+
+static void ckpt_free(Checkpoint *c) {
+  ckpt_free_pages(c);
+  FOOTPRINT("snapshot", c->dev, 0);
+  free(c->dev);
+  c->dev = NULL;
+}
+
+static void drop_oldest() {
+  ckpt_free(CKPT(0));
+  ckpt_head = (ckpt_head + 1) % NR_CKPT;
+  nr_ckpt --;
+  // the oldest one is never restored to the checkpoint before
+  Checkpoint *c = CKPT(0);
+  ckpt_free_pages(c);
+  memmove(input, input + (c->input_pos - input_base), (nr_input - c->input_pos) * sizeof(*input));
+  input_base = c->input_pos;
+}
+
+#define PAGE_IDX(page) (((page) - CONFIG_MBASE) / PAGE_SIZE)
+#define SHADOW(page) (shadow + ((page) - CONFIG_MBASE))
+
+static void shadow_read(paddr_t page, uint8_t *dst) {
+  if (shadow_kept[PAGE_IDX(page)]) memcpy(dst, SHADOW(page), PAGE_SIZE);
+  else memset(dst, shadow_fill[PAGE_IDX(page)], PAGE_SIZE);
+}
+
+static void shadow_write(paddr_t page, const uint8_t *src) {
+  memcpy(SHADOW(page), src, PAGE_SIZE);
+  shadow_kept[PAGE_IDX(page)] = true;
+}
+
+static void shadow_init() {
+  // the pages of the mapping are committed when they are written
+  if (shadow == NULL) {
+    shadow = mmap(NULL, CONFIG_MSIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    assert(shadow != MAP_FAILED);
+    FOOTPRINT("snapshot", shadow, CONFIG_MSIZE);
+  } else {
+    madvise(shadow, CONFIG_MSIZE, MADV_DONTNEED);
+  }
+  paddr_t page;
+  for (page = CONFIG_MBASE; page - CONFIG_MBASE < CONFIG_MSIZE; page += PAGE_SIZE) {
+    shadow_kept[PAGE_IDX(page)] = false;
+    if (!paddr_page_blank(page, &shadow_fill[PAGE_IDX(page)])) shadow_write(page, guest_to_host(page));
+  }
+}
+
+static void take_checkpoint() {
+  if (nr_ckpt == NR_CKPT) drop_oldest();
+  Checkpoint *c = CKPT(nr_ckpt);
+  c->icount = icount;
+  c->nr_guest_inst = g_nr_guest_inst;
+  c->input_pos = input_pos;
+  c->cpu = cpu;
+  c->dev = snapshot_save_devices(&c->dev_size);
+  FOOTPRINT("snapshot", c->dev, c->dev_size);
+  if (nr_ckpt == 0) shadow_init();
+  else {
+    paddr_t page = CONFIG_MBASE;
+    int n = 0;
+    for (; paddr_next_dirty(&page); page += PAGE_SIZE) n ++;
+    c->page = malloc(n * sizeof(*c->page));
+    c->undo = malloc((size_t)n * PAGE_SIZE);
+    assert(n == 0 || (c->page && c->undo));
+    FOOTPRINT("snapshot", c->page, n * sizeof(*c->page));
+    FOOTPRINT("snapshot", c->undo, (size_t)n * PAGE_SIZE);
+    for (page = CONFIG_MBASE; paddr_next_dirty(&page); page += PAGE_SIZE) {
+      shadow_read(page, c->undo + (size_t)c->nr_page * PAGE_SIZE);
+      shadow_write(page, guest_to_host(page));
+      c->page[c->nr_page ++] = page;
+    }
+  }
+  paddr_clear_dirty(CONFIG_MBASE, CONFIG_MSIZE);
+  nr_ckpt ++;
+  next_ckpt = icount + INTERVAL;
+}
+
+uint64_t reverse_limit(uint64_t n) {
+  if (nr_ckpt == 0) take_checkpoint();
+  return (next_ckpt - icount < n ? next_ckpt - icount : n);
+}
+
+void reverse_advance(uint64_t n) {
+  icount += n;
+  if (icount == next_ckpt) take_checkpoint();
+}
+
+void reverse_reset() {
+  while (nr_ckpt > 0) {
+    ckpt_free(CKPT(nr_ckpt - 1));
+    nr_ckpt --;
+  }
+  ckpt_head = 0;
+  icount = 0;
+  input_base = input_pos = nr_input = 0;
+}
+
+uint64_t reverse_icount() { return icount; }
+
+static void restore_page(paddr_t page, const uint8_t *data) {
+  memcpy(guest_to_host(page), data, PAGE_SIZE);
+  // drop the instructions cached and update the watchpoints
+  paddr_host_written(page, PAGE_SIZE);
+}
+
+static void restore(int idx) {
+  paddr_t page = CONFIG_MBASE;
+  for (; paddr_next_dirty(&page); page += PAGE_SIZE) {
+    shadow_read(page, guest_to_host(page));
+    paddr_host_written(page, PAGE_SIZE);
+  }
+  for (; nr_ckpt - 1 > idx; nr_ckpt --) {
+    Checkpoint *c = CKPT(nr_ckpt - 1);
+    int i;
+    for (i = 0; i < c->nr_page; i ++) {
+      uint8_t *undo = c->undo + (size_t)i * PAGE_SIZE;
+      shadow_write(c->page[i], undo);
+      restore_page(c->page[i], undo);
+    }
+    ckpt_free(c);
+  }
+  paddr_clear_dirty(CONFIG_MBASE, CONFIG_MSIZE);
+
+  Checkpoint *c = CKPT(idx);
+  cpu = c->cpu;
+  g_nr_guest_inst = c->nr_guest_inst;
+  icount = c->icount;
+  input_pos = c->input_pos;
+  snapshot_load_devices(c->dev, c->dev_size);
+  vaddr_tlb_flush();
+  next_ckpt = icount + INTERVAL;
+  if (nemu_state.state != NEMU_RUNNING) nemu_state.state = NEMU_STOP;
+}
+
+// the latest checkpoint not after `target`
+static int find_checkpoint(uint64_t target) {
+  int i = nr_ckpt - 1;
+  while (i > 0 && CKPT(i)->icount > target) i --;
+  return i;
+}
+
+/* Replay from checkpoint `idx` to `end`, and return the position of the last
+ * stop by breakpoints and watchpoints before `before`, or 0 if none. The
+ * checkpoint is never a stop, since no instruction is executed there. */
+static uint64_t replay(int idx, uint64_t end, uint64_t before) {
+  uint64_t last = 0;
+  reverse_replaying = true;
+  restore(idx);
+  while (icount < end) {
+    uint64_t start = icount;
+    bool stopped = cpu_exec_replay(end - icount);
+    if (stopped && icount < before) last = icount;
+    if (nemu_state.state != NEMU_STOP || (icount == start && !stopped)) break;
+  }
+  reverse_replaying = false;
+  if (icount != end) {
+    Log_warn("Replaying stops at %" PRIu64 " instead of %" PRIu64 ", the execution is not deterministic",
+        icount, end);
+  }
+  return last;
+}
+
+bool reverse_step(uint64_t n) {
+  if (nr_ckpt == 0 || icount == CKPT(0)->icount) {
+    printf("No instruction is executed since the oldest checkpoint\n");
+    return false;
+  }
+  uint64_t target = (icount - CKPT(0)->icount > n ? icount - n : CKPT(0)->icount);
+  if (icount - target < n) printf("Only %" PRIu64 " instructions are kept\n", icount - target);
+  replay(find_checkpoint(target), target, 0);
+  return true;
+}
+
+bool reverse_continue() {
+  if (nr_ckpt == 0 || icount == CKPT(0)->icount) {
+    printf("No instruction is executed since the oldest checkpoint\n");
+    return false;
+  }
+  uint64_t cur = icount;
+  int idx = find_checkpoint(cur - 1);
+  uint64_t end = cur, hit = 0;
+  // search the intervals between checkpoints from the latest one
+  for (; idx >= 0; idx --) {
+    uint64_t start = CKPT(idx)->icount;
+    hit = replay(idx, end, cur);
+    if (hit != 0) break;
+    end = start;
+  }
+  if (hit == 0) {
+    printf("No breakpoint or watchpoint is hit since the oldest checkpoint\n");
+    replay(0, CKPT(0)->icount, 0);
+    return true;
+  }
+  replay(find_checkpoint(hit), hit, 0);
+  return true;
+}
+
+void reverse_display() {
+  if (nr_ckpt == 0) {
+    printf("No checkpoints.\n");
+    return;
+  }
+  printf("%d checkpoints in [%" PRIu64 ", %" PRIu64 "], now at %" PRIu64 ", %" PRIu64
+      " inputs recorded\n", nr_ckpt, CKPT(0)->icount, CKPT(nr_ckpt - 1)->icount, icount,
+      nr_input - input_base);
+}
@@ -0,0 +1,83 @@
+/***************************************************************************************
+* Copyright (c) 2014-2024 Zihao Yu, Nanjing University
+*
+* NEMU is licensed under Mulan PSL v2.
+* You can use this software according to the terms and conditions of the Mulan PSL v2.
+* You may obtain a copy of Mulan PSL v2 at:
+*          http://license.coscl.org.cn/MulanPSL2
+*
+* THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+* EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+* MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+*
+* See the Mulan PSL v2 for more details.
+***************************************************************************************/
+
+
+#include <cpu/bbv.h>
+#include <errno.h>
+#include <limits.h>
+#include <sys/stat.h>
+
+static uint64_t *point = NULL; // the intervals chosen, in ascending order
+static int nr_point = 0, cur = 0;
+static char *ckpt_dir = NULL;
+
+bool snapshot_save(const char *file);
+
+static int point_cmp(const void *a, const void *b) {
+  uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+  return (x > y) - (x < y);
+}
+
+/* `file` is the output of SimPoint by -saveSimpoints, with a line of
+ * "INTERVAL CLUSTER" for each interval chosen. The snapshots are saved to
+ * DIR/INTERVAL.snap. */
+bool simpoint_open(const char *file, const char *dir) {
+  FILE *fp = fopen(file, "r");
+  if (fp == NULL) return false;
+  uint64_t interval;
+  int cluster, max_point = 0;
+  while (fscanf(fp, "%" SCNu64 " %d", &interval, &cluster) == 2) {
+    if (nr_point == max_point) {
+      max_point = (max_point == 0 ? 64 : max_point * 2);
+      point = realloc(point, sizeof(*point) * max_point);
+      assert(point != NULL);
+    }
+    point[nr_point ++] = interval;
+  }
+  fclose(fp);
+  qsort(point, nr_point, sizeof(*point), point_cmp);
+
+  ckpt_dir = strdup(dir);
+  if (mkdir(dir, 0755) != 0 && errno != EEXIST) return false;
+  Log("%d simpoints, saving snapshots to %s", nr_point, dir);
+  return true;
+}
+
+static uint64_t next_start() {
+  return point[cur] * CONFIG_BBV_INTERVAL;
+}
+
+uint64_t simpoint_limit(uint64_t n) {
+  if (cur == nr_point) return n;
+  extern uint64_t g_nr_guest_inst;
+  uint64_t left = (next_start() > g_nr_guest_inst ? next_start() - g_nr_guest_inst : 0);
+  return (left < n ? left : n);
+}
+
+void simpoint_advance() {
+  extern uint64_t g_nr_guest_inst;
+  if (cur == nr_point || g_nr_guest_inst < next_start()) return;
+  char file[PATH_MAX];
+  snprintf(file, sizeof(file), "%s/%" PRIu64 ".snap", ckpt_dir, point[cur]);
+  bool ok = snapshot_save(file);
+  Assert(ok, "Can not save snapshot to '%s'", file);
+  Log("simpoint %" PRIu64 " saved to %s at instruction %" PRIu64, point[cur], file, g_nr_guest_inst);
+  // skip the duplicates, and those passed by CONFIG_IDLE_SLEEP
+  while (cur < nr_point && next_start() <= g_nr_guest_inst) cur ++;
+  if (cur == nr_point) {
+    // nothing is left to save
+    nemu_state.state = NEMU_QUIT;
+  }
+}
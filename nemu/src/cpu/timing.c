@@ -0,0 +1,26 @@
+/***************************************************************************************
+* Copyright (c) 2014-2024 Zihao Yu, Nanjing University
+*
+* NEMU is licensed under Mulan PSL v2.
+* You can use this software according to the terms and conditions of the Mulan PSL v2.
+* You may obtain a copy of Mulan PSL v2 at:
+*          http://license.coscl.org.cn/MulanPSL2
+*
+* THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+* EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+* MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+*
+* See the Mulan PSL v2 for more details.
+***************************************************************************************/
+
+#include <cpu/timing.h>
+
+uint64_t timing_cycle = 0;
+vaddr_t timing_tag[TIMING_NR_LINE] = {};
+vaddr_t timing_btb[TIMING_NR_BTB] = {};
+
+void timing_report() {
+  extern uint64_t g_nr_guest_inst;
+  Log("estimated cycles = %" PRIu64 ", IPC = %.3f", timing_cycle,
+      (timing_cycle == 0 ? 0 : (double)g_nr_guest_inst / timing_cycle));
+}
@@ -14,38 +14,20 @@
 ***************************************************************************************/
 
 #include <common.h>
+#include <utils.h>
 #include <device/alarm.h>
-#include <sys/time.h>
-#include <signal.h>
+#include <device/event.h>
 
-#define MAX_HANDLER 8
+/* Each handler is called by its own periodic event of devices, in the host
+ * time or in the virtual time, so nothing interrupts the execution loop or
+ * host I/O. */
+#define ALARM_PERIOD_US (1000000 / TIMER_HZ)
 
-static alarm_handler_t handler[MAX_HANDLER] = {};
-static int idx = 0;
-
-void add_alarm_handle(alarm_handler_t h) {
-  assert(idx < MAX_HANDLER);
-  handler[idx ++] = h;
-}
-
-static void alarm_sig_handler(int signum) {
-  int i;
-  for (i = 0; i < idx; i ++) {
-    handler[i]();
-  }
+static void alarm_event(void *arg) {
+  ((alarm_handler_t)arg)();
 }
 
-void init_alarm() {
-  struct sigaction s;
-  memset(&s, 0, sizeof(s));
-  s.sa_handler = alarm_sig_handler;
-  int ret = sigaction(SIGVTALRM, &s, NULL);
-  Assert(ret == 0, "Can not set signal handler");
-
-  struct itimerval it = {};
-  it.it_value.tv_sec = 0;
-  it.it_value.tv_usec = 1000000 / TIMER_HZ;
-  it.it_interval = it.it_value;
-  ret = setitimer(ITIMER_VIRTUAL, &it, NULL);
-  Assert(ret == 0, "Can not set timer");
+void add_alarm_handle(alarm_handler_t h) {
+  int id = dev_event_new("alarm", alarm_event, h);
+  dev_event_periodic(id, ALARM_PERIOD_US);
 }
@@ -0,0 +1,86 @@
+/***************************************************************************************
+* Copyright (c) 2014-2024 Zihao Yu, Nanjing University
+*
+* NEMU is licensed under Mulan PSL v2.
+* You can use this software according to the terms and conditions of the Mulan PSL v2.
+* You may obtain a copy of Mulan PSL v2 at:
+*          http://license.coscl.org.cn/MulanPSL2
+*
+* THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+* EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+* MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+*
+* See the Mulan PSL v2 for more details.
+***************************************************************************************/
+
+#include <common.h>
+#include <device/async.h>
+#include <pthread.h>
+
+#define NR_JOB 64
+
+typedef struct {
+  dev_work_t work, done;
+  void *arg;
+} Job;
+
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t cond = PTHREAD_COND_INITIALIZER;
+// queued jobs in a ring, and finished ones waiting for being reaped
+static Job queue[NR_JOB], finished[NR_JOB];
+static int q_head = 0, q_len = 0, nr_finished = 0;
+// jobs queued, running or finished but not reaped, only changed by the CPU thread
+static int nr_job = 0;
+static bool has_finished = false;
+static bool started = false;
+
+static void *worker(void *arg) {
+  pthread_mutex_lock(&lock);
+  while (true) {
+    while (q_len == 0) pthread_cond_wait(&cond, &lock);
+    Job j = queue[q_head];
+    q_head = (q_head + 1) % NR_JOB;
+    q_len --;
+    pthread_mutex_unlock(&lock);
+    j.work(j.arg);
+    pthread_mutex_lock(&lock);
+    finished[nr_finished ++] = j;
+    __atomic_store_n(&has_finished, true, __ATOMIC_RELEASE);
+  }
+  return NULL;
+}
+
+static void start_workers() {
+  int i;
+  for (i = 0; i < CONFIG_DEVICE_WORKERS; i ++) {
+    pthread_t thread;
+    int ret = pthread_create(&thread, NULL, worker, NULL);
+    Assert(ret == 0, "Can not create the worker threads of devices");
+    pthread_detach(thread);
+  }
+  started = true;
+}
+
+void dev_async(dev_work_t work, dev_work_t done, void *arg) {
+  if (!started) start_workers();
+  Assert(nr_job < NR_JOB, "Too many operations of devices in flight");
+  nr_job ++;
+  pthread_mutex_lock(&lock);
+  queue[(q_head + q_len) % NR_JOB] = (Job) { .work = work, .done = done, .arg = arg };
+  q_len ++;
+  pthread_cond_signal(&cond);
+  pthread_mutex_unlock(&lock);
+}
+
+void dev_async_reap() {
+  if (!__atomic_load_n(&has_finished, __ATOMIC_ACQUIRE)) return;
+  Job j[NR_JOB];
+  pthread_mutex_lock(&lock);
+  int n = nr_finished, i;
+  memcpy(j, finished, n * sizeof(Job));
+  nr_finished = 0;
+  __atomic_store_n(&has_finished, false, __ATOMIC_RELAXED);
+  pthread_mutex_unlock(&lock);
+  nr_job -= n;
+  for (i = 0; i < n; i ++) j[i].done(j[i].arg);
+}
@@ -15,6 +15,7 @@
 
 #include <common.h>
 #include <device/map.h>
+#include <device/replay.h>
 #include <SDL2/SDL.h>
 
 enum {
@@ -30,12 +31,266 @@ enum {
 static uint8_t *sbuf = NULL;
 static uint32_t *audio_base = NULL;
 
+/* sbuf is a single-producer single-consumer ring. The guest appends
+ * samples after the ones it has written before and then commits them by
+ * writing reg_count, while the SDL callback consumes them from another
+ * thread. `produced` and `consumed` count bytes since initialization and
+ * are only written by the CPU thread and the callback respectively, so
+ * reg_count = produced - consumed needs no lock.
+ *
+ * A guest usually commits with `count = count + len`. Samples may be
+ * consumed between reading and writing reg_count, so the bytes committed
+ * are measured against the value read last, instead of the current count.
+ */
+static uint32_t produced = 0, consumed = 0;
+static uint32_t count_read = 0; // only used by the CPU thread
+
+/* SDL is opened once at the rate and the channels of the host, and the
+ * samples of the guest are converted by the callback, so that programming
+ * the registers with another format does not reopen the device. A chunk of
+ * guest frames is widened to float and mixed to the host channels into
+ * `in`, whose first frame is the last one of the chunk before, and then
+ * resampled linearly into `out` and narrowed back to S16. `pos` is
+ * the position of the next output frame in `in`, in 32.32 fixed point,
+ * and advances by `step` = guest rate / host rate for each of them. */
+static SDL_AudioDeviceID dev = 0;
+static SDL_AudioSpec have = {};
+static struct {
+  int gch, hch; // channels of the guest and the host
+  uint64_t pos, step;
+  int max_out; // frames converted at a time
+  float *in, *out, *tmp;
+} cv = {};
+
+/* The samples are converted in blocks of LANES, whose loops have a known
+ * trip count for the compiler to turn into SIMD, and the rest one by one. */
+#define LANES 8
+
+static inline float s16_to_float(int16_t x) { return x * (1.0f / 32768); }
+
+static inline int16_t float_to_s16(float x) {
+  x *= 32768;
+  x = (x > 32767 ? 32767 : x);
+  x = (x < -32768 ? -32768 : x);
+  return (int16_t)x;
+}
+
+static void widen(float *restrict dst, const int16_t *restrict src, int n) {
+  int i, j;
+  for (i = 0; i + LANES <= n; i += LANES)
+    for (j = 0; j < LANES; j ++) dst[i + j] = s16_to_float(src[i + j]);
+  for (; i < n; i ++) dst[i] = s16_to_float(src[i]);
+}
+
+static void narrow(int16_t *restrict dst, const float *restrict src, int n) {
+  int i, j;
+  for (i = 0; i + LANES <= n; i += LANES)
+    for (j = 0; j < LANES; j ++) dst[i + j] = float_to_s16(src[i + j]);
+  for (; i < n; i ++) dst[i] = float_to_s16(src[i]);
+}
+
+// mix `n` frames of the guest to the host channels
+static void mix(float *restrict dst, const float *restrict src, int n) {
+  int gch = cv.gch, hch = cv.hch, i, c;
+  if (gch == hch) memcpy(dst, src, sizeof(float) * n * hch);
+  else if (hch == 1) {
+    for (i = 0; i < n; i ++) {
+      float sum = 0;
+      for (c = 0; c < gch; c ++) sum += src[i * gch + c];
+      dst[i] = sum / gch;
+    }
+  } else if (gch == 1) {
+    for (i = 0; i < n; i ++)
+      for (c = 0; c < hch; c ++) dst[i * hch + c] = src[i];
+  } else {
+    // the channels missing in the guest repeat those it has
+    for (i = 0; i < n; i ++)
+      for (c = 0; c < hch; c ++) dst[i * hch + c] = src[i * gch + c % gch];
+  }
+}
+
+static void resample(float *restrict dst, const float *restrict src, int n) {
+  int hch = cv.hch, i, c;
+  if (cv.step == (1ull << 32) && cv.pos == 0) {
+    // the same rate
+    memcpy(dst, src, sizeof(float) * n * hch);
+    return;
+  }
+  for (i = 0; i < n; i ++) {
+    uint64_t p = cv.pos + cv.step * i;
+    const float *a = src + (p >> 32) * hch;
+    float frac = (uint32_t)p * (1.0f / 4294967296.0f);
+    for (c = 0; c < hch; c ++) dst[i * hch + c] = a[c] + (a[c + hch] - a[c]) * frac;
+  }
+}
+
+// fill `n` <= cv.max_out frames of `stream`, return those with samples
+static int convert(int16_t *stream, int n) {
+  int hch = cv.hch;
+  uint32_t fbytes = cv.gch * sizeof(int16_t);
+  uint32_t c = consumed;
+  uint64_t avail = (__atomic_load_n(&produced, __ATOMIC_ACQUIRE) - c) / fbytes;
+  uint64_t m = ((cv.pos + cv.step * n) >> 32) + 1;
+  if (m > avail) m = avail;
+
+  // widen the ring, which wraps at a sample
+  uint32_t pos = c % CONFIG_SB_SIZE, len = m * fbytes;
+  uint32_t first = (len < CONFIG_SB_SIZE - pos ? len : CONFIG_SB_SIZE - pos);
+  widen(cv.tmp, (int16_t *)(sbuf + pos), first / sizeof(int16_t));
+  widen(cv.tmp + first / sizeof(int16_t), (int16_t *)sbuf, (len - first) / sizeof(int16_t));
+  mix(cv.in + hch, cv.tmp, m);
+
+  // frames whose both neighbours are in `in`
+  uint64_t end = m << 32;
+  int nr = (end <= cv.pos ? 0 : (end - cv.pos + cv.step - 1) / cv.step);
+  if (nr > n) nr = n;
+  resample(cv.out, cv.in, nr);
+  narrow(stream, cv.out, nr * hch);
+
+  // keep the frame before the next output, and drop the fraction on underrun
+  uint64_t p = cv.pos + cv.step * nr;
+  uint64_t k = p >> 32;
+  if (k > m) { k = m; p = k << 32; }
+  memmove(cv.in, cv.in + k * hch, sizeof(float) * hch);
+  cv.pos = p - (k << 32);
+  __atomic_store_n(&consumed, c + k * fbytes, __ATOMIC_RELEASE);
+  return nr;
+}
+
+static void audio_play(void *userdata, uint8_t *stream, int len) {
+  int16_t *out = (int16_t *)stream;
+  int n = len / (cv.hch * sizeof(int16_t));
+  while (n > 0 && cv.step != 0) {
+    int chunk = (n < cv.max_out ? n : cv.max_out);
+    int nr = convert(out, chunk);
+    out += nr * cv.hch;
+    n -= nr;
+    if (nr < chunk) break;
+  }
+  // play silence on underrun
+  memset(out, 0, stream + len - (uint8_t *)out);
+}
+
+extern bool device_headless;
+
+/* With --headless, the samples are consumed by a null sink instead of SDL,
+ * at the rate they would be played, so that a guest waiting for sbuf to
+ * drain runs as it does with sound. The sink goes by the time of the guest,
+ * which is virtual with CONFIG_TIMER_VIRTUAL, and plays silence when sbuf
+ * is empty, as the callback of SDL does. */
+static uint64_t sink_rate = 0; // bytes per second
+static uint64_t sink_time = 0; // when the sink played its last byte
+
+static uint64_t sink_now() {
+#ifdef CONFIG_TIMER_VIRTUAL
+  extern uint64_t g_nr_guest_inst;
+  return g_nr_guest_inst / CONFIG_TIMER_VIRTUAL_MIPS;
+#else
+  return get_time();
+#endif
+}
+
+static void sink_play() {
+  if (sink_rate == 0) { consumed = produced; return; }
+  uint64_t n = (sink_now() - sink_time) * sink_rate / 1000000;
+  if (n == 0) return;
+  // the rest of a byte is left to the next time
+  sink_time += n * 1000000 / sink_rate;
+  uint32_t avail = produced - consumed;
+  consumed += (n < avail ? n : avail);
+}
+
+static void audio_open() {
+  SDL_AudioSpec want = {};
+  want.format = AUDIO_S16SYS;
+  want.freq = CONFIG_AUDIO_FREQ;
+  want.channels = 2;
+  want.samples = (audio_base[reg_samples] != 0 ? audio_base[reg_samples] : 1024);
+  want.callback = audio_play;
+  want.userdata = NULL;
+  SDL_InitSubSystem(SDL_INIT_AUDIO);
+  dev = SDL_OpenAudioDevice(NULL, 0, &want, &have,
+      SDL_AUDIO_ALLOW_FREQUENCY_CHANGE | SDL_AUDIO_ALLOW_CHANNELS_CHANGE);
+  if (dev == 0) { Log_warn("Can not open audio: %s", SDL_GetError()); return; }
+  Log("Audio is played at %d Hz with %d channels", have.freq, have.channels);
+}
+
+// a higher rate is played as this one, and more channels are not played
+#define MAX_FREQ 384000
+#define MAX_CHANNELS 8
+
+static void audio_init() {
+  if (device_headless) {
+    produced = consumed = count_read = 0;
+    sink_rate = (uint64_t)audio_base[reg_freq] * audio_base[reg_channels] * sizeof(int16_t);
+    sink_time = sink_now();
+    return;
+  }
+
+  if (dev == 0) audio_open();
+  if (dev != 0) SDL_LockAudioDevice(dev);
+  produced = consumed = count_read = 0;
+  if (dev != 0) {
+    uint32_t freq = audio_base[reg_freq], gch = audio_base[reg_channels];
+    if (freq > MAX_FREQ) freq = MAX_FREQ;
+    if (gch > MAX_CHANNELS) { Log_warn("Can not play %u channels", gch); gch = 0; }
+    cv.gch = gch;
+    cv.hch = have.channels;
+    cv.pos = 0;
+    // nothing is consumed without a format
+    cv.step = (gch == 0 ? 0 : ((uint64_t)freq << 32) / have.freq);
+    cv.max_out = have.samples;
+    uint64_t max_in = ((cv.step * cv.max_out) >> 32) + 2;
+    cv.in = realloc(cv.in, sizeof(float) * (max_in + 1) * cv.hch);
+    cv.out = realloc(cv.out, sizeof(float) * cv.max_out * cv.hch);
+    cv.tmp = realloc(cv.tmp, sizeof(float) * max_in * (gch == 0 ? 1 : gch));
+    // silence before the first frame
+    memset(cv.in, 0, sizeof(float) * cv.hch);
+    SDL_UnlockAudioDevice(dev);
+    SDL_PauseAudioDevice(dev, 0);
+  }
+}
+
 static void audio_io_handler(uint32_t offset, int len, bool is_write) {
+  switch (offset / sizeof(uint32_t)) {
+    case reg_init:
+      if (is_write && audio_base[reg_init] != 0) audio_init();
+      break;
+    case reg_count:
+      if (!is_write) {
+        if (device_headless) sink_play();
+        count_read = DEVICE_INPUT(produced - __atomic_load_n(&consumed, __ATOMIC_ACQUIRE));
+        audio_base[reg_count] = count_read;
+      } else {
+        uint32_t count = audio_base[reg_count];
+        uint32_t n = (count > count_read ? count - count_read : 0);
+        uint32_t free = CONFIG_SB_SIZE - (produced - __atomic_load_n(&consumed, __ATOMIC_ACQUIRE));
+        if (n > free) n = free;
+        count_read = count;
+        // publish the samples written to sbuf before
+        __atomic_store_n(&produced, produced + n, __ATOMIC_RELEASE);
+      }
+      break;
+  }
+}
+
+// append samples natively, return the number of bytes accepted
+uint32_t audio_write(const uint8_t *buf, uint32_t len) {
+  uint32_t p = produced;
+  uint32_t free = CONFIG_SB_SIZE - (p - __atomic_load_n(&consumed, __ATOMIC_ACQUIRE));
+  uint32_t n = (len < free ? len : free);
+  uint32_t pos = p % CONFIG_SB_SIZE;
+  uint32_t first = (n < CONFIG_SB_SIZE - pos ? n : CONFIG_SB_SIZE - pos);
+  memcpy(sbuf + pos, buf, first);
+  memcpy(sbuf, buf + first, n - first);
+  __atomic_store_n(&produced, p + n, __ATOMIC_RELEASE);
+  return n;
 }
 
 void init_audio() {
   uint32_t space_size = sizeof(uint32_t) * nr_reg;
   audio_base = (uint32_t *)new_space(space_size);
+  audio_base[reg_sbuf_size] = CONFIG_SB_SIZE;
 #ifdef CONFIG_HAS_PORT_IO
   add_pio_map ("audio", CONFIG_AUDIO_CTL_PORT, audio_base, space_size, audio_io_handler);
 #else
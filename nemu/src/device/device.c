@@ -14,10 +14,15 @@
 ***************************************************************************************/
 
 #include <common.h>
+#include <isa.h>
 #include <utils.h>
 #include <device/alarm.h>
+#include <device/replay.h>
+#include <device/async.h>
+#include <device/event.h>
 #ifndef CONFIG_TARGET_AM
 #include <SDL2/SDL.h>
+#include <unistd.h>
 #endif
 
 void init_map();
@@ -28,46 +33,127 @@ void init_i8042();
 void init_audio();
 void init_disk();
 void init_sdcard();
-void init_alarm();
+void init_pvio();
+void init_net();
+void init_hartctl();
 
 void send_key(uint8_t, bool);
-void vga_update_screen();
+void keyboard_poll();
 
-void device_update() {
-  static uint64_t last = 0;
-  uint64_t now = get_time();
-  if (now - last < 1000000 / TIMER_HZ) {
-    return;
-  }
-  last = now;
+// the host and the async operations are polled TIMER_HZ times per second
+#define POLL_PERIOD_US (1000000 / TIMER_HZ)
 
-  IFDEF(CONFIG_HAS_VGA, vga_update_screen());
+// set by --headless, so that SDL is never initialized
+bool device_headless = false;
 
 #ifndef CONFIG_TARGET_AM
-  SDL_Event event;
-  while (SDL_PollEvent(&event)) {
-    switch (event.type) {
-      case SDL_QUIT:
-        nemu_state.state = NEMU_QUIT;
-        break;
-#ifdef CONFIG_HAS_KEYBOARD
-      // If a key was pressed
-      case SDL_KEYDOWN:
-      case SDL_KEYUP: {
-        uint8_t k = event.key.keysym.scancode;
-        bool is_keydown = (event.key.type == SDL_KEYDOWN);
-        send_key(k, is_keydown);
-        break;
-      }
+#ifdef CONFIG_VGA_THREAD
+/* SDL is owned by the display thread, which polls the events and sends the
+ * keys to the keyboard device through its lock-free queue. The CPU thread
+ * only checks this flag for the requests it must handle by itself. */
+static bool quit_pending = false;
+#define request_quit() __atomic_store_n(&quit_pending, true, __ATOMIC_RELEASE)
+#else
+#define request_quit() (nemu_state.state = NEMU_QUIT)
 #endif
-      default: break;
+
+static void handle_event(SDL_Event *event) {
+  switch (event->type) {
+    case SDL_QUIT:
+      request_quit();
+      break;
+#ifdef CONFIG_HAS_KEYBOARD
+    // If a key was pressed
+    case SDL_KEYDOWN:
+    case SDL_KEYUP: {
+      uint8_t k = event->key.keysym.scancode;
+      bool is_keydown = (event->key.type == SDL_KEYDOWN);
+      send_key(k, is_keydown);
+      break;
     }
+#endif
+    default: break;
+  }
+}
+
+// should only be called by the thread owning SDL
+void device_poll_events() {
+  // there are no events before the window is opened, which never is with --headless
+  if (device_headless || SDL_WasInit(SDL_INIT_VIDEO) == 0) return;
+  IFDEF(CONFIG_HAS_KEYBOARD, keyboard_poll());
+  SDL_Event event;
+  while (SDL_PollEvent(&event)) handle_event(&event);
+}
+#endif
+
+static void device_poll() {
+  IFDEF(CONFIG_DEVICE_ASYNC, dev_async_reap());
+
+#ifdef CONFIG_VGA_THREAD
+  if (__atomic_load_n(&quit_pending, __ATOMIC_ACQUIRE)) {
+    __atomic_store_n(&quit_pending, false, __ATOMIC_RELAXED);
+    nemu_state.state = NEMU_QUIT;
   }
+#elif !defined(CONFIG_TARGET_AM)
+  device_poll_events();
 #endif
 }
 
+static void poll_event(void *arg) {
+  device_poll();
+}
+
+#ifdef CONFIG_IDLE_SLEEP
+/* The guest is considered idle after reading the timer or the empty keyboard
+ * IDLE_THRESHOLD times in a row at the same pc, with no more than
+ * IDLE_MAX_GAP instructions between two readings. Then the host sleeps for
+ * IDLE_SLEEP_US at each reading, and the instructions which would have run
+ * meanwhile are estimated from the speed measured before getting idle.
+ */
+#define IDLE_THRESHOLD 1024
+#define IDLE_MAX_GAP 64
+#define IDLE_SLEEP_US 1000
+
+void device_idle_poll() {
+  // the host does not sleep while replaying
+  IFDEF(CONFIG_REVERSE, if (replay_pending()) return);
+  extern uint64_t g_nr_guest_inst;
+  static vaddr_t last_pc = 0;
+  static uint64_t last_inst = 0, start_inst = 0, start_time = 0;
+  static int nr_spin = 0;
+  static double rate = 0; // guest instructions per us
+
+  uint64_t inst = g_nr_guest_inst;
+  bool spinning = (cpu.pc == last_pc && inst - last_inst <= IDLE_MAX_GAP);
+  last_pc = cpu.pc;
+  last_inst = inst;
+  if (!spinning) {
+    nr_spin = 0;
+    start_inst = inst;
+    start_time = get_time();
+    return;
+  }
+
+  if (nr_spin < IDLE_THRESHOLD) {
+    if (++ nr_spin < IDLE_THRESHOLD) return;
+    uint64_t elapsed = get_time() - start_time;
+    rate = (elapsed > 0 ? (double)(inst - start_inst) / elapsed : 0);
+  }
+
+  usleep(IDLE_SLEEP_US);
+  g_nr_guest_inst += rate * IDLE_SLEEP_US;
+
+  // few instructions are executed now, so run the events due by the host time
+  device_update();
+}
+#endif
+
 void sdl_clear_event_queue() {
-#ifndef CONFIG_TARGET_AM
+#ifdef CONFIG_VGA_THREAD
+  // keys are already dropped by the keyboard while the guest is stopped
+  __atomic_store_n(&quit_pending, false, __ATOMIC_RELEASE);
+#elif !defined(CONFIG_TARGET_AM)
+  if (SDL_WasInit(SDL_INIT_VIDEO) == 0) return;
   SDL_Event event;
   while (SDL_PollEvent(&event));
 #endif
@@ -84,6 +170,9 @@ void init_device() {
   IFDEF(CONFIG_HAS_AUDIO, init_audio());
   IFDEF(CONFIG_HAS_DISK, init_disk());
   IFDEF(CONFIG_HAS_SDCARD, init_sdcard());
+  IFDEF(CONFIG_HAS_PVIO, init_pvio());
+  IFDEF(CONFIG_HAS_NET, init_net());
+  IFDEF(CONFIG_HAS_HART_CTL, init_hartctl());
 
-  IFNDEF(CONFIG_TARGET_AM, init_alarm());
+  dev_event_periodic(dev_event_new("poll", poll_event, NULL), POLL_PERIOD_US);
 }
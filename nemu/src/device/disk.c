@@ -14,6 +14,156 @@
 ***************************************************************************************/
 
 #include <device/map.h>
+#include <memory/paddr.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+/* A block device without PIO. The guest programs the guest physical
+ * address of a buffer, the first block and the number of blocks, then
+ * writes the command register. The whole transfer is done by a single
+ * pread() or pwrite() between the image and pmem. With CONFIG_DEVICE_ASYNC,
+ * the transfer runs on a worker thread, and the status reads DISK_BUSY
+ * until it completes and raises an interrupt. */
+enum {
+  reg_present,
+  reg_blksz,
+  reg_blkcnt,
+  reg_buf,
+  reg_blkno,
+  reg_count,
+  reg_cmd,
+  reg_status,
+  nr_reg
+};
+
+enum { DISK_CMD_READ = 1, DISK_CMD_WRITE = 2 };
+enum { DISK_OK = 0, DISK_ERROR = 1, DISK_BUSY = 2 };
+
+#define BLKSZ 512
+
+static uint32_t *disk_base = NULL;
+static int disk_fd = -1;
+static bool disk_writable = false;
+
+static bool blkio_check(paddr_t buf, uint64_t blkno, uint64_t count, bool is_write) {
+  size_t len = count * BLKSZ;
+  if (disk_fd < 0 || blkno + count > disk_base[reg_blkcnt]) return false;
+  if (is_write && !disk_writable) return false;
+  if (len == 0) return true;
+  return in_pmem(buf) && in_pmem(buf + len - 1) && buf + len - 1 >= buf;
+}
+
+// only touch the image and pmem, and return the number of bytes transferred
+static size_t blkio_transfer(paddr_t buf, uint64_t blkno, size_t len, bool is_write) {
+  uint8_t *host = guest_to_host(buf);
+  off_t offset = blkno * BLKSZ;
+  size_t done = 0;
+  while (done < len) {
+    ssize_t n = (is_write ? pwrite(disk_fd, host + done, len - done, offset + done)
+                          : pread (disk_fd, host + done, len - done, offset + done));
+    if (n <= 0) break;
+    done += n;
+  }
+  return done;
+}
+
+bool disk_blkio(paddr_t buf, uint64_t blkno, uint64_t count, bool is_write) {
+  // called by pvio without accessing the registers
+  io_space_init(disk_base);
+  if (!blkio_check(buf, blkno, count, is_write)) return false;
+  size_t len = count * BLKSZ;
+  paddr_host_access(buf, len);
+  size_t done = blkio_transfer(buf, blkno, len, is_write);
+  if (!is_write) paddr_host_written(buf, done);
+  return done == len;
+}
+
+#ifdef CONFIG_DEVICE_ASYNC
+#include <device/async.h>
+
+static struct {
+  paddr_t buf;
+  uint64_t blkno;
+  size_t len, done;
+  bool is_write;
+} req;
+
+static void disk_work(void *arg) {
+  req.done = blkio_transfer(req.buf, req.blkno, req.len, req.is_write);
+}
+
+static void disk_done(void *arg) {
+  if (!req.is_write) paddr_host_written(req.buf, req.done);
+  disk_base[reg_status] = (req.done == req.len ? DISK_OK : DISK_ERROR);
+  void dev_raise_intr();
+  dev_raise_intr();
+}
+
+static bool disk_start(paddr_t buf, uint64_t blkno, uint64_t count, bool is_write) {
+  if (!blkio_check(buf, blkno, count, is_write)) return false;
+  req.buf = buf;
+  req.blkno = blkno;
+  req.len = count * BLKSZ;
+  req.is_write = is_write;
+  // the worker does not touch lazy pmem by itself
+  paddr_host_access(buf, req.len);
+  disk_base[reg_status] = DISK_BUSY;
+  dev_async(disk_work, disk_done, NULL);
+  return true;
+}
+#endif
+
+static void disk_io_handler(uint32_t offset, int len, bool is_write) {
+#ifdef CONFIG_DEVICE_ASYNC
+  // let the guest spinning on the status see the completion at once
+  if (!is_write && offset / sizeof(uint32_t) == reg_status) dev_async_reap();
+  if (is_write && disk_base[reg_status] == DISK_BUSY) return;
+#endif
+  if (!is_write || offset / sizeof(uint32_t) != reg_cmd) return;
+  switch (disk_base[reg_cmd]) {
+    case DISK_CMD_READ:
+    case DISK_CMD_WRITE: {
+      bool is_wr = (disk_base[reg_cmd] == DISK_CMD_WRITE);
+#ifdef CONFIG_DEVICE_ASYNC
+      if (!disk_start(disk_base[reg_buf], disk_base[reg_blkno], disk_base[reg_count], is_wr)) {
+        disk_base[reg_status] = DISK_ERROR;
+      }
+#else
+      bool ok = disk_blkio(disk_base[reg_buf], disk_base[reg_blkno], disk_base[reg_count], is_wr);
+      disk_base[reg_status] = (ok ? DISK_OK : DISK_ERROR);
+#endif
+      break;
+    }
+    default: disk_base[reg_status] = DISK_ERROR; break;
+  }
+}
+
+static void open_image() {
+  const char *path = CONFIG_DISK_IMG_PATH;
+  if (path[0] == '\0') return;
+  disk_fd = open(path, O_RDWR);
+  disk_writable = (disk_fd >= 0);
+  if (disk_fd < 0) disk_fd = open(path, O_RDONLY);
+  if (disk_fd < 0) { Log_warn("Can not open disk image '%s'", path); return; }
+
+  struct stat st;
+  int ret = fstat(disk_fd, &st);
+  assert(ret == 0);
+  disk_base[reg_present] = 1;
+  disk_base[reg_blkcnt] = st.st_size / BLKSZ;
+  Log("Disk image %s, %u blocks%s", path, disk_base[reg_blkcnt], disk_writable ? "" : ", read only");
+}
 
 void init_disk() {
+  uint32_t space_size = sizeof(uint32_t) * nr_reg;
+  disk_base = (uint32_t *)new_space(space_size);
+  disk_base[reg_blksz] = BLKSZ;
+  // the image is opened by the first access
+  io_space_set_init(disk_base, open_image);
+#ifdef CONFIG_HAS_PORT_IO
+  add_pio_map ("disk", CONFIG_DISK_CTL_PORT, disk_base, space_size, disk_io_handler);
+#else
+  add_mmio_map("disk", CONFIG_DISK_CTL_MMIO, disk_base, space_size, disk_io_handler);
+#endif
 }
@@ -0,0 +1,189 @@
+/***************************************************************************************
+* Copyright (c) 2014-2024 Zihao Yu, Nanjing University
+*
+* NEMU is licensed under Mulan PSL v2.
+* You can use this software according to the terms and conditions of the Mulan PSL v2.
+* You may obtain a copy of Mulan PSL v2 at:
+*          http://license.coscl.org.cn/MulanPSL2
+*
+* THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+* EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+* MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+*
+* See the Mulan PSL v2 for more details.
+***************************************************************************************/
+
+#include <device/event.h>
+#include <device/map.h>
+#include <utils.h>
+
+#define MAX_EVENT 32
+
+// the bounds of the countdown, so that a deadline far away does not overflow it
+#define COUNTDOWN_MIN 64
+#define COUNTDOWN_MAX (1ll << 30)
+
+typedef struct {
+  const char *name;
+  dev_event_t handler;
+  void *arg;
+  uint64_t deadline; // in instructions in virtual time, or in us in host time
+  uint64_t period; // in the same unit, 0 if it is one-shot
+  int pos; // in the heap, -1 if not pending
+} Event;
+
+static Event event[MAX_EVENT];
+static int nr_event = 0;
+static int heap[MAX_EVENT];
+static int heap_size = 0;
+
+/* The instructions run since the start, counted by the CPU loop through
+ * device_countdown, which was `armed` when it was last set. */
+int64_t device_countdown = COUNTDOWN_MIN;
+static int64_t armed = COUNTDOWN_MIN;
+static uint64_t nr_inst = 0;
+
+static inline uint64_t inst_now() {
+  return nr_inst + (armed - device_countdown);
+}
+
+#ifdef CONFIG_TIMER_VIRTUAL
+static inline uint64_t clock_now() { return inst_now(); }
+static inline uint64_t us_to_clock(uint64_t us) { return us * CONFIG_TIMER_VIRTUAL_MIPS; }
+static inline int64_t clock_to_inst(uint64_t n) { return (n < COUNTDOWN_MAX ? n : COUNTDOWN_MAX); }
+#else
+// the speed is measured over at least this long, as get_time() is in us
+#define RATE_WINDOW_US 10000
+
+static double rate = 1; // guest instructions per us
+static uint64_t rate_inst = 0, rate_us = 0;
+
+static inline uint64_t clock_now() { return get_time(); }
+static inline uint64_t us_to_clock(uint64_t us) { return us; }
+
+/* Only half of the distance to the deadline is counted down, so that an
+ * event is not late if the guest slows down. It is checked again with the
+ * rest of the distance, which takes a few more checks for each event. */
+static inline int64_t clock_to_inst(uint64_t us) {
+  double n = us * rate / 2;
+  return (n < COUNTDOWN_MIN ? COUNTDOWN_MIN : n < COUNTDOWN_MAX ? (int64_t)n : COUNTDOWN_MAX);
+}
+
+static void measure_rate(uint64_t now_us) {
+  uint64_t now = inst_now();
+  if (rate_us != 0 && now_us < rate_us + RATE_WINDOW_US) return;
+  if (rate_us != 0) {
+    double r = (double)(now - rate_inst) / (now_us - rate_us);
+    // avoid overreacting to a single sample, e.g. after stopping in sdb
+    if (r < rate / 4) r = rate / 4;
+    if (r > rate * 4) r = rate * 4;
+    rate = (r > 0.001 ? r : 0.001);
+  }
+  rate_inst = now;
+  rate_us = now_us;
+}
+#endif
+
+static inline bool before(int a, int b) {
+  return event[heap[a]].deadline < event[heap[b]].deadline;
+}
+
+static inline void heap_swap(int a, int b) {
+  int t = heap[a]; heap[a] = heap[b]; heap[b] = t;
+  event[heap[a]].pos = a;
+  event[heap[b]].pos = b;
+}
+
+static void sift_up(int i) {
+  while (i > 0 && before(i, (i - 1) / 2)) { heap_swap(i, (i - 1) / 2); i = (i - 1) / 2; }
+}
+
+static void sift_down(int i) {
+  while (true) {
+    int l = 2 * i + 1, r = l + 1, m = i;
+    if (l < heap_size && before(l, m)) m = l;
+    if (r < heap_size && before(r, m)) m = r;
+    if (m == i) return;
+    heap_swap(i, m);
+    i = m;
+  }
+}
+
+static void heap_remove(int id) {
+  int i = event[id].pos;
+  event[id].pos = -1;
+  if (-- heap_size == i) return;
+  heap[i] = heap[heap_size];
+  event[heap[i]].pos = i;
+  sift_up(i);
+  sift_down(event[heap[i]].pos);
+}
+
+// count down to the earliest deadline
+static void rearm(uint64_t now) {
+  nr_inst = inst_now();
+  int64_t n = COUNTDOWN_MAX;
+  if (heap_size > 0) {
+    uint64_t d = event[heap[0]].deadline;
+    n = clock_to_inst(d > now ? d - now : 0);
+  }
+  // a block of instructions may pass the deadline a little
+  device_countdown = armed = (n > 0 ? n : 1);
+}
+
+int dev_event_new(const char *name, dev_event_t handler, void *arg) {
+  Assert(nr_event < MAX_EVENT, "Too many events of devices");
+  event[nr_event] = (Event) { .name = name, .handler = handler, .arg = arg, .pos = -1 };
+  return nr_event ++;
+}
+
+static void event_insert(int id, uint64_t deadline) {
+  Event *e = &event[id];
+  if (e->pos != -1) heap_remove(id);
+  e->deadline = deadline;
+  heap[heap_size] = id;
+  e->pos = heap_size;
+  sift_up(heap_size ++);
+}
+
+void dev_event_schedule(int id, uint64_t delay_us) {
+  uint64_t now = clock_now();
+  event[id].period = 0;
+  event_insert(id, now + us_to_clock(delay_us));
+  rearm(now);
+}
+
+void dev_event_periodic(int id, uint64_t period_us) {
+  uint64_t now = clock_now();
+  event[id].period = us_to_clock(period_us);
+  assert(event[id].period > 0);
+  event_insert(id, now + event[id].period);
+  rearm(now);
+}
+
+void dev_event_cancel(int id) {
+  event[id].period = 0;
+  if (event[id].pos == -1) return;
+  heap_remove(id);
+  rearm(clock_now());
+}
+
+// also called while the guest is idle, when few instructions run
+void device_update() {
+  DEVICE_LOCK();
+  uint64_t now = clock_now();
+  IFNDEF(CONFIG_TIMER_VIRTUAL, measure_rate(now));
+  while (heap_size > 0 && event[heap[0]].deadline <= now) {
+    int id = heap[0];
+    Event *e = &event[id];
+    heap_remove(id);
+    // the next period is counted before the handler, which may cancel it
+    if (e->period != 0) {
+      uint64_t next = e->deadline + e->period;
+      event_insert(id, next > now ? next : now + e->period);
+    }
+    e->handler(e->arg);
+  }
+  rearm(now);
+  DEVICE_UNLOCK();
+}
@@ -14,7 +14,7 @@
 #**************************************************************************************/
 
 DIRS-y += src/device/io
-SRCS-$(CONFIG_DEVICE) += src/device/device.c src/device/alarm.c src/device/intr.c
+SRCS-$(CONFIG_DEVICE) += src/device/device.c src/device/event.c src/device/alarm.c src/device/intr.c
 SRCS-$(CONFIG_HAS_SERIAL) += src/device/serial.c
 SRCS-$(CONFIG_HAS_TIMER) += src/device/timer.c
 SRCS-$(CONFIG_HAS_KEYBOARD) += src/device/keyboard.c
@@ -22,11 +22,18 @@ SRCS-$(CONFIG_HAS_VGA) += src/device/vga.c
 SRCS-$(CONFIG_HAS_AUDIO) += src/device/audio.c
 SRCS-$(CONFIG_HAS_DISK) += src/device/disk.c
 SRCS-$(CONFIG_HAS_SDCARD) += src/device/sdcard.c
+SRCS-$(CONFIG_HAS_PVIO) += src/device/pvio.c
+SRCS-$(CONFIG_HAS_NET) += src/device/net.c
+SRCS-$(CONFIG_HAS_HART_CTL) += src/device/hartctl.c
+SRCS-$(CONFIG_INPUT_LOG) += src/device/input-log.c
+SRCS-$(CONFIG_DEVICE_ASYNC) += src/device/async.c
 
 SRCS-BLACKLIST-$(CONFIG_TARGET_AM) += src/device/alarm.c
 
 ifdef CONFIG_DEVICE
 ifndef CONFIG_TARGET_AM
 LIBS += $(shell sdl2-config --libs)
+LIBS += $(if $(CONFIG_VGA_THREAD)$(CONFIG_DEVICE_ASYNC),-lpthread,)
+LIBS += $(if $(CONFIG_INPUT_LOG),-lz,)
 endif
 endif
@@ -0,0 +1,49 @@
+/***************************************************************************************
+* Copyright (c) 2014-2024 Zihao Yu, Nanjing University
+*
+* NEMU is licensed under Mulan PSL v2.
+* You can use this software according to the terms and conditions of the Mulan PSL v2.
+* You may obtain a copy of Mulan PSL v2 at:
+*          http://license.coscl.org.cn/MulanPSL2
+*
+* THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+* EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+* MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+*
+* See the Mulan PSL v2 for more details.
+***************************************************************************************/
+
+#include <device/map.h>
+#include <cpu/hart.h>
+
+/* Tell the guest the number of harts and the running one, and start the
+ * harts parked at reset. The guest writes the pc and the stack pointer to
+ * start from into reg_entry and reg_stack, and then the id of a parked hart
+ * into reg_start. Without CONFIG_MULTI_HART, there is a single hart. */
+enum { reg_nr, reg_id, reg_entry, reg_stack, reg_start, nr_reg };
+
+static uint32_t *hartctl_base = NULL;
+
+static void hartctl_io_handler(uint32_t offset, int len, bool is_write) {
+  switch (offset / sizeof(uint32_t)) {
+    case reg_id:
+      if (!is_write) hartctl_base[reg_id] = MUXDEF(CONFIG_MULTI_HART, hart_current(), 0);
+      break;
+    case reg_start:
+#ifdef CONFIG_MULTI_HART
+      if (is_write) hart_start(hartctl_base[reg_start], hartctl_base[reg_entry], hartctl_base[reg_stack]);
+#endif
+      break;
+  }
+}
+
+void init_hartctl() {
+  uint32_t space_size = sizeof(uint32_t) * nr_reg;
+  hartctl_base = (uint32_t *)new_space(space_size);
+  hartctl_base[reg_nr] = MUXDEF(CONFIG_MULTI_HART, CONFIG_NR_HART, 1);
+#ifdef CONFIG_HAS_PORT_IO
+  add_pio_map ("hartctl", CONFIG_HART_CTL_PORT, hartctl_base, space_size, hartctl_io_handler);
+#else
+  add_mmio_map("hartctl", CONFIG_HART_CTL_MMIO, hartctl_base, space_size, hartctl_io_handler);
+#endif
+}
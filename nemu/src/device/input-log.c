@@ -0,0 +1,117 @@
+/***************************************************************************************
+* Copyright (c) 2014-2024 Zihao Yu, Nanjing University
+*
+* NEMU is licensed under Mulan PSL v2.
+* You can use this software according to the terms and conditions of the Mulan PSL v2.
+* You may obtain a copy of Mulan PSL v2 at:
+*          http://license.coscl.org.cn/MulanPSL2
+*
+* THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+* EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+* MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+*
+* See the Mulan PSL v2 for more details.
+***************************************************************************************/
+
+#include <common.h>
+#include <device/replay.h>
+#include <zlib.h>
+
+/* The log is compressed by zlib, and has an entry for each input
+ *
+ *   uint64_t icount;  // with INTR_FLAG for an interrupt
+ *   uint64_t value;   // 0 for an interrupt
+ *
+ * in the order they come. The counts are those of `g_nr_guest_inst`, which
+ * the block and JIT engines only update after each block, so a log is
+ * replayed with the engine recording it.
+ */
+#define INPUT_MAGIC "NEMUINPT"
+#define INTR_FLAG ((uint64_t)1 << 63)
+
+typedef struct {
+  uint64_t icount;
+  uint64_t value;
+} Entry;
+
+extern uint64_t g_nr_guest_inst;
+void dev_raise_intr();
+
+bool input_replaying = false;
+static bool is_record = false;
+static gzFile log_gz = NULL;
+static Entry next;
+static uint64_t nr_entry = 0;
+
+static void input_log_close() {
+  if (log_gz == NULL) return;
+  if (input_replaying) Log("NEMU exits before the input logged at %" PRIu64 " instructions", next.icount & ~INTR_FLAG);
+  gzclose(log_gz);
+  log_gz = NULL;
+  Log("Input log: %" PRIu64 " entries %s", nr_entry, (is_record ? "recorded" : "replayed"));
+}
+
+static void read_next() {
+  if (gzread(log_gz, &next, sizeof(next)) == sizeof(next)) return;
+  input_replaying = false;
+  Log("The input log ends at %" PRIu64 " instructions, inputs come from the host from now on", g_nr_guest_inst);
+}
+
+bool input_log_open(const char *file, bool replay) {
+  char magic[8];
+  log_gz = gzopen(file, replay ? "rb" : "wb1");
+  if (log_gz == NULL) return false;
+  gzbuffer(log_gz, 1 << 20);
+  if (replay) {
+    Assert(gzread(log_gz, magic, sizeof(magic)) == sizeof(magic) &&
+        memcmp(magic, INPUT_MAGIC, sizeof(magic)) == 0, "'%s' is not an input log", file);
+    input_replaying = true;
+    read_next();
+  } else {
+    gzwrite(log_gz, INPUT_MAGIC, sizeof(magic));
+    is_record = true;
+  }
+  atexit(input_log_close);
+  return true;
+}
+
+static void record(uint64_t icount, uint64_t value) {
+  if (!is_record) return;
+  Entry e = { .icount = icount, .value = value };
+  gzwrite(log_gz, &e, sizeof(e));
+  nr_entry ++;
+}
+
+uint64_t input_log_value(uint64_t value) {
+  record(g_nr_guest_inst, value);
+  return value;
+}
+
+void input_log_intr() { record(g_nr_guest_inst | INTR_FLAG, 0); }
+
+static void diverge() {
+  panic("Replaying diverges at %" PRIu64 " instructions, where the next input logged comes at %" PRIu64 "%s",
+      g_nr_guest_inst, next.icount & ~INTR_FLAG, (next.icount & INTR_FLAG ? " as an interrupt" : ""));
+}
+
+uint64_t input_log_next() {
+  if (next.icount != g_nr_guest_inst) diverge();
+  uint64_t value = next.value;
+  nr_entry ++;
+  read_next();
+  return value;
+}
+
+/* Raise the interrupts due, and cut the run of `n` instructions at the
+ * next one. */
+uint64_t input_log_limit(uint64_t n) {
+  while (input_replaying && (next.icount & INTR_FLAG)) {
+    uint64_t icount = next.icount & ~INTR_FLAG;
+    if (icount > g_nr_guest_inst) return (icount - g_nr_guest_inst < n ? icount - g_nr_guest_inst : n);
+    if (icount < g_nr_guest_inst) diverge();
+    dev_raise_intr();
+    nr_entry ++;
+    read_next();
+  }
+  return n;
+}
@@ -15,5 +15,10 @@
 
 #include <isa.h>
 
+/* Interrupt sources may run in another thread, so they only set this word,
+ * and the execution loop tests it with a single load. */
+uint32_t intr_pending = 0;
+
 void dev_raise_intr() {
+  __atomic_fetch_or(&intr_pending, INTR_DEV, __ATOMIC_RELEASE);
 }
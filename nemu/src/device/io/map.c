@@ -18,20 +18,130 @@
 #include <memory/vaddr.h>
 #include <device/map.h>
 
+#ifdef CONFIG_LIVE
+#include <live-def.h>
+extern LiveCounters *live;
+#define LIVE_ACCESS(map, rw) LIVE_ADD(live->dev[(map)->live_id].rw, 1)
+#else
+#define LIVE_ACCESS(map, rw)
+#endif
+
+#ifdef CONFIG_HART_THREAD
+pthread_mutex_t device_lock = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+#ifdef CONFIG_INST_COST
+// the maps accessed so far, in the order of their first accesses
+static IOMap *cost_map[64];
+static int nr_cost_map = 0;
+
+static void map_cost(IOMap *map, uint64_t t) {
+  if (map->nr_access ++ == 0 && nr_cost_map < ARRLEN(cost_map)) cost_map[nr_cost_map ++] = map;
+  map->cost += cost_clock() - t;
+}
+
+void map_cost_report() {
+  if (nr_cost_map == 0) return;
+  Log("host cost of devices:");
+  int i;
+  for (i = 0; i < nr_cost_map; i ++) {
+    IOMap *map = cost_map[i];
+    Log("  %-10s %14" PRIu64 " accesses, %" PRIu64 " " COST_UNIT ", %.1f each", map->name,
+        map->nr_access, map->cost, (double)map->cost / map->nr_access);
+  }
+}
+#define COST_START() uint64_t __t = cost_clock()
+#define COST_END(map) map_cost(map, __t)
+#else
+#define COST_START()
+#define COST_END(map)
+#endif
+
+#ifndef CONFIG_TARGET_AM
+#include <sys/mman.h>
+/* The space is only reserved, and the pages of each device are opened when
+ * allocated, so that only those touched are committed. A closed page is
+ * left after each one as a guard, catching overruns of device buffers. */
+#define IO_SPACE_MAX (256 * 1024 * 1024)
+#define GUARD_SIZE PAGE_SIZE
+#else
 #define IO_SPACE_MAX (32 * 1024 * 1024)
+#define GUARD_SIZE 0
+#endif
+#define NR_SPACE 32
 
 static uint8_t *io_space = NULL;
 static uint8_t *p_space = NULL;
+static struct {
+  uint8_t *base;
+  size_t size;
+  io_init_t init;
+} space[NR_SPACE];
+static int nr_space = 0;
 
-uint8_t* new_space(int size) {
-  uint8_t *p = p_space;
-  // page aligned;
+// `align` should be a power of 2, and the space is at least page aligned
+uint8_t* new_space_aligned(int size, int align) {
+  if (align < PAGE_SIZE) align = PAGE_SIZE;
+  assert((align & (align - 1)) == 0);
+  uint8_t *p = io_space + ((p_space - io_space + align - 1) & ~(uintptr_t)(align - 1));
   size = (size + (PAGE_SIZE - 1)) & ~PAGE_MASK;
-  p_space += size;
-  assert(p_space - io_space < IO_SPACE_MAX);
+  Assert(p + size + GUARD_SIZE <= io_space + IO_SPACE_MAX && nr_space < NR_SPACE,
+      "IO space is used up by a space of %d bytes", size);
+#ifndef CONFIG_TARGET_AM
+  int ret = mprotect(p, size, PROT_READ | PROT_WRITE);
+  Assert(ret == 0, "Can not open IO space of %d bytes", size);
+#endif
+  FOOTPRINT("io space", p, size);
+  space[nr_space].base = p;
+  space[nr_space].size = size;
+  nr_space ++;
+  p_space = p + size + GUARD_SIZE;
   return p;
 }
 
+uint8_t* new_space(int size) {
+  return new_space_aligned(size, PAGE_SIZE);
+}
+
+// the registers and buffers of the i-th device, which are saved by snapshots
+uint8_t* io_space_get(int i, size_t *size) {
+  if (i >= nr_space) return NULL;
+  *size = space[i].size;
+  return space[i].base;
+}
+
+static int space_index(void *base) {
+  int i;
+  for (i = 0; i < nr_space; i ++) {
+    if (space[i].base == base) return i;
+  }
+  return -1;
+}
+
+void io_space_set_init(void *base, io_init_t init) {
+  int i = space_index(base);
+  assert(i != -1);
+  space[i].init = init;
+}
+
+io_init_t io_space_get_init(void *base) {
+  int i = space_index(base);
+  return (i == -1 ? NULL : space[i].init);
+}
+
+void io_space_init(void *base) {
+  int i = space_index(base);
+  if (i == -1 || space[i].init == NULL) return;
+  io_init_t init = space[i].init;
+  space[i].init = NULL;
+  init();
+}
+
+static void map_init(IOMap *map) {
+  map->init = NULL;
+  io_space_init(map->space);
+}
+
 static void check_bound(IOMap *map, paddr_t addr) {
   if (map == NULL) {
     Assert(map != NULL, "address (" FMT_PADDR ") is out of bound at pc = " FMT_WORD, addr, cpu.pc);
@@ -43,28 +153,45 @@ static void check_bound(IOMap *map, paddr_t addr) {
 }
 
 static void invoke_callback(io_callback_t c, paddr_t offset, int len, bool is_write) {
-  if (c != NULL) { c(offset, len, is_write); }
+  if (c != NULL) { STATS_TIME(STATS_DEVICE, c(offset, len, is_write)); }
 }
 
 void init_map() {
+#ifndef CONFIG_TARGET_AM
+  io_space = mmap(NULL, IO_SPACE_MAX, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+  Assert(io_space != MAP_FAILED, "Can not reserve IO space");
+#else
   io_space = malloc(IO_SPACE_MAX);
   assert(io_space);
+#endif
   p_space = io_space;
 }
 
 word_t map_read(paddr_t addr, int len, IOMap *map) {
   assert(len >= 1 && len <= 8);
   check_bound(map, addr);
+  DEVICE_LOCK();
+  if (unlikely(map->init != NULL)) map_init(map);
   paddr_t offset = addr - map->low;
+  COST_START();
   invoke_callback(map->callback, offset, len, false); // prepare data to read
+  LIVE_ACCESS(map, read);
   word_t ret = host_read(map->space + offset, len);
+  COST_END(map);
+  DEVICE_UNLOCK();
   return ret;
 }
 
 void map_write(paddr_t addr, int len, word_t data, IOMap *map) {
   assert(len >= 1 && len <= 8);
   check_bound(map, addr);
+  DEVICE_LOCK();
+  if (unlikely(map->init != NULL)) map_init(map);
   paddr_t offset = addr - map->low;
+  COST_START();
   host_write(map->space + offset, len, data);
   invoke_callback(map->callback, offset, len, true);
+  LIVE_ACCESS(map, write);
+  COST_END(map);
+  DEVICE_UNLOCK();
 }
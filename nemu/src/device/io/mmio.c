@@ -14,16 +14,37 @@
 ***************************************************************************************/
 
 #include <device/map.h>
+#include <device/mmio.h>
 #include <memory/paddr.h>
+#include <memory/vaddr.h>
 
-#define NR_MAP 16
-
-static IOMap maps[NR_MAP] = {};
+// sorted by the start address, and never overlapped
+static IOMap **maps = NULL;
 static int nr_map = 0;
 
-static IOMap* fetch_mmio_map(paddr_t addr) {
-  int mapid = find_mapid_by_addr(maps, nr_map, addr);
-  return (mapid == -1 ? NULL : &maps[mapid]);
+static IOMap* find_mmio_map(paddr_t addr) {
+  static HART_LOCAL IOMap *last = NULL;
+  if (last != NULL && map_inside(last, addr)) return last;
+  // find the last map starting at or below `addr`
+  int l = 0, r = nr_map;
+  while (l < r) {
+    int mid = (l + r) / 2;
+    if (maps[mid]->low <= addr) l = mid + 1;
+    else r = mid;
+  }
+  if (l == 0 || !map_inside(maps[l - 1], addr)) return NULL;
+  last = maps[l - 1];
+  return last;
+}
+
+IOMap* fetch_mmio_map(paddr_t addr) {
+  IOMap *map = find_mmio_map(addr);
+  if (map != NULL) difftest_skip_ref();
+  return map;
+}
+
+bool mmio_map_exists(paddr_t addr) {
+  return find_mmio_map(addr) != NULL;
 }
 
 static void report_mmio_overlap(const char *name1, paddr_t l1, paddr_t r1,
@@ -32,25 +53,51 @@ static void report_mmio_overlap(const char *name1, paddr_t l1, paddr_t r1,
                "with %s@[" FMT_PADDR ", " FMT_PADDR "]", name1, l1, r1, name2, l2, r2);
 }
 
+// update the entry of `page` in the region table of paddr
+static void update_region(paddr_t page) {
+  paddr_t last = page + PAGE_SIZE - 1;
+  IOMap *map = NULL;
+  int i, n = 0;
+  for (i = 0; i < nr_map; i ++) {
+    if (maps[i]->low <= last && maps[i]->high >= page) { map = maps[i]; n ++; }
+  }
+  if (n != 1) { paddr_set_region(page, NULL, NULL); return; }
+  bool cover = (map->low <= page && map->high >= last);
+  uint8_t *host = (cover && map->callback == NULL && map->init == NULL ? (uint8_t *)map->space + (page - map->low) : NULL);
+  paddr_set_region(page, host, map);
+}
+
 /* device interface */
 void add_mmio_map(const char *name, paddr_t addr, void *space, uint32_t len, io_callback_t callback) {
-  assert(nr_map < NR_MAP);
   paddr_t left = addr, right = addr + len - 1;
   if (in_pmem(left) || in_pmem(right)) {
     report_mmio_overlap(name, left, right, "pmem", PMEM_LEFT, PMEM_RIGHT);
   }
   for (int i = 0; i < nr_map; i++) {
-    if (left <= maps[i].high && right >= maps[i].low) {
-      report_mmio_overlap(name, left, right, maps[i].name, maps[i].low, maps[i].high);
+    if (left <= maps[i]->high && right >= maps[i]->low) {
+      report_mmio_overlap(name, left, right, maps[i]->name, maps[i]->low, maps[i]->high);
     }
   }
 
-  maps[nr_map] = (IOMap){ .name = name, .low = addr, .high = addr + len - 1,
-    .space = space, .callback = callback };
-  Log("Add mmio map '%s' at [" FMT_PADDR ", " FMT_PADDR "]",
-      maps[nr_map].name, maps[nr_map].low, maps[nr_map].high);
-
+  // maps are referred to by the region table, so they are never moved
+  IOMap *map = malloc(sizeof(IOMap));
+  assert(map);
+  *map = (IOMap){ .name = name, .low = addr, .high = addr + len - 1,
+    .space = space, .callback = callback, .init = io_space_get_init(space) };
+  IFDEF(CONFIG_LIVE, int live_device(const char *name); map->live_id = live_device(name));
+  maps = realloc(maps, sizeof(IOMap *) * (nr_map + 1));
+  assert(maps);
+  int i;
+  for (i = nr_map; i > 0 && maps[i - 1]->low > map->low; i --) maps[i] = maps[i - 1];
+  maps[i] = map;
   nr_map ++;
+  Log("Add mmio map '%s' at [" FMT_PADDR ", " FMT_PADDR "]", map->name, map->low, map->high);
+
+  paddr_t page;
+  for (page = left & ~PAGE_MASK; ; page += PAGE_SIZE) {
+    update_region(page);
+    if (page == (right & ~PAGE_MASK)) break;
+  }
 }
 
 /* bus interface */
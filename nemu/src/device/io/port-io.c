@@ -13,37 +13,51 @@
 * See the Mulan PSL v2 for more details.
 ***************************************************************************************/
 
+#include <isa.h>
 #include <device/map.h>
 
-#define PORT_IO_SPACE_MAX 65535
+#define PORT_IO_SPACE_MAX 65536
 
 #define NR_MAP 16
 static IOMap maps[NR_MAP] = {};
 static int nr_map = 0;
+/* the map of each port, NULL if the port is not mapped. It is indexed by
+ * ioaddr_t directly, which covers the whole port space, so an access only
+ * checks that the port is mapped and that it does not run past the map. */
+static IOMap *port_map[PORT_IO_SPACE_MAX] = {};
 
 /* device interface */
 void add_pio_map(const char *name, ioaddr_t addr, void *space, uint32_t len, io_callback_t callback) {
   assert(nr_map < NR_MAP);
   assert(addr + len <= PORT_IO_SPACE_MAX);
   maps[nr_map] = (IOMap){ .name = name, .low = addr, .high = addr + len - 1,
-    .space = space, .callback = callback };
+    .space = space, .callback = callback, .init = io_space_get_init(space) };
+  IFDEF(CONFIG_LIVE, int live_device(const char *name); maps[nr_map].live_id = live_device(name));
   Log("Add port-io map '%s' at [" FMT_PADDR ", " FMT_PADDR "]",
       maps[nr_map].name, maps[nr_map].low, maps[nr_map].high);
+  int i;
+  for (i = 0; i < len; i ++) {
+    assert(port_map[addr + i] == NULL);
+    port_map[addr + i] = &maps[nr_map];
+  }
 
   nr_map ++;
 }
 
 /* CPU interface */
+static IOMap* fetch_pio_map(ioaddr_t addr, int len) {
+  IOMap *map = port_map[addr];
+  if (unlikely(map == NULL || addr + len - 1 > map->high)) {
+    panic("port [0x%04x, 0x%04x] is not mapped at pc = " FMT_WORD, addr, addr + len - 1, cpu.pc);
+  }
+  difftest_skip_ref();
+  return map;
+}
+
 uint32_t pio_read(ioaddr_t addr, int len) {
-  assert(addr + len - 1 < PORT_IO_SPACE_MAX);
-  int mapid = find_mapid_by_addr(maps, nr_map, addr);
-  assert(mapid != -1);
-  return map_read(addr, len, &maps[mapid]);
+  return map_read(addr, len, fetch_pio_map(addr, len));
 }
 
 void pio_write(ioaddr_t addr, int len, uint32_t data) {
-  assert(addr + len - 1 < PORT_IO_SPACE_MAX);
-  int mapid = find_mapid_by_addr(maps, nr_map, addr);
-  assert(mapid != -1);
-  map_write(addr, len, data, &maps[mapid]);
+  map_write(addr, len, data, fetch_pio_map(addr, len));
 }
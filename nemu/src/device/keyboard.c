@@ -14,6 +14,7 @@
 ***************************************************************************************/
 
 #include <device/map.h>
+#include <device/replay.h>
 #include <utils.h>
 
 #define KEYDOWN_MASK 0x8000
@@ -45,31 +46,91 @@ static void init_keymap() {
   MAP(NEMU_KEYS, SDL_KEYMAP)
 }
 
-#define KEY_QUEUE_LEN 1024
-static int key_queue[KEY_QUEUE_LEN] = {};
-static int key_f = 0, key_r = 0;
-
-static void key_enqueue(uint32_t am_scancode) {
-  key_queue[key_r] = am_scancode;
-  key_r = (key_r + 1) % KEY_QUEUE_LEN;
-  Assert(key_r != key_f, "key queue overflow!");
+/* A single-producer single-consumer queue of AM scancodes. The producer
+ * only writes `key_tail` and the consumer only writes `key_head`, so
+ * events may be sent from another thread than the guest reading them.
+ *
+ * The queue does not abort the simulation when it is full. A key press
+ * which does not fit is dropped, and so is its release. A release which
+ * does not fit is kept pending and sent before any later event, so the
+ * guest never sees a key stuck in the pressed state. */
+#define KEY_QUEUE_LEN 1024 // should be a power of 2
+static uint32_t key_queue[KEY_QUEUE_LEN] = {};
+static uint32_t key_head = 0, key_tail = 0;
+
+// the following are only used by the producer
+static bool key_down[256] = {};    // the state seen by the guest after the queue is consumed
+static bool key_pending[256] = {}; // a release is not queued yet
+static int nr_key_pending = 0;
+static uint64_t nr_key_dropped = 0;
+
+static bool key_enqueue(uint32_t am_scancode) {
+  uint32_t t = key_tail;
+  if (t - __atomic_load_n(&key_head, __ATOMIC_ACQUIRE) == KEY_QUEUE_LEN) return false;
+  key_queue[t % KEY_QUEUE_LEN] = am_scancode;
+  __atomic_store_n(&key_tail, t + 1, __ATOMIC_RELEASE);
+  return true;
 }
 
 static uint32_t key_dequeue() {
-  uint32_t key = NEMU_KEY_NONE;
-  if (key_f != key_r) {
-    key = key_queue[key_f];
-    key_f = (key_f + 1) % KEY_QUEUE_LEN;
-  }
+  uint32_t h = key_head;
+  if (h == __atomic_load_n(&key_tail, __ATOMIC_ACQUIRE)) return NEMU_KEY_NONE;
+  uint32_t key = key_queue[h % KEY_QUEUE_LEN];
+  __atomic_store_n(&key_head, h + 1, __ATOMIC_RELEASE);
   return key;
 }
 
+static void key_overflow() {
+  if (nr_key_dropped ++ == 0) Log("key queue overflow, events are dropped");
+}
+
+// try to queue the pending releases, return false if some are still pending
+static bool key_flush_pending() {
+  int i;
+  for (i = 0; i < 256 && nr_key_pending > 0; i ++) {
+    if (!key_pending[i]) continue;
+    if (!key_enqueue(keymap[i])) return false;
+    key_pending[i] = false;
+    nr_key_pending --;
+  }
+  return true;
+}
+
+void keyboard_poll() {
+  if (nr_key_pending > 0) key_flush_pending();
+}
+
 void send_key(uint8_t scancode, bool is_keydown) {
-  if (nemu_state.state == NEMU_RUNNING && keymap[scancode] != NEMU_KEY_NONE) {
-    uint32_t am_scancode = keymap[scancode] | (is_keydown ? KEYDOWN_MASK : 0);
-    key_enqueue(am_scancode);
+  if (nemu_state.state != NEMU_RUNNING || keymap[scancode] == NEMU_KEY_NONE) return;
+  bool flushed = (nr_key_pending == 0 || key_flush_pending());
+  uint32_t am_scancode = keymap[scancode] | (is_keydown ? KEYDOWN_MASK : 0);
+  if (is_keydown) {
+    if (flushed && key_enqueue(am_scancode)) key_down[scancode] = true;
+    else key_overflow();
+  } else if (key_down[scancode]) {
+    key_down[scancode] = false;
+    if (!flushed || !key_enqueue(am_scancode)) {
+      key_pending[scancode] = true;
+      nr_key_pending ++;
+      key_overflow();
+    }
   }
 }
+
+#ifdef CONFIG_SNAPSHOT
+#include <device/snapshot.h>
+
+// the keys queued are inputs, which are replayed by reverse execution
+static void keyboard_snapshot(Snapshot *s) {
+  if (snapshot_is_replay(s)) return;
+  SNAPSHOT_VAR(s, key_queue);
+  SNAPSHOT_VAR(s, key_head);
+  SNAPSHOT_VAR(s, key_tail);
+  SNAPSHOT_VAR(s, key_down);
+  SNAPSHOT_VAR(s, key_pending);
+  SNAPSHOT_VAR(s, nr_key_pending);
+}
+#endif
 #else // !CONFIG_TARGET_AM
 #define NEMU_KEY_NONE 0
 
@@ -82,10 +143,24 @@ static uint32_t key_dequeue() {
 
 static uint32_t *i8042_data_port_base = NULL;
 
+// the next key seen by the guest, also read through pvio
+uint32_t keyboard_read() {
+#if defined(CONFIG_VGA_SHOW_SCREEN) && !defined(CONFIG_TARGET_AM)
+  void vga_open_window();
+  vga_open_window();
+#endif
+  uint32_t key = DEVICE_INPUT(key_dequeue());
+#ifdef CONFIG_IDLE_SLEEP
+  void device_idle_poll();
+  if (key == NEMU_KEY_NONE) device_idle_poll();
+#endif
+  return key;
+}
+
 static void i8042_data_io_handler(uint32_t offset, int len, bool is_write) {
   assert(!is_write);
   assert(offset == 0);
-  i8042_data_port_base[0] = key_dequeue();
+  i8042_data_port_base[0] = keyboard_read();
 }
 
 void init_i8042() {
@@ -97,4 +172,5 @@ void init_i8042() {
   add_mmio_map("keyboard", CONFIG_I8042_DATA_MMIO, i8042_data_port_base, 4, i8042_data_io_handler);
 #endif
   IFNDEF(CONFIG_TARGET_AM, init_keymap());
+  IFDEF(CONFIG_SNAPSHOT, snapshot_register("keyboard", keyboard_snapshot));
 }
@@ -0,0 +1,200 @@
+/***************************************************************************************
+* Copyright (c) 2014-2024 Zihao Yu, Nanjing University
+*
+* NEMU is licensed under Mulan PSL v2.
+* You can use this software according to the terms and conditions of the Mulan PSL v2.
+* You may obtain a copy of Mulan PSL v2 at:
+*          http://license.coscl.org.cn/MulanPSL2
+*
+* THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+* EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+* MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+*
+* See the Mulan PSL v2 for more details.
+***************************************************************************************/
+
+#include <device/map.h>
+#include <memory/paddr.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <linux/if.h>
+#include <linux/if_tun.h>
+
+/* A network card moving frames between the host and descriptor rings in
+ * pmem. The guest programs the guest physical address and the number of
+ * entries (a power of 2) of each ring, fills descriptors after the last one
+ * submitted, and writes the doorbell of the ring with the free-running index
+ * past the last descriptor. Descriptors are consumed before the write
+ * returns, and each frame is copied once, by a single send() or recv()
+ * between the host and the buffer in pmem.
+ *
+ * A TX descriptor sends the frame in its buffer. An RX descriptor lends a
+ * buffer to receive a pending frame, and its length is set to the size of
+ * the frame. Buffers are not kept by the device, the ones left when no frame
+ * is pending get a length of 0. Reading reg_rx_pending tells the size of the
+ * next pending frame.
+ *
+ * The backend is "tap:NAME" for a TAP interface, or "unix:PATH" for a UNIX
+ * datagram socket bound at PATH, where frames are sent to the last peer
+ * which has sent one to it.
+ */
+enum {
+  reg_present,
+  reg_rx_pending,
+  reg_tx_ring,
+  reg_tx_size,
+  reg_tx_doorbell,
+  reg_rx_ring,
+  reg_rx_size,
+  reg_rx_doorbell,
+  nr_reg
+};
+
+enum { NET_OK = 0, NET_ERROR = 1 };
+
+typedef struct {
+  uint32_t addr;
+  uint32_t len;
+  uint32_t status;
+  uint32_t pad;
+} NetDesc;
+
+typedef struct {
+  uint32_t head;
+  int reg_ring, reg_size, reg_doorbell;
+} NetRing;
+
+static uint32_t *net_base = NULL;
+static int net_fd = -1;
+static bool net_is_tap = false;
+static struct sockaddr_un peer = {};
+static socklen_t peer_len = 0;
+static NetRing tx = { .reg_ring = reg_tx_ring, .reg_size = reg_tx_size, .reg_doorbell = reg_tx_doorbell };
+static NetRing rx = { .reg_ring = reg_rx_ring, .reg_size = reg_rx_size, .reg_doorbell = reg_rx_doorbell };
+
+static void *guest_range(paddr_t addr, uint64_t len) {
+  if (len == 0) return NULL;
+  if (!in_pmem(addr) || !in_pmem(addr + len - 1) || addr + len - 1 < addr) return NULL;
+  paddr_host_access(addr, len);
+  return guest_to_host(addr);
+}
+
+static bool net_send(NetDesc *d) {
+  void *buf = guest_range(d->addr, d->len);
+  if (buf == NULL) return false;
+  ssize_t n;
+  if (net_is_tap) n = write(net_fd, buf, d->len);
+  else if (peer_len == 0) return true; // no one to receive it, as if the frame is lost
+  else n = sendto(net_fd, buf, d->len, 0, (struct sockaddr *)&peer, peer_len);
+  return n == d->len;
+}
+
+// return false if no frame is pending
+static bool net_recv(NetDesc *d) {
+  void *buf = guest_range(d->addr, d->len);
+  if (buf == NULL) { d->len = 0; return true; }
+  ssize_t n;
+  if (net_is_tap) n = read(net_fd, buf, d->len);
+  else {
+    struct sockaddr_un from;
+    socklen_t from_len = sizeof(from);
+    n = recvfrom(net_fd, buf, d->len, MSG_DONTWAIT, (struct sockaddr *)&from, &from_len);
+    if (n >= 0 && from_len > sizeof(sa_family_t)) { peer = from; peer_len = from_len; }
+  }
+  if (n < 0) return false;
+  d->len = n;
+  paddr_host_written(d->addr, n);
+  return true;
+}
+
+static void net_doorbell(NetRing *r, bool is_tx) {
+  uint32_t size = net_base[r->reg_size];
+  NetDesc *ring = guest_range(net_base[r->reg_ring], (uint64_t)size * sizeof(NetDesc));
+  if (ring == NULL || (size & (size - 1)) != 0) return;
+  uint32_t tail = net_base[r->reg_doorbell];
+  // descriptors beyond one lap are not submitted yet
+  if (tail - r->head > size) tail = r->head + size;
+  bool pending = true;
+  for (; r->head != tail; r->head ++) {
+    NetDesc *d = &ring[r->head & (size - 1)];
+    if (is_tx) d->status = (net_fd >= 0 && net_send(d) ? NET_OK : NET_ERROR);
+    else {
+      if (pending) pending = (net_fd >= 0 && net_recv(d));
+      if (!pending) d->len = 0;
+      d->status = NET_OK;
+    }
+  }
+  paddr_host_written(net_base[r->reg_ring], size * sizeof(NetDesc));
+}
+
+static uint32_t net_pending() {
+  int n = 0;
+  if (net_fd < 0 || ioctl(net_fd, FIONREAD, &n) != 0) return 0;
+  return n;
+}
+
+static void net_io_handler(uint32_t offset, int len, bool is_write) {
+  int reg = offset / sizeof(uint32_t);
+  if (!is_write) {
+    if (reg == reg_rx_pending) net_base[reg_rx_pending] = net_pending();
+    return;
+  }
+  switch (reg) {
+    case reg_tx_ring: case reg_tx_size: tx.head = 0; break;
+    case reg_rx_ring: case reg_rx_size: rx.head = 0; break;
+    case reg_tx_doorbell: net_doorbell(&tx, true); break;
+    case reg_rx_doorbell: net_doorbell(&rx, false); break;
+  }
+}
+
+static int open_tap(const char *name) {
+  int fd = open("/dev/net/tun", O_RDWR | O_NONBLOCK);
+  if (fd < 0) return -1;
+  struct ifreq ifr = {};
+  ifr.ifr_flags = IFF_TAP | IFF_NO_PI;
+  strncpy(ifr.ifr_name, name, IFNAMSIZ - 1);
+  if (ioctl(fd, TUNSETIFF, &ifr) != 0) { close(fd); return -1; }
+  return fd;
+}
+
+static int open_unix(const char *path) {
+  int fd = socket(AF_UNIX, SOCK_DGRAM, 0);
+  if (fd < 0) return -1;
+  struct sockaddr_un addr = { .sun_family = AF_UNIX };
+  strncpy(addr.sun_path, path, sizeof(addr.sun_path) - 1);
+  unlink(path);
+  if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) { close(fd); return -1; }
+  return fd;
+}
+
+static void open_backend() {
+  const char *backend = CONFIG_NET_BACKEND;
+  if (backend[0] == '\0') return;
+  if (strncmp(backend, "tap:", 4) == 0) {
+    net_is_tap = true;
+    net_fd = open_tap(backend + 4);
+  } else if (strncmp(backend, "unix:", 5) == 0) {
+    net_fd = open_unix(backend + 5);
+  } else {
+    Log_warn("Unknown network backend '%s'", backend);
+    return;
+  }
+  if (net_fd < 0) { Log_warn("Can not open network backend '%s'", backend); return; }
+  net_base[reg_present] = 1;
+  Log("Network backend %s", backend);
+}
+
+void init_net() {
+  uint32_t space_size = sizeof(uint32_t) * nr_reg;
+  net_base = (uint32_t *)new_space(space_size);
+  // the backend is opened by the first access
+  io_space_set_init(net_base, open_backend);
+#ifdef CONFIG_HAS_PORT_IO
+  add_pio_map ("net", CONFIG_NET_CTL_PORT, net_base, space_size, net_io_handler);
+#else
+  add_mmio_map("net", CONFIG_NET_CTL_MMIO, net_base, space_size, net_io_handler);
+#endif
+}
@@ -0,0 +1,189 @@
+/***************************************************************************************
+* Copyright (c) 2014-2024 Zihao Yu, Nanjing University
+*
+* NEMU is licensed under Mulan PSL v2.
+* You can use this software according to the terms and conditions of the Mulan PSL v2.
+* You may obtain a copy of Mulan PSL v2 at:
+*          http://license.coscl.org.cn/MulanPSL2
+*
+* THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+* EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+* MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+*
+* See the Mulan PSL v2 for more details.
+***************************************************************************************/
+
+
+#include <device/map.h>
+#include <memory/paddr.h>
+
+/* A paravirtual device taking batches of requests through a ring in pmem.
+ * The guest programs the guest physical address and the number of entries
+ * (a power of 2) of the ring, fills the entries after the last one
+ * submitted, and writes the doorbell register with the free-running index
+ * past the last entry. All entries up to it are processed natively before
+ * the write returns, so one MMIO exit covers the whole batch. The status of
+ * each entry is written back, and reg_head tells how many entries have been
+ * consumed since the ring was set up.
+ */
+enum {
+  reg_present,
+  reg_ring,
+  reg_size,
+  reg_doorbell,
+  reg_head,
+  nr_reg
+};
+
+enum {
+  PVIO_OP_NOP,
+  PVIO_OP_FBDRAW,      // x, y, pixels, w, h, sync
+  PVIO_OP_DISK_READ,   // buf, blkno, count
+  PVIO_OP_DISK_WRITE,  // buf, blkno, count
+  PVIO_OP_AUDIO_PLAY,  // buf, len; arg[1] is set to the bytes accepted
+  PVIO_OP_GPU_MEMCPY,  // dest in video memory, src, size
+  PVIO_OP_GPU_RENDER,  // root canvas in video memory
+  PVIO_OP_KEYBRD,      // dest of the key as read from the keyboard register
+  PVIO_OP_UPTIME,      // dest of the 64-bit uptime in us
+};
+
+// the bits of reg_present
+enum { PVIO_FEAT_PRESENT = 1, PVIO_FEAT_GPU_ACCEL = 2 };
+
+enum { PVIO_OK = 0, PVIO_ERROR = 1 };
+
+typedef struct {
+  uint32_t op;
+  uint32_t status;
+  uint32_t arg[6];
+} PvioReq;
+
+void vga_fbdraw(uint32_t x, uint32_t y, uint32_t w, uint32_t h, const uint32_t *pixels, bool sync);
+bool disk_blkio(paddr_t buf, uint64_t blkno, uint64_t count, bool is_write);
+uint32_t audio_write(const uint8_t *buf, uint32_t len);
+bool vga_gpu_memcpy(uint32_t dest, const void *src, uint32_t size);
+bool vga_gpu_render(uint32_t root);
+uint32_t keyboard_read();
+uint64_t rtc_read();
+
+static uint32_t *pvio_base = NULL;
+
+static void *guest_range(paddr_t addr, uint64_t len) {
+  if (len == 0) return NULL;
+  if (!in_pmem(addr) || !in_pmem(addr + len - 1) || addr + len - 1 < addr) return NULL;
+  return guest_to_host(addr);
+}
+
+#ifdef CONFIG_HAS_VGA
+static bool pvio_fbdraw(uint32_t *a) {
+  uint64_t n = (uint64_t)a[3] * a[4];
+  if (n == 0) { vga_fbdraw(a[0], a[1], 0, 0, NULL, a[5]); return true; }
+  uint32_t *pixels = guest_range(a[2], n * sizeof(uint32_t));
+  if (pixels == NULL) return false;
+  vga_fbdraw(a[0], a[1], a[3], a[4], pixels, a[5]);
+  return true;
+}
+#endif
+
+#ifdef CONFIG_VGA_ACCEL
+static bool pvio_gpu_memcpy(uint32_t *a) {
+  if (a[2] == 0) return true;
+  void *src = guest_range(a[1], a[2]);
+  return src != NULL && vga_gpu_memcpy(a[0], src, a[2]);
+}
+#endif
+
+#ifdef CONFIG_HAS_AUDIO
+static bool pvio_audio_play(uint32_t *a) {
+  if (a[1] == 0) return true;
+  uint8_t *buf = guest_range(a[0], a[1]);
+  if (buf == NULL) return false;
+  a[1] = audio_write(buf, a[1]);
+  return true;
+}
+#endif
+
+// write a result of `len` bytes to the guest
+static bool pvio_result(paddr_t dest, const void *val, int len) {
+  void *p = guest_range(dest, len);
+  if (p == NULL) return false;
+  memcpy(p, val, len);
+  paddr_host_written(dest, len);
+  return true;
+}
+
+#ifdef CONFIG_HAS_KEYBOARD
+static bool pvio_keybrd(uint32_t *a) {
+  uint32_t key = keyboard_read();
+  return pvio_result(a[0], &key, sizeof(key));
+}
+#endif
+
+#ifdef CONFIG_HAS_TIMER
+static bool pvio_uptime(uint32_t *a) {
+  uint64_t us = rtc_read();
+  return pvio_result(a[0], &us, sizeof(us));
+}
+#endif
+
+static bool pvio_process(PvioReq *req) {
+  switch (req->op) {
+    case PVIO_OP_NOP: return true;
+#ifdef CONFIG_HAS_VGA
+    case PVIO_OP_FBDRAW: return pvio_fbdraw(req->arg);
+#endif
+#ifdef CONFIG_HAS_DISK
+    case PVIO_OP_DISK_READ:
+    case PVIO_OP_DISK_WRITE:
+      return disk_blkio(req->arg[0], req->arg[1], req->arg[2], req->op == PVIO_OP_DISK_WRITE);
+#endif
+#ifdef CONFIG_HAS_AUDIO
+    case PVIO_OP_AUDIO_PLAY: return pvio_audio_play(req->arg);
+#endif
+#ifdef CONFIG_VGA_ACCEL
+    case PVIO_OP_GPU_MEMCPY: return pvio_gpu_memcpy(req->arg);
+    case PVIO_OP_GPU_RENDER: return vga_gpu_render(req->arg[0]);
+#endif
+#ifdef CONFIG_HAS_KEYBOARD
+    case PVIO_OP_KEYBRD: return pvio_keybrd(req->arg);
+#endif
+#ifdef CONFIG_HAS_TIMER
+    case PVIO_OP_UPTIME: return pvio_uptime(req->arg);
+#endif
+    default: return false;
+  }
+}
+
+static void pvio_doorbell() {
+  uint32_t size = pvio_base[reg_size];
+  PvioReq *ring = guest_range(pvio_base[reg_ring], (uint64_t)size * sizeof(PvioReq));
+  if (ring == NULL || (size & (size - 1)) != 0) return;
+  uint32_t head = pvio_base[reg_head], tail = pvio_base[reg_doorbell];
+  // entries beyond one lap are not submitted yet
+  if (tail - head > size) tail = head + size;
+  for (; head != tail; head ++) {
+    PvioReq *req = &ring[head & (size - 1)];
+    req->status = (pvio_process(req) ? PVIO_OK : PVIO_ERROR);
+  }
+  pvio_base[reg_head] = head;
+  paddr_host_written(pvio_base[reg_ring], size * sizeof(PvioReq));
+}
+
+static void pvio_io_handler(uint32_t offset, int len, bool is_write) {
+  if (!is_write) return;
+  switch (offset / sizeof(uint32_t)) {
+    case reg_ring: case reg_size: pvio_base[reg_head] = 0; break;
+    case reg_doorbell: pvio_doorbell(); break;
+  }
+}
+
+void init_pvio() {
+  uint32_t space_size = sizeof(uint32_t) * nr_reg;
+  pvio_base = (uint32_t *)new_space(space_size);
+  pvio_base[reg_present] = PVIO_FEAT_PRESENT | MUXDEF(CONFIG_VGA_ACCEL, PVIO_FEAT_GPU_ACCEL, 0);
+#ifdef CONFIG_HAS_PORT_IO
+  add_pio_map ("pvio", CONFIG_PVIO_CTL_PORT, pvio_base, space_size, pvio_io_handler);
+#else
+  add_mmio_map("pvio", CONFIG_PVIO_CTL_MMIO, pvio_base, space_size, pvio_io_handler);
+#endif
+}
@@ -15,6 +15,10 @@
 
 #include <device/map.h>
 #include "mmc.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 // http://www.files.e-shop.co.il/pdastore/Tech-mmc-samsung/SEC%20MMC%20SPEC%20ver09.pdf
 
@@ -40,7 +44,16 @@ enum {
   SDHBLC
 };
 
-static FILE *fp = NULL;
+/* The image is mapped shared, so accessing SDDATA is a plain copy from or
+ * to the mapping. Writes are written back by the page cache of the host,
+ * and the range written by a command is scheduled for writing back when
+ * the transmission stops, and synchronized on exit. With
+ * CONFIG_DEVICE_ASYNC, a worker synchronizes the range instead, while the
+ * guest keeps running. */
+static uint8_t *img = NULL;
+static size_t img_size = 0;
+static bool img_writable = false;
+static size_t dirty_lo = -1, dirty_hi = 0;
 static uint32_t *base = NULL;
 static uint32_t blkcnt = 0;
 static long blk_addr = 0;
@@ -48,11 +61,134 @@ static uint32_t addr = 0;
 static bool write_cmd = 0;
 static bool read_ext_csd = false;
 
+#ifdef CONFIG_SNAPSHOT
+#include <device/snapshot.h>
+
+// the image is not saved, it is shared by all snapshots
+static void sdcard_snapshot(Snapshot *s) {
+  SNAPSHOT_VAR(s, blkcnt);
+  SNAPSHOT_VAR(s, blk_addr);
+  SNAPSHOT_VAR(s, addr);
+  SNAPSHOT_VAR(s, write_cmd);
+  SNAPSHOT_VAR(s, read_ext_csd);
+}
+#endif
+
+/* A read command advises the host to read the blocks requested and a
+ * window after them, so that the I/O overlaps the guest draining SDDATA.
+ * The window doubles while a command continues where the last one
+ * stopped, and falls back otherwise. With CONFIG_DEVICE_ASYNC, a worker
+ * also faults the range in, so that the CPU thread does not wait for it. */
+#define RA_MIN (128 * 1024)
+#define RA_MAX (8 * 1024 * 1024)
+static size_t ra_hi = 0; // the end of the range read ahead
+static size_t ra_win = RA_MIN;
+
+#ifdef CONFIG_DEVICE_ASYNC
+#include <device/async.h>
+
+// an operation of a worker, at most one of each kind is in flight
+typedef struct {
+  size_t lo, hi;
+  bool busy;
+} SDJob;
+static SDJob ra_job = {}, wb_job = {};
+
+static void sd_done(void *arg) {
+  ((SDJob *)arg)->busy = false;
+}
+
+static void sd_populate(void *arg) {
+  SDJob *j = arg;
+#ifdef MADV_POPULATE_READ
+  if (madvise(img + j->lo, j->hi - j->lo, MADV_POPULATE_READ) == 0) return;
+#endif
+  size_t page = sysconf(_SC_PAGESIZE), pos;
+  for (pos = j->lo; pos < j->hi; pos += page) (void)*(volatile uint8_t *)(img + pos);
+}
+
+static void sd_writeback(void *arg) {
+  SDJob *j = arg;
+  msync(img + j->lo, j->hi - j->lo, MS_SYNC);
+}
+
+static void sd_start(SDJob *j, size_t lo, size_t hi, dev_work_t work) {
+  j->lo = lo;
+  j->hi = hi;
+  j->busy = true;
+  dev_async(work, sd_done, j);
+}
+#endif
+
+static void read_ahead(size_t prev_end) {
+  size_t lo = (size_t)blk_addr << 9;
+  if (img == NULL || lo >= img_size) return;
+  if (lo == prev_end) ra_win = (ra_win * 2 < RA_MAX ? ra_win * 2 : RA_MAX);
+  else { ra_win = RA_MIN; ra_hi = 0; }
+  size_t hi = lo + ((size_t)blkcnt << 9) + ra_win;
+  if (hi > img_size) hi = img_size;
+  // skip what is read ahead by the commands before
+  if (ra_hi > lo) lo = ra_hi;
+  if (lo >= hi) return;
+  ra_hi = hi;
+  lo &= ~(sysconf(_SC_PAGESIZE) - 1);
+  madvise(img + lo, hi - lo, MADV_WILLNEED);
+  // the range is left to the kernel if the worker is still busy
+  IFDEF(CONFIG_DEVICE_ASYNC, if (!ra_job.busy) sd_start(&ra_job, lo, hi, sd_populate));
+}
+
 static void prepare_rw(int is_write) {
+  // where the last command stopped, see read_ahead()
+  size_t prev_end = (write_cmd ? -1 : ((size_t)blk_addr << 9) + addr);
   blk_addr = base[SDARG];
   addr = 0;
-  if (fp) fseek(fp, blk_addr << 9, SEEK_SET);
   write_cmd = is_write;
+  if (!is_write) read_ahead(prev_end);
+}
+
+static void sync_img(int flags) {
+  if (dirty_lo >= dirty_hi) return;
+  size_t lo = dirty_lo & ~(sysconf(_SC_PAGESIZE) - 1);
+  msync(img + lo, dirty_hi - lo, flags);
+  dirty_lo = -1;
+  dirty_hi = 0;
+}
+
+static void stop_transmission() {
+#ifdef CONFIG_DEVICE_ASYNC
+  // the range is left to the next stop if the worker is still busy
+  if (dirty_lo >= dirty_hi || wb_job.busy) return;
+  size_t lo = dirty_lo & ~(sysconf(_SC_PAGESIZE) - 1);
+  sd_start(&wb_job, lo, dirty_hi, sd_writeback);
+  dirty_lo = -1;
+  dirty_hi = 0;
+#else
+  sync_img(MS_ASYNC);
+#endif
+}
+
+static void sync_img_at_exit() {
+#ifdef CONFIG_DEVICE_ASYNC
+  // also the range being written back, which may not be finished
+  if (wb_job.busy) {
+    if (wb_job.lo < dirty_lo) dirty_lo = wb_job.lo;
+    if (wb_job.hi > dirty_hi) dirty_hi = wb_job.hi;
+  }
+#endif
+  sync_img(MS_SYNC);
+}
+
+static void access_data() {
+  size_t pos = (blk_addr << 9) + addr;
+  if (img == NULL || pos + 4 > img_size) {
+    if (!write_cmd) base[SDDATA] = 0;
+    return;
+  }
+  if (!write_cmd) { memcpy(&base[SDDATA], img + pos, 4); return; }
+  if (!img_writable) return;
+  memcpy(img + pos, &base[SDDATA], 4);
+  if (pos < dirty_lo) dirty_lo = pos;
+  if (pos + 4 > dirty_hi) dirty_hi = pos + 4;
 }
 
 static void sdcard_handle_cmd(int cmd) {
@@ -82,7 +218,7 @@ static void sdcard_handle_cmd(int cmd) {
     case MMC_READ_MULTIPLE_BLOCK: prepare_rw(false); break;
     case MMC_WRITE_MULTIPLE_BLOCK: prepare_rw(true); break;
     case MMC_SEND_STATUS: base[SDRSP0] = 0x900; base[SDRSP1] = base[SDRSP2] = base[SDRSP3] = 0; break;
-    case MMC_STOP_TRANSMISSION: break;
+    case MMC_STOP_TRANSMISSION: stop_transmission(); break;
     default:
       panic("unhandled command = %d", cmd);
   }
@@ -109,10 +245,8 @@ static void sdcard_io_handler(uint32_t offset, int len, bool is_write) {
          }
          base[SDDATA] = data;
          if (addr == 512 - 4) read_ext_csd = false;
-       } else if (fp) {
-         __attribute__((unused)) int ret;
-         if (!write_cmd) { ret = fread(&base[SDDATA], 4, 1, fp); }
-         else { ret = fwrite(&base[SDDATA], 4, 1, fp); }
+       } else if (is_write == write_cmd) {
+         access_data();
        }
        addr += 4;
        break;
@@ -122,13 +256,32 @@ static void sdcard_io_handler(uint32_t offset, int len, bool is_write) {
   }
 }
 
+static void open_image() {
+  const char *path = CONFIG_SDCARD_IMG_PATH;
+  int fd = open(path, O_RDWR);
+  img_writable = (fd >= 0);
+  if (fd < 0) fd = open(path, O_RDONLY);
+  if (fd < 0) { Log_warn("Can not find sdcard image: %s", path); return; }
+
+  struct stat st;
+  int ret = fstat(fd, &st);
+  assert(ret == 0);
+  img_size = st.st_size;
+  if (img_size > 0) {
+    void *p = mmap(NULL, img_size, PROT_READ | (img_writable ? PROT_WRITE : 0), MAP_SHARED, fd, 0);
+    Assert(p != MAP_FAILED, "Can not map sdcard image: %s", path);
+    img = p;
+    if (img_writable) atexit(sync_img_at_exit);
+  }
+  close(fd);
+}
+
 void init_sdcard() {
   base = (uint32_t *)new_space(0x80);
+  // the image is opened by the first access
+  io_space_set_init(base, open_image);
   add_mmio_map("sdhci", CONFIG_SDCARD_CTL_MMIO, base, 0x80, sdcard_io_handler);
+  IFDEF(CONFIG_SNAPSHOT, snapshot_register("sdcard", sdcard_snapshot));
 
   Assert(C_SIZE < (1 << 12), "shoule be fit in 12 bits");
-
-  const char *img = CONFIG_SDCARD_IMG_PATH;
-  fp = fopen(img, "r+");
-  if (fp == NULL) Log("Can not find sdcard image: %s", img);
 }
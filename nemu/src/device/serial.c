@@ -15,18 +15,99 @@
 
 #include <utils.h>
 #include <device/map.h>
+#include <device/replay.h>
+#include <device/alarm.h>
+#include <device/event.h>
 
 /* http://en.wikibooks.org/wiki/Serial_Programming/8250_UART_Programming */
 // NOTE: this is compatible to 16550
 
 #define CH_OFFSET 0
+#define LSR_OFFSET 5
+#define LSR_TX_READY 0x60
+#define LSR_RX_READY 0x01
 
 static uint8_t *serial_base = NULL;
 
+#ifndef CONFIG_TARGET_AM
+/* Output is buffered and written when a newline is put, when the buffer
+ * is full, and by an event FLUSH_DELAY_US after the first byte buffered,
+ * instead of a write() per byte. */
+#define OBUF_SIZE 4096
+#define FLUSH_DELAY_US (1000000 / TIMER_HZ)
+static char obuf[OBUF_SIZE];
+static int obuf_len = 0;
+static int flush_event_id = -1;
+
+void serial_flush() {
+  if (obuf_len == 0) return;
+  fwrite(obuf, 1, obuf_len, stderr);
+  obuf_len = 0;
+}
+
+static void serial_putc(char ch) {
+  IFDEF(CONFIG_REVERSE, if (reverse_replaying) return);
+  if (obuf_len == 0 && ch != '\n') dev_event_schedule(flush_event_id, FLUSH_DELAY_US);
+  obuf[obuf_len ++] = ch;
+  if (ch == '\n' || obuf_len == OBUF_SIZE) serial_flush();
+}
+
+static void flush_event(void *arg) {
+  serial_flush();
+}
+#else
+void serial_flush() { }
 
 static void serial_putc(char ch) {
-  MUXDEF(CONFIG_TARGET_AM, putch(ch), putc(ch, stderr));
+  putch(ch);
 }
+#endif
+
+#ifdef CONFIG_SERIAL_INPUT_FIFO
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+/* Input is read from the FIFO without blocking by a periodic event, so
+ * reading the serial port never waits for the host. */
+#define FIFO_PATH "/tmp/nemu.serial"
+#define POLL_PERIOD_US (1000000 / TIMER_HZ)
+#define IBUF_SIZE 1024
+static int fifo_fd = -1;
+static uint8_t ibuf[IBUF_SIZE];
+static int ibuf_head = 0, ibuf_tail = 0; // bytes in [head, tail) are not read yet
+
+static void serial_poll(void *arg) {
+  if (fifo_fd < 0 || ibuf_head != ibuf_tail) return;
+  struct pollfd p = { .fd = fifo_fd, .events = POLLIN };
+  if (poll(&p, 1, 0) <= 0 || !(p.revents & POLLIN)) return;
+  ssize_t n = read(fifo_fd, ibuf, IBUF_SIZE);
+  ibuf_head = 0;
+  ibuf_tail = (n > 0 ? n : 0);
+}
+
+static bool serial_has_input() {
+  return ibuf_head != ibuf_tail;
+}
+
+static uint8_t serial_getc() {
+  return (serial_has_input() ? ibuf[ibuf_head ++] : 0xff);
+}
+
+static void init_fifo() {
+  int ret = mkfifo(FIFO_PATH, 0666);
+  Assert(ret == 0 || errno == EEXIST, "Can not create " FIFO_PATH);
+  // opening a FIFO for reading without blocking does not wait for the writer
+  fifo_fd = open(FIFO_PATH, O_RDONLY | O_NONBLOCK);
+  Assert(fifo_fd >= 0, "Can not open " FIFO_PATH);
+  dev_event_periodic(dev_event_new("serial-in", serial_poll, NULL), POLL_PERIOD_US);
+}
+#else
+static bool serial_has_input() { return false; }
+static uint8_t serial_getc() { return 0xff; }
+#endif
 
 static void serial_io_handler(uint32_t offset, int len, bool is_write) {
   assert(len == 1);
@@ -34,7 +115,10 @@ static void serial_io_handler(uint32_t offset, int len, bool is_write) {
     /* We bind the serial port with the host stderr in NEMU. */
     case CH_OFFSET:
       if (is_write) serial_putc(serial_base[0]);
-      else panic("do not support read");
+      else serial_base[0] = DEVICE_INPUT(serial_getc());
+      break;
+    case LSR_OFFSET:
+      if (!is_write) serial_base[LSR_OFFSET] = LSR_TX_READY | (DEVICE_INPUT(serial_has_input()) ? LSR_RX_READY : 0);
       break;
     default: panic("do not support offset = %d", offset);
   }
@@ -47,5 +131,10 @@ void init_serial() {
 #else
   add_mmio_map("serial", CONFIG_SERIAL_MMIO, serial_base, 8, serial_io_handler);
 #endif
+  IFDEF(CONFIG_SERIAL_INPUT_FIFO, init_fifo());
+#ifndef CONFIG_TARGET_AM
+  flush_event_id = dev_event_new("serial-out", flush_event, NULL);
+  atexit(serial_flush);
+#endif
 
 }
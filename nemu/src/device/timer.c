@@ -15,24 +15,70 @@
 
 #include <device/map.h>
 #include <device/alarm.h>
+#include <device/replay.h>
 #include <utils.h>
 
 static uint32_t *rtc_port_base = NULL;
+IFNDEF(CONFIG_TIMER_VIRTUAL, static int64_t rtc_offset = 0); // changed by loading snapshots
 
+#ifdef CONFIG_TIMER_VIRTUAL
+static uint64_t get_virtual_time() {
+  extern uint64_t g_nr_guest_inst;
+  return g_nr_guest_inst / CONFIG_TIMER_VIRTUAL_MIPS;
+}
+#endif
+
+// the uptime seen by the guest, also read through pvio
+uint64_t rtc_read() {
+  uint64_t us = MUXDEF(CONFIG_TIMER_VIRTUAL, get_virtual_time(), DEVICE_INPUT(get_time() + rtc_offset));
+#ifdef CONFIG_IDLE_SLEEP
+  void device_idle_poll();
+  device_idle_poll();
+#endif
+  return us;
+}
+
+// Reading the low word latches the whole counter, so the high word read
+// next belongs to the same value. An 8-byte read gets both in one access.
 static void rtc_io_handler(uint32_t offset, int len, bool is_write) {
   assert(offset == 0 || offset == 4);
-  if (!is_write && offset == 4) {
-    uint64_t us = get_time();
+  if (!is_write && offset == 0) {
+    uint64_t us = rtc_read();
     rtc_port_base[0] = (uint32_t)us;
     rtc_port_base[1] = us >> 32;
   }
 }
 
+#if defined(CONFIG_SNAPSHOT) && !defined(CONFIG_TIMER_VIRTUAL)
+#include <device/snapshot.h>
+
+// the rtc continues from the time of the snapshot after loading it
+static void rtc_snapshot(Snapshot *s) {
+  if (snapshot_is_replay(s)) return;
+  uint64_t us = get_time() + rtc_offset;
+  SNAPSHOT_VAR(s, us);
+  if (snapshot_is_load(s)) rtc_offset = us - get_time();
+}
+#endif
+
+#ifdef CONFIG_TIMING
+#include <cpu/timing.h>
+
+static uint32_t *cycle_port_base = NULL;
+
+// reading the low word latches the whole counter
+static void cycle_io_handler(uint32_t offset, int len, bool is_write) {
+  if (is_write || offset != 0) return;
+  cycle_port_base[0] = (uint32_t)timing_cycle;
+  cycle_port_base[1] = timing_cycle >> 32;
+}
+#endif
+
 #ifndef CONFIG_TARGET_AM
 static void timer_intr() {
   if (nemu_state.state == NEMU_RUNNING) {
     extern void dev_raise_intr();
-    dev_raise_intr();
+    DEVICE_INTR(dev_raise_intr());
   }
 }
 #endif
@@ -43,6 +89,13 @@ void init_timer() {
   add_pio_map ("rtc", CONFIG_RTC_PORT, rtc_port_base, 8, rtc_io_handler);
 #else
   add_mmio_map("rtc", CONFIG_RTC_MMIO, rtc_port_base, 8, rtc_io_handler);
+#endif
+#ifdef CONFIG_TIMING
+  cycle_port_base = (uint32_t *)new_space(8);
+  add_mmio_map("cycle", CONFIG_CYCLE_MMIO, cycle_port_base, 8, cycle_io_handler);
 #endif
   IFNDEF(CONFIG_TARGET_AM, add_alarm_handle(timer_intr));
+#if defined(CONFIG_SNAPSHOT) && !defined(CONFIG_TIMER_VIRTUAL)
+  snapshot_register("timer", rtc_snapshot);
+#endif
 }
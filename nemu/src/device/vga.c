@@ -15,6 +15,8 @@
 
 #include <common.h>
 #include <device/map.h>
+#include <device/alarm.h>
+#include <device/event.h>
 
 #define SCREEN_W (MUXDEF(CONFIG_VGA_SIZE_800x600, 800, 400))
 #define SCREEN_H (MUXDEF(CONFIG_VGA_SIZE_800x600, 600, 300))
@@ -35,47 +37,507 @@ static void *vmem = NULL;
 static uint32_t *vgactl_port_base = NULL;
 
 #ifdef CONFIG_VGA_SHOW_SCREEN
+/* A frame is presented when the guest syncs, but no more often than the
+ * host display refreshes. A sync coming earlier is left pending, and the
+ * dirty bands keep accumulating, so that the frames in between are skipped
+ * instead of uploaded, and the next poll after the interval presents the
+ * latest one. */
+static uint64_t frame_interval = 1000000 / 60; // us, set by the refresh rate of the display
+static uint64_t next_frame = 0;
+
+static bool frame_due() {
+  uint64_t now = get_time();
+  if (now < next_frame) return false;
+  uint64_t interval = __atomic_load_n(&frame_interval, __ATOMIC_RELAXED);
+  // keep the pace, unless the guest has not synced for a while
+  next_frame = (now - next_frame < interval ? next_frame : now) + interval;
+  return true;
+}
+
 #ifndef CONFIG_TARGET_AM
 #include <SDL2/SDL.h>
 
 static SDL_Renderer *renderer = NULL;
 static SDL_Texture *texture = NULL;
 
-static void init_screen() {
+/* The screen is divided into bands of rows. Writes to vmem extend the
+ * range of dirty columns of the band, and only that range is uploaded to
+ * the texture on sync. A band is clean if x0 >= x1. */
+#define BAND_H 16
+#define NR_BAND ((SCREEN_H + BAND_H - 1) / BAND_H)
+
+typedef struct {
+  uint16_t x0, x1;
+} Band;
+
+static Band band[NR_BAND];
+
+static inline void mark_dirty(uint32_t y, uint32_t x0, uint32_t x1) {
+  int i = y / BAND_H;
+  if (x0 < band[i].x0) band[i].x0 = x0;
+  if (x1 > band[i].x1) band[i].x1 = x1;
+}
+
+static inline bool band_dirty(const Band *b) {
+  return b->x0 < b->x1;
+}
+
+static inline Band band_union(Band a, Band b) {
+  if (!band_dirty(&a)) return b;
+  if (!band_dirty(&b)) return a;
+  return (Band) { .x0 = (a.x0 < b.x0 ? a.x0 : b.x0), .x1 = (a.x1 > b.x1 ? a.x1 : b.x1) };
+}
+
+static void vmem_io_handler(uint32_t offset, int len, bool is_write) {
+  if (!is_write) return;
+  uint32_t pixel = offset / sizeof(uint32_t);
+  uint32_t x = pixel % SCREEN_W, y = pixel / SCREEN_W;
+  uint32_t x1 = x + (offset % sizeof(uint32_t) + len + sizeof(uint32_t) - 1) / sizeof(uint32_t);
+  if (x1 > SCREEN_W) {
+    // the write crosses the end of the row
+    if (y + 1 < SCREEN_H) mark_dirty(y + 1, 0, x1 - SCREEN_W);
+    x1 = SCREEN_W;
+  }
+  if (y < SCREEN_H) mark_dirty(y, x, x1);
+}
+
+/* The window of 400x300 is scaled by 2. A renderer on the GPU scales the
+ * texture for free, but the software renderer stretches it pixel by pixel
+ * on every present. For the latter, the texture has the size of the window
+ * instead, and the dirty bands are scaled into it by duplicating pixels,
+ * written straight into the locked streaming texture without another copy,
+ * so that the present is a plain copy. */
+#define SCALE MUXDEF(CONFIG_VGA_SIZE_400x300, 2, 1)
+static bool scale_on_cpu = false;
+
+static void open_window() {
   SDL_Window *window = NULL;
   char title[128];
   sprintf(title, "%s-NEMU", str(__GUEST_ISA__));
   SDL_Init(SDL_INIT_VIDEO);
-  SDL_CreateWindowAndRenderer(
-      SCREEN_W * (MUXDEF(CONFIG_VGA_SIZE_400x300, 2, 1)),
-      SCREEN_H * (MUXDEF(CONFIG_VGA_SIZE_400x300, 2, 1)),
-      0, &window, &renderer);
+  SDL_CreateWindowAndRenderer(SCREEN_W * SCALE, SCREEN_H * SCALE, 0, &window, &renderer);
   SDL_SetWindowTitle(window, title);
-  texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888,
-      SDL_TEXTUREACCESS_STATIC, SCREEN_W, SCREEN_H);
+  SDL_DisplayMode mode;
+  if (SDL_GetWindowDisplayMode(window, &mode) == 0 && mode.refresh_rate > 0) {
+    // written by the display thread with CONFIG_VGA_THREAD
+    __atomic_store_n(&frame_interval, 1000000 / mode.refresh_rate, __ATOMIC_RELAXED);
+  }
+  SDL_RendererInfo info;
+  scale_on_cpu = (SCALE > 1 && SDL_GetRendererInfo(renderer, &info) == 0 &&
+      (info.flags & SDL_RENDERER_SOFTWARE));
+  if (scale_on_cpu) {
+    texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888,
+        SDL_TEXTUREACCESS_STREAMING, SCREEN_W * SCALE, SCREEN_H * SCALE);
+  } else {
+    texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888,
+        SDL_TEXTUREACCESS_STATIC, SCREEN_W, SCREEN_H);
+  }
   SDL_RenderPresent(renderer);
 }
 
-static inline void update_screen() {
-  SDL_UpdateTexture(texture, NULL, vmem, SCREEN_W * sizeof(uint32_t));
+// scale `rect` of `pixels` by SCALE into the texture
+static void upload_scaled(const uint32_t *pixels, const SDL_Rect *rect) {
+  SDL_Rect r = { .x = rect->x * SCALE, .y = rect->y * SCALE, .w = rect->w * SCALE, .h = rect->h * SCALE };
+  void *dst;
+  int pitch;
+  if (SDL_LockTexture(texture, &r, &dst, &pitch) != 0) return;
+  int x, y, k;
+  for (y = 0; y < rect->h; y ++) {
+    const uint32_t *src = pixels + (rect->y + y) * SCREEN_W + rect->x;
+    uint32_t *row = (uint32_t *)((uint8_t *)dst + y * SCALE * pitch);
+    // simple enough to be vectorized by the compiler
+    for (x = 0; x < rect->w; x ++) {
+      for (k = 0; k < SCALE; k ++) row[x * SCALE + k] = src[x];
+    }
+    for (k = 1; k < SCALE; k ++) memcpy((uint8_t *)row + k * pitch, row, r.w * sizeof(uint32_t));
+  }
+  SDL_UnlockTexture(texture);
+}
+
+// upload the dirty bands of `pixels` and present the frame
+static void draw_frame(const uint32_t *pixels, const Band *b) {
+  int i;
+  for (i = 0; i < NR_BAND; i ++) {
+    if (!band_dirty(&b[i])) continue;
+    int y = i * BAND_H;
+    SDL_Rect rect = { .x = b[i].x0, .y = y, .w = b[i].x1 - b[i].x0,
+      .h = (SCREEN_H - y < BAND_H ? SCREEN_H - y : BAND_H) };
+    if (scale_on_cpu) upload_scaled(pixels, &rect);
+    else SDL_UpdateTexture(texture, &rect, pixels + y * SCREEN_W + rect.x, SCREEN_W * sizeof(uint32_t));
+  }
   SDL_RenderClear(renderer);
   SDL_RenderCopy(renderer, texture, NULL, NULL);
   SDL_RenderPresent(renderer);
 }
+
+static bool take_dirty_bands(Band *out) {
+  bool dirty = false;
+  int i;
+  for (i = 0; i < NR_BAND; i ++) {
+    if (band_dirty(&band[i])) dirty = true;
+    out[i] = band[i];
+    band[i].x0 = SCREEN_W;
+    band[i].x1 = 0;
+  }
+  return dirty;
+}
+
+extern bool device_headless;
+void vga_open_window();
+
+#ifdef CONFIG_VGA_RECORD
+static const char *rec_file = NULL;
+
+void vga_set_record(const char *file) { rec_file = file; }
+#endif
+
+// frames are still produced with --headless for recording
+static inline bool vga_recording() {
+  return MUXDEF(CONFIG_VGA_RECORD, rec_file != NULL, false);
+}
+
+#ifdef CONFIG_VGA_THREAD
+#include <pthread.h>
+#include <unistd.h>
+
+void device_poll_events();
+
+/* Frames are handed to the display thread by triple buffering. The CPU
+ * thread fills frame[frame_write] and exchanges it with frame_ready, and
+ * the display thread exchanges frame_read with frame_ready if it is fresh,
+ * so neither of them ever waits for the other. A frame carries the bands
+ * changed since the last frame taken by the display thread, including
+ * those of frames replaced before being taken. */
+#define FRAME_FRESH 4
+
+static uint32_t frame[3][SCREEN_W * SCREEN_H];
+static Band frame_band[3][NR_BAND];
+static int frame_ready = 1;
+static int frame_write = 0; // only used by the CPU thread
+static int frame_read = 2;  // only used by the display thread
+static Band acc_band[NR_BAND]; // bands of frames not known to be taken
+
+#ifdef CONFIG_VGA_RECORD
+/* Frames taken by the display thread are also recorded into a Y4M video
+ * by an encoder thread, or piped to a command if the file is "|COMMAND",
+ * such as "|ffmpeg -i - out.mp4". The display thread copies a frame into a
+ * free slot of a small pool, so the CPU thread copies nothing more than
+ * for the display, and the frame is dropped if the encoder has not freed
+ * any slot. The video runs at the refresh rate of the display, and a frame
+ * is repeated for the refreshes it stays on the screen, up to a second. */
+#define NR_REC_SLOT 4
+
+static FILE *rec_fp = NULL;
+static bool rec_is_pipe = false;
+static uint32_t rec_frame[NR_REC_SLOT][SCREEN_W * SCREEN_H];
+static uint64_t rec_time[NR_REC_SLOT];
+// the slots in [rec_tail, rec_head) are full, rec_head is only written by
+// the display thread, and rec_tail by the encoder thread
+static uint32_t rec_head = 0, rec_tail = 0;
+static uint64_t rec_nr_frame = 0, rec_nr_drop = 0;
+static bool rec_stop = false;
+static pthread_t rec_thread;
+
+// called by the display thread
+static void rec_push(const uint32_t *pixels) {
+  uint32_t h = rec_head;
+  if (h - __atomic_load_n(&rec_tail, __ATOMIC_ACQUIRE) == NR_REC_SLOT) { rec_nr_drop ++; return; }
+  memcpy(rec_frame[h % NR_REC_SLOT], pixels, sizeof(rec_frame[0]));
+  rec_time[h % NR_REC_SLOT] = get_time();
+  __atomic_store_n(&rec_head, h + 1, __ATOMIC_RELEASE);
+}
+
+// BT.601 with the limited range, which players assume for Y4M
+static void rec_convert(uint8_t *yuv, const uint32_t *pixels) {
+  const int n = SCREEN_W * SCREEN_H;
+  int i;
+  for (i = 0; i < n; i ++) {
+    int r = (pixels[i] >> 16) & 0xff, g = (pixels[i] >> 8) & 0xff, b = pixels[i] & 0xff;
+    yuv[i]         = (( 66 * r + 129 * g +  25 * b + 128) >> 8) + 16;
+    yuv[n + i]     = ((-38 * r -  74 * g + 112 * b + 128) >> 8) + 128;
+    yuv[2 * n + i] = ((112 * r -  94 * g -  18 * b + 128) >> 8) + 128;
+  }
+}
+
+static void* encoder_thread(void *arg) {
+  static uint8_t yuv[3 * SCREEN_W * SCREEN_H];
+  uint64_t interval = __atomic_load_n(&frame_interval, __ATOMIC_RELAXED);
+  fprintf(rec_fp, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C444\n", SCREEN_W, SCREEN_H,
+      (int)((1000000 + interval / 2) / interval));
+  uint64_t last = 0;
+  while (true) {
+    uint32_t t = rec_tail;
+    if (t == __atomic_load_n(&rec_head, __ATOMIC_ACQUIRE)) {
+      if (__atomic_load_n(&rec_stop, __ATOMIC_ACQUIRE)) break;
+      usleep(1000);
+      continue;
+    }
+    int slot = t % NR_REC_SLOT;
+    if (rec_nr_frame > 0) {
+      // the last frame stays on the screen until this one
+      uint64_t n = (rec_time[slot] - last) / interval;
+      if (n > 1000000 / interval) n = 1000000 / interval;
+      for (; n > 1; n --) { fputs("FRAME\n", rec_fp); fwrite(yuv, 1, sizeof(yuv), rec_fp); }
+    }
+    last = rec_time[slot];
+    rec_convert(yuv, rec_frame[slot]);
+    __atomic_store_n(&rec_tail, t + 1, __ATOMIC_RELEASE);
+    fputs("FRAME\n", rec_fp);
+    fwrite(yuv, 1, sizeof(yuv), rec_fp);
+    rec_nr_frame ++;
+  }
+  return NULL;
+}
+
+static void rec_close() {
+  __atomic_store_n(&rec_stop, true, __ATOMIC_RELEASE);
+  pthread_join(rec_thread, NULL);
+  if (rec_is_pipe) pclose(rec_fp);
+  else fclose(rec_fp);
+  Log("Recorded %" PRIu64 " frames into %s, %" PRIu64 " dropped", rec_nr_frame, rec_file, rec_nr_drop);
+}
+
+// called by the display thread, after the refresh rate is known
+static void rec_open() {
+  rec_is_pipe = (rec_file[0] == '|');
+  rec_fp = (rec_is_pipe ? popen(rec_file + 1, "w") : fopen(rec_file, "wb"));
+  if (rec_fp == NULL) { Log_warn("Can not record the screen into %s", rec_file); rec_file = NULL; return; }
+  FOOTPRINT("vga", rec_frame, sizeof(rec_frame));
+  int ret = pthread_create(&rec_thread, NULL, encoder_thread, NULL);
+  Assert(ret == 0, "Can not create the encoder thread");
+  atexit(rec_close);
+}
+#endif
+
+static void* display_thread(void *arg) {
+  // SDL expects windows to be used by the thread creating them
+  if (!device_headless) open_window();
+  IFDEF(CONFIG_VGA_RECORD, if (rec_file != NULL) rec_open());
+  while (true) {
+    device_poll_events();
+    if (__atomic_load_n(&frame_ready, __ATOMIC_ACQUIRE) & FRAME_FRESH) {
+      int r = __atomic_exchange_n(&frame_ready, frame_read, __ATOMIC_ACQ_REL);
+      frame_read = r & ~FRAME_FRESH;
+      if (!device_headless) draw_frame(frame[frame_read], frame_band[frame_read]);
+      IFDEF(CONFIG_VGA_RECORD, if (rec_file != NULL) rec_push(frame[frame_read]));
+    } else {
+      usleep(1000);
+    }
+  }
+  return NULL;
+}
+
+static void init_screen() {
+  pthread_t thread;
+  int ret = pthread_create(&thread, NULL, display_thread, NULL);
+  Assert(ret == 0, "Can not create the display thread");
+  FOOTPRINT("vga", frame, sizeof(frame));
+  pthread_detach(thread);
+}
+
+static inline void update_screen() {
+  Band b[NR_BAND];
+  if (!take_dirty_bands(b)) return;
+  vga_open_window();
+  if (device_headless && !vga_recording()) return;
+  int w = frame_write, i;
+  for (i = 0; i < NR_BAND; i ++) frame_band[w][i] = band_union(acc_band[i], b[i]);
+  memcpy(frame[w], vmem, sizeof(frame[w]));
+  int old = __atomic_exchange_n(&frame_ready, w | FRAME_FRESH, __ATOMIC_ACQ_REL);
+  frame_write = old & ~FRAME_FRESH;
+  // if the previous frame is taken, the next one only needs the bands of this frame
+  bool dropped = old & FRAME_FRESH;
+  for (i = 0; i < NR_BAND; i ++) acc_band[i] = (dropped ? frame_band[w][i] : b[i]);
+}
+#else
+static void init_screen() { open_window(); }
+
+static inline void update_screen() {
+  Band b[NR_BAND];
+  // nothing to present if the frame is not changed
+  if (!take_dirty_bands(b)) return;
+  vga_open_window();
+  if (!device_headless) draw_frame(vmem, b);
+}
+#endif
+
+/* The window is opened on the first frame presented, or on the first read
+ * of the keyboard, which needs it for input, so that SDL is not initialized
+ * for runs using neither. It is never opened with --headless, where the
+ * display thread only runs for recording. */
+void vga_open_window() {
+  static bool opened = false;
+  if (likely(opened) || (device_headless && !vga_recording())) return;
+  opened = true;
+  init_screen();
+}
+
+static io_callback_t vmem_callback() {
+  // nothing is presented with --headless, so vmem is plain memory to the guest
+  if (device_headless && !vga_recording()) return NULL;
+  // the whole texture is uploaded for the first time
+  int i;
+  for (i = 0; i < NR_BAND; i ++) { band[i].x0 = 0; band[i].x1 = SCREEN_W; }
+  return vmem_io_handler;
+}
 #else
 static void init_screen() {}
 
+static io_callback_t vmem_callback() { return NULL; }
+
 static inline void update_screen() {
   io_write(AM_GPU_FBDRAW, 0, 0, vmem, screen_width(), screen_height(), true);
 }
 #endif
 #endif
 
+// draw a rectangle of `w * h` pixels natively, clipped to the screen
+void vga_fbdraw(uint32_t x, uint32_t y, uint32_t w, uint32_t h, const uint32_t *pixels, bool sync) {
+  uint32_t sw = screen_width(), sh = screen_height();
+  if (x < sw && y < sh) {
+    uint32_t cw = (w < sw - x ? w : sw - x);
+    uint32_t ch = (h < sh - y ? h : sh - y);
+    uint32_t j;
+    for (j = 0; j < ch; j ++) {
+      memcpy((uint32_t *)vmem + (y + j) * sw + x, pixels + j * w, cw * sizeof(uint32_t));
+#if defined(CONFIG_VGA_SHOW_SCREEN) && !defined(CONFIG_TARGET_AM)
+      mark_dirty(y + j, x, x + cw);
+#endif
+    }
+  }
+  if (sync) vgactl_port_base[1] = 1;
+}
+
+#ifdef CONFIG_VGA_ACCEL
+/* The 2D accelerator keeps textures and canvas nodes in its own memory,
+ * addressed by the offsets of gpuptr_t in amdev.h. A render composes the
+ * tree of canvases into vmem: a texture is scaled into its parent, and a
+ * subtree is composed in a scratch buffer first. */
+#define GMEM_SIZE (8 * 1024 * 1024)
+#define GPU_NULL 0xffffffff
+#define GPU_TEXTURE 1
+#define GPU_SUBTREE 2
+#define GPU_MAX_DEPTH 16
+#define GPU_MAX_NODE 65536
+
+typedef struct {
+  uint16_t type, w, h, x1, y1, w1, h1;
+  uint32_t sibling;
+  union {
+    uint32_t child;
+    struct { uint16_t w, h; uint32_t pixels; } __attribute__((packed)) texture;
+  };
+} __attribute__((packed)) GpuCanvas;
+
+static uint8_t *gmem = NULL, *gscratch = NULL;
+static uint32_t gscratch_used = 0;
+static int gpu_nr_node = 0;
+
+static void *gmem_range(uint8_t *base, uint32_t ptr, uint64_t len) {
+  if (len > GMEM_SIZE || ptr > GMEM_SIZE - len) return NULL;
+  return base + ptr;
+}
+
+bool vga_gpu_memcpy(uint32_t dest, const void *src, uint32_t size) {
+  void *dst = gmem_range(gmem, dest, size);
+  if (dst == NULL) return false;
+  memcpy(dst, src, size);
+  return true;
+}
+
+// scale the `w * h` pixels of `src` to the rectangle of `cv` in the `W * H` canvas
+static void gpu_blit(uint32_t *dst, int W, int H, const GpuCanvas *cv, const uint32_t *src, int w, int h) {
+  int x1 = cv->x1, y1 = cv->y1, w1 = cv->w1, h1 = cv->h1;
+  if (w == 0 || h == 0 || x1 >= W || y1 >= H) return;
+  int cw = (w1 < W - x1 ? w1 : W - x1);
+  int ch = (h1 < H - y1 ? h1 : H - y1);
+  int i, j;
+  dst += y1 * W + x1;
+  if (w1 == w && h1 == h) {
+    for (j = 0; j < ch; j ++) memcpy(dst + j * W, src + j * w, cw * sizeof(uint32_t));
+    return;
+  }
+  static uint16_t xmap[UINT16_MAX + 1];
+  for (i = 0; i < cw; i ++) xmap[i] = (uint64_t)i * w / w1;
+  for (j = 0; j < ch; j ++) {
+    const uint32_t *row = src + (uint64_t)j * h / h1 * w;
+    uint32_t *d = dst + j * W;
+    for (i = 0; i < cw; i ++) d[i] = row[xmap[i]];
+  }
+}
+
+static bool gpu_render_node(uint32_t ptr, uint32_t *dst, int W, int H, int depth) {
+  if (depth > GPU_MAX_DEPTH || ++ gpu_nr_node > GPU_MAX_NODE) return false;
+  GpuCanvas *cv = gmem_range(gmem, ptr, sizeof(GpuCanvas));
+  if (cv == NULL) return false;
+  switch (cv->type) {
+    case GPU_TEXTURE: {
+      int w = cv->texture.w, h = cv->texture.h;
+      uint32_t *pixels = gmem_range(gmem, cv->texture.pixels, (uint64_t)w * h * sizeof(uint32_t));
+      if (pixels == NULL) return false;
+      gpu_blit(dst, W, H, cv, pixels, w, h);
+      return true;
+    }
+    case GPU_SUBTREE: {
+      int w = cv->w, h = cv->h;
+      uint64_t size = (uint64_t)w * h * sizeof(uint32_t);
+      uint32_t *local = gmem_range(gscratch, gscratch_used, size);
+      if (local == NULL) return false;
+      gscratch_used += size;
+      memset(local, 0, size);
+      uint32_t child;
+      for (child = cv->child; child != GPU_NULL; ) {
+        if (!gpu_render_node(child, local, w, h, depth + 1)) return false;
+        child = ((GpuCanvas *)(gmem + child))->sibling;
+      }
+      gpu_blit(dst, W, H, cv, local, w, h);
+      return true;
+    }
+    default: return false;
+  }
+}
+
+bool vga_gpu_render(uint32_t root) {
+  uint32_t sw = screen_width(), sh = screen_height();
+  gscratch_used = 0;
+  gpu_nr_node = 0;
+  bool ok = gpu_render_node(root, vmem, sw, sh, 0);
+#if defined(CONFIG_VGA_SHOW_SCREEN) && !defined(CONFIG_TARGET_AM)
+  uint32_t y;
+  for (y = 0; y < sh; y += BAND_H) mark_dirty(y, 0, sw);
+#endif
+  vgactl_port_base[1] = 1;
+  return ok;
+}
+#endif
+
 void vga_update_screen() {
-  // TODO: call `update_screen()` when the sync register is non-zero,
-  // then zero out the sync register
+  if (vgactl_port_base[1] != 0) {
+    IFDEF(CONFIG_VGA_SHOW_SCREEN, if (!frame_due()) return; update_screen());
+    vgactl_port_base[1] = 0;
+  }
 }
 
+// the sync register is checked TIMER_HZ times per second
+static void vga_event(void *arg) {
+  vga_update_screen();
+}
+
+#ifdef CONFIG_SNAPSHOT
+#include <device/snapshot.h>
+
+// vmem is saved with the other devices, only redraw the screen on loading
+static void vga_snapshot(Snapshot *s) {
+  if (!snapshot_is_load(s)) return;
+#if defined(CONFIG_VGA_SHOW_SCREEN) && !defined(CONFIG_TARGET_AM)
+  int i;
+  for (i = 0; i < NR_BAND; i ++) mark_dirty(i * BAND_H, 0, SCREEN_W);
+#endif
+  vgactl_port_base[1] = 1;
+  vga_update_screen();
+}
+#endif
+
 void init_vga() {
   vgactl_port_base = (uint32_t *)new_space(8);
   vgactl_port_base[0] = (screen_width() << 16) | screen_height();
@@ -86,7 +548,15 @@ void init_vga() {
 #endif
 
   vmem = new_space(screen_size());
-  add_mmio_map("vmem", CONFIG_FB_ADDR, vmem, screen_size(), NULL);
-  IFDEF(CONFIG_VGA_SHOW_SCREEN, init_screen());
+  add_mmio_map("vmem", CONFIG_FB_ADDR, vmem, screen_size(),
+      MUXDEF(CONFIG_VGA_SHOW_SCREEN, vmem_callback(), NULL));
   IFDEF(CONFIG_VGA_SHOW_SCREEN, memset(vmem, 0, screen_size()));
+  IFDEF(CONFIG_SNAPSHOT, snapshot_register("vga", vga_snapshot));
+  dev_event_periodic(dev_event_new("vga", vga_event, NULL), 1000000 / TIMER_HZ);
+#ifdef CONFIG_VGA_ACCEL
+  // only the pages touched are backed by the host
+  gmem = calloc(2, GMEM_SIZE);
+  assert(gmem != NULL);
+  gscratch = gmem + GMEM_SIZE;
+#endif
 }
@@ -0,0 +1,112 @@
+/***************************************************************************************
+* Copyright (c) 2014-2024 Zihao Yu, Nanjing University
+*
+* NEMU is licensed under Mulan PSL v2.
+* You can use this software according to the terms and conditions of the Mulan PSL v2.
+* You may obtain a copy of Mulan PSL v2 at:
+*          http://license.coscl.org.cn/MulanPSL2
+*
+* THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+* EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+* MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+*
+* See the Mulan PSL v2 for more details.
+***************************************************************************************/
+
+
+#include <block.h>
+
+#define NR_BLOCK (64 * 1024)
+#define BLOCK_TABLE_SIZE (16 * 1024)
+
+static Block pool[NR_BLOCK] = {};
+static int nr_block = 0;
+static Block *table[BLOCK_TABLE_SIZE] = {};
+uint32_t block_nr_flush = 0;
+
+static inline int block_hash(vaddr_t pc) {
+  return (pc >> MUXDEF(CONFIG_ISA_x86, 0, 2)) % BLOCK_TABLE_SIZE;
+}
+
+Block* block_lookup(vaddr_t pc) {
+  Block *b = table[block_hash(pc)];
+  return (b != NULL && b->pc == pc ? b : NULL);
+}
+
+// Note that a caller may still hold a pointer to a block allocated before
+// flushing. Such a pointer is harmless, since the memory of the pool is
+// never freed, and the pc of every block dropped matches no pc until the
+// block is allocated again. The instructions of the block being run are
+// freed on the next allocation, after it returns.
+void block_flush() {
+  memset(table, 0, sizeof(table));
+  int i;
+  for (i = 0; i < nr_block; i ++) pool[i].pc = BLOCK_INVALID_PC;
+  nr_block = 0;
+  block_nr_flush ++;
+}
+
+/* Drop the recorded blocks overlapping the page at `page`, whose copies of
+ * the instructions may be stale. The superblocks containing them take a side
+ * exit there from now on. A block being recorded is not recorded, see
+ * `block_nr_flush`. */
+void block_flush_page(paddr_t page) {
+  int i;
+  for (i = 0; i < nr_block; i ++) {
+    Block *b = &pool[i];
+    if (b->ninst == 0 || b->pc == BLOCK_INVALID_PC || b->end <= page || b->pc >= page + PAGE_SIZE) continue;
+    Block **slot = &table[block_hash(b->pc)];
+    if (*slot == b) *slot = NULL;
+    b->pc = BLOCK_INVALID_PC;
+  }
+  block_nr_flush ++;
+}
+
+/* Make the recorded blocks running across `pc` record again, so that they
+ * are split before it, e.g. for a new breakpoint at `pc`. Other blocks and
+ * the superblocks stay, unlike block_flush(). */
+void block_split(vaddr_t pc) {
+  int i;
+  for (i = 0; i < nr_block; i ++) {
+    Block *b = &pool[i];
+    if (b->ninst != 0 && b->pc < pc && pc < b->end) b->ninst = 0;
+  }
+}
+
+Block* block_new(vaddr_t pc) {
+#ifdef CONFIG_FOOTPRINT
+  static bool accounted = false;
+  if (!accounted) {
+    FOOTPRINT("block cache", pool, sizeof(pool));
+    FOOTPRINT("block cache", table, sizeof(table));
+    accounted = true;
+  }
+#endif
+  if (nr_block == NR_BLOCK) block_flush();
+  Block *b = &pool[nr_block ++];
+  free(b->inst);
+  *b = (Block) { .pc = pc };
+  table[block_hash(pc)] = b;
+  return b;
+}
+
+void block_record(Block *b, const BlockInst *inst, uint32_t ninst, vaddr_t end) {
+  b->inst = realloc(b->inst, sizeof(*inst) * ninst);
+  assert(b->inst != NULL);
+  memcpy(b->inst, inst, sizeof(*inst) * ninst);
+  b->ninst = ninst;
+  b->end = end;
+}
+
+void block_form_super(Block *b) {
+  uint32_t ninst = b->ninst, n = 0;
+  Block *s;
+  for (s = b->succ; s != NULL && s != b && n < SUPER_MAX_BLOCK; s = s->succ) {
+    // a loop back to the head is left to the dispatching loop
+    if (s->ninst == 0 || ninst + s->ninst > SUPER_MAX_INST) break;
+    b->super[n ++] = s;
+    ninst += s->ninst;
+  }
+  b->nsuper = n;
+  b->nr_exit = 0;
+}
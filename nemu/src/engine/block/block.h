@@ -0,0 +1,82 @@
+/***************************************************************************************
+* Copyright (c) 2014-2024 Zihao Yu, Nanjing University
+*
+* NEMU is licensed under Mulan PSL v2.
+* You can use this software according to the terms and conditions of the Mulan PSL v2.
+* You may obtain a copy of Mulan PSL v2 at:
+*          http://license.coscl.org.cn/MulanPSL2
+*
+* THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+* EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+* MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+*
+* See the Mulan PSL v2 for more details.
+***************************************************************************************/
+
+
+#ifndef __ENGINE_BLOCK_H__
+#define __ENGINE_BLOCK_H__
+
+#include <common.h>
+#include <isa.h>
+#include <memory/vaddr.h>
+
+/* A block is a run of guest instructions starting at `pc` which was last seen
+ * executing straight through, i.e. only its final instruction transferred
+ * control. It is recorded by executing the instructions with isa_exec_once(),
+ * which keeps copies of them as decoded, and later runs these copies back to
+ * back, leaving early whenever one of them does not fall through. The blocks
+ * overlapping a page of code are dropped once the guest writes to the page.
+ */
+#define BLOCK_MAX_INST 256
+#define BLOCK_INVALID_PC ((vaddr_t)-1) // of the blocks dropped, never matches
+
+/* Blocks executed BLOCK_HOT_THRESHOLD times become the head of a superblock,
+ * which also contains the blocks along the most taken successors. The blocks
+ * of a superblock are executed one after another without going back to the
+ * dispatching loop, and execution leaves the superblock from a side exit
+ * once the guest goes another way. A superblock taking too many side exits
+ * is dissolved, and formed again along the new hot path later.
+ */
+#define BLOCK_HOT_THRESHOLD 64
+#define SUPER_MAX_BLOCK 8
+#define SUPER_MAX_INST 1024
+
+typedef struct Block {
+  vaddr_t pc;
+  uint32_t ninst;     // 0 if the block is not recorded yet
+  vaddr_t end;        // the pc after the final instruction, once recorded
+  BlockInst *inst;    // the `ninst` instructions, once recorded
+  struct Block *next; // the block executed right after this one last time
+
+  uint32_t count;     // number of executions as a head
+  uint32_t vote;      // confidence of `succ`
+  struct Block *succ; // the most taken successor, by majority vote
+
+  uint32_t nsuper;    // number of blocks following the head in the superblock
+  uint32_t nr_exit;   // number of side exits taken
+  struct Block *super[SUPER_MAX_BLOCK];
+#ifdef CONFIG_COVERAGE
+  uint8_t cov_way;    // the ways of the final instruction seen, 1 for falling through and 2 for taken
+#endif
+} Block;
+
+// incremented by each flush, so that a block whose recording saw one is not
+// recorded with the instructions saved before
+extern uint32_t block_nr_flush;
+
+Block* block_lookup(vaddr_t pc);
+Block* block_new(vaddr_t pc);
+void block_flush();
+void block_flush_page(paddr_t page);
+void block_split(vaddr_t pc);
+void block_record(Block *b, const BlockInst *inst, uint32_t ninst, vaddr_t end);
+void block_form_super(Block *b);
+
+static inline void block_vote(Block *b, Block *succ) {
+  if (b->succ == succ) { if (b->vote < BLOCK_HOT_THRESHOLD) b->vote ++; }
+  else if (b->vote == 0) { b->succ = succ; b->vote = 1; }
+  else b->vote --;
+}
+
+#endif
@@ -15,3 +15,7 @@
 
 INC_PATH += $(NEMU_HOME)/src/engine/$(ENGINE)
 DIRS-y += src/engine/$(ENGINE)
+
+# the block engine and the JIT still execute instructions with the interpreter
+DIRS-$(CONFIG_ENGINE_BLOCK) += src/engine/interpreter
+DIRS-$(CONFIG_ENGINE_JIT) += src/engine/interpreter
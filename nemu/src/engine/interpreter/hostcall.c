@@ -47,5 +47,462 @@ void invalid_inst(vaddr_t thispc) {
         "* The machine is always right!\n"
         "* Every line of untested code is always wrong!\n\n", ANSI_FG_RED), isa_logo);
 
+  IFDEF(CONFIG_IQUEUE, void iqueue_dump(); iqueue_dump());
   set_nemu_state(NEMU_ABORT, thispc, -1);
 }
+
+#ifdef CONFIG_SEMIHOSTING
+#include <memory/paddr.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+/* The operations of the RISC-V (ARM compatible) semihosting used here. The
+ * parameter block is an array of words, and the result is returned in a0.
+ * Handles given to the guest index `sh_fd`, so that the guest can not close
+ * the files NEMU itself is using. */
+enum {
+  SYS_OPEN = 0x01, SYS_CLOSE = 0x02, SYS_WRITEC = 0x03, SYS_WRITE0 = 0x04,
+  SYS_WRITE = 0x05, SYS_READ = 0x06, SYS_ISTTY = 0x09, SYS_SEEK = 0x0a,
+  SYS_FLEN = 0x0c, SYS_ERRNO = 0x13,
+};
+
+#define NR_SH_FD 64
+static int sh_fd[NR_SH_FD];
+static int sh_errno = 0;
+
+static void *sh_range(paddr_t addr, uint64_t len) {
+  if (len == 0) len = 1;
+  if (!in_pmem(addr) || !in_pmem(addr + len - 1) || addr + len - 1 < addr) return NULL;
+  // the range may be passed to a system call
+  paddr_host_access(addr, len);
+  return guest_to_host(addr);
+}
+
+static bool sh_args(paddr_t addr, word_t *arg, int n) {
+  void *p = sh_range(addr, sizeof(word_t) * n);
+  if (p == NULL) return false;
+  memcpy(arg, p, sizeof(word_t) * n);
+  return true;
+}
+
+static int sh_host_fd(word_t handle) {
+  return (handle > 0 && handle < NR_SH_FD && sh_fd[handle] > 0 ? sh_fd[handle] - 1 : -1);
+}
+
+static word_t sh_error(int err) {
+  sh_errno = err;
+  return -1;
+}
+
+static word_t sh_open(const char *name, word_t mode) {
+  // the modes of fopen(): r, rb, r+, r+b, w, wb, w+, w+b, a, ab, a+, a+b
+  static const int flags[] = { O_RDONLY, O_RDWR, O_WRONLY | O_CREAT | O_TRUNC,
+    O_RDWR | O_CREAT | O_TRUNC, O_WRONLY | O_CREAT | O_APPEND, O_RDWR | O_CREAT | O_APPEND };
+  if (mode >= 12) return sh_error(EINVAL);
+  int fd;
+  if (strcmp(name, ":tt") == 0) fd = dup(mode < 4 ? STDIN_FILENO : STDOUT_FILENO);
+  else fd = open(name, flags[mode / 2], 0644);
+  if (fd < 0) return sh_error(errno);
+  int i;
+  for (i = 1; i < NR_SH_FD; i ++) {
+    if (sh_fd[i] == 0) { sh_fd[i] = fd + 1; return i; }
+  }
+  close(fd);
+  return sh_error(EMFILE);
+}
+
+// move `len` bytes between the file and the guest buffer, and return the number of bytes not moved
+static word_t sh_rw(int fd, paddr_t buf, word_t len, bool is_write) {
+  uint8_t *p = sh_range(buf, len);
+  if (p == NULL) { sh_errno = EFAULT; return len; }
+  word_t done = 0;
+  while (done < len) {
+    ssize_t n = (is_write ? write(fd, p + done, len - done) : read(fd, p + done, len - done));
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) { if (n < 0) sh_errno = errno; break; }
+    done += n;
+  }
+  if (!is_write && done > 0) paddr_host_written(buf, done);
+  return len - done;
+}
+
+#ifdef CONFIG_PV_MEM
+/* NEMU's own operations, in the range left to applications by semihosting.
+ * klib asks for bulk copies and fills of at least a few dozen bytes with
+ * dst, src (or the byte to fill) and n in a1, a2 and a3. A non-zero result
+ * tells the guest to do the work itself, since a range is not in pmem. */
+enum { PV_MEMCPY = 0x100, PV_MEMSET = 0x101, PV_MEMMOVE = 0x102 };
+
+static word_t pv_mem(word_t op, paddr_t dst, word_t src, word_t n) {
+  if (n == 0) return 0;
+  uint8_t *d = sh_range(dst, n);
+  uint8_t *s = (op == PV_MEMSET ? NULL : sh_range(src, n));
+  if (d == NULL || (op != PV_MEMSET && s == NULL)) return 1;
+  switch (op) {
+    case PV_MEMCPY:  memcpy(d, s, n); break;
+    case PV_MEMMOVE: memmove(d, s, n); break;
+    default:         memset(d, src, n); break;
+  }
+  // the written range is also copied to the reference of DiffTest here
+  paddr_host_written(dst, n);
+  // credit the instructions of the loop in klib, so that statistics and
+  // the virtual time do not depend on whether the host did the work
+  extern uint64_t g_nr_guest_inst;
+  g_nr_guest_inst += (uint64_t)n * CONFIG_PV_MEM_CREDIT / 16;
+  return 0;
+}
+#endif
+
+word_t semihost_call(word_t op, word_t arg, word_t arg2, word_t arg3) {
+  // the reference does not know semihosting, take over the registers and pmem
+  difftest_skip_ref();
+#ifdef CONFIG_PV_MEM
+  if (op >= PV_MEMCPY && op <= PV_MEMMOVE) return pv_mem(op, arg, arg2, arg3);
+#endif
+  static const int nr_arg[] = { [SYS_OPEN] = 3, [SYS_CLOSE] = 1, [SYS_WRITE] = 3,
+    [SYS_READ] = 3, [SYS_ISTTY] = 1, [SYS_SEEK] = 2, [SYS_FLEN] = 1 };
+  word_t a[3] = {};
+  int n = (op < ARRLEN(nr_arg) ? nr_arg[op] : 0);
+  if (n > 0 && !sh_args(arg, a, n)) return sh_error(EFAULT);
+  int fd = sh_host_fd(a[0]);
+
+  switch (op) {
+    case SYS_OPEN: {
+      // a[1] is the mode, and a[2] is the length of the name without '\0'
+      char *name = sh_range(a[0], (uint64_t)a[2] + 1);
+      if (name == NULL || name[a[2]] != '\0') return sh_error(EFAULT);
+      return sh_open(name, a[1]);
+    }
+    case SYS_CLOSE:
+      if (fd < 0) return sh_error(EBADF);
+      sh_fd[a[0]] = 0;
+      return (close(fd) == 0 ? 0 : sh_error(errno));
+    case SYS_WRITEC: {
+      uint8_t *c = sh_range(arg, 1);
+      if (c != NULL) { putchar(*c); fflush(stdout); }
+      return 0;
+    }
+    case SYS_WRITE0: {
+      char *s = sh_range(arg, 1);
+      if (s == NULL) return sh_error(EFAULT);
+      size_t max = CONFIG_MBASE + CONFIG_MSIZE - arg;
+      fwrite(s, strnlen(s, max), 1, stdout);
+      fflush(stdout);
+      return 0;
+    }
+    case SYS_WRITE:
+    case SYS_READ:
+      if (fd < 0) { sh_errno = EBADF; return a[2]; }
+      return sh_rw(fd, a[1], a[2], op == SYS_WRITE);
+    case SYS_ISTTY:
+      if (fd < 0) return sh_error(EBADF);
+      return isatty(fd);
+    case SYS_SEEK:
+      if (fd < 0) return sh_error(EBADF);
+      return (lseek(fd, a[1], SEEK_SET) == (off_t)a[1] ? 0 : sh_error(errno));
+    case SYS_FLEN: {
+      struct stat st;
+      if (fd < 0) return sh_error(EBADF);
+      return (fstat(fd, &st) == 0 ? st.st_size : sh_error(errno));
+    }
+    case SYS_ERRNO: return sh_errno;
+    default:
+      Log_warn("Unsupported semihosting operation 0x%x at pc = " FMT_WORD, (int)op, cpu.pc);
+      return sh_error(ENOSYS);
+  }
+}
+#endif
+
+#ifdef CONFIG_MODE_USER
+#include <memory/paddr.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/random.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/time.h>
+#include <sys/uio.h>
+#include <sys/utsname.h>
+
+/* The system calls of Linux on riscv. Their numbers, flags and errno values
+ * are those of asm-generic, which are also used by the x86-64 host, so that
+ * they are passed through, and only the structures containing words or
+ * guest pointers are converted. The guest runs on a single thread without
+ * signals, and its mappings are taken from below the stack without ever
+ * being reused. */
+enum {
+  NR_getcwd = 17, NR_fcntl = 25, NR_ioctl = 29, NR_faccessat = 48, NR_openat = 56,
+  NR_close = 57, NR_lseek = 62, NR_read = 63, NR_write = 64, NR_readv = 65,
+  NR_writev = 66, NR_pread64 = 67, NR_pwrite64 = 68, NR_readlinkat = 78,
+  NR_newfstatat = 79, NR_fstat = 80, NR_exit = 93, NR_exit_group = 94,
+  NR_set_tid_address = 96, NR_futex = 98, NR_set_robust_list = 99,
+  NR_clock_gettime = 113, NR_sched_yield = 124, NR_kill = 129, NR_tgkill = 131,
+  NR_rt_sigaction = 134, NR_rt_sigprocmask = 135, NR_uname = 160,
+  NR_gettimeofday = 169, NR_getpid = 172, NR_getppid = 173, NR_getuid = 174,
+  NR_geteuid = 175, NR_getgid = 176, NR_getegid = 177, NR_gettid = 178,
+  NR_brk = 214, NR_munmap = 215, NR_mremap = 216, NR_mmap = 222,
+  NR_mprotect = 226, NR_madvise = 233, NR_prlimit64 = 261, NR_getrandom = 278,
+  NR_statx = 291, NR_clock_gettime64 = 403, NR_futex_time64 = 422,
+};
+
+#define USER_PAGE_ALIGN(x) (((x) + 4095) & ~(word_t)4095)
+
+static paddr_t user_brk_start = 0, user_brk = 0;
+static paddr_t user_mmap_top = 0, user_stack_bottom = 0;
+
+// called by the loader with the end of the segments and the bottom of the stack
+void user_init_mem(paddr_t brk, paddr_t stack_bottom) {
+  user_brk_start = user_brk = brk;
+  user_mmap_top = user_stack_bottom = stack_bottom;
+}
+
+static void *user_ptr(word_t addr, uint64_t len) {
+  if (len == 0) len = 1;
+  if (!in_pmem(addr) || !in_pmem(addr + len - 1) || addr + len - 1 < addr) return NULL;
+  paddr_host_access(addr, len);
+  return guest_to_host(addr);
+}
+
+static const char *user_str(word_t addr) {
+  char *s = user_ptr(addr, 1);
+  if (s == NULL || strnlen(s, PMEM_RIGHT - addr + 1) > PMEM_RIGHT - addr) return NULL;
+  return s;
+}
+
+// the result of a host call returning -1 with errno on failures
+static word_t user_ret(long ret) {
+  return (ret < 0 ? -(word_t)errno : (word_t)ret);
+}
+
+// copy `len` bytes of the host to the guest
+static word_t user_put(word_t addr, const void *buf, size_t len) {
+  void *p = user_ptr(addr, len);
+  if (p == NULL) return -(word_t)EFAULT;
+  memcpy(p, buf, len);
+  paddr_host_written(addr, len);
+  return 0;
+}
+
+static word_t user_rw(int fd, word_t buf, word_t len, bool is_write, long off) {
+  void *p = user_ptr(buf, len);
+  if (p == NULL) return -(word_t)EFAULT;
+  ssize_t n;
+  if (off < 0) n = (is_write ? write(fd, p, len) : read(fd, p, len));
+  else n = (is_write ? pwrite(fd, p, len, off) : pread(fd, p, len, off));
+  if (!is_write && n > 0) paddr_host_written(buf, n);
+  return user_ret(n);
+}
+
+static word_t user_rwv(int fd, word_t iov, word_t nr, bool is_write) {
+  if (nr > 1024) return -(word_t)EINVAL; // UIO_MAXIOV
+  word_t *giov = user_ptr(iov, sizeof(word_t) * 2 * nr);
+  if (giov == NULL) return -(word_t)EFAULT;
+  struct iovec hiov[nr + 1];
+  word_t i;
+  for (i = 0; i < nr; i ++) {
+    hiov[i].iov_base = user_ptr(giov[2 * i], giov[2 * i + 1]);
+    hiov[i].iov_len = giov[2 * i + 1];
+    if (hiov[i].iov_base == NULL) return -(word_t)EFAULT;
+  }
+  ssize_t n = (is_write ? writev(fd, hiov, nr) : readv(fd, hiov, nr));
+  if (!is_write) {
+    for (i = 0; i < nr && n > 0; i ++) paddr_host_written(giov[2 * i], giov[2 * i + 1]);
+  }
+  return user_ret(n);
+}
+
+// struct stat of asm-generic, used by 64-bit guests
+static word_t user_stat(word_t addr, const struct stat *st) {
+  struct {
+    uint64_t dev, ino;
+    uint32_t mode, nlink, uid, gid;
+    uint64_t rdev, pad1;
+    int64_t size;
+    int32_t blksize, pad2;
+    int64_t blocks;
+    int64_t atime, atime_ns, mtime, mtime_ns, ctime, ctime_ns;
+    uint32_t unused[2];
+  } g = {
+    .dev = st->st_dev, .ino = st->st_ino, .mode = st->st_mode, .nlink = st->st_nlink,
+    .uid = st->st_uid, .gid = st->st_gid, .rdev = st->st_rdev, .size = st->st_size,
+    .blksize = st->st_blksize, .blocks = st->st_blocks,
+    .atime = st->st_atim.tv_sec, .atime_ns = st->st_atim.tv_nsec,
+    .mtime = st->st_mtim.tv_sec, .mtime_ns = st->st_mtim.tv_nsec,
+    .ctime = st->st_ctim.tv_sec, .ctime_ns = st->st_ctim.tv_nsec,
+  };
+  return user_put(addr, &g, sizeof(g));
+}
+
+static word_t user_mmap(word_t addr, word_t len, word_t flags, int fd, uint64_t off) {
+  len = USER_PAGE_ALIGN(len);
+  if (len == 0) return -(word_t)EINVAL;
+  if (flags & MAP_FIXED) {
+    if (user_ptr(addr, len) == NULL) return -(word_t)ENOMEM;
+  } else {
+    if (len > user_mmap_top - user_brk) return -(word_t)ENOMEM;
+    addr = user_mmap_top -= len;
+  }
+  uint8_t *p = guest_to_host(addr);
+  memset(p, 0, len);
+  if (!(flags & MAP_ANONYMOUS) && pread(fd, p, len, off) < 0) return -(word_t)errno;
+  paddr_host_written(addr, len);
+  return addr;
+}
+
+static word_t user_brk_set(word_t addr) {
+  if (addr >= user_brk_start && addr <= user_mmap_top) {
+    // the memory given back may be taken again, which should be zero
+    if (addr > user_brk) {
+      memset(guest_to_host(user_brk), 0, addr - user_brk);
+      paddr_host_written(user_brk, addr - user_brk);
+    }
+    user_brk = addr;
+  }
+  return user_brk;
+}
+
+static word_t user_uname(word_t addr) {
+  struct utsname u;
+  uname(&u);
+  snprintf(u.nodename, sizeof(u.nodename), "nemu");
+  snprintf(u.machine, sizeof(u.machine), MUXDEF(CONFIG_ISA64, "riscv64", "riscv32"));
+  return user_put(addr, &u, sizeof(u));
+}
+
+static void user_exit(int code) {
+  set_nemu_state(NEMU_END, cpu.pc, code);
+}
+
+word_t user_syscall(word_t nr, word_t a0, word_t a1, word_t a2, word_t a3, word_t a4, word_t a5) {
+  // the reference knows no system calls, take over the registers and pmem
+  difftest_skip_ref();
+  switch (nr) {
+    case NR_read: return user_rw(a0, a1, a2, false, -1);
+    case NR_write: return user_rw(a0, a1, a2, true, -1);
+    case NR_pread64: return user_rw(a0, a1, a2, false, a3);
+    case NR_pwrite64: return user_rw(a0, a1, a2, true, a3);
+    case NR_readv: return user_rwv(a0, a1, a2, false);
+    case NR_writev: return user_rwv(a0, a1, a2, true);
+    case NR_openat: {
+      const char *path = user_str(a1);
+      return (path == NULL ? -(word_t)EFAULT : user_ret(openat((int)a0, path, a2, a3)));
+    }
+    // keep stdin, stdout and stderr of NEMU
+    case NR_close: return (a0 <= 2 ? 0 : user_ret(close(a0)));
+    case NR_lseek:
+#ifdef CONFIG_ISA64
+      return user_ret(lseek(a0, a1, a2));
+#else
+    { // llseek with the offset in two words and the result to a3
+      off_t off = lseek(a0, ((uint64_t)a1 << 32) | a2, a4);
+      if (off < 0) return -(word_t)errno;
+      uint64_t res = off;
+      return user_put(a3, &res, sizeof(res));
+    }
+#endif
+    case NR_faccessat: {
+      const char *path = user_str(a1);
+      return (path == NULL ? -(word_t)EFAULT : user_ret(faccessat((int)a0, path, a2, 0)));
+    }
+    case NR_readlinkat: {
+      const char *path = user_str(a1);
+      char *buf = user_ptr(a2, a3);
+      if (path == NULL || buf == NULL) return -(word_t)EFAULT;
+      word_t ret = user_ret(readlinkat((int)a0, path, buf, a3));
+      if ((sword_t)ret > 0) paddr_host_written(a2, ret);
+      return ret;
+    }
+    case NR_getcwd: {
+      char *buf = user_ptr(a0, a1);
+      if (buf == NULL) return -(word_t)EFAULT;
+      if (getcwd(buf, a1) == NULL) return -(word_t)errno;
+      paddr_host_written(a0, strlen(buf) + 1);
+      return strlen(buf) + 1;
+    }
+    case NR_fcntl: return user_ret(fcntl(a0, a1, a2));
+    case NR_ioctl: {
+      // only the queries of isatty() and the size of the terminal
+      uint8_t buf[64];
+      if (a1 != TCGETS && a1 != TIOCGWINSZ) return -(word_t)ENOTTY;
+      long ret = syscall(SYS_ioctl, (int)a0, a1, buf);
+      if (ret < 0) return -(word_t)errno;
+      return user_put(a2, buf, a1 == TCGETS ? 36 : sizeof(struct winsize));
+    }
+    case NR_fstat: {
+      struct stat st;
+      return (fstat(a0, &st) < 0 ? -(word_t)errno : user_stat(a1, &st));
+    }
+    case NR_newfstatat: {
+      struct stat st;
+      const char *path = user_str(a1);
+      if (path == NULL) return -(word_t)EFAULT;
+      return (fstatat((int)a0, path, &st, a3) < 0 ? -(word_t)errno : user_stat(a2, &st));
+    }
+    case NR_statx: {
+      // struct statx of 256 bytes has the same layout on all architectures
+      uint8_t stx[256];
+      const char *path = user_str(a1);
+      if (path == NULL) return -(word_t)EFAULT;
+      long ret = syscall(SYS_statx, (int)a0, path, (int)a2, (unsigned)a3, stx);
+      return (ret < 0 ? -(word_t)errno : user_put(a4, stx, sizeof(stx)));
+    }
+    case NR_exit:
+    case NR_exit_group: user_exit(a0); return 0;
+    case NR_kill:
+    case NR_tgkill: user_exit(128 + (nr == NR_kill ? a1 : a2)); return 0;
+    case NR_brk: return user_brk_set(a0);
+    case NR_mmap: return user_mmap(a0, a1, a3, a4, (uint64_t)a5 * MUXDEF(CONFIG_ISA64, 1, 4096));
+    case NR_munmap:
+      if (a0 == user_mmap_top) user_mmap_top += USER_PAGE_ALIGN(a1);
+      return 0;
+    case NR_mremap: return -(word_t)ENOMEM;
+    case NR_mprotect: case NR_madvise: case NR_set_robust_list:
+    case NR_rt_sigaction: case NR_rt_sigprocmask: case NR_sched_yield:
+      return 0;
+    // a single thread never waits for a futex
+    case NR_futex: case NR_futex_time64:
+      return ((a1 & 0x7f) == 0 ? -(word_t)EAGAIN : 0);
+    case NR_clock_gettime:
+    case NR_clock_gettime64: {
+      // struct timespec of 64-bit time
+      struct timespec ts;
+      if (clock_gettime(a0, &ts) < 0) return -(word_t)errno;
+      int64_t t[2] = { ts.tv_sec, ts.tv_nsec };
+      return user_put(a1, t, sizeof(t));
+    }
+    case NR_gettimeofday: {
+      struct timeval tv;
+      gettimeofday(&tv, NULL);
+      int64_t t[2] = { tv.tv_sec, tv.tv_usec };
+      return (a0 == 0 ? 0 : user_put(a0, t, sizeof(t)));
+    }
+    case NR_uname: return user_uname(a0);
+    case NR_prlimit64: {
+      if (a3 == 0) return 0;
+      uint64_t lim[2] = { RLIM_INFINITY, RLIM_INFINITY };
+      if (a1 == RLIMIT_STACK) lim[0] = PMEM_RIGHT + 1 - user_stack_bottom;
+      return user_put(a3, lim, sizeof(lim));
+    }
+    case NR_getrandom: {
+      void *buf = user_ptr(a0, a1);
+      if (buf == NULL) return -(word_t)EFAULT;
+      word_t ret = user_ret(getrandom(buf, a1, a2));
+      if ((sword_t)ret > 0) paddr_host_written(a0, ret);
+      return ret;
+    }
+    case NR_set_tid_address: case NR_getpid: case NR_gettid: return 1;
+    case NR_getppid: return 0;
+    case NR_getuid: case NR_geteuid: case NR_getgid: case NR_getegid: return 0;
+    default:
+      Log_warn("Unsupported system call %d at pc = " FMT_WORD, (int)nr, cpu.pc);
+      return -(word_t)ENOSYS;
+  }
+}
+#endif
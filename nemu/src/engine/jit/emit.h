@@ -0,0 +1,109 @@
+/***************************************************************************************
+* Copyright (c) 2014-2024 Zihao Yu, Nanjing University
+*
+* NEMU is licensed under Mulan PSL v2.
+* You can use this software according to the terms and conditions of the Mulan PSL v2.
+* You may obtain a copy of Mulan PSL v2 at:
+*          http://license.coscl.org.cn/MulanPSL2
+*
+* THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+* EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+* MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+*
+* See the Mulan PSL v2 for more details.
+***************************************************************************************/
+
+
+#ifndef __ENGINE_JIT_EMIT_H__
+#define __ENGINE_JIT_EMIT_H__
+
+#include <common.h>
+
+// A tiny x86-64 emitter, only covering the encodings used by translate.c.
+// Registers are named by their encoding in ModRM.
+
+enum { EAX, ECX, EDX, EBX, ESP, EBP, ESI, EDI };
+enum { R12 = 4, R13 = 5 }; // with REX.B
+
+extern uint8_t *jit_code;
+
+static inline void emit8(uint8_t b) { *jit_code ++ = b; }
+static inline void emit32(uint32_t w) { memcpy(jit_code, &w, 4); jit_code += 4; }
+static inline void emit64(uint64_t d) { memcpy(jit_code, &d, 8); jit_code += 8; }
+
+#define emit_bytes(...) do { \
+  const uint8_t __b[] = { __VA_ARGS__ }; \
+  memcpy(jit_code, __b, sizeof(__b)); jit_code += sizeof(__b); \
+} while (0)
+
+// mov r32, [rbx + disp32]
+static inline void emit_load_rbx(int r, uint32_t disp) { emit_bytes(0x8b, 0x83 | (r << 3)); emit32(disp); }
+// mov [rbx + disp32], r32
+static inline void emit_store_rbx(int r, uint32_t disp) { emit_bytes(0x89, 0x83 | (r << 3)); emit32(disp); }
+// mov dword [rbx + disp32], imm32
+static inline void emit_storei_rbx(uint32_t disp, uint32_t imm) { emit_bytes(0xc7, 0x83); emit32(disp); emit32(imm); }
+// mov r32, imm32
+static inline void emit_movi(int r, uint32_t imm) { emit8(0xb8 + r); emit32(imm); }
+// mov dst, src (32-bit)
+static inline void emit_mov(int dst, int src) { emit_bytes(0x89, 0xc0 | (src << 3) | dst); }
+// add/sub/and/cmp r32, imm32
+static inline void emit_alui(int op, int r, uint32_t imm) { emit_bytes(0x81, 0xc0 | (op << 3) | r); emit32(imm); }
+enum { ALU_ADD = 0, ALU_AND = 4, ALU_SUB = 5, ALU_CMP = 7 };
+// shr r32, imm8
+static inline void emit_shri(int r, uint8_t imm) { emit_bytes(0xc1, 0xe8 | r, imm); }
+// test r32, r32
+static inline void emit_test(int r) { emit_bytes(0x85, 0xc0 | (r << 3) | r); }
+// movabs r64, imm64, for the registers without REX.B
+static inline void emit_movabs(int r, uint64_t imm) { emit_bytes(0x48, 0xb8 + r); emit64(imm); }
+// movabs r12/r13, imm64
+static inline void emit_movabs_ext(int r, uint64_t imm) { emit_bytes(0x49, 0xb8 + r); emit64(imm); }
+// call a C function through rax
+static inline void emit_call(void *f) { emit_movabs(EAX, (uintptr_t)f); emit_bytes(0xff, 0xd0); }
+
+// loads and stores of guest pmem, addressed by [r12 + rcx]
+static inline void emit_pmem_load(int len) {
+  switch (len) {
+    case 1: emit_bytes(0x41, 0x0f, 0xb6, 0x04, 0x0c); break; // movzx eax, byte [r12 + rcx]
+    case 2: emit_bytes(0x41, 0x0f, 0xb7, 0x04, 0x0c); break; // movzx eax, word [r12 + rcx]
+    case 4: emit_bytes(0x41, 0x8b, 0x04, 0x0c); break;       // mov eax, [r12 + rcx]
+    default: panic("bad len = %d", len);
+  }
+}
+
+static inline void emit_pmem_store(int len) {
+  switch (len) {
+    case 1: emit_bytes(0x41, 0x88, 0x14, 0x0c); break;       // mov [r12 + rcx], dl
+    case 2: emit_bytes(0x66, 0x41, 0x89, 0x14, 0x0c); break; // mov [r12 + rcx], dx
+    case 4: emit_bytes(0x41, 0x89, 0x14, 0x0c); break;       // mov [r12 + rcx], edx
+    default: panic("bad len = %d", len);
+  }
+}
+
+// cmp byte [r13 + rdx], 0
+static inline void emit_check_code_page() { emit_bytes(0x41, 0x80, 0x7c, 0x15, 0x00, 0x00); }
+
+// bts dword [rax], edx
+static inline void emit_bts_rax() { emit_bytes(0x0f, 0xab, 0x10); }
+
+// jumps with 32-bit displacement, return the address to patch
+enum { JCC_JE = 0x84, JCC_JNE = 0x85, JCC_JA = 0x87 };
+static inline uint8_t* emit_jcc(int cc) { emit_bytes(0x0f, cc); emit32(0); return jit_code - 4; }
+static inline uint8_t* emit_jmp() { emit8(0xe9); emit32(0); return jit_code - 4; }
+static inline void patch_here(uint8_t *p) {
+  uint32_t rel = jit_code - (p + 4);
+  memcpy(p, &rel, 4);
+}
+
+// translated code keeps &cpu in rbx, pmem in r12 and pmem_code_page in r13
+static inline void emit_prologue(uint64_t cpu, uint64_t pmem, uint64_t code_page) {
+  emit_bytes(0x53, 0x41, 0x54, 0x41, 0x55); // push rbx; push r12; push r13
+  emit_movabs(EBX, cpu);
+  emit_movabs_ext(R12, pmem);
+  emit_movabs_ext(R13, code_page);
+}
+
+static inline void emit_epilogue() {
+  emit_bytes(0x41, 0x5d, 0x41, 0x5c, 0x5b, 0xc3); // pop r13; pop r12; pop rbx; ret
+}
+
+#endif
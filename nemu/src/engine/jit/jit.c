@@ -0,0 +1,137 @@
+/***************************************************************************************
+* Copyright (c) 2014-2024 Zihao Yu, Nanjing University
+*
+* NEMU is licensed under Mulan PSL v2.
+* You can use this software according to the terms and conditions of the Mulan PSL v2.
+* You may obtain a copy of Mulan PSL v2 at:
+*          http://license.coscl.org.cn/MulanPSL2
+*
+* THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+* EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+* MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+*
+* See the Mulan PSL v2 for more details.
+***************************************************************************************/
+
+
+#include <isa.h>
+#include <cpu/cpu.h>
+#include <memory/paddr.h>
+#include <memory/vaddr.h>
+#include <jit.h>
+#include <sys/mman.h>
+
+#define CODE_BUF_SIZE (16 * 1024 * 1024)
+#define TB_TABLE_SIZE (16 * 1024)
+// the longest code a TB may need
+#define TB_CODE_MAX (TB_MAX_INST * 128 + 256)
+
+static uint8_t *code_buf = NULL;
+static uint8_t *code_free = NULL;
+static TB tb_table[TB_TABLE_SIZE] = {};
+static uint64_t flush_epoch = 0;
+
+static inline TB* tb_entry(vaddr_t pc) {
+  return &tb_table[(pc >> 2) % TB_TABLE_SIZE];
+}
+
+static void jit_flush() {
+  memset(tb_table, 0, sizeof(tb_table));
+  code_free = code_buf;
+  flush_epoch ++;
+}
+
+// The blocks overlapping a page are dropped when guest writes to it. Their
+// code is only released once the buffer is full, so the translated code
+// calling this function may still return through it.
+void jit_flush_page(paddr_t page) {
+  // such a block starts less than TB_MAX_INST instructions before the page,
+  // and all these pcs fall into consecutive entries
+  vaddr_t lo = page - (TB_MAX_INST - 1) * 4;
+  int i;
+  for (i = 0; i < PAGE_SIZE / 4 + TB_MAX_INST - 1; i ++) {
+    TB *tb = tb_entry(lo + i * 4);
+    if (tb->code != NULL && tb->pc < page + PAGE_SIZE && tb->pc + tb->ninst * 4 > page) {
+      tb->code = NULL;
+      tb->hot = 0;
+    }
+  }
+  flush_epoch ++;
+}
+
+/* Drop the blocks running across `pc`, so that they are translated again
+ * ending before it, e.g. for a new breakpoint at `pc`. Other blocks stay,
+ * and a block split by a breakpoint deleted later is only shorter. */
+void jit_split(vaddr_t pc) {
+  vaddr_t lo = pc - (TB_MAX_INST - 1) * 4;
+  int i;
+  for (i = 0; i < TB_MAX_INST - 1; i ++) {
+    TB *tb = tb_entry(lo + i * 4);
+    if (tb->code != NULL && tb->pc < pc && tb->pc + tb->ninst * 4 > pc) tb->code = NULL;
+  }
+}
+
+static void init_jit() {
+  code_buf = mmap(NULL, CODE_BUF_SIZE, PROT_READ | PROT_WRITE | PROT_EXEC,
+      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  Assert(code_buf != MAP_FAILED, "Can not allocate code buffer for JIT");
+  FOOTPRINT("translation", code_buf, CODE_BUF_SIZE);
+  FOOTPRINT("translation", tb_table, sizeof(tb_table));
+  jit_flush();
+  init_jit_perf();
+}
+
+// Translated code accesses pmem by the guest addresses, so it is only
+// translated and entered while they are not translated by the MMU. Otherwise
+// the interpreter executes the instructions through vaddr_read() and
+// vaddr_write().
+static inline bool jit_mmu_direct(vaddr_t pc) {
+  return isa_mmu_check(pc, 4, MEM_TYPE_IFETCH) == MMU_DIRECT &&
+    isa_mmu_check(pc, 4, MEM_TYPE_READ) == MMU_DIRECT &&
+    isa_mmu_check(pc, 4, MEM_TYPE_WRITE) == MMU_DIRECT;
+}
+
+static bool translate(TB *tb, vaddr_t pc) {
+  // only translate code in pmem, since its translation may be out of date
+  // once guest writes to it, and such writes are tracked by paddr
+  if (!in_pmem(pc) || !in_pmem(pc + TB_MAX_INST * 4 - 1)) return false;
+  if (code_buf + CODE_BUF_SIZE - code_free < TB_CODE_MAX) jit_flush();
+
+  *tb = (TB) { .pc = pc, .ninst = 0, .hot = 0, .code = (tb_func_t)code_free };
+  code_free = jit_translate(tb, code_free, code_buf + CODE_BUF_SIZE);
+  jit_perf_code(tb, code_free);
+  return true;
+}
+
+uint64_t jit_exec(uint64_t n) {
+  if (unlikely(code_buf == NULL)) init_jit();
+
+  vaddr_t pc = cpu.pc;
+  if (!jit_mmu_direct(pc)) return 0;
+  TB *tb = tb_entry(pc);
+  if (tb->pc != pc || tb->code == NULL) {
+    if (++ tb->hot < JIT_HOT_THRESHOLD) return 0;
+    if (!translate(tb, pc)) { tb->hot = 0; return 0; }
+  }
+  // a block runs to its end, so do not enter it if it executes too much
+  if (tb->ninst > n) return 0;
+  return tb->code();
+}
+
+/* helpers called by translated code */
+
+uint32_t jit_load(vaddr_t addr, int len) {
+  return vaddr_read(addr, len);
+}
+
+// return non-zero if translated code is flushed by this store, which may be
+// the rest of the block executing it
+int jit_store(vaddr_t addr, int len, word_t data) {
+  uint64_t epoch = flush_epoch;
+  vaddr_write(addr, len, data);
+  return epoch != flush_epoch;
+}
+
+void jit_nemutrap(vaddr_t pc) {
+  NEMUTRAP(pc, cpu.gpr[10]); // $a0 holds the return value
+}
@@ -0,0 +1,52 @@
+/***************************************************************************************
+* Copyright (c) 2014-2024 Zihao Yu, Nanjing University
+*
+* NEMU is licensed under Mulan PSL v2.
+* You can use this software according to the terms and conditions of the Mulan PSL v2.
+* You may obtain a copy of Mulan PSL v2 at:
+*          http://license.coscl.org.cn/MulanPSL2
+*
+* THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+* EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+* MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+*
+* See the Mulan PSL v2 for more details.
+***************************************************************************************/
+
+
+#ifndef __ENGINE_JIT_H__
+#define __ENGINE_JIT_H__
+
+#include <common.h>
+
+/* Translated code returns the number of guest instructions it executed,
+ * after updating `cpu.pc` to the next instruction to execute. */
+typedef uint32_t (*tb_func_t)();
+
+typedef struct {
+  vaddr_t pc;
+  uint32_t ninst;
+  uint32_t hot;   // how many times `pc` was reached without translated code
+  tb_func_t code;
+} TB;
+
+#define JIT_HOT_THRESHOLD 16
+#define TB_MAX_INST 64
+
+uint64_t jit_exec(uint64_t n);
+void jit_flush_page(paddr_t page);
+void jit_split(vaddr_t pc);
+
+// translate.c
+uint8_t* jit_translate(TB *tb, uint8_t *code, uint8_t *code_end);
+
+// perf.c
+void init_jit_perf();
+void jit_perf_code(const TB *tb, const uint8_t *code_end);
+
+// jit.c, called by translated code
+uint32_t jit_load(vaddr_t addr, int len);
+int jit_store(vaddr_t addr, int len, word_t data);
+void jit_nemutrap(vaddr_t pc);
+
+#endif
@@ -0,0 +1,120 @@
+/***************************************************************************************
+* Copyright (c) 2014-2024 Zihao Yu, Nanjing University
+*
+* NEMU is licensed under Mulan PSL v2.
+* You can use this software according to the terms and conditions of the Mulan PSL v2.
+* You may obtain a copy of Mulan PSL v2 at:
+*          http://license.coscl.org.cn/MulanPSL2
+*
+* THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+* EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+* MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+*
+* See the Mulan PSL v2 for more details.
+***************************************************************************************/
+
+
+// Tell host perf about the code translated by the JIT, which is otherwise
+// shown as anonymous addresses in the code buffer.
+
+#include <common.h>
+#include <jit.h>
+#include <elf.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+#if defined(CONFIG_JIT_PERF_MAP) || defined(CONFIG_JIT_PERF_DUMP)
+static void tb_name(const TB *tb, char *buf, size_t size) {
+  vaddr_t end = tb->pc + tb->ninst * 4;
+  word_t off = 0;
+  const char *f = symbol_lookup(tb->pc, &off);
+  if (f != NULL) snprintf(buf, size, "%s+0x%x [" FMT_WORD ", " FMT_WORD ")", f, (uint32_t)off, tb->pc, end);
+  else snprintf(buf, size, "[" FMT_WORD ", " FMT_WORD ")", tb->pc, end);
+}
+#endif
+
+#ifdef CONFIG_JIT_PERF_MAP
+static FILE *perf_map = NULL;
+
+static void init_perf_map() {
+  char path[64];
+  snprintf(path, sizeof(path), "/tmp/perf-%d.map", getpid());
+  perf_map = fopen(path, "w");
+  Assert(perf_map, "Can not open '%s'", path);
+  // perf may read it at any time, even after NEMU crashes
+  setvbuf(perf_map, NULL, _IOLBF, 0);
+  Log("Translated code is named in %s", path);
+}
+#endif
+
+#ifdef CONFIG_JIT_PERF_DUMP
+// the format is defined by tools/perf/Documentation/jitdump-specification.txt of Linux
+#define JITDUMP_MAGIC 0x4A695444
+#define JIT_CODE_LOAD 0
+
+typedef struct {
+  uint32_t magic, version, total_size, elf_mach, pad1, pid;
+  uint64_t timestamp, flags;
+} JitHeader;
+
+typedef struct {
+  uint32_t id, total_size;
+  uint64_t timestamp;
+  uint32_t pid, tid;
+  uint64_t vma, code_addr, code_size, code_index;
+} JitCodeLoad;
+
+static FILE *perf_dump = NULL;
+static uint64_t code_index = 0;
+
+// perf record should use the same clock by `-k mono'
+static uint64_t timestamp() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static void init_perf_dump() {
+  char path[64];
+  snprintf(path, sizeof(path), "/tmp/jit-%d.dump", getpid());
+  perf_dump = fopen(path, "w+");
+  Assert(perf_dump, "Can not open '%s'", path);
+  // perf inject finds the file by this mapping recorded by perf record
+  void *marker = mmap(NULL, sysconf(_SC_PAGESIZE), PROT_READ | PROT_EXEC, MAP_PRIVATE, fileno(perf_dump), 0);
+  Assert(marker != MAP_FAILED, "Can not map '%s'", path);
+  JitHeader h = { .magic = JITDUMP_MAGIC, .version = 1, .total_size = sizeof(h),
+    .elf_mach = EM_X86_64, .pid = getpid(), .timestamp = timestamp() };
+  fwrite(&h, sizeof(h), 1, perf_dump);
+  fflush(perf_dump);
+  Log("Translated code is recorded in %s", path);
+}
+#endif
+
+void init_jit_perf() {
+  IFDEF(CONFIG_JIT_PERF_MAP, init_perf_map());
+  IFDEF(CONFIG_JIT_PERF_DUMP, init_perf_dump());
+}
+
+void jit_perf_code(const TB *tb, const uint8_t *code_end) {
+#if defined(CONFIG_JIT_PERF_MAP) || defined(CONFIG_JIT_PERF_DUMP)
+  char name[128];
+  tb_name(tb, name, sizeof(name));
+  uint64_t size = code_end - (uint8_t *)tb->code;
+#endif
+#ifdef CONFIG_JIT_PERF_MAP
+  fprintf(perf_map, "%lx %lx %s\n", (uintptr_t)tb->code, size, name);
+#endif
+#ifdef CONFIG_JIT_PERF_DUMP
+  size_t len = strlen(name) + 1;
+  JitCodeLoad r = { .id = JIT_CODE_LOAD, .total_size = sizeof(r) + len + size,
+    .timestamp = timestamp(), .pid = getpid(), .tid = syscall(SYS_gettid),
+    .vma = (uintptr_t)tb->code, .code_addr = (uintptr_t)tb->code,
+    .code_size = size, .code_index = code_index ++ };
+  fwrite(&r, sizeof(r), 1, perf_dump);
+  fwrite(name, len, 1, perf_dump);
+  fwrite(tb->code, size, 1, perf_dump);
+  fflush(perf_dump);
+#endif
+}
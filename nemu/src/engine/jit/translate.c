@@ -0,0 +1,170 @@
+/***************************************************************************************
+* Copyright (c) 2014-2024 Zihao Yu, Nanjing University
+*
+* NEMU is licensed under Mulan PSL v2.
+* You can use this software according to the terms and conditions of the Mulan PSL v2.
+* You may obtain a copy of Mulan PSL v2 at:
+*          http://license.coscl.org.cn/MulanPSL2
+*
+* THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+* EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+* MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+*
+* See the Mulan PSL v2 for more details.
+***************************************************************************************/
+
+
+// Translate riscv32 guest instructions into x86-64 host code.
+
+#include <isa.h>
+#include <cpu/cpu.h>
+#include <cpu/decode.h>
+#include <memory/host.h>
+#include <memory/paddr.h>
+#include <memory/vaddr.h>
+#include <cpu/breakpoint.h>
+#include <jit.h>
+#include <stddef.h>
+#include "emit.h"
+
+uint8_t *jit_code = NULL;
+
+#define GPR(i) ((uint32_t)(offsetof(CPU_state, gpr) + (i) * sizeof(word_t)))
+#define PC     ((uint32_t)offsetof(CPU_state, pc))
+
+#define immI() SEXT(BITS(inst, 31, 20), 12)
+#define immU() (SEXT(BITS(inst, 31, 12), 20) << 12)
+#define immS() ((SEXT(BITS(inst, 31, 25), 7) << 5) | BITS(inst, 11, 7))
+
+// leave the block with `ninst` instructions executed and `cpu.pc = npc`
+static void emit_exit(vaddr_t npc, uint32_t ninst) {
+  emit_storei_rbx(PC, npc);
+  emit_movi(EAX, ninst);
+  emit_epilogue();
+}
+
+static void emit_li(int rd, word_t imm) {
+  if (rd != 0) emit_storei_rbx(GPR(rd), imm);
+}
+
+// compute the guest address into eax and its offset in pmem into ecx,
+// and jump to the returned patch point if the access is not inside pmem
+static uint8_t* emit_addr(int rs1, word_t imm, int len) {
+  emit_load_rbx(EAX, GPR(rs1));
+  emit_alui(ALU_ADD, EAX, imm);
+  emit_mov(ECX, EAX);
+  emit_alui(ALU_SUB, ECX, CONFIG_MBASE);
+  emit_alui(ALU_CMP, ECX, CONFIG_MSIZE - len);
+  return emit_jcc(JCC_JA);
+}
+
+static void emit_load(int rd, int rs1, word_t imm, int len) {
+  uint8_t *slow = emit_addr(rs1, imm, len);
+  emit_pmem_load(len);
+  uint8_t *done = emit_jmp();
+
+  patch_here(slow);
+  emit_mov(EDI, EAX);
+  emit_movi(ESI, len);
+  emit_call(jit_load);
+
+  patch_here(done);
+  if (rd != 0) emit_store_rbx(EAX, GPR(rd));
+}
+
+// `ninst` instructions are executed once the store is done
+static void emit_store(int rs1, int rs2, word_t imm, int len, vaddr_t npc, uint32_t ninst) {
+  uint8_t *slow = emit_addr(rs1, imm, len);
+  uint8_t *slow2 = NULL;
+  if (len > 1) {
+    // go to the slow path if the access crosses a page
+    emit_mov(EDX, ECX);
+    emit_alui(ALU_AND, EDX, PAGE_MASK);
+    emit_alui(ALU_CMP, EDX, PAGE_SIZE - len);
+    slow2 = emit_jcc(JCC_JA);
+  }
+  emit_mov(EDX, ECX);
+  emit_shri(EDX, PAGE_SHIFT);
+  emit_check_code_page();
+  uint8_t *slow3 = emit_jcc(JCC_JNE);
+#ifdef CONFIG_PMEM_DIRTY
+  // edx is the page index in pmem
+  emit_movabs(EAX, (uintptr_t)pmem_dirty);
+  emit_bts_rax();
+#endif
+  emit_load_rbx(EDX, GPR(rs2));
+  emit_pmem_store(len);
+  uint8_t *done = emit_jmp();
+
+  patch_here(slow);
+  if (slow2) patch_here(slow2);
+  patch_here(slow3);
+  emit_mov(EDI, EAX);
+  emit_movi(ESI, len);
+  emit_load_rbx(EDX, GPR(rs2));
+  emit_call(jit_store);
+  emit_test(EAX);
+  uint8_t *not_flushed = emit_jcc(JCC_JE);
+  // the code of this block may be stale
+  emit_exit(npc, ninst);
+
+  patch_here(not_flushed);
+  patch_here(done);
+}
+
+static void emit_hostcall(void *f, vaddr_t pc) {
+  emit_movi(EDI, pc);
+  emit_call(f);
+}
+
+enum { TR_NEXT, TR_END, TR_UNSUPPORTED };
+
+// translate the instruction at `pc`, and return whether it ends the block,
+// or TR_UNSUPPORTED without translating it, for it to be interpreted
+static int translate_inst(vaddr_t pc, uint32_t inst, uint32_t ninst) {
+  int rd  = BITS(inst, 11, 7);
+  int rs1 = BITS(inst, 19, 15);
+  int rs2 = BITS(inst, 24, 20);
+  int end = TR_NEXT;
+  // compressed instructions are left to the interpreter
+  if ((inst & 3) != 3) return TR_UNSUPPORTED;
+
+#define INSTPAT_INST(s) (inst)
+#define INSTPAT_MATCH(s, name, type, ... /* translate body */ ) { __VA_ARGS__ ; }
+
+  INSTPAT_START();
+  INSTPAT("??????? ????? ????? ??? ????? 00101 11", auipc  , U, emit_li(rd, pc + immU()));
+  INSTPAT("??????? ????? ????? 100 ????? 00000 11", lbu    , I, emit_load(rd, rs1, immI(), 1));
+  INSTPAT("??????? ????? ????? 000 ????? 01000 11", sb     , S, emit_store(rs1, rs2, immS(), 1, pc + 4, ninst + 1));
+
+  INSTPAT("0000000 00001 00000 000 00000 11100 11", ebreak , N, emit_hostcall(jit_nemutrap, pc); end = TR_END);
+  INSTPAT("??????? ????? ????? ??? ????? ????? ??", inv    , N, end = TR_UNSUPPORTED);
+  INSTPAT_END();
+
+  return end;
+}
+
+uint8_t* jit_translate(TB *tb, uint8_t *code, uint8_t *code_end) {
+  jit_code = code;
+  emit_prologue((uintptr_t)&cpu, (uintptr_t)guest_to_host(CONFIG_MBASE), (uintptr_t)pmem_code_page);
+
+  vaddr_t pc = tb->pc;
+  int end = TR_NEXT;
+  while (end == TR_NEXT && tb->ninst < TB_MAX_INST) {
+    // end the block before a breakpoint, so that it is checked as a block
+    // entry, also for those suspended by fast-forwarding
+    if (tb->ninst > 0 && bp_probe(pc)) break;
+    uint32_t inst = host_read(guest_to_host(pc), 4);
+    paddr_mark_code(pc);
+    end = translate_inst(pc, inst, tb->ninst);
+    if (end == TR_UNSUPPORTED) break;
+    tb->ninst ++;
+    pc += 4;
+  }
+  // a block starting with an instruction not supported returns 0 at once,
+  // and the instruction is executed by the interpreter
+  emit_exit(pc, tb->ninst);
+
+  assert(jit_code <= code_end);
+  return jit_code;
+}
@@ -13,5 +13,34 @@
 # See the Mulan PSL v2 for more details.
 #**************************************************************************************/
 
-INC_PATH += $(NEMU_HOME)/src/isa/$(GUEST_ISA)/include
-DIRS-y += src/isa/$(GUEST_ISA)
+# riscv64 is built from the source of riscv32
+ISA_DIR = $(if $(filter riscv64,$(GUEST_ISA)),riscv32,$(GUEST_ISA))
+
+INC_PATH += $(NEMU_HOME)/src/isa/$(ISA_DIR)/include
+DIRS-y += src/isa/$(ISA_DIR)
+
+ifndef CONFIG_RVC
+SRCS-BLACKLIST-y += src/isa/$(ISA_DIR)/rvc.c
+endif
+ifndef CONFIG_RVF
+SRCS-BLACKLIST-y += src/isa/$(ISA_DIR)/fpu.c
+endif
+LIBS += $(if $(CONFIG_RVF),-lm,)
+
+# Decode with the patterns of inst.c reordered by the counts of a profile,
+# see tools/instpat-order
+INSTPAT_ORDER = $(call remove_quote,$(CONFIG_INSTPAT_ORDER))
+ifneq ($(INSTPAT_ORDER),)
+INSTPAT_ORDER_TOOL = tools/instpat-order/build/instpat-order
+INSTPAT_ORDER_SRC = build/gen-$(NAME)/inst.c
+SRCS-BLACKLIST-y += src/isa/$(ISA_DIR)/inst.c
+SRCS-y += $(INSTPAT_ORDER_SRC)
+# for the includes of inst.c relative to its directory
+CFLAGS += -iquote src/isa/$(ISA_DIR)
+$(INSTPAT_ORDER_SRC): src/isa/$(ISA_DIR)/inst.c $(INSTPAT_ORDER) $(INSTPAT_ORDER_TOOL)
+	@echo + ORDER $<
+	@mkdir -p $(dir $@)
+	@$(INSTPAT_ORDER_TOOL) $(INSTPAT_ORDER) $< > $@
+$(INSTPAT_ORDER_TOOL):
+	$(MAKE) -s -C tools/instpat-order
+endif
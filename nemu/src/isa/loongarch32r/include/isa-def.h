@@ -28,6 +28,10 @@ typedef struct {
   uint32_t inst;
 } loongarch32r_ISADecodeInfo;
 
+// INSTPAT is dispatched by the fields at bits 31:26, 25:22, 21:15 and 14:10
+// in turn, which end the opcodes of 6, 10, 17 and 22 bits
+#define INSTPAT_TREE_LEVELS 26, 22, 15, 10
+
 #define isa_mmu_check(vaddr, len, type) (MMU_DIRECT)
 
 #endif
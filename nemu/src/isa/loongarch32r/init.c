@@ -34,6 +34,12 @@ static void restart() {
   cpu.gpr[0] = 0;
 }
 
+void isa_hart_init(int id, word_t sp) {
+  /* Pass the id of the hart in $a0. */
+  cpu.gpr[4] = id;
+  cpu.gpr[3] = sp;
+}
+
 void init_isa() {
   /* Load built-in image. */
   memcpy(guest_to_host(RESET_VECTOR), img, sizeof(img));
@@ -19,8 +19,9 @@
 #include <cpu/decode.h>
 
 #define R(i) gpr(i)
-#define Mr vaddr_read
-#define Mw vaddr_write
+// the width of each access is a constant, so use the fixed-width accessors
+#define Mr(addr, len) concat(vaddr_read_, len)(addr)
+#define Mw(addr, len, data) concat(vaddr_write_, len)(addr, data)
 
 enum {
   TYPE_2RI12, TYPE_1RI20,
@@ -52,6 +53,7 @@ static int decode_exec(Decode *s) {
   word_t src1 = 0, src2 = 0, imm = 0; \
   decode_operand(s, &rd, &src1, &src2, &imm, concat(TYPE_, type)); \
   __VA_ARGS__ ; \
+  INSTPAT_STAT(s, name); \
 }
 
   INSTPAT_START();
@@ -27,6 +27,7 @@ typedef struct {
 // decode
 typedef struct {
   uint32_t inst;
+  bool in_slot; // executed in the delay slot of a branch
 } mips32_ISADecodeInfo;
 
 #define isa_mmu_check(vaddr, len, type) (MMU_DIRECT)
@@ -19,11 +19,12 @@
 #include <cpu/decode.h>
 
 #define R(i) gpr(i)
-#define Mr vaddr_read
-#define Mw vaddr_write
+// the width of each access is a constant, so use the fixed-width accessors
+#define Mr(addr, len) concat(vaddr_read_, len)(addr)
+#define Mw(addr, len, data) concat(vaddr_write_, len)(addr, data)
 
 enum {
-  TYPE_I, TYPE_U,
+  TYPE_I, TYPE_U, TYPE_B, TYPE_J, TYPE_R,
   TYPE_N, // none
 };
 
@@ -31,6 +32,8 @@ enum {
 #define src2R() do { *src2 = R(rt); } while (0)
 #define immI() do { *imm = SEXT(BITS(i, 15, 0), 16); } while(0)
 #define immU() do { *imm = BITS(i, 15, 0); } while(0)
+#define immB() do { *imm = s->pc + 4 + (SEXT(BITS(i, 15, 0), 16) << 2); } while(0)
+#define immJ() do { *imm = ((s->pc + 4) & 0xf0000000) | (BITS(i, 25, 0) << 2); } while(0)
 
 static void decode_operand(Decode *s, int *rd, word_t *src1, word_t *src2, word_t *imm, int type) {
   uint32_t i = s->isa.inst;
@@ -40,11 +43,36 @@ static void decode_operand(Decode *s, int *rd, word_t *src1, word_t *src2, word_
   switch (type) {
     case TYPE_I: src1R(); immI(); break;
     case TYPE_U: src1R(); immU(); break;
+    case TYPE_B: src1R(); src2R(); immB(); break;
+    case TYPE_J:                   immJ(); break;
+    case TYPE_R: src1R(); src2R();         break;
     case TYPE_N: break;
     default: panic("unsupported type = %d", type);
   }
 }
 
+static int decode_exec(Decode *s);
+
+/* A branch is executed together with the instruction in its delay slot, as
+ * one instruction of 8 bytes, so the execution loop and the decoded form of
+ * other instructions know nothing about delay slots. The condition, target
+ * and link of the branch are evaluated before the slot is executed. A slot
+ * redirecting the pc can only be taking an exception, which then wins over
+ * the branch, as if the slot were executed alone. */
+static void exec_delay_slot(Decode *s, bool taken, vaddr_t target) {
+  // a branch in a delay slot is UNPREDICTABLE
+  if (unlikely(s->isa.in_slot)) { INV(s->pc); return; }
+  Decode slot = { .pc = s->snpc, .snpc = s->snpc, .isa.in_slot = true };
+  slot.isa.inst = inst_fetch(&slot.snpc, 4);
+  decode_exec(&slot);
+  s->snpc = slot.snpc;
+  s->dnpc = (slot.dnpc != slot.snpc ? slot.dnpc : (taken ? target : slot.snpc));
+}
+
+#define B(cond) exec_delay_slot(s, cond, imm)
+#define J(target) exec_delay_slot(s, true, target)
+#define Link(r) R(r) = s->pc + 8
+
 static int decode_exec(Decode *s) {
   s->dnpc = s->snpc;
 
@@ -54,6 +82,7 @@ static int decode_exec(Decode *s) {
   word_t src1 = 0, src2 = 0, imm = 0; \
   decode_operand(s, &rd, &src1, &src2, &imm, concat(TYPE_, type)); \
   __VA_ARGS__ ; \
+  INSTPAT_STAT(s, name); \
 }
 
   INSTPAT_START();
@@ -61,6 +90,17 @@ static int decode_exec(Decode *s) {
   INSTPAT("100011 ????? ????? ????? ????? ??????", lw     , I, R(rd) = Mr(src1 + imm, 4));
   INSTPAT("101011 ????? ????? ????? ????? ??????", sw     , I, Mw(src1 + imm, 4, R(rd)));
 
+  INSTPAT("000100 ????? ????? ????? ????? ??????", beq    , B, B(src1 == src2));
+  INSTPAT("000101 ????? ????? ????? ????? ??????", bne    , B, B(src1 != src2));
+  INSTPAT("000110 ????? 00000 ????? ????? ??????", blez   , B, B((sword_t)src1 <= 0));
+  INSTPAT("000111 ????? 00000 ????? ????? ??????", bgtz   , B, B((sword_t)src1 > 0));
+  INSTPAT("000001 ????? 00000 ????? ????? ??????", bltz   , B, B((sword_t)src1 < 0));
+  INSTPAT("000001 ????? 00001 ????? ????? ??????", bgez   , B, B((sword_t)src1 >= 0));
+  INSTPAT("000010 ????? ????? ????? ????? ??????", j      , J, J(imm));
+  INSTPAT("000011 ????? ????? ????? ????? ??????", jal    , J, Link(31); J(imm));
+  INSTPAT("000000 ????? 00000 00000 ????? 001000", jr     , R, J(src1));
+  INSTPAT("000000 ????? 00000 ????? ????? 001001", jalr   , R, Link(rd); J(src1));
+
   INSTPAT("011100 ????? ????? ????? ????? 111111", sdbbp  , N, NEMUTRAP(s->pc, R(2))); // R(2) is $v0;
   INSTPAT("?????? ????? ????? ????? ????? ??????", inv    , N, INV(s->pc));
   INSTPAT_END();
@@ -71,6 +111,7 @@ static int decode_exec(Decode *s) {
 }
 
 int isa_exec_once(Decode *s) {
+  s->isa.in_slot = false;
   s->isa.inst = inst_fetch(&s->snpc, 4);
   return decode_exec(s);
 }
@@ -0,0 +1,273 @@
+/***************************************************************************************
+* Copyright (c) 2014-2024 Zihao Yu, Nanjing University
+*
+* NEMU is licensed under Mulan PSL v2.
+* You can use this software according to the terms and conditions of the Mulan PSL v2.
+* You may obtain a copy of Mulan PSL v2 at:
+*          http://license.coscl.org.cn/MulanPSL2
+*
+* THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+* EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+* MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+*
+* See the Mulan PSL v2 for more details.
+***************************************************************************************/
+
+#include <isa.h>
+#include <cpu/cpu.h>
+#include <fenv.h>
+#include <math.h>
+#include "local-include/csr.h"
+#include "local-include/fpu.h"
+
+/* The arithmetic is done by the FPU of the host, with its rounding mode set
+ * from the instruction and the flags read back from its exception flags.
+ * The host differs from RISC-V in the cases below, which are fixed up:
+ * - a NaN result is always the canonical NaN on RISC-V, so the payload
+ *   propagated by the host is dropped;
+ * - the host has no RMM (round to nearest, ties to max magnitude). It only
+ *   differs from RNE in a tie, which is found from the exact residual of
+ *   additions and multiplications, and from the exact value of conversions.
+ *   Quotients and square roots are never a tie. A fused multiply-add with
+ *   RMM is rounded as RNE;
+ * - 0 * inf in a fused multiply-add is invalid even with a quiet NaN
+ *   addend;
+ * - conversions to integers saturate on RISC-V, and are done by software
+ *   with the flags raised by hand. So are the comparisons, min/max, sign
+ *   injection and classification, which the host does not do bit-exactly. */
+
+enum { RM_RNE, RM_RTZ, RM_RDN, RM_RUP, RM_RMM, RM_DYN = 7 };
+enum { FLAG_NX = 0x1, FLAG_UF = 0x2, FLAG_OF = 0x4, FLAG_DZ = 0x8, FLAG_NV = 0x10 };
+
+static const int host_rm[] = { FE_TONEAREST, FE_TOWARDZERO, FE_DOWNWARD, FE_UPWARD, FE_TONEAREST };
+
+// keep the compiler from moving an operation across the accesses to fenv
+#define FP_BARRIER(x) __asm__ volatile("" : "+m"(x))
+
+static inline void fpu_raise(int flags) {
+  csr(fflags) |= flags;
+  csr(fcsr) |= flags;
+}
+
+// return the rounding mode, or -1 for a reserved one
+static inline int fpu_rm(int rm) {
+  if (rm == RM_DYN) rm = csr(frm);
+  if (unlikely(rm > RM_RMM)) { INV(cpu.pc); return -1; }
+  return rm;
+}
+
+// NEMU itself runs in RNE, so other modes are set for a single operation
+static inline void host_enter(int rm) {
+  if (host_rm[rm] != FE_TONEAREST) fesetround(host_rm[rm]);
+  feclearexcept(FE_ALL_EXCEPT);
+}
+
+static inline void host_leave(int rm) {
+  int e = fetestexcept(FE_ALL_EXCEPT);
+  if (host_rm[rm] != FE_TONEAREST) fesetround(FE_TONEAREST);
+  if (likely(e == 0)) return;
+  fpu_raise(((e & FE_INEXACT) ? FLAG_NX : 0) | ((e & FE_UNDERFLOW) ? FLAG_UF : 0) |
+      ((e & FE_OVERFLOW) ? FLAG_OF : 0) | ((e & FE_DIVBYZERO) ? FLAG_DZ : 0) |
+      ((e & FE_INVALID) ? FLAG_NV : 0));
+}
+
+/* In a tie of RNE, the exact result is r + e with e half the gap to the
+ * neighbor of r, and RMM takes the neighbor if it is away from zero. */
+#define RMM_FIX(T, r, e) ({ \
+  T __r = (r); \
+  long double __e = (e); \
+  if (__e != 0 && isfinite(__r)) { \
+    T __inf = (__e > 0 ? INFINITY : -INFINITY); \
+    T __n = (sizeof(T) == 4 ? nextafterf(__r, __inf) : nextafter(__r, __inf)); \
+    if (fabsl(__n) > fabsl(__r) && __e * 2 == (long double)__n - __r) __r = __n; \
+  } \
+  __r; \
+})
+
+/* Each format is described by its C type T, the unsigned type U of its bits,
+ * and how it is held in an FP register. */
+#define FPU_IMPL(s, T, U, BITS_, unbox, box) \
+typedef union { T f; U u; } concat(FP_, s); \
+\
+static inline T concat(get_, s)(uint64_t x) { return ((concat(FP_, s)) { .u = unbox(x) }).f; } \
+static inline uint64_t concat(put_, s)(T f) { \
+  concat(FP_, s) v = { .f = f }; \
+  if (isnan(f)) v.u = (U)((U)-1 >> 1) ^ ((U)-1 >> 2 >> (BITS_ == 32 ? 8 : 11)); \
+  return box(v.u); \
+} \
+static inline bool concat(is_snan_, s)(T f) { \
+  concat(FP_, s) v = { .f = f }; \
+  return isnan(f) && !(v.u & ((U)1 << (BITS_ == 32 ? 22 : 51))); \
+} \
+\
+uint64_t concat(fadd_, s)(uint64_t a, uint64_t b, int rm) { \
+  if ((rm = fpu_rm(rm)) < 0) return 0; \
+  T x = concat(get_, s)(a), y = concat(get_, s)(b); \
+  host_enter(rm); \
+  FP_BARRIER(x); FP_BARRIER(y); \
+  T r = x + y; \
+  FP_BARRIER(r); \
+  host_leave(rm); \
+  if (rm == RM_RMM) { T bb = r - x; r = RMM_FIX(T, r, (x - (r - bb)) + (y - bb)); } \
+  return concat(put_, s)(r); \
+} \
+uint64_t concat(fsub_, s)(uint64_t a, uint64_t b, int rm) { \
+  concat(FP_, s) v = { .f = concat(get_, s)(b) }; \
+  v.u ^= (U)1 << (BITS_ - 1); \
+  return concat(fadd_, s)(a, box(v.u), rm); \
+} \
+uint64_t concat(fmul_, s)(uint64_t a, uint64_t b, int rm) { \
+  if ((rm = fpu_rm(rm)) < 0) return 0; \
+  T x = concat(get_, s)(a), y = concat(get_, s)(b); \
+  host_enter(rm); \
+  FP_BARRIER(x); FP_BARRIER(y); \
+  T r = x * y; \
+  FP_BARRIER(r); \
+  host_leave(rm); \
+  if (rm == RM_RMM) r = RMM_FIX(T, r, fma(x, y, -r)); \
+  return concat(put_, s)(r); \
+} \
+uint64_t concat(fdiv_, s)(uint64_t a, uint64_t b, int rm) { \
+  if ((rm = fpu_rm(rm)) < 0) return 0; \
+  T x = concat(get_, s)(a), y = concat(get_, s)(b); \
+  host_enter(rm); \
+  FP_BARRIER(x); FP_BARRIER(y); \
+  T r = x / y; \
+  FP_BARRIER(r); \
+  host_leave(rm); \
+  return concat(put_, s)(r); \
+} \
+uint64_t concat(fsqrt_, s)(uint64_t a, int rm) { \
+  if ((rm = fpu_rm(rm)) < 0) return 0; \
+  T x = concat(get_, s)(a); \
+  host_enter(rm); \
+  FP_BARRIER(x); \
+  T r = (BITS_ == 32 ? sqrtf(x) : sqrt(x)); \
+  FP_BARRIER(r); \
+  host_leave(rm); \
+  return concat(put_, s)(r); \
+} \
+uint64_t concat(fmadd_, s)(uint64_t a, uint64_t b, uint64_t c, int rm, bool neg_prod, bool neg_add) { \
+  if ((rm = fpu_rm(rm)) < 0) return 0; \
+  T x = concat(get_, s)(a), y = concat(get_, s)(b), z = concat(get_, s)(c); \
+  if (neg_prod) x = -x; \
+  if (neg_add) z = -z; \
+  host_enter(rm); \
+  FP_BARRIER(x); FP_BARRIER(y); FP_BARRIER(z); \
+  T r = (BITS_ == 32 ? fmaf(x, y, z) : fma(x, y, z)); \
+  FP_BARRIER(r); \
+  host_leave(rm); \
+  /* 0 * inf is invalid even if the addend is a quiet NaN */ \
+  if ((isinf(x) && y == 0) || (x == 0 && isinf(y))) fpu_raise(FLAG_NV); \
+  return concat(put_, s)(r); \
+} \
+\
+uint64_t concat(fsgnj_, s)(uint64_t a, uint64_t b, int mode) { \
+  U sign = (U)1 << (BITS_ - 1); \
+  U x = unbox(a), y = unbox(b); \
+  U sy = (mode == 0 ? y : (mode == 1 ? ~y : x ^ y)) & sign; \
+  return box((x & ~sign) | sy); \
+} \
+uint64_t concat(fminmax_, s)(uint64_t a, uint64_t b, bool max) { \
+  T x = concat(get_, s)(a), y = concat(get_, s)(b); \
+  if (concat(is_snan_, s)(x) || concat(is_snan_, s)(y)) fpu_raise(FLAG_NV); \
+  T r; \
+  if (isnan(x)) r = y; \
+  else if (isnan(y)) r = x; \
+  else if (x == y) r = (signbit(x) != max ? x : y); /* -0 < +0 */ \
+  else r = ((x < y) != max ? x : y); \
+  return concat(put_, s)(r); \
+} \
+word_t concat(fcmp_, s)(uint64_t a, uint64_t b, int mode) { \
+  T x = concat(get_, s)(a), y = concat(get_, s)(b); \
+  if (isnan(x) || isnan(y)) { \
+    /* feq is quiet, while flt and fle signal */ \
+    if (mode != 2 || concat(is_snan_, s)(x) || concat(is_snan_, s)(y)) fpu_raise(FLAG_NV); \
+    return 0; \
+  } \
+  return (mode == 0 ? x <= y : (mode == 1 ? x < y : x == y)); \
+} \
+word_t concat(fclass_, s)(uint64_t a) { \
+  T x = concat(get_, s)(a); \
+  bool neg = signbit(x); \
+  switch (fpclassify(x)) { \
+    case FP_INFINITE:  return (neg ? 1 << 0 : 1 << 7); \
+    case FP_NORMAL:    return (neg ? 1 << 1 : 1 << 6); \
+    case FP_SUBNORMAL: return (neg ? 1 << 2 : 1 << 5); \
+    case FP_ZERO:      return (neg ? 1 << 3 : 1 << 4); \
+    default:           return (concat(is_snan_, s)(x) ? 1 << 8 : 1 << 9); \
+  } \
+} \
+\
+word_t concat(fcvt_to_int_, s)(uint64_t a, int rm, int bits, bool is_signed) { \
+  if ((rm = fpu_rm(rm)) < 0) return 0; \
+  T x = concat(get_, s)(a); \
+  int64_t lo = (is_signed ? (int64_t)((uint64_t)-1 << (bits - 1)) : 0); \
+  uint64_t hi = (is_signed ? ((uint64_t)1 << (bits - 1)) - 1 : (uint64_t)-1 >> (64 - bits)); \
+  T r; \
+  switch (rm) { \
+    case RM_RTZ: r = trunc(x); break; \
+    case RM_RDN: r = floor(x); break; \
+    case RM_RUP: r = ceil(x); break; \
+    case RM_RMM: r = round(x); break; \
+    default:     r = nearbyint(x); break; \
+  } \
+  uint64_t v; \
+  /* the limits are compared as powers of 2, which are exact */ \
+  if (isnan(r) || r >= ldexp(1.0, bits - is_signed)) { fpu_raise(FLAG_NV); v = hi; } \
+  else if (r < (T)lo) { fpu_raise(FLAG_NV); v = lo; } \
+  else { \
+    v = (is_signed ? (uint64_t)(int64_t)r : (uint64_t)r); \
+    if (r != x) fpu_raise(FLAG_NX); \
+  } \
+  return (word_t)(bits == 32 ? SEXT(v, 32) : v); \
+} \
+uint64_t concat(fcvt_from_int_, s)(uint64_t x, int rm, bool is_signed) { \
+  if ((rm = fpu_rm(rm)) < 0) return 0; \
+  host_enter(rm); \
+  FP_BARRIER(x); \
+  T r = (is_signed ? (T)(int64_t)x : (T)x); \
+  FP_BARRIER(r); \
+  host_leave(rm); \
+  if (rm == RM_RMM) { \
+    long double exact = (is_signed ? (long double)(int64_t)x : (long double)x); \
+    r = RMM_FIX(T, r, exact - r); \
+  } \
+  return concat(put_, s)(r); \
+}
+
+#ifdef CONFIG_RVD
+#define UNBOX_S(x) ((uint32_t)((x) >> 32) == 0xffffffff ? (uint32_t)(x) : 0x7fc00000u)
+#else
+#define UNBOX_S(x) ((uint32_t)(x))
+#endif
+#define BOX_S(x) FPU_BOX(x)
+#define UNBOX_D(x) ((uint64_t)(x))
+#define BOX_D(x) ((uint64_t)(x))
+
+FPU_IMPL(s, float, uint32_t, 32, UNBOX_S, BOX_S)
+#ifdef CONFIG_RVD
+FPU_IMPL(d, double, uint64_t, 64, UNBOX_D, BOX_D)
+
+uint64_t fcvt_s_d(uint64_t a, int rm) {
+  if ((rm = fpu_rm(rm)) < 0) return 0;
+  double x = get_d(a);
+  host_enter(rm);
+  FP_BARRIER(x);
+  float r = x;
+  FP_BARRIER(r);
+  host_leave(rm);
+  if (rm == RM_RMM) r = RMM_FIX(float, r, (long double)x - r);
+  return put_s(r);
+}
+
+uint64_t fcvt_d_s(uint64_t a) {
+  float x = get_s(a);
+  host_enter(RM_RNE);
+  FP_BARRIER(x);
+  double r = x;
+  FP_BARRIER(r);
+  host_leave(RM_RNE);
+  return put_d(r);
+}
+#endif
@@ -17,17 +17,80 @@
 #define __ISA_RISCV_H__
 
 #include <common.h>
+#include <stddef.h>
+#include <difftest-def.h>
 
+#define CPU_LINE 64
+
+/* The CSRs implemented, as (name, number, hook run after a write). Each one
+ * is kept in cpu.csr[] at its compact ID, CSR_name, and the accessors are
+ * generated from this table by system/csr.c. */
+#define CSR_LIST(f) \
+  CSR_LIST_F(f) \
+  f(satp    , 0x180, csr_hook_satp) \
+  f(mstatus , 0x300, csr_hook_intr) \
+  f(mie     , 0x304, csr_hook_intr) \
+  f(mtvec   , 0x305, NULL) \
+  f(mscratch, 0x340, NULL) \
+  f(mepc    , 0x341, NULL) \
+  f(mcause  , 0x342, NULL) \
+  f(mtval   , 0x343, NULL) \
+  f(mip     , 0x344, csr_hook_intr)
+
+#ifdef CONFIG_RVF
+#define CSR_LIST_F(f) \
+  f(fflags  , 0x001, csr_hook_fflags) \
+  f(frm     , 0x002, csr_hook_frm) \
+  f(fcsr    , 0x003, csr_hook_fcsr)
+#else
+#define CSR_LIST_F(f)
+#endif
+
+#define CSR_ENUM(name, no, hook) concat(CSR_, name),
+enum { CSR_LIST(CSR_ENUM) NR_CSR };
+
+/* The state is laid out by how often it is accessed. The GPRs and pc start
+ * at a host cache line, since they are accessed by every instruction. The
+ * CSRs start at the next line, and state rarely used goes after them. The
+ * GPRs and pc also form the view of difftest, riscv_DiffRegs. */
 typedef struct {
   word_t gpr[MUXDEF(CONFIG_RVE, 16, 32)];
   vaddr_t pc;
-} MUXDEF(CONFIG_RV64, riscv64_CPU_state, riscv32_CPU_state);
+  word_t csr[NR_CSR] __attribute__((aligned(CPU_LINE)));
+  IFDEF(CONFIG_RVF, uint64_t fpr[32];) // a single is NaN-boxed with the D extension
+} __attribute__((aligned(CPU_LINE))) MUXDEF(CONFIG_RV64, riscv64_CPU_state, riscv32_CPU_state);
+
+#define RISCV_CPU_state MUXDEF(CONFIG_RV64, riscv64_CPU_state, riscv32_CPU_state)
+static_assert(offsetof(RISCV_CPU_state, gpr) == offsetof(riscv_DiffRegs, gpr) &&
+    sizeof(((RISCV_CPU_state *)0)->gpr) == sizeof(((riscv_DiffRegs *)0)->gpr) &&
+    offsetof(RISCV_CPU_state, pc) == offsetof(riscv_DiffRegs, pc), "CPU_state does not begin with riscv_DiffRegs");
+#undef RISCV_CPU_state
 
 // decode
 typedef struct {
-  uint32_t inst;
+  uint32_t inst;         // as fetched, 16-bit for a compressed one
+  IFDEF(CONFIG_RVC, uint32_t einst;) // expanded into 32-bit
 } MUXDEF(CONFIG_RV64, riscv64_ISADecodeInfo, riscv32_ISADecodeInfo);
 
+// INSTPAT is dispatched by funct7, funct3 and opcode
+#define INSTPAT_TREE_MASK 0xfe00707fu
+#define INSTPAT_TREE_KEY(inst) (BITS(inst, 6, 0) | (BITS(inst, 14, 12) << 7) | (BITS(inst, 31, 25) << 10))
+
+#ifdef CONFIG_DECODE_CACHE
+/* An instruction in the decode cache, with the address of the matched
+ * execution body and the operand fields extracted by decode_operand(). The
+ * blocks of ENGINE_BLOCK keep copies of them. */
+typedef struct {
+  vaddr_t pc;
+  uint32_t inst;
+  uint8_t rd, rs1, rs2, type;
+  IFDEF(CONFIG_DECODE_FUSION, uint8_t fuse); // the kind of the pair headed by this instruction
+  IFDEF(CONFIG_DECODE_FUSION, uint32_t inst2); // the second instruction of the pair
+  word_t imm;
+  const void *exec;
+} MUXDEF(CONFIG_RV64, riscv64_DecodeCacheEntry, riscv32_DecodeCacheEntry);
+#endif
+
 #define isa_mmu_check(vaddr, len, type) (MMU_DIRECT)
 
 #endif
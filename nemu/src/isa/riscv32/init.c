@@ -32,9 +32,20 @@ static void restart() {
 
   /* The zero register is always 0. */
   cpu.gpr[0] = 0;
+
+  /* Run in the machine mode after a trap returns. */
+  cpu.csr[CSR_mstatus] = 0x1800;
+}
+
+void isa_hart_init(int id, word_t sp) {
+  /* Like the firmware of RISC-V, pass the id of the hart in $a0. */
+  cpu.gpr[10] = id;
+  cpu.gpr[2] = sp;
 }
 
 void init_isa() {
+  IFDEF(CONFIG_DECODE_CACHE, void init_decode_cache(); init_decode_cache());
+
   /* Load built-in image. */
   memcpy(guest_to_host(RESET_VECTOR), img, sizeof(img));
 
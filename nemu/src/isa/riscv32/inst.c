@@ -14,16 +14,27 @@
 ***************************************************************************************/
 
 #include "local-include/reg.h"
+#include "local-include/csr.h"
+#include "local-include/fpu.h"
 #include <cpu/cpu.h>
 #include <cpu/ifetch.h>
 #include <cpu/decode.h>
+#include <memory/paddr.h>
+#include <cpu/hart.h>
 
 #define R(i) gpr(i)
-#define Mr vaddr_read
-#define Mw vaddr_write
+// the 32-bit instruction to execute
+#define INST(s) ((s)->isa.MUXDEF(CONFIG_RVC, einst, inst))
+#define ILEN(inst) (((inst) & 3) == 3 ? 4 : 2)
+// the width of each access is a constant, so use the fixed-width accessors
+#define Mr(addr, len) concat(vaddr_read_, len)(addr)
+#define Mw(addr, len, data) concat(vaddr_write_, len)(addr, data)
 
 enum {
-  TYPE_I, TYPE_U, TYPE_S,
+  TYPE_I, TYPE_U, TYPE_S, TYPE_R,
+  TYPE_CSR, // with the index of rs1, or the unsigned immediate, in src2
+  TYPE_F,   // the indices of rs1 and rs2 in src1 and src2, rs3 and rm in imm
+  TYPE_FS,  // a store of an FP register, with the index of rs2 in src2
   TYPE_N, // none
 };
 
@@ -33,8 +44,220 @@ enum {
 #define immU() do { *imm = SEXT(BITS(i, 31, 12), 20) << 12; } while(0)
 #define immS() do { *imm = (SEXT(BITS(i, 31, 25), 7) << 5) | BITS(i, 11, 7); } while(0)
 
+#ifdef CONFIG_DECODE_CACHE
+// Direct-mapped cache of decoded instructions, indexed by pc. An entry keeps
+// the address of the matched execution body together with the operand fields
+// extracted by decode_operand(), so a hit can jump to the body directly.
+#define DCACHE_SIZE 4096 // should be a multiple of PAGE_SIZE / 4
+#define DCACHE_INVALID_PC ((vaddr_t)-1) // never matches, since pc is aligned
+
+typedef MUXDEF(CONFIG_RV64, riscv64_DecodeCacheEntry, riscv32_DecodeCacheEntry) DecodeCacheEntry;
+
+static HART_LOCAL DecodeCacheEntry dcache[DCACHE_SIZE] = {};
+IFDEF(CONFIG_LIVE, uint64_t dcache_nr_miss = 0);
+// set while decoding ahead of time, when nothing is executed
+IFDEF(CONFIG_DECODE_CACHE_AOT, static bool dcache_aot = false);
+
+// pcs are 2-byte aligned with compressed instructions
+#define DCACHE_SHIFT MUXDEF(CONFIG_RVC, 1, 2)
+
+static inline DecodeCacheEntry* dcache_entry(vaddr_t pc) {
+  return &dcache[(pc >> DCACHE_SHIFT) % DCACHE_SIZE];
+}
+
+#ifdef CONFIG_DECODE_FUSION
+/* Compilers access data pc-relatively by an auipc and a load or a store
+ * based on its rd. When such an auipc is cached, the access after it in the
+ * same page is kept in its entry, and a hit executes both at once if the
+ * loop allows. The page is flushed as a whole, so the pair never outlives
+ * either instruction. The access is only fused if it is aligned and falls
+ * in pmem, where it can not raise an exception; otherwise the auipc is
+ * executed alone, and the access raises its exception at its own pc. */
+enum { FUSE_NONE, FUSE_LBU, FUSE_SB, FUSE_LWU, FUSE_LD, FUSE_SD, FUSE_FLW, FUSE_FLD };
+static const uint8_t fuse_len[] = { [FUSE_LBU] = 1, [FUSE_SB] = 1, [FUSE_LWU] = 4, [FUSE_LD] = 8,
+  [FUSE_SD] = 8, [FUSE_FLW] = 4, [FUSE_FLD] = 8 };
+
+// only the accesses implemented by INSTPAT below
+static int fuse_kind(uint32_t auipc, uint32_t i) {
+  int rd = BITS(auipc, 11, 7);
+  if (rd == 0 || BITS(i, 19, 15) != rd) return FUSE_NONE;
+  switch (BITS(i, 6, 0) | (BITS(i, 14, 12) << 7)) {
+    case 0x03 | (4 << 7): return FUSE_LBU;
+    case 0x23 | (0 << 7): return FUSE_SB;
+#ifdef CONFIG_ISA64
+    case 0x03 | (6 << 7): return FUSE_LWU;
+    case 0x03 | (3 << 7): return FUSE_LD;
+    case 0x23 | (3 << 7): return FUSE_SD;
+#endif
+#ifdef CONFIG_RVF
+    case 0x07 | (2 << 7): return FUSE_FLW;
+#endif
+#ifdef CONFIG_RVD
+    case 0x07 | (3 << 7): return FUSE_FLD;
+#endif
+  }
+  return FUSE_NONE;
+}
+
+static void dcache_fuse(DecodeCacheEntry *e) {
+  vaddr_t next = e->pc + 4;
+  e->fuse = FUSE_NONE;
+  if (BITS(e->inst, 6, 0) != 0x17 || ((next + 3) & ~PAGE_MASK) != (e->pc & ~PAGE_MASK) ||
+      !in_pmem(next + 3)) return;
+  // a compressed instruction is not fused
+  uint32_t i = host_read(guest_to_host(next), 2) | (host_read(guest_to_host(next + 2), 2) << 16);
+  if ((i & 3) != 3) return;
+  e->fuse = fuse_kind(e->inst, i);
+  e->inst2 = i;
+}
+#endif
+
+static void dcache_fill(Decode *s, int rd, word_t imm, int type, const void *exec) {
+  DecodeCacheEntry *e = dcache_entry(s->pc);
+  uint32_t i = INST(s);
+  *e = (DecodeCacheEntry) { .pc = s->pc, .inst = s->isa.inst, .rd = rd,
+    .rs1 = BITS(i, 19, 15), .rs2 = BITS(i, 24, 20), .type = type, .imm = imm, .exec = exec };
+  // vaddr is identical to paddr since isa_mmu_check() always returns MMU_DIRECT
+  paddr_mark_code(s->pc);
+  IFDEF(CONFIG_DECODE_FUSION, dcache_fuse(e));
+  IFDEF(CONFIG_LIVE, dcache_nr_miss ++);
+}
+
+void isa_flush_decode_cache(paddr_t page) {
+  // all pcs in a page fall into PAGE_SIZE >> DCACHE_SHIFT consecutive entries
+  int base = (page >> DCACHE_SHIFT) % DCACHE_SIZE;
+  int i;
+  for (i = 0; i < PAGE_SIZE >> DCACHE_SHIFT; i ++) {
+    DecodeCacheEntry *e = &dcache[(base + i) % DCACHE_SIZE];
+    if ((e->pc & ~PAGE_MASK) == page) e->pc = DCACHE_INVALID_PC;
+  }
+}
+
+void flush_decode_cache() {
+  int i;
+  for (i = 0; i < DCACHE_SIZE; i ++) {
+    dcache[i].pc = DCACHE_INVALID_PC;
+  }
+}
+
+void init_decode_cache() {
+  flush_decode_cache();
+  FOOTPRINT("decode cache", dcache, sizeof(dcache));
+}
+
+#ifdef CONFIG_DECODE_CACHE_FILE
+/* The decode cache is saved into a file on exit, and loaded by the next run
+ * of the same image with the same executable of NEMU, which are told by the
+ * hashes of them in the header. The address of the execution body of an
+ * entry is saved as an offset from isa_exec_once(), which stays the same
+ * across runs of the same executable. The pcs of the entries cached with the
+ * MMU on are virtual, so an entry is only loaded if the instruction at its
+ * pc in pmem is still the one cached, which then decodes to the same entry
+ * anyway. */
+#define DCACHE_FILE_MAGIC "NEMUDCAC"
+
+typedef struct {
+  char magic[8];
+  uint64_t build_id;
+  uint64_t img_hash;
+  uint32_t entry_size;
+  uint32_t nr_entry;
+} DecodeCacheFileHeader;
+
+static const char *dcache_file = NULL;
+static uint64_t dcache_build_id = 0, dcache_img_hash = 0;
+
+// FNV-1a on 8-byte words, which is good enough to tell a different file
+static uint64_t hash_update(uint64_t h, const uint8_t *p, size_t len) {
+  for (; len >= 8; p += 8, len -= 8) {
+    uint64_t w;
+    memcpy(&w, p, 8);
+    h = (h ^ w) * 0x100000001b3ull;
+  }
+  for (; len > 0; p ++, len --) h = (h ^ *p) * 0x100000001b3ull;
+  return h;
+}
+
+static uint64_t hash_exe() {
+  FILE *fp = fopen("/proc/self/exe", "rb");
+  if (fp == NULL) return 0;
+  static uint8_t buf[64 * 1024];
+  uint64_t h = 0xcbf29ce484222325ull;
+  size_t n;
+  while ((n = fread(buf, 1, sizeof(buf), fp)) > 0) h = hash_update(h, buf, n);
+  fclose(fp);
+  return h;
+}
+
+static void dcache_save() {
+  FILE *fp = fopen(dcache_file, "wb");
+  if (fp == NULL) { Log_warn("Can not write the decode cache to '%s'", dcache_file); return; }
+  DecodeCacheFileHeader h = { .build_id = dcache_build_id, .img_hash = dcache_img_hash,
+    .entry_size = sizeof(DecodeCacheEntry) };
+  memcpy(h.magic, DCACHE_FILE_MAGIC, sizeof(h.magic));
+  fwrite(&h, sizeof(h), 1, fp);
+  int i;
+  for (i = 0; i < DCACHE_SIZE; i ++) {
+    if (dcache[i].pc == DCACHE_INVALID_PC) continue;
+    DecodeCacheEntry e = dcache[i];
+    e.exec = (const void *)((uintptr_t)e.exec - (uintptr_t)isa_exec_once);
+    fwrite(&e, sizeof(e), 1, fp);
+    h.nr_entry ++;
+  }
+  // the number of entries is known at last
+  rewind(fp);
+  fwrite(&h, sizeof(h), 1, fp);
+  fclose(fp);
+  Log("Saved %d entries of the decode cache to %s", h.nr_entry, dcache_file);
+}
+
+static bool dcache_entry_valid(const DecodeCacheEntry *e) {
+  int len = MUXDEF(CONFIG_RVC, ILEN(e->inst), 4);
+  if (!in_pmem(e->pc) || !in_pmem(e->pc + len - 1)) return false;
+  uint32_t inst = host_read(guest_to_host(e->pc), 2);
+  if (len == 4) inst |= host_read(guest_to_host(e->pc + 2), 2) << 16;
+  return inst == e->inst;
+}
+
+/* Load the decode cache from `file` if it is saved by the same executable
+ * for the image of `img_size` bytes loaded at RESET_VECTOR, and save the
+ * decode cache into `file` on exit. */
+void isa_decode_cache_file(const char *file, long img_size) {
+  dcache_file = file;
+  dcache_build_id = hash_exe();
+  dcache_img_hash = hash_update(0xcbf29ce484222325ull, guest_to_host(RESET_VECTOR), img_size);
+  atexit(dcache_save);
+
+  FILE *fp = fopen(file, "rb");
+  if (fp == NULL) return;
+  DecodeCacheFileHeader h;
+  if (fread(&h, sizeof(h), 1, fp) != 1 || memcmp(h.magic, DCACHE_FILE_MAGIC, sizeof(h.magic)) != 0 ||
+      h.build_id != dcache_build_id || h.img_hash != dcache_img_hash ||
+      h.entry_size != sizeof(DecodeCacheEntry)) {
+    Log_warn("The decode cache in %s is not for this image or this build, ignored", file);
+    fclose(fp);
+    return;
+  }
+  int nr_load = 0;
+  DecodeCacheEntry e;
+  uint32_t i;
+  for (i = 0; i < h.nr_entry && fread(&e, sizeof(e), 1, fp) == 1; i ++) {
+    if (!dcache_entry_valid(&e)) continue;
+    e.exec = (const void *)((uintptr_t)e.exec + (uintptr_t)isa_exec_once);
+    // the pair is found again, since the instruction after it may differ
+    IFDEF(CONFIG_DECODE_FUSION, dcache_fuse(&e));
+    *dcache_entry(e.pc) = e;
+    paddr_mark_code(e.pc);
+    nr_load ++;
+  }
+  fclose(fp);
+  Log("Loaded %d of %d entries of the decode cache from %s", nr_load, h.nr_entry, file);
+}
+#endif
+#endif
+
 static void decode_operand(Decode *s, int *rd, word_t *src1, word_t *src2, word_t *imm, int type) {
-  uint32_t i = s->isa.inst;
+  uint32_t i = INST(s);
   int rs1 = BITS(i, 19, 15);
   int rs2 = BITS(i, 24, 20);
   *rd     = BITS(i, 11, 7);
@@ -42,28 +265,407 @@ static void decode_operand(Decode *s, int *rd, word_t *src1, word_t *src2, word_
     case TYPE_I: src1R();          immI(); break;
     case TYPE_U:                   immU(); break;
     case TYPE_S: src1R(); src2R(); immS(); break;
+    case TYPE_R: src1R(); src2R();         break;
+    case TYPE_CSR: src1R(); *src2 = rs1; *imm = BITS(i, 31, 20); break;
+    case TYPE_F:  *src1 = rs1; *src2 = rs2; *imm = BITS(i, 31, 27) | (BITS(i, 14, 12) << 5); break;
+    case TYPE_FS: src1R(); *src2 = rs2; immS(); break;
     case TYPE_N: break;
     default: panic("unsupported type = %d", type);
   }
 }
 
-static int decode_exec(Decode *s) {
+#ifdef CONFIG_DECODE_CACHE
+__attribute__((always_inline))
+static inline void decode_operand_cached(const DecodeCacheEntry *e, int *rd, word_t *src1, word_t *src2, word_t *imm, int type) {
+  int rs1 = e->rs1;
+  int rs2 = e->rs2;
+  *rd  = e->rd;
+  *imm = e->imm;
+  switch (type) {
+    case TYPE_I: src1R();          break;
+    case TYPE_S: src1R(); src2R(); break;
+    case TYPE_R: src1R(); src2R(); break;
+    case TYPE_CSR: src1R(); *src2 = rs1; break;
+    case TYPE_F:  *src1 = rs1; *src2 = rs2; break;
+    case TYPE_FS: src1R(); *src2 = rs2; break;
+    default: break;
+  }
+}
+
+#ifdef CONFIG_DECODE_THREADED
+// Every pattern has its own handler, which fetches the operands of a cached
+// instruction with the instruction type known at compile time. A hit in the
+// decode cache jumps to the handler directly.
+#define DCACHE_HANDLER(type) \
+  if (0) { \
+    concat(__instpat_exec_, __LINE__): \
+    decode_operand_cached(cached, &rd, &src1, &src2, &imm, concat(TYPE_, type)); \
+  }
+#else
+#define DCACHE_HANDLER(type) concat(__instpat_exec_, __LINE__): ;
+#endif
+#endif
+
+#ifdef CONFIG_DECODE_CACHE_AOT
+// only fill an entry not taken by another pc, and return -1 for an invalid instruction
+#define DCACHE_AOT(name, ...) \
+  if (unlikely(dcache_aot)) { \
+    if (strcmp(str(name), "inv") == 0) return -1; \
+    if (dcache_entry(s->pc)->pc == DCACHE_INVALID_PC) dcache_fill(s, __VA_ARGS__); \
+    return 0; \
+  }
+#else
+#define DCACHE_AOT(name, ...)
+#endif
+
+/* The high half of a product is taken from a single multiplication of the
+ * double width of word_t. A division by zero, or the overflowing one of the
+ * most negative number by -1, divides by 1 instead, with the divisor chosen
+ * by masks, so that the host never traps and the common path has no branch
+ * but the test of a zero divisor. Dividing by 1 gives the results RISC-V
+ * requires for an overflow, and those for a zero divisor are selected. */
+typedef MUXDEF(CONFIG_ISA64, __int128, int64_t) dsword_t;
+typedef MUXDEF(CONFIG_ISA64, unsigned __int128, uint64_t) dword_t;
+#define XLEN (sizeof(word_t) * 8)
+
+static inline word_t mul_h  (word_t a, word_t b) { return ((dsword_t)(sword_t)a * (sword_t)b) >> XLEN; }
+static inline word_t mul_hsu(word_t a, word_t b) { return ((dsword_t)(sword_t)a * (dsword_t)b) >> XLEN; }
+static inline word_t mul_hu (word_t a, word_t b) { return ((dword_t)a * b) >> XLEN; }
+
+static inline sword_t sdivisor(word_t a, word_t b) {
+  word_t one = (b == 0) | (((a ^ ((word_t)1 << (XLEN - 1))) | (b + 1)) == 0);
+  return (sword_t)((b & (one - 1)) | one);
+}
+static inline word_t udivisor(word_t b) { return b | (b == 0); }
+
+static inline word_t div_s(word_t a, word_t b) { word_t q = (sword_t)a / sdivisor(a, b); return (b == 0 ? (word_t)-1 : q); }
+static inline word_t div_u(word_t a, word_t b) { word_t q = a / udivisor(b);             return (b == 0 ? (word_t)-1 : q); }
+static inline word_t rem_s(word_t a, word_t b) { word_t r = (sword_t)a % sdivisor(a, b); return (b == 0 ? a : r); }
+static inline word_t rem_u(word_t a, word_t b) { word_t r = a % udivisor(b);             return (b == 0 ? a : r); }
+
+#ifdef CONFIG_ISA64
+/* The W-suffixed instructions operate on the low 32 bits and sign-extend the
+ * 32-bit result. Their divisions are done in 64 bits, where the overflowing
+ * INT32_MIN / -1 does not trap, and is truncated to the result required. */
+#define SEXTW(x) ((word_t)(int64_t)(int32_t)(x))
+
+static inline word_t sll_w(word_t a, word_t b) { return SEXTW((uint32_t)a << (b & 0x1f)); }
+static inline word_t srl_w(word_t a, word_t b) { return SEXTW((uint32_t)a >> (b & 0x1f)); }
+static inline word_t sra_w(word_t a, word_t b) { return SEXTW((int32_t)a >> (b & 0x1f)); }
+
+static inline word_t div_w (word_t a, word_t b) { int64_t d = (int32_t)b;  word_t q = SEXTW((int32_t)a / (d | (d == 0)));  return (d == 0 ? (word_t)-1 : q); }
+static inline word_t div_uw(word_t a, word_t b) { uint32_t d = b;          word_t q = SEXTW((uint32_t)a / (d | (d == 0))); return (d == 0 ? (word_t)-1 : q); }
+static inline word_t rem_w (word_t a, word_t b) { int64_t d = (int32_t)b;  word_t r = SEXTW((int32_t)a % (d | (d == 0)));  return (d == 0 ? SEXTW(a) : r); }
+static inline word_t rem_uw(word_t a, word_t b) { uint32_t d = b;          word_t r = SEXTW((uint32_t)a % (d | (d == 0))); return (d == 0 ? SEXTW(a) : r); }
+#endif
+
+#ifdef CONFIG_RVA
+/* The atomic instructions operate on pmem with the atomic builtins of the
+ * host, so that they stay atomic without any global lock if the harts run
+ * on several host threads. A reservation of lr keeps the address and the
+ * value loaded, and sc stores by a compare-and-swap against that value, so
+ * it fails if another hart changes the word in between. Each hart has its
+ * entry of the reservations in its own host cache line. */
+typedef struct {
+  bool valid;
+  paddr_t addr;
+  word_t val;
+} __attribute__((aligned(CPU_LINE))) Reservation;
+
+static Reservation resv[MUXDEF(CONFIG_MULTI_HART, CONFIG_NR_HART, 1)] = {};
+#define RESV() (&resv[MUXDEF(CONFIG_MULTI_HART, hart_current(), 0)])
+
+enum { AMO_SWAP, AMO_ADD, AMO_XOR, AMO_AND, AMO_OR, AMO_MIN, AMO_MAX, AMO_MINU, AMO_MAXU };
+
+// vaddr is identical to paddr since isa_mmu_check() always returns MMU_DIRECT
+static inline void* amo_host(Decode *s, vaddr_t addr, int len) {
+  if (unlikely((addr & (len - 1)) != 0 || !in_pmem(addr))) { INV(s->pc); return NULL; }
+  return guest_to_host(addr);
+}
+
+// `op` is a constant in each INSTPAT, so only one case is left when inlined
+#define AMO_FN(bits) \
+static inline uint##bits##_t amo##bits(uint##bits##_t *p, int op, uint##bits##_t v) { \
+  switch (op) { \
+    case AMO_SWAP: return __atomic_exchange_n(p, v, __ATOMIC_SEQ_CST); \
+    case AMO_ADD:  return __atomic_fetch_add(p, v, __ATOMIC_SEQ_CST); \
+    case AMO_XOR:  return __atomic_fetch_xor(p, v, __ATOMIC_SEQ_CST); \
+    case AMO_AND:  return __atomic_fetch_and(p, v, __ATOMIC_SEQ_CST); \
+    case AMO_OR:   return __atomic_fetch_or (p, v, __ATOMIC_SEQ_CST); \
+  } \
+  uint##bits##_t old = __atomic_load_n(p, __ATOMIC_RELAXED), new; \
+  do { \
+    switch (op) { \
+      case AMO_MIN:  new = ((int##bits##_t)old < (int##bits##_t)v ? old : v); break; \
+      case AMO_MAX:  new = ((int##bits##_t)old > (int##bits##_t)v ? old : v); break; \
+      case AMO_MINU: new = (old < v ? old : v); break; \
+      default:       new = (old > v ? old : v); break; \
+    } \
+  } while (!__atomic_compare_exchange_n(p, &old, new, true, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED)); \
+  return old; \
+}
+AMO_FN(32)
+IFDEF(CONFIG_ISA64, AMO_FN(64))
+
+// return the old value sign-extended
+static inline word_t amo(Decode *s, vaddr_t addr, int len, int op, word_t v) {
+  void *p = amo_host(s, addr, len);
+  if (p == NULL) return 0;
+  word_t old = (len == 4 ? (word_t)(int32_t)amo32(p, op, v) : MUXDEF(CONFIG_ISA64, amo64(p, op, v), 0));
+  paddr_atomic_written(addr, len);
+  return old;
+}
+
+static inline word_t lr(Decode *s, vaddr_t addr, int len) {
+  void *p = amo_host(s, addr, len);
+  if (p == NULL) return 0;
+  word_t val = (len == 4 ? (word_t)(int32_t)__atomic_load_n((uint32_t *)p, __ATOMIC_SEQ_CST) :
+      MUXDEF(CONFIG_ISA64, __atomic_load_n((uint64_t *)p, __ATOMIC_SEQ_CST), 0));
+  *RESV() = (Reservation) { .valid = true, .addr = addr, .val = val };
+  return val;
+}
+
+// return 0 on success, and 1 on failure
+static inline word_t sc(Decode *s, vaddr_t addr, int len, word_t v) {
+  Reservation *r = RESV();
+  bool valid = r->valid && r->addr == addr;
+  r->valid = false;
+  void *p = amo_host(s, addr, len);
+  if (p == NULL || !valid) return 1;
+  bool ok = (len == 4 ?
+      __atomic_compare_exchange_n((uint32_t *)p, &(uint32_t){ r->val }, v, false, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED) :
+      MUXDEF(CONFIG_ISA64, __atomic_compare_exchange_n((uint64_t *)p, &(uint64_t){ r->val }, v, false,
+          __ATOMIC_SEQ_CST, __ATOMIC_RELAXED), false));
+  if (!ok) return 1;
+  paddr_atomic_written(addr, len);
+  return 0;
+}
+#endif
+
+#ifdef CONFIG_RVF
+#define F(i) (cpu.fpr[i])
+#define RS3 (imm & 0x1f)
+#define RM (imm >> 5)
+// a double is accessed in two halves without RV64, where word_t has 32 bits
+#define Mr_d(addr) MUXDEF(CONFIG_ISA64, Mr(addr, 8), (Mr(addr, 4) | ((uint64_t)Mr((addr) + 4, 4) << 32)))
+#define Mw_d(addr, data) MUXDEF(CONFIG_ISA64, Mw(addr, 8, data), \
+    do { Mw(addr, 4, (uint32_t)(data)); Mw((addr) + 4, 4, (data) >> 32); } while (0))
+#endif
+
+/* The CSR number is mapped to the compact ID by a table lookup. As required,
+ * csrrs and csrrc do not write the CSR if rs1 is $zero or the immediate
+ * is 0, so the hook of a read-only access is not run. */
+enum { CSR_RW, CSR_RS, CSR_RC };
+
+static inline word_t csr_access(Decode *s, uint32_t no, int op, word_t val, bool write) {
+  int id = csr_id[no] - 1;
+  if (unlikely(id < 0)) { INV(s->pc); return 0; }
+  word_t old = cpu.csr[id];
+  if (write) csr_write(id, op == CSR_RW ? val : (op == CSR_RS ? old | val : old & ~val));
+  return old;
+}
+
+/* An ebreak between `slli x0, x0, 0x1f` and `srai x0, x0, 7` is a semihosting
+ * call. The pc is taken as a guest physical address, which is the case when
+ * the guest runs without paging. */
+#ifdef CONFIG_SEMIHOSTING
+// an instruction next to ebreak, or 0 if it is not in pmem
+static inline uint32_t sh_inst(paddr_t addr) {
+  if (!in_pmem(addr) || !in_pmem(addr + 3)) return 0;
+  return *(uint32_t *)guest_to_host(addr);
+}
+#endif
+
+// flush the translations of the page of `addr`, or of all pages if rs1 is x0
+static inline void sfence_vma(Decode *s, vaddr_t addr) {
+  if (BITS(s->isa.inst, 19, 15) != 0) vaddr_tlb_flush_range(addr, 1);
+  else vaddr_tlb_flush();
+  // the decode cache is indexed by vaddr, as for a write to satp
+  IFDEF(CONFIG_DECODE_CACHE, flush_decode_cache());
+}
+
+static inline void ebreak(Decode *s) {
+#ifdef CONFIG_SEMIHOSTING
+  if (s->snpc == s->pc + 4 &&
+      sh_inst(s->pc - 4) == 0x01f01013 && sh_inst(s->pc + 4) == 0x40705013) {
+    R(10) = semihost_call(R(10), R(11), R(12), R(13));
+    return;
+  }
+#endif
+  NEMUTRAP(s->pc, R(10)); // R(10) is $a0
+}
+
+static int decode_exec(Decode *s, MUXDEF(CONFIG_DECODE_CACHE, const DecodeCacheEntry, void) *cached) {
   s->dnpc = s->snpc;
+  int rd = 0;
+  word_t src1 = 0, src2 = 0, imm = 0;
 
-#define INSTPAT_INST(s) ((s)->isa.inst)
+#define INSTPAT_INST(s) INST(s)
 #define INSTPAT_MATCH(s, name, type, ... /* execute body */ ) { \
-  int rd = 0; \
-  word_t src1 = 0, src2 = 0, imm = 0; \
   decode_operand(s, &rd, &src1, &src2, &imm, concat(TYPE_, type)); \
+  IFDEF(CONFIG_DECODE_CACHE, \
+    DCACHE_AOT(name, rd, imm, concat(TYPE_, type), &&concat(__instpat_exec_, __LINE__)); \
+    dcache_fill(s, rd, imm, concat(TYPE_, type), &&concat(__instpat_exec_, __LINE__)); \
+    DCACHE_HANDLER(type)) \
   __VA_ARGS__ ; \
+  INSTPAT_STAT(s, name); \
 }
 
+#ifdef CONFIG_DECODE_CACHE
+  if (cached != NULL) {
+    IFNDEF(CONFIG_DECODE_THREADED, decode_operand_cached(cached, &rd, &src1, &src2, &imm, cached->type));
+    goto *(cached->exec);
+  }
+#endif
   INSTPAT_START();
   INSTPAT("??????? ????? ????? ??? ????? 00101 11", auipc  , U, R(rd) = s->pc + imm);
   INSTPAT("??????? ????? ????? 100 ????? 00000 11", lbu    , I, R(rd) = Mr(src1 + imm, 1));
   INSTPAT("??????? ????? ????? 000 ????? 01000 11", sb     , S, Mw(src1 + imm, 1, src2));
+  // the shamt has 6 bits on RV64, the rest of the immediate tells srai from srli
+  INSTPAT("000000? ????? ????? 001 ????? 00100 11", slli   , I, R(rd) = src1 << (imm & (XLEN - 1)));
+  INSTPAT("010000? ????? ????? 101 ????? 00100 11", srai   , I, R(rd) = (sword_t)src1 >> (imm & (XLEN - 1)));
 
-  INSTPAT("0000000 00001 00000 000 00000 11100 11", ebreak , N, NEMUTRAP(s->pc, R(10))); // R(10) is $a0
+  INSTPAT("0000001 ????? ????? 000 ????? 01100 11", mul    , R, R(rd) = src1 * src2);
+  INSTPAT("0000001 ????? ????? 001 ????? 01100 11", mulh   , R, R(rd) = mul_h(src1, src2));
+  INSTPAT("0000001 ????? ????? 010 ????? 01100 11", mulhsu , R, R(rd) = mul_hsu(src1, src2));
+  INSTPAT("0000001 ????? ????? 011 ????? 01100 11", mulhu  , R, R(rd) = mul_hu(src1, src2));
+  INSTPAT("0000001 ????? ????? 100 ????? 01100 11", div    , R, R(rd) = div_s(src1, src2));
+  INSTPAT("0000001 ????? ????? 101 ????? 01100 11", divu   , R, R(rd) = div_u(src1, src2));
+  INSTPAT("0000001 ????? ????? 110 ????? 01100 11", rem    , R, R(rd) = rem_s(src1, src2));
+  INSTPAT("0000001 ????? ????? 111 ????? 01100 11", remu   , R, R(rd) = rem_u(src1, src2));
+
+#ifdef CONFIG_ISA64
+  INSTPAT("??????? ????? ????? 110 ????? 00000 11", lwu    , I, R(rd) = Mr(src1 + imm, 4));
+  INSTPAT("??????? ????? ????? 011 ????? 00000 11", ld     , I, R(rd) = Mr(src1 + imm, 8));
+  INSTPAT("??????? ????? ????? 011 ????? 01000 11", sd     , S, Mw(src1 + imm, 8, src2));
+
+  INSTPAT("??????? ????? ????? 000 ????? 00110 11", addiw  , I, R(rd) = SEXTW(src1 + imm));
+  INSTPAT("0000000 ????? ????? 001 ????? 00110 11", slliw  , I, R(rd) = sll_w(src1, imm));
+  INSTPAT("0000000 ????? ????? 101 ????? 00110 11", srliw  , I, R(rd) = srl_w(src1, imm));
+  INSTPAT("0100000 ????? ????? 101 ????? 00110 11", sraiw  , I, R(rd) = sra_w(src1, imm));
+  INSTPAT("0000000 ????? ????? 000 ????? 01110 11", addw   , R, R(rd) = SEXTW(src1 + src2));
+  INSTPAT("0100000 ????? ????? 000 ????? 01110 11", subw   , R, R(rd) = SEXTW(src1 - src2));
+  INSTPAT("0000000 ????? ????? 001 ????? 01110 11", sllw   , R, R(rd) = sll_w(src1, src2));
+  INSTPAT("0000000 ????? ????? 101 ????? 01110 11", srlw   , R, R(rd) = srl_w(src1, src2));
+  INSTPAT("0100000 ????? ????? 101 ????? 01110 11", sraw   , R, R(rd) = sra_w(src1, src2));
+
+  INSTPAT("0000001 ????? ????? 000 ????? 01110 11", mulw   , R, R(rd) = SEXTW(src1 * src2));
+  INSTPAT("0000001 ????? ????? 100 ????? 01110 11", divw   , R, R(rd) = div_w(src1, src2));
+  INSTPAT("0000001 ????? ????? 101 ????? 01110 11", divuw  , R, R(rd) = div_uw(src1, src2));
+  INSTPAT("0000001 ????? ????? 110 ????? 01110 11", remw   , R, R(rd) = rem_w(src1, src2));
+  INSTPAT("0000001 ????? ????? 111 ????? 01110 11", remuw  , R, R(rd) = rem_uw(src1, src2));
+#endif
+
+#ifdef CONFIG_RVA
+  INSTPAT("00010?? 00000 ????? 010 ????? 01011 11", lr.w   , R, R(rd) = lr(s, src1, 4));
+  INSTPAT("00011?? ????? ????? 010 ????? 01011 11", sc.w   , R, R(rd) = sc(s, src1, 4, src2));
+  INSTPAT("00001?? ????? ????? 010 ????? 01011 11", amoswap.w, R, R(rd) = amo(s, src1, 4, AMO_SWAP, src2));
+  INSTPAT("00000?? ????? ????? 010 ????? 01011 11", amoadd.w , R, R(rd) = amo(s, src1, 4, AMO_ADD , src2));
+  INSTPAT("00100?? ????? ????? 010 ????? 01011 11", amoxor.w , R, R(rd) = amo(s, src1, 4, AMO_XOR , src2));
+  INSTPAT("01100?? ????? ????? 010 ????? 01011 11", amoand.w , R, R(rd) = amo(s, src1, 4, AMO_AND , src2));
+  INSTPAT("01000?? ????? ????? 010 ????? 01011 11", amoor.w  , R, R(rd) = amo(s, src1, 4, AMO_OR  , src2));
+  INSTPAT("10000?? ????? ????? 010 ????? 01011 11", amomin.w , R, R(rd) = amo(s, src1, 4, AMO_MIN , src2));
+  INSTPAT("10100?? ????? ????? 010 ????? 01011 11", amomax.w , R, R(rd) = amo(s, src1, 4, AMO_MAX , src2));
+  INSTPAT("11000?? ????? ????? 010 ????? 01011 11", amominu.w, R, R(rd) = amo(s, src1, 4, AMO_MINU, src2));
+  INSTPAT("11100?? ????? ????? 010 ????? 01011 11", amomaxu.w, R, R(rd) = amo(s, src1, 4, AMO_MAXU, src2));
+#ifdef CONFIG_ISA64
+  INSTPAT("00010?? 00000 ????? 011 ????? 01011 11", lr.d   , R, R(rd) = lr(s, src1, 8));
+  INSTPAT("00011?? ????? ????? 011 ????? 01011 11", sc.d   , R, R(rd) = sc(s, src1, 8, src2));
+  INSTPAT("00001?? ????? ????? 011 ????? 01011 11", amoswap.d, R, R(rd) = amo(s, src1, 8, AMO_SWAP, src2));
+  INSTPAT("00000?? ????? ????? 011 ????? 01011 11", amoadd.d , R, R(rd) = amo(s, src1, 8, AMO_ADD , src2));
+  INSTPAT("00100?? ????? ????? 011 ????? 01011 11", amoxor.d , R, R(rd) = amo(s, src1, 8, AMO_XOR , src2));
+  INSTPAT("01100?? ????? ????? 011 ????? 01011 11", amoand.d , R, R(rd) = amo(s, src1, 8, AMO_AND , src2));
+  INSTPAT("01000?? ????? ????? 011 ????? 01011 11", amoor.d  , R, R(rd) = amo(s, src1, 8, AMO_OR  , src2));
+  INSTPAT("10000?? ????? ????? 011 ????? 01011 11", amomin.d , R, R(rd) = amo(s, src1, 8, AMO_MIN , src2));
+  INSTPAT("10100?? ????? ????? 011 ????? 01011 11", amomax.d , R, R(rd) = amo(s, src1, 8, AMO_MAX , src2));
+  INSTPAT("11000?? ????? ????? 011 ????? 01011 11", amominu.d, R, R(rd) = amo(s, src1, 8, AMO_MINU, src2));
+  INSTPAT("11100?? ????? ????? 011 ????? 01011 11", amomaxu.d, R, R(rd) = amo(s, src1, 8, AMO_MAXU, src2));
+#endif
+#endif
+
+#ifdef CONFIG_RVF
+  INSTPAT("??????? ????? ????? 010 ????? 00001 11", flw    , I , F(rd) = FPU_BOX(Mr(src1 + imm, 4)));
+  INSTPAT("??????? ????? ????? 010 ????? 01001 11", fsw    , FS, Mw(src1 + imm, 4, (uint32_t)F(src2)));
+  INSTPAT("?????00 ????? ????? ??? ????? 10000 11", fmadd.s  , F, F(rd) = fmadd_s(F(src1), F(src2), F(RS3), RM, false, false));
+  INSTPAT("?????00 ????? ????? ??? ????? 10001 11", fmsub.s  , F, F(rd) = fmadd_s(F(src1), F(src2), F(RS3), RM, false, true));
+  INSTPAT("?????00 ????? ????? ??? ????? 10010 11", fnmsub.s , F, F(rd) = fmadd_s(F(src1), F(src2), F(RS3), RM, true, false));
+  INSTPAT("?????00 ????? ????? ??? ????? 10011 11", fnmadd.s , F, F(rd) = fmadd_s(F(src1), F(src2), F(RS3), RM, true, true));
+  INSTPAT("0000000 ????? ????? ??? ????? 10100 11", fadd.s   , F, F(rd) = fadd_s(F(src1), F(src2), RM));
+  INSTPAT("0000100 ????? ????? ??? ????? 10100 11", fsub.s   , F, F(rd) = fsub_s(F(src1), F(src2), RM));
+  INSTPAT("0001000 ????? ????? ??? ????? 10100 11", fmul.s   , F, F(rd) = fmul_s(F(src1), F(src2), RM));
+  INSTPAT("0001100 ????? ????? ??? ????? 10100 11", fdiv.s   , F, F(rd) = fdiv_s(F(src1), F(src2), RM));
+  INSTPAT("0101100 00000 ????? ??? ????? 10100 11", fsqrt.s  , F, F(rd) = fsqrt_s(F(src1), RM));
+  INSTPAT("0010000 ????? ????? 000 ????? 10100 11", fsgnj.s  , F, F(rd) = fsgnj_s(F(src1), F(src2), 0));
+  INSTPAT("0010000 ????? ????? 001 ????? 10100 11", fsgnjn.s , F, F(rd) = fsgnj_s(F(src1), F(src2), 1));
+  INSTPAT("0010000 ????? ????? 010 ????? 10100 11", fsgnjx.s , F, F(rd) = fsgnj_s(F(src1), F(src2), 2));
+  INSTPAT("0010100 ????? ????? 000 ????? 10100 11", fmin.s   , F, F(rd) = fminmax_s(F(src1), F(src2), false));
+  INSTPAT("0010100 ????? ????? 001 ????? 10100 11", fmax.s   , F, F(rd) = fminmax_s(F(src1), F(src2), true));
+  INSTPAT("1100000 00000 ????? ??? ????? 10100 11", fcvt.w.s , F, R(rd) = fcvt_to_int_s(F(src1), RM, 32, true));
+  INSTPAT("1100000 00001 ????? ??? ????? 10100 11", fcvt.wu.s, F, R(rd) = fcvt_to_int_s(F(src1), RM, 32, false));
+  INSTPAT("1110000 00000 ????? 000 ????? 10100 11", fmv.x.w  , F, R(rd) = SEXT(F(src1), 32));
+  INSTPAT("1010000 ????? ????? 010 ????? 10100 11", feq.s    , F, R(rd) = fcmp_s(F(src1), F(src2), 2));
+  INSTPAT("1010000 ????? ????? 001 ????? 10100 11", flt.s    , F, R(rd) = fcmp_s(F(src1), F(src2), 1));
+  INSTPAT("1010000 ????? ????? 000 ????? 10100 11", fle.s    , F, R(rd) = fcmp_s(F(src1), F(src2), 0));
+  INSTPAT("1110000 00000 ????? 001 ????? 10100 11", fclass.s , F, R(rd) = fclass_s(F(src1)));
+  INSTPAT("1101000 00000 ????? ??? ????? 10100 11", fcvt.s.w , F, F(rd) = fcvt_from_int_s((int32_t)R(src1), RM, true));
+  INSTPAT("1101000 00001 ????? ??? ????? 10100 11", fcvt.s.wu, F, F(rd) = fcvt_from_int_s((uint32_t)R(src1), RM, false));
+  INSTPAT("1111000 00000 ????? 000 ????? 10100 11", fmv.w.x  , F, F(rd) = FPU_BOX(R(src1)));
+#ifdef CONFIG_ISA64
+  INSTPAT("1100000 00010 ????? ??? ????? 10100 11", fcvt.l.s , F, R(rd) = fcvt_to_int_s(F(src1), RM, 64, true));
+  INSTPAT("1100000 00011 ????? ??? ????? 10100 11", fcvt.lu.s, F, R(rd) = fcvt_to_int_s(F(src1), RM, 64, false));
+  INSTPAT("1101000 00010 ????? ??? ????? 10100 11", fcvt.s.l , F, F(rd) = fcvt_from_int_s(R(src1), RM, true));
+  INSTPAT("1101000 00011 ????? ??? ????? 10100 11", fcvt.s.lu, F, F(rd) = fcvt_from_int_s(R(src1), RM, false));
+#endif
+#endif
+#ifdef CONFIG_RVD
+  INSTPAT("??????? ????? ????? 011 ????? 00001 11", fld    , I , F(rd) = Mr_d(src1 + imm));
+  INSTPAT("??????? ????? ????? 011 ????? 01001 11", fsd    , FS, Mw_d(src1 + imm, F(src2)));
+  INSTPAT("?????01 ????? ????? ??? ????? 10000 11", fmadd.d  , F, F(rd) = fmadd_d(F(src1), F(src2), F(RS3), RM, false, false));
+  INSTPAT("?????01 ????? ????? ??? ????? 10001 11", fmsub.d  , F, F(rd) = fmadd_d(F(src1), F(src2), F(RS3), RM, false, true));
+  INSTPAT("?????01 ????? ????? ??? ????? 10010 11", fnmsub.d , F, F(rd) = fmadd_d(F(src1), F(src2), F(RS3), RM, true, false));
+  INSTPAT("?????01 ????? ????? ??? ????? 10011 11", fnmadd.d , F, F(rd) = fmadd_d(F(src1), F(src2), F(RS3), RM, true, true));
+  INSTPAT("0000001 ????? ????? ??? ????? 10100 11", fadd.d   , F, F(rd) = fadd_d(F(src1), F(src2), RM));
+  INSTPAT("0000101 ????? ????? ??? ????? 10100 11", fsub.d   , F, F(rd) = fsub_d(F(src1), F(src2), RM));
+  INSTPAT("0001001 ????? ????? ??? ????? 10100 11", fmul.d   , F, F(rd) = fmul_d(F(src1), F(src2), RM));
+  INSTPAT("0001101 ????? ????? ??? ????? 10100 11", fdiv.d   , F, F(rd) = fdiv_d(F(src1), F(src2), RM));
+  INSTPAT("0101101 00000 ????? ??? ????? 10100 11", fsqrt.d  , F, F(rd) = fsqrt_d(F(src1), RM));
+  INSTPAT("0010001 ????? ????? 000 ????? 10100 11", fsgnj.d  , F, F(rd) = fsgnj_d(F(src1), F(src2), 0));
+  INSTPAT("0010001 ????? ????? 001 ????? 10100 11", fsgnjn.d , F, F(rd) = fsgnj_d(F(src1), F(src2), 1));
+  INSTPAT("0010001 ????? ????? 010 ????? 10100 11", fsgnjx.d , F, F(rd) = fsgnj_d(F(src1), F(src2), 2));
+  INSTPAT("0010101 ????? ????? 000 ????? 10100 11", fmin.d   , F, F(rd) = fminmax_d(F(src1), F(src2), false));
+  INSTPAT("0010101 ????? ????? 001 ????? 10100 11", fmax.d   , F, F(rd) = fminmax_d(F(src1), F(src2), true));
+  INSTPAT("1100001 00000 ????? ??? ????? 10100 11", fcvt.w.d , F, R(rd) = fcvt_to_int_d(F(src1), RM, 32, true));
+  INSTPAT("1100001 00001 ????? ??? ????? 10100 11", fcvt.wu.d, F, R(rd) = fcvt_to_int_d(F(src1), RM, 32, false));
+  INSTPAT("0100000 00001 ????? ??? ????? 10100 11", fcvt.s.d , F, F(rd) = fcvt_s_d(F(src1), RM));
+  INSTPAT("0100001 00000 ????? ??? ????? 10100 11", fcvt.d.s , F, F(rd) = fcvt_d_s(F(src1)));
+  INSTPAT("1010001 ????? ????? 010 ????? 10100 11", feq.d    , F, R(rd) = fcmp_d(F(src1), F(src2), 2));
+  INSTPAT("1010001 ????? ????? 001 ????? 10100 11", flt.d    , F, R(rd) = fcmp_d(F(src1), F(src2), 1));
+  INSTPAT("1010001 ????? ????? 000 ????? 10100 11", fle.d    , F, R(rd) = fcmp_d(F(src1), F(src2), 0));
+  INSTPAT("1110001 00000 ????? 001 ????? 10100 11", fclass.d , F, R(rd) = fclass_d(F(src1)));
+  INSTPAT("1101001 00000 ????? ??? ????? 10100 11", fcvt.d.w , F, F(rd) = fcvt_from_int_d((int32_t)R(src1), RM, true));
+  INSTPAT("1101001 00001 ????? ??? ????? 10100 11", fcvt.d.wu, F, F(rd) = fcvt_from_int_d((uint32_t)R(src1), RM, false));
+#ifdef CONFIG_ISA64
+  INSTPAT("1100001 00010 ????? ??? ????? 10100 11", fcvt.l.d , F, R(rd) = fcvt_to_int_d(F(src1), RM, 64, true));
+  INSTPAT("1100001 00011 ????? ??? ????? 10100 11", fcvt.lu.d, F, R(rd) = fcvt_to_int_d(F(src1), RM, 64, false));
+  INSTPAT("1101001 00010 ????? ??? ????? 10100 11", fcvt.d.l , F, F(rd) = fcvt_from_int_d(R(src1), RM, true));
+  INSTPAT("1101001 00011 ????? ??? ????? 10100 11", fcvt.d.lu, F, F(rd) = fcvt_from_int_d(R(src1), RM, false));
+  INSTPAT("1110001 00000 ????? 000 ????? 10100 11", fmv.x.d  , F, R(rd) = F(src1));
+  INSTPAT("1111001 00000 ????? 000 ????? 10100 11", fmv.d.x  , F, F(rd) = R(src1));
+#endif
+#endif
+
+  INSTPAT("??????? ????? ????? 001 ????? 11100 11", csrrw  , CSR, R(rd) = csr_access(s, imm, CSR_RW, src1, true));
+  INSTPAT("??????? ????? ????? 010 ????? 11100 11", csrrs  , CSR, R(rd) = csr_access(s, imm, CSR_RS, src1, src2 != 0));
+  INSTPAT("??????? ????? ????? 011 ????? 11100 11", csrrc  , CSR, R(rd) = csr_access(s, imm, CSR_RC, src1, src2 != 0));
+  INSTPAT("??????? ????? ????? 101 ????? 11100 11", csrrwi , CSR, R(rd) = csr_access(s, imm, CSR_RW, src2, true));
+  INSTPAT("??????? ????? ????? 110 ????? 11100 11", csrrsi , CSR, R(rd) = csr_access(s, imm, CSR_RS, src2, src2 != 0));
+  INSTPAT("??????? ????? ????? 111 ????? 11100 11", csrrci , CSR, R(rd) = csr_access(s, imm, CSR_RC, src2, src2 != 0));
+  INSTPAT("0000000 00000 00000 000 00000 11100 11", ecall  , N, MUXDEF(CONFIG_MODE_USER,
+        R(10) = user_syscall(R(17), R(10), R(11), R(12), R(13), R(14), R(15)),
+        s->dnpc = isa_raise_intr(EXC_ECALL_M, s->pc)));
+  INSTPAT("0011000 00010 00000 000 00000 11100 11", mret   , N, s->dnpc = isa_mret());
+  INSTPAT("0000000 00001 00000 000 00000 11100 11", ebreak , N, ebreak(s));
+  INSTPAT("0001001 ????? ????? 000 00000 11100 11", sfence.vma, R, sfence_vma(s, src1));
   INSTPAT("??????? ????? ????? ??? ????? ????? ??", inv    , N, INV(s->pc));
   INSTPAT_END();
 
@@ -72,7 +674,189 @@ static int decode_exec(Decode *s) {
   return 0;
 }
 
+#ifdef CONFIG_RVC
+uint32_t rvc_expand(uint32_t c);
+
+// a 4-byte aligned word never crosses a page, and holds the first half of
+// an instruction, or a compressed one in its lower half
+static inline uint32_t rvc_fetch(vaddr_t *pc) {
+  uint32_t inst;
+  if (likely((*pc & 3) == 0)) {
+    inst = vaddr_ifetch(*pc, 4);
+    if (unlikely((inst & 3) != 3)) inst &= 0xffff;
+  } else {
+    inst = vaddr_ifetch(*pc, 2);
+    if ((inst & 3) == 3) inst |= vaddr_ifetch(*pc + 2, 2) << 16;
+  }
+  *pc += ILEN(inst);
+  return inst;
+}
+#endif
+
+#ifdef CONFIG_DECODE_FUSION
+// execute the pair headed by the auipc cached in `e`, and return false if
+// the access may raise an exception
+static inline bool exec_fused(Decode *s, DecodeCacheEntry *e) {
+  uint32_t i = e->inst2;
+  bool store = (BITS(i, 6, 0) == 0x23);
+  word_t base = s->pc + e->imm;
+  word_t addr = base + (store ? (SEXT(BITS(i, 31, 25), 7) << 5) | BITS(i, 11, 7) : SEXT(BITS(i, 31, 20), 12));
+  int len = fuse_len[e->fuse];
+  if (unlikely((addr & (len - 1)) != 0 || !in_pmem(addr) || !in_pmem(addr + len - 1))) return false;
+  R(e->rd) = base;
+  int r2 = (store ? BITS(i, 24, 20) : BITS(i, 11, 7));
+  switch (e->fuse) {
+    case FUSE_LBU: R(r2) = Mr(addr, 1); break;
+    case FUSE_SB:  Mw(addr, 1, R(r2)); break;
+#ifdef CONFIG_ISA64
+    case FUSE_LWU: R(r2) = Mr(addr, 4); break;
+    case FUSE_LD:  R(r2) = Mr(addr, 8); break;
+    case FUSE_SD:  Mw(addr, 8, R(r2)); break;
+#endif
+#ifdef CONFIG_RVF
+    case FUSE_FLW: F(r2) = FPU_BOX(Mr(addr, 4)); break;
+#endif
+#ifdef CONFIG_RVD
+    case FUSE_FLD: F(r2) = Mr_d(addr); break;
+#endif
+  }
+  R(0) = 0;
+  s->snpc += 4;
+  s->dnpc = s->snpc;
+  s->ninst = 2;
+  return true;
+}
+#endif
+
 int isa_exec_once(Decode *s) {
+  IFDEF(CONFIG_DECODE_FUSION, int may_fuse = s->ninst; s->ninst = 1);
+#ifdef CONFIG_DECODE_CACHE
+  DecodeCacheEntry *e = dcache_entry(s->pc);
+  if (likely(e->pc == s->pc)) {
+    s->isa.inst = e->inst;
+    s->snpc += MUXDEF(CONFIG_RVC, ILEN(e->inst), 4);
+    IFDEF(CONFIG_DECODE_FUSION, if (e->fuse != FUSE_NONE && may_fuse > 1 && exec_fused(s, e)) return 0);
+    return decode_exec(s, e);
+  }
+#endif
+#ifdef CONFIG_RVC
+  s->isa.inst = rvc_fetch(&s->snpc);
+  s->isa.einst = rvc_expand(s->isa.inst);
+#else
   s->isa.inst = inst_fetch(&s->snpc, 4);
-  return decode_exec(s);
+#endif
+  return decode_exec(s, NULL);
+}
+
+#ifdef CONFIG_ENGINE_BLOCK
+bool isa_block_save(Decode *s, BlockInst *bi) {
+  DecodeCacheEntry *e = dcache_entry(s->pc);
+  // dropped if the instruction has written its own page
+  if (e->pc != s->pc) return false;
+  *bi = *e;
+  return true;
+}
+
+// ecall, ebreak, the CSR instructions and the returns from traps may stop
+// the run or change what is executed next other than by jumping
+bool isa_block_end(const BlockInst *bi) {
+  return BITS(bi->inst, 6, 0) == 0x73 || MUXDEF(CONFIG_RVC, bi->inst == 0x9002, false); // c.ebreak
+}
+
+int isa_block_exec(Decode *s, const BlockInst *bi) {
+  s->pc = bi->pc;
+  s->snpc = bi->pc + MUXDEF(CONFIG_RVC, ILEN(bi->inst), 4);
+  s->isa.inst = bi->inst;
+  return decode_exec(s, bi);
+}
+#endif
+
+#ifdef CONFIG_DECODE_CACHE_AOT
+/* Decode the code of the image loaded at RESET_VECTOR ahead of time. The
+ * walk starts from the entry and the function symbols, and follows the
+ * targets of jal and branches, the instruction after a branch or a call,
+ * and that after any instruction which does not jump. It stops at indirect
+ * jumps, returns from traps, ebreak and invalid instructions, whose
+ * successors are left to the decoding at runtime. An entry of the decode
+ * cache taken by another pc is not replaced, so that it keeps what is
+ * loaded from --dcache, or else the code walked first from the entry. */
+#define immJ(i) SEXT((BITS(i, 31, 31) << 20) | (BITS(i, 19, 12) << 12) | (BITS(i, 20, 20) << 11) | (BITS(i, 30, 21) << 1), 21)
+#define immB(i) SEXT((BITS(i, 31, 31) << 12) | (BITS(i, 7, 7) << 11) | (BITS(i, 30, 25) << 5) | (BITS(i, 11, 8) << 1), 13)
+
+static vaddr_t *aot_stack = NULL;
+static int aot_top = 0, aot_size = 0;
+static uint8_t *aot_visited = NULL; // a bit for each halfword of the image
+static vaddr_t aot_lo = 0, aot_hi = 0;
+
+static void aot_push(vaddr_t pc) {
+  if (pc < aot_lo || pc >= aot_hi || (pc & (MUXDEF(CONFIG_RVC, 2, 4) - 1)) != 0) return;
+  uint64_t idx = (pc - aot_lo) >> 1;
+  if (aot_visited[idx / 8] & (1 << (idx % 8))) return;
+  aot_visited[idx / 8] |= 1 << (idx % 8);
+  if (aot_top == aot_size) {
+    aot_size = (aot_size == 0 ? 1024 : aot_size * 2);
+    aot_stack = realloc(aot_stack, sizeof(*aot_stack) * aot_size);
+    assert(aot_stack != NULL);
+  }
+  aot_stack[aot_top ++] = pc;
+}
+
+// decode the instruction at `pc` without executing it, and push its successors
+static bool aot_decode(vaddr_t pc) {
+  Decode s = { .pc = pc };
+  uint32_t inst = host_read(guest_to_host(pc), 2);
+  if (ILEN(inst) == 4) {
+    if (pc + 4 > aot_hi) return false;
+    inst |= host_read(guest_to_host(pc + 2), 2) << 16;
+  }
+  s.snpc = pc + ILEN(inst);
+  s.isa.inst = inst;
+  IFDEF(CONFIG_RVC, s.isa.einst = (ILEN(inst) == 2 ? rvc_expand(inst) : inst));
+  if (decode_exec(&s, NULL) != 0) return false;
+
+  uint32_t i = INST(&s);
+  int rd = BITS(i, 11, 7);
+  switch (BITS(i, 6, 0)) {
+    case 0x6f: // jal
+      aot_push(pc + immJ(i));
+      if (rd != 0) aot_push(s.snpc);
+      break;
+    case 0x63: aot_push(pc + immB(i)); aot_push(s.snpc); break; // branches
+    case 0x67: if (rd != 0) aot_push(s.snpc); break; // jalr
+    case 0x73: // mret, sret and ebreak do not fall through
+      if (i != 0x30200073 && i != 0x10200073 && i != 0x00100073) aot_push(s.snpc);
+      break;
+    default: aot_push(s.snpc); break;
+  }
+  return true;
+}
+
+void isa_decode_cache_aot(long img_size) {
+  aot_lo = RESET_VECTOR;
+  aot_hi = RESET_VECTOR + img_size;
+  aot_visited = calloc((img_size / 2 + 7) / 8 + 1, 1);
+  assert(aot_visited != NULL);
+  int nr = symbol_count(), j;
+  for (j = 0; j < nr; j ++) {
+    vaddr_t start;
+    word_t size;
+    symbol_get(j, &start, &size);
+    aot_push(start);
+  }
+  // the entry is on the top of the stack, to be walked first
+  aot_push(cpu.pc);
+
+  int nr_inst = 0, nr_fill = 0;
+  for (j = 0; j < DCACHE_SIZE; j ++) nr_fill -= (dcache[j].pc != DCACHE_INVALID_PC);
+  dcache_aot = true;
+  while (aot_top > 0) nr_inst += aot_decode(aot_stack[-- aot_top]);
+  dcache_aot = false;
+  for (j = 0; j < DCACHE_SIZE; j ++) nr_fill += (dcache[j].pc != DCACHE_INVALID_PC);
+
+  free(aot_stack);
+  free(aot_visited);
+  aot_stack = NULL;
+  aot_top = aot_size = 0;
+  Log("Decoded %d instructions reachable in the image ahead of time, %d of them cached", nr_inst, nr_fill);
 }
+#endif
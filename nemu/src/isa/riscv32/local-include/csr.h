@@ -0,0 +1,50 @@
+/***************************************************************************************
+* Copyright (c) 2014-2024 Zihao Yu, Nanjing University
+*
+* NEMU is licensed under Mulan PSL v2.
+* You can use this software according to the terms and conditions of the Mulan PSL v2.
+* You may obtain a copy of Mulan PSL v2 at:
+*          http://license.coscl.org.cn/MulanPSL2
+*
+* THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+* EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+* MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+*
+* See the Mulan PSL v2 for more details.
+***************************************************************************************/
+
+#ifndef __RISCV_CSR_H__
+#define __RISCV_CSR_H__
+
+#include <isa.h>
+
+#define csr(name) (cpu.csr[concat(CSR_, name)])
+
+#define MSTATUS_MIE  0x8
+#define MSTATUS_MPIE 0x80
+#define MSTATUS_MPP  0x1800
+
+#define INTR_BIT ((word_t)1 << (sizeof(word_t) * 8 - 1))
+#define IRQ_MSI 3
+#define IRQ_MTI 7
+#define IRQ_MEI 11
+#define EXC_ECALL_M 11
+#define EXC_INST_ACCESS_FAULT  1
+#define EXC_LOAD_ACCESS_FAULT  5
+#define EXC_STORE_ACCESS_FAULT 7
+#define EXC_INST_PAGE_FAULT  12
+#define EXC_LOAD_PAGE_FAULT  13
+#define EXC_STORE_PAGE_FAULT 15
+
+// the compact ID plus 1 of each CSR number, 0 for one not implemented
+extern const uint8_t csr_id[4096];
+extern void (*const csr_hook[NR_CSR])();
+
+static inline void csr_write(int id, word_t val) {
+  cpu.csr[id] = val;
+  if (csr_hook[id] != NULL) csr_hook[id]();
+}
+
+vaddr_t isa_mret();
+
+#endif
@@ -0,0 +1,55 @@
+/***************************************************************************************
+* Copyright (c) 2014-2024 Zihao Yu, Nanjing University
+*
+* NEMU is licensed under Mulan PSL v2.
+* You can use this software according to the terms and conditions of the Mulan PSL v2.
+* You may obtain a copy of Mulan PSL v2 at:
+*          http://license.coscl.org.cn/MulanPSL2
+*
+* THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+* EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+* MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+*
+* See the Mulan PSL v2 for more details.
+***************************************************************************************/
+
+#ifndef __RISCV_FPU_H__
+#define __RISCV_FPU_H__
+
+#include <common.h>
+
+/* The operands and results are the raw bits of FP registers, where a single
+ * is NaN-boxed in the upper 32 bits if the D extension is used. `rm` is the
+ * field of the instruction, and 7 takes the rounding mode from frm. */
+#define FPU_DECL(s) \
+  uint64_t concat(fadd_, s)(uint64_t a, uint64_t b, int rm); \
+  uint64_t concat(fsub_, s)(uint64_t a, uint64_t b, int rm); \
+  uint64_t concat(fmul_, s)(uint64_t a, uint64_t b, int rm); \
+  uint64_t concat(fdiv_, s)(uint64_t a, uint64_t b, int rm); \
+  uint64_t concat(fsqrt_, s)(uint64_t a, int rm); \
+  /* a * b + c, with the product and the addend negated as told */ \
+  uint64_t concat(fmadd_, s)(uint64_t a, uint64_t b, uint64_t c, int rm, bool neg_prod, bool neg_add); \
+  /* mode 0, 1, 2 for fsgnj, fsgnjn, fsgnjx */ \
+  uint64_t concat(fsgnj_, s)(uint64_t a, uint64_t b, int mode); \
+  uint64_t concat(fminmax_, s)(uint64_t a, uint64_t b, bool max); \
+  /* mode 0, 1, 2 for fle, flt, feq */ \
+  word_t concat(fcmp_, s)(uint64_t a, uint64_t b, int mode); \
+  word_t concat(fclass_, s)(uint64_t a); \
+  /* to and from an integer of `bits`, sign-extended to XLEN */ \
+  word_t concat(fcvt_to_int_, s)(uint64_t a, int rm, int bits, bool is_signed); \
+  uint64_t concat(fcvt_from_int_, s)(uint64_t x, int rm, bool is_signed);
+
+FPU_DECL(s)
+#ifdef CONFIG_RVD
+FPU_DECL(d)
+#endif
+
+#ifdef CONFIG_RVD
+uint64_t fcvt_s_d(uint64_t a, int rm);
+uint64_t fcvt_d_s(uint64_t a);
+#define FPU_BOX(x) (0xffffffff00000000ull | (uint32_t)(x))
+#else
+#define FPU_BOX(x) ((uint32_t)(x))
+#endif
+
+#endif
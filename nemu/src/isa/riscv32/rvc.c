@@ -0,0 +1,173 @@
+/***************************************************************************************
+* Copyright (c) 2014-2024 Zihao Yu, Nanjing University
+*
+* NEMU is licensed under Mulan PSL v2.
+* You can use this software according to the terms and conditions of the Mulan PSL v2.
+* You may obtain a copy of Mulan PSL v2 at:
+*          http://license.coscl.org.cn/MulanPSL2
+*
+* THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+* EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+* MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+*
+* See the Mulan PSL v2 for more details.
+***************************************************************************************/
+
+
+#include <common.h>
+
+/* Expand a 16-bit instruction of the C extension into its 32-bit equivalent,
+ * or return 0 if it is reserved, which matches no instruction but inv. The
+ * expansion is done once when an instruction is decoded, and the decode cache
+ * keeps the expanded one, so that only the 32-bit instructions are executed. */
+
+#define C(hi, lo) BITS(c, hi, lo)
+#define RP(hi) (C(hi, hi - 2) + 8) // x8 - x15 of rs1', rs2' and rd'
+
+enum {
+  OP_LOAD = 0x03, OP_LOAD_FP = 0x07, OP_IMM = 0x13, OP_IMM_32 = 0x1b,
+  OP_STORE = 0x23, OP_STORE_FP = 0x27, OP_OP = 0x33, OP_LUI = 0x37, OP_OP_32 = 0x3b,
+  OP_BRANCH = 0x63, OP_JALR = 0x67, OP_JAL = 0x6f, OP_SYSTEM = 0x73,
+};
+
+static inline uint32_t enc_i(uint32_t op, int f3, int rd, int rs1, uint32_t imm) {
+  return (imm << 20) | (rs1 << 15) | (f3 << 12) | (rd << 7) | op;
+}
+
+static inline uint32_t enc_s(uint32_t op, int f3, int rs1, int rs2, uint32_t imm) {
+  return (BITS(imm, 11, 5) << 25) | (rs2 << 20) | (rs1 << 15) | (f3 << 12) | (BITS(imm, 4, 0) << 7) | op;
+}
+
+static inline uint32_t enc_r(uint32_t op, int f7, int f3, int rd, int rs1, int rs2) {
+  return (f7 << 25) | (rs2 << 20) | (rs1 << 15) | (f3 << 12) | (rd << 7) | op;
+}
+
+static inline uint32_t enc_b(int f3, int rs1, int rs2, uint32_t imm) {
+  return (BITS(imm, 12, 12) << 31) | (BITS(imm, 10, 5) << 25) | (rs2 << 20) | (rs1 << 15) |
+    (f3 << 12) | (BITS(imm, 4, 1) << 8) | (BITS(imm, 11, 11) << 7) | OP_BRANCH;
+}
+
+static inline uint32_t enc_j(int rd, uint32_t imm) {
+  return (BITS(imm, 20, 20) << 31) | (BITS(imm, 10, 1) << 21) | (BITS(imm, 11, 11) << 20) |
+    (BITS(imm, 19, 12) << 12) | (rd << 7) | OP_JAL;
+}
+
+// the immediates, named after the instructions using them
+#define imm6()     (SEXT((C(12, 12) << 5) | C(6, 2), 6) & 0xfff)
+#define uimm6()    ((C(12, 12) << 5) | C(6, 2))
+#define uimm_w()   ((C(5, 5) << 6) | (C(12, 10) << 3) | (C(6, 6) << 2))
+#define uimm_d()   ((C(6, 5) << 6) | (C(12, 10) << 3))
+#define uimm_lwsp() ((C(3, 2) << 6) | (C(12, 12) << 5) | (C(6, 4) << 2))
+#define uimm_ldsp() ((C(4, 2) << 6) | (C(12, 12) << 5) | (C(6, 5) << 3))
+#define uimm_swsp() ((C(8, 7) << 6) | (C(12, 9) << 2))
+#define uimm_sdsp() ((C(9, 7) << 6) | (C(12, 10) << 3))
+#define imm_j()    SEXT((C(12, 12) << 11) | (C(8, 8) << 10) | (C(10, 9) << 8) | (C(6, 6) << 7) | \
+                        (C(7, 7) << 6) | (C(2, 2) << 5) | (C(11, 11) << 4) | (C(5, 3) << 1), 12)
+#define imm_b()    SEXT((C(12, 12) << 8) | (C(6, 5) << 6) | (C(2, 2) << 5) | (C(11, 10) << 3) | \
+                        (C(4, 3) << 1), 9)
+
+static uint32_t expand_q0(uint32_t c) {
+  int rd = RP(4), rs1 = RP(9);
+  switch (C(15, 13)) {
+    case 0: { // c.addi4spn
+      uint32_t imm = (C(10, 7) << 6) | (C(12, 11) << 4) | (C(5, 5) << 3) | (C(6, 6) << 2);
+      return (imm == 0 ? 0 : enc_i(OP_IMM, 0, rd, 2, imm));
+    }
+    case 1: return enc_i(OP_LOAD_FP, 3, rd, rs1, uimm_d());        // c.fld
+    case 2: return enc_i(OP_LOAD, 2, rd, rs1, uimm_w());           // c.lw
+    case 3: return MUXDEF(CONFIG_ISA64,
+                enc_i(OP_LOAD, 3, rd, rs1, uimm_d()),              // c.ld
+                enc_i(OP_LOAD_FP, 2, rd, rs1, uimm_w()));          // c.flw
+    case 5: return enc_s(OP_STORE_FP, 3, rs1, rd, uimm_d());       // c.fsd
+    case 6: return enc_s(OP_STORE, 2, rs1, rd, uimm_w());          // c.sw
+    case 7: return MUXDEF(CONFIG_ISA64,
+                enc_s(OP_STORE, 3, rs1, rd, uimm_d()),             // c.sd
+                enc_s(OP_STORE_FP, 2, rs1, rd, uimm_w()));         // c.fsw
+    default: return 0;
+  }
+}
+
+static uint32_t expand_q1(uint32_t c) {
+  int rd = C(11, 7), rdp = RP(9), rs2p = RP(4);
+  switch (C(15, 13)) {
+    case 0: return enc_i(OP_IMM, 0, rd, rd, imm6());               // c.addi, c.nop
+#ifdef CONFIG_ISA64
+    case 1: return (rd == 0 ? 0 : enc_i(OP_IMM_32, 0, rd, rd, imm6())); // c.addiw
+#else
+    case 1: return enc_j(1, imm_j());                              // c.jal
+#endif
+    case 2: return enc_i(OP_IMM, 0, rd, 0, imm6());                // c.li
+    case 3:
+      if (rd == 2) {                                               // c.addi16sp
+        uint32_t imm = SEXT((C(12, 12) << 9) | (C(4, 3) << 7) | (C(5, 5) << 6) |
+            (C(2, 2) << 5) | (C(6, 6) << 4), 10);
+        return (imm == 0 ? 0 : enc_i(OP_IMM, 0, 2, 2, imm & 0xfff));
+      } else {                                                     // c.lui
+        uint32_t imm = SEXT((C(12, 12) << 5) | C(6, 2), 6);
+        return (imm == 0 ? 0 : (imm << 12) | (rd << 7) | OP_LUI);
+      }
+    case 4:
+      switch (C(11, 10)) {
+        case 0: case 1: {                                          // c.srli, c.srai
+          uint32_t shamt = uimm6();
+          IFNDEF(CONFIG_ISA64, if (shamt >= 32) return 0); // reserved for RV32
+          return enc_i(OP_IMM, 5, rdp, rdp, shamt | (C(10, 10) << 10));
+        }
+        case 2: return enc_i(OP_IMM, 7, rdp, rdp, imm6());         // c.andi
+        default: {
+          static const int f3[] = { 0, 4, 6, 7 };                  // c.sub, c.xor, c.or, c.and
+          int f = C(6, 5);
+          if (C(12, 12) == 0) return enc_r(OP_OP, (f == 0 ? 0x20 : 0), f3[f], rdp, rdp, rs2p);
+#ifdef CONFIG_ISA64
+          if (f < 2) return enc_r(OP_OP_32, (f == 0 ? 0x20 : 0), 0, rdp, rdp, rs2p); // c.subw, c.addw
+#endif
+          return 0;
+        }
+      }
+    case 5: return enc_j(0, imm_j());                              // c.j
+    case 6: return enc_b(0, rdp, 0, imm_b());                      // c.beqz
+    case 7: return enc_b(1, rdp, 0, imm_b());                      // c.bnez
+    default: return 0;
+  }
+}
+
+static uint32_t expand_q2(uint32_t c) {
+  int rd = C(11, 7), rs2 = C(6, 2);
+  switch (C(15, 13)) {
+    case 0: {                                                      // c.slli
+      uint32_t shamt = uimm6();
+      IFNDEF(CONFIG_ISA64, if (shamt >= 32) return 0); // reserved for RV32
+      return enc_i(OP_IMM, 1, rd, rd, shamt);
+    }
+    case 1: return enc_i(OP_LOAD_FP, 3, rd, 2, uimm_ldsp());       // c.fldsp
+    case 2: return (rd == 0 ? 0 : enc_i(OP_LOAD, 2, rd, 2, uimm_lwsp())); // c.lwsp
+    case 3: return MUXDEF(CONFIG_ISA64,
+                (rd == 0 ? 0 : enc_i(OP_LOAD, 3, rd, 2, uimm_ldsp())),    // c.ldsp
+                enc_i(OP_LOAD_FP, 2, rd, 2, uimm_lwsp()));                // c.flwsp
+    case 4:
+      if (C(12, 12) == 0) {
+        if (rs2 == 0) return (rd == 0 ? 0 : enc_i(OP_JALR, 0, 0, rd, 0)); // c.jr
+        return enc_r(OP_OP, 0, 0, rd, 0, rs2);                     // c.mv
+      }
+      if (rs2 == 0) {
+        if (rd == 0) return 0x00100073;                            // c.ebreak
+        return enc_i(OP_JALR, 0, 1, rd, 0);                        // c.jalr
+      }
+      return enc_r(OP_OP, 0, 0, rd, rd, rs2);                      // c.add
+    case 5: return enc_s(OP_STORE_FP, 3, 2, rs2, uimm_sdsp());     // c.fsdsp
+    case 6: return enc_s(OP_STORE, 2, 2, rs2, uimm_swsp());        // c.swsp
+    case 7: return MUXDEF(CONFIG_ISA64,
+                enc_s(OP_STORE, 3, 2, rs2, uimm_sdsp()),           // c.sdsp
+                enc_s(OP_STORE_FP, 2, 2, rs2, uimm_swsp()));       // c.fswsp
+    default: return 0;
+  }
+}
+
+uint32_t rvc_expand(uint32_t c) {
+  switch (c & 3) {
+    case 0: return (c == 0 ? 0 : expand_q0(c)); // all zero is defined illegal
+    case 1: return expand_q1(c);
+    case 2: return expand_q2(c);
+    default: return c;
+  }
+}
@@ -0,0 +1,55 @@
+/***************************************************************************************
+* Copyright (c) 2014-2024 Zihao Yu, Nanjing University
+*
+* NEMU is licensed under Mulan PSL v2.
+* You can use this software according to the terms and conditions of the Mulan PSL v2.
+* You may obtain a copy of Mulan PSL v2 at:
+*          http://license.coscl.org.cn/MulanPSL2
+*
+* THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+* EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+* MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+*
+* See the Mulan PSL v2 for more details.
+***************************************************************************************/
+
+#include <isa.h>
+#include <memory/vaddr.h>
+#include "../local-include/csr.h"
+
+static void csr_hook_satp() {
+  vaddr_tlb_flush();
+  // the decode cache is indexed by vaddr, which may map to another page now
+  IFDEF(CONFIG_DECODE_CACHE, void flush_decode_cache(); flush_decode_cache());
+}
+
+static void csr_hook_intr() {
+  // let the execution loop query an interrupt which may be taken now
+  IFDEF(CONFIG_DEVICE, if ((csr(mstatus) & MSTATUS_MIE) && (csr(mip) & csr(mie)))
+    __atomic_fetch_or(&intr_pending, INTR_ISA, __ATOMIC_RELAXED));
+}
+
+#ifdef CONFIG_RVF
+// fflags and frm are fields of fcsr, and kept consistent with it
+static void csr_hook_fflags() {
+  csr(fflags) &= 0x1f;
+  csr(fcsr) = (csr(fcsr) & ~0x1f) | csr(fflags);
+}
+
+static void csr_hook_frm() {
+  csr(frm) &= 0x7;
+  csr(fcsr) = (csr(fcsr) & 0x1f) | (csr(frm) << 5);
+}
+
+static void csr_hook_fcsr() {
+  csr(fcsr) &= 0xff;
+  csr(fflags) = csr(fcsr) & 0x1f;
+  csr(frm) = csr(fcsr) >> 5;
+}
+#endif
+
+#define CSR_ID(name, no, hook) [no] = concat(CSR_, name) + 1,
+const uint8_t csr_id[4096] = { CSR_LIST(CSR_ID) };
+
+#define CSR_HOOK(name, no, hook) [concat(CSR_, name)] = hook,
+void (*const csr_hook[NR_CSR])() = { CSR_LIST(CSR_HOOK) };
@@ -14,15 +14,49 @@
 ***************************************************************************************/
 
 #include <isa.h>
+#include "../local-include/csr.h"
 
+// only the machine mode is implemented
 word_t isa_raise_intr(word_t NO, vaddr_t epc) {
-  /* TODO: Trigger an interrupt/exception with ``NO''.
-   * Then return the address of the interrupt/exception vector.
-   */
+  word_t s = csr(mstatus);
+  csr(mstatus) = (s & ~(MSTATUS_MIE | MSTATUS_MPIE)) | ((s & MSTATUS_MIE) << 4) | MSTATUS_MPP;
+  csr(mepc) = epc;
+  csr(mcause) = NO;
+  return csr(mtvec);
+}
+
+#ifdef CONFIG_MEM_EXCEPTION
+word_t isa_mem_exception(vaddr_t addr, int type, bool page_fault) {
+  static const word_t no[2][3] = {
+    { EXC_INST_ACCESS_FAULT, EXC_LOAD_ACCESS_FAULT, EXC_STORE_ACCESS_FAULT },
+    { EXC_INST_PAGE_FAULT, EXC_LOAD_PAGE_FAULT, EXC_STORE_PAGE_FAULT },
+  };
+  csr(mtval) = addr;
+  return no[page_fault][type];
+}
+#endif
 
-  return 0;
+vaddr_t isa_mret() {
+  word_t s = csr(mstatus);
+  // an interrupt pending may be enabled again
+  csr_write(CSR_mstatus, (s & ~MSTATUS_MIE) | ((s & MSTATUS_MPIE) >> 4) | MSTATUS_MPIE);
+  return csr(mepc);
 }
 
+/* This is only called after an interrupt is raised, by a device or by a CSR
+ * write which enables one. The devices are wired to the machine timer
+ * interrupt, as no interrupt controller is modeled, which is latched in
+ * mip.MTIP until it is taken. An interrupt is only taken if it is enabled
+ * in mie, as the hook of the CSR writes checks. */
 word_t isa_query_intr() {
+  IFDEF(CONFIG_DEVICE, if (__atomic_load_n(&intr_pending, __ATOMIC_ACQUIRE) & INTR_DEV) csr(mip) |= 1 << IRQ_MTI);
+  if (!(csr(mstatus) & MSTATUS_MIE)) return INTR_EMPTY;
+  word_t pending = csr(mip) & csr(mie);
+  if (pending & (1 << IRQ_MEI)) return INTR_BIT | IRQ_MEI;
+  if (pending & (1 << IRQ_MSI)) return INTR_BIT | IRQ_MSI;
+  if (pending & (1 << IRQ_MTI)) {
+    csr(mip) &= ~(1 << IRQ_MTI);
+    return INTR_BIT | IRQ_MTI;
+  }
   return INTR_EMPTY;
 }
@@ -17,6 +17,8 @@
 #include <memory/vaddr.h>
 #include <memory/paddr.h>
 
+// a leaf PTE at level 1 maps a megapage, which should be reported by
+// or'ing MEM_RET_SUPERPAGE, so that the soft TLB caches it as a whole
 paddr_t isa_mmu_translate(vaddr_t vaddr, int len, int type) {
   return MEM_RET_FAIL;
 }
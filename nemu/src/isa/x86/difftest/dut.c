@@ -18,7 +18,9 @@
 #include "../local-include/reg.h"
 
 bool isa_difftest_checkregs(CPU_state *ref_r, vaddr_t pc) {
-  return false;
+  // the lazy flags are computed only to be compared
+  isa_sync_regs(&cpu);
+  return memcmp(&cpu, ref_r, DIFFTEST_REG_SIZE) == 0;
 }
 
 void isa_difftest_attach() {
@@ -37,12 +37,33 @@ typedef struct {
 #define edi gpr[7]._32
 
   vaddr_t pc;
+  uint32_t eflags; // CF, PF, AF, ZF, SF and OF are stale while lazy.op != LF_NONE
+
+  // the last instruction setting the arithmetic flags, from which they are
+  // computed only when an instruction or difftest reads them
+  struct {
+    uint32_t op, width;
+    uint32_t src1, src2, res;
+  } lazy;
 } x86_CPU_state;
 
+// bring eflags in the view of difftest up to date
+void x86_sync_regs(x86_CPU_state *s);
+#define isa_sync_regs(s) x86_sync_regs(s)
+
 // decode
+// the memory operand at disp + base + (index << scale), kept to compute
+// the address again for a cached instruction
+typedef struct {
+  int8_t base, index; // -1 if not used
+  uint8_t scale;
+  word_t disp;
+} MemOperand;
+
 typedef struct {
   uint8_t inst[16];
   uint8_t *p_inst;
+  MemOperand mem;
 } x86_ISADecodeInfo;
 
 enum { R_EAX, R_ECX, R_EDX, R_EBX, R_ESP, R_EBP, R_ESI, R_EDI };
@@ -32,9 +32,18 @@ static const uint8_t img []  = {
 static void restart() {
   /* Set the initial instruction pointer. */
   cpu.pc = RESET_VECTOR;
+  cpu.eflags = 0x2;
+}
+
+void isa_hart_init(int id, word_t sp) {
+  /* Pass the id of the hart in %eax. */
+  cpu.eax = id;
+  cpu.esp = sp;
 }
 
 void init_isa() {
+  IFDEF(CONFIG_DECODE_CACHE, void init_decode_cache(); init_decode_cache());
+
   /* Test the implementation of the `CPU_state' structure. */
   void reg_test();
 #ifndef CONFIG_DETERMINISTIC
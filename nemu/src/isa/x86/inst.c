@@ -14,9 +14,11 @@
 ***************************************************************************************/
 
 #include "local-include/reg.h"
+#include "local-include/eflags.h"
 #include <cpu/cpu.h>
 #include <cpu/ifetch.h>
 #include <cpu/decode.h>
+#include <memory/paddr.h>
 
 typedef union {
   struct {
@@ -40,8 +42,12 @@ typedef union {
   uint8_t val;
 } SIB;
 
-static word_t x86_inst_fetch(Decode *s, int len) {
 #if defined(CONFIG_ITRACE) || defined(CONFIG_IQUEUE)
+#define KEEP_INST 1 // the bytes of each instruction are kept for tracing
+#endif
+
+static word_t x86_inst_fetch(Decode *s, int len) {
+#ifdef KEEP_INST
   uint8_t *p = &s->isa.inst[s->snpc - s->pc];
   word_t ret = inst_fetch(&s->snpc, len);
   word_t ret_save = ret;
@@ -75,6 +81,13 @@ static void reg_write(int idx, int width, word_t data) {
   }
 }
 
+static inline word_t mem_addr(Decode *s) {
+  word_t addr = s->isa.mem.disp;
+  if (s->isa.mem.base != -1)  addr += reg_l(s->isa.mem.base);
+  if (s->isa.mem.index != -1) addr += reg_l(s->isa.mem.index) << s->isa.mem.scale;
+  return addr;
+}
+
 static void load_addr(Decode *s, ModR_M *m, word_t *rm_addr) {
   assert(m->mod != 3);
 
@@ -103,10 +116,11 @@ static void load_addr(Decode *s, ModR_M *m, word_t *rm_addr) {
     if (disp_size == 1) { disp = (int8_t)disp; }
   }
 
-  word_t addr = disp;
-  if (base_reg != -1)  addr += reg_l(base_reg);
-  if (index_reg != -1) addr += reg_l(index_reg) << scale;
-  *rm_addr = addr;
+  s->isa.mem.base = base_reg;
+  s->isa.mem.index = index_reg;
+  s->isa.mem.scale = scale;
+  s->isa.mem.disp = disp;
+  *rm_addr = mem_addr(s);
 }
 
 static void decode_rm(Decode *s, int *rm_reg, word_t *rm_addr, int *reg, int width) {
@@ -146,66 +160,218 @@ enum {
   TYPE_N, // none
 };
 
+#ifdef CONFIG_DECODE_CACHE
+/* Direct-mapped cache of decoded instructions, indexed by pc. Decoding the
+ * prefixes, opcode, ModR/M, SIB, displacement and immediate of an x86
+ * instruction costs much more than executing it, so an entry keeps all of
+ * them with the length, together with the address of the matched execution
+ * body, and a hit jumps to the body directly. The address of a memory
+ * operand depends on registers, so it is computed again from the kept form. */
+#define DCACHE_SIZE 8192 // should be a multiple of PAGE_SIZE
+#define DCACHE_INVALID_PC ((vaddr_t)-1) // never matches, since it is outside pmem
+#define MAX_ILEN 15
+
+typedef struct {
+  vaddr_t pc;
+  uint8_t ilen, w, opcode;
+  int8_t rd, rs, gp_idx;
+  word_t imm;
+  MemOperand mem;
+  const void *exec;
+  IFDEF(KEEP_INST, uint8_t inst[16]);
+} DecodeCacheEntry;
+
+static DecodeCacheEntry dcache[DCACHE_SIZE] = {};
+IFDEF(CONFIG_LIVE, uint64_t dcache_nr_miss = 0);
+
+static inline DecodeCacheEntry* dcache_entry(vaddr_t pc) {
+  return &dcache[pc % DCACHE_SIZE];
+}
+
+static void dcache_fill(Decode *s, uint8_t opcode, int rd, int rs, int gp_idx, int w, word_t imm,
+    const void *exec) {
+  DecodeCacheEntry *e = dcache_entry(s->pc);
+  int ilen = s->snpc - s->pc;
+  *e = (DecodeCacheEntry) { .pc = s->pc, .ilen = ilen, .w = w, .opcode = opcode, .rd = rd, .rs = rs,
+    .gp_idx = gp_idx, .imm = imm, .mem = s->isa.mem, .exec = exec };
+  IFDEF(KEEP_INST, memcpy(e->inst, s->isa.inst, ilen));
+  // vaddr is identical to paddr since isa_mmu_check() always returns MMU_DIRECT,
+  // and an instruction may straddle into the next page
+  paddr_mark_code(s->pc);
+  paddr_mark_code(s->pc + ilen - 1);
+  IFDEF(CONFIG_LIVE, dcache_nr_miss ++);
+}
+
+void isa_flush_decode_cache(paddr_t page) {
+  // the instructions in or straddling into a page start at one of the
+  // PAGE_SIZE + MAX_ILEN - 1 consecutive pcs ending at the page end
+  int base = (page - (MAX_ILEN - 1)) % DCACHE_SIZE;
+  int i;
+  for (i = 0; i < PAGE_SIZE + MAX_ILEN - 1; i ++) {
+    DecodeCacheEntry *e = &dcache[(base + i) % DCACHE_SIZE];
+    if ((e->pc & ~PAGE_MASK) == page || ((e->pc + e->ilen - 1) & ~PAGE_MASK) == page) {
+      e->pc = DCACHE_INVALID_PC;
+    }
+  }
+}
+
+void init_decode_cache() {
+  int i;
+  for (i = 0; i < DCACHE_SIZE; i ++) {
+    dcache[i].pc = DCACHE_INVALID_PC;
+  }
+  FOOTPRINT("decode cache", dcache, sizeof(dcache));
+}
+
+#endif
+
+// only isa_exec_once() fills the decode cache, see below
+#define DCACHE_FILL()
+
 #define INSTPAT_INST(s) opcode
 #define INSTPAT_MATCH(s, name, type, width, ... /* execute body */ ) { \
-  int rd = 0, rs = 0, gp_idx = 0; \
-  word_t src1 = 0, addr = 0, imm = 0; \
-  int w = width == 0 ? (is_operand_size_16 ? 2 : 4) : width; \
+  w = width == 0 ? (is_operand_size_16 ? 2 : 4) : width; \
   decode_operand(s, opcode, &rd, &src1, &addr, &rs, &gp_idx, &imm, w, concat(TYPE_, type)); \
+  DCACHE_FILL(); \
   s->dnpc = s->snpc; \
   __VA_ARGS__ ; \
+  INSTPAT_STAT(s, name); \
 }
 
 static void decode_operand(Decode *s, uint8_t opcode, int *rd_, word_t *src1,
     word_t *addr, int *rs, int *gp_idx, word_t *imm, int w, int type) {
   switch (type) {
+    case TYPE_r:    destr(opcode & 0x7); break;
+    case TYPE_J:    if (w == 1) simm(1); else if (w == 2) simm(2); else imm(); break;
+    case TYPE_E:    decode_rm(s, rd_, addr, NULL, w); break;
     case TYPE_I2r:  destr(opcode & 0x7); imm(); break;
+    case TYPE_I2a:  destr(R_EAX); imm(); break;
     case TYPE_G2E:  decode_rm(s, rd_, addr, rs, w); src1r(*rs); break;
     case TYPE_E2G:  decode_rm(s, rs, addr, rd_, w); break;
     case TYPE_I2E:  decode_rm(s, rd_, addr, gp_idx, w); imm(); break;
-    case TYPE_O2a:  destr(R_EAX); *addr = x86_inst_fetch(s, 4); break;
-    case TYPE_a2O:  *rs = R_EAX;  *addr = x86_inst_fetch(s, 4); break;
+    case TYPE_SI2E: decode_rm(s, rd_, addr, gp_idx, w); simm(1); break;
+    case TYPE_O2a:  destr(R_EAX); *addr = s->isa.mem.disp = x86_inst_fetch(s, 4); break;
+    case TYPE_a2O:  *rs = R_EAX;  *addr = s->isa.mem.disp = x86_inst_fetch(s, 4); break;
     case TYPE_N:    break;
     default: panic("Unsupported type = %d", type);
   }
 }
 
-#define gp1() do { \
-  switch (gp_idx) { \
-    default: INV(s->pc); \
-  }; \
-} while (0)
+// the operation in bits 5-3 of the opcodes 00-3f, and in the reg field of group 1
+enum { ALU_ADD, ALU_OR, ALU_ADC, ALU_SBB, ALU_AND, ALU_SUB, ALU_XOR, ALU_CMP };
+
+static word_t alu(int op, int w, word_t a, word_t b) {
+  word_t r, c;
+  switch (op) {
+    case ALU_ADD: r = a + b; eflags_set_lazy(LF_ADD, w, a, b, r); break;
+    case ALU_ADC: c = eflags_cf(); r = a + b + c; eflags_set_lazy(c ? LF_ADC : LF_ADD, w, a, b, r); break;
+    case ALU_SBB: c = eflags_cf(); r = a - b - c; eflags_set_lazy(c ? LF_SBB : LF_SUB, w, a, b, r); break;
+    case ALU_SUB: case ALU_CMP: r = a - b; eflags_set_lazy(LF_SUB, w, a, b, r); break;
+    case ALU_OR:  r = a | b; eflags_set_lazy(LF_LOGIC, w, a, b, r); break;
+    case ALU_AND: r = a & b; eflags_set_lazy(LF_LOGIC, w, a, b, r); break;
+    default:      r = a ^ b; eflags_set_lazy(LF_LOGIC, w, a, b, r); break;
+  }
+  return r;
+}
+
+#define alu_op ((opcode >> 3) & 0x7)
+// cmp does not write the result back
+#define aluE(op, src) do { word_t r = alu(op, w, RMr(rd, w), src); if (op != ALU_CMP) RMw(r); } while (0)
+#define aluG(op, src) do { word_t r = alu(op, w, Rr(rd, w), src); if (op != ALU_CMP) Rw(rd, w, r); } while (0)
+
+#define gp1() aluE(gp_idx, imm)
+
+#define push(val) do { cpu.esp -= 4; Mw(cpu.esp, 4, val); } while (0)
+#define pop()     (cpu.esp += 4, Mr(cpu.esp - 4, 4))
+#define EFLAGS_POPF 0x247fd5 // the flags popf can change
+
+// the operands of INSTPAT_MATCH
+#define INSTPAT_OPERANDS \
+  int rd = 0, rs = 0, gp_idx = 0, w = 0; \
+  word_t src1 = 0, addr = 0, imm = 0
 
 void _2byte_esc(Decode *s, bool is_operand_size_16) {
+  INSTPAT_OPERANDS;
   uint8_t opcode = x86_inst_fetch(s, 1);
   INSTPAT_START();
+  INSTPAT("1000 ????", jcc,    J,    0, if (eflags_cond(opcode & 0xf)) s->dnpc += imm);
+  INSTPAT("1001 ????", setcc,  E,    1, RMw(eflags_cond(opcode & 0xf)));
   INSTPAT("???? ????", inv,    N,    0, INV(s->pc));
   INSTPAT_END();
 }
 
+#ifdef CONFIG_DECODE_CACHE
+// A hit jumps to the body in isa_exec_once(), so the instructions decoded
+// by _2byte_esc() are not cached.
+#undef DCACHE_FILL
+#define DCACHE_FILL() do { \
+  dcache_fill(s, opcode, rd, rs, gp_idx, w, imm, &&concat(__instpat_exec_, __LINE__)); \
+  concat(__instpat_exec_, __LINE__): ; \
+} while (0)
+#endif
+
 int isa_exec_once(Decode *s) {
   bool is_operand_size_16 = false;
   uint8_t opcode = 0;
+  INSTPAT_OPERANDS;
+
+#ifdef CONFIG_DECODE_CACHE
+  DecodeCacheEntry *e = dcache_entry(s->pc);
+  if (likely(e->pc == s->pc)) {
+    s->snpc += e->ilen;
+    IFDEF(KEEP_INST, memcpy(s->isa.inst, e->inst, e->ilen));
+    s->isa.mem = e->mem;
+    opcode = e->opcode; rd = e->rd; rs = e->rs; gp_idx = e->gp_idx; w = e->w; imm = e->imm;
+    addr = mem_addr(s);
+    if (rs != -1) src1 = Rr(rs, w); // only used by G2E
+    goto *(e->exec);
+  }
+#endif
+  s->isa.mem.base = s->isa.mem.index = -1;
+  s->isa.mem.disp = 0;
 
 again:
   opcode = x86_inst_fetch(s, 1);
 
   INSTPAT_START();
 
-  INSTPAT("0000 1111", 2byte_esc, N,    0, _2byte_esc(s, is_operand_size_16));
+  INSTPAT("0000 1111", 2byte_esc, N,    0,
+      IFDEF(CONFIG_DECODE_CACHE, dcache_entry(s->pc)->pc = DCACHE_INVALID_PC);
+      _2byte_esc(s, is_operand_size_16));
+
+  INSTPAT("00?? ?000", alu,       G2E,  1, aluE(alu_op, src1));
+  INSTPAT("00?? ?001", alu,       G2E,  0, aluE(alu_op, src1));
+  INSTPAT("00?? ?010", alu,       E2G,  1, aluG(alu_op, RMr(rs, w)));
+  INSTPAT("00?? ?011", alu,       E2G,  0, aluG(alu_op, RMr(rs, w)));
+  INSTPAT("00?? ?100", alu,       I2a,  1, aluG(alu_op, imm));
+  INSTPAT("00?? ?101", alu,       I2a,  0, aluG(alu_op, imm));
+
+  INSTPAT("0100 0???", inc,       r,    0, word_t a = Rr(rd, w); Rw(rd, w, a + 1); eflags_set_incdec(LF_INC, w, a, a + 1));
+  INSTPAT("0100 1???", dec,       r,    0, word_t a = Rr(rd, w); Rw(rd, w, a - 1); eflags_set_incdec(LF_DEC, w, a, a - 1));
 
   INSTPAT("0110 0110", data_size, N,    0, is_operand_size_16 = true; goto again;);
 
+  INSTPAT("0111 ????", jcc,       J,    1, if (eflags_cond(opcode & 0xf)) s->dnpc += imm);
+
   INSTPAT("1000 0000", gp1,       I2E,  1, gp1());
+  INSTPAT("1000 0001", gp1,       I2E,  0, gp1());
+  INSTPAT("1000 0011", gp1,       SI2E, 0, gp1());
+  INSTPAT("1000 0100", test,      G2E,  1, alu(ALU_AND, w, RMr(rd, w), src1));
+  INSTPAT("1000 0101", test,      G2E,  0, alu(ALU_AND, w, RMr(rd, w), src1));
   INSTPAT("1000 1000", mov,       G2E,  1, RMw(src1));
   INSTPAT("1000 1001", mov,       G2E,  0, RMw(src1));
   INSTPAT("1000 1010", mov,       E2G,  1, Rw(rd, w, RMr(rs, w)));
   INSTPAT("1000 1011", mov,       E2G,  0, Rw(rd, w, RMr(rs, w)));
 
+  INSTPAT("1001 1100", pushf,     N,    0, eflags_sync(); push(cpu.eflags));
+  INSTPAT("1001 1101", popf,      N,    0, eflags_sync(); cpu.eflags = (pop() & EFLAGS_POPF) | 0x2);
+
   INSTPAT("1010 0000", mov,       O2a,  1, Rw(R_EAX, 1, Mr(addr, 1)));
   INSTPAT("1010 0001", mov,       O2a,  0, Rw(R_EAX, w, Mr(addr, w)));
   INSTPAT("1010 0010", mov,       a2O,  1, Mw(addr, 1, Rr(R_EAX, 1)));
   INSTPAT("1010 0011", mov,       a2O,  0, Mw(addr, w, Rr(R_EAX, w)));
+  INSTPAT("1010 1000", test,      I2a,  1, alu(ALU_AND, w, Rr(R_EAX, w), imm));
+  INSTPAT("1010 1001", test,      I2a,  0, alu(ALU_AND, w, Rr(R_EAX, w), imm));
 
   INSTPAT("1011 0???", mov,       I2r,  1, Rw(rd, 1, imm));
   INSTPAT("1011 1???", mov,       I2r,  0, Rw(rd, w, imm));
@@ -0,0 +1,144 @@
+/***************************************************************************************
+* Copyright (c) 2014-2024 Zihao Yu, Nanjing University
+*
+* NEMU is licensed under Mulan PSL v2.
+* You can use this software according to the terms and conditions of the Mulan PSL v2.
+* You may obtain a copy of Mulan PSL v2 at:
+*          http://license.coscl.org.cn/MulanPSL2
+*
+* THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+* EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+* MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+*
+* See the Mulan PSL v2 for more details.
+***************************************************************************************/
+
+#ifndef __X86_EFLAGS_H__
+#define __X86_EFLAGS_H__
+
+#include <isa.h>
+
+/* Lazy arithmetic flags. An ALU instruction only records its kind, width,
+ * operands and result in cpu.lazy, and a flag is computed from them when
+ * jcc, setcc, adc, sbb or pushf reads it. Most flags are overwritten before
+ * being read, and a cmp followed by jcc is answered by comparing the
+ * operands directly. cpu.eflags is brought up to date by eflags_sync(). */
+
+#define EFLAGS_CF 0x001
+#define EFLAGS_PF 0x004
+#define EFLAGS_AF 0x010
+#define EFLAGS_ZF 0x040
+#define EFLAGS_SF 0x080
+#define EFLAGS_OF 0x800
+#define EFLAGS_ARITH (EFLAGS_CF | EFLAGS_PF | EFLAGS_AF | EFLAGS_ZF | EFLAGS_SF | EFLAGS_OF)
+
+enum {
+  LF_NONE, // cpu.eflags is up to date
+  LF_ADD, LF_ADC, // ADC only with carry in, otherwise ADD
+  LF_SUB, LF_SBB, // SBB only with borrow in, otherwise SUB
+  LF_LOGIC,
+  LF_INC, LF_DEC, // CF is kept in cpu.eflags
+};
+
+static inline void eflags_set_lazy(int op, int width, word_t src1, word_t src2, word_t res) {
+  cpu.lazy.op = op;
+  cpu.lazy.width = width;
+  cpu.lazy.src1 = src1;
+  cpu.lazy.src2 = src2;
+  cpu.lazy.res = res;
+}
+
+static inline word_t lf_mask() { return (word_t)-1 >> (32 - cpu.lazy.width * 8); }
+static inline int lf_msb(word_t x) { return (x >> (cpu.lazy.width * 8 - 1)) & 1; }
+
+static inline int eflags_cf() {
+  word_t a = cpu.lazy.src1 & lf_mask(), b = cpu.lazy.src2 & lf_mask(), r = cpu.lazy.res & lf_mask();
+  switch (cpu.lazy.op) {
+    case LF_ADD: return r < a;
+    case LF_ADC: return r <= a;
+    case LF_SUB: return a < b;
+    case LF_SBB: return a <= b;
+    case LF_LOGIC: return 0;
+    default: return (cpu.eflags & EFLAGS_CF) != 0;
+  }
+}
+
+static inline int eflags_zf() {
+  if (cpu.lazy.op == LF_NONE) return (cpu.eflags & EFLAGS_ZF) != 0;
+  return (cpu.lazy.res & lf_mask()) == 0;
+}
+
+static inline int eflags_sf() {
+  if (cpu.lazy.op == LF_NONE) return (cpu.eflags & EFLAGS_SF) != 0;
+  return lf_msb(cpu.lazy.res);
+}
+
+static inline int eflags_pf() {
+  if (cpu.lazy.op == LF_NONE) return (cpu.eflags & EFLAGS_PF) != 0;
+  return !__builtin_parity(cpu.lazy.res & 0xff);
+}
+
+static inline int eflags_of() {
+  word_t a = cpu.lazy.src1, b = cpu.lazy.src2, r = cpu.lazy.res;
+  switch (cpu.lazy.op) {
+    case LF_ADD: case LF_ADC: case LF_INC: return lf_msb((a ^ r) & (b ^ r));
+    case LF_SUB: case LF_SBB: case LF_DEC: return lf_msb((a ^ b) & (a ^ r));
+    case LF_LOGIC: return 0;
+    default: return (cpu.eflags & EFLAGS_OF) != 0;
+  }
+}
+
+static inline int eflags_af() {
+  switch (cpu.lazy.op) {
+    case LF_NONE: return (cpu.eflags & EFLAGS_AF) != 0;
+    case LF_LOGIC: return 0;
+    default: return ((cpu.lazy.src1 ^ cpu.lazy.src2 ^ cpu.lazy.res) >> 4) & 1;
+  }
+}
+
+static inline void eflags_sync() {
+  if (cpu.lazy.op == LF_NONE) return;
+  cpu.eflags = (cpu.eflags & ~EFLAGS_ARITH) |
+    (eflags_cf() ? EFLAGS_CF : 0) | (eflags_pf() ? EFLAGS_PF : 0) |
+    (eflags_af() ? EFLAGS_AF : 0) | (eflags_zf() ? EFLAGS_ZF : 0) |
+    (eflags_sf() ? EFLAGS_SF : 0) | (eflags_of() ? EFLAGS_OF : 0);
+  cpu.lazy.op = LF_NONE;
+}
+
+// inc and dec leave CF as it is, so it is kept in cpu.eflags first
+static inline void eflags_set_incdec(int op, int width, word_t src1, word_t res) {
+  int cf = eflags_cf();
+  cpu.eflags = (cpu.eflags & ~EFLAGS_CF) | cf;
+  eflags_set_lazy(op, width, src1, 1, res);
+}
+
+// the condition `cc` in the low 4 bits of jcc, setcc and cmovcc
+static inline bool eflags_cond(int cc) {
+  bool r;
+  if (cpu.lazy.op == LF_SUB) {
+    // cmp and sub compare the operands directly
+    word_t a = cpu.lazy.src1 & lf_mask(), b = cpu.lazy.src2 & lf_mask();
+    int shift = 32 - cpu.lazy.width * 8;
+    sword_t sa = (sword_t)(a << shift), sb = (sword_t)(b << shift);
+    switch (cc >> 1) {
+      case 1: return (a < b) ^ (cc & 1);   // b
+      case 2: return (a == b) ^ (cc & 1);  // e
+      case 3: return (a <= b) ^ (cc & 1);  // be
+      case 6: return (sa < sb) ^ (cc & 1); // l
+      case 7: return (sa <= sb) ^ (cc & 1); // le
+    }
+  }
+  switch (cc >> 1) {
+    case 0: r = eflags_of(); break;
+    case 1: r = eflags_cf(); break;
+    case 2: r = eflags_zf(); break;
+    case 3: r = eflags_cf() || eflags_zf(); break;
+    case 4: r = eflags_sf(); break;
+    case 5: r = eflags_pf(); break;
+    case 6: r = eflags_sf() != eflags_of(); break;
+    default: r = eflags_zf() || (eflags_sf() != eflags_of()); break;
+  }
+  return r ^ (cc & 1);
+}
+
+#endif
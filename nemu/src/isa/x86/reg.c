@@ -15,6 +15,7 @@
 
 #include <isa.h>
 #include "local-include/reg.h"
+#include "local-include/eflags.h"
 
 const char *regsl[] = {"eax", "ecx", "edx", "ebx", "esp", "ebp", "esi", "edi"};
 const char *regsw[] = {"ax", "cx", "dx", "bx", "sp", "bp", "si", "di"};
@@ -67,6 +68,19 @@ void isa_reg_display() {
   printf("esi:0x%x      ", cpu.esi);
   printf("edi:0x%x      ", cpu.edi);
   printf("\n\n");
+  eflags_sync();
+  printf("eflags:0x%x   ", cpu.eflags);
+  printf("\n\n");
+}
+
+void x86_sync_regs(x86_CPU_state *s) {
+  if (s == &cpu) { eflags_sync(); return; }
+  // the flags are computed from the global state
+  x86_CPU_state now = cpu;
+  cpu = *s;
+  eflags_sync();
+  *s = cpu;
+  cpu = now;
 }
 
 word_t isa_reg_str2val(const char *s, bool *success) {
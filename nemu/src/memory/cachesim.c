@@ -0,0 +1,260 @@
+/***************************************************************************************
+* Copyright (c) 2014-2024 Zihao Yu, Nanjing University
+*
+* NEMU is licensed under Mulan PSL v2.
+* You can use this software according to the terms and conditions of the Mulan PSL v2.
+* You may obtain a copy of Mulan PSL v2 at:
+*          http://license.coscl.org.cn/MulanPSL2
+*
+* THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+* EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+* MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+*
+* See the Mulan PSL v2 for more details.
+***************************************************************************************/
+
+#include <isa.h>
+#include <memory/paddr.h>
+#include <memory/mtrace.h>
+
+/* A functional model of L1I, L1D and a unified L2, fed with the records of
+ * mtrace by its consumer thread, so that the guest only pays for putting
+ * them into the ring. The caches are write-back and write-allocate. A miss
+ * of L1 reads the line from L2, and a dirty line evicted from L1 is written
+ * to L2. Only accesses to pmem are cached.
+ *
+ * The caches are configured by a spec like
+ *   l1i=64:8:64,l1d=64:8:64,l2=1024:16:64,policy=lru
+ * giving the sets, ways and bytes of a line of each cache, where the sets
+ * and the line size are powers of 2, and a cache with 0 sets is left out.
+ * The policy of replacement is lru, fifo or random.
+ */
+enum { L1I, L1D, L2, NR_CACHE };
+enum { POLICY_LRU, POLICY_FIFO, POLICY_RANDOM };
+
+typedef struct {
+  const char *name;
+  int sets, ways, line_shift;
+  uint64_t *tag; // line + 1 in [set * ways + way], 0 for an invalid one
+  uint64_t *stamp; // the time of the last use with LRU, or of the fill with FIFO
+  bool *dirty;
+  uint64_t hit, miss, writeback;
+} Cache;
+
+static Cache cache[NR_CACHE] = {
+  [L1I] = { .name = "L1I" }, [L1D] = { .name = "L1D" }, [L2] = { .name = "L2" },
+};
+static int policy = POLICY_LRU;
+static uint64_t now = 0, seed = 1;
+
+/* The statistics of each pc issuing accesses, in a hash table growing when
+ * half full. Fetches are counted at their pc as well. */
+typedef struct {
+  vaddr_t pc;
+  uint64_t access, l1_miss, l2_miss; // access is 0 for an empty entry
+} PCStat;
+
+#define NR_REPORT 20
+
+static PCStat *pc_stat = NULL;
+static uint64_t pc_stat_size = 0, nr_pc_stat = 0;
+
+static bool parse_cache(Cache *c, const char *s) {
+  int sets, ways, line;
+  if (sscanf(s, "%d:%d:%d", &sets, &ways, &line) != 3) return false;
+  if (sets < 0 || (sets & (sets - 1)) != 0 || ways <= 0 || line < 8 || (line & (line - 1)) != 0) return false;
+  free(c->tag); free(c->stamp); free(c->dirty);
+  *c = (Cache) { .name = c->name, .sets = sets, .ways = ways, .line_shift = __builtin_ctz(line) };
+  if (sets == 0) return true;
+  c->tag = calloc((size_t)sets * ways, sizeof(uint64_t));
+  c->stamp = calloc((size_t)sets * ways, sizeof(uint64_t));
+  c->dirty = calloc((size_t)sets * ways, sizeof(bool));
+  assert(c->tag != NULL && c->stamp != NULL && c->dirty != NULL);
+  return true;
+}
+
+bool cachesim_init(const char *spec) {
+  char *buf = strdup(spec), *save = NULL, *item;
+  bool ok = true;
+  for (item = strtok_r(buf, ",", &save); ok && item != NULL; item = strtok_r(NULL, ",", &save)) {
+    char *val = strchr(item, '=');
+    if (val == NULL) { ok = false; break; }
+    *val ++ = '\0';
+    if (strcmp(item, "l1i") == 0) ok = parse_cache(&cache[L1I], val);
+    else if (strcmp(item, "l1d") == 0) ok = parse_cache(&cache[L1D], val);
+    else if (strcmp(item, "l2") == 0) ok = parse_cache(&cache[L2], val);
+    else if (strcmp(item, "policy") == 0) {
+      if (strcmp(val, "lru") == 0) policy = POLICY_LRU;
+      else if (strcmp(val, "fifo") == 0) policy = POLICY_FIFO;
+      else if (strcmp(val, "random") == 0) policy = POLICY_RANDOM;
+      else ok = false;
+    } else ok = false;
+  }
+  free(buf);
+  if (!ok) { Log("cachesim: bad spec '%s'", spec); return false; }
+
+  free(pc_stat);
+  pc_stat_size = 4096;
+  nr_pc_stat = 0;
+  pc_stat = calloc(pc_stat_size, sizeof(PCStat));
+  assert(pc_stat != NULL);
+  int i;
+  for (i = 0; i < NR_CACHE; i ++) {
+    Cache *c = &cache[i];
+    if (c->sets == 0) continue;
+    Log("cachesim: %-3s %d sets x %d ways x %d bytes = %d KB", c->name, c->sets, c->ways,
+        1 << c->line_shift, (c->sets * c->ways) << c->line_shift >> 10);
+  }
+  return true;
+}
+
+static PCStat* pc_stat_fetch(vaddr_t pc) {
+  if (nr_pc_stat * 2 >= pc_stat_size) {
+    PCStat *old = pc_stat;
+    uint64_t old_size = pc_stat_size, i;
+    pc_stat_size *= 2;
+    pc_stat = calloc(pc_stat_size, sizeof(PCStat));
+    assert(pc_stat != NULL);
+    nr_pc_stat = 0;
+    for (i = 0; i < old_size; i ++) {
+      if (old[i].access != 0) *pc_stat_fetch(old[i].pc) = old[i];
+    }
+    free(old);
+  }
+  uint64_t i = (pc ^ (pc >> 13)) & (pc_stat_size - 1);
+  while (pc_stat[i].access != 0 && pc_stat[i].pc != pc) i = (i + 1) & (pc_stat_size - 1);
+  if (pc_stat[i].access == 0) { pc_stat[i].pc = pc; nr_pc_stat ++; }
+  return &pc_stat[i];
+}
+
+static int victim(Cache *c, int base) {
+  int w;
+  for (w = 0; w < c->ways; w ++) {
+    if (c->tag[base + w] == 0) return w;
+  }
+  if (policy == POLICY_RANDOM) {
+    seed ^= seed << 13; seed ^= seed >> 7; seed ^= seed << 17;
+    return seed % c->ways;
+  }
+  int v = 0;
+  for (w = 1; w < c->ways; w ++) {
+    if (c->stamp[base + w] < c->stamp[base + v]) v = w;
+  }
+  return v;
+}
+
+// access the line containing `addr`, and return whether it hits
+static bool cache_access(Cache *c, paddr_t addr, bool is_write) {
+  uint64_t line = addr >> c->line_shift;
+  int base = (line & (c->sets - 1)) * c->ways, w;
+  now ++;
+  for (w = 0; w < c->ways; w ++) {
+    if (c->tag[base + w] == line + 1) {
+      c->hit ++;
+      if (policy == POLICY_LRU) c->stamp[base + w] = now;
+      c->dirty[base + w] |= is_write;
+      return true;
+    }
+  }
+  c->miss ++;
+  w = victim(c, base);
+  if (c->tag[base + w] != 0 && c->dirty[base + w]) {
+    c->writeback ++;
+    if (c != &cache[L2] && cache[L2].sets != 0) {
+      cache_access(&cache[L2], (c->tag[base + w] - 1) << c->line_shift, true);
+    }
+  }
+  c->tag[base + w] = line + 1;
+  c->stamp[base + w] = now;
+  c->dirty[base + w] = is_write;
+  return false;
+}
+
+static void access_line(const MTraceRecord *r, paddr_t addr, PCStat *ps) {
+  Cache *l1 = &cache[r->is_write == MTRACE_IFETCH ? L1I : L1D];
+  bool is_write = (r->is_write == 1), miss = true;
+  if (l1->sets != 0) {
+    miss = !cache_access(l1, addr, is_write);
+    ps->l1_miss += miss;
+  }
+  // L2 is reached by a miss of L1, where a dirty line is only written back
+  if (miss && cache[L2].sets != 0) {
+    ps->l2_miss += !cache_access(&cache[L2], addr, l1->sets == 0 && is_write);
+  }
+}
+
+void cachesim_feed(const MTraceRecord *r, int n) {
+  int i;
+  for (i = 0; i < n; i ++, r ++) {
+    if (!in_pmem(r->addr)) continue;
+    PCStat *ps = pc_stat_fetch(r->pc);
+    ps->access ++;
+    Cache *l1 = &cache[r->is_write == MTRACE_IFETCH ? L1I : L1D];
+    int shift = (l1->sets != 0 ? l1->line_shift : cache[L2].line_shift);
+    paddr_t first = r->addr >> shift, last = (r->addr + r->len - 1) >> shift, line;
+    // an access crossing lines touches each of them
+    for (line = first; line <= last; line ++) access_line(r, (line == first ? r->addr : line << shift), ps);
+  }
+}
+
+typedef struct {
+  const char *name; // NULL if the pcs are not in any function
+  vaddr_t pc; // the lowest one
+  uint64_t access, l1_miss, l2_miss;
+} Item;
+
+static int item_cmp_pc(const void *a, const void *b) {
+  vaddr_t x = ((const Item *)a)->pc, y = ((const Item *)b)->pc;
+  return (x > y) - (x < y);
+}
+
+static int item_cmp_miss(const void *a, const void *b) {
+  const Item *x = a, *y = b;
+  if (x->l1_miss != y->l1_miss) return (x->l1_miss < y->l1_miss) - (x->l1_miss > y->l1_miss);
+  return (x->l2_miss < y->l2_miss) - (x->l2_miss > y->l2_miss);
+}
+
+// the pcs are merged by function, or by page if they are not in any function
+void cachesim_report() {
+  if (pc_stat == NULL) return;
+  int i;
+  for (i = 0; i < NR_CACHE; i ++) {
+    Cache *c = &cache[i];
+    uint64_t total = c->hit + c->miss;
+    if (c->sets == 0 || total == 0) continue;
+    Log("cachesim: %-3s %" PRIu64 " accesses, %" PRIu64 " misses, miss rate = %.2f%%, %" PRIu64 " writebacks",
+        c->name, total, c->miss, c->miss * 100.0 / total, c->writeback);
+  }
+
+  Item *item = malloc(sizeof(Item) * (nr_pc_stat + 1));
+  assert(item != NULL);
+  int nr = 0, n = 0;
+  uint64_t j;
+  for (j = 0; j < pc_stat_size; j ++) {
+    PCStat *p = &pc_stat[j];
+    if (p->access == 0) continue;
+    item[nr ++] = (Item) { .name = symbol_lookup(p->pc, NULL), .pc = p->pc,
+      .access = p->access, .l1_miss = p->l1_miss, .l2_miss = p->l2_miss };
+  }
+  qsort(item, nr, sizeof(Item), item_cmp_pc);
+  for (i = 0; i < nr; i ++) {
+    Item *last = (n > 0 ? &item[n - 1] : NULL);
+    bool merge = (last != NULL && (item[i].name != NULL ? item[i].name == last->name :
+          last->name == NULL && (item[i].pc & ~(vaddr_t)0xfff) == (last->pc & ~(vaddr_t)0xfff)));
+    if (merge) {
+      last->access += item[i].access;
+      last->l1_miss += item[i].l1_miss;
+      last->l2_miss += item[i].l2_miss;
+    } else item[n ++] = item[i];
+  }
+  qsort(item, n, sizeof(Item), item_cmp_miss);
+
+  Log("cachesim: the pc ranges missing most, with accesses, L1 misses and L2 misses:");
+  for (i = 0; i < n && i < NR_REPORT; i ++) {
+    char range[64];
+    if (item[i].name != NULL) snprintf(range, sizeof(range), "%s", item[i].name);
+    else snprintf(range, sizeof(range), FMT_WORD "+0x1000", item[i].pc & ~(vaddr_t)0xfff);
+    Log("  %-24s %14" PRIu64 " %14" PRIu64 " %14" PRIu64, range, item[i].access, item[i].l1_miss, item[i].l2_miss);
+  }
+  free(item);
+}
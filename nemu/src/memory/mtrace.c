@@ -0,0 +1,193 @@
+/***************************************************************************************
+* Copyright (c) 2014-2024 Zihao Yu, Nanjing University
+*
+* NEMU is licensed under Mulan PSL v2.
+* You can use this software according to the terms and conditions of the Mulan PSL v2.
+* You may obtain a copy of Mulan PSL v2 at:
+*          http://license.coscl.org.cn/MulanPSL2
+*
+* THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+* EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+* MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+*
+* See the Mulan PSL v2 for more details.
+***************************************************************************************/
+
+
+#include <isa.h>
+#include <memory/mtrace.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+
+#define RING_SIZE CONFIG_MTRACE_RING_SIZE
+#define MAX_FILTER 8
+
+static_assert((RING_SIZE & (RING_SIZE - 1)) == 0, "the size of the ring should be a power of 2");
+
+typedef struct {
+  word_t lo, hi;
+} Range;
+
+// filters are only changed by sdb while the guest is stopped
+static Range addr_filter[MAX_FILTER], pc_filter[MAX_FILTER];
+static int nr_addr_filter = 0, nr_pc_filter = 0;
+
+/* A single-producer single-consumer ring. The guest thread only writes
+ * `head` and the consumer thread only writes `tail`, so no lock is needed.
+ * The consumer writes the records into the trace file and feeds them to the
+ * cache simulator, and runs as long as either of them is on. */
+static MTraceRecord ring[RING_SIZE];
+static uint64_t head = 0, tail = 0;
+static uint64_t nr_record = 0, nr_stall = 0;
+
+bool mtrace_on = false;
+IFDEF(CONFIG_CACHESIM, bool mtrace_ifetch_on = false);
+static bool consumer_quit = false;
+static pthread_t consumer;
+static TraceFile *trace_tf = NULL;
+static char *trace_file = NULL;
+static bool cachesim_on = false;
+
+static inline bool in_filter(Range *r, int n, word_t x) {
+  if (n == 0) return true;
+  int i;
+  for (i = 0; i < n; i ++) {
+    if (x >= r[i].lo && x <= r[i].hi) return true;
+  }
+  return false;
+}
+
+void mtrace_record(paddr_t addr, int len, word_t data, int is_write) {
+  if (!in_filter(addr_filter, nr_addr_filter, addr)) return;
+  if (!in_filter(pc_filter, nr_pc_filter, cpu.pc)) return;
+
+  uint64_t h = head;
+  while (h - __atomic_load_n(&tail, __ATOMIC_ACQUIRE) == RING_SIZE) {
+    // wait for the consumer instead of dropping records
+    nr_stall ++;
+    sched_yield();
+  }
+  if (len < sizeof(word_t)) data &= (1ull << (len * 8)) - 1;
+  ring[h % RING_SIZE] = (MTraceRecord) {
+    .pc = cpu.pc, .data = data, .addr = addr, .len = len, .is_write = is_write
+  };
+  __atomic_store_n(&head, h + 1, __ATOMIC_RELEASE);
+  nr_record ++;
+}
+
+static void* consumer_thread(void *arg) {
+  while (true) {
+    // check for quitting first, so that records published before it are seen below
+    bool quit = __atomic_load_n(&consumer_quit, __ATOMIC_ACQUIRE);
+    uint64_t h = __atomic_load_n(&head, __ATOMIC_ACQUIRE);
+    if (h == tail) {
+      if (quit) break;
+      usleep(1000);
+      continue;
+    }
+    uint64_t idx = tail % RING_SIZE, n = h - tail;
+    if (idx + n > RING_SIZE) n = RING_SIZE - idx;
+    if (trace_tf != NULL) tfile_write(trace_tf, &ring[idx], n * sizeof(MTraceRecord));
+    IFDEF(CONFIG_CACHESIM, if (cachesim_on) cachesim_feed(&ring[idx], n));
+    __atomic_store_n(&tail, tail + n, __ATOMIC_RELEASE);
+  }
+  if (trace_tf != NULL) tfile_flush(trace_tf);
+  return NULL;
+}
+
+// the consumer only reads its sinks while running, so they are changed between these
+static void ring_stop() {
+  if (!mtrace_on) return;
+  mtrace_on = false;
+  IFDEF(CONFIG_CACHESIM, mtrace_ifetch_on = false);
+  __atomic_store_n(&consumer_quit, true, __ATOMIC_RELEASE);
+  pthread_join(consumer, NULL);
+}
+
+static void ring_start() {
+  if (trace_tf == NULL && !cachesim_on) return;
+  head = tail = 0;
+  consumer_quit = false;
+  int ret = pthread_create(&consumer, NULL, consumer_thread, NULL);
+  Assert(ret == 0, "Can not create the consumer thread of mtrace");
+  FOOTPRINT("trace", ring, sizeof(ring));
+  mtrace_on = true;
+  IFDEF(CONFIG_CACHESIM, mtrace_ifetch_on = cachesim_on);
+}
+
+static void close_trace() {
+  if (trace_tf == NULL) return;
+  tfile_close(trace_tf);
+  trace_tf = NULL;
+  Log("mtrace: %" PRIu64 " records written to %s", nr_record, trace_file);
+}
+
+static void mtrace_exit() {
+  ring_stop();
+  close_trace();
+}
+
+bool mtrace_start(const char *file) {
+  ring_stop();
+  close_trace();
+  trace_tf = tfile_open(file, NULL, 0);
+  if (trace_tf != NULL) {
+    free(trace_file);
+    trace_file = strdup(file);
+    nr_record = nr_stall = 0;
+    static bool registered = false;
+    if (!registered) { atexit(mtrace_exit); registered = true; }
+  }
+  ring_start();
+  return trace_tf != NULL;
+}
+
+void mtrace_stop() {
+  ring_stop();
+  close_trace();
+  ring_start();
+}
+
+#ifdef CONFIG_CACHESIM
+bool mtrace_cachesim(const char *spec) {
+  ring_stop();
+  cachesim_on = (spec != NULL && cachesim_init(spec));
+  ring_start();
+  return spec == NULL || cachesim_on;
+}
+
+void mtrace_cachesim_report() {
+  if (!cachesim_on) return;
+  ring_stop();
+  cachesim_report();
+  ring_start();
+}
+#endif
+
+bool mtrace_add_filter(bool is_pc, word_t lo, word_t hi) {
+  Range *r = (is_pc ? pc_filter : addr_filter);
+  int *n = (is_pc ? &nr_pc_filter : &nr_addr_filter);
+  if (*n == MAX_FILTER || lo > hi) return false;
+  r[(*n) ++] = (Range) { .lo = lo, .hi = hi };
+  return true;
+}
+
+void mtrace_clear_filter() {
+  nr_addr_filter = nr_pc_filter = 0;
+}
+
+void mtrace_display() {
+  if (trace_tf != NULL) {
+    printf("mtrace is on, writing to %s, %" PRIu64 " records, %" PRIu64 " stalls\n",
+        trace_file, nr_record, nr_stall);
+  } else printf("mtrace is off\n");
+  if (cachesim_on) printf("the cache simulator is fed by mtrace\n");
+  int i;
+  for (i = 0; i < nr_addr_filter; i ++) {
+    printf("addr [" FMT_WORD ", " FMT_WORD "]\n", addr_filter[i].lo, addr_filter[i].hi);
+  }
+  for (i = 0; i < nr_pc_filter; i ++) {
+    printf("pc   [" FMT_WORD ", " FMT_WORD "]\n", pc_filter[i].lo, pc_filter[i].hi);
+  }
+}
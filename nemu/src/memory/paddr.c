@@ -13,12 +13,27 @@
 * See the Mulan PSL v2 for more details.
 ***************************************************************************************/
 
+#define _GNU_SOURCE
 #include <memory/host.h>
 #include <memory/paddr.h>
+#include <memory/vaddr.h>
+#include <memory/mtrace.h>
 #include <device/mmio.h>
+#include <device/map.h>
 #include <isa.h>
+#include <cpu/cpu.h>
+#include <cpu/hart.h>
+#include <difftest-def.h>
+#ifdef CONFIG_PMEM_MMAP
+#include <sys/mman.h>
+#include <signal.h>
+#include <unistd.h>
+#endif
+#ifdef CONFIG_LOCKSTEP
+#include <cpu/lockstep.h>
+#endif
 
-#if   defined(CONFIG_PMEM_MALLOC)
+#if   defined(CONFIG_PMEM_MALLOC) || defined(CONFIG_PMEM_MMAP)
 static uint8_t *pmem = NULL;
 #else // CONFIG_PMEM_GARRAY
 static uint8_t pmem[CONFIG_MSIZE] PG_ALIGN = {};
@@ -27,38 +42,454 @@ static uint8_t pmem[CONFIG_MSIZE] PG_ALIGN = {};
 uint8_t* guest_to_host(paddr_t paddr) { return pmem + paddr - CONFIG_MBASE; }
 paddr_t host_to_guest(uint8_t *haddr) { return haddr - pmem + CONFIG_MBASE; }
 
-static word_t pmem_read(paddr_t addr, int len) {
+static inline word_t pmem_read(paddr_t addr, int len) {
   word_t ret = host_read(guest_to_host(addr), len);
   return ret;
 }
 
-static void pmem_write(paddr_t addr, int len, word_t data) {
+#ifdef CONFIG_MEM_CODE_PAGE
+bool pmem_code_page[CONFIG_MSIZE / PAGE_SIZE] = {};
+
+void paddr_mark_code(paddr_t paddr) {
+  // code fetched from MMIO is not tracked
+  if (!in_pmem(paddr)) return;
+  pmem_code_page[(paddr - CONFIG_MBASE) >> PAGE_SHIFT] = true;
+  // the instances in lockstep may hold different code in a page written
+  IFDEF(CONFIG_LOCKSTEP, if (paddr_is_dirty(paddr)) lockstep_private_code(paddr & ~PAGE_MASK));
+}
+
+static inline void check_code_page(paddr_t addr) {
+  int idx = (addr - CONFIG_MBASE) >> PAGE_SHIFT;
+  if (unlikely(pmem_code_page[idx])) {
+    pmem_code_page[idx] = false;
+    paddr_t page = addr & ~PAGE_MASK;
+    IFDEF(CONFIG_DECODE_CACHE, isa_flush_decode_cache(page));
+    IFDEF(CONFIG_HART_THREAD, hart_code_written());
+    IFDEF(CONFIG_ENGINE_JIT, void jit_flush_page(paddr_t page); jit_flush_page(page));
+    IFDEF(CONFIG_ENGINE_BLOCK, void block_flush_page(paddr_t page); block_flush_page(page));
+    IFDEF(CONFIG_PLUGIN, plugin_flush_page(page));
+  }
+}
+#endif
+
+#ifdef CONFIG_PMEM_DIRTY
+#define NR_PMEM_PAGE (CONFIG_MSIZE / PAGE_SIZE)
+uint64_t pmem_dirty[(NR_PMEM_PAGE + 63) / 64] = {};
+
+bool paddr_next_dirty(paddr_t *page) {
+  uint64_t idx = (*page - CONFIG_MBASE) >> PAGE_SHIFT;
+  while (idx < NR_PMEM_PAGE) {
+    uint64_t w = pmem_dirty[idx / 64] >> (idx % 64);
+    if (w != 0) {
+      idx += __builtin_ctzll(w);
+      if (idx >= NR_PMEM_PAGE) break;
+      *page = CONFIG_MBASE + (idx << PAGE_SHIFT);
+      return true;
+    }
+    idx = (idx / 64 + 1) * 64;
+  }
+  return false;
+}
+
+void paddr_clear_dirty(paddr_t addr, size_t size) {
+  if (size == 0) return;
+  uint64_t l = (addr - CONFIG_MBASE) >> PAGE_SHIFT;
+  uint64_t r = (addr - CONFIG_MBASE + size - 1) >> PAGE_SHIFT;
+  for (; l <= r && l % 64 != 0; l ++) pmem_dirty[l / 64] &= ~(1ull << (l % 64));
+  for (; l + 63 <= r; l += 64) pmem_dirty[l / 64] = 0;
+  for (; l <= r; l ++) pmem_dirty[l / 64] &= ~(1ull << (l % 64));
+}
+#endif
+
+static inline void pmem_written(paddr_t addr, int len) {
+  IFDEF(CONFIG_PMEM_DIRTY, paddr_mark_dirty(addr));
+  IFDEF(CONFIG_MEM_CODE_PAGE, check_code_page(addr));
+  if (unlikely(((addr ^ (addr + len - 1)) & ~PAGE_MASK) != 0)) {
+    IFDEF(CONFIG_PMEM_DIRTY, paddr_mark_dirty(addr + len - 1));
+    IFDEF(CONFIG_MEM_CODE_PAGE, check_code_page(addr + len - 1));
+  }
+  IFDEF(CONFIG_WATCHPOINT, paddr_check_watch(addr, len));
+}
+
+static inline void pmem_write(paddr_t addr, int len, word_t data) {
   host_write(guest_to_host(addr), len, data);
+  pmem_written(addr, len);
+}
+
+void paddr_atomic_written(paddr_t addr, int len) {
+  pmem_written(addr, len);
+}
+
+void paddr_host_written(paddr_t addr, size_t len) {
+  if (len == 0) return;
+  paddr_t page = addr & ~PAGE_MASK, last = (addr + len - 1) & ~PAGE_MASK;
+  while (true) {
+    IFDEF(CONFIG_PMEM_DIRTY, paddr_mark_dirty(page));
+    IFDEF(CONFIG_MEM_CODE_PAGE, check_code_page(page));
+    if (page == last) break;
+    page += PAGE_SIZE;
+  }
+  IFDEF(CONFIG_WATCHPOINT, wp_check_write(addr, len));
+  // REF does not have the device
+  IFDEF(CONFIG_DIFFTEST, ref_difftest_memcpy(addr, guest_to_host(addr), len, DIFFTEST_TO_REF));
+}
+
+typedef struct {
+  uint8_t *host;
+  IOMap *map;
+} Region;
+
+#define NR_REGION (1ull << (32 - PAGE_SHIFT))
+#define REGION_LIMIT ((uint64_t)NR_REGION << PAGE_SHIFT)
+// entries of untouched pages are never committed by the host
+static Region region[NR_REGION] = {};
+
+static inline Region* region_fetch(paddr_t addr) {
+#ifdef PMEM64
+  static Region region_none = {};
+  if (unlikely((uint64_t)addr >= REGION_LIMIT)) return &region_none;
+#endif
+  return &region[addr >> PAGE_SHIFT];
+}
+
+void paddr_set_region(paddr_t page, uint8_t *host, IOMap *map) {
+  if ((uint64_t)page >= REGION_LIMIT) return;
+  region[page >> PAGE_SHIFT] = (Region) { .host = host, .map = map };
 }
 
-static void out_of_bound(paddr_t addr) {
+uint8_t* paddr_host_page(paddr_t page, bool *is_io) {
+  if (in_pmem(page)) { *is_io = false; return guest_to_host(page); }
+  Region *r = region_fetch(page);
+  *is_io = true;
+  return r->host;
+}
+
+static void out_of_bound(paddr_t addr, int type) {
+  IFDEF(CONFIG_MEM_EXCEPTION, cpu_raise_exception(isa_mem_exception(addr, type, false)));
+  IFDEF(CONFIG_LOCKSTEP, lockstep_crash());
   panic("address = " FMT_PADDR " is out of bound of pmem [" FMT_PADDR ", " FMT_PADDR "] at pc = " FMT_WORD,
       addr, PMEM_LEFT, PMEM_RIGHT, cpu.pc);
 }
 
+// REF shares the handler of SIGSEGV with DUT, so it fills pmem at once
+#if defined(CONFIG_PMEM_MMAP) && defined(CONFIG_MEM_RANDOM) && !defined(CONFIG_TARGET_SHARE)
+#define PMEM_LAZY_RANDOM
+#endif
+
+#ifdef PMEM_LAZY_RANDOM
+/* pmem is mapped without access at first. Touching a chunk of it raises
+ * SIGSEGV, and the handler fills the chunk with the random value and opens
+ * it for access, so that untouched memory is neither filled nor committed.
+ */
+// keep a huge page in a single chunk
+#define LAZY_CHUNK MUXDEF(CONFIG_PMEM_HUGEPAGE, (2 * 1024 * 1024), (64 * 1024))
+#define NR_LAZY_CHUNK ((CONFIG_MSIZE + LAZY_CHUNK - 1) / LAZY_CHUNK)
+static uint8_t random_byte = 0;
+static bool chunk_ready[NR_LAZY_CHUNK] = {};
+
+static void fill_chunk(size_t idx) {
+  if (chunk_ready[idx]) return;
+  size_t offset = idx * LAZY_CHUNK;
+  size_t size = (CONFIG_MSIZE - offset < LAZY_CHUNK ? CONFIG_MSIZE - offset : LAZY_CHUNK);
+  int ret = mprotect(pmem + offset, size, PROT_READ | PROT_WRITE);
+  assert(ret == 0);
+  memset(pmem + offset, random_byte, size);
+  chunk_ready[idx] = true;
+}
+
+static void pmem_fault_handler(int sig, siginfo_t *info, void *ucontext) {
+  uint8_t *addr = info->si_addr;
+  if (addr < pmem || addr >= pmem + CONFIG_MSIZE) {
+    // not caused by pmem, fault again with the default action
+    signal(SIGSEGV, SIG_DFL);
+    return;
+  }
+  fill_chunk((addr - pmem) / LAZY_CHUNK);
+}
+
+static void init_lazy_random() {
+  random_byte = rand();
+  struct sigaction s;
+  memset(&s, 0, sizeof(s));
+  s.sa_sigaction = pmem_fault_handler;
+  s.sa_flags = SA_SIGINFO;
+  int ret = sigaction(SIGSEGV, &s, NULL);
+  Assert(ret == 0, "Can not set signal handler");
+}
+#endif
+
+void paddr_host_access(paddr_t addr, size_t len) {
+#ifdef PMEM_LAZY_RANDOM
+  // a system call does not fault, so the chunks are filled before it
+  if (len == 0 || !in_pmem(addr)) return;
+  size_t lo = addr - CONFIG_MBASE;
+  size_t hi = (len > CONFIG_MSIZE - lo ? CONFIG_MSIZE : lo + len);
+  size_t i;
+  for (i = lo / LAZY_CHUNK; i <= (hi - 1) / LAZY_CHUNK; i ++) fill_chunk(i);
+#endif
+}
+
+#ifdef CONFIG_PMEM_MMAP
+IFDEF(CONFIG_PMEM_HUGEPAGE, static bool pmem_hugetlb = false);
+// the byte filling each page left out of the memory file by paddr_pmem_freeze()
+static uint8_t *frozen_fill = NULL;
+// set if pmem is a memory file mapped by paddr_pmem_switch()
+static bool pmem_shared = false;
+
+static uint8_t* map_pmem() {
+#ifdef PMEM_LAZY_RANDOM
+  int prot = PROT_NONE;
+#else
+  int prot = PROT_READ | PROT_WRITE;
+#endif
+  const char *backing = "normal pages";
+  void *p = MAP_FAILED;
+#ifdef CONFIG_PMEM_HUGEPAGE
+  // huge pages are reserved here, instead of failing when they are touched
+  p = mmap(NULL, CONFIG_MSIZE, prot, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+  if (p != MAP_FAILED) backing = "hugetlbfs";
+#endif
+  if (p == MAP_FAILED) {
+    p = mmap(NULL, CONFIG_MSIZE, prot, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    Assert(p != MAP_FAILED, "Can not map pmem");
+#ifdef CONFIG_PMEM_HUGEPAGE
+    if (madvise(p, CONFIG_MSIZE, MADV_HUGEPAGE) == 0) backing = "transparent huge pages";
+#endif
+  }
+  Log("pmem is backed by %s", backing);
+  IFDEF(CONFIG_PMEM_HUGEPAGE, pmem_hugetlb = (strcmp(backing, "hugetlbfs") == 0));
+  return p;
+}
+
+bool pmem_map_file(paddr_t addr, int fd, size_t size) {
+  size_t offset = addr - CONFIG_MBASE;
+  // part of a hugetlbfs mapping can not be replaced by a file, a file mapped
+  // over frozen pmem would be brought back by paddr_pmem_restore(), and one
+  // mapped over a shared memory file would not be written into it
+  if (MUXDEF(CONFIG_PMEM_HUGEPAGE, pmem_hugetlb, false) || frozen_fill != NULL || pmem_shared || size == 0 ||
+      (offset & PAGE_MASK) != 0 || size > CONFIG_MSIZE - offset) return false;
+#ifdef PMEM_LAZY_RANDOM
+  // chunks partially covered by the file would not fault as a whole later
+  fill_chunk(offset / LAZY_CHUNK);
+  fill_chunk((offset + size - 1) / LAZY_CHUNK);
+  size_t i;
+  for (i = offset / LAZY_CHUNK; i <= (offset + size - 1) / LAZY_CHUNK; i ++) chunk_ready[i] = true;
+#endif
+  void *p = mmap(pmem + offset, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, fd, 0);
+  return p != MAP_FAILED;
+}
+
+/* The pages not filled with a single byte are copied into a memory file,
+ * which is then mapped to pmem copy-on-write in place. A page written later
+ * gets a private copy, and dropping the copy brings back the page in the
+ * file. The blank pages are holes in the file, so they read as zero, and
+ * those filled with another byte are filled again after being dropped. */
+bool paddr_pmem_freeze() {
+  if (MUXDEF(CONFIG_PMEM_HUGEPAGE, pmem_hugetlb, false)) return false;
+  int fd = memfd_create("pmem-frozen", 0);
+  if (fd < 0) return false;
+  if (ftruncate(fd, CONFIG_MSIZE) != 0) { close(fd); return false; }
+  if (frozen_fill == NULL) frozen_fill = malloc(CONFIG_MSIZE / PAGE_SIZE);
+  assert(frozen_fill != NULL);
+  paddr_t page;
+  for (page = PMEM_LEFT; page - PMEM_LEFT < CONFIG_MSIZE; page += PAGE_SIZE) {
+    uint8_t *fill = &frozen_fill[(page - PMEM_LEFT) / PAGE_SIZE];
+    if (paddr_page_blank(page, fill)) continue;
+    *fill = 0;
+    ssize_t n = pwrite(fd, guest_to_host(page), PAGE_SIZE, page - PMEM_LEFT);
+    assert(n == PAGE_SIZE);
+  }
+  void *p = mmap(pmem, CONFIG_MSIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, fd, 0);
+  Assert(p == pmem, "Can not map pmem");
+  close(fd);
+#ifdef PMEM_LAZY_RANDOM
+  // untouched chunks stay untouched, and are filled when they fault
+  size_t i;
+  for (i = 0; i < NR_LAZY_CHUNK; i ++) {
+    if (chunk_ready[i]) continue;
+    size_t offset = i * LAZY_CHUNK;
+    size_t size = (CONFIG_MSIZE - offset < LAZY_CHUNK ? CONFIG_MSIZE - offset : LAZY_CHUNK);
+    int ret = mprotect(pmem + offset, size, PROT_NONE);
+    assert(ret == 0);
+  }
+#endif
+  for (page = PMEM_LEFT; page - PMEM_LEFT < CONFIG_MSIZE; page += PAGE_SIZE) {
+    uint8_t fill = frozen_fill[(page - PMEM_LEFT) / PAGE_SIZE];
+#ifdef PMEM_LAZY_RANDOM
+    if (!chunk_ready[(page - PMEM_LEFT) / LAZY_CHUNK]) continue;
+#endif
+    if (fill != 0) memset(guest_to_host(page), fill, PAGE_SIZE);
+  }
+  return true;
+}
+
+void paddr_pmem_switch(int fd) {
+  void *p = mmap(pmem, CONFIG_MSIZE, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0);
+  Assert(p == pmem, "Can not map pmem");
+  pmem_shared = true;
+}
+
+void paddr_pmem_restore(paddr_t addr, size_t size) {
+  assert(frozen_fill != NULL);
+  int ret = madvise(guest_to_host(addr), size, MADV_DONTNEED);
+  assert(ret == 0);
+  paddr_t page;
+  for (page = addr; page - addr < size; page += PAGE_SIZE) {
+    uint8_t fill = frozen_fill[(page - PMEM_LEFT) / PAGE_SIZE];
+    if (fill != 0) memset(guest_to_host(page), fill, PAGE_SIZE);
+  }
+}
+#endif
+
+// untouched chunks of lazy pmem are taken as filled, without committing them
+bool paddr_page_blank(paddr_t page, uint8_t *byte) {
+#ifdef PMEM_LAZY_RANDOM
+  if (!chunk_ready[(page - CONFIG_MBASE) / LAZY_CHUNK]) { *byte = random_byte; return true; }
+#endif
+  const uint64_t *p = (const uint64_t *)guest_to_host(page);
+  uint64_t w = p[0];
+  if (w != (w & 0xff) * 0x0101010101010101ull) return false;
+  int i;
+  for (i = 1; i < PAGE_SIZE / sizeof(uint64_t); i ++) {
+    if (p[i] != w) return false;
+  }
+  *byte = w & 0xff;
+  return true;
+}
+
+void paddr_fill(uint8_t byte) {
+#ifdef CONFIG_PMEM_MMAP
+  // map pmem again to drop the pages committed, including those of files
+  if (!MUXDEF(CONFIG_PMEM_HUGEPAGE, pmem_hugetlb, false)) {
+#ifdef PMEM_LAZY_RANDOM
+    int prot = PROT_NONE;
+#else
+    int prot = PROT_READ | PROT_WRITE;
+#endif
+    void *p = mmap(pmem, CONFIG_MSIZE, prot, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED | MAP_NORESERVE, -1, 0);
+    Assert(p == pmem, "Can not map pmem");
+    IFDEF(CONFIG_PMEM_HUGEPAGE, madvise(pmem, CONFIG_MSIZE, MADV_HUGEPAGE));
+    free(frozen_fill);
+    frozen_fill = NULL;
+    pmem_shared = false;
+#ifdef PMEM_LAZY_RANDOM
+    memset(chunk_ready, 0, sizeof(chunk_ready));
+    random_byte = byte;
+    return;
+#endif
+    if (byte == 0) return;
+  }
+#endif
+  memset(pmem, byte, CONFIG_MSIZE);
+}
+
+#ifdef CONFIG_LOCKSTEP
+int paddr_pmem_clone() {
+  // pmem stays the same between the calls, so the pages to copy are found once
+  static paddr_t *used = NULL;
+  static int nr_used = -1;
+  paddr_t page;
+  if (nr_used < 0) {
+    used = malloc(sizeof(paddr_t) * (CONFIG_MSIZE / PAGE_SIZE));
+    assert(used != NULL);
+    nr_used = 0;
+    for (page = PMEM_LEFT; page - PMEM_LEFT < CONFIG_MSIZE; page += PAGE_SIZE) {
+      uint8_t byte;
+      if (!paddr_page_blank(page, &byte) || byte != 0) used[nr_used ++] = page;
+    }
+  }
+  int fd = memfd_create("pmem", 0);
+  Assert(fd >= 0 && ftruncate(fd, CONFIG_MSIZE) == 0, "Can not create a memory file for pmem");
+  int i;
+  for (i = 0; i < nr_used; i ++) {
+    ssize_t n = pwrite(fd, guest_to_host(used[i]), PAGE_SIZE, used[i] - PMEM_LEFT);
+    assert(n == PAGE_SIZE);
+  }
+  return fd;
+}
+
+#endif
+
 void init_mem() {
 #if   defined(CONFIG_PMEM_MALLOC)
   pmem = malloc(CONFIG_MSIZE);
   assert(pmem);
+#elif defined(CONFIG_PMEM_MMAP)
+  pmem = map_pmem();
 #endif
+  FOOTPRINT("pmem", pmem, CONFIG_MSIZE);
+#ifdef PMEM_LAZY_RANDOM
+  init_lazy_random();
+#else
   IFDEF(CONFIG_MEM_RANDOM, memset(pmem, rand(), CONFIG_MSIZE));
+#endif
+  paddr_t page;
+  for (page = PMEM_LEFT; page - PMEM_LEFT < CONFIG_MSIZE; page += PAGE_SIZE) {
+    paddr_set_region(page, guest_to_host(page), NULL);
+  }
+  IFDEF(CONFIG_VADDR_TLB, vaddr_tlb_flush());
   Log("physical memory area [" FMT_PADDR ", " FMT_PADDR "]", PMEM_LEFT, PMEM_RIGHT);
 }
 
-word_t paddr_read(paddr_t addr, int len) {
-  if (likely(in_pmem(addr))) return pmem_read(addr, len);
-  IFDEF(CONFIG_DEVICE, return mmio_read(addr, len));
-  out_of_bound(addr);
+/* The accessors below are inlined into each width-specific entry point,
+ * so that `len` is a constant and the size dispatch is folded away. */
+static inline __attribute__((always_inline)) word_t paddr_do_read(paddr_t addr, int len, int type) {
+  Region *r = region_fetch(addr);
+  if (likely(r->host != NULL)) {
+    if (likely(r->map == NULL)) return pmem_read(addr, len);
+    difftest_skip_ref();
+    return host_read(r->host + (addr & PAGE_MASK), len);
+  }
+  IFDEF(PMEM64, if (in_pmem(addr)) return pmem_read(addr, len));
+#ifdef CONFIG_DEVICE
+  if (r->map != NULL) { difftest_skip_ref(); return map_read(addr, len, r->map); }
+  IFDEF(CONFIG_MEM_EXCEPTION, if (unlikely(!mmio_map_exists(addr))) out_of_bound(addr, type));
+  return mmio_read(addr, len);
+#endif
+  out_of_bound(addr, type);
   return 0;
 }
 
+// instruction fetches are not traced
+word_t paddr_ifetch(paddr_t addr, int len) {
+  return paddr_do_read(addr, len, MEM_TYPE_IFETCH);
+}
+
+word_t paddr_read(paddr_t addr, int len) {
+  word_t ret = paddr_do_read(addr, len, MEM_TYPE_READ);
+  MTRACE(addr, len, ret, false);
+  return ret;
+}
+
+static inline __attribute__((always_inline)) void paddr_do_write(paddr_t addr, int len, word_t data) {
+  MTRACE(addr, len, data, true);
+  Region *r = region_fetch(addr);
+  if (likely(r->host != NULL)) {
+    if (likely(r->map == NULL)) { pmem_write(addr, len, data); return; }
+    difftest_skip_ref();
+    host_write(r->host + (addr & PAGE_MASK), len, data);
+    return;
+  }
+  IFDEF(PMEM64, if (in_pmem(addr)) { pmem_write(addr, len, data); return; });
+#ifdef CONFIG_DEVICE
+  if (r->map != NULL) { difftest_skip_ref(); map_write(addr, len, data, r->map); return; }
+  IFDEF(CONFIG_MEM_EXCEPTION, if (unlikely(!mmio_map_exists(addr))) out_of_bound(addr, MEM_TYPE_WRITE));
+  mmio_write(addr, len, data);
+  return;
+#endif
+  out_of_bound(addr, MEM_TYPE_WRITE);
+}
+
 void paddr_write(paddr_t addr, int len, word_t data) {
-  if (likely(in_pmem(addr))) { pmem_write(addr, len, data); return; }
-  IFDEF(CONFIG_DEVICE, mmio_write(addr, len, data); return);
-  out_of_bound(addr);
+  paddr_do_write(addr, len, data);
 }
+
+#define PADDR_ACCESS(bytes, bits) \
+  word_t paddr_read_##bytes(paddr_t addr) { \
+    word_t ret = paddr_do_read(addr, bytes, MEM_TYPE_READ); \
+    MTRACE(addr, bytes, ret, false); \
+    return ret; \
+  } \
+  void paddr_write_##bytes(paddr_t addr, word_t data) { paddr_do_write(addr, bytes, data); }
+
+MAP(MEM_ACCESS_WIDTH, PADDR_ACCESS)
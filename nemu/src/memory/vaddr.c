@@ -14,16 +14,248 @@
 ***************************************************************************************/
 
 #include <isa.h>
+#include <memory/host.h>
 #include <memory/paddr.h>
+#include <memory/vaddr.h>
+#include <memory/mtrace.h>
+#include <cpu/timing.h>
+#include <cpu/difftest.h>
+#include <cpu/cpu.h>
+
+// `superpage` is set if the translation holds for the whole superpage
+static paddr_t vaddr_translate_page(vaddr_t addr, int len, int type, bool *superpage) {
+  paddr_t ret = isa_mmu_translate(addr, len, type);
+  *superpage = (ret & MEM_RET_SUPERPAGE) != 0;
+  ret &= ~(paddr_t)MEM_RET_SUPERPAGE;
+#ifdef CONFIG_MEM_EXCEPTION
+  if (unlikely((ret & PAGE_MASK) != MEM_RET_OK)) cpu_raise_exception(isa_mem_exception(addr, type, true));
+#endif
+  Assert((ret & PAGE_MASK) == MEM_RET_OK, "fail to translate vaddr = " FMT_WORD
+      " at pc = " FMT_WORD, addr, cpu.pc);
+  return (ret & ~PAGE_MASK) | (addr & PAGE_MASK);
+}
+
+static paddr_t vaddr_translate(vaddr_t addr, int len, int type) {
+  bool superpage;
+  return vaddr_translate_page(addr, len, type, &superpage);
+}
+
+static inline word_t paddr_read_type(paddr_t addr, int len, int type) {
+  return (type == MEM_TYPE_IFETCH ? paddr_ifetch(addr, len) : paddr_read(addr, len));
+}
+
+static inline bool cross_page(vaddr_t addr, int len) {
+  return ((addr ^ (addr + len - 1)) & ~PAGE_MASK) != 0;
+}
+
+// translate and access an address crossing pages byte by byte
+static word_t vaddr_read_cross(vaddr_t addr, int len, int type) {
+  word_t ret = 0;
+  int i;
+  for (i = 0; i < len; i ++) {
+    ret |= paddr_read_type(vaddr_translate(addr + i, 1, type), 1, type) << (i * 8);
+  }
+  return ret;
+}
+
+static void vaddr_write_cross(vaddr_t addr, int len, word_t data) {
+  int i;
+  for (i = 0; i < len; i ++) {
+    paddr_write(vaddr_translate(addr + i, 1, MEM_TYPE_WRITE), 1, data >> (i * 8));
+  }
+}
+
+#ifdef CONFIG_VADDR_TLB
+/* A direct-mapped TLB for each type of access. An entry maps a virtual page
+ * to the host address of the physical page it is translated to, so that a
+ * hit takes neither a page table walk nor a check of the physical address.
+ * Besides pmem, this covers the pages of MMIO maps without callback, such as
+ * framebuffers, which are plain memory to the guest. Other pages are always
+ * translated again.
+ *
+ * Translations of superpages are also kept in a small fully-associative
+ * array, which is searched when the direct-mapped one misses. A hit there
+ * refills the entry of the page without walking the page table, so a kernel
+ * mapped by megapages does not take a walk for each of its pages.
+ */
+#define TLB_SIZE 256
+#define TLB_SUPER_SIZE 16
+#define TLB_INVALID ((vaddr_t)1) // never matches, since tags are page aligned
+
+typedef struct {
+  vaddr_t tag;
+  paddr_t ppage;
+  uint8_t *host;
+  bool is_io; // the page belongs to an MMIO map, which REF does not have
+} TLBEntry;
+
+typedef struct {
+  vaddr_t tag; // aligned to SUPERPAGE_SIZE
+  paddr_t pbase;
+} TLBSuperEntry;
+
+static HART_LOCAL TLBEntry tlb[3][TLB_SIZE] = {};
+static HART_LOCAL TLBSuperEntry tlb_super[3][TLB_SUPER_SIZE] = {};
+static HART_LOCAL int tlb_super_next[3] = {}; // replaced in turn
+static HART_LOCAL uint64_t tlb_hit[3] = {}, tlb_miss[3] = {}, tlb_super_hit[3] = {};
+
+void vaddr_tlb_flush() {
+  int t, i;
+  for (t = 0; t < 3; t ++) {
+    for (i = 0; i < TLB_SIZE; i ++) tlb[t][i].tag = TLB_INVALID;
+    for (i = 0; i < TLB_SUPER_SIZE; i ++) tlb_super[t][i].tag = TLB_INVALID;
+  }
+}
+
+void vaddr_tlb_flush_range(vaddr_t addr, word_t size) {
+  vaddr_t first = addr & ~PAGE_MASK, last = (addr + size - 1) & ~PAGE_MASK;
+  if (size == 0) return;
+  if (last < first || ((last - first) >> PAGE_SHIFT) >= TLB_SIZE) { vaddr_tlb_flush(); return; }
+  int t, i;
+  for (t = 0; t < 3; t ++) {
+    vaddr_t page = first;
+    do {
+      TLBEntry *e = &tlb[t][(page >> PAGE_SHIFT) % TLB_SIZE];
+      if (e->tag == page) e->tag = TLB_INVALID;
+      page += PAGE_SIZE;
+    } while (page - PAGE_SIZE != last);
+    for (i = 0; i < TLB_SUPER_SIZE; i ++) {
+      vaddr_t tag = tlb_super[t][i].tag;
+      if (tag != TLB_INVALID && tag <= last && tag + SUPERPAGE_MASK >= first) tlb_super[t][i].tag = TLB_INVALID;
+    }
+  }
+}
+
+void vaddr_tlb_display() {
+  static const char *name[] = { "ifetch", "read", "write" };
+  int t;
+  for (t = 0; t < 3; t ++) {
+    uint64_t total = tlb_hit[t] + tlb_miss[t];
+    printf("%-6s hit = %" PRIu64 ", miss = %" PRIu64 " (superpage hit = %" PRIu64 "), hit rate = %.2f%%\n",
+        name[t], tlb_hit[t], tlb_miss[t], tlb_super_hit[t], (total == 0 ? 0 : tlb_hit[t] * 100.0 / total));
+  }
+}
+
+#ifdef CONFIG_LIVE
+void vaddr_tlb_count(uint64_t *hit, uint64_t *miss) {
+  memcpy(hit, tlb_hit, sizeof(tlb_hit));
+  memcpy(miss, tlb_miss, sizeof(tlb_miss));
+}
+#endif
+
+// the physical page of `addr`, from the superpage entries if possible
+static paddr_t tlb_super_fetch(vaddr_t addr, int len, int type) {
+  vaddr_t tag = addr & ~SUPERPAGE_MASK;
+  int i;
+  for (i = 0; i < TLB_SUPER_SIZE; i ++) {
+    TLBSuperEntry *e = &tlb_super[type][i];
+    if (e->tag == tag) {
+      tlb_super_hit[type] ++;
+      return e->pbase | (addr & SUPERPAGE_MASK & ~PAGE_MASK);
+    }
+  }
+  bool superpage;
+  paddr_t ppage = vaddr_translate_page(addr, len, type, &superpage) & ~PAGE_MASK;
+  if (superpage) {
+    TLBSuperEntry *e = &tlb_super[type][tlb_super_next[type]];
+    tlb_super_next[type] = (tlb_super_next[type] + 1) % TLB_SUPER_SIZE;
+    *e = (TLBSuperEntry) { .tag = tag, .pbase = ppage & ~(paddr_t)SUPERPAGE_MASK };
+  }
+  return ppage;
+}
+
+static TLBEntry* tlb_fetch(vaddr_t addr, int len, int type) {
+  TLBEntry *e = &tlb[type][(addr >> PAGE_SHIFT) % TLB_SIZE];
+  if (likely(e->tag == (addr & ~PAGE_MASK))) {
+    tlb_hit[type] ++;
+    return e;
+  }
+  tlb_miss[type] ++;
+  paddr_t ppage = tlb_super_fetch(addr, len, type);
+  bool is_io;
+  uint8_t *host = paddr_host_page(ppage, &is_io);
+  if (host == NULL) return NULL;
+  *e = (TLBEntry) { .tag = addr & ~PAGE_MASK, .ppage = ppage, .host = host, .is_io = is_io };
+  return e;
+}
+
+static word_t vaddr_read_translate(vaddr_t addr, int len, int type) {
+  if (unlikely(cross_page(addr, len))) return vaddr_read_cross(addr, len, type);
+  TLBEntry *e = tlb_fetch(addr, len, type);
+  if (likely(e != NULL)) {
+    word_t ret = host_read(e->host + (addr & PAGE_MASK), len);
+    if (unlikely(e->is_io)) difftest_skip_ref();
+    if (type != MEM_TYPE_IFETCH) MTRACE(e->ppage | (addr & PAGE_MASK), len, ret, false);
+    return ret;
+  }
+  return paddr_read_type(vaddr_translate(addr, len, type), len, type);
+}
+
+static void vaddr_write_translate(vaddr_t addr, int len, word_t data) {
+  if (unlikely(cross_page(addr, len))) { vaddr_write_cross(addr, len, data); return; }
+  TLBEntry *e = tlb_fetch(addr, len, MEM_TYPE_WRITE);
+  if (unlikely(e == NULL)) { paddr_write(vaddr_translate(addr, len, MEM_TYPE_WRITE), len, data); return; }
+  if (unlikely(e->is_io)) {
+    difftest_skip_ref();
+    host_write(e->host + (addr & PAGE_MASK), len, data);
+    MTRACE(e->ppage | (addr & PAGE_MASK), len, data, true);
+    return;
+  }
+#ifdef CONFIG_MEM_CODE_PAGE
+  // writing to code pages should drop the cached instructions
+  if (unlikely(pmem_code_page[(e->ppage - CONFIG_MBASE) >> PAGE_SHIFT])) {
+    paddr_write(e->ppage | (addr & PAGE_MASK), len, data);
+    return;
+  }
+#endif
+  host_write(e->host + (addr & PAGE_MASK), len, data);
+  MTRACE(e->ppage | (addr & PAGE_MASK), len, data, true);
+  IFDEF(CONFIG_PMEM_DIRTY, paddr_mark_dirty(e->ppage));
+  IFDEF(CONFIG_WATCHPOINT, paddr_check_watch(e->ppage | (addr & PAGE_MASK), len));
+}
+#else
+void vaddr_tlb_flush() { }
+void vaddr_tlb_flush_range(vaddr_t addr, word_t size) { }
+void vaddr_tlb_display() { printf("soft TLB is not enabled\n"); }
+
+static word_t vaddr_read_translate(vaddr_t addr, int len, int type) {
+  if (unlikely(cross_page(addr, len))) return vaddr_read_cross(addr, len, type);
+  return paddr_read_type(vaddr_translate(addr, len, type), len, type);
+}
+
+static void vaddr_write_translate(vaddr_t addr, int len, word_t data) {
+  if (unlikely(cross_page(addr, len))) { vaddr_write_cross(addr, len, data); return; }
+  paddr_write(vaddr_translate(addr, len, MEM_TYPE_WRITE), len, data);
+}
+#endif
 
 word_t vaddr_ifetch(vaddr_t addr, int len) {
-  return paddr_read(addr, len);
+  if (likely(isa_mmu_check(addr, len, MEM_TYPE_IFETCH) == MMU_DIRECT)) return paddr_ifetch(addr, len);
+  return vaddr_read_translate(addr, len, MEM_TYPE_IFETCH);
 }
 
 word_t vaddr_read(vaddr_t addr, int len) {
-  return paddr_read(addr, len);
+  TIMING_MEM(addr, false);
+  if (likely(isa_mmu_check(addr, len, MEM_TYPE_READ) == MMU_DIRECT)) return paddr_read(addr, len);
+  return vaddr_read_translate(addr, len, MEM_TYPE_READ);
 }
 
 void vaddr_write(vaddr_t addr, int len, word_t data) {
-  paddr_write(addr, len, data);
+  TIMING_MEM(addr, true);
+  if (likely(isa_mmu_check(addr, len, MEM_TYPE_WRITE) == MMU_DIRECT)) { paddr_write(addr, len, data); return; }
+  vaddr_write_translate(addr, len, data);
 }
+
+#define VADDR_ACCESS(bytes, bits) \
+  word_t vaddr_read_##bytes(vaddr_t addr) { \
+    TIMING_MEM(addr, false); \
+    if (likely(isa_mmu_check(addr, bytes, MEM_TYPE_READ) == MMU_DIRECT)) return paddr_read_##bytes(addr); \
+    return vaddr_read_translate(addr, bytes, MEM_TYPE_READ); \
+  } \
+  void vaddr_write_##bytes(vaddr_t addr, word_t data) { \
+    TIMING_MEM(addr, true); \
+    if (likely(isa_mmu_check(addr, bytes, MEM_TYPE_WRITE) == MMU_DIRECT)) { paddr_write_##bytes(addr, data); return; } \
+    vaddr_write_translate(addr, bytes, data); \
+  }
+
+MAP(MEM_ACCESS_WIDTH, VADDR_ACCESS)
@@ -0,0 +1,255 @@
+/***************************************************************************************
+* Copyright (c) 2014-2024 Zihao Yu, Nanjing University
+*
+* NEMU is licensed under Mulan PSL v2.
+* You can use this software according to the terms and conditions of the Mulan PSL v2.
+* You may obtain a copy of Mulan PSL v2 at:
+*          http://license.coscl.org.cn/MulanPSL2
+*
+* THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+* EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+* MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+*
+* See the Mulan PSL v2 for more details.
+***************************************************************************************/
+
+
+#include <isa.h>
+#include <memory/paddr.h>
+
+// symbols are kept sorted by start address so that a PC can be
+// symbolized by binary search
+typedef struct {
+  vaddr_t start;
+  word_t size;
+  const char *name;
+} Symbol;
+
+static Symbol *symtab = NULL;
+static int nr_symtab = 0;
+
+const char *symbol_lookup(vaddr_t pc, word_t *offset) {
+  int l = 0, r = nr_symtab - 1;
+  // find the last symbol starting at or below pc
+  while (l <= r) {
+    int mid = (l + r) / 2;
+    if (symtab[mid].start <= pc) l = mid + 1;
+    else r = mid - 1;
+  }
+  if (r < 0) return NULL;
+  Symbol *s = &symtab[r];
+  if (pc - s->start >= s->size && pc != s->start) return NULL;
+  if (offset != NULL) *offset = pc - s->start;
+  return s->name;
+}
+
+int symbol_at(vaddr_t addr) {
+  int l = 0, r = nr_symtab - 1;
+  while (l <= r) {
+    int mid = (l + r) / 2;
+    if (symtab[mid].start == addr) return mid;
+    if (symtab[mid].start < addr) l = mid + 1;
+    else r = mid - 1;
+  }
+  return -1;
+}
+
+int symbol_count() {
+  return nr_symtab;
+}
+
+const char *symbol_get(int idx, vaddr_t *start, word_t *size) {
+  *start = symtab[idx].start;
+  *size = symtab[idx].size;
+  return symtab[idx].name;
+}
+
+bool symbol_find(const char *name, vaddr_t *start, word_t *size) {
+  int i;
+  for (i = 0; i < nr_symtab; i ++) {
+    if (strcmp(symtab[i].name, name) == 0) {
+      *start = symtab[i].start;
+      *size = symtab[i].size;
+      return true;
+    }
+  }
+  return false;
+}
+
+#ifndef CONFIG_TARGET_AM
+#include <elf.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#ifdef CONFIG_ISA64
+typedef Elf64_Ehdr Ehdr;
+typedef Elf64_Phdr Phdr;
+typedef Elf64_Shdr Shdr;
+typedef Elf64_Sym  Sym;
+#define ELF_CLASS ELFCLASS64
+#define ELF_ST_TYPE ELF64_ST_TYPE
+#else
+typedef Elf32_Ehdr Ehdr;
+typedef Elf32_Phdr Phdr;
+typedef Elf32_Shdr Shdr;
+typedef Elf32_Sym  Sym;
+#define ELF_CLASS ELFCLASS32
+#define ELF_ST_TYPE ELF32_ST_TYPE
+#endif
+
+#ifdef CONFIG_MODE_USER
+static vaddr_t user_phdr = 0;
+static word_t user_phnum = 0;
+static paddr_t user_end = 0;
+static vaddr_t phdr_addr(const Ehdr *eh, const Phdr *ph);
+#endif
+
+static int symbol_cmp(const void *a, const void *b) {
+  vaddr_t x = ((const Symbol *)a)->start, y = ((const Symbol *)b)->start;
+  return (x > y) - (x < y);
+}
+
+static void load_symbols(const uint8_t *buf, size_t size, const Ehdr *eh) {
+  if (eh->e_shoff == 0 || eh->e_shoff + (size_t)eh->e_shnum * sizeof(Shdr) > size) return;
+  const Shdr *sh = (const Shdr *)(buf + eh->e_shoff);
+  for (int i = 0; i < eh->e_shnum; i ++) {
+    if (sh[i].sh_type != SHT_SYMTAB || sh[i].sh_link >= eh->e_shnum) continue;
+    const Shdr *str = &sh[sh[i].sh_link];
+    if (sh[i].sh_offset + sh[i].sh_size > size || str->sh_offset + str->sh_size > size) continue;
+
+    // keep a private copy of the string table since the file is unmapped later
+    char *strtab = malloc(str->sh_size + 1);
+    assert(strtab);
+    memcpy(strtab, buf + str->sh_offset, str->sh_size);
+    strtab[str->sh_size] = '\0';
+
+    const Sym *sym = (const Sym *)(buf + sh[i].sh_offset);
+    int n = sh[i].sh_size / sizeof(Sym);
+    symtab = realloc(symtab, sizeof(Symbol) * (nr_symtab + n));
+    assert(symtab);
+    for (int j = 0; j < n; j ++) {
+      if (ELF_ST_TYPE(sym[j].st_info) != STT_FUNC || sym[j].st_name >= str->sh_size) continue;
+      symtab[nr_symtab ++] = (Symbol) {
+        .start = sym[j].st_value, .size = sym[j].st_size, .name = strtab + sym[j].st_name
+      };
+    }
+  }
+  qsort(symtab, nr_symtab, sizeof(Symbol), symbol_cmp);
+}
+
+// Load the PT_LOAD segments of an ELF file and return its entry.
+// The size of the memory covered from RESET_VECTOR is stored in `img_size`.
+vaddr_t load_elf(const char *file, long *img_size) {
+  int fd = open(file, O_RDONLY);
+  Assert(fd >= 0, "Can not open '%s'", file);
+  struct stat st;
+  int ret = fstat(fd, &st);
+  assert(ret == 0);
+  size_t size = st.st_size;
+  Assert(size >= sizeof(Ehdr), "'%s' is too small to be an ELF file", file);
+  const uint8_t *buf = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  Assert(buf != MAP_FAILED, "Can not map '%s'", file);
+  close(fd);
+
+  const Ehdr *eh = (const Ehdr *)buf;
+  Assert(memcmp(eh->e_ident, ELFMAG, SELFMAG) == 0, "'%s' is not an ELF file", file);
+  Assert(eh->e_ident[EI_CLASS] == ELF_CLASS, "'%s' does not match the word size of the guest", file);
+  Assert(eh->e_phoff + (size_t)eh->e_phnum * sizeof(Phdr) <= size, "Bad program headers in '%s'", file);
+
+  paddr_t end = RESET_VECTOR;
+  const Phdr *ph = (const Phdr *)(buf + eh->e_phoff);
+  for (int i = 0; i < eh->e_phnum; i ++) {
+    if (ph[i].p_type != PT_LOAD || ph[i].p_memsz == 0) continue;
+    paddr_t addr = ph[i].p_paddr;
+    Assert(ph[i].p_filesz <= ph[i].p_memsz && ph[i].p_offset + ph[i].p_filesz <= size,
+        "Bad segment %d in '%s'", i, file);
+    Assert(in_pmem(addr) && in_pmem(addr + ph[i].p_memsz - 1),
+        "Segment %d [" FMT_PADDR ", " FMT_PADDR ") is out of pmem", i, addr, (paddr_t)(addr + ph[i].p_memsz));
+    uint8_t *host = guest_to_host(addr);
+    memcpy(host, buf + ph[i].p_offset, ph[i].p_filesz);
+    memset(host + ph[i].p_filesz, 0, ph[i].p_memsz - ph[i].p_filesz);
+    if (addr + ph[i].p_memsz > end) end = addr + ph[i].p_memsz;
+  }
+
+  load_symbols(buf, size, eh);
+  IFDEF(CONFIG_MODE_USER, user_phdr = phdr_addr(eh, ph); user_phnum = eh->e_phnum; user_end = end);
+  vaddr_t entry = eh->e_entry;
+  munmap((void *)buf, size);
+
+  Log("The ELF is %s, entry = " FMT_WORD ", %d function symbols", file, entry, nr_symtab);
+  *img_size = end - RESET_VECTOR;
+  return entry;
+}
+
+#ifdef CONFIG_MODE_USER
+#include <sys/random.h>
+
+#define USER_STACK_SIZE (8 << 20)
+#define PAGE_ALIGN(x) (((x) + 4095) & ~(paddr_t)4095)
+
+void user_init_mem(paddr_t brk, paddr_t mmap_top);
+
+// the program headers are in the segment holding their offset in the file
+static vaddr_t phdr_addr(const Ehdr *eh, const Phdr *ph) {
+  for (int i = 0; i < eh->e_phnum; i ++) {
+    if (ph[i].p_type == PT_PHDR) return ph[i].p_vaddr;
+  }
+  for (int i = 0; i < eh->e_phnum; i ++) {
+    if (ph[i].p_type == PT_LOAD && eh->e_phoff >= ph[i].p_offset &&
+        eh->e_phoff < ph[i].p_offset + ph[i].p_filesz) {
+      return ph[i].p_vaddr + eh->e_phoff - ph[i].p_offset;
+    }
+  }
+  return 0;
+}
+
+static paddr_t sp;
+
+static paddr_t push(const void *data, size_t len, size_t align) {
+  sp = (sp - len) & ~(paddr_t)(align - 1);
+  memcpy(guest_to_host(sp), data, len);
+  return sp;
+}
+
+/* Load the static ELF `argv[0]` for the user mode, and set up the stack at
+ * the top of pmem as Linux does: argc, argv, an empty envp and auxv, with
+ * the strings above them. The heap starts after the segments, and the
+ * mappings grow down from below the stack. */
+long load_user(int argc, char *argv[]) {
+  long size;
+  cpu.pc = load_elf(argv[0], &size);
+  Assert(user_phdr != 0, "The program headers of '%s' are not loaded", argv[0]);
+
+  sp = PMEM_RIGHT + 1;
+  word_t *str = malloc(sizeof(word_t) * argc);
+  assert(str != NULL);
+  for (int i = argc - 1; i >= 0; i --) str[i] = push(argv[i], strlen(argv[i]) + 1, 1);
+  uint8_t rand[16];
+  if (getrandom(rand, sizeof(rand), 0) != sizeof(rand)) memset(rand, 0x5a, sizeof(rand));
+  word_t at_random = push(rand, sizeof(rand), 16);
+
+  word_t auxv[][2] = {
+    { AT_PHDR, user_phdr }, { AT_PHENT, sizeof(Phdr) }, { AT_PHNUM, user_phnum },
+    { AT_PAGESZ, 4096 }, { AT_ENTRY, cpu.pc }, { AT_RANDOM, at_random },
+    { AT_UID, 0 }, { AT_EUID, 0 }, { AT_GID, 0 }, { AT_EGID, 0 },
+    { AT_CLKTCK, 100 }, { AT_SECURE, 0 }, { AT_NULL, 0 },
+  };
+  // argc, argv, envp and auxv from a 16-byte aligned sp upwards
+  int n = 1 + (argc + 1) + 1 + 2 * ARRLEN(auxv);
+  sp = (sp - sizeof(word_t) * n) & ~(paddr_t)15;
+  word_t *p = (word_t *)guest_to_host(sp);
+  *p ++ = argc;
+  for (int i = 0; i < argc; i ++) *p ++ = str[i];
+  *p ++ = 0; // end of argv
+  *p ++ = 0; // end of envp
+  memcpy(p, auxv, sizeof(auxv));
+  free(str);
+
+  cpu.gpr[2] = sp; // sp of riscv
+  user_init_mem(PAGE_ALIGN(user_end), (PMEM_RIGHT + 1 - USER_STACK_SIZE) & ~(paddr_t)4095);
+  return size;
+}
+#endif
+#endif
@@ -0,0 +1,531 @@
+/***************************************************************************************
+* Copyright (c) 2014-2024 Zihao Yu, Nanjing University
+*
+* NEMU is licensed under Mulan PSL v2.
+* You can use this software according to the terms and conditions of the Mulan PSL v2.
+* You may obtain a copy of Mulan PSL v2 at:
+*          http://license.coscl.org.cn/MulanPSL2
+*
+* THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+* EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+* MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+*
+* See the Mulan PSL v2 for more details.
+***************************************************************************************/
+
+
+#define _GNU_SOURCE
+#include <isa.h>
+#include <cpu/cpu.h>
+#include <memory/paddr.h>
+#include <memory/vaddr.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdarg.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+/* Run the images listed in a file, one per line, each in a child forked
+ * after the initialization, so that the monitor, the devices and the
+ * disassembler are set up once and shared by copy-on-write. At most `jobs`
+ * children run at a time, and each of them writes a line of JSON with its
+ * result to stdout. The output of the guest and the log of a child go to a
+ * file in a temporary directory, which is kept if the image fails. */
+
+static char *farm_list = NULL;
+static int farm_jobs = 0;
+IFDEF(CONFIG_RUN_LIST, static char *run_list = NULL);
+
+void farm_set_list(const char *file) {
+  farm_list = strdup(file);
+}
+
+#ifdef CONFIG_RUN_LIST
+void farm_set_run_list(const char *file) {
+  run_list = strdup(file);
+}
+#endif
+
+void farm_set_jobs(int jobs) {
+  farm_jobs = jobs;
+}
+
+static int nr_thread() {
+  FILE *fp = fopen("/proc/self/status", "r");
+  if (fp == NULL) return 1;
+  char line[128];
+  int n = 1;
+  while (fgets(line, sizeof(line), fp)) {
+    if (sscanf(line, "Threads: %d", &n) == 1) break;
+  }
+  fclose(fp);
+  return n;
+}
+
+// write a line of result into `fd` at once, so that the lines of the children are not mixed
+static void write_result(int fd, const char *img, const char *fmt, ...) {
+  char buf[PATH_MAX + 512];
+  int n = snprintf(buf, sizeof(buf), "{\"image\":\"");
+  const char *p;
+  for (p = img; *p != '\0' && n < PATH_MAX; p ++) {
+    if (*p == '"' || *p == '\\') buf[n ++] = '\\';
+    buf[n ++] = *p;
+  }
+  buf[n ++] = '"';
+  va_list ap;
+  va_start(ap, fmt);
+  n += vsnprintf(buf + n, sizeof(buf) - n, fmt, ap);
+  va_end(ap);
+  if (n > sizeof(buf) - 2) n = sizeof(buf) - 2;
+  buf[n ++] = '}';
+  buf[n ++] = '\n';
+  ssize_t ret = write(fd, buf, n);
+  assert(ret == n);
+}
+
+long farm_load_img(const char *file);
+
+// send the output of the guest to `file`, or drop it if `file` is NULL, and
+// return the fd of the original stdout for the results
+static int drop_output(const char *file) {
+  int result_fd = dup(STDOUT_FILENO);
+  int null_fd = (file == NULL ? open("/dev/null", O_WRONLY) : open(file, O_WRONLY | O_CREAT | O_TRUNC, 0644));
+  assert(result_fd >= 0 && null_fd >= 0);
+  // the serial port writes to stderr
+  dup2(null_fd, STDOUT_FILENO);
+  dup2(null_fd, STDERR_FILENO);
+  close(null_fd);
+  return result_fd;
+}
+
+// the directory of the logs of the children
+static char log_dir[] = "/tmp/nemu-farm-XXXXXX";
+
+static void log_file(char *buf, int size, pid_t pid) {
+  snprintf(buf, size, "%s/%d.log", log_dir, (int)pid);
+}
+
+static void write_state(int result_fd, const char *img) {
+  void statistic_json(FILE *fp);
+  static const char *state_name[] = {
+    [NEMU_RUNNING] = "running", [NEMU_STOP] = "stop", [NEMU_END] = "end",
+    [NEMU_ABORT] = "abort", [NEMU_QUIT] = "quit",
+  };
+
+  char *stat = NULL;
+  size_t size = 0;
+  FILE *fp = open_memstream(&stat, &size);
+  assert(fp != NULL);
+  statistic_json(fp);
+  fclose(fp);
+  write_result(result_fd, img, ",\"state\":\"%s\",\"halt_ret\":%u,\"pc\":%" PRIu64 ",\"statistic\":%s",
+      state_name[nemu_state.state], nemu_state.halt_ret, (uint64_t)nemu_state.halt_pc, stat);
+  free(stat);
+}
+
+#ifdef CONFIG_FARM_NUMA
+#include <sched.h>
+#include <sys/syscall.h>
+#include <linux/mempolicy.h>
+
+/* The topology is read from sysfs before forking, and each slot of a
+ * running child is given a core, taking the nodes in turn and the cores
+ * allowed to NEMU in each of them. A child is pinned to the core of its
+ * slot and prefers the node of it for new pages. Its pmem, decode cache and
+ * traces are first touched by itself, so they come from that node, while
+ * the pages shared with the parent are copied there when written. */
+#define MAX_NODE 64
+
+static int *slot_cpu = NULL, *slot_node = NULL;
+
+// parse the list of cpus like "0-3,8-11" of `node` into `set`
+static bool node_cpus(int node, cpu_set_t *set) {
+  char path[64], buf[1024];
+  snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", node);
+  FILE *fp = fopen(path, "r");
+  if (fp == NULL) return false;
+  bool ok = (fgets(buf, sizeof(buf), fp) != NULL);
+  fclose(fp);
+  CPU_ZERO(set);
+  char *p = buf;
+  while (ok && *p >= '0' && *p <= '9') {
+    int lo = strtol(p, &p, 10), hi = lo;
+    if (*p == '-') hi = strtol(p + 1, &p, 10);
+    for (; lo <= hi && lo < CPU_SETSIZE; lo ++) CPU_SET(lo, set);
+    if (*p == ',') p ++;
+  }
+  return ok;
+}
+
+static void init_numa(int nr_job) {
+  cpu_set_t allowed, set[MAX_NODE];
+  int node_id[MAX_NODE], nr_node = 0, node;
+  if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) return;
+  for (node = 0; node < MAX_NODE; node ++) {
+    if (!node_cpus(node, &set[nr_node])) continue;
+    CPU_AND(&set[nr_node], &set[nr_node], &allowed);
+    if (CPU_COUNT(&set[nr_node]) > 0) node_id[nr_node ++] = node;
+  }
+  if (nr_node < 2) return;
+
+  slot_cpu = malloc(sizeof(int) * nr_job);
+  slot_node = malloc(sizeof(int) * nr_job);
+  assert(slot_cpu != NULL && slot_node != NULL);
+  int i;
+  for (i = 0; i < nr_job; i ++) {
+    cpu_set_t *s = &set[i % nr_node];
+    int k = (i / nr_node) % CPU_COUNT(s), cpu;
+    for (cpu = 0; !CPU_ISSET(cpu, s) || k -- > 0; cpu ++);
+    slot_cpu[i] = cpu;
+    slot_node[i] = node_id[i % nr_node];
+  }
+  Log("farm: the children are placed on %d NUMA nodes in turn", nr_node);
+}
+
+static void pin_child(int slot) {
+  if (slot_cpu == NULL) return;
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(slot_cpu[slot], &set);
+  sched_setaffinity(0, sizeof(set), &set);
+  unsigned long mask = 1ul << slot_node[slot];
+  syscall(SYS_set_mempolicy, MPOL_PREFERRED, &mask, MAX_NODE + 1);
+}
+#endif
+
+static void run_child(const char *img) {
+  char log[PATH_MAX];
+  log_file(log, sizeof(log), getpid());
+  int result_fd = drop_output(log);
+  void init_host_timer();
+  init_host_timer();
+  farm_load_img(img);
+  cpu_exec(-1);
+  write_state(result_fd, img);
+}
+
+typedef struct {
+  pid_t pid;
+  char *img;
+} Job;
+
+// wait for a child to exit, and return true if it passes
+static bool reap(Job *job, int nr_job, int *nr_running) {
+  int status;
+  pid_t pid = wait(&status);
+  assert(pid > 0);
+  int i;
+  for (i = 0; i < nr_job && job[i].pid != pid; i ++);
+  assert(i < nr_job);
+  if (WIFSIGNALED(status)) {
+    write_result(STDOUT_FILENO, job[i].img, ",\"state\":\"crash\",\"signal\":%d", WTERMSIG(status));
+  }
+  bool pass = WIFEXITED(status) && WEXITSTATUS(status) == 0;
+  char log[PATH_MAX];
+  log_file(log, sizeof(log), pid);
+  if (pass) unlink(log);
+  else Log_warn("farm: '%s' failed, see %s", job[i].img, log);
+  free(job[i].img);
+  job[i].pid = 0;
+  (*nr_running) --;
+  return pass;
+}
+
+int is_exit_status_bad();
+
+// read the next image in the list into `line`, skipping blank lines and comments
+static bool next_img(FILE *fp, char *line, int size) {
+  while (fgets(line, size, fp) != NULL) {
+    line[strcspn(line, "\r\n")] = '\0';
+    if (line[0] != '\0' && line[0] != '#') return true;
+  }
+  return false;
+}
+
+#ifdef CONFIG_RUN_LIST
+/* Run the images one after another in this process instead. The state after
+ * the initialization is kept as the baseline: the registers, the memory and
+ * the hooks of the devices, and the pages of pmem not filled with a single
+ * byte. Before each image, the pages of pmem written since the baseline, as
+ * found by the dirty bits, are restored from it, so that the cost of
+ * resetting follows the memory touched by the last image. If pmem can be
+ * frozen into a memory file mapped copy-on-write, the pages are kept by the
+ * file instead of being copied, and restoring a run of them drops their
+ * private copies with a single madvise(). Unlike the forked children, an
+ * image crashing NEMU ends the whole list. */
+#define NR_PAGE (CONFIG_MSIZE / PAGE_SIZE)
+
+static struct {
+  CPU_state cpu;
+  void *dev;
+  size_t dev_size;
+  bool frozen;
+  uint8_t fill[NR_PAGE]; // the byte filling the page if it is not kept
+  uint8_t *page[NR_PAGE];
+} base;
+
+void* snapshot_save_devices(size_t *size);
+void snapshot_load_devices(void *buf, size_t size);
+void cpu_reset_statistic();
+
+static void save_baseline(bool freeze) {
+  base.cpu = cpu;
+  base.dev = snapshot_save_devices(&base.dev_size);
+  base.frozen = freeze && MUXDEF(CONFIG_PMEM_MMAP, paddr_pmem_freeze(), false);
+  int i;
+  for (i = 0; i < NR_PAGE && !base.frozen; i ++) {
+    paddr_t page = CONFIG_MBASE + (paddr_t)i * PAGE_SIZE;
+    if (paddr_page_blank(page, &base.fill[i])) continue;
+    base.page[i] = malloc(PAGE_SIZE);
+    assert(base.page[i] != NULL);
+    memcpy(base.page[i], guest_to_host(page), PAGE_SIZE);
+  }
+  paddr_clear_dirty(CONFIG_MBASE, CONFIG_MSIZE);
+}
+
+// restore the run of `size` bytes of pmem at `page` from the baseline
+static void restore_run(paddr_t page, size_t size) {
+#ifdef CONFIG_PMEM_MMAP
+  if (base.frozen) { paddr_pmem_restore(page, size); return; }
+#endif
+  paddr_t p;
+  for (p = page; p - page < size; p += PAGE_SIZE) {
+    int i = (p - CONFIG_MBASE) / PAGE_SIZE;
+    if (base.page[i] != NULL) memcpy(guest_to_host(p), base.page[i], PAGE_SIZE);
+    else memset(guest_to_host(p), base.fill[i], PAGE_SIZE);
+  }
+}
+
+static void restore_baseline() {
+  paddr_t page = CONFIG_MBASE;
+  while (paddr_next_dirty(&page)) {
+    paddr_t end = page + PAGE_SIZE;
+    while (in_pmem(end) && paddr_is_dirty(end)) end += PAGE_SIZE;
+    restore_run(page, end - page);
+    // drop the instructions cached from the last image
+    paddr_host_written(page, end - page);
+    page = end;
+  }
+  paddr_clear_dirty(CONFIG_MBASE, CONFIG_MSIZE);
+  cpu = base.cpu;
+  snapshot_load_devices(base.dev, base.dev_size);
+  vaddr_tlb_flush();
+  cpu_reset_statistic();
+  nemu_state = (NEMUState) { .state = NEMU_STOP };
+}
+
+static void run_list_seq(FILE *fp, int result_fd, int *nr_img, int *nr_fail) {
+  char line[PATH_MAX];
+  while (next_img(fp, line, sizeof(line))) {
+    if (*nr_img > 0) restore_baseline();
+    long size = farm_load_img(line);
+    // the image is loaded around the dirty bits, and restored with the others next time
+    paddr_host_written(RESET_VECTOR, size);
+    cpu_exec(-1);
+    write_state(result_fd, line);
+    *nr_fail += is_exit_status_bad();
+    (*nr_img) ++;
+  }
+}
+
+#ifdef CONFIG_RUN_LIST_TURNS
+/* With --jobs=N, N images are run in turns instead, each for
+ * CONFIG_RUN_LIST_QUANTUM instructions before switching to the next, like
+ * the instances of the lockstep mode. cpu_exec() stops at the end of a
+ * block when the quantum is used up, and goes on from there in the next
+ * turn. Each image keeps its registers, its counters and a snapshot of the
+ * devices, and its pmem is a memory file started from the baseline and
+ * mapped to the address of pmem in its turns. The images run different
+ * code at the same addresses, so the instructions cached are dropped on
+ * each switch. */
+typedef struct {
+  char *img;
+  int fd;
+  CPU_state cpu;
+  NEMUState state;
+  uint64_t stat[3];
+  void *dev;
+  size_t dev_size;
+} Turn;
+
+static Turn *turn = NULL;
+static int nr_turn = 0, cur = -1;
+
+void cpu_swap_statistic(uint64_t stat[3]);
+
+// a memory file holding the pmem of the baseline
+static int baseline_pmem() {
+  static uint8_t filled[PAGE_SIZE];
+  int fd = memfd_create("pmem", 0);
+  Assert(fd >= 0 && ftruncate(fd, CONFIG_MSIZE) == 0, "Can not create a memory file for pmem");
+  int i;
+  for (i = 0; i < NR_PAGE; i ++) {
+    const uint8_t *p = base.page[i];
+    if (p == NULL) {
+      // blank pages filled with zero are holes
+      if (base.fill[i] == 0) continue;
+      memset(filled, base.fill[i], PAGE_SIZE);
+      p = filled;
+    }
+    ssize_t n = pwrite(fd, p, PAGE_SIZE, (off_t)i * PAGE_SIZE);
+    assert(n == PAGE_SIZE);
+  }
+  return fd;
+}
+
+static void flush_code() {
+  paddr_t page;
+  for (page = PMEM_LEFT; page - PMEM_LEFT < CONFIG_MSIZE; page += PAGE_SIZE) {
+    IFDEF(CONFIG_MEM_CODE_PAGE, if (!pmem_code_page[(page - PMEM_LEFT) >> PAGE_SHIFT]) continue);
+    IFDEF(CONFIG_DECODE_CACHE, isa_flush_decode_cache(page));
+    IFDEF(CONFIG_MEM_CODE_PAGE, pmem_code_page[(page - PMEM_LEFT) >> PAGE_SHIFT] = false);
+  }
+  IFDEF(CONFIG_ENGINE_BLOCK, void block_flush(); block_flush());
+}
+
+static void switch_to(int i) {
+  if (i == cur) return;
+  if (cur >= 0) {
+    Turn *t = &turn[cur];
+    t->cpu = cpu;
+    t->state = nemu_state;
+    cpu_swap_statistic(t->stat);
+    free(t->dev);
+    t->dev = snapshot_save_devices(&t->dev_size);
+  }
+  cur = i;
+  Turn *t = &turn[cur];
+  paddr_pmem_switch(t->fd);
+  cpu = t->cpu;
+  nemu_state = t->state;
+  cpu_swap_statistic(t->stat);
+  snapshot_load_devices(t->dev, t->dev_size);
+  vaddr_tlb_flush();
+  flush_code();
+}
+
+// start `img` from the baseline in the free slot `i`
+static void start(int i, const char *img) {
+  Turn *t = &turn[i];
+  *t = (Turn) { .img = strdup(img), .fd = baseline_pmem(), .cpu = base.cpu,
+    .state = { .state = NEMU_STOP }, .dev_size = base.dev_size };
+  t->dev = malloc(base.dev_size);
+  assert(t->dev != NULL);
+  memcpy(t->dev, base.dev, base.dev_size);
+  switch_to(i);
+  // pmem is shared with the file, so the image is copied rather than mapped
+  farm_load_img(img);
+}
+
+static void run_list_turns(FILE *fp, int result_fd, int *nr_img, int *nr_fail) {
+  nr_turn = farm_jobs;
+  turn = calloc(nr_turn, sizeof(Turn));
+  assert(turn != NULL);
+  int nr_running = 0, i;
+  bool more = true;
+  char line[PATH_MAX];
+  while (more || nr_running > 0) {
+    for (i = 0; i < nr_turn; i ++) {
+      Turn *t = &turn[i];
+      if (t->img == NULL) {
+        if (!more || !(more = next_img(fp, line, sizeof(line)))) continue;
+        start(i, line);
+        nr_running ++;
+      }
+      switch_to(i);
+      cpu_exec(CONFIG_RUN_LIST_QUANTUM);
+      if (nemu_state.state == NEMU_STOP) continue;
+      write_state(result_fd, t->img);
+      *nr_fail += is_exit_status_bad();
+      (*nr_img) ++;
+      // the memory file is dropped once it is no longer mapped
+      close(t->fd);
+      free(t->img);
+      free(t->dev);
+      t->img = NULL;
+      cur = -1;
+      nr_running --;
+    }
+  }
+  free(turn);
+}
+#endif
+
+static void run_list_all() {
+  FILE *fp = fopen(run_list, "r");
+  Assert(fp != NULL, "Can not open '%s'", run_list);
+  void (*run)(FILE *, int, int *, int *) = run_list_seq;
+  IFDEF(CONFIG_RUN_LIST_TURNS, if (farm_jobs > 1) run = run_list_turns);
+  // the images in turns start from copies of the baseline
+  save_baseline(run == run_list_seq);
+  fflush(NULL);
+  int out_fd = dup(STDOUT_FILENO), err_fd = dup(STDERR_FILENO);
+  int result_fd = drop_output(NULL);
+  int nr_img = 0, nr_fail = 0;
+  run(fp, result_fd, &nr_img, &nr_fail);
+  fclose(fp);
+  fflush(NULL);
+  dup2(out_fd, STDOUT_FILENO);
+  dup2(err_fd, STDERR_FILENO);
+  close(out_fd);
+  close(err_fd);
+  close(result_fd);
+
+  Log("run list: %d images, %d failed", nr_img, nr_fail);
+  nemu_state.state = NEMU_END;
+  nemu_state.halt_ret = (nr_fail != 0);
+}
+#endif
+
+// return false if not in the farm mode
+bool farm_run() {
+#ifdef CONFIG_RUN_LIST
+  if (run_list != NULL) { run_list_all(); return true; }
+#endif
+  if (farm_list == NULL) return false;
+
+  FILE *fp = fopen(farm_list, "r");
+  Assert(fp != NULL, "Can not open '%s'", farm_list);
+  // the children get a copy of the calling thread only
+  Assert(nr_thread() == 1, "Can not run the farm with threads started");
+  Assert(mkdtemp(log_dir) != NULL, "Can not create a directory for the logs");
+
+  int nr_job = (farm_jobs > 0 ? farm_jobs : sysconf(_SC_NPROCESSORS_ONLN));
+  Job *job = calloc(nr_job, sizeof(Job));
+  assert(job != NULL);
+  IFDEF(CONFIG_FARM_NUMA, init_numa(nr_job));
+  int nr_running = 0, nr_img = 0, nr_fail = 0;
+  char line[PATH_MAX];
+
+  while (next_img(fp, line, sizeof(line))) {
+    if (nr_running == nr_job) nr_fail += !reap(job, nr_job, &nr_running);
+
+    int i;
+    for (i = 0; job[i].pid != 0; i ++);
+    fflush(NULL);
+    pid_t pid = fork();
+    Assert(pid >= 0, "Can not fork");
+    if (pid == 0) {
+      fclose(fp);
+      IFDEF(CONFIG_FARM_NUMA, pin_child(i));
+      run_child(line);
+      fflush(NULL);
+      _exit(is_exit_status_bad());
+    }
+    job[i].pid = pid;
+    job[i].img = strdup(line);
+    nr_running ++;
+    nr_img ++;
+  }
+  fclose(fp);
+  while (nr_running > 0) nr_fail += !reap(job, nr_job, &nr_running);
+  free(job);
+  // kept with the logs of the failed images
+  rmdir(log_dir);
+
+  Log("farm: %d images, %d failed", nr_img, nr_fail);
+  nemu_state.state = NEMU_END;
+  nemu_state.halt_ret = (nr_fail != 0);
+  return true;
+}
@@ -15,14 +15,23 @@
 
 #include <isa.h>
 #include <memory/paddr.h>
+#include <memory/mtrace.h>
+#include <cpu/itrace.h>
+#include <cpu/ftrace.h>
+#include <cpu/plugin.h>
+#include <cpu/lockstep.h>
 
 void init_rand();
 void init_log(const char *log_file);
 void init_mem();
 void init_difftest(char *ref_so_file, long img_size, int port);
+void difftest_set_log(char *file, bool replay);
 void init_device();
 void init_sdb();
-void init_disasm();
+void init_trace_switch();
+void init_host_timer();
+vaddr_t load_elf(const char *file, long *img_size);
+long load_user(int argc, char *argv[]);
 
 static void welcome() {
   Log("Trace: %s", MUXDEF(CONFIG_TRACE, ANSI_FMT("ON", ANSI_FG_GREEN), ANSI_FMT("OFF", ANSI_FG_RED)));
@@ -36,59 +45,255 @@ static void welcome() {
 
 #ifndef CONFIG_TARGET_AM
 #include <getopt.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
 
 void sdb_set_batch_mode();
+void sdb_set_script(const char *file);
+void sdb_set_gdb(int port);
+void stats_set_json(const char *file);
+void farm_set_list(const char *file);
+void farm_set_jobs(int jobs);
+void farm_set_run_list(const char *file);
+void vga_set_record(const char *file);
+void stats_phase(const char *name);
+
+// time the phases of the initialization with CONFIG_STATS
+#define PHASE(name) IFDEF(CONFIG_STATS, stats_phase(name))
+void set_trace(bool on);
+void cpu_set_ff(uint64_t n);
+void cpu_set_max_inst(uint64_t n);
+void cpu_set_timeout(int sec);
+void cpu_set_progress(int sec);
+bool memhash_set(const char *spec);
+IFDEF(CONFIG_DEVICE, extern bool device_headless);
 
 static char *log_file = NULL;
 static char *diff_so_file = NULL;
 static char *img_file = NULL;
+static char *elf_file = NULL;
+IFDEF(CONFIG_MTRACE, static char *mtrace_file = NULL);
+IFDEF(CONFIG_CACHESIM, static char *cachesim_spec = CONFIG_CACHESIM_SPEC);
+#ifdef CONFIG_PLUGIN
+#define MAX_PLUGIN 8
+static char *plugin_spec[MAX_PLUGIN];
+static int nr_plugin = 0;
+#endif
+IFDEF(CONFIG_ITRACE_BINARY, static char *itrace_file = NULL);
+IFDEF(CONFIG_FTRACE, static char *ftrace_file = NULL);
+IFDEF(CONFIG_PROFILE, static char *profile_file = NULL);
+IFDEF(CONFIG_INST_STAT, static char *inst_stat_file = NULL);
+IFDEF(CONFIG_BBV, static char *bbv_file = NULL);
+IFDEF(CONFIG_COVERAGE, static char *cov_file = NULL);
+IFDEF(CONFIG_SIMPOINT, static char *simpoint_file = NULL);
+IFDEF(CONFIG_SIMPOINT, static char *ckpt_dir = "build/ckpt");
+IFDEF(CONFIG_SNAPSHOT, static char *restore_file = NULL);
+IFDEF(CONFIG_DECODE_CACHE_FILE, static char *dcache_file = NULL);
+IFDEF(CONFIG_DECODE_CACHE_AOT, static bool dcache_aot = false);
+IFDEF(CONFIG_INPUT_LOG, static char *input_log_file = NULL);
+IFDEF(CONFIG_INPUT_LOG, static bool input_log_replay = false);
+// armed after loading the image, which may bring symbols
+static char *trace_window[8];
+static int nr_trace_window = 0;
 static int difftest_port = 1234;
+// the image and its arguments in the user mode
+IFDEF(CONFIG_MODE_USER, static int user_argc = 0);
+IFDEF(CONFIG_MODE_USER, static char **user_argv = NULL);
 
 static long load_img() {
+#ifdef CONFIG_MODE_USER
+  Assert(img_file != NULL, "No program is given to run in the user mode");
+  return load_user(user_argc, user_argv);
+#endif
+  if (elf_file != NULL) {
+    long size;
+    cpu.pc = load_elf(elf_file, &size);
+    return size;
+  }
+
   if (img_file == NULL) {
     Log("No image is given. Use the default build-in image.");
     return 4096; // built-in image size
   }
 
-  FILE *fp = fopen(img_file, "rb");
-  Assert(fp, "Can not open '%s'", img_file);
+  int fd = open(img_file, O_RDONLY);
+  Assert(fd >= 0, "Can not open '%s'", img_file);
 
-  fseek(fp, 0, SEEK_END);
-  long size = ftell(fp);
+  struct stat st;
+  int ret = fstat(fd, &st);
+  assert(ret == 0);
+  long size = st.st_size;
 
   Log("The image is %s, size = %ld", img_file, size);
+  Assert(size <= PMEM_RIGHT - RESET_VECTOR + 1, "The image is larger than the memory");
 
-  fseek(fp, 0, SEEK_SET);
-  int ret = fread(guest_to_host(RESET_VECTOR), size, 1, fp);
-  assert(ret == 1);
+  // map the image without copying if possible
+  if (!MUXDEF(CONFIG_PMEM_MMAP, pmem_map_file(RESET_VECTOR, fd, size), false)) {
+    uint8_t *p = guest_to_host(RESET_VECTOR);
+    paddr_host_access(RESET_VECTOR, size);
+    long offset = 0;
+    while (offset < size) {
+      long n = size - offset;
+      if (n > (64 << 20)) n = (64 << 20);
+      ssize_t nread = pread(fd, p + offset, n, offset);
+      Assert(nread > 0, "Can not read '%s'", img_file);
+      offset += nread;
+    }
+  }
 
-  fclose(fp);
+  close(fd);
   return size;
 }
 
+#ifdef CONFIG_FARM
+// load `file` into the initialized machine for the farm, with the registers at reset
+long farm_load_img(const char *file) {
+  img_file = (char *)file;
+  elf_file = NULL;
+  IFDEF(CONFIG_MODE_USER, user_argc = 1; user_argv = &img_file);
+  init_isa();
+  return load_img();
+}
+#endif
+
 static int parse_args(int argc, char *argv[]) {
   const struct option table[] = {
     {"batch"    , no_argument      , NULL, 'b'},
+    {"script"   , required_argument, NULL, 'S'},
+    {"gdb"      , required_argument, NULL, 'g'},
+    {"stats"    , required_argument, NULL, 't'},
+    {"bbv"      , required_argument, NULL, 'B'},
+    {"coverage" , required_argument, NULL, 'O'},
+    {"simpoint" , required_argument, NULL, 'k'},
+    {"ckpt-dir" , required_argument, NULL, 'K'},
+    {"restore"  , required_argument, NULL, 'C'},
+    {"dcache"   , required_argument, NULL, 'c'},
+    {"aot"      , no_argument      , NULL, 'A'},
+    {"input-record", required_argument, NULL, 'I'},
+    {"input-replay", required_argument, NULL, 'J'},
+    {"farm"     , required_argument, NULL, 'F'},
+    {"run-list" , required_argument, NULL, 'L'},
+    {"jobs"     , required_argument, NULL, 'j'},
+    {"lockstep" , required_argument, NULL, 'Q'},
     {"log"      , required_argument, NULL, 'l'},
+    {"log-level", required_argument, NULL, 'v'},
     {"diff"     , required_argument, NULL, 'd'},
+    {"elf"      , required_argument, NULL, 'e'},
     {"port"     , required_argument, NULL, 'p'},
+    {"mtrace"   , required_argument, NULL, 'm'},
+    {"cachesim" , required_argument, NULL, 'M'},
+    {"plugin"   , required_argument, NULL, 'X'},
+    {"itrace"   , required_argument, NULL, 'i'},
+    {"ftrace"   , required_argument, NULL, 'f'},
+    {"profile"  , required_argument, NULL, 'P'},
+    {"inst-stat", required_argument, NULL, 's'},
+    {"trace-window", required_argument, NULL, 'w'},
+    {"diff-record", required_argument, NULL, 'r'},
+    {"diff-replay", required_argument, NULL, 'R'},
+    {"no-trace" , no_argument      , NULL, 'n'},
+    {"headless" , no_argument      , NULL, 'H'},
+    {"record-video", required_argument, NULL, 'V'},
+    {"ff"       , required_argument, NULL, 'N'},
+    {"max-inst" , required_argument, NULL, 'Y'},
+    {"timeout"  , required_argument, NULL, 'T'},
+    {"progress" , required_argument, NULL, 'G'},
+    {"hash-mem" , required_argument, NULL, 'a'},
     {"help"     , no_argument      , NULL, 'h'},
     {0          , 0                , NULL,  0 },
   };
   int o;
-  while ( (o = getopt_long(argc, argv, "-bhl:d:p:", table, NULL)) != -1) {
+  while ( (o = getopt_long(argc, argv, "-bhnHAl:v:d:e:p:m:M:X:r:R:i:w:f:P:s:S:g:t:B:O:k:K:C:c:I:J:F:L:j:Q:N:Y:T:G:a:V:", table, NULL)) != -1) {
     switch (o) {
       case 'b': sdb_set_batch_mode(); break;
+      case 'S': sdb_set_script(optarg); break;
+      case 'g': IFDEF(CONFIG_GDBSTUB, sdb_set_gdb(atoi(optarg))); break;
+      case 't': IFDEF(CONFIG_STATS, stats_set_json(optarg)); break;
+      case 'B': IFDEF(CONFIG_BBV, bbv_file = optarg); break;
+      case 'O': IFDEF(CONFIG_COVERAGE, cov_file = optarg); break;
+      case 'k': IFDEF(CONFIG_SIMPOINT, simpoint_file = optarg); break;
+      case 'K': IFDEF(CONFIG_SIMPOINT, ckpt_dir = optarg); break;
+      case 'C': IFDEF(CONFIG_SNAPSHOT, restore_file = optarg); break;
+      case 'c': IFDEF(CONFIG_DECODE_CACHE_FILE, dcache_file = optarg); break;
+      case 'A': IFDEF(CONFIG_DECODE_CACHE_AOT, dcache_aot = true); break;
+      case 'I': IFDEF(CONFIG_INPUT_LOG, input_log_file = optarg; input_log_replay = false); break;
+      case 'J': IFDEF(CONFIG_INPUT_LOG, input_log_file = optarg; input_log_replay = true); break;
+      case 'F': IFDEF(CONFIG_FARM, farm_set_list(optarg)); break;
+      case 'L': IFDEF(CONFIG_RUN_LIST, farm_set_run_list(optarg)); break;
+      case 'j': IFDEF(CONFIG_FARM, farm_set_jobs(atoi(optarg))); break;
+      case 'Q': IFDEF(CONFIG_LOCKSTEP, lockstep_set_faults(optarg)); break;
       case 'p': sscanf(optarg, "%d", &difftest_port); break;
+      case 'n': set_trace(false); break;
+      case 'H': IFDEF(CONFIG_DEVICE, device_headless = true); break;
+      case 'V': IFDEF(CONFIG_VGA_RECORD, vga_set_record(optarg)); break;
+      case 'N': cpu_set_ff(strtoull(optarg, NULL, 0)); break;
+      case 'Y': cpu_set_max_inst(strtoull(optarg, NULL, 0)); break;
+      case 'T': cpu_set_timeout(atoi(optarg)); break;
+      case 'G': cpu_set_progress(atoi(optarg)); break;
+      case 'a': if (!memhash_set(optarg)) exit(1); break;
       case 'l': log_file = optarg; break;
+      case 'v': log_level = atoi(optarg); break;
       case 'd': diff_so_file = optarg; break;
-      case 1: img_file = optarg; return 0;
+      case 'e': elf_file = optarg; break;
+      case 'm': IFDEF(CONFIG_MTRACE, mtrace_file = optarg); break;
+      case 'M': IFDEF(CONFIG_CACHESIM, cachesim_spec = optarg); break;
+      case 'X': IFDEF(CONFIG_PLUGIN, if (nr_plugin < MAX_PLUGIN) plugin_spec[nr_plugin ++] = optarg); break;
+      case 'i': IFDEF(CONFIG_ITRACE_BINARY, itrace_file = optarg); break;
+      case 'f': IFDEF(CONFIG_FTRACE, ftrace_file = optarg); break;
+      case 'P': IFDEF(CONFIG_PROFILE, profile_file = optarg); break;
+      case 's': IFDEF(CONFIG_INST_STAT, inst_stat_file = optarg); break;
+      case 'w':
+        Assert(nr_trace_window < ARRLEN(trace_window), "Too many trace windows");
+        trace_window[nr_trace_window ++] = optarg;
+        break;
+      case 'r': IFDEF(CONFIG_DIFFTEST_LOG, difftest_set_log(optarg, false)); break;
+      case 'R': IFDEF(CONFIG_DIFFTEST_LOG, difftest_set_log(optarg, true)); break;
+      case 1:
+        img_file = optarg;
+        IFDEF(CONFIG_MODE_USER, user_argc = argc - optind + 1; user_argv = argv + optind - 1);
+        return 0;
       default:
         printf("Usage: %s [OPTION...] IMAGE [args]\n\n", argv[0]);
         printf("\t-b,--batch              run with batch mode\n");
+        printf("\t-S,--script=FILE        run the sdb commands in FILE, and print the results in JSON\n");
+        printf("\t-g,--gdb=PORT           wait for gdb to connect to PORT before running\n");
         printf("\t-l,--log=FILE           output log to FILE\n");
+        printf("\t-v,--log-level=N        only log messages up to N (1: warn, 2: info, 3: debug), no higher than CONFIG_LOG_LEVEL\n");
         printf("\t-d,--diff=REF_SO        run DiffTest with reference REF_SO\n");
+        printf("\t-e,--elf=FILE           load the PT_LOAD segments of FILE, start from its entry\n");
         printf("\t-p,--port=PORT          run DiffTest with port PORT\n");
+        printf("\t-m,--mtrace=FILE        trace memory accesses into FILE\n");
+        printf("\t-M,--cachesim=SPEC      simulate the caches in SPEC, such as l1d=64:8:64,l2=1024:16:64,policy=lru\n");
+        printf("\t-X,--plugin=LIB[,ARG]   load the plugin LIB with the argument ARG, which can be given more than once\n");
+        printf("\t-i,--itrace=FILE        record instructions executed into FILE in binary\n");
+        printf("\t-f,--ftrace=FILE        record function calls and returns into FILE\n");
+        printf("\t-P,--profile=FILE       sample the guest pc, and write the hot functions into FILE\n");
+        printf("\t-s,--inst-stat=FILE     write the execution counts of instructions into FILE in JSON\n");
+        printf("\t-B,--bbv=FILE           write the basic block vectors of intervals into FILE for SimPoint\n");
+        printf("\t-O,--coverage=FILE      write the lines and branches of --elf covered into FILE in the lcov format\n");
+        printf("\t-k,--simpoint=FILE      run untraced and save snapshots at the intervals chosen by SimPoint in FILE\n");
+        printf("\t-K,--ckpt-dir=DIR       save the snapshots of --simpoint to DIR (build/ckpt by default)\n");
+        printf("\t-C,--restore=FILE       start from the snapshot saved into FILE by \"save FILE\"\n");
+        printf("\t-c,--dcache=FILE        load the decode cache saved into FILE by the last run of the image, and save it on exit\n");
+        printf("\t-A,--aot                decode the code reachable in the image before running\n");
+        printf("\t-I,--input-record=FILE  log the inputs of devices with the instruction counts they come at to FILE\n");
+        printf("\t-J,--input-replay=FILE  take the inputs of devices from FILE logged by --input-record\n");
+        printf("\t-F,--farm=LIST          run the images listed in LIST in parallel, and print a line of result for each\n");
+        printf("\t-L,--run-list=LIST      run the images listed in LIST one after another in this process, and print a line of result for each\n");
+        printf("\t-j,--jobs=N             run N images of --farm at a time (the number of host CPUs by default), or of --run-list in turns\n");
+        printf("\t-Q,--lockstep=FAULTS    run the image with each fault in FAULTS injected in lockstep, and print a line of result for each\n");
+        printf("\t-t,--stats=FILE         write the timing of phases, the breakdown and speed of running into FILE in JSON\n");
+        printf("\t-r,--diff-record=FILE   record the states of REF in DiffTest to FILE\n");
+        printf("\t-R,--diff-replay=FILE   run DiffTest against the states in FILE, without REF\n");
+        printf("\t-n,--no-trace           start without tracing, send SIGUSR1 to switch\n");
+        printf("\t-H,--headless           run devices without SDL, showing no window and playing no sound\n");
+        printf("\t-V,--record-video=FILE  record the screen into FILE in Y4M, or pipe it to COMMAND if FILE is |COMMAND\n");
+        printf("\t-N,--ff=N               run untraced without breakpoints and watchpoints for the first N instructions\n");
+        printf("\t-Y,--max-inst=N         abort the guest after N instructions\n");
+        printf("\t-T,--timeout=SEC        abort the guest after SEC seconds of host time\n");
+        printf("\t-G,--progress=SEC       report the instructions, the speed and the pc every SEC seconds\n");
+        printf("\t-a,--hash-mem=RANGES   hash pmem in RANGES, which are LO:HI[,LO:HI...][=EXPECTED], at the end, and check it with EXPECTED\n");
+        printf("\t-w,--trace-window=WIN   only trace inside WIN, which is inst:LO:HI, pc:LO:HI or sym:NAME\n");
         printf("\n");
         exit(0);
     }
@@ -100,33 +305,186 @@ void init_monitor(int argc, char *argv[]) {
   /* Perform some global initialization. */
 
   /* Parse arguments. */
+  PHASE("args");
   parse_args(argc, argv);
 
   /* Set random seed. */
   init_rand();
 
   /* Open the log file. */
+  PHASE("log");
   init_log(log_file);
 
+#ifdef CONFIG_LIVE
+  /* Publish the live counters, before the devices are counted. */
+  void init_live();
+  init_live();
+#endif
+
   /* Initialize memory. */
+  PHASE("mem");
   init_mem();
 
+#ifdef CONFIG_MTRACE
+  /* Start tracing memory accesses. */
+  if (mtrace_file != NULL) {
+    bool ok = mtrace_start(mtrace_file);
+    Assert(ok, "Can not open '%s'", mtrace_file);
+  }
+#endif
+
+#ifdef CONFIG_PLUGIN
+  /* Load the plugins, which hook the blocks when they are first run. */
+  for (int i = 0; i < nr_plugin; i ++) {
+    bool ok = plugin_load(plugin_spec[i]);
+    Assert(ok, "Can not load the plugin '%s'", plugin_spec[i]);
+  }
+#endif
+
+#ifdef CONFIG_CACHESIM
+  /* Simulate the caches on the accesses traced. */
+  bool ok = mtrace_cachesim(cachesim_spec);
+  Assert(ok, "Bad spec of the caches '%s'", cachesim_spec);
+#endif
+
+#ifdef CONFIG_ITRACE_BINARY
+  /* Record instructions executed, which are disassembled by tools/nemu-trace. */
+  if (itrace_file != NULL) {
+    bool ok = itrace_open(itrace_file);
+    Assert(ok, "Can not open '%s'", itrace_file);
+  }
+#endif
+
   /* Initialize devices. */
+  PHASE("device");
   IFDEF(CONFIG_DEVICE, init_device());
 
+#ifdef CONFIG_INPUT_LOG
+  /* Log the inputs of devices, or take them from the log. */
+  if (input_log_file != NULL) {
+    bool input_log_open(const char *file, bool replay);
+    bool ok = input_log_open(input_log_file, input_log_replay);
+    Assert(ok, "Can not open '%s'", input_log_file);
+  }
+#endif
+
   /* Perform ISA dependent initialization. */
+  PHASE("isa");
   init_isa();
 
   /* Load the image to memory. This will overwrite the built-in image. */
+  PHASE("img");
   long img_size = load_img();
 
+#ifdef CONFIG_DECODE_CACHE_FILE
+  /* Skip decoding the code decoded by the last run of the same image. */
+  if (dcache_file != NULL) {
+    void isa_decode_cache_file(const char *file, long img_size);
+    isa_decode_cache_file(dcache_file, img_size);
+  }
+#endif
+
+#ifdef CONFIG_DECODE_CACHE_AOT
+  /* Decode the code reachable in the image before running. */
+  if (dcache_aot) {
+    void isa_decode_cache_aot(long img_size);
+    isa_decode_cache_aot(img_size);
+  }
+#endif
+
+#ifdef CONFIG_FTRACE
+  /* Trace function calls with the symbols loaded with the image. */
+  if (ftrace_file != NULL) {
+    bool ok = ftrace_open(ftrace_file);
+    Assert(ok, "Can not open '%s'", ftrace_file);
+  }
+#endif
+
+#ifdef CONFIG_INST_STAT
+  if (inst_stat_file != NULL) {
+    void inst_stat_set_json(const char *file);
+    inst_stat_set_json(inst_stat_file);
+  }
+#endif
+
+#ifdef CONFIG_BBV
+  /* Count the instructions executed in basic blocks by intervals. */
+  if (bbv_file != NULL) {
+    bool bbv_open(const char *file);
+    bool ok = bbv_open(bbv_file);
+    Assert(ok, "Can not open '%s'", bbv_file);
+  }
+#endif
+
+#ifdef CONFIG_COVERAGE
+  /* Mark the code executed for the coverage. */
+  if (cov_file != NULL) {
+    bool cov_open(const char *file, const char *elf);
+    bool ok = cov_open(cov_file, elf_file);
+    Assert(ok, "Can not write the coverage of --elf into '%s'", cov_file);
+  }
+#endif
+
+#ifdef CONFIG_SIMPOINT
+  /* Fast-forward to the intervals chosen without instrumentation. */
+  if (simpoint_file != NULL) {
+    bool simpoint_open(const char *file, const char *dir);
+    bool ok = simpoint_open(simpoint_file, ckpt_dir);
+    Assert(ok, "Can not read '%s' or create '%s'", simpoint_file, ckpt_dir);
+    set_trace(false);
+  }
+#endif
+
+#ifdef CONFIG_PROFILE
+  /* Start sampling the guest pc. */
+  if (profile_file != NULL) {
+    void profile_start(const char *file);
+    profile_start(profile_file);
+  }
+#endif
+
+  /* Arm the trace windows. */
+  int i;
+  for (i = 0; i < nr_trace_window; i ++) {
+    char *kind = strtok(trace_window[i], ":");
+    char *a = strtok(NULL, ":");
+    char *b = strtok(NULL, ":");
+    const char *err = trace_window_arm(kind, a, b);
+    Assert(err == NULL, "Bad trace window: %s", err);
+  }
+
+#ifdef CONFIG_MULTI_HART
+  /* Park the harts other than hart 0. */
+  void init_hart();
+  init_hart();
+#endif
+
   /* Initialize differential testing. */
+  PHASE("difftest");
   init_difftest(diff_so_file, img_size, difftest_port);
 
+#ifdef CONFIG_SNAPSHOT
+  /* Start from a snapshot instead of the image at reset. */
+  if (restore_file != NULL) {
+    PHASE("restore");
+    bool snapshot_load(const char *file);
+    bool ok = snapshot_load(restore_file);
+    Assert(ok, "Can not restore from '%s'", restore_file);
+    Log("Restored from %s, pc = " FMT_WORD, restore_file, cpu.pc);
+  }
+#endif
+
   /* Initialize the simple debugger. */
+  PHASE("sdb");
   init_sdb();
 
-  IFDEF(CONFIG_ITRACE, init_disasm());
+  /* Switch between the traced and untraced execution loops with SIGUSR1. */
+  init_trace_switch();
+
+  /* Start the host timer of --timeout and --progress. */
+  init_host_timer();
+
+  PHASE(NULL);
 
   /* Display welcome message. */
   welcome();
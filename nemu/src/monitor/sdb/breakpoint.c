@@ -0,0 +1,112 @@
+/***************************************************************************************
+* Copyright (c) 2014-2024 Zihao Yu, Nanjing University
+*
+* NEMU is licensed under Mulan PSL v2.
+* You can use this software according to the terms and conditions of the Mulan PSL v2.
+* You may obtain a copy of Mulan PSL v2 at:
+*          http://license.coscl.org.cn/MulanPSL2
+*
+* THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+* EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+* MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+*
+* See the Mulan PSL v2 for more details.
+***************************************************************************************/
+
+
+#include <isa.h>
+#include <cpu/breakpoint.h>
+#include <device/replay.h>
+#include "sdb.h"
+
+int nr_bp = 0;
+vaddr_t bp_set[BP_SET_SIZE] = { [0 ... BP_SET_SIZE - 1] = BP_EMPTY };
+
+static struct {
+  bool used;
+  vaddr_t pc;
+  uint64_t hit;
+} bp[NR_BP] = {};
+
+static void bp_rebuild() {
+  int i;
+  for (i = 0; i < BP_SET_SIZE; i ++) bp_set[i] = BP_EMPTY;
+  nr_bp = 0;
+  for (i = 0; i < NR_BP; i ++) {
+    if (!bp[i].used) continue;
+    uint32_t j = (bp[i].pc ^ (bp[i].pc >> 7)) % BP_SET_SIZE;
+    while (bp_set[j] != BP_EMPTY) j = (j + 1) % BP_SET_SIZE;
+    bp_set[j] = bp[i].pc;
+    nr_bp ++;
+  }
+}
+
+int bp_new(vaddr_t pc) {
+  int i, slot = -1;
+  for (i = NR_BP - 1; i >= 0; i --) {
+    if (bp[i].used && bp[i].pc == pc) return i;
+    if (!bp[i].used) slot = i;
+  }
+  if (slot < 0) return -1;
+  bp[slot].used = true;
+  bp[slot].pc = pc;
+  bp[slot].hit = 0;
+  bp_rebuild();
+  /* only the recorded blocks running across the breakpoint are recorded
+   * again, and a block split by a breakpoint deleted later is only shorter,
+   * so that the blocks stay warm while debugging */
+  IFDEF(CONFIG_ENGINE_BLOCK, void block_split(vaddr_t pc); block_split(pc));
+  IFDEF(CONFIG_ENGINE_JIT, void jit_split(vaddr_t pc); jit_split(pc));
+  return slot;
+}
+
+int bp_find(vaddr_t pc) {
+  int i;
+  for (i = 0; i < NR_BP; i ++) {
+    if (bp[i].used && bp[i].pc == pc) return i;
+  }
+  return -1;
+}
+
+bool bp_delete(int NO) {
+  if (NO < 0 || NO >= NR_BP || !bp[NO].used) return false;
+  bp[NO].used = false;
+  bp_rebuild();
+  return true;
+}
+
+void bp_clear() {
+  int i;
+  for (i = 0; i < NR_BP; i ++) bp[i].used = false;
+  bp_rebuild();
+}
+
+void bp_display() {
+  if (nr_bp == 0) {
+    printf("No breakpoints.\n");
+    return;
+  }
+  printf("Num  Address     Hits      What\n");
+  int i;
+  for (i = 0; i < NR_BP; i ++) {
+    if (!bp[i].used) continue;
+    word_t off = 0;
+    const char *name = symbol_lookup(bp[i].pc, &off);
+    printf("%-4d " FMT_WORD "  %-9" PRIu64 " ", i, bp[i].pc, bp[i].hit);
+    if (name != NULL) printf("<%s+%" PRIu64 ">", name, (uint64_t)off);
+    printf("\n");
+  }
+}
+
+bool bp_stop(vaddr_t pc) {
+  int i;
+  for (i = 0; i < NR_BP && !MUXDEF(CONFIG_REVERSE, reverse_replaying, false); i ++) {
+    if (bp[i].used && bp[i].pc == pc) {
+      bp[i].hit ++;
+      printf("\nBreakpoint %d, pc = " FMT_WORD "\n", i, pc);
+      break;
+    }
+  }
+  if (nemu_state.state == NEMU_RUNNING) nemu_state.state = NEMU_STOP;
+  return true;
+}
@@ -14,11 +14,10 @@
 ***************************************************************************************/
 
 #include <isa.h>
+#include <memory/host.h>
+#include <memory/paddr.h>
+#include "sdb.h"
 
-/* We use the POSIX regex functions to process regular expressions.
- * Type 'man regex' for more information about POSIX regex functions.
- */
-#include <regex.h>
 #include <string.h>
 
 // For expr unit test, in this mode, special token will be set to a custom number, as follow:
@@ -41,44 +40,6 @@ enum {
   TK_DEREF
 };
 
-static struct rule {
-  const char *regex;
-  int token_type;
-} rules[] = {
-  {"[ ]", TK_NOTYPE},    // spaces
-  {"==", TK_EQ},        // equal
-  {"\\+", TK_ADD},
-  {"\\-", TK_SUB},
-  {"\\*", TK_MULTIPLY},
-  {"\\/", TK_DIVIDE},
-  {"\\(", TK_OPENPARENTHESIS},
-  {"\\)", TK_CLOSEPARENTHESIS},
-  {"[1-9][0-9]*", TK_NUMBER},
-  {"0[xX][0-9a-fA-F]+", TK_HEX_NUMBER},
-  {"\\$[a-zA-Z0-9]+", TK_REG_NAME},
-};
-
-#define NR_REGEX ARRLEN(rules)
-
-static regex_t re[NR_REGEX] = {};
-
-/* Rules are used for many times.
- * Therefore we compile them only once before any usage.
- */
-void init_regex() {
-  int i;
-  char error_msg[128];
-  int ret;
-
-  for (i = 0; i < NR_REGEX; i ++) {
-    ret = regcomp(&re[i], rules[i].regex, REG_EXTENDED);
-    if (ret != 0) {
-      regerror(ret, &re[i], error_msg, 128);
-      panic("regex compilation failed: %s\n%s", error_msg, rules[i].regex);
-    }
-  }
-}
-
 typedef struct token {
   int type;
   char str[32];
@@ -103,75 +64,112 @@ static bool check_substr_valid(int substr_len)
   return true;
 }
 
+static inline bool is_hex(char c) {
+  return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F');
+}
+
+static inline bool is_alnum(char c) {
+  return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+}
+
+/* Scan the expression in a single pass. The tokens are the same as the
+ * rules below matched one by one with POSIX regex, which took a regexec()
+ * for each rule at each position:
+ *   " " "==" "+" "-" "*" "/" "(" ")" "0|[1-9][0-9]*" "0[xX][0-9a-fA-F]+" "\$[a-zA-Z0-9]+"
+ */
 static bool make_token(char *e) {
   int position = 0;
-  int i;
-  regmatch_t pmatch;
 
   nr_token = 0;
 
   while (e[position] != '\0') {
-    /* Try all rules one by one. */
-    for (i = 0; i < NR_REGEX; i ++) {
-      //printf("i:%d; regexec re:%d; rm_so:%d;\n", i, regexec(&re[i], e + position, 1, &pmatch, 0), pmatch.rm_so);
-      if (regexec(&re[i], e + position, 1, &pmatch, 0) == 0 && pmatch.rm_so == 0) {
-        char *substr_start = e + position;
-        int substr_len = pmatch.rm_eo;
-        position += substr_len;
-        switch (rules[i].token_type) {
-          case TK_NUMBER:
-          case TK_HEX_NUMBER:
-          case TK_REG_NAME:
-            Log("match rules[%d] = \"%s\" at position %d with len %d: %.*s",
-                i, rules[i].regex, position, substr_len, substr_len, substr_start);
-            check_nr_valid();
-            check_substr_valid(substr_len);
-            memset(tokens[nr_token].str, 0, sizeof(tokens[0].str) / sizeof(char));
-            memcpy(tokens[nr_token].str, substr_start, substr_len);
-            tokens[nr_token].type = rules[i].token_type;
-            nr_token++;
-            break;
-          case TK_ADD:
-          case TK_SUB:
-          case TK_MULTIPLY:
-            if(0 == nr_token || TK_ADD == tokens[nr_token - 1].type
-                             || TK_SUB == tokens[nr_token - 1].type
-                             || TK_MULTIPLY == tokens[nr_token - 1].type
-                             || TK_DIVIDE == tokens[nr_token - 1].type
-                             || TK_OPENPARENTHESIS == tokens[nr_token - 1].type) {
-              Log("match (TK_DEREF) rules[%d] = \"%s\" at position %d with len %d: %.*s",
-                   i, rules[i].regex, position, substr_len, substr_len, substr_start);
-              check_nr_valid();
-              tokens[nr_token].type = TK_DEREF;
-              nr_token++;
-              break;
-            }
-          case TK_DIVIDE:
-          case TK_OPENPARENTHESIS:
-          case TK_CLOSEPARENTHESIS:
-            Log("match rules[%d] = \"%s\" at position %d with len %d: %.*s",
-                i, rules[i].regex, position, substr_len, substr_len, substr_start);
-            check_nr_valid();
-            tokens[nr_token].type = rules[i].token_type;
-            nr_token++;
-            break;
-          case TK_NOTYPE:
-            break;
-          default: TODO();
+    char *substr_start = e + position;
+    int substr_len = 1, type;
+    switch (*substr_start) {
+      case ' ': position ++; continue;
+      case '+': type = TK_ADD; break;
+      case '-': type = TK_SUB; break;
+      case '*': type = TK_MULTIPLY; break;
+      case '/': type = TK_DIVIDE; break;
+      case '(': type = TK_OPENPARENTHESIS; break;
+      case ')': type = TK_CLOSEPARENTHESIS; break;
+      case '=':
+        if (substr_start[1] != '=') goto no_match;
+        type = TK_EQ; substr_len = 2;
+        break;
+      case '0':
+        if ((substr_start[1] != 'x' && substr_start[1] != 'X') || !is_hex(substr_start[2])) {
+          type = TK_NUMBER;
+          break;
         }
+        type = TK_HEX_NUMBER;
+        for (substr_len = 3; is_hex(substr_start[substr_len]); substr_len ++);
         break;
-      }
+      case '1' ... '9':
+        type = TK_NUMBER;
+        while (substr_start[substr_len] >= '0' && substr_start[substr_len] <= '9') substr_len ++;
+        break;
+      case '$':
+        if (!is_alnum(substr_start[1])) goto no_match;
+        type = TK_REG_NAME;
+        for (substr_len = 2; is_alnum(substr_start[substr_len]); substr_len ++);
+        break;
+      default: goto no_match;
     }
-
-    if (i == NR_REGEX) {
-      printf("no match at position %d\n%s\n%*.s^\n", position, e, position, "");
-      return false;
+    position += substr_len;
+
+    switch (type) {
+      case TK_NUMBER:
+      case TK_HEX_NUMBER:
+      case TK_REG_NAME:
+        check_nr_valid();
+        check_substr_valid(substr_len);
+        memset(tokens[nr_token].str, 0, sizeof(tokens[0].str) / sizeof(char));
+        memcpy(tokens[nr_token].str, substr_start, substr_len);
+        break;
+      case TK_ADD:
+      case TK_SUB:
+      case TK_MULTIPLY:
+        if(0 == nr_token || TK_ADD == tokens[nr_token - 1].type
+                         || TK_SUB == tokens[nr_token - 1].type
+                         || TK_MULTIPLY == tokens[nr_token - 1].type
+                         || TK_DIVIDE == tokens[nr_token - 1].type
+                         || TK_OPENPARENTHESIS == tokens[nr_token - 1].type)
+          type = TK_DEREF;
+        // fall through
+      default:
+        check_nr_valid();
+        break;
     }
+    tokens[nr_token].type = type;
+    nr_token++;
   }
 
   return true;
+
+no_match:
+  printf("no match at position %d\n%s\n%*.s^\n", position, e, position, "");
+  return false;
 }
 
+/* An expression is compiled once into a postfix program of the ops below,
+ * with constant subexpressions folded into single OP_NUM, so that a
+ * watchpoint or `p` evaluates it by a loop over a small stack instead of
+ * tokenizing and parsing the string again. */
+enum { OP_NUM, OP_REG, OP_DEREF, OP_EQ, OP_ADD, OP_SUB, OP_MUL, OP_DIV };
+
+typedef struct {
+  int type;
+  word_t val;          // OP_NUM
+  const char *reg;     // OP_REG, the name without '$'
+} Op;
+
+struct Expr {
+  int nr_op;
+  Op op[ARRLEN(tokens)]; // at most one op for each token
+  char reg[ARRLEN(tokens)][32];
+};
+
 static inline bool check_parentheses(int token_start, int token_end)
 {
   int parenthesis_num = 0;
@@ -200,132 +198,172 @@ static inline bool check_parentheses(int token_start, int token_end)
   return true;
 }
 
-static inline int eval(int token_start, int token_end)
-{
-  int token_tmp, parenthesis_num;
-  int token_diff;
+static int precedence(int type) {
+  switch (type) {
+    case TK_EQ: return 1;
+    case TK_ADD: case TK_SUB: return 2;
+    case TK_MULTIPLY: case TK_DIVIDE: return 3;
+    default: return 0;
+  }
+}
+
+static word_t binary(int op, word_t a, word_t b) {
+  switch (op) {
+    case OP_EQ: return a == b;
+    case OP_ADD: return a + b;
+    case OP_SUB: return a - b;
+    case OP_MUL: return a * b;
+    default: return a / b;
+  }
+}
 
-  if(token_start > token_end){
-    assert(0);
+static void emit_binary(Expr *c, int op) {
+  Op *a = &c->op[c->nr_op - 2], *b = &c->op[c->nr_op - 1];
+  // the roots of both operands are the last two ops, fold them if constant
+  if (a->type == OP_NUM && b->type == OP_NUM && !(op == OP_DIV && b->val == 0)) {
+    a->val = binary(op, a->val, b->val);
+    c->nr_op --;
+    return;
   }
+  c->op[c->nr_op ++] = (Op) { .type = op };
+}
 
-  // 1. 若表达式为数值类，则返回数值
-  token_diff = token_end - token_start;
-  if(0 == token_diff || 1 == token_diff) {
-    if(0 == token_diff && TK_NUMBER == tokens[token_start].type) {  // TK_NUMBER
-      Log("match TK_NUMBER, eval return number:%s;", tokens[token_start].str);
-      return atoi(tokens[token_start].str);
-    } else if(0 == token_diff && TK_HEX_NUMBER == tokens[token_start].type) { // TK_HEX_NUMBER
-      Log("match TK_HEX_NUMBER, eval return number:%s;", tokens[token_start].str);
-      return strtol(tokens[token_start].str, NULL, 16);
-    } else if(1 == token_diff
-              && TK_DEREF == tokens[token_start].type
-              && (TK_NUMBER == tokens[token_end].type || TK_HEX_NUMBER == tokens[token_end].type)) { // TK_DEREF
-      Log("match TK_DEREF, eval pointer: *%s;", tokens[token_end].str);
+static bool compile(Expr *c, int token_start, int token_end)
+{
+  if(token_start > token_end)
+    return false;
+
+  // 1. 若表达式为数值类或寄存器, 则生成对应的操作
+  if(token_start == token_end) {
+    Token *t = &tokens[token_start];
+    Op *op = &c->op[c->nr_op];
+    switch(t->type) {
+      case TK_NUMBER:     *op = (Op) { .type = OP_NUM, .val = strtoull(t->str, NULL, 10) }; break;
+      case TK_HEX_NUMBER: *op = (Op) { .type = OP_NUM, .val = strtoull(t->str, NULL, 16) }; break;
+      case TK_REG_NAME: {
 #if EXPR_UNIT_TEST_ENABLED
-      return 1;
+        *op = (Op) { .type = OP_NUM, .val = 2 };
 #else
-      // TODO: find deref
-      return -1;
+        bool success = true;
+        isa_reg_str2val(t->str + 1, &success);
+        if(!success) {
+          printf("unknown register %s\n", t->str);
+          return false;
+        }
+        strcpy(c->reg[token_start], t->str + 1);
+        *op = (Op) { .type = OP_REG, .reg = c->reg[token_start] };
 #endif
-    } else if(0 == token_diff && TK_REG_NAME == tokens[token_start].type) {  // TK_REG_NAME
-      Log("match TK_REG_NAME, eval pointer: *%s;", tokens[token_end].str);
+        break;
+      }
+      default: return false;
+    }
+    c->nr_op++;
+    return true;
+  }
+
+  // 2. 若表达式前后只有正反括号, 则解括号后处理内部
+  if(TK_OPENPARENTHESIS == tokens[token_start].type
+      && TK_CLOSEPARENTHESIS == tokens[token_end].type
+      && check_parentheses(token_start + 1, token_end - 1))
+    return compile(c, token_start + 1, token_end - 1);
+
+  // 3. 从token_end往token_start找括号外优先级最低的运算符, 同优先级取最右边的
+  int token_tmp, parenthesis_num = 0, main_op = -1;
+  for(token_tmp = token_end; token_tmp >= token_start; token_tmp--) {
+    int type = tokens[token_tmp].type;
+    if(TK_CLOSEPARENTHESIS == type) parenthesis_num++;
+    else if(TK_OPENPARENTHESIS == type) parenthesis_num--;
+    if(parenthesis_num < 0) return false;
+    if(0 != parenthesis_num || 0 == precedence(type)) continue;
+    if(main_op < 0 || precedence(type) < precedence(tokens[main_op].type)) main_op = token_tmp;
+  }
+  if(0 != parenthesis_num)
+    return false;
+
+  if(main_op < 0) {
+    // 4. 没有二元运算符, 只能是解引用
+    if(TK_DEREF != tokens[token_start].type || !compile(c, token_start + 1, token_end))
+      return false;
 #if EXPR_UNIT_TEST_ENABLED
-      return 2;
+    c->op[c->nr_op - 1] = (Op) { .type = OP_NUM, .val = 1 };
 #else
-      // TODO: find reg
-      return -1;
+    c->op[c->nr_op++] = (Op) { .type = OP_DEREF };
 #endif
-    } else
-      assert(0);
+    return true;
   }
 
-  if(!check_parentheses(token_start, token_end))
-    assert(0);
-
-  // 2. 若表达式前后只有正反括号，并且解括号后从前往后扫描总是先有'('再有对应的')', 则解括号后调用递归函数处理内部
-  if(TK_OPENPARENTHESIS == tokens[token_start].type
-      && TK_CLOSEPARENTHESIS == tokens[token_end].type
-      && check_parentheses(token_start + 1, token_end - 1)) {
-    Log("match TK_OPENPARENTHESIS/TK_CLOSEPARENTHESIS in start/end, parse inner expr;");
-    return eval(token_start + 1, token_end - 1);
+  if(!compile(c, token_start, main_op - 1) || !compile(c, main_op + 1, token_end))
+    return false;
+  switch(tokens[main_op].type) {
+    case TK_EQ:       emit_binary(c, OP_EQ); break;
+    case TK_ADD:      emit_binary(c, OP_ADD); break;
+    case TK_SUB:      emit_binary(c, OP_SUB); break;
+    case TK_MULTIPLY: emit_binary(c, OP_MUL); break;
+    default:          emit_binary(c, OP_DIV); break;
   }
+  return true;
+}
 
-  // 从token_end往token_start找符号
-  token_tmp = token_end + 1;
-  parenthesis_num = 0;
-  while(token_tmp > token_start) {
-    token_tmp--;
-    switch(tokens[token_tmp].type) {
-      // 找到)后寻找对应的(并跳过中间表达式
-      case TK_OPENPARENTHESIS:
-        parenthesis_num++;
-        Log("match TK_OPENPARENTHESIS, parenthesis_num:%d;", parenthesis_num);
-        break;
-      case TK_CLOSEPARENTHESIS:
-        parenthesis_num--;
-        Log("match TK_CLOSEPARENTHESIS, parenthesis_num:%d;", parenthesis_num);
-        break;
-      // 找到+或-后将符号先后进行分割并分别调用递归函数，并用+或-相连接
-      case TK_ADD:
-        if(0 != parenthesis_num) continue;
-        Log("match TK_ADD, do eval call");
-        return eval(token_start, token_tmp - 1) + eval(token_tmp + 1, token_end);
-      case TK_SUB:
-        if(0 != parenthesis_num) continue;
-        Log("match TK_SUB, do eval call");
-        return eval(token_start, token_tmp - 1) - eval(token_tmp + 1, token_end);
-      default:
-        break;
-    }
+Expr* expr_compile(char *e) {
+  if (!make_token(e) || nr_token == 0) return NULL;
+  Expr *c = malloc(sizeof(Expr));
+  assert(c != NULL);
+  c->nr_op = 0;
+  if (!compile(c, 0, nr_token - 1)) {
+    printf("invalid expression: %s\n", e);
+    free(c);
+    return NULL;
   }
+  return c;
+}
 
-  token_tmp = token_end + 1;
-  parenthesis_num = 0;
-  while(token_tmp > token_start) {
-    token_tmp--;
-    switch(tokens[token_tmp].type) {
-      // 找到)后寻找对应的(并跳过中间表达式
-      case TK_OPENPARENTHESIS:
-        parenthesis_num++;
-        Log("match TK_OPENPARENTHESIS, parenthesis_num:%d;", parenthesis_num);
-        break;
-      case TK_CLOSEPARENTHESIS:
-        parenthesis_num--;
-        Log("match TK_CLOSEPARENTHESIS, parenthesis_num:%d;", parenthesis_num);
+// a word of pmem is read without side effects, reading other addresses fails
+word_t expr_eval(const Expr *c, bool *success) {
+  word_t stack[ARRLEN(c->op)];
+  int sp = 0, i;
+  *success = true;
+  for (i = 0; i < c->nr_op; i ++) {
+    const Op *op = &c->op[i];
+    switch (op->type) {
+      case OP_NUM: stack[sp ++] = op->val; break;
+      case OP_REG: stack[sp ++] = isa_reg_str2val(op->reg, success); break;
+      case OP_DEREF: {
+        paddr_t addr = stack[sp - 1];
+        if (!in_pmem(addr) || !in_pmem(addr + sizeof(word_t) - 1)) { *success = false; return 0; }
+        stack[sp - 1] = host_read(guest_to_host(addr), sizeof(word_t));
         break;
-      // 找到*或/后将符号先后进行分割并分别调用递归函数，并用*或/相连接
-      case TK_MULTIPLY:
-        if(0 != parenthesis_num) continue;
-        Log("match TK_MULTIPLY, do eval call");
-        return eval(token_start, token_tmp - 1) * eval(token_tmp + 1, token_end);
-      case TK_DIVIDE:
-        if(0 != parenthesis_num) continue;
-        Log("match TK_DIVIDE, do eval call");
-        return eval(token_start, token_tmp - 1) / eval(token_tmp + 1, token_end);
+      }
       default:
-        break;
+        sp --;
+        if (op->type == OP_DIV && stack[sp] == 0) { *success = false; return 0; }
+        stack[sp - 1] = binary(op->type, stack[sp - 1], stack[sp]);
     }
   }
+  return stack[0];
+}
 
-  // token_tmp <= token_start
-  assert(0);
-
-  // TODO:
-  return -1;
+/* Store the addresses dereferenced by `c` into `addr`, and return how many
+ * there are, or -1 if `c` reads registers or memory at addresses which are
+ * not constant, i.e. its value may change without writing these words. */
+int expr_mem_deps(const Expr *c, paddr_t *addr, int n) {
+  int nr = 0, i;
+  for (i = 0; i < c->nr_op; i ++) {
+    if (c->op[i].type == OP_REG) return -1;
+    if (c->op[i].type != OP_DEREF) continue;
+    // the operand is constant iff it is folded into the op before
+    if (c->op[i - 1].type != OP_NUM || nr == n) return -1;
+    addr[nr ++] = c->op[i - 1].val;
+  }
+  return nr;
 }
 
 word_t expr(char *e, bool *success) {
-  int result;
-  *success = true;
-
-  if (!make_token(e)) {
+  Expr *c = expr_compile(e);
+  if (c == NULL) {
     *success = false;
     return 0;
   }
-
-  // 0 ~ (nr_token-1)
-  result = eval(0, nr_token - 1);
-
+  word_t result = expr_eval(c, success);
+  free(c);
   return result;
 }
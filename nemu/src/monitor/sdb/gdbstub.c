@@ -0,0 +1,335 @@
+/***************************************************************************************
+* Copyright (c) 2014-2024 Zihao Yu, Nanjing University
+*
+* NEMU is licensed under Mulan PSL v2.
+* You can use this software according to the terms and conditions of the Mulan PSL v2.
+* You may obtain a copy of Mulan PSL v2 at:
+*          http://license.coscl.org.cn/MulanPSL2
+*
+* THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+* EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+* MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+*
+* See the Mulan PSL v2 for more details.
+***************************************************************************************/
+
+
+/* A GDB remote stub, so that guest programs can be debugged with
+ *   (gdb) target remote :PORT
+ * The packets are framed like tools/qemu-diff/src/protocol.c, and the
+ * breakpoints and watchpoints asked by gdb are those of sdb. */
+
+#include <isa.h>
+#include <cpu/cpu.h>
+#include <memory/paddr.h>
+#include <difftest-def.h>
+#include <ctype.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include "sdb.h"
+
+#define PACKET_SIZE 4096
+
+struct gdb_conn {
+  FILE *in;
+  FILE *out;
+  bool ack;
+};
+
+#ifdef CONFIG_WATCHPOINT
+// a watchpoint of gdb covers several words, each watched by sdb
+#define NR_GDB_WP 16
+#define GDB_WP_WORDS 4
+static struct {
+  bool used;
+  paddr_t addr;
+  int len;
+  int NO[GDB_WP_WORDS];
+} gdb_wp[NR_GDB_WP] = {};
+#endif
+
+static volatile bool gdb_break = false;
+
+static uint8_t hex_nibble(uint8_t hex) {
+  return isdigit(hex) ? hex - '0' : tolower(hex) - 'a' + 10;
+}
+
+static uint8_t hex_encode(uint8_t digit) {
+  return digit > 9 ? 'a' + digit - 10 : '0' + digit;
+}
+
+static void hex_bytes(char *dst, const uint8_t *src, size_t len) {
+  for (size_t i = 0; i < len; i ++) {
+    *dst ++ = hex_encode(src[i] >> 4);
+    *dst ++ = hex_encode(src[i] & 0xf);
+  }
+  *dst = '\0';
+}
+
+// return the number of bytes decoded from the hex string
+static size_t unhex_bytes(uint8_t *dst, const char *src, size_t len) {
+  size_t i;
+  for (i = 0; i < len && isxdigit(src[0]) && isxdigit(src[1]); i ++, src += 2) {
+    dst[i] = hex_nibble(src[0]) << 4 | hex_nibble(src[1]);
+  }
+  return i;
+}
+
+static void send_packet(struct gdb_conn *conn, const char *command) {
+  size_t size = strlen(command);
+  uint8_t sum = 0;
+  for (size_t i = 0; i < size; i ++) sum += command[i];
+
+  int c;
+  do {
+    fprintf(conn->out, "$%s#%02x", command, sum);
+    fflush(conn->out);
+    if (!conn->ack) break;
+    // look for '+' ACK or '-' NACK/resend
+    c = fgetc(conn->in);
+  } while (c == '-');
+}
+
+// return the payload terminated by '\0' and its size, or NULL if gdb is gone
+static char* recv_packet(struct gdb_conn *conn, size_t *ret_size) {
+  static char reply[PACKET_SIZE + 1];
+  int c;
+
+  while (true) {
+    // fast-forward to the first start of packet, skipping acks and ^C
+    while ((c = fgetc(conn->in)) != EOF && c != '$');
+    if (c == EOF) return NULL;
+
+    size_t i = 0;
+    uint8_t sum = 0;
+    bool escape = false;
+    while ((c = fgetc(conn->in)) != EOF && c != '#') {
+      sum += c;
+      if (c == '}') { escape = true; continue; }
+      if (c == '*' && i > 0) {
+        // run-length-encoding, the count is added to 29
+        int count = fgetc(conn->in) - 29;
+        sum += count + 29;
+        for (; count > 0 && i < PACKET_SIZE; count --, i ++) reply[i] = reply[i - 1];
+        continue;
+      }
+      if (escape) { c ^= 0x20; escape = false; }
+      if (i < PACKET_SIZE) reply[i ++] = c;
+    }
+    if (c == EOF) return NULL;
+
+    char sum_str[3] = { fgetc(conn->in), fgetc(conn->in), '\0' };
+    bool sum_ok = strtoul(sum_str, NULL, 16) == sum;
+    if (conn->ack) {
+      fputc(sum_ok ? '+' : '-', conn->out);
+      fflush(conn->out);
+    }
+    if (sum_ok || !conn->ack) {
+      reply[i] = '\0';
+      *ret_size = i;
+      return reply;
+    }
+  }
+}
+
+// executed in signal context when gdb sends ^C, only stop the running loop
+static void gdb_sigio_handler(int sig) {
+  if (nemu_state.state == NEMU_RUNNING) {
+    gdb_break = true;
+    nemu_state.state = NEMU_STOP;
+  }
+}
+
+static void stop_reply(char *buf) {
+  switch (nemu_state.state) {
+    case NEMU_END: sprintf(buf, "W%02x", nemu_state.halt_ret & 0xff); break;
+    case NEMU_ABORT: strcpy(buf, "X06"); break;
+    default: strcpy(buf, gdb_break ? "S02" : "S05"); break;
+  }
+}
+
+static void gdb_resume(uint64_t n, char *buf) {
+  if (nemu_state.state != NEMU_END && nemu_state.state != NEMU_ABORT) {
+    gdb_break = false;
+    cpu_exec(n);
+  }
+  stop_reply(buf);
+}
+
+static bool rw_mem(char *args, char *buf, char cmd) {
+  char *p;
+  paddr_t addr = strtoul(args, &p, 16);
+  size_t len = strtoul(p + 1, &p, 16);
+  if (*p == ':') p ++;
+  if (cmd == 'm' && len > PACKET_SIZE / 2) len = PACKET_SIZE / 2;
+  // gdb probes the support of 'X' with an empty write
+  if (len == 0) { strcpy(buf, cmd == 'm' ? "" : "OK"); return true; }
+
+  // only pmem is accessed, to avoid the side effects of reading devices
+  size_t n;
+  for (n = 0; n < len && in_pmem(addr + n); n ++);
+  if (n == 0) return false;
+
+  uint8_t *host = guest_to_host(addr);
+  switch (cmd) {
+    case 'm': hex_bytes(buf, host, n); return true;
+    case 'M': if (n < len || unhex_bytes(host, p, len) < len) return false; break;
+    case 'X': if (n < len) return false; memcpy(host, p, len); break;
+  }
+  paddr_host_written(addr, len);
+  strcpy(buf, "OK");
+  return true;
+}
+
+#ifdef CONFIG_WATCHPOINT
+static bool set_wp(paddr_t addr, int len, bool insert) {
+  paddr_t base = addr & ~(paddr_t)(sizeof(word_t) - 1);
+  int nr_word = (addr + len - base + sizeof(word_t) - 1) / sizeof(word_t);
+  int i, j;
+
+  for (i = 0; i < NR_GDB_WP; i ++) {
+    if (!insert && gdb_wp[i].used && gdb_wp[i].addr == addr && gdb_wp[i].len == len) {
+      for (j = 0; j < nr_word; j ++) wp_delete(gdb_wp[i].NO[j]);
+      gdb_wp[i].used = false;
+      return true;
+    }
+  }
+  if (!insert || nr_word > GDB_WP_WORDS) return false;
+
+  for (i = 0; i < NR_GDB_WP && gdb_wp[i].used; i ++);
+  if (i == NR_GDB_WP) return false;
+  for (j = 0; j < nr_word; j ++) {
+    char e[32];
+    sprintf(e, "*" FMT_PADDR, base + j * (paddr_t)sizeof(word_t));
+    gdb_wp[i].NO[j] = wp_new(e);
+    if (gdb_wp[i].NO[j] < 0) {
+      while (j -- > 0) wp_delete(gdb_wp[i].NO[j]);
+      return false;
+    }
+  }
+  gdb_wp[i].used = true;
+  gdb_wp[i].addr = addr;
+  gdb_wp[i].len = len;
+  return true;
+}
+#endif
+
+// return 1 on success, 0 on failure, and -1 for the types not supported
+static int set_bp(char *args, bool insert) {
+  char *p;
+  int type = strtol(args, &p, 16);
+  word_t addr = strtoul(p + 1, &p, 16);
+
+  switch (type) {
+    case 0: return insert ? bp_new(addr) >= 0 : bp_delete(bp_find(addr));
+    case 2: return MUXDEF(CONFIG_WATCHPOINT, set_wp(addr, strtol(p + 1, NULL, 16), insert), -1);
+    default: return -1;
+  }
+}
+
+// return false when the session is over
+static bool handle(struct gdb_conn *conn, char *pkt, size_t size) {
+  static char buf[PACKET_SIZE + 1];
+  char *args = pkt + 1;
+  bool ok = true;
+  buf[0] = '\0';
+  isa_sync_regs(&cpu);
+
+  switch (pkt[0]) {
+    case '?': stop_reply(buf); break;
+    case 'g': hex_bytes(buf, (uint8_t *)&cpu, DIFFTEST_REG_SIZE); break;
+    case 'G': ok = unhex_bytes((uint8_t *)&cpu, args, DIFFTEST_REG_SIZE) == DIFFTEST_REG_SIZE; break;
+    case 'p': {
+      size_t off = strtoul(args, NULL, 16) * sizeof(word_t);
+      if (off + sizeof(word_t) <= DIFFTEST_REG_SIZE) hex_bytes(buf, (uint8_t *)&cpu + off, sizeof(word_t));
+      else memset(buf, 'x', sizeof(word_t) * 2), buf[sizeof(word_t) * 2] = '\0';
+      break;
+    }
+    case 'P': {
+      char *p;
+      size_t off = strtoul(args, &p, 16) * sizeof(word_t);
+      ok = off + sizeof(word_t) <= DIFFTEST_REG_SIZE &&
+        unhex_bytes((uint8_t *)&cpu + off, p + 1, sizeof(word_t)) == sizeof(word_t);
+      break;
+    }
+    case 'm': case 'M': ok = rw_mem(args, buf, pkt[0]); break;
+    case 'X':
+      // the length of the binary data tells its start
+      ok = memchr(pkt, ':', size) != NULL && rw_mem(args, buf, 'X');
+      break;
+    case 'c': case 's':
+      if (*args != '\0') cpu.pc = strtoul(args, NULL, 16);
+      gdb_resume(pkt[0] == 'c' ? -1 : 1, buf);
+      break;
+    case 'Z': case 'z': {
+      int ret = set_bp(args, pkt[0] == 'Z');
+      if (ret < 0) { send_packet(conn, ""); return true; }
+      ok = ret;
+      break;
+    }
+    case 'H': strcpy(buf, "OK"); break;
+    case 'D': send_packet(conn, "OK"); return false;
+    case 'k': nemu_state.state = NEMU_QUIT; return false;
+    case 'q':
+      if (strncmp(args, "Supported", 9) == 0) sprintf(buf, "PacketSize=%x;QStartNoAckMode+", PACKET_SIZE);
+      else if (strcmp(args, "Attached") == 0) strcpy(buf, "1");
+      else if (strcmp(args, "C") == 0) strcpy(buf, "QC1");
+      break;
+    case 'Q':
+      if (strcmp(args, "StartNoAckMode") == 0) {
+        send_packet(conn, "OK");
+        conn->ack = false;
+        return true;
+      }
+      break;
+    default: break; // an empty reply for the packets not supported
+  }
+
+  if (!ok) strcpy(buf, "E01");
+  else if (buf[0] == '\0' && strchr("GPZzX", pkt[0]) != NULL) strcpy(buf, "OK");
+  send_packet(conn, buf);
+  return true;
+}
+
+void gdbstub_serve(int port) {
+  int lfd = socket(AF_INET, SOCK_STREAM, 0);
+  int tmp = 1;
+  setsockopt(lfd, SOL_SOCKET, SO_REUSEADDR, &tmp, sizeof(tmp));
+  struct sockaddr_in sa = {
+    .sin_family = AF_INET,
+    .sin_port = htons(port),
+    .sin_addr.s_addr = htonl(INADDR_LOOPBACK),
+  };
+  if (lfd < 0 || bind(lfd, (struct sockaddr *)&sa, sizeof(sa)) != 0 || listen(lfd, 1) != 0) {
+    printf("can not listen on port %d\n", port);
+    if (lfd >= 0) close(lfd);
+    return;
+  }
+  printf("waiting for gdb on port %d, (gdb) target remote :%d\n", port, port);
+  fflush(stdout);
+  int fd = accept(lfd, NULL, NULL);
+  close(lfd);
+  if (fd < 0) return;
+  setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &tmp, sizeof(tmp));
+
+  // let ^C from gdb stop the guest running
+  void (*old_handler)(int) = signal(SIGIO, gdb_sigio_handler);
+  fcntl(fd, F_SETOWN, getpid());
+  fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_ASYNC);
+
+  struct gdb_conn conn = { .in = fdopen(fd, "rb"), .out = fdopen(dup(fd), "wb"), .ack = true };
+  Log("gdb connected");
+  char *pkt;
+  size_t size;
+  while ((pkt = recv_packet(&conn, &size)) != NULL && handle(&conn, pkt, size));
+  Log("gdb disconnected");
+
+  fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) & ~O_ASYNC);
+  fclose(conn.in);
+  fclose(conn.out);
+  signal(SIGIO, old_handler);
+}
@@ -0,0 +1,174 @@
+/***************************************************************************************
+* Copyright (c) 2014-2024 Zihao Yu, Nanjing University
+*
+* NEMU is licensed under Mulan PSL v2.
+* You can use this software according to the terms and conditions of the Mulan PSL v2.
+* You may obtain a copy of Mulan PSL v2 at:
+*          http://license.coscl.org.cn/MulanPSL2
+*
+* THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+* EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+* MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+*
+* See the Mulan PSL v2 for more details.
+***************************************************************************************/
+
+
+#include <isa.h>
+#include <cpu/decode.h>
+#include <memory/paddr.h>
+#include <device/map.h>
+#include <time.h>
+#include <math.h>
+#include "sdb.h"
+
+/* Each function is timed for NR_ROUND rounds of n calls after a warm-up
+ * round. The mean ns/op of the rounds is reported with its 95% confidence
+ * interval by the Student's t-distribution. */
+#define NR_ROUND 20
+#define T_95 2.093 // t of 95% with NR_ROUND - 1 degrees of freedom
+
+static volatile word_t sink;
+
+static uint64_t now_ns() {
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return (uint64_t)t.tv_sec * 1000000000 + t.tv_nsec;
+}
+
+static void bench(const char *name, void (*fn)(uint64_t), uint64_t n) {
+  double x[NR_ROUND], mean = 0, var = 0;
+  int i;
+  if (n == 0) n = 1;
+  fn(n / 10 + 1);
+  for (i = 0; i < NR_ROUND; i ++) {
+    uint64_t t0 = now_ns();
+    fn(n);
+    x[i] = (double)(now_ns() - t0) / n;
+    mean += x[i];
+  }
+  mean /= NR_ROUND;
+  for (i = 0; i < NR_ROUND; i ++) var += (x[i] - mean) * (x[i] - mean);
+  var /= NR_ROUND - 1;
+  printf("%-28s %10.2f ns/op  +- %.2f\n", name, mean, T_95 * sqrt(var / NR_ROUND));
+}
+
+/* Memory is written at the top of pmem, which is restored at the end. On
+ * riscv, it is filled with SCRATCH_INST instructions, twice the entries of
+ * the decode cache, so that each one misses when they are run in turn. */
+#define SCRATCH_SIZE (32 * 1024)
+#define SCRATCH_BASE (PMEM_RIGHT + 1 - SCRATCH_SIZE)
+
+#ifdef CONFIG_ISA_riscv
+#define SCRATCH_INST (SCRATCH_SIZE / 4)
+#define NOP 0x00000017 // auipc zero, 0
+
+static uint64_t scratch_idx = 0;
+
+static void exec_at(vaddr_t pc) {
+  Decode s = { .pc = pc, .snpc = pc };
+  isa_exec_once(&s);
+}
+
+static void bench_exec_hit(uint64_t n) {
+  while (n --) exec_at(SCRATCH_BASE);
+}
+
+static void bench_exec_miss(uint64_t n) {
+  while (n --) exec_at(SCRATCH_BASE + (scratch_idx ++ % SCRATCH_INST) * 4);
+}
+#endif
+
+static void bench_pattern_decode(uint64_t n) {
+  static const char *pat[] = {
+    "??????? ????? ????? ??? ????? 00101 11",
+    "0000000 00001 00000 000 00000 11100 11",
+  };
+  uint64_t key, mask, shift;
+  while (n --) {
+    // the pattern is hidden from constant folding
+    const char *volatile str = pat[n & 1];
+    pattern_decode(str, 38, &key, &mask, &shift);
+    sink = key ^ mask ^ shift;
+  }
+}
+
+static void bench_paddr_read(uint64_t n) {
+  while (n --) sink = paddr_read(CONFIG_MBASE + (n & 0xffc), 4);
+}
+
+static void bench_paddr_write(uint64_t n) {
+  while (n --) paddr_write(SCRATCH_BASE + (n & 0xffc), 4, n);
+}
+
+static paddr_t mmio_addr = 0;
+static IOMap *mmio_map = NULL;
+
+static void bench_mmio_read(uint64_t n) {
+  while (n --) sink = paddr_read(mmio_addr, 4);
+}
+
+static void bench_map_read(uint64_t n) {
+  while (n --) sink = map_read(mmio_addr, 4, mmio_map);
+}
+
+static void bench_expr(uint64_t n) {
+  char e[] = "*0x80000000 == (0x80000000 + 4 * 3) / 2 - 1";
+  bool success;
+  while (n --) sink = expr(e, &success);
+}
+
+static Expr *compiled = NULL;
+
+static void bench_expr_eval(uint64_t n) {
+  bool success;
+  while (n --) sink = expr_eval(compiled, &success);
+}
+
+#ifdef CONFIG_ITRACE
+void disassemble(char *str, int size, uint64_t pc, uint8_t *code, int nbyte);
+
+static void bench_disassemble(uint64_t n) {
+  static uint64_t pc = 0;
+  uint32_t inst = MUXDEF(CONFIG_ISA_riscv, NOP, 0);
+  char buf[128];
+  // a different pc each time misses the cache of disassemble()
+  while (n --) disassemble(buf, sizeof(buf), pc += 4, (uint8_t *)&inst, 4);
+}
+#endif
+
+IOMap* fetch_mmio_map(paddr_t addr);
+
+void hostbench(uint64_t n, paddr_t mmio) {
+  CPU_state saved_cpu = cpu;
+  static uint8_t saved[SCRATCH_SIZE];
+  memcpy(saved, guest_to_host(SCRATCH_BASE), SCRATCH_SIZE);
+
+  printf("%-28s %10s %14s\n", "function", "mean", "95% CI");
+  bench("pattern_decode", bench_pattern_decode, n);
+#ifdef CONFIG_ISA_riscv
+  int i;
+  for (i = 0; i < SCRATCH_INST; i ++) paddr_write(SCRATCH_BASE + i * 4, 4, NOP);
+  bench("isa_exec_once (cached)", bench_exec_hit, n);
+  bench("isa_exec_once (decoded)", bench_exec_miss, n);
+#endif
+  bench("paddr_read (pmem)", bench_paddr_read, n);
+  bench("paddr_write (pmem)", bench_paddr_write, n);
+  mmio_addr = mmio;
+  mmio_map = fetch_mmio_map(mmio);
+  if (mmio_map != NULL) {
+    bench("paddr_read (mmio)", bench_mmio_read, n);
+    bench("map_read", bench_map_read, n);
+  }
+  else printf("No MMIO at " FMT_PADDR ", skip it\n", mmio);
+  char e[] = "*0x80000000 == (0x80000000 + 4 * 3) / 2 - 1";
+  compiled = expr_compile(e);
+  bench("expr", bench_expr, n / 10);
+  if (compiled != NULL) bench("expr_eval (compiled)", bench_expr_eval, n);
+  free(compiled);
+  IFDEF(CONFIG_ITRACE, bench("disassemble", bench_disassemble, n / 10));
+
+  memcpy(guest_to_host(SCRATCH_BASE), saved, SCRATCH_SIZE);
+  paddr_host_written(SCRATCH_BASE, SCRATCH_SIZE);
+  cpu = saved_cpu;
+}
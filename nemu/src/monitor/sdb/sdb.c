@@ -17,13 +17,29 @@
 #include <cpu/cpu.h>
 #include <readline/readline.h>
 #include <readline/history.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <unistd.h>
 #include "sdb.h"
 #include <memory/vaddr.h>
 #include <memory/paddr.h>
+#include <memory/mtrace.h>
+#include <cpu/reverse.h>
+#include <cpu/hart.h>
+#include <cpu/lockstep.h>
 
 static int is_batch_mode = false;
+static int gdb_port = 0;
+
+/* In script mode, commands are read from a file without readline, and the
+ * result of each command is written to stdout as a line of JSON, with the
+ * text printed by the command captured into "output". Other messages only go
+ * to the log file. Commands add their own fields with SCRIPT_FIELD(). */
+static int script_fd = -1;
+static FILE *json_fp = NULL;
+static FILE *field_fp = NULL;
+#define SCRIPT_FIELD(...) do { if (field_fp != NULL) fprintf(field_fp, __VA_ARGS__); } while (0)
 
-void init_regex();
 void init_wp_pool();
 
 /* We use the `readline' library to provide more flexibility to read from stdin. */
@@ -54,11 +70,42 @@ static int _cmd_info_r()
   return 0;
 }
 
+// subcommand for cmd_info [info b]
+static int _cmd_info_b()
+{
+  bp_display();
+  return 0;
+}
+
+#ifdef CONFIG_REVERSE
+// subcommand for cmd_info [info c]
+static int _cmd_info_c()
+{
+  reverse_display();
+  return 0;
+}
+#endif
+
+#ifdef CONFIG_MULTI_HART
+// subcommand for cmd_info [info h]
+static int _cmd_info_h()
+{
+  hart_display();
+  return 0;
+}
+#endif
+
+// subcommand for cmd_info [info t]
+static int _cmd_info_t()
+{
+  vaddr_tlb_display();
+  return 0;
+}
+
 // subcommand for cmd_info [info w]
 static int _cmd_info_w()
 {
-  // TODO:
-
+  wp_display();
   return 0;
 }
 
@@ -96,6 +143,21 @@ end:
   return 0;
 }
 
+static int cmd_ff(char *args)
+{
+  void cpu_set_ff(uint64_t n);
+  extern uint64_t g_nr_guest_inst;
+  char *end;
+  uint64_t n = (args == NULL ? 0 : strtoull(args, &end, 0));
+  if (args == NULL || end == args || n <= g_nr_guest_inst) {
+    printf("Usage: ff N, with N larger than %" PRIu64 " instructions executed\n", g_nr_guest_inst);
+    return 0;
+  }
+  cpu_set_ff(n);
+  cpu_exec(n - g_nr_guest_inst);
+  return 0;
+}
+
 static int cmd_info(char *args)
 {
   int len;
@@ -117,6 +179,18 @@ static int cmd_info(char *args)
     _cmd_info_r();
   else if ('w' == *args)
     _cmd_info_w();
+  else if ('t' == *args)
+    _cmd_info_t();
+  else if ('b' == *args)
+    _cmd_info_b();
+#ifdef CONFIG_REVERSE
+  else if ('c' == *args)
+    _cmd_info_c();
+#endif
+#ifdef CONFIG_MULTI_HART
+  else if ('h' == *args)
+    _cmd_info_h();
+#endif
   else
     printf("unsupported subcommand \"%s\"\n", args);
 
@@ -124,11 +198,44 @@ end:
   return 0;
 }
 
+// return the number of bytes inside pmem from ADDR, up to LEN
+static size_t pmem_span(long addr, size_t len)
+{
+  if (addr < 0 || !in_pmem(addr))
+    return 0;
+  size_t avail = (size_t)PMEM_RIGHT - addr + 1;
+  return (len < avail ? len : avail);
+}
+
+/* The bytes are taken right from pmem, and the text is formatted into a
+ * large buffer written out at once, so that examining megabytes is fast. */
+static void hexdump(long addr, const uint8_t *host, size_t len)
+{
+  static const char hex[] = "0123456789abcdef";
+  static char buf[64 * 1024];
+  size_t pos = 0, i;
+
+  for (i = 0; i < len; i++)
+  {
+    if (pos > sizeof(buf) - 32)
+    {
+      fwrite(buf, 1, pos, stdout);
+      pos = 0;
+    }
+    if (i % 8 == 0)
+      pos += sprintf(buf + pos, "\n0x%lx: ", addr + (long)i);
+    memcpy(buf + pos, "0x..   ", 7);
+    buf[pos + 2] = hex[host[i] >> 4];
+    buf[pos + 3] = hex[host[i] & 0xf];
+    pos += 7;
+  }
+  fwrite(buf, 1, pos, stdout);
+}
+
 static int cmd_x(char *args)
 {
   char *arg1, *arg2, *endptr;
   long int pr_num, pr_addr;
-  int group_num, i, j, out_of_pmem_flag = 0;
 
   if (!args)
     goto param_unsupported;
@@ -143,34 +250,73 @@ static int cmd_x(char *args)
   pr_addr = strtol(arg2, &endptr, 16);
   if (*endptr != '\0')
     goto param_unsupported;
+  if (pr_num < 0)
+    pr_num = 0;
 
-  group_num = pr_num / 8;
-  if (pr_num % 8)
-    group_num += 1;
+  size_t len = pmem_span(pr_addr, pr_num);
+  const uint8_t *host = (len > 0 ? guest_to_host(pr_addr) : NULL);
+  hexdump(pr_addr, host, len);
+  if (len < pr_num)
+  {
+    if (len % 8 == 0)
+      printf("\n0x%lx: ", pr_addr + (long)len);
+    printf("[PMEM OUT OF LIMIT]");
+  }
+  printf("\n\n");
 
-  for (i = 0; i < group_num; i++)
+  if (field_fp != NULL)
   {
-    printf("\n0x%lx: ", pr_addr + (i * 8));
+    SCRIPT_FIELD(",\"addr\":%ld,\"data\":[", pr_addr);
+    for (size_t i = 0; i < len; i++)
+      SCRIPT_FIELD("%s%u", (i == 0 ? "" : ","), (unsigned)host[i]);
+    SCRIPT_FIELD("]");
+  }
 
-    for (j = 0; j < 8; j++)
-    {
-      if (!in_pmem(pr_addr + (i * 8) + j))
-      {
-        out_of_pmem_flag = 1;
-        break;
-      }
+  return 0;
 
-      printf("0x%02x   ", vaddr_read(pr_addr + (i * 8) + j, 1));
-    }
+param_unsupported:
+  printf("unsupported command params\n");
+  return 0;
+}
 
-    if (out_of_pmem_flag)
-    {
-      printf("[PMEM OUT OF LIMIT]");
-      break;
-    }
+static int cmd_dump(char *args)
+{
+  char *arg1 = strtok(NULL, " ");
+  char *arg2 = strtok(NULL, " ");
+  char *arg3 = strtok(NULL, " ");
+  char *endptr1, *endptr2;
+
+  if (!arg1 || !arg2 || !arg3)
+    goto param_unsupported;
+
+  long addr = strtol(arg1, &endptr1, 0);
+  size_t len = strtoul(arg2, &endptr2, 0);
+  if (*endptr1 != '\0' || *endptr2 != '\0')
+    goto param_unsupported;
+
+  if (pmem_span(addr, len) < len)
+  {
+    printf("[0x%lx, 0x%lx) is not inside pmem\n", addr, addr + (long)len);
+    return 0;
   }
-  printf("\n\n");
 
+  FILE *fp = fopen(arg3, "wb");
+  if (fp == NULL)
+  {
+    printf("can not open \"%s\"\n", arg3);
+    return 0;
+  }
+  size_t n = 0;
+  if (len > 0)
+  {
+    paddr_host_access(addr, len);
+    n = fwrite(guest_to_host(addr), 1, len, fp);
+  }
+  if (fclose(fp) != 0 || n < len)
+    printf("can not write \"%s\"\n", arg3);
+  else
+    printf("dumped %zu bytes at 0x%lx to \"%s\"\n", len, addr, arg3);
+  SCRIPT_FIELD(",\"bytes\":%zu", n);
   return 0;
 
 param_unsupported:
@@ -180,97 +326,413 @@ param_unsupported:
 
 static int cmd_p(char *args)
 {
-  // TODO:
+  bool success;
+  word_t result;
+
+  if (!args)
+    goto param_unsupported;
 
+  result = expr(args, &success);
+  if (!success)
+  {
+    printf("can not evaluate the expression\n");
+    return 0;
+  }
+  printf("%" PRIu64 " (" FMT_WORD ")\n", (uint64_t)result, result);
+  SCRIPT_FIELD(",\"value\":%" PRIu64, (uint64_t)result);
+
+  return 0;
+
+param_unsupported:
+  printf("unsupported command params\n");
   return 0;
 }
 
 static int cmd_w(char *args)
 {
-  // TODO:
+  int NO;
+
+  if (!args)
+    goto param_unsupported;
+
+  NO = wp_new(args);
+  if (NO >= 0)
+  {
+    printf("Watchpoint %d: %s\n", NO, args);
+    SCRIPT_FIELD(",\"id\":%d", NO);
+  }
 
   return 0;
+
+param_unsupported:
+  printf("unsupported command params\n");
+  return 0;
+}
+
+static int cmd_b(char *args)
+{
+  char *endptr;
+  bool success;
+  vaddr_t pc;
+  word_t size;
+  long int NO;
+  int ret;
+
+  if (!args)
+    goto param_unsupported;
+
+  if (0 == strcmp(args, "clear"))
+  {
+    bp_clear();
+    return 0;
+  }
+
+  if (0 == strncmp(args, "delete ", 7))
+  {
+    NO = strtol(args + 7, &endptr, 10);
+    if (*endptr != '\0')
+      goto param_unsupported;
+    if (!bp_delete(NO))
+      printf("No breakpoint number %ld.\n", NO);
+    return 0;
+  }
+
+  // a symbol of --elf, or an expression
+  if (!symbol_find(args, &pc, &size))
+  {
+    pc = expr(args, &success);
+    if (!success)
+    {
+      printf("can not evaluate the address\n");
+      return 0;
+    }
+  }
+
+  ret = bp_new(pc);
+  if (ret < 0)
+    printf("too many breakpoints\n");
+  else
+    printf("Breakpoint %d at " FMT_WORD "\n", ret, pc);
+
+  return 0;
+
+param_unsupported:
+  printf("unsupported command params\n");
+  return 0;
 }
 
 static int cmd_d(char *args)
 {
-  // TODO:
+  char *endptr;
+  long int NO;
+
+  if (!args)
+    goto param_unsupported;
+
+  NO = strtol(args, &endptr, 10);
+  if (*endptr != '\0')
+    goto param_unsupported;
+
+  if (!wp_delete(NO))
+    printf("No watchpoint number %ld.\n", NO);
 
   return 0;
+
+param_unsupported:
+  printf("unsupported command params\n");
+  return 0;
 }
 
+/* Check expr() with the lines of "RESULT EXPR" in a file, or a stream from
+ * stdin with "-", such as the output of tools/gen-expr. The default mode
+ * shows each expression and stops at the first failure. "batch" only shows
+ * the failures and a summary at the end, and "bench" only the summary. */
 static int cmd_test_expr(char *args)
 {
-  char file_path[] = "./tools/gen-expr/build/input";
-  FILE *file;
-  char *line = NULL;
-  bool success;
-  size_t len = 0;
-  ssize_t read;
-  int line_no = 0;
-  char *expr_result, *expr_str;
-  unsigned int result, need_result;
-  int ret = 0;
+  enum { VERBOSE, BATCH, BENCH } mode = VERBOSE;
+  const char *file_path = "./tools/gen-expr/build/input";
+  char *arg;
+  for (arg = strtok(args, " "); arg != NULL; arg = strtok(NULL, " "))
+  {
+    if (strcmp(arg, "bench") == 0)
+      mode = BENCH;
+    else if (strcmp(arg, "batch") == 0)
+      mode = BATCH;
+    else
+      file_path = arg;
+  }
 
-  file = fopen(file_path, "r");
+  FILE *file = (strcmp(file_path, "-") == 0 ? stdin : fopen(file_path, "r"));
   if (file == NULL)
   {
-    perror("cannot open ./tools/gen-expr/build/input");
-    ret = -1;
-    goto ret;
+    printf("cannot open %s: %s\n", file_path, strerror(errno));
+    return 0;
   }
 
+  char *line = NULL;
+  size_t len = 0;
+  ssize_t read;
+  uint64_t line_no = 0, nr_fail = 0, start = get_time();
+  int ret = 0;
+
   while ((read = getline(&line, &len, file)) > 0)
   {
     line_no++;
+    line[strcspn(line, "\n")] = '\0';
 
-    line[read-1] = '\0';
-
-    printf("lineNo:%d;\n\n", line_no);
-
-    expr_result = strtok(line, " ");
-    if(NULL == expr_result) {
-      printf("wrong expr result:(%s)\n", line);
-      ret = -1;
-      goto readline_end;
+    char *expr_result = strtok(line, " ");
+    char *expr_str = strtok(NULL, " ");
+    if (expr_str == NULL)
+    {
+      printf("line %" PRIu64 ": wrong format: (%s)\n", line_no, line);
+      nr_fail++;
+      if (mode == VERBOSE)
+        break;
+      continue;
     }
-    need_result = atoi(expr_result);
+    word_t need_result = strtoull(expr_result, NULL, 0);
 
-    expr_str = strtok(NULL, " ");
-    if(NULL == expr_str) {
-      printf("wrong expr str:(%s)\n", line);
-      ret = -1;
-      goto readline_end;
+    if (mode == VERBOSE)
+    {
+      printf("lineNo:%" PRIu64 ";\n\n", line_no);
+      printf("\033[36mexpr:%s; start calc...\033[0m\n\n", expr_str);
     }
 
-    printf("\033[36mexpr:%s; start calc...\033[0m\n\n", expr_str);
+    bool success;
+    word_t result = expr(expr_str, &success);
+    bool pass = success && result == need_result;
+    nr_fail += !pass;
 
-    result = expr(expr_str, &success);
-
-    printf("\ncalc:%u; expected:%u;\n\n", result, need_result);
+    if (mode == BATCH && !pass)
+    {
+      printf("line %" PRIu64 ": %s = %" PRIu64 ", expected %" PRIu64 "%s\n", line_no, expr_str,
+          (uint64_t)result, (uint64_t)need_result, (success ? "" : " (failed to evaluate)"));
+    }
+    if (mode != VERBOSE)
+      continue;
 
-    if(result == need_result) {
+    printf("\ncalc:%" PRIu64 "; expected:%" PRIu64 ";\n\n", (uint64_t)result, (uint64_t)need_result);
+    if (pass)
+    {
       printf("\n\033[32mcalc succeed!\033[0m\n\n");
       printf("---------------------------------------------------------------\n");
-    } else {
+    }
+    else
+    {
       printf("\n\033[31mcalc failed!\033[0m\n\n");
       printf("---------------------------------------------------------------\n");
       ret = -1;
-      goto readline_end;
-    }
-
-readline_end:
-    free(line);
-    line = NULL;
-    if(-1 == ret)
       break;
+    }
   }
+  free(line);
 
-  printf("end-of-file\n");
-  fclose(file);
-ret:
+  if (mode != VERBOSE)
+  {
+    uint64_t us = get_time() - start;
+    printf("%" PRIu64 " expressions in %" PRIu64 " us, %" PRIu64 " failed, %.0f expressions/s\n",
+        line_no, us, nr_fail, (us == 0 ? 0 : line_no * 1e6 / us));
+  }
+  else
+    printf("end-of-file\n");
+  SCRIPT_FIELD(",\"nr_expr\":%" PRIu64 ",\"nr_fail\":%" PRIu64, line_no, nr_fail);
+  if (file != stdin)
+    fclose(file);
   return ret;
 }
+static int cmd_trace(char *args)
+{
+  extern bool g_trace_on;
+  void set_trace(bool on);
+
+  char *arg1 = strtok(NULL, " ");
+  if (!arg1)
+    goto end;
+
+  if (0 == strcmp(arg1, "on"))
+    set_trace(true);
+  else if (0 == strcmp(arg1, "off"))
+    set_trace(false);
+  else if (0 == strcmp(arg1, "window"))
+  {
+    char *kind = strtok(NULL, " ");
+    if (kind && 0 == strcmp(kind, "clear"))
+      trace_window_clear();
+    else if (kind)
+    {
+      char *a = strtok(NULL, " ");
+      char *b = strtok(NULL, " ");
+      const char *err = trace_window_arm(kind, a, b);
+      if (err)
+        printf("%s\n", err);
+    }
+    trace_window_display();
+    return 0;
+  }
+  else
+    printf("unsupported argument \"%s\"\n", arg1);
+
+end:
+  printf("trace is %s\n", g_trace_on ? "on" : "off");
+  return 0;
+}
+
+#ifdef CONFIG_MTRACE
+static int cmd_mtrace(char *args)
+{
+  char *arg1, *arg2, *arg3, *endptr;
+  word_t lo, hi;
+
+  arg1 = strtok(NULL, " ");
+  if (!arg1)
+    goto end;
+
+  if (0 == strcmp(arg1, "on"))
+  {
+    arg2 = strtok(NULL, " ");
+    if (!mtrace_start(arg2 ? arg2 : "build/mtrace.bin"))
+      printf("can not open \"%s\"\n", arg2 ? arg2 : "build/mtrace.bin");
+  }
+  else if (0 == strcmp(arg1, "off"))
+    mtrace_stop();
+  else if (0 == strcmp(arg1, "clear"))
+    mtrace_clear_filter();
+  else if (0 == strcmp(arg1, "addr") || 0 == strcmp(arg1, "pc"))
+  {
+    arg2 = strtok(NULL, " ");
+    arg3 = strtok(NULL, " ");
+    if (!arg2 || !arg3)
+      goto param_unsupported;
+
+    lo = strtoull(arg2, &endptr, 0);
+    if (*endptr != '\0')
+      goto param_unsupported;
+    hi = strtoull(arg3, &endptr, 0);
+    if (*endptr != '\0')
+      goto param_unsupported;
+
+    if (!mtrace_add_filter(0 == strcmp(arg1, "pc"), lo, hi))
+      printf("can not add the range\n");
+  }
+  else
+    goto param_unsupported;
+
+end:
+  mtrace_display();
+  return 0;
+
+param_unsupported:
+  printf("unsupported command params\n");
+  return 0;
+}
+#endif
+
+#ifdef CONFIG_REVERSE
+static int cmd_rsi(char *args)
+{
+  char *endptr;
+  uint64_t step = 1;
+
+  if (args)
+  {
+    step = strtoull(args, &endptr, 0);
+    if (*endptr != '\0' || step == 0)
+    {
+      printf("step(%s) is ilegel\n", args);
+      return 0;
+    }
+  }
+
+  if (reverse_step(step))
+    printf("pc = " FMT_WORD ", instruction %" PRIu64 "\n", cpu.pc, reverse_icount());
+  return 0;
+}
+
+static int cmd_rc(char *args)
+{
+  if (reverse_continue())
+    printf("pc = " FMT_WORD ", instruction %" PRIu64 "\n", cpu.pc, reverse_icount());
+  return 0;
+}
+#endif
+
+#ifdef CONFIG_SNAPSHOT
+bool snapshot_save(const char *file);
+bool snapshot_load(const char *file);
+int snapshot_fork();
+void snapshot_fork_load();
+
+static int cmd_save(char *args)
+{
+  char *arg1 = strtok(NULL, " ");
+
+  if (!arg1)
+  {
+    int ret = snapshot_fork();
+    if (ret == 0)
+      printf("snapshot saved at pc = " FMT_WORD "\n", cpu.pc);
+    else if (ret > 0)
+    {
+      // this is the copy frozen by "save", resumed by "load"
+      printf("snapshot loaded, pc = " FMT_WORD "\n", cpu.pc);
+      SCRIPT_FIELD(",\"resumed\":true");
+    }
+    return 0;
+  }
+
+  if (snapshot_save(arg1))
+    printf("snapshot saved to \"%s\" at pc = " FMT_WORD "\n", arg1, cpu.pc);
+  else
+    printf("can not save snapshot to \"%s\"\n", arg1);
+  return 0;
+}
+
+static int cmd_load(char *args)
+{
+  char *arg1 = strtok(NULL, " ");
+
+  if (!arg1)
+  {
+    // only returns if there is no snapshot
+    snapshot_fork_load();
+    return 0;
+  }
+
+  if (snapshot_load(arg1))
+    printf("snapshot loaded from \"%s\", pc = " FMT_WORD "\n", arg1, cpu.pc);
+  else
+    printf("can not load snapshot from \"%s\"\n", arg1);
+  return 0;
+}
+#endif
+
+#ifdef CONFIG_GDBSTUB
+static int cmd_gdb(char *args)
+{
+  char *arg1 = strtok(NULL, " ");
+  int port = (arg1 ? atoi(arg1) : 1234);
+  gdbstub_serve(port);
+  return (nemu_state.state == NEMU_QUIT ? -1 : 0);
+}
+#endif
+
+#ifdef CONFIG_HOSTBENCH
+void hostbench(uint64_t n, paddr_t mmio);
+
+static int cmd_hostbench(char *args)
+{
+  char *arg1 = strtok(NULL, " ");
+  char *arg2 = strtok(NULL, " ");
+  uint64_t n = (arg1 ? strtoull(arg1, NULL, 0) : 100000);
+  paddr_t mmio = (arg2 ? strtoul(arg2, NULL, 0) : MUXDEF(CONFIG_HAS_TIMER, CONFIG_RTC_MMIO, 0));
+  if (n == 0) {
+    printf("Bad number of calls '%s'\n", arg1);
+    return 0;
+  }
+  hostbench(n, mmio);
+  return 0;
+}
+#endif
 /* command implemetion end */
 
 static int cmd_help(char *args);
@@ -287,19 +749,63 @@ static struct
     {"si", "si [N], let the program execute N instructions and then pause execution. \
 When N is not given, the default is 1. (for example: si 10)",
      cmd_si},
-    {"info", "[info r]/ [info w], print program info. (r: register info; w: watch point info;)", cmd_info},
+    {"ff", "ff N, run the untraced loop without breakpoints and watchpoints until N instructions \
+are executed, then attach DiffTest again and stop. (for example: ff 10000000000)", cmd_ff},
+    {"info", "[info r]/ [info w]/ [info b]/ [info t], print program info. (r: register info; w: watch point info; \
+b: breakpoint info; t: soft TLB statistics; c: checkpoints of reverse execution; h: harts;)", cmd_info},
     {"x", "x [N] [EXPR], calc the result value of the EXPR as the starting memory \
 address, output N consecutive 4 bytes in hex form. (for example: x 10 $esp){x86 program start with 0x100000}",
      cmd_x},
     {"p", "p [EXPR], calc the value of the expression EXPR. (for example: p $eax + 1)", cmd_p},
-    {"w", "w [EXPR], when the value of expression EXPR changes, program execution is paused. (for \
-example: w *0x2000)",
+    {"w", "w [EXPR], when the value of expression EXPR changes, program execution is paused \
+after the instruction changing it. EXPR only reading pmem at constant addresses is checked on writes to it, \
+others are checked after each instruction. (for example: w *0x80001000 + *0x80001004, w $a0 == 0)",
      cmd_w},
+    {"trace", "trace [on|off], switch between the traced and the untraced (faster) \
+execution loops. Sending SIGUSR1 to NEMU also switches them. \
+trace window [inst LO HI|pc LO HI|sym NAME|clear], only enable the log inside the windows, \
+and run the traced loop only inside the windows by instruction count. \
+(for example: trace window inst 5000000000 5000100000)", cmd_trace},
+#ifdef CONFIG_MTRACE
+    {"mtrace", "mtrace [on [FILE]|off|addr LO HI|pc LO HI|clear], trace memory accesses into \
+FILE (build/mtrace.bin by default), only those inside the given address and PC ranges if any. \
+(for example: mtrace addr 0x80000000 0x80000fff)", cmd_mtrace},
+#endif
+#ifdef CONFIG_REVERSE
+    {"rsi", "rsi [N], go back N instructions, 1 by default, by replaying from the \
+last checkpoint before. (for example: rsi 10)", cmd_rsi},
+    {"rc", "rc, go back to the last stop by a breakpoint or a watchpoint. \
+info c shows the checkpoints kept.", cmd_rc},
+#endif
+#ifdef CONFIG_SNAPSHOT
+    {"save", "save [FILE], save a snapshot of the registers, memory and devices into FILE. \
+Without FILE, the snapshot is kept by a frozen copy of NEMU, which is fast. (for example: save build/a.snap)", cmd_save},
+    {"load", "load [FILE], load the snapshot saved into FILE, or the last one saved without FILE, \
+which can be loaded again.", cmd_load},
+#endif
+#ifdef CONFIG_GDBSTUB
+    {"gdb", "gdb [PORT], wait for gdb to connect to PORT (1234 by default), and serve it \
+until it detaches. The breakpoints and watchpoints set by gdb are those of sdb. \
+(for example: gdb 1234, then (gdb) target remote :1234)", cmd_gdb},
+#endif
+#ifdef CONFIG_HOSTBENCH
+    {"hostbench", "hostbench [N] [MMIO], time the hot functions of NEMU on the host by rounds of N calls \
+(100000 by default), reading the device at MMIO (the rtc by default), and report ns per call. \
+The registers and memory used are restored. (for example: hostbench 1000000)", cmd_hostbench},
+#endif
+    {"b", "b [ADDR|SYMBOL], stop before executing the instruction at the address ADDR or the \
+function SYMBOL of --elf. b delete [N], delete the breakpoint N. b clear, delete all breakpoints. \
+(for example: b main)", cmd_b},
+    {"dump", "dump ADDR LEN FILE, write LEN bytes of pmem from ADDR into FILE in binary. \
+(for example: dump 0x80000000 0x4000000 build/pmem.bin)", cmd_dump},
     {"d", "d [N], delete the monitoring point with serial number N. (for example: d 2)", cmd_d},
     {"test_expr", "read file from ./tools/gen-expr/build/input then calc expr line by line, you need do as follows first:\n\
             1) in src/monitor/sdb/expr.c, set EXPR_UNIT_TEST_ENABLED to 1 to enable reg/deref testcase. \n\
             2) do ($ cp resource/input tools/gen-expr/build/) to use default testcase. \n\
-            3) do ($ ./gen-expr 100 > input) to run more testcase.", cmd_test_expr},
+            3) do ($ ./gen-expr 100 > input) to run more testcase.\n\
+            test_expr [bench|batch] [FILE], read FILE instead, or stdin with \"-\". batch only reports \
+the failures and a summary, bench only the number of expressions calculated per second. \
+(for example: ./build/gen-expr -j 8 1000000 | nemu -S script, with \"test_expr batch -\" in script)", cmd_test_expr},
 };
 
 #define NR_CMD ARRLEN(cmd_table)
@@ -338,64 +844,207 @@ void sdb_set_batch_mode()
   is_batch_mode = true;
 }
 
-void sdb_mainloop()
+void sdb_set_gdb(int port)
 {
-  if (is_batch_mode)
+  gdb_port = port;
+}
+
+// return -1 to exit NEMU, 1 for an unknown command, and 0 otherwise
+static int sdb_exec(char *str)
+{
+  char *str_end = str + strlen(str);
+
+  /* extract the first token as the command */
+  char *cmd = strtok(str, " ");
+  if (cmd == NULL)
   {
-    cmd_c(NULL);
-    return;
+    return 0;
   }
 
-  for (char *str; (str = rl_gets()) != NULL;)
+  /* treat the remaining string as the arguments,
+   * which may need further parsing
+   */
+  char *args = cmd + strlen(cmd) + 1;
+  if (args >= str_end)
   {
-    char *str_end = str + strlen(str);
+    args = NULL;
+  }
 
-    /* extract the first token as the command */
-    char *cmd = strtok(str, " ");
-    if (cmd == NULL)
-    {
-      continue;
-    }
+#ifdef CONFIG_DEVICE
+  extern void sdl_clear_event_queue();
+  sdl_clear_event_queue();
+#endif
 
-    /* treat the remaining string as the arguments,
-     * which may need further parsing
-     */
-    char *args = cmd + strlen(cmd) + 1;
-    if (args >= str_end)
+  int i;
+  for (i = 0; i < NR_CMD; i++)
+  {
+    if (strcmp(cmd, cmd_table[i].name) == 0)
     {
-      args = NULL;
+      return (cmd_table[i].handler(args) < 0 ? -1 : 0);
     }
+  }
 
-#ifdef CONFIG_DEVICE
-    extern void sdl_clear_event_queue();
-    sdl_clear_event_queue();
+  printf("Unknown command '%s'\n", cmd);
+  return 1;
+}
+
+void sdb_set_script(const char *file)
+{
+  script_fd = (strcmp(file, "-") == 0 ? dup(STDIN_FILENO) : open(file, O_RDONLY));
+  Assert(script_fd >= 0, "Can not open script '%s'", file);
+  // stdout only carries the results
+  json_fp = fdopen(dup(STDOUT_FILENO), "w");
+  assert(json_fp);
+  fflush(stdout);
+  FILE *fp = freopen("/dev/null", "w", stdout);
+  assert(fp);
+}
+
+/* Lines are read byte by byte, so that the offset of the script is right
+ * after the command being executed, which is shared by the copies of NEMU
+ * forked for snapshots. */
+static bool script_getline(char *buf, int size)
+{
+  int len = 0;
+  char c;
+  while (read(script_fd, &c, 1) == 1)
+  {
+    if (c == '\n')
+      break;
+    if (len < size - 1)
+      buf[len++] = c;
+  }
+  buf[len] = '\0';
+  return len > 0 || c == '\n';
+}
+
+static void json_string(FILE *fp, const char *s)
+{
+  fputc('"', fp);
+  for (; *s; s++)
+  {
+    unsigned char c = *s;
+    if (c == '"' || c == '\\')
+      fprintf(fp, "\\%c", c);
+    else if (c == '\n')
+      fputs("\\n", fp);
+    else if (c < 0x20)
+      fprintf(fp, "\\u%04x", c);
+    else
+      fputc(c, fp);
+  }
+  fputc('"', fp);
+}
+
+static const char *state_name()
+{
+  static const char *name[] = {
+      [NEMU_RUNNING] = "running", [NEMU_STOP] = "stop", [NEMU_END] = "end",
+      [NEMU_ABORT] = "abort", [NEMU_QUIT] = "quit"};
+  return name[nemu_state.state];
+}
+
+static void script_mainloop()
+{
+  extern uint64_t g_nr_guest_inst;
+  void statistic_json(FILE *fp);
+  char line[4096];
+
+  while (script_getline(line, sizeof(line)))
+  {
+    char *str = line + strspn(line, " \t\r");
+    str[strcspn(str, "\r")] = '\0';
+    if (*str == '\0' || *str == '#')
+      continue;
+
+    char *cmd = strdup(str);
+    char *output = NULL, *fields = NULL;
+    size_t output_size = 0, fields_size = 0;
+    FILE *saved = stdout;
+    fflush(stdout);
+    stdout = open_memstream(&output, &output_size);
+    field_fp = open_memstream(&fields, &fields_size);
+    assert(stdout && field_fp);
+    int ret = sdb_exec(str);
+    fclose(stdout);
+    stdout = saved;
+    fclose(field_fp);
+    field_fp = NULL;
+
+    fputs("{\"cmd\":", json_fp);
+    json_string(json_fp, cmd);
+    fprintf(json_fp, ",\"ok\":%s,\"output\":", (ret == 1 ? "false" : "true"));
+    json_string(json_fp, output);
+    fprintf(json_fp, ",\"pc\":%" PRIu64 ",\"inst\":%" PRIu64 ",\"state\":\"%s\"%s}\n",
+        (uint64_t)cpu.pc, g_nr_guest_inst, state_name(), fields);
+    fflush(json_fp);
+    free(cmd);
+    free(output);
+    free(fields);
+    if (ret < 0)
+      break;
+  }
+
+  // reaching the end of the script is like "q"
+  if (nemu_state.state == NEMU_RUNNING || nemu_state.state == NEMU_STOP)
+    nemu_state.state = NEMU_QUIT;
+  fputs("{\"statistic\":", json_fp);
+  statistic_json(json_fp);
+  fprintf(json_fp, ",\"state\":\"%s\",\"halt_ret\":%d}\n", state_name(), nemu_state.halt_ret);
+  fflush(json_fp);
+}
+
+void sdb_mainloop()
+{
+#ifdef CONFIG_FARM
+  bool farm_run();
+  if (farm_run())
+  {
+    return;
+  }
 #endif
 
-    int i;
-    for (i = 0; i < NR_CMD; i++)
+#ifdef CONFIG_LOCKSTEP
+  if (lockstep_run())
+  {
+    return;
+  }
+#endif
+
+  if (script_fd >= 0)
+  {
+    script_mainloop();
+    return;
+  }
+
+#ifdef CONFIG_GDBSTUB
+  if (gdb_port != 0)
+  {
+    gdbstub_serve(gdb_port);
+    if (nemu_state.state == NEMU_QUIT)
     {
-      if (strcmp(cmd, cmd_table[i].name) == 0)
-      {
-        if (cmd_table[i].handler(args) < 0)
-        {
-          return;
-        }
-        break;
-      }
+      return;
     }
+  }
+#endif
+
+  if (is_batch_mode)
+  {
+    cmd_c(NULL);
+    return;
+  }
 
-    if (i == NR_CMD)
+  for (char *str; (str = rl_gets()) != NULL;)
+  {
+    if (sdb_exec(str) < 0)
     {
-      printf("Unknown command '%s'\n", cmd);
+      return;
     }
   }
 }
 
 void init_sdb()
 {
-  /* Compile the regular expressions. */
-  init_regex();
-
   /* Initialize the watchpoint pool. */
   init_wp_pool();
 }
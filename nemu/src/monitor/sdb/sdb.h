@@ -20,4 +20,22 @@
 
 word_t expr(char *e, bool *success);
 
+typedef struct Expr Expr;
+// the result is freed by free()
+Expr* expr_compile(char *e);
+word_t expr_eval(const Expr *c, bool *success);
+int expr_mem_deps(const Expr *c, paddr_t *addr, int n);
+
+int wp_new(char *e);
+bool wp_delete(int NO);
+void wp_display();
+
+int bp_new(vaddr_t pc);
+int bp_find(vaddr_t pc);
+bool bp_delete(int NO);
+void bp_clear();
+void bp_display();
+
+void gdbstub_serve(int port);
+
 #endif
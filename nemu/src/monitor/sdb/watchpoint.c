@@ -14,15 +14,30 @@
 ***************************************************************************************/
 
 #include "sdb.h"
+#include <memory/host.h>
+#include <memory/paddr.h>
+#include <device/replay.h>
 
 #define NR_WP 32
 
+/* A watchpoint is an expression compiled once. If it only reads words of
+ * pmem at constant addresses, it is not evaluated after every instruction.
+ * The pages of these words are flagged in pmem_watch_page[] instead, and
+ * only writes to them call wp_check_write(), which evaluates the
+ * expressions reading the words written. Other expressions, such as those
+ * reading registers, have `nr_dep` being -1, and are evaluated by
+ * wp_check_each() after each instruction while any of them is set. */
+#define WP_MAX_DEPS 8
+
 typedef struct watchpoint {
   int NO;
   struct watchpoint *next;
 
-  /* TODO: Add more members if necessary */
-
+  Expr *e;
+  char *str;
+  word_t old;
+  int nr_dep;
+  paddr_t dep[WP_MAX_DEPS];
 } WP;
 
 static WP wp_pool[NR_WP] = {};
@@ -39,5 +54,153 @@ void init_wp_pool() {
   free_ = wp_pool;
 }
 
-/* TODO: Implement the functionality of watchpoint */
+#ifdef CONFIG_WATCHPOINT
+bool pmem_watch_page[CONFIG_MSIZE / PAGE_SIZE] = {};
+bool wp_active = false;
+int wp_nr_each = 0;
+
+static void wp_mark_pages() {
+  memset(pmem_watch_page, 0, sizeof(pmem_watch_page));
+  wp_active = (head != NULL);
+  wp_nr_each = 0;
+  WP *wp;
+  int i;
+  for (wp = head; wp != NULL; wp = wp->next) {
+    wp_nr_each += (wp->nr_dep < 0);
+    for (i = 0; i < wp->nr_dep; i ++) {
+      pmem_watch_page[(wp->dep[i] - CONFIG_MBASE) >> PAGE_SHIFT] = true;
+      pmem_watch_page[(wp->dep[i] + sizeof(word_t) - 1 - CONFIG_MBASE) >> PAGE_SHIFT] = true;
+    }
+  }
+}
+
+int wp_new(char *str) {
+  Expr *e = expr_compile(str);
+  if (e == NULL) return -1;
+  WP *wp = free_;
+  bool success;
+  paddr_t dep[WP_MAX_DEPS];
+  int nr_dep = expr_mem_deps(e, dep, WP_MAX_DEPS), i;
+  word_t val = expr_eval(e, &success);
+  if (nr_dep == 0) {
+    printf("the expression is constant\n");
+    goto fail;
+  }
+  for (i = 0; i < nr_dep; i ++) {
+    if (!in_pmem(dep[i]) || !in_pmem(dep[i] + sizeof(word_t) - 1)) {
+      printf("address " FMT_PADDR " is not in pmem\n", dep[i]);
+      goto fail;
+    }
+  }
+  if (!success) {
+    printf("can not evaluate the expression\n");
+    goto fail;
+  }
+  if (wp == NULL) {
+    printf("too many watchpoints\n");
+    goto fail;
+  }
+  free_ = wp->next;
+  wp->next = head;
+  head = wp;
+  wp->e = e;
+  wp->str = strdup(str);
+  wp->old = val;
+  wp->nr_dep = nr_dep;
+  memcpy(wp->dep, dep, sizeof(dep));
+  wp_mark_pages();
+  return wp->NO;
+
+fail:
+  free(e);
+  return -1;
+}
+
+bool wp_delete(int NO) {
+  WP **p;
+  for (p = &head; *p != NULL; p = &(*p)->next) {
+    if ((*p)->NO == NO) {
+      WP *wp = *p;
+      *p = wp->next;
+      free(wp->e);
+      free(wp->str);
+      wp->next = free_;
+      free_ = wp;
+      wp_mark_pages();
+      return true;
+    }
+  }
+  return false;
+}
+
+void wp_display() {
+  if (head == NULL) {
+    printf("No watchpoints.\n");
+    return;
+  }
+  printf("Num  What\n");
+  WP *wp;
+  for (wp = head; wp != NULL; wp = wp->next) {
+    printf("%-4d %s = " FMT_WORD "\n", wp->NO, wp->str, wp->old);
+  }
+}
+
+static void wp_update(WP *wp) {
+  bool success;
+  word_t val = expr_eval(wp->e, &success);
+  if (!success || val == wp->old) return;
+  if (!MUXDEF(CONFIG_REVERSE, reverse_replaying, false)) {
+    printf("\nWatchpoint %d: %s\n\nOld value = " FMT_WORD "\nNew value = " FMT_WORD "\n",
+        wp->NO, wp->str, wp->old, val);
+  }
+  wp->old = val;
+  // stop after the instruction changing it
+  if (nemu_state.state == NEMU_RUNNING) nemu_state.state = NEMU_STOP;
+}
+
+// called after [addr, addr + len) is written, if it touches a watched page
+void wp_check_write(paddr_t addr, size_t len) {
+  WP *wp;
+  for (wp = head; wp != NULL; wp = wp->next) {
+    int i;
+    for (i = 0; i < wp->nr_dep; i ++) {
+      if (wp->dep[i] < addr + len && wp->dep[i] + sizeof(word_t) > addr) break;
+    }
+    if (i < wp->nr_dep) wp_update(wp);
+  }
+}
+
+// called after each instruction if `wp_nr_each` is not 0
+void wp_check_each() {
+  WP *wp;
+  for (wp = head; wp != NULL; wp = wp->next) {
+    if (wp->nr_dep < 0) wp_update(wp);
+  }
+}
+
+/* Stop checking writes while fast-forwarding. On resuming, the values are
+ * taken as they are, without reporting the changes in between. */
+void wp_suspend(bool suspend) {
+  if (suspend) {
+    memset(pmem_watch_page, 0, sizeof(pmem_watch_page));
+    wp_active = false;
+    wp_nr_each = 0;
+    return;
+  }
+  WP *wp;
+  for (wp = head; wp != NULL; wp = wp->next) {
+    bool success;
+    wp->old = expr_eval(wp->e, &success);
+  }
+  wp_mark_pages();
+}
+#else
+int wp_new(char *e) {
+  printf("watchpoints are not enabled\n");
+  return -1;
+}
+
+bool wp_delete(int NO) { return false; }
+void wp_display() { printf("watchpoints are not enabled\n"); }
+#endif
 
@@ -17,26 +17,29 @@
 #include <capstone/capstone.h>
 #include <common.h>
 
-static size_t (*cs_disasm_dl)(csh handle, const uint8_t *code,
-    size_t code_size, uint64_t address, size_t count, cs_insn **insn);
-static void (*cs_free_dl)(cs_insn *insn, size_t count);
+static bool (*cs_disasm_iter_dl)(csh handle, const uint8_t **code,
+    size_t *size, uint64_t *address, cs_insn *insn);
 
 static csh handle;
+// reused by every disassembly, instead of allocating one by cs_disasm()
+static cs_insn *insn = NULL;
 
-void init_disasm() {
+// capstone is loaded on the first disassembly, which most runs never need
+static void init_disasm() {
   void *dl_handle;
   dl_handle = dlopen("tools/capstone/repo/libcapstone.so.5", RTLD_LAZY);
-  assert(dl_handle);
+  Assert(dl_handle, "%s, build it with `make -C tools/capstone'", dlerror());
 
   cs_err (*cs_open_dl)(cs_arch arch, cs_mode mode, csh *handle) = NULL;
   cs_open_dl = dlsym(dl_handle, "cs_open");
   assert(cs_open_dl);
 
-  cs_disasm_dl = dlsym(dl_handle, "cs_disasm");
-  assert(cs_disasm_dl);
+  cs_insn *(*cs_malloc_dl)(csh handle) = NULL;
+  cs_malloc_dl = dlsym(dl_handle, "cs_malloc");
+  assert(cs_malloc_dl);
 
-  cs_free_dl = dlsym(dl_handle, "cs_free");
-  assert(cs_free_dl);
+  cs_disasm_iter_dl = dlsym(dl_handle, "cs_disasm_iter");
+  assert(cs_disasm_iter_dl);
 
   cs_arch arch = MUXDEF(CONFIG_ISA_x86,      CS_ARCH_X86,
                    MUXDEF(CONFIG_ISA_mips32, CS_ARCH_MIPS,
@@ -57,15 +60,106 @@ void init_disasm() {
   ret = cs_option_dl(handle, CS_OPT_SYNTAX, CS_OPT_SYNTAX_ATT);
   assert(ret == CS_ERR_OK);
 #endif
+
+  insn = cs_malloc_dl(handle);
+  assert(insn != NULL);
 }
 
-void disassemble(char *str, int size, uint64_t pc, uint8_t *code, int nbyte) {
-	cs_insn *insn;
-	size_t count = cs_disasm_dl(handle, code, nbyte, pc, 0, &insn);
-  assert(count == 1);
+/* A direct-mapped cache of the results, since a traced loop disassembles
+ * the same instructions again and again. The pc is part of the key, since
+ * capstone shows the targets of branches as absolute addresses for some
+ * ISAs. */
+#define CACHE_SIZE 1024
+static struct {
+  uint64_t pc;
+  uint8_t code[16];
+  int nbyte; // 0 for an empty entry
+  char str[96]; // not shorter than the space left in a line of itrace
+} cache[CACHE_SIZE];
+
+static int cache_idx(uint64_t pc) {
+  return (pc ^ (pc >> 10)) % CACHE_SIZE;
+}
+
+static void format_insn(char *str, int size) {
   int ret = snprintf(str, size, "%s", insn->mnemonic);
   if (insn->op_str[0] != '\0') {
     snprintf(str + ret, size - ret, "\t%s", insn->op_str);
   }
-  cs_free_dl(insn, count);
+}
+
+// disassemble one instruction at the beginning of `code` into `insn`
+static bool disassemble_one(uint64_t pc, const uint8_t *code, int nbyte) {
+  if (unlikely(insn == NULL)) init_disasm();
+  size_t size = nbyte;
+  return cs_disasm_iter_dl(handle, &code, &size, &pc, insn);
+}
+
+static void cache_fill(int idx, uint64_t pc, const uint8_t *code, int nbyte) {
+  format_insn(cache[idx].str, sizeof(cache[idx].str));
+  cache[idx].pc = pc;
+  cache[idx].nbyte = nbyte;
+  memcpy(cache[idx].code, code, nbyte);
+}
+
+void disassemble(char *str, int size, uint64_t pc, uint8_t *code, int nbyte) {
+  if (nbyte > sizeof(cache[0].code)) {
+    bool ok = disassemble_one(pc, code, nbyte);
+    assert(ok);
+    format_insn(str, size);
+    return;
+  }
+  int idx = cache_idx(pc);
+  if (cache[idx].pc != pc || cache[idx].nbyte != nbyte || memcmp(cache[idx].code, code, nbyte)) {
+    bool ok = disassemble_one(pc, code, nbyte);
+    assert(ok);
+    cache_fill(idx, pc, code, nbyte);
+  }
+  snprintf(str, size, "%s", cache[idx].str);
+}
+
+/* Disassemble a contiguous run of `size` bytes of guest code at `pc` in one
+ * pass, and put the instructions into the cache, so that format_inst() on
+ * each of them afterwards only hits the cache. Return the number of bytes
+ * disassembled, which stops before an invalid instruction. */
+int disassemble_block(vaddr_t pc, const uint8_t *code, int size) {
+  if (unlikely(insn == NULL)) init_disasm();
+  const uint8_t *p = code;
+  size_t left = size;
+  uint64_t addr = pc;
+  while (left > 0 && cs_disasm_iter_dl(handle, &p, &left, &addr, insn)) {
+    int nbyte = insn->size;
+    const uint8_t *inst = p - nbyte;
+    if (nbyte > sizeof(cache[0].code)) continue;
+    // format_inst() disassembles x86 at the next pc, which is `addr` now
+    uint64_t key = MUXDEF(CONFIG_ISA_x86, addr, addr - nbyte);
+#ifdef CONFIG_ISA_x86
+    bool ok = disassemble_one(key, inst, nbyte);
+    assert(ok);
+#endif
+    cache_fill(cache_idx(key), key, inst, nbyte);
+  }
+  return p - code;
+}
+
+// format an instruction as "pc: bytes  assembly"
+void format_inst(char *str, int size, vaddr_t pc, uint8_t *inst, int ilen) {
+  char *p = str;
+  p += snprintf(p, size, FMT_WORD ":", pc);
+  int i;
+#ifdef CONFIG_ISA_x86
+  for (i = 0; i < ilen; i ++) {
+#else
+  for (i = ilen - 1; i >= 0; i --) {
+#endif
+    p += snprintf(p, 4, " %02x", inst[i]);
+  }
+  int ilen_max = MUXDEF(CONFIG_ISA_x86, 8, 4);
+  int space_len = ilen_max - ilen;
+  if (space_len < 0) space_len = 0;
+  space_len = space_len * 3 + 1;
+  memset(p, ' ', space_len);
+  p += space_len;
+
+  disassemble(p, str + size - p, MUXDEF(CONFIG_ISA_x86, pc + ilen, pc), inst, ilen);
 }
@@ -22,3 +22,49 @@ src/utils/disasm.c: $(LIBCAPSTONE)
 $(LIBCAPSTONE):
 	$(MAKE) -C tools/capstone
 endif
+
+ifdef CONFIG_ITRACE_BINARY
+LIBS += -lpthread
+else
+SRCS-BLACKLIST-y += src/utils/itrace.c
+endif
+
+LIBS += $(if $(CONFIG_LOG_ASYNC),-lpthread,)
+
+ifndef CONFIG_FTRACE
+SRCS-BLACKLIST-y += src/utils/ftrace.c
+endif
+
+ifndef CONFIG_PROFILE
+SRCS-BLACKLIST-y += src/utils/profile.c
+endif
+
+ifndef CONFIG_INST_STAT
+SRCS-BLACKLIST-y += src/utils/inst-stat.c
+endif
+
+ifndef CONFIG_STATS
+SRCS-BLACKLIST-y += src/utils/stats.c
+endif
+
+ifndef CONFIG_FOOTPRINT
+SRCS-BLACKLIST-y += src/utils/footprint.c
+endif
+
+ifndef CONFIG_LIVE
+SRCS-BLACKLIST-y += src/utils/live.c
+endif
+
+SRCS-BLACKLIST-$(CONFIG_TARGET_AM) += src/utils/memhash.c
+
+ifdef CONFIG_SNAPSHOT
+LIBS += -lz
+else
+SRCS-BLACKLIST-y += src/utils/snapshot.c
+endif
+
+ifeq ($(CONFIG_ITRACE_BINARY)$(CONFIG_MTRACE)$(CONFIG_LOG_ASYNC)$(CONFIG_FTRACE),)
+SRCS-BLACKLIST-y += src/utils/tfile.c
+else
+LIBS += -lz
+endif
@@ -0,0 +1,110 @@
+/***************************************************************************************
+* Copyright (c) 2014-2024 Zihao Yu, Nanjing University
+*
+* NEMU is licensed under Mulan PSL v2.
+* You can use this software according to the terms and conditions of the Mulan PSL v2.
+* You may obtain a copy of Mulan PSL v2 at:
+*          http://license.coscl.org.cn/MulanPSL2
+*
+* THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+* EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+* MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+*
+* See the Mulan PSL v2 for more details.
+***************************************************************************************/
+
+
+#include <common.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+/* Regions of host memory accounted to subsystems. The resident part of a
+ * region is found by mincore() when it is collected, so that accounting
+ * costs nothing while running. Regions smaller than a page may be counted
+ * with the page they share with others. */
+
+typedef struct {
+  const char *name;
+  void *addr;
+  size_t size;
+} Region;
+
+static Region *region = NULL;
+static int nr_region = 0, max_region = 0;
+
+void footprint_add(const char *name, void *addr, size_t size) {
+  int i;
+  for (i = 0; i < nr_region && region[i].addr != addr; i ++);
+  if (i == nr_region) {
+    if (size == 0) return;
+    if (nr_region == max_region) {
+      max_region = (max_region == 0 ? 64 : max_region * 2);
+      region = realloc(region, sizeof(*region) * max_region);
+      assert(region);
+    }
+    nr_region ++;
+  } else if (size == 0) {
+    memmove(&region[i], &region[i + 1], sizeof(*region) * (nr_region - i - 1));
+    nr_region --;
+    return;
+  }
+  region[i] = (Region) { .name = name, .addr = addr, .size = size };
+}
+
+static uint64_t resident(void *addr, size_t size) {
+  static long page = 0;
+  if (page == 0) page = sysconf(_SC_PAGESIZE);
+  uintptr_t lo = (uintptr_t)addr & ~(page - 1);
+  uintptr_t hi = ((uintptr_t)addr + size + page - 1) & ~(page - 1);
+  unsigned char vec[4096];
+  uint64_t n = 0;
+  for (; lo < hi; lo += sizeof(vec) * page) {
+    size_t len = hi - lo;
+    if (len > sizeof(vec) * page) len = sizeof(vec) * page;
+    if (mincore((void *)lo, len, vec) != 0) continue;
+    size_t i;
+    for (i = 0; i < len / page; i ++) n += vec[i] & 1;
+  }
+  n *= page;
+  return (n < size ? n : size);
+}
+
+int footprint_collect(Footprint *fp, int max) {
+  int i, j, n = 0;
+  for (i = 0; i < nr_region; i ++) {
+    for (j = 0; j < n && strcmp(fp[j].name, region[i].name) != 0; j ++);
+    if (j == n) {
+      // the rest are summed into the last one
+      if (n == max) j = max - 1;
+      else fp[n ++] = (Footprint) { .name = region[i].name };
+    }
+    fp[j].reserved += region[i].size;
+    fp[j].resident += resident(region[i].addr, region[i].size);
+  }
+  return n;
+}
+
+uint64_t footprint_rss() {
+  long pages = 0;
+  FILE *fp = fopen("/proc/self/statm", "r");
+  if (fp == NULL) return 0;
+  if (fscanf(fp, "%*d %ld", &pages) != 1) pages = 0;
+  fclose(fp);
+  return pages * sysconf(_SC_PAGESIZE);
+}
+
+#define MB(x) ((x) / 1048576.0)
+
+void footprint_report() {
+  Footprint fp[32];
+  int i, n = footprint_collect(fp, ARRLEN(fp));
+  uint64_t reserved = 0, res = 0;
+  Log("host memory       reserved (MB)   resident (MB)");
+  for (i = 0; i < n; i ++) {
+    Log("%-16s %14.2f %15.2f", fp[i].name, MB(fp[i].reserved), MB(fp[i].resident));
+    reserved += fp[i].reserved;
+    res += fp[i].resident;
+  }
+  Log("%-16s %14.2f %15.2f", "total", MB(reserved), MB(res));
+  Log("%-16s %14s %15.2f", "RSS", "", MB(footprint_rss()));
+}
@@ -0,0 +1,106 @@
+/***************************************************************************************
+* Copyright (c) 2014-2024 Zihao Yu, Nanjing University
+*
+* NEMU is licensed under Mulan PSL v2.
+* You can use this software according to the terms and conditions of the Mulan PSL v2.
+* You may obtain a copy of Mulan PSL v2 at:
+*          http://license.coscl.org.cn/MulanPSL2
+*
+* THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+* EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+* MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+*
+* See the Mulan PSL v2 for more details.
+***************************************************************************************/
+
+
+#include <common.h>
+#include <cpu/ftrace.h>
+
+/* Calls and returns are found from the control flow without decoding, so
+ * that it works for any ISA: a transfer to the start of a function is a
+ * call, and a transfer to the return address of a frame near the top of
+ * the shadow stack is a return. Frames above that one are abandoned by
+ * tail calls or longjmp(), and they return at the same time. */
+#define MAX_DEPTH 4096
+// how many frames from the top are searched for a return
+#define RET_SEARCH 8
+
+typedef struct {
+  vaddr_t ret;
+  uint32_t sym;
+} Frame;
+
+bool ftrace_on = false;
+static Frame stack[MAX_DEPTH];
+static int depth = 0;
+static TraceFile *ftrace_tf = NULL;
+static uint64_t nr_record = 0;
+
+extern uint64_t g_nr_guest_inst;
+
+static void emit(vaddr_t pc, uint32_t sym, int type) {
+  FTraceRecord r = { .pc = pc, .nr_inst = g_nr_guest_inst, .sym = sym, .type = type };
+  tfile_write(ftrace_tf, &r, sizeof(r));
+  nr_record ++;
+}
+
+void ftrace_transfer(vaddr_t pc, vaddr_t snpc, vaddr_t dnpc) {
+  int i;
+  for (i = depth - 1; i >= 0 && i >= depth - RET_SEARCH; i --) {
+    if (stack[i].ret == dnpc) {
+      while (depth > i) emit(pc, stack[-- depth].sym, FTRACE_RET);
+      return;
+    }
+  }
+
+  int sym = symbol_at(dnpc);
+  if (sym < 0) return;
+  if (depth == MAX_DEPTH) {
+    // forget the oldest half of the frames under a runaway recursion
+    memmove(stack, stack + MAX_DEPTH / 2, sizeof(Frame) * (MAX_DEPTH / 2));
+    depth = MAX_DEPTH / 2;
+  }
+  stack[depth ++] = (Frame) { .ret = snpc, .sym = sym };
+  emit(pc, sym, FTRACE_CALL);
+}
+
+static void ftrace_close() {
+  tfile_close(ftrace_tf);
+  ftrace_on = false;
+  Log("ftrace: %" PRIu64 " records written", nr_record);
+}
+
+bool ftrace_open(const char *file) {
+  // the symbol table is written into the header
+  int nr = symbol_count(), i;
+  size_t len = sizeof(FTraceHeader);
+  for (i = 0; i < nr; i ++) {
+    vaddr_t start;
+    word_t size;
+    len += 2 * sizeof(uint64_t) + sizeof(uint32_t) + strlen(symbol_get(i, &start, &size));
+  }
+  uint8_t *buf = malloc(len), *p = buf + sizeof(FTraceHeader);
+  assert(buf != NULL);
+  FTraceHeader h = { .word_bytes = sizeof(word_t), .nr_sym = nr };
+  memcpy(h.magic, FTRACE_MAGIC, sizeof(h.magic));
+  memcpy(buf, &h, sizeof(h));
+  for (i = 0; i < nr; i ++) {
+    vaddr_t start;
+    word_t size;
+    const char *name = symbol_get(i, &start, &size);
+    uint64_t x[2] = { start, size };
+    uint32_t name_len = strlen(name);
+    memcpy(p, x, sizeof(x)); p += sizeof(x);
+    memcpy(p, &name_len, sizeof(name_len)); p += sizeof(name_len);
+    memcpy(p, name, name_len); p += name_len;
+  }
+
+  ftrace_tf = tfile_open(file, buf, len);
+  free(buf);
+  if (ftrace_tf == NULL) return false;
+  if (nr == 0) Log("ftrace: no symbol is found, load the image with --elf");
+  ftrace_on = true;
+  atexit(ftrace_close);
+  return true;
+}
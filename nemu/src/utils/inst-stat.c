@@ -0,0 +1,78 @@
+/***************************************************************************************
+* Copyright (c) 2014-2024 Zihao Yu, Nanjing University
+*
+* NEMU is licensed under Mulan PSL v2.
+* You can use this software according to the terms and conditions of the Mulan PSL v2.
+* You may obtain a copy of Mulan PSL v2 at:
+*          http://license.coscl.org.cn/MulanPSL2
+*
+* THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+* EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+* MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+*
+* See the Mulan PSL v2 for more details.
+***************************************************************************************/
+
+
+#include <common.h>
+#include <cpu/decode.h>
+
+/* The counters are placed in the section "inst_stat" by INSTPAT_STAT(), so
+ * that all patterns of the ISA are found without a table. */
+extern InstStat __start_inst_stat[], __stop_inst_stat[];
+static char *json_file = NULL;
+#ifdef CONFIG_INST_COST
+InstStat *inst_stat_last = NULL;
+#endif
+
+void inst_stat_set_json(const char *file) {
+  json_file = strdup(file);
+}
+
+static int stat_cmp(const void *a, const void *b) {
+  uint64_t x = (*(InstStat * const *)a)->count, y = (*(InstStat * const *)b)->count;
+  return (x < y) - (x > y);
+}
+
+void inst_stat_report() {
+  int nr = __stop_inst_stat - __start_inst_stat, n = 0, i;
+  InstStat **s = malloc(sizeof(InstStat *) * nr);
+  assert(s != NULL);
+  uint64_t total = 0;
+  for (i = 0; i < nr; i ++) {
+    if (__start_inst_stat[i].count == 0) continue;
+    s[n ++] = &__start_inst_stat[i];
+    total += __start_inst_stat[i].count;
+  }
+  qsort(s, n, sizeof(InstStat *), stat_cmp);
+
+  Log("instruction mix of %" PRIu64 " instructions:", total);
+  for (i = 0; i < n; i ++) {
+    char cost[64] = "";
+#ifdef CONFIG_INST_COST
+    snprintf(cost, sizeof(cost), ", %" PRIu64 " " COST_UNIT ", %.1f each", s[i]->cost,
+        (double)s[i]->cost / s[i]->count);
+#endif
+    if (s[i]->taken != 0)
+      Log("  %-10s %14" PRIu64 " %6.2f%%, taken %" PRIu64 ", not taken %" PRIu64 "%s", s[i]->pat, s[i]->count,
+          s[i]->count * 100.0 / total, s[i]->taken, s[i]->count - s[i]->taken, cost);
+    else Log("  %-10s %14" PRIu64 " %6.2f%%%s", s[i]->pat, s[i]->count, s[i]->count * 100.0 / total, cost);
+  }
+
+  if (json_file != NULL) {
+    FILE *fp = fopen(json_file, "w");
+    if (fp == NULL) Log_warn("Can not open '%s'", json_file);
+    else {
+      fprintf(fp, "{\"total\": %" PRIu64 ", \"inst\": [", total);
+      for (i = 0; i < n; i ++) {
+        fprintf(fp, "%s\n  {\"name\": \"%s\", \"pattern\": \"%s\", \"count\": %" PRIu64 ", \"taken\": %" PRIu64,
+            (i == 0 ? "" : ","), s[i]->pat, s[i]->pattern, s[i]->count, s[i]->taken);
+        IFDEF(CONFIG_INST_COST, fprintf(fp, ", \"cost\": %" PRIu64, s[i]->cost));
+        fprintf(fp, "}");
+      }
+      fprintf(fp, "\n]}\n");
+      fclose(fp);
+    }
+  }
+  free(s);
+}
@@ -0,0 +1,129 @@
+/***************************************************************************************
+* Copyright (c) 2014-2024 Zihao Yu, Nanjing University
+*
+* NEMU is licensed under Mulan PSL v2.
+* You can use this software according to the terms and conditions of the Mulan PSL v2.
+* You may obtain a copy of Mulan PSL v2 at:
+*          http://license.coscl.org.cn/MulanPSL2
+*
+* THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+* EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+* MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+*
+* See the Mulan PSL v2 for more details.
+***************************************************************************************/
+
+
+#include <common.h>
+#include <cpu/itrace.h>
+#include <capstone/capstone.h>
+#include <pthread.h>
+
+/* The ring always holds the last records, so that instructions are only
+ * disassembled offline. Each time half of the ring is filled, it is handed
+ * to the writer thread, which writes and compresses it while the other
+ * half is being filled. */
+ITraceRecord itrace_ring[ITRACE_RING_SIZE];
+uint64_t itrace_nr = 0;
+// records in [nr_written, nr_posted) are being written by the writer thread
+static uint64_t nr_posted = 0, nr_written = 0;
+static bool writer_quit = false;
+static TraceFile *itrace_tf = NULL;
+static pthread_t writer;
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t cond = PTHREAD_COND_INITIALIZER;
+
+static void* writer_thread(void *arg) {
+  pthread_mutex_lock(&lock);
+  while (true) {
+    while (nr_written == nr_posted && !writer_quit) pthread_cond_wait(&cond, &lock);
+    if (nr_written == nr_posted) break;
+    uint64_t start = nr_written, end = nr_posted;
+    pthread_mutex_unlock(&lock);
+    // a posted range never wraps around the ring
+    tfile_write(itrace_tf, &itrace_ring[start % ITRACE_RING_SIZE], (end - start) * sizeof(ITraceRecord));
+    pthread_mutex_lock(&lock);
+    nr_written = end;
+    pthread_cond_broadcast(&cond);
+  }
+  pthread_mutex_unlock(&lock);
+  return NULL;
+}
+
+void itrace_flush() {
+  if (itrace_tf == NULL) return;
+  pthread_mutex_lock(&lock);
+  // the half to fill next should be written already
+  while (nr_written != nr_posted) pthread_cond_wait(&cond, &lock);
+  nr_posted = itrace_nr;
+  pthread_cond_broadcast(&cond);
+  pthread_mutex_unlock(&lock);
+}
+
+static void itrace_close() {
+  itrace_flush();
+  pthread_mutex_lock(&lock);
+  writer_quit = true;
+  pthread_cond_broadcast(&cond);
+  pthread_mutex_unlock(&lock);
+  pthread_join(writer, NULL);
+  tfile_close(itrace_tf);
+  itrace_tf = NULL;
+  Log("itrace: %" PRIu64 " records written", itrace_nr);
+}
+
+bool itrace_open(const char *file) {
+  ITraceHeader h = {
+    .cs_arch = MUXDEF(CONFIG_ISA_x86,      CS_ARCH_X86,
+                 MUXDEF(CONFIG_ISA_mips32, CS_ARCH_MIPS,
+                 MUXDEF(CONFIG_ISA_riscv,  CS_ARCH_RISCV,
+                 MUXDEF(CONFIG_ISA_loongarch32r,  CS_ARCH_LOONGARCH, -1)))),
+    .cs_mode = MUXDEF(CONFIG_ISA_x86,      CS_MODE_32,
+                 MUXDEF(CONFIG_ISA_mips32, CS_MODE_MIPS32,
+                 MUXDEF(CONFIG_ISA_riscv,  MUXDEF(CONFIG_ISA64, CS_MODE_RISCV64, CS_MODE_RISCV32) | CS_MODE_RISCVC,
+                 MUXDEF(CONFIG_ISA_loongarch32r,  CS_MODE_LOONGARCH32, -1)))),
+    .cs_syntax = MUXDEF(CONFIG_ISA_x86, CS_OPT_SYNTAX_ATT, 0),
+    .word_bytes = sizeof(word_t),
+    .flags = MUXDEF(CONFIG_ISA_x86, ITRACE_FLAG_X86, 0),
+  };
+  memcpy(h.magic, ITRACE_MAGIC, sizeof(h.magic));
+  itrace_tf = tfile_open(file, &h, sizeof(h));
+  if (itrace_tf == NULL) return false;
+  int ret = pthread_create(&writer, NULL, writer_thread, NULL);
+  Assert(ret == 0, "Can not create the writer thread of itrace");
+  FOOTPRINT("trace", itrace_ring, sizeof(itrace_ring));
+  atexit(itrace_close);
+  return true;
+}
+
+void itrace_dump(int n) {
+  if (n > itrace_nr) n = itrace_nr;
+  if (n > ITRACE_RING_SIZE) n = ITRACE_RING_SIZE;
+  if (n == 0) return;
+  log_write("The last %d instructions executed:\n", n);
+  void format_inst(char *str, int size, vaddr_t pc, uint8_t *inst, int ilen);
+  int disassemble_block(vaddr_t pc, const uint8_t *code, int size);
+  uint64_t i;
+  // disassemble the records at consecutive pcs as blocks first
+  uint8_t block[1024];
+  vaddr_t start = 0;
+  int len = 0;
+  for (i = itrace_nr - n; i < itrace_nr; i ++) {
+    ITraceRecord *r = &itrace_ring[i % ITRACE_RING_SIZE];
+    if (len > 0 && (r->pc != start + len || len + r->ilen > sizeof(block))) {
+      disassemble_block(start, block, len);
+      len = 0;
+    }
+    if (len == 0) start = r->pc;
+    memcpy(block + len, r->inst, r->ilen);
+    len += r->ilen;
+  }
+  disassemble_block(start, block, len);
+
+  for (i = itrace_nr - n; i < itrace_nr; i ++) {
+    ITraceRecord *r = &itrace_ring[i % ITRACE_RING_SIZE];
+    char buf[128];
+    format_inst(buf, sizeof(buf), r->pc, r->inst, r->ilen);
+    log_write("%s\n", buf);
+  }
+}
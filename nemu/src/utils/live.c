@@ -0,0 +1,135 @@
+/***************************************************************************************
+* Copyright (c) 2014-2024 Zihao Yu, Nanjing University
+*
+* NEMU is licensed under Mulan PSL v2.
+* You can use this software according to the terms and conditions of the Mulan PSL v2.
+* You may obtain a copy of Mulan PSL v2 at:
+*          http://license.coscl.org.cn/MulanPSL2
+*
+* THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+* EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+* MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+*
+* See the Mulan PSL v2 for more details.
+***************************************************************************************/
+
+
+#include <common.h>
+#include <live-def.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+
+/* The counters are published to the shared memory of LIVE_SHM_PREFIX PID.
+ * Those counted in slow paths, i.e. MMIO and difftest, are added to it
+ * directly, while the others are copied every CONFIG_LIVE_INTERVAL
+ * instructions and at the end of cpu_exec(), which also reads the clock.
+ * A forked copy of NEMU counts into a private page instead. */
+
+static LiveCounters private = {};
+LiveCounters *live = &private;
+static char shm_name[32] = "";
+static uint64_t next_update = CONFIG_LIVE_INTERVAL;
+static uint64_t last_inst = 0, last_ns = 0;
+IFDEF(CONFIG_FOOTPRINT, static uint64_t last_mem_ns = 0);
+
+static uint64_t live_clock() {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec * 1000000000ull + now.tv_nsec;
+}
+
+static void live_exit() {
+  shm_unlink(shm_name);
+}
+
+static void live_forked() {
+  private = *live;
+  live = &private;
+}
+
+void init_live() {
+  snprintf(shm_name, sizeof(shm_name), LIVE_SHM_PREFIX "%d", getpid());
+  int fd = shm_open(shm_name, O_CREAT | O_RDWR | O_TRUNC, 0644);
+  if (fd < 0 || ftruncate(fd, sizeof(LiveCounters)) != 0) {
+    Log_warn("Can not create the shared memory %s, live counters are off", shm_name);
+    if (fd >= 0) { close(fd); shm_unlink(shm_name); }
+    return;
+  }
+  void *p = mmap(NULL, sizeof(LiveCounters), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  assert(p != MAP_FAILED);
+  live = p;
+  live->version = LIVE_VERSION;
+  last_ns = live_clock();
+  LIVE_STORE(live->update_ns, last_ns);
+  // readers check the magic last
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+  memcpy(live->magic, LIVE_MAGIC, sizeof(live->magic));
+  atexit(live_exit);
+  pthread_atfork(NULL, NULL, live_forked);
+  Log("Live counters are published at /dev/shm%s", shm_name);
+}
+
+// return the index of the counters of the device `name`
+int live_device(const char *name) {
+  uint32_t n = live->nr_dev;
+  if (n == LIVE_NR_DEV) return n - 1;
+  strncpy(live->dev[n].name, (n == LIVE_NR_DEV - 1 ? "others" : name), LIVE_NAME_LEN - 1);
+  LIVE_STORE(live->nr_dev, n + 1);
+  return n;
+}
+
+// return the number of instructions to run before the next update, up to `n`
+uint64_t live_limit(uint64_t n) {
+  extern uint64_t g_nr_guest_inst;
+  uint64_t left = (next_update > g_nr_guest_inst ? next_update - g_nr_guest_inst : 1);
+  return (left < n ? left : n);
+}
+
+void live_update(bool force) {
+  extern uint64_t g_nr_guest_inst;
+  if (!force && g_nr_guest_inst < next_update) return;
+  // instructions may be skipped by CONFIG_IDLE_SLEEP
+  while (next_update <= g_nr_guest_inst) next_update += CONFIG_LIVE_INTERVAL;
+  uint64_t now = live_clock();
+  if (now - last_ns >= 1000000) {
+    LIVE_STORE(live->inst_per_sec, (g_nr_guest_inst - last_inst) * 1000000000 / (now - last_ns));
+    last_inst = g_nr_guest_inst;
+    last_ns = now;
+  }
+  LIVE_STORE(live->guest_inst, g_nr_guest_inst);
+  LIVE_STORE(live->state, nemu_state.state);
+#ifdef CONFIG_VADDR_TLB
+  void vaddr_tlb_count(uint64_t *hit, uint64_t *miss);
+  uint64_t hit[LIVE_NR_TLB], miss[LIVE_NR_TLB];
+  vaddr_tlb_count(hit, miss);
+  int t;
+  for (t = 0; t < LIVE_NR_TLB; t ++) {
+    LIVE_STORE(live->tlb_hit[t], hit[t]);
+    LIVE_STORE(live->tlb_miss[t], miss[t]);
+  }
+#endif
+#ifdef CONFIG_DECODE_CACHE
+  extern uint64_t dcache_nr_miss;
+  LIVE_STORE(live->decode_miss, dcache_nr_miss);
+#endif
+#ifdef CONFIG_FOOTPRINT
+  // mincore() walks the page tables of all the memory accounted
+  if (force || now - last_mem_ns >= 1000000000) {
+    Footprint fp[LIVE_NR_MEM];
+    int i, n = footprint_collect(fp, LIVE_NR_MEM);
+    for (i = 0; i < n; i ++) {
+      strncpy(live->mem[i].name, fp[i].name, LIVE_NAME_LEN - 1);
+      LIVE_STORE(live->mem[i].reserved, fp[i].reserved);
+      LIVE_STORE(live->mem[i].resident, fp[i].resident);
+    }
+    LIVE_STORE(live->nr_mem, n);
+    LIVE_STORE(live->rss, footprint_rss());
+    last_mem_ns = now;
+  }
+#endif
+  LIVE_STORE(live->update_ns, now);
+}
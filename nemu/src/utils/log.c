@@ -13,25 +13,349 @@
 * See the Mulan PSL v2 for more details.
 ***************************************************************************************/
 
-#include <common.h>
+#include <isa.h>
 
 extern uint64_t g_nr_guest_inst;
 
+int log_level = CONFIG_LOG_LEVEL;
+
 #ifndef CONFIG_TARGET_AM
 FILE *log_fp = NULL;
 
+#ifdef CONFIG_LOG_ASYNC
+#include <pthread.h>
+#include <sched.h>
+#include <stdarg.h>
+#include <unistd.h>
+
+#define RING_SIZE CONFIG_LOG_ASYNC_RING_SIZE
+static_assert((RING_SIZE & (RING_SIZE - 1)) == 0, "the size of the ring should be a power of 2");
+
+/* Messages are pushed into a ring with a single consumer. They mostly come
+ * from the emulation thread, but also from the display thread, so producers
+ * take `push_lock`, which also guards the formats and the record of
+ * LOG_BINARY, and is hardly ever contended. The writer
+ * thread only writes `tail` and `flushed`, and writes the ring to the file
+ * in large chunks, being the only one accessing the file. When the log is
+ * stdout, messages are written directly, keeping their order with those
+ * printed by Log(). */
+static char ring[RING_SIZE];
+static uint64_t head = 0, tail = 0;
+// the messages before it are flushed to the file
+static uint64_t flushed = 0;
+static bool async_on = false;
+static bool writer_quit = false;
+static pthread_t writer;
+static pthread_mutex_t push_lock = PTHREAD_MUTEX_INITIALIZER;
+static TraceFile *log_tf = NULL;
+
+static void* writer_thread(void *arg) {
+  bool dirty = false;
+  while (true) {
+    // check for quitting first, so that messages published before it are seen below
+    bool quit = __atomic_load_n(&writer_quit, __ATOMIC_ACQUIRE);
+    uint64_t h = __atomic_load_n(&head, __ATOMIC_ACQUIRE);
+    if (h == tail) {
+      if (dirty) { tfile_flush(log_tf); dirty = false; }
+      __atomic_store_n(&flushed, h, __ATOMIC_RELEASE);
+      if (quit) break;
+      usleep(1000);
+      continue;
+    }
+    uint64_t idx = tail % RING_SIZE, n = h - tail;
+    if (idx + n > RING_SIZE) n = RING_SIZE - idx;
+    tfile_write(log_tf, &ring[idx], n);
+    dirty = true;
+    __atomic_store_n(&tail, tail + n, __ATOMIC_RELEASE);
+  }
+  return NULL;
+}
+
+static void push(const char *buf, uint64_t len) {
+  while (len > 0) {
+    uint64_t free_len;
+    while ((free_len = RING_SIZE - (head - __atomic_load_n(&tail, __ATOMIC_ACQUIRE))) == 0) {
+      sched_yield();
+    }
+    uint64_t idx = head % RING_SIZE, n = len;
+    if (n > free_len) n = free_len;
+    if (idx + n > RING_SIZE) n = RING_SIZE - idx;
+    memcpy(&ring[idx], buf, n);
+    __atomic_store_n(&head, head + n, __ATOMIC_RELEASE);
+    buf += n;
+    len -= n;
+  }
+}
+
+#ifdef CONFIG_LOG_BINARY
+#include <blog-def.h>
+
+#define NR_FMT 1024
+#define MAX_ARG 16
+
+/* The format strings seen, looked up by their addresses, with the kinds of
+ * their arguments parsed once when defined. A format which can not be
+ * recorded in binary has id 0, and is formatted as before. */
+typedef struct {
+  const char *fmt;
+  uint32_t id;
+  int nr_arg;
+  uint8_t kind[MAX_ARG];
+} Format;
+static Format fmts[NR_FMT];
+static uint32_t nr_fmt = 0;
+// the record being built
+static uint8_t *rec = NULL;
+static size_t rec_size = 0;
+
+static void push_record(uint32_t id, const void *payload, uint32_t len) {
+  BLogRecord r = { .len = sizeof(r) + len, .id = id };
+  push((const char *)&r, sizeof(r));
+  push((const char *)payload, len);
+}
+
+static Format *lookup(const char *fmt) {
+  uint32_t idx = ((uintptr_t)fmt * 0x9e3779b97f4a7c15ull) >> (64 - 10);
+  for (;; idx = (idx + 1) % NR_FMT) {
+    Format *f = &fmts[idx];
+    if (f->fmt == fmt) return f;
+    if (f->fmt == NULL) break;
+  }
+  if (nr_fmt >= NR_FMT / 4 * 3) return NULL;
+  Format *f = &fmts[idx];
+  f->fmt = fmt;
+  f->id = ++ nr_fmt;
+  for (const char *p = fmt; (p = strchr(p, '%')) != NULL; ) {
+    int kind;
+    p += blog_conversion(p, &kind);
+    if (kind == BLOG_ARG_NONE) continue;
+    if (kind == BLOG_ARG_BAD || f->nr_arg == MAX_ARG) { f->id = 0; return f; }
+    f->kind[f->nr_arg ++] = kind;
+  }
+  push_record(BLOG_DEF | f->id, fmt, strlen(fmt));
+  return f;
+}
+
+static void rec_reserve(size_t size) {
+  if (size <= rec_size) return;
+  rec_size = (size > 2 * rec_size ? size : 2 * rec_size);
+  rec = realloc(rec, rec_size);
+  assert(rec != NULL);
+}
+
+// record the arguments of `fmt` without formatting them, return false if not recordable
+static bool write_binary(const char *fmt, va_list ap) {
+  Format *f = lookup(fmt);
+  if (f == NULL || f->id == 0) return false;
+  size_t len = sizeof(BLogRecord);
+  rec_reserve(len + f->nr_arg * 8);
+  int i;
+  for (i = 0; i < f->nr_arg; i ++) {
+    uint64_t v = 0;
+    switch (f->kind[i]) {
+      case BLOG_ARG_INT: v = (int64_t)va_arg(ap, int); break;
+      case BLOG_ARG_LONG: v = va_arg(ap, long long); break;
+      case BLOG_ARG_PTR: v = (uintptr_t)va_arg(ap, void *); break;
+      case BLOG_ARG_DOUBLE: { double d = va_arg(ap, double); memcpy(&v, &d, 8); break; }
+      case BLOG_ARG_STR: {
+        const char *s = va_arg(ap, const char *);
+        if (s == NULL) s = "(null)";
+        uint32_t n = strlen(s);
+        rec_reserve(len + 4 + n + (f->nr_arg - i - 1) * 8);
+        memcpy(rec + len, &n, 4);
+        memcpy(rec + len + 4, s, n);
+        len += 4 + n;
+        continue;
+      }
+    }
+    memcpy(rec + len, &v, 8);
+    len += 8;
+  }
+  BLogRecord r = { .len = len, .id = f->id };
+  memcpy(rec, &r, sizeof(r));
+  push((const char *)rec, len);
+  return true;
+}
+#endif
+
+static void push_text(const char *buf, uint64_t len) {
+  MUXDEF(CONFIG_LOG_BINARY, push_record(0, buf, len), push(buf, len));
+}
+
+void log_write_async(const char *fmt, ...) {
+  if (!async_on && log_fp == NULL) return;
+  va_list ap;
+  va_start(ap, fmt);
+  if (!async_on) {
+    vfprintf(log_fp, fmt, ap);
+    fflush(log_fp);
+    va_end(ap);
+    return;
+  }
+#ifdef CONFIG_LOG_BINARY
+  pthread_mutex_lock(&push_lock);
+  bool done = write_binary(fmt, ap);
+  pthread_mutex_unlock(&push_lock);
+  if (done) {
+    va_end(ap);
+    return;
+  }
+#endif
+  char buf[256];
+  va_list ap2;
+  va_copy(ap2, ap);
+  int len = vsnprintf(buf, sizeof(buf), fmt, ap);
+  char *p = buf;
+  if (len >= sizeof(buf)) {
+    p = malloc(len + 1);
+    assert(p != NULL);
+    vsnprintf(p, len + 1, fmt, ap2);
+  }
+  pthread_mutex_lock(&push_lock);
+  push_text(p, len);
+  pthread_mutex_unlock(&push_lock);
+  if (p != buf) free(p);
+  va_end(ap2);
+  va_end(ap);
+}
+
+// wait until all messages are written, called on failures
+void log_flush() {
+  if (!async_on) {
+    if (log_fp != NULL) fflush(log_fp);
+    return;
+  }
+  uint64_t h = __atomic_load_n(&head, __ATOMIC_ACQUIRE);
+  while (__atomic_load_n(&flushed, __ATOMIC_ACQUIRE) < h) usleep(100);
+}
+
+static void stop_writer() {
+  __atomic_store_n(&writer_quit, true, __ATOMIC_RELEASE);
+  pthread_join(writer, NULL);
+  tfile_close(log_tf);
+  // messages from now on are dropped
+  async_on = false;
+}
+
+static void start_writer(const char *log_file) {
+#ifdef CONFIG_LOG_BINARY
+  size_t n = strlen(log_file);
+  Assert(n < 5 || strcmp(log_file + n - 5, ".ring") != 0,
+      "A binary log can not be circular, whose format strings may be overwritten");
+#endif
+  log_tf = tfile_open(log_file, MUXDEF(CONFIG_LOG_BINARY, BLOG_MAGIC, NULL), MUXDEF(CONFIG_LOG_BINARY, 8, 0));
+  Assert(log_tf, "Can not open '%s'", log_file);
+  int ret = pthread_create(&writer, NULL, writer_thread, NULL);
+  Assert(ret == 0, "Can not create the writer thread of log");
+  FOOTPRINT("trace", ring, sizeof(ring));
+  async_on = true;
+  atexit(stop_writer);
+}
+#endif
+
 void init_log(const char *log_file) {
   log_fp = stdout;
+#ifdef CONFIG_LOG_ASYNC
+  if (log_file != NULL) {
+    log_fp = NULL;
+    start_writer(log_file);
+  }
+#else
   if (log_file != NULL) {
     FILE *fp = fopen(log_file, "w");
     Assert(fp, "Can not open '%s'", log_file);
     log_fp = fp;
   }
+#endif
   Log("Log is written to %s", log_file ? log_file : "stdout");
 }
 
-bool log_enable() {
-  return MUXDEF(CONFIG_TRACE, (g_nr_guest_inst >= CONFIG_TRACE_START) &&
-         (g_nr_guest_inst <= CONFIG_TRACE_END), false);
+#define MAX_WINDOW 8
+
+typedef struct {
+  uint64_t lo, hi;
+} Window;
+
+// windows are only changed by sdb and the command line while the guest is stopped
+static Window inst_window[MAX_WINDOW], pc_window[MAX_WINDOW];
+static int nr_inst_window = 0, nr_pc_window = 0;
+int log_nr_window = 0;
+
+static inline bool in_window(Window *w, int n, uint64_t x) {
+  if (n == 0) return true;
+  int i;
+  for (i = 0; i < n; i ++) {
+    if (x >= w[i].lo && x <= w[i].hi) return true;
+  }
+  return false;
+}
+
+bool log_enable_window() {
+  return in_window(inst_window, nr_inst_window, g_nr_guest_inst) &&
+         in_window(pc_window, nr_pc_window, cpu.pc);
+}
+
+static bool parse_num(const char *s, uint64_t *x) {
+  char *end;
+  if (s == NULL) return false;
+  *x = strtoull(s, &end, 0);
+  return *s != '\0' && *end == '\0';
+}
+
+const char *trace_window_arm(const char *kind, const char *a, const char *b) {
+  uint64_t lo, hi;
+  bool is_pc = true;
+  if (kind != NULL && strcmp(kind, "sym") == 0) {
+    vaddr_t start;
+    word_t size;
+    if (a == NULL || !symbol_find(a, &start, &size)) return "symbol is not found";
+    lo = start;
+    hi = start + (size > 0 ? size - 1 : 0);
+  } else if (kind != NULL && (strcmp(kind, "inst") == 0 || strcmp(kind, "pc") == 0)) {
+    if (!parse_num(a, &lo) || !parse_num(b, &hi) || lo > hi) return "bad range";
+    is_pc = (kind[0] == 'p');
+  } else return "unknown kind of window";
+
+  Window *w = (is_pc ? pc_window : inst_window);
+  int *n = (is_pc ? &nr_pc_window : &nr_inst_window);
+  if (*n == MAX_WINDOW) return "too many windows";
+  w[(*n) ++] = (Window) { .lo = lo, .hi = hi };
+  log_nr_window ++;
+  return NULL;
+}
+
+void trace_window_clear() {
+  nr_inst_window = nr_pc_window = log_nr_window = 0;
+}
+
+void trace_window_display() {
+  if (nr_inst_window == 0 && nr_pc_window == 0) {
+    printf("no trace window, the log is enabled for instructions [%d, %d]\n",
+        MUXDEF(CONFIG_TRACE, CONFIG_TRACE_START, 0), MUXDEF(CONFIG_TRACE, CONFIG_TRACE_END, -1));
+    return;
+  }
+  int i;
+  for (i = 0; i < nr_inst_window; i ++) {
+    printf("inst [%" PRIu64 ", %" PRIu64 "]\n", inst_window[i].lo, inst_window[i].hi);
+  }
+  for (i = 0; i < nr_pc_window; i ++) {
+    printf("pc   [" FMT_WORD ", " FMT_WORD "]\n", (word_t)pc_window[i].lo, (word_t)pc_window[i].hi);
+  }
+}
+
+uint64_t trace_window_next(bool *in) {
+  if (nr_inst_window == 0) return 0;
+  // instructions are counted from 1 as seen by log_enable() after executing them
+  uint64_t now = g_nr_guest_inst + 1, next = UINT64_MAX;
+  *in = false;
+  int i;
+  for (i = 0; i < nr_inst_window; i ++) {
+    Window *w = &inst_window[i];
+    if (now >= w->lo && now <= w->hi) {
+      *in = true;
+      if (w->hi - now + 1 < next && w->hi != UINT64_MAX) next = w->hi - now + 1;
+    } else if (w->lo > now && w->lo - now < next) next = w->lo - now;
+  }
+  return next;
 }
 #endif
@@ -0,0 +1,169 @@
+/***************************************************************************************
+* Copyright (c) 2014-2024 Zihao Yu, Nanjing University
+*
+* NEMU is licensed under Mulan PSL v2.
+* You can use this software according to the terms and conditions of the Mulan PSL v2.
+* You may obtain a copy of Mulan PSL v2 at:
+*          http://license.coscl.org.cn/MulanPSL2
+*
+* THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+* EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+* MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+*
+* See the Mulan PSL v2 for more details.
+***************************************************************************************/
+
+#include <isa.h>
+#include <memory/paddr.h>
+
+/* The hash of pmem at the end of the guest given by --hash-mem, so that a
+ * test can check the memory it has written without dumping it. The spec
+ *   LO:HI[,LO:HI...][=EXPECTED]
+ * gives the ranges [LO, HI) of physical addresses, hashed one after another
+ * as if they were concatenated, and the value expected, with which a
+ * different hash turns the end into a bad trap.
+ *
+ * The hash is built like XXH3 without being compatible with it: 8 lanes of
+ * 64 bits take a stripe of 64 bytes at a time, each lane adding a 32x32
+ * multiplication of its word mixed with a key, which the compiler turns
+ * into SIMD, and the lanes are scrambled every block of 1 KB. */
+#define NR_LANE 8
+#define STRIPE (NR_LANE * 8)
+#define STRIPE_PER_BLOCK 16
+#define MAX_RANGE 16
+
+static const uint64_t key[NR_LANE + 2] = {
+  0xbe4ba423396cfeb8ull, 0x1cad21f72c81017cull, 0xdb979083e96dd4deull, 0x1f67b3b7a4a44072ull,
+  0x78e5c0cc4ee679cbull, 0x2172ffcc7dd05a82ull, 0x8e2443f7744608b8ull, 0x4c263a81e69035e0ull,
+  0xcb00c391bb52283cull, 0xa32e531b8b65d088ull,
+};
+
+#define PRIME32_1 0x9e3779b1u
+#define PRIME64_1 0x9e3779b185ebca87ull
+#define PRIME64_2 0xc2b2ae3d27d4eb4full
+
+static struct { paddr_t lo, hi; } range[MAX_RANGE];
+static int nr_range = 0;
+static bool has_expected = false;
+static uint64_t expected = 0;
+
+static inline void accumulate(uint64_t *restrict acc, const uint8_t *p) {
+  int i;
+  for (i = 0; i < NR_LANE; i ++) {
+    uint64_t d, k;
+    memcpy(&d, p + i * 8, 8);
+    k = d ^ key[i];
+    acc[i ^ 1] += d;
+    acc[i] += (k & 0xffffffffu) * (k >> 32);
+  }
+}
+
+static inline void scramble(uint64_t *acc) {
+  int i;
+  for (i = 0; i < NR_LANE; i ++) {
+    acc[i] = (acc[i] ^ (acc[i] >> 47) ^ key[i + 2]) * PRIME32_1;
+  }
+}
+
+static uint64_t mix(uint64_t a, uint64_t b) {
+  __uint128_t m = (__uint128_t)a * b;
+  return (uint64_t)m ^ (uint64_t)(m >> 64);
+}
+
+static uint64_t avalanche(uint64_t h) {
+  h ^= h >> 37;
+  h *= 0x165667919e3779f9ull;
+  return h ^ (h >> 32);
+}
+
+typedef struct {
+  uint64_t acc[NR_LANE];
+  uint64_t len;
+  uint8_t buf[STRIPE]; // the bytes after the last whole stripe, as a range may end anywhere
+} HashState;
+
+static void hash_stripe(HashState *s, const uint8_t *p, uint64_t stripe) {
+  accumulate(s->acc, p);
+  if ((stripe + 1) % STRIPE_PER_BLOCK == 0) scramble(s->acc);
+}
+
+static void hash_update(HashState *s, const uint8_t *p, uint64_t size) {
+  uint64_t pend = s->len % STRIPE;
+  if (pend != 0) {
+    uint64_t n = (size < STRIPE - pend ? size : STRIPE - pend);
+    memcpy(s->buf + pend, p, n);
+    p += n; size -= n; s->len += n;
+    if (pend + n < STRIPE) return;
+    hash_stripe(s, s->buf, s->len / STRIPE - 1);
+  }
+  for (; size >= STRIPE; p += STRIPE, size -= STRIPE, s->len += STRIPE) {
+    hash_stripe(s, p, s->len / STRIPE);
+  }
+  memcpy(s->buf, p, size);
+  s->len += size;
+}
+
+static uint64_t hash_final(HashState *s) {
+  uint64_t pend = s->len % STRIPE;
+  if (pend != 0) {
+    memset(s->buf + pend, 0, STRIPE - pend);
+    accumulate(s->acc, s->buf);
+  }
+  uint64_t h = s->len * PRIME64_1;
+  int i;
+  for (i = 0; i < NR_LANE; i += 2) h += mix(s->acc[i] ^ key[i], s->acc[i + 1] ^ key[i + 1]);
+  return avalanche(h ^ PRIME64_2);
+}
+
+bool memhash_set(const char *spec) {
+  char *buf = strdup(spec), *save = NULL, *item;
+  char *eq = strchr(buf, '=');
+  bool ok = true;
+  if (eq != NULL) {
+    char *end;
+    *eq ++ = '\0';
+    expected = strtoull(eq, &end, 16);
+    has_expected = true;
+    ok = (*eq != '\0' && *end == '\0');
+  }
+  nr_range = 0;
+  for (item = strtok_r(buf, ",", &save); ok && item != NULL; item = strtok_r(NULL, ",", &save)) {
+    char *end;
+    uint64_t lo = strtoull(item, &end, 0), hi;
+    ok = (*end == ':' && nr_range < MAX_RANGE);
+    if (!ok) break;
+    hi = strtoull(end + 1, &end, 0);
+    ok = (*end == '\0' && lo < hi && in_pmem(lo) && in_pmem(hi - 1));
+    if (ok) { range[nr_range].lo = lo; range[nr_range].hi = hi; nr_range ++; }
+  }
+  free(buf);
+  if (!ok || nr_range == 0) {
+    Log("hash-mem: bad spec '%s', which should be LO:HI[,LO:HI...][=EXPECTED] inside pmem", spec);
+    nr_range = 0;
+    has_expected = false;
+    return false;
+  }
+  return true;
+}
+
+/* Called when the guest ends, return false if the hash is not the one
+ * expected. */
+bool memhash_check() {
+  if (nr_range == 0) return true;
+  HashState s = { .acc = {
+    PRIME32_1, PRIME64_1, PRIME64_2, 0x165667b19e3779f9ull,
+    0x85ebca77c2b2ae63ull, 0x27d4eb2f165667c5ull, 0xc2b2ae3d27d4eb4full, 0x9e3779b1u,
+  } };
+  uint64_t t0 = get_time();
+  int i;
+  for (i = 0; i < nr_range; i ++) {
+    hash_update(&s, guest_to_host(range[i].lo), range[i].hi - range[i].lo);
+  }
+  uint64_t h = hash_final(&s);
+  Log("hash-mem: %" PRIu64 " bytes hashed to %016" PRIx64 " in %" PRIu64 " us", s.len, h, get_time() - t0);
+  if (has_expected && h != expected) {
+    Log("hash-mem: " ANSI_FMT("mismatch", ANSI_FG_RED) ", %016" PRIx64 " is expected", expected);
+    return false;
+  }
+  return true;
+}
@@ -0,0 +1,118 @@
+/***************************************************************************************
+* Copyright (c) 2014-2024 Zihao Yu, Nanjing University
+*
+* NEMU is licensed under Mulan PSL v2.
+* You can use this software according to the terms and conditions of the Mulan PSL v2.
+* You may obtain a copy of Mulan PSL v2 at:
+*          http://license.coscl.org.cn/MulanPSL2
+*
+* THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+* EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+* MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+*
+* See the Mulan PSL v2 for more details.
+***************************************************************************************/
+
+
+#include <isa.h>
+#include <signal.h>
+#include <sys/time.h>
+
+/* The pc of the guest is sampled by SIGPROF on a timer of host CPU time,
+ * and counted in a hash table, so that the execution loops are untouched.
+ * The handler only writes the table, which is read when reporting. */
+#define HASH_SIZE 65536
+#define NR_REPORT 20
+
+static struct {
+  vaddr_t pc;
+  uint64_t count; // 0 for an empty entry
+} hist[HASH_SIZE];
+static uint64_t nr_sample = 0, nr_drop = 0;
+static char *folded_file = NULL;
+
+static void profile_handler(int sig) {
+  vaddr_t pc = cpu.pc;
+  uint32_t i = (pc ^ (pc >> 16)) % HASH_SIZE, n;
+  nr_sample ++;
+  for (n = 0; n < HASH_SIZE; n ++, i = (i + 1) % HASH_SIZE) {
+    if (hist[i].count == 0) hist[i].pc = pc;
+    if (hist[i].pc == pc) {
+      hist[i].count ++;
+      return;
+    }
+  }
+  nr_drop ++;
+}
+
+void profile_start(const char *file) {
+  folded_file = strdup(file);
+  struct sigaction s = {};
+  s.sa_handler = profile_handler;
+  s.sa_flags = SA_RESTART;
+  int ret = sigaction(SIGPROF, &s, NULL);
+  Assert(ret == 0, "Can not set up the handler of SIGPROF");
+  struct itimerval it = {};
+  it.it_interval.tv_usec = it.it_value.tv_usec = 1000000 / CONFIG_PROFILE_FREQ;
+  ret = setitimer(ITIMER_PROF, &it, NULL);
+  Assert(ret == 0, "Can not start the timer of profiling");
+}
+
+typedef struct {
+  const char *name; // NULL if the pc is not in any function
+  vaddr_t pc;
+  uint64_t count;
+} Item;
+
+static int item_cmp_name(const void *a, const void *b) {
+  const Item *x = a, *y = b;
+  if (x->name != y->name) return (x->name > y->name) - (x->name < y->name);
+  return (x->pc > y->pc) - (x->pc < y->pc);
+}
+
+static int item_cmp_count(const void *a, const void *b) {
+  uint64_t x = ((const Item *)a)->count, y = ((const Item *)b)->count;
+  return (x < y) - (x > y);
+}
+
+// report the hot functions, or the hot pc not in any function
+void profile_report() {
+  if (folded_file == NULL || nr_sample == 0) return;
+  // block the timer while reading the table
+  sigset_t set, old;
+  sigemptyset(&set);
+  sigaddset(&set, SIGPROF);
+  sigprocmask(SIG_BLOCK, &set, &old);
+
+  Item *item = malloc(sizeof(Item) * HASH_SIZE);
+  assert(item != NULL);
+  int nr = 0, i;
+  for (i = 0; i < HASH_SIZE; i ++) {
+    if (hist[i].count == 0) continue;
+    item[nr ++] = (Item) { .name = symbol_lookup(hist[i].pc, NULL), .pc = hist[i].pc, .count = hist[i].count };
+  }
+  uint64_t total = nr_sample;
+  sigprocmask(SIG_SETMASK, &old, NULL);
+
+  // merge the samples of each function
+  qsort(item, nr, sizeof(Item), item_cmp_name);
+  int n = 0;
+  for (i = 0; i < nr; i ++) {
+    if (n > 0 && item[i].name != NULL && item[i].name == item[n - 1].name) item[n - 1].count += item[i].count;
+    else item[n ++] = item[i];
+  }
+  qsort(item, n, sizeof(Item), item_cmp_count);
+
+  FILE *fp = fopen(folded_file, "w");
+  if (fp == NULL) Log_warn("profile: can not open '%s'", folded_file);
+  Log("profile: %" PRIu64 " samples, %" PRIu64 " dropped, the hottest:", total, nr_drop);
+  for (i = 0; i < n; i ++) {
+    char pc[32];
+    snprintf(pc, sizeof(pc), FMT_WORD, item[i].pc);
+    const char *name = (item[i].name != NULL ? item[i].name : pc);
+    if (i < NR_REPORT) Log("  %6.2f%%  %s", item[i].count * 100.0 / total, name);
+    if (fp != NULL) fprintf(fp, "%s %" PRIu64 "\n", name, item[i].count);
+  }
+  if (fp != NULL) fclose(fp);
+  free(item);
+}
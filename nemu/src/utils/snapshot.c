@@ -0,0 +1,390 @@
+/***************************************************************************************
+* Copyright (c) 2014-2024 Zihao Yu, Nanjing University
+*
+* NEMU is licensed under Mulan PSL v2.
+* You can use this software according to the terms and conditions of the Mulan PSL v2.
+* You may obtain a copy of Mulan PSL v2 at:
+*          http://license.coscl.org.cn/MulanPSL2
+*
+* THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+* EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+* MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+*
+* See the Mulan PSL v2 for more details.
+***************************************************************************************/
+
+
+#include <isa.h>
+#include <memory/paddr.h>
+#include <memory/vaddr.h>
+#include <cpu/difftest.h>
+#include <device/map.h>
+#include <device/snapshot.h>
+#include <zlib.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+/* A snapshot file holds a header, the registers, pmem, the memory of the
+ * devices and the state of the device hooks, compressed by zlib. pmem is
+ * sparse: the byte filling most of the blank pages, a bitmap of the other
+ * pages, and these pages only. The state of the hooks is a sequence of
+ * sections of a name, a length and the data, so that a section without a
+ * hook is skipped on loading. */
+#define SNAPSHOT_MAGIC "NEMUSNAP"
+#define SNAPSHOT_VERSION 4
+#define NAME_LEN 16
+#define NR_HOOK 16
+#define IO_CHUNK (1024 * 1024)
+#define NR_PAGE (CONFIG_MSIZE / PAGE_SIZE)
+
+typedef struct {
+  char magic[8];
+  uint32_t version;
+  uint32_t word_bytes;
+  char isa[NAME_LEN];
+  uint64_t mbase, msize;
+  uint64_t io_size;
+} SnapshotHeader;
+
+struct Snapshot {
+  uint8_t *buf;
+  size_t size, pos;
+  bool is_load;
+  bool is_replay;
+  bool truncated;
+};
+
+static struct {
+  const char *name;
+  snapshot_hook_t hook;
+} hooks[NR_HOOK];
+static int nr_hook = 0;
+
+extern uint64_t g_nr_guest_inst;
+extern bool g_trace_on;
+
+void snapshot_register(const char *name, snapshot_hook_t hook) {
+  Assert(nr_hook < NR_HOOK, "Too many snapshot hooks");
+  Assert(strlen(name) < NAME_LEN, "The name of snapshot hook %s is too long", name);
+  hooks[nr_hook].name = name;
+  hooks[nr_hook].hook = hook;
+  nr_hook ++;
+}
+
+bool snapshot_is_load(Snapshot *s) { return s->is_load; }
+bool snapshot_is_replay(Snapshot *s) { return s->is_replay; }
+
+void snapshot_io(Snapshot *s, void *buf, size_t len) {
+  if (s->is_load) {
+    // the state is kept if the section is shorter than expected
+    if (s->pos + len > s->size) { s->truncated = true; return; }
+    memcpy(buf, s->buf + s->pos, len);
+  } else {
+    if (s->pos + len > s->size) {
+      s->size = (s->pos + len) * 2;
+      s->buf = realloc(s->buf, s->size);
+      assert(s->buf);
+    }
+    memcpy(s->buf + s->pos, buf, len);
+  }
+  s->pos += len;
+}
+
+// sections of all hooks, `s->pos` is the length
+static void save_hooks(Snapshot *s) {
+  int i;
+  for (i = 0; i < nr_hook; i ++) {
+    char name[NAME_LEN] = {};
+    strcpy(name, hooks[i].name);
+    snapshot_io(s, name, NAME_LEN);
+    uint32_t len = 0;
+    size_t len_pos = s->pos;
+    SNAPSHOT_VAR(s, len);
+    hooks[i].hook(s);
+    len = s->pos - len_pos - sizeof(len);
+    memcpy(s->buf + len_pos, &len, sizeof(len));
+  }
+}
+
+static void load_hooks(uint8_t *buf, size_t size, bool is_replay) {
+  size_t pos = 0;
+  while (pos + NAME_LEN + sizeof(uint32_t) <= size) {
+    char name[NAME_LEN];
+    uint32_t len;
+    memcpy(name, buf + pos, NAME_LEN);
+    name[NAME_LEN - 1] = '\0';
+    memcpy(&len, buf + pos + NAME_LEN, sizeof(len));
+    pos += NAME_LEN + sizeof(len);
+    if (len > size - pos) break;
+    int i;
+    for (i = 0; i < nr_hook; i ++) {
+      if (strcmp(name, hooks[i].name) != 0) continue;
+      Snapshot s = { .buf = buf + pos, .size = len, .is_load = true, .is_replay = is_replay };
+      hooks[i].hook(&s);
+      if (s.truncated || s.pos != len) Log_warn("The state of %s in the snapshot does not match", name);
+      break;
+    }
+    if (i == nr_hook) Log("Skip the state of %s in the snapshot", name);
+    pos += len;
+  }
+}
+
+static bool gz_io(gzFile f, void *buf, size_t len, bool is_load) {
+  uint8_t *p = buf;
+  while (len > 0) {
+    unsigned n = (len < IO_CHUNK ? len : IO_CHUNK);
+    int ret = (is_load ? gzread(f, p, n) : gzwrite(f, p, n));
+    if (ret != n) return false;
+    p += n;
+    len -= n;
+  }
+  return true;
+}
+
+// the spaces of all devices in turn, without the guard pages between them
+static bool gz_io_space(gzFile f, bool is_load) {
+  size_t size;
+  uint8_t *io;
+  int i;
+  for (i = 0; (io = io_space_get(i, &size)) != NULL; i ++) {
+    if (!gz_io(f, io, size, is_load)) return false;
+  }
+  return true;
+}
+
+static uint64_t io_space_total() {
+  size_t size;
+  uint64_t total = 0;
+  int i;
+  for (i = 0; io_space_get(i, &size) != NULL; i ++) total += size;
+  return total;
+}
+
+static bool save_pmem(gzFile f) {
+  static uint8_t bitmap[(NR_PAGE + 7) / 8];
+  int16_t *blank = malloc(NR_PAGE * sizeof(*blank));
+  assert(blank);
+  uint32_t count[256] = {};
+  size_t i;
+  for (i = 0; i < NR_PAGE; i ++) {
+    uint8_t byte;
+    blank[i] = (paddr_page_blank(CONFIG_MBASE + i * PAGE_SIZE, &byte) ? byte : -1);
+    if (blank[i] >= 0) count[byte] ++;
+  }
+  uint8_t fill = 0;
+  for (i = 1; i < 256; i ++) {
+    if (count[i] > count[fill]) fill = i;
+  }
+  memset(bitmap, 0, sizeof(bitmap));
+  for (i = 0; i < NR_PAGE; i ++) {
+    if (blank[i] != fill) bitmap[i / 8] |= 1 << (i % 8);
+  }
+  free(blank);
+  bool ok = gz_io(f, &fill, sizeof(fill), false) && gz_io(f, bitmap, sizeof(bitmap), false);
+  for (i = 0; ok && i < NR_PAGE; i ++) {
+    if (!(bitmap[i / 8] & (1 << (i % 8)))) continue;
+    paddr_host_access(CONFIG_MBASE + i * PAGE_SIZE, PAGE_SIZE);
+    ok = gz_io(f, guest_to_host(CONFIG_MBASE + i * PAGE_SIZE), PAGE_SIZE, false);
+  }
+  return ok;
+}
+
+// blank pages are left to paddr_fill(), which does not commit them
+static bool load_pmem(gzFile f) {
+  static uint8_t bitmap[(NR_PAGE + 7) / 8];
+  uint8_t fill;
+  if (!gz_io(f, &fill, sizeof(fill), true) || !gz_io(f, bitmap, sizeof(bitmap), true)) return false;
+  paddr_fill(fill);
+  size_t i;
+  for (i = 0; i < NR_PAGE; i ++) {
+    if (!(bitmap[i / 8] & (1 << (i % 8)))) continue;
+    paddr_host_access(CONFIG_MBASE + i * PAGE_SIZE, PAGE_SIZE);
+    if (!gz_io(f, guest_to_host(CONFIG_MBASE + i * PAGE_SIZE), PAGE_SIZE, true)) return false;
+  }
+  return true;
+}
+
+static void init_header(SnapshotHeader *h) {
+  memset(h, 0, sizeof(*h));
+  memcpy(h->magic, SNAPSHOT_MAGIC, sizeof(h->magic));
+  h->version = SNAPSHOT_VERSION;
+  h->word_bytes = sizeof(word_t);
+  strncpy(h->isa, str(__GUEST_ISA__), NAME_LEN - 1);
+  h->mbase = CONFIG_MBASE;
+  h->msize = CONFIG_MSIZE;
+  h->io_size = io_space_total();
+}
+
+bool snapshot_save(const char *file) {
+  gzFile f = gzopen(file, "wb1");
+  if (f == NULL) return false;
+  SnapshotHeader h;
+  init_header(&h);
+  Snapshot s = {};
+  save_hooks(&s);
+  uint64_t hook_size = s.pos;
+  bool ok = gz_io(f, &h, sizeof(h), false) &&
+    gz_io(f, &cpu, sizeof(cpu), false) &&
+    gz_io(f, &g_nr_guest_inst, sizeof(g_nr_guest_inst), false) &&
+    save_pmem(f) &&
+    gz_io_space(f, false) &&
+    gz_io(f, &hook_size, sizeof(hook_size), false) &&
+    gz_io(f, s.buf, hook_size, false);
+  free(s.buf);
+  return (gzclose(f) == Z_OK) && ok;
+}
+
+bool snapshot_load(const char *file) {
+  gzFile f = gzopen(file, "rb");
+  if (f == NULL) return false;
+  SnapshotHeader h, expected;
+  init_header(&expected);
+  if (!gz_io(f, &h, sizeof(h), true) || memcmp(&h, &expected, sizeof(h)) != 0) {
+    printf("\"%s\" is not a snapshot of this build of NEMU\n", file);
+    gzclose(f);
+    return false;
+  }
+
+  CPU_state c;
+  uint64_t nr_inst, hook_size = 0;
+  bool ok = gz_io(f, &c, sizeof(c), true) && gz_io(f, &nr_inst, sizeof(nr_inst), true);
+  if (!ok) { gzclose(f); return false; }
+
+  if (g_trace_on) difftest_detach();
+  // pmem and the devices are overwritten in place
+  ok = load_pmem(f) &&
+    gz_io_space(f, true) &&
+    gz_io(f, &hook_size, sizeof(hook_size), true);
+  uint8_t *buf = (ok ? malloc(hook_size) : NULL);
+  ok = ok && buf != NULL && gz_io(f, buf, hook_size, true);
+  gzclose(f);
+  if (!ok) panic("Snapshot \"%s\" is truncated, the state is partially loaded", file);
+
+  cpu = c;
+  g_nr_guest_inst = nr_inst;
+  load_hooks(buf, hook_size, false);
+  free(buf);
+  vaddr_tlb_flush();
+  // drop the instructions cached from the old pmem, and update REF
+  paddr_host_written(CONFIG_MBASE, CONFIG_MSIZE);
+  if (g_trace_on) difftest_attach();
+  if (nemu_state.state != NEMU_RUNNING) nemu_state.state = NEMU_STOP;
+  // the history before loading is not reachable any more
+  IFDEF(CONFIG_REVERSE, void reverse_reset(); reverse_reset());
+  return true;
+}
+
+// the memory and the hooks of the devices, for checkpoints of reverse execution
+void* snapshot_save_devices(size_t *size) {
+  Snapshot s = { .is_replay = true };
+  size_t io_size;
+  uint8_t *io;
+  int i;
+  for (i = 0; (io = io_space_get(i, &io_size)) != NULL; i ++) snapshot_io(&s, io, io_size);
+  save_hooks(&s);
+  *size = s.pos;
+  return s.buf;
+}
+
+void snapshot_load_devices(void *buf, size_t size) {
+  size_t io_size, pos = 0;
+  uint8_t *io;
+  int i;
+  for (i = 0; (io = io_space_get(i, &io_size)) != NULL; i ++) {
+    assert(pos + io_size <= size);
+    memcpy(io, (uint8_t *)buf + pos, io_size);
+    pos += io_size;
+  }
+  load_hooks((uint8_t *)buf + pos, size - pos, true);
+}
+
+/* The fast path forks a child holding the snapshot, which is frozen until
+ * the snapshot is loaded, so that saving and loading only copy the pages
+ * written later. On loading, the process running the guest waits for the
+ * child to finish as the new one, and the child forks another frozen copy
+ * first, so that the snapshot can be loaded again. Only the thread calling
+ * fork() is copied, so the fast path is refused if there are others. */
+static int snap_fd = -1;
+static pid_t snap_pid = 0;
+
+static int nr_thread() {
+  FILE *fp = fopen("/proc/self/status", "r");
+  if (fp == NULL) return 1;
+  char line[128];
+  int n = 1;
+  while (fgets(line, sizeof(line), fp)) {
+    if (sscanf(line, "Threads: %d", &n) == 1) break;
+  }
+  fclose(fp);
+  return n;
+}
+
+static void snapshot_drop() {
+  if (snap_pid == 0) return;
+  close(snap_fd);
+  waitpid(snap_pid, NULL, 0);
+  snap_fd = -1;
+  snap_pid = 0;
+}
+
+// return 0 after saving, 1 after loading, and -1 on failure
+int snapshot_fork() {
+  int n = nr_thread();
+  if (n > 1) {
+    printf("NEMU is running %d threads, which can not be forked, use \"save FILE\" instead\n", n);
+    return -1;
+  }
+  snapshot_drop();
+  // the state of the hooks is restored after resuming, e.g. the time of rtc
+  Snapshot s = {};
+  save_hooks(&s);
+  bool resumed = false;
+  while (true) {
+    int fd[2];
+    if (pipe(fd) != 0) { free(s.buf); return -1; }
+    fflush(NULL);
+    pid_t pid = fork();
+    if (pid < 0) { close(fd[0]); close(fd[1]); free(s.buf); return -1; }
+    if (pid > 0) {
+      close(fd[0]);
+      snap_fd = fd[1];
+      snap_pid = pid;
+      break;
+    }
+
+    close(fd[1]);
+    struct sigaction ign = { .sa_handler = SIG_IGN }, old;
+    sigaction(SIGINT, &ign, &old);
+    char c;
+    ssize_t ret;
+    do { ret = read(fd[0], &c, 1); } while (ret < 0 && errno == EINTR);
+    // the snapshot is dropped by closing the pipe
+    if (ret != 1) _exit(0);
+    close(fd[0]);
+    sigaction(SIGINT, &old, NULL);
+    resumed = true;
+  }
+  if (resumed) load_hooks(s.buf, s.pos, false);
+  free(s.buf);
+  return resumed;
+}
+
+void snapshot_fork_load() {
+  if (snap_pid == 0) { printf("No snapshot is saved\n"); return; }
+  struct sigaction ign = { .sa_handler = SIG_IGN };
+  sigaction(SIGINT, &ign, NULL);
+  fflush(NULL);
+  // the pages written since the snapshot are no longer needed
+  uintptr_t lo = ROUNDUP((uintptr_t)guest_to_host(CONFIG_MBASE), PAGE_SIZE);
+  uintptr_t hi = ROUNDDOWN((uintptr_t)guest_to_host(CONFIG_MBASE) + CONFIG_MSIZE, PAGE_SIZE);
+  madvise((void *)lo, hi - lo, MADV_DONTNEED);
+  char c = 0;
+  int ret = write(snap_fd, &c, 1);
+  assert(ret == 1);
+  int status;
+  waitpid(snap_pid, &status, 0);
+  _exit(WIFEXITED(status) ? WEXITSTATUS(status) : 1);
+}
@@ -0,0 +1,139 @@
+/***************************************************************************************
+* Copyright (c) 2014-2024 Zihao Yu, Nanjing University
+*
+* NEMU is licensed under Mulan PSL v2.
+* You can use this software according to the terms and conditions of the Mulan PSL v2.
+* You may obtain a copy of Mulan PSL v2 at:
+*          http://license.coscl.org.cn/MulanPSL2
+*
+* THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+* EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+* MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+*
+* See the Mulan PSL v2 for more details.
+***************************************************************************************/
+
+
+#include <common.h>
+#include <time.h>
+
+/* The host time of each phase of init_monitor(), of the time spent in
+ * devices, differential testing and tracing while running, and the speed
+ * sampled every CONFIG_STATS_INTERVAL instructions. They are reported in
+ * the log at the end, and also written to FILE in JSON with --stats=FILE. */
+
+#define NR_PHASE 16
+
+static const char *kind_name[NR_STATS] = {
+  [STATS_DEVICE] = "device", [STATS_DIFFTEST] = "difftest", [STATS_TRACE] = "trace",
+};
+uint64_t stats_ns[NR_STATS] = {};
+
+static struct {
+  const char *name;
+  uint64_t ns;
+} phase[NR_PHASE];
+static int nr_phase = 0;
+static uint64_t phase_start = 0;
+
+typedef struct {
+  uint64_t inst;
+  uint64_t ns; // the host time spent in cpu_exec() until then
+} Sample;
+static Sample *sample = NULL;
+static size_t nr_sample = 0, max_sample = 0;
+static uint64_t next_sample = CONFIG_STATS_INTERVAL;
+static uint64_t exec_ns = 0, exec_start = 0;
+
+static char *json_file = NULL;
+
+uint64_t stats_clock() {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec * 1000000000ull + now.tv_nsec;
+}
+
+void stats_set_json(const char *file) {
+  json_file = strdup(file);
+}
+
+// end the current phase, and start a phase named `name` unless it is NULL
+void stats_phase(const char *name) {
+  uint64_t now = stats_clock();
+  if (nr_phase > 0 && phase_start != 0) phase[nr_phase - 1].ns = now - phase_start;
+  phase_start = 0;
+  if (name == NULL || nr_phase == NR_PHASE) return;
+  phase[nr_phase ++].name = name;
+  phase_start = now;
+}
+
+void stats_exec(bool start) {
+  uint64_t now = stats_clock();
+  if (start) exec_start = now;
+  else exec_ns += now - exec_start;
+}
+
+// return the number of instructions to run before the next sample, up to `n`
+uint64_t stats_limit(uint64_t n) {
+  extern uint64_t g_nr_guest_inst;
+  uint64_t left = (next_sample > g_nr_guest_inst ? next_sample - g_nr_guest_inst : 1);
+  return (left < n ? left : n);
+}
+
+void stats_sample() {
+  extern uint64_t g_nr_guest_inst;
+  if (g_nr_guest_inst < next_sample) return;
+  // instructions may be skipped by CONFIG_IDLE_SLEEP
+  while (next_sample <= g_nr_guest_inst) next_sample += CONFIG_STATS_INTERVAL;
+  if (nr_sample == max_sample) {
+    max_sample = (max_sample == 0 ? 1024 : max_sample * 2);
+    sample = realloc(sample, sizeof(Sample) * max_sample);
+    assert(sample != NULL);
+  }
+  sample[nr_sample ++] = (Sample) { g_nr_guest_inst, exec_ns + stats_clock() - exec_start };
+}
+
+static void write_json(FILE *fp) {
+  void statistic_json(FILE *fp);
+  fputs("{\"total\": ", fp);
+  statistic_json(fp);
+  fputs(",\n\"phase\": [", fp);
+  int i;
+  for (i = 0; i < nr_phase; i ++) {
+    fprintf(fp, "%s{\"name\": \"%s\", \"us\": %" PRIu64 "}", (i == 0 ? "" : ", "),
+        phase[i].name, phase[i].ns / 1000);
+  }
+  fputs("],\n\"exec\": {", fp);
+  fprintf(fp, "\"us\": %" PRIu64, exec_ns / 1000);
+  for (i = 0; i < NR_STATS; i ++) fprintf(fp, ", \"%s_us\": %" PRIu64, kind_name[i], stats_ns[i] / 1000);
+  fputs("},\n\"timeline\": [", fp);
+  size_t j;
+  for (j = 0; j < nr_sample; j ++) {
+    const Sample *prev = (j == 0 ? &(Sample) { 0, 0 } : &sample[j - 1]);
+    uint64_t ns = sample[j].ns - prev->ns;
+    fprintf(fp, "%s\n  {\"inst\": %" PRIu64 ", \"us\": %" PRIu64 ", \"mips\": %.2f}", (j == 0 ? "" : ","),
+        sample[j].inst, sample[j].ns / 1000, (ns > 0 ? (sample[j].inst - prev->inst) * 1000.0 / ns : 0.0));
+  }
+  fputs("\n]}\n", fp);
+}
+
+void stats_report() {
+  uint64_t init_ns = 0;
+  int i;
+  for (i = 0; i < nr_phase; i ++) init_ns += phase[i].ns;
+  Log("init time = %" PRIu64 " us", init_ns / 1000);
+  for (i = 0; i < nr_phase; i ++) {
+    Log("  %-10s %10" PRIu64 " us", phase[i].name, phase[i].ns / 1000);
+  }
+  Log("time in devices = %" PRIu64 " us, difftest = %" PRIu64 " us, trace = %" PRIu64 " us",
+      stats_ns[STATS_DEVICE] / 1000, stats_ns[STATS_DIFFTEST] / 1000, stats_ns[STATS_TRACE] / 1000);
+
+  if (json_file != NULL) {
+    FILE *fp = fopen(json_file, "w");
+    if (fp == NULL) Log_warn("Can not open '%s'", json_file);
+    else {
+      write_json(fp);
+      fclose(fp);
+    }
+  }
+}
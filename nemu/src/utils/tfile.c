@@ -0,0 +1,163 @@
+/***************************************************************************************
+* Copyright (c) 2014-2024 Zihao Yu, Nanjing University
+*
+* NEMU is licensed under Mulan PSL v2.
+* You can use this software according to the terms and conditions of the Mulan PSL v2.
+* You may obtain a copy of Mulan PSL v2 at:
+*          http://license.coscl.org.cn/MulanPSL2
+*
+* THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+* EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+* MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+*
+* See the Mulan PSL v2 for more details.
+***************************************************************************************/
+
+
+#include <common.h>
+#include <tring-def.h>
+#include <zlib.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+/* A trace file written sequentially. A file whose name ends with ".gz" is
+ * compressed by zlib at the fastest level. If CONFIG_TRACE_FILE_MAX is not
+ * 0, a file growing larger than that is renamed to NAME.1, replacing the
+ * older one, and NAME is started again with the same header. At most two
+ * files are then kept for a trace of any length.
+ *
+ * A file whose name ends with ".ring" is instead a circular file of
+ * CONFIG_TRACE_RING_SIZE, see include/tring-def.h. It is mapped into memory,
+ * so that writing is a memcpy() without system calls, and the pages written
+ * are in the page cache even if NEMU is killed. */
+struct TraceFile {
+  char *name;
+  FILE *fp;
+  gzFile gz;
+  TRingHeader *ring;
+  size_t map_len;
+  void *header;
+  size_t header_len;
+  uint64_t size; // bytes written to the current file before compression
+};
+
+#define FILE_MAX ((uint64_t)CONFIG_TRACE_FILE_MAX << 20)
+#define RING_SIZE ((uint64_t)CONFIG_TRACE_RING_SIZE << 20)
+
+static bool has_suffix(const char *name, const char *suffix) {
+  size_t len = strlen(name), n = strlen(suffix);
+  return len > n && strcmp(name + len - n, suffix) == 0;
+}
+
+static bool open_ring(TraceFile *f) {
+  int fd = open(f->name, O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) return false;
+  size_t page = sysconf(_SC_PAGESIZE);
+  uint64_t data_off = (sizeof(TRingHeader) + f->header_len + page - 1) / page * page;
+  f->map_len = data_off + RING_SIZE;
+  // allocate the blocks now, instead of getting SIGBUS when the disk is full
+  void *p = MAP_FAILED;
+  if (posix_fallocate(fd, 0, f->map_len) == 0) {
+    p = mmap(NULL, f->map_len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  }
+  close(fd);
+  if (p == MAP_FAILED) return false;
+  TRingHeader *r = f->ring = p;
+  r->header_len = f->header_len;
+  r->data_off = data_off;
+  r->data_size = RING_SIZE;
+  r->begin = r->end = 0;
+  memcpy(r + 1, f->header, f->header_len);
+  // the magic is written last, as a file with it is complete
+  memcpy(r->magic, TRING_MAGIC, sizeof(r->magic));
+  return true;
+}
+
+static void ring_write(TraceFile *f, const uint8_t *buf, size_t len) {
+  TRingHeader *r = f->ring;
+  uint64_t size = r->data_size, end = r->end + len;
+  if (len > size) { buf += len - size; len = size; }
+  if (end - r->begin > size) {
+    __atomic_store_n(&r->begin, end - size, __ATOMIC_RELAXED);
+    // before overwriting the oldest bytes
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+  }
+  uint8_t *data = (uint8_t *)r + r->data_off;
+  uint64_t off = (end - len) % size, n = (len < size - off ? len : size - off);
+  memcpy(data + off, buf, n);
+  memcpy(data, buf + n, len - n);
+  __atomic_store_n(&r->end, end, __ATOMIC_RELEASE);
+}
+
+static bool reopen(TraceFile *f) {
+  if (has_suffix(f->name, ".gz")) {
+    f->gz = gzopen(f->name, "wb1");
+    if (f->gz == NULL) return false;
+    gzbuffer(f->gz, 1 << 20);
+    gzwrite(f->gz, f->header, f->header_len);
+  } else {
+    f->fp = fopen(f->name, "wb");
+    if (f->fp == NULL) return false;
+    fwrite(f->header, 1, f->header_len, f->fp);
+  }
+  f->size = f->header_len;
+  return true;
+}
+
+static void close_file(TraceFile *f) {
+  if (f->gz != NULL) gzclose(f->gz);
+  if (f->fp != NULL) fclose(f->fp);
+  f->gz = NULL;
+  f->fp = NULL;
+}
+
+TraceFile *tfile_open(const char *file, const void *header, size_t header_len) {
+  TraceFile *f = calloc(1, sizeof(TraceFile));
+  assert(f != NULL);
+  f->name = strdup(file);
+  f->header = malloc(header_len + 1);
+  if (header_len > 0) memcpy(f->header, header, header_len);
+  f->header_len = header_len;
+  if (!(has_suffix(file, ".ring") ? open_ring(f) : reopen(f))) {
+    free(f->name);
+    free(f->header);
+    free(f);
+    return NULL;
+  }
+  return f;
+}
+
+void tfile_write(TraceFile *f, const void *buf, size_t len) {
+  if (f->ring != NULL) {
+    ring_write(f, buf, len);
+    return;
+  }
+  if (FILE_MAX != 0 && f->size + len > FILE_MAX && f->size > f->header_len) {
+    close_file(f);
+    char *old = malloc(strlen(f->name) + 3);
+    sprintf(old, "%s.1", f->name);
+    rename(f->name, old);
+    free(old);
+    bool ok = reopen(f);
+    Assert(ok, "Can not reopen '%s'", f->name);
+  }
+  if (f->gz != NULL) gzwrite(f->gz, buf, len);
+  else fwrite(buf, 1, len, f->fp);
+  f->size += len;
+}
+
+void tfile_flush(TraceFile *f) {
+  // nothing to do for a ring, whose pages are in the page cache already
+  if (f->ring != NULL) return;
+  if (f->gz != NULL) gzflush(f->gz, Z_SYNC_FLUSH);
+  else fflush(f->fp);
+}
+
+void tfile_close(TraceFile *f) {
+  if (f->ring != NULL) munmap(f->ring, f->map_len);
+  close_file(f);
+  free(f->name);
+  free(f->header);
+  free(f);
+}
@@ -45,5 +45,6 @@ uint64_t get_time() {
 }
 
 void init_rand() {
-  srand(get_time_internal());
+  // virtual time is meant to be reproducible, so is the random memory
+  srand(MUXDEF(CONFIG_TIMER_VIRTUAL, 0, get_time_internal()));
 }
@@ -0,0 +1,209 @@
+/***************************************************************************************
+* Copyright (c) 2014-2024 Zihao Yu, Nanjing University
+*
+* NEMU is licensed under Mulan PSL v2.
+* You can use this software according to the terms and conditions of the Mulan PSL v2.
+* You may obtain a copy of Mulan PSL v2 at:
+*          http://license.coscl.org.cn/MulanPSL2
+*
+* THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+* EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+* MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+*
+* See the Mulan PSL v2 for more details.
+***************************************************************************************/
+
+
+/* Compare the speed of NEMU on the benchmarks of `make bench` against a
+ * baseline, as done by `make bench-regress`.
+ *   usage: bench-cmp [-t THRESHOLD] [-a ALPHA] [-j JSON] BASE CURRENT
+ * BASE and CURRENT are the results of several runs of `make bench`,
+ * concatenated. For each benchmark, the MIPS of the runs are compared by
+ * Welch's t-test, and it is reported slower if the slowdown is more than
+ * THRESHOLD percent (3 by default) and significant at level ALPHA (0.05 by
+ * default). The report is printed, and also written to JSON if given. The
+ * exit status is 1 if any benchmark is slower. */
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define MAX_BENCH 32
+#define MAX_RUN   64
+
+typedef struct {
+  char name[32];
+  double mips[MAX_RUN];
+  int n;
+} Bench;
+
+typedef struct {
+  char label[64];
+  Bench bench[MAX_BENCH];
+  int nr_bench;
+  int nr_run;
+} Result;
+
+static Bench* find_bench(Result *r, const char *name, bool create) {
+  int i;
+  for (i = 0; i < r->nr_bench; i ++) {
+    if (strcmp(r->bench[i].name, name) == 0) return &r->bench[i];
+  }
+  if (!create || r->nr_bench == MAX_BENCH) return NULL;
+  Bench *b = &r->bench[r->nr_bench ++];
+  snprintf(b->name, sizeof(b->name), "%s", name);
+  return b;
+}
+
+// runs failed are dropped, so that they are not taken as slow
+static void load_result(Result *r, const char *file) {
+  FILE *fp = fopen(file, "r");
+  if (fp == NULL) { perror(file); exit(2); }
+  memset(r, 0, sizeof(*r));
+  snprintf(r->label, sizeof(r->label), "%s", file);
+  char line[256], name[32], label[64], fail[8];
+  double inst, us;
+  while (fgets(line, sizeof(line), fp) != NULL) {
+    if (line[0] == '#') {
+      // "# NAME COMMIT DATE" heads each run
+      if (r->nr_run ++ == 0 && sscanf(line, "# %*s %63s", label) == 1) strcpy(r->label, label);
+      continue;
+    }
+    int n = sscanf(line, "%31s %lf %lf %*f %7s", name, &inst, &us, fail);
+    if (n < 3 || n == 4 || us <= 0) continue;
+    Bench *b = find_bench(r, name, true);
+    if (b != NULL && b->n < MAX_RUN) b->mips[b->n ++] = inst / us;
+  }
+  fclose(fp);
+}
+
+static void mean_var(const Bench *b, double *mean, double *var) {
+  double s = 0, ss = 0;
+  int i;
+  for (i = 0; i < b->n; i ++) s += b->mips[i];
+  *mean = s / b->n;
+  for (i = 0; i < b->n; i ++) ss += (b->mips[i] - *mean) * (b->mips[i] - *mean);
+  *var = (b->n > 1 ? ss / (b->n - 1) : 0);
+}
+
+// continued fraction of the regularized incomplete beta function
+static double betacf(double a, double b, double x) {
+  const double tiny = 1e-300;
+  double c = 1, d = 1 - (a + b) * x / (a + 1);
+  if (fabs(d) < tiny) d = tiny;
+  d = 1 / d;
+  double h = d;
+  int m;
+  for (m = 1; m <= 300; m ++) {
+    double aa = m * (b - m) * x / ((a + 2 * m - 1) * (a + 2 * m));
+    d = 1 + aa * d; if (fabs(d) < tiny) d = tiny;
+    c = 1 + aa / c; if (fabs(c) < tiny) c = tiny;
+    d = 1 / d; h *= d * c;
+    aa = -(a + m) * (a + b + m) * x / ((a + 2 * m) * (a + 2 * m + 1));
+    d = 1 + aa * d; if (fabs(d) < tiny) d = tiny;
+    c = 1 + aa / c; if (fabs(c) < tiny) c = tiny;
+    d = 1 / d;
+    double del = d * c;
+    h *= del;
+    if (fabs(del - 1) < 1e-12) break;
+  }
+  return h;
+}
+
+static double betai(double a, double b, double x) {
+  if (x <= 0) return 0;
+  if (x >= 1) return 1;
+  double bt = exp(lgamma(a + b) - lgamma(a) - lgamma(b) + a * log(x) + b * log(1 - x));
+  return (x < (a + 1) / (a + b + 2) ? bt * betacf(a, b, x) / a : 1 - bt * betacf(b, a, 1 - x) / b);
+}
+
+// two-sided p-value of Welch's t-test, NAN with less than 2 runs on either side
+static double welch_p(const Bench *x, const Bench *y) {
+  if (x->n < 2 || y->n < 2) return NAN;
+  double mx, vx, my, vy;
+  mean_var(x, &mx, &vx);
+  mean_var(y, &my, &vy);
+  double sx = vx / x->n, sy = vy / y->n;
+  if (sx + sy == 0) return (mx == my ? 1 : 0);
+  double t = (mx - my) / sqrt(sx + sy);
+  double df = (sx + sy) * (sx + sy) / (sx * sx / (x->n - 1) + sy * sy / (y->n - 1));
+  return betai(df / 2, 0.5, df / (df + t * t));
+}
+
+int main(int argc, char *argv[]) {
+  double threshold = 3, alpha = 0.05;
+  const char *json = NULL;
+  int o;
+  while ((o = getopt(argc, argv, "t:a:j:")) != -1) {
+    switch (o) {
+      case 't': threshold = atof(optarg); break;
+      case 'a': alpha = atof(optarg); break;
+      case 'j': json = optarg; break;
+      default: goto usage;
+    }
+  }
+  if (argc - optind != 2) {
+usage:
+    fprintf(stderr, "usage: %s [-t THRESHOLD] [-a ALPHA] [-j JSON] BASE CURRENT\n", argv[0]);
+    return 2;
+  }
+
+  static Result base, cur;
+  load_result(&base, argv[optind]);
+  load_result(&cur, argv[optind + 1]);
+
+  FILE *js = NULL;
+  if (json != NULL) {
+    js = fopen(json, "w");
+    if (js == NULL) { perror(json); return 2; }
+    fprintf(js, "{\"base\": \"%s\", \"current\": \"%s\", \"threshold\": %g, \"alpha\": %g, \"benchmarks\": [",
+        base.label, cur.label, threshold, alpha);
+  }
+
+  printf("base %s (%d runs), current %s (%d runs), threshold %g%%, alpha %g\n",
+      base.label, base.nr_run, cur.label, cur.nr_run, threshold, alpha);
+  printf("%-12s %18s %18s %9s %8s  %s\n", "name", "base MIPS", "current MIPS", "change", "p", "verdict");
+
+  // benchmarks only in the baseline are reported missing, those only in the current run new
+  Result all = cur;
+  int i, slower = 0;
+  for (i = 0; i < base.nr_bench; i ++) find_bench(&all, base.bench[i].name, true);
+  for (i = 0; i < all.nr_bench; i ++) {
+    const char *name = all.bench[i].name;
+    Bench *b = find_bench(&base, name, false), *c = find_bench(&cur, name, false);
+    double mb = NAN, vb = NAN, mc = NAN, vc = NAN, change = NAN, p = NAN;
+    const char *verdict;
+    if (b != NULL && b->n > 0) mean_var(b, &mb, &vb);
+    if (c != NULL && c->n > 0) mean_var(c, &mc, &vc);
+    if (isnan(mb)) verdict = "new";
+    else if (isnan(mc)) verdict = "missing";
+    else {
+      change = (mc - mb) / mb * 100;
+      p = welch_p(b, c);
+      if (isnan(p)) verdict = "too few runs";
+      else if (p >= alpha || fabs(change) <= threshold) verdict = "same";
+      else if (change < 0) { verdict = "SLOWER"; slower ++; }
+      else verdict = "faster";
+    }
+    printf("%-12s %9.2f +- %-5.2f %9.2f +- %-5.2f %+8.2f%% %8.4f  %s\n",
+        name, mb, sqrt(vb), mc, sqrt(vc), change, p, verdict);
+    if (js != NULL) {
+#define J(x) (isnan(x) ? 0 : (x))
+      fprintf(js, "%s\n  {\"name\": \"%s\", \"base_mips\": %.4f, \"base_sd\": %.4f, \"base_runs\": %d, "
+          "\"current_mips\": %.4f, \"current_sd\": %.4f, \"current_runs\": %d, "
+          "\"change_percent\": %.4f, \"p\": %.6f, \"verdict\": \"%s\"}",
+          (i == 0 ? "" : ","), name, J(mb), J(sqrt(vb)), (b ? b->n : 0),
+          J(mc), J(sqrt(vc)), (c ? c->n : 0), J(change), (isnan(p) ? 1 : p), verdict);
+#undef J
+    }
+  }
+  printf("%d benchmark(s) slower\n", slower);
+  if (js != NULL) {
+    fprintf(js, "\n], \"slower\": %d}\n", slower);
+    fclose(js);
+  }
+  return (slower > 0);
+}
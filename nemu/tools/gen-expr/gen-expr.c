@@ -16,95 +16,199 @@
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdbool.h>
 #include <time.h>
 #include <assert.h>
 #include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+
+/* Generate N lines of "RESULT EXPR" for `test_expr` in sdb. The results are
+ * computed by a reference evaluator in the process, and the expressions are
+ * generated by several threads, whose lines are written in chunks as they
+ * are ready, so millions of them can be streamed into NEMU. */
 
 static int NUM_MAX = 1024;
+// the tokenizer of sdb takes at most 31 tokens
+#define MAX_TOKEN 31
+#define CHUNK_SIZE 65536
+
+typedef struct {
+  uint32_t seed;
+  char buf[1024];
+  char *p;
+} Gen;
+
+typedef struct {
+  pthread_t thread;
+  uint32_t seed;
+  uint64_t n;
+} Worker;
 
-// this should be enough
-static char buf[65536] = {};
-static char code_buf[65536 + 128] = {}; // a little larger than `buf`
-static char *code_format =
-"#include <stdio.h>\n"
-"int main() { "
-"  unsigned result = %s; "
-"  printf(\"%%u\", result); "
-"  return 0; "
-"}";
+static pthread_mutex_t out_lock = PTHREAD_MUTEX_INITIALIZER;
 
 // return random generated num, num < max
-static unsigned int choose(unsigned int max)
+static unsigned int choose(Gen *g, unsigned int max)
 {
-	return ((unsigned)rand()) % max;
+	// xorshift32, since rand() is shared by the threads
+	uint32_t x = g->seed;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	g->seed = x;
+	return x % max;
 }
 
-static void gen(char expr)
+static void gen(Gen *g, const char *s)
 {
-	sprintf(buf + strlen(buf), "%c", expr);
+	g->p = stpcpy(g->p, s);
 }
 
-static void gen_num()
+static void gen_num(Gen *g)
 {
-	sprintf(buf + strlen(buf), "%u", choose(NUM_MAX));
+	unsigned int n = choose(g, NUM_MAX);
+	g->p += sprintf(g->p, (choose(g, 4) == 0 ? "0x%x" : "%u"), n);
 }
 
-static void gen_rand_op()
+static void gen_rand_op(Gen *g)
 {
-	switch(rand() % 4) {
-		case 0:
-			sprintf(buf + strlen(buf), "+");
-			break;
-		case 1:
-			sprintf(buf + strlen(buf), "-");
-			break;
-		case 2:
-			sprintf(buf + strlen(buf), "*");
-			break;
-		case 3:
-			sprintf(buf + strlen(buf), "/");
-			break;
-	}
+	static const char *op[] = { "+", "+", "-", "-", "*", "*", "/", "/", "==" };
+	gen(g, op[choose(g, sizeof(op) / sizeof(op[0]))]);
 }
 
-static void gen_rand_expr() {
-  switch (choose(3)) {
-    case 0: gen_num(); break;
-    case 1: gen('('); gen_rand_expr(); gen(')'); break;
-    default: gen_rand_expr(); gen_rand_op(); gen_rand_expr(); break;
+// generate an expression of at most `budget` tokens
+static void gen_rand_expr(Gen *g, int budget) {
+  switch (budget < 3 ? 0 : choose(g, 3)) {
+    case 0: gen_num(g); break;
+    case 1: gen(g, "("); gen_rand_expr(g, budget - 2); gen(g, ")"); break;
+    default: {
+      int left = 1 + choose(g, budget - 2);
+      gen_rand_expr(g, left); gen_rand_op(g); gen_rand_expr(g, budget - 1 - left);
+      break;
+    }
   }
 }
 
-int main(int argc, char *argv[]) {
-  int seed = time(0);
-  srand(seed);
-  int loop = 1;
-  if (argc > 1) {
-    sscanf(argv[1], "%d", &loop);
+/* The reference evaluator, by recursive descent with the precedence of C.
+ * It fails when dividing by zero, or when a value in the middle does not fit
+ * in 32-bit unsigned, so that the result is the same for any width of
+ * word_t in NEMU. */
+typedef struct {
+  const char *s;
+  bool ok;
+} Eval;
+
+static uint64_t eval_eq(Eval *e);
+
+static uint64_t eval_primary(Eval *e) {
+  if (*e->s == '(') {
+    e->s ++;
+    uint64_t v = eval_eq(e);
+    assert(*e->s == ')');
+    e->s ++;
+    return v;
   }
-  int i;
-  for (i = 0; i < loop; i ++) {
-	memset(buf, 0, sizeof(buf));
-    gen_rand_expr();
+  char *end;
+  uint64_t v = strtoull(e->s, &end, 0);
+  assert(end != e->s);
+  e->s = end;
+  return v;
+}
+
+static uint64_t eval_product(Eval *e) {
+  uint64_t v = eval_primary(e);
+  while (*e->s == '*' || *e->s == '/') {
+    char op = *e->s ++;
+    uint64_t r = eval_primary(e);
+    if (op == '*') v *= r;
+    else if (r == 0) { e->ok = false; v = 0; }
+    else v /= r;
+    if (v > UINT32_MAX) e->ok = false;
+  }
+  return v;
+}
+
+static uint64_t eval_sum(Eval *e) {
+  uint64_t v = eval_product(e);
+  while (*e->s == '+' || *e->s == '-') {
+    char op = *e->s ++;
+    uint64_t r = eval_product(e);
+    if (op == '+') v += r;
+    else if (r > v) e->ok = false;
+    else v -= r;
+    if (v > UINT32_MAX) e->ok = false;
+  }
+  return v;
+}
+
+static uint64_t eval_eq(Eval *e) {
+  uint64_t v = eval_sum(e);
+  while (e->s[0] == '=' && e->s[1] == '=') {
+    e->s += 2;
+    v = (v == eval_sum(e));
+  }
+  return v;
+}
 
-    sprintf(code_buf, code_format, buf);
+static void flush(char *chunk, int len) {
+  pthread_mutex_lock(&out_lock);
+  fwrite(chunk, 1, len, stdout);
+  pthread_mutex_unlock(&out_lock);
+}
 
-    FILE *fp = fopen("/tmp/.code.c", "w");
-    assert(fp != NULL);
-    fputs(code_buf, fp);
-    fclose(fp);
+static void *worker(void *arg) {
+  Worker *w = arg;
+  Gen g = { .seed = w->seed };
+  char *chunk = malloc(CHUNK_SIZE);
+  assert(chunk != NULL);
+  int len = 0;
+  uint64_t i = 0;
+  while (i < w->n) {
+    g.p = g.buf;
+    gen_rand_expr(&g, MAX_TOKEN);
 
-    int ret = system("gcc -Werror=overflow -Werror=div-by-zero /tmp/.code.c -o /tmp/.expr");
-    if (ret != 0) continue;
+    Eval e = { .s = g.buf, .ok = true };
+    uint64_t result = eval_eq(&e);
+    if (!e.ok) continue;
 
-    fp = popen("/tmp/.expr", "r");
-    assert(fp != NULL);
+    if (len + sizeof(g.buf) + 16 > CHUNK_SIZE) { flush(chunk, len); len = 0; }
+    len += sprintf(chunk + len, "%u %s\n", (unsigned)result, g.buf);
+    i ++;
+  }
+  flush(chunk, len);
+  free(chunk);
+  return NULL;
+}
 
-    int result;
-    ret = fscanf(fp, "%d", &result);
-    pclose(fp);
+int main(int argc, char *argv[]) {
+  uint32_t seed = time(0);
+  int jobs = sysconf(_SC_NPROCESSORS_ONLN);
+  int o;
+  while ((o = getopt(argc, argv, "j:s:")) != -1) {
+    switch (o) {
+      case 'j': jobs = atoi(optarg); break;
+      case 's': seed = strtoul(optarg, NULL, 0); break;
+      default:
+        fprintf(stderr, "Usage: %s [-j JOBS] [-s SEED] [N]\n", argv[0]);
+        return 1;
+    }
+  }
+  uint64_t loop = (optind < argc ? strtoull(argv[optind], NULL, 0) : 1);
+  if (jobs < 1) jobs = 1;
 
-    printf("%u %s\n", result, buf);
+  Worker *w = calloc(jobs, sizeof(Worker));
+  assert(w != NULL);
+  int i;
+  for (i = 0; i < jobs; i ++) {
+    w[i].n = loop / jobs + (i < loop % jobs);
+    // the state of xorshift should not be 0
+    w[i].seed = (seed + i) * 2654435761u | 1;
+    int ret = pthread_create(&w[i].thread, NULL, worker, &w[i]);
+    assert(ret == 0);
+  }
+  for (i = 0; i < jobs; i ++) {
+    pthread_join(w[i].thread, NULL);
   }
+  free(w);
   return 0;
 }
@@ -0,0 +1,273 @@
+/***************************************************************************************
+* Copyright (c) 2014-2024 Zihao Yu, Nanjing University
+*
+* NEMU is licensed under Mulan PSL v2.
+* You can use this software according to the terms and conditions of the Mulan PSL v2.
+* You may obtain a copy of Mulan PSL v2 at:
+*          http://license.coscl.org.cn/MulanPSL2
+*
+* THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+* EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+* MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+*
+* See the Mulan PSL v2 for more details.
+***************************************************************************************/
+
+
+/* Reorder the INSTPAT lines of a decoder by the counts of a profile, as done
+ * by the build with CONFIG_INSTPAT_ORDER.
+ *   usage: instpat-order STAT SOURCE > OUTPUT
+ * STAT is the JSON written by --inst-stat. In each INSTPAT_START/END block
+ * of SOURCE, the pattern executed most is put first, as long as no earlier
+ * pattern which may match the same instruction is left behind it, which
+ * keeps the result of decoding. Each pattern is wrapped by the conditionals
+ * around it in the source, and by a #line to its place there, so that the
+ * labels made from __LINE__ do not change. Blocks with anything else than
+ * patterns, conditionals and comments are copied as they are. */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_LINE  8192
+#define MAX_STAT  1024
+#define MAX_PAT   256
+#define MAX_DEPTH 16
+#define MAX_COND  1024
+
+typedef struct {
+  char *name, *pattern;
+  uint64_t count;
+} Stat;
+
+typedef struct {
+  int first, nr_line; // lines in the source
+  char cond[MAX_COND]; // empty if unconditional
+  char *name, *pattern; // pattern is NULL if it is not a string literal
+  uint64_t count;
+  bool done;
+} Pat;
+
+static Stat stat[MAX_STAT];
+static int nr_stat = 0;
+static char *line[MAX_LINE];
+static int nr_line = 0;
+static const char *source;
+
+// the string after `"key": "` in `s`
+static char* json_str(const char *s, const char *key) {
+  char k[32];
+  snprintf(k, sizeof(k), "\"%s\": \"", key);
+  const char *p = strstr(s, k);
+  if (p == NULL) return NULL;
+  p += strlen(k);
+  const char *q = strchr(p, '"');
+  return (q == NULL ? NULL : strndup(p, q - p));
+}
+
+static void load_stat(const char *file) {
+  FILE *fp = fopen(file, "r");
+  if (fp == NULL) { perror(file); exit(1); }
+  char buf[512];
+  while (fgets(buf, sizeof(buf), fp) != NULL && nr_stat < MAX_STAT) {
+    char *name = json_str(buf, "name"), *pattern = json_str(buf, "pattern");
+    char *c = strstr(buf, "\"count\": ");
+    if (name == NULL || pattern == NULL || c == NULL) { free(name); free(pattern); continue; }
+    stat[nr_stat ++] = (Stat) { .name = name, .pattern = pattern, .count = strtoull(c + 9, NULL, 10) };
+  }
+  fclose(fp);
+  if (nr_stat == 0) fprintf(stderr, "instpat-order: no count with a pattern is found in %s\n", file);
+}
+
+static void load_source(const char *file) {
+  FILE *fp = fopen(file, "r");
+  if (fp == NULL) { perror(file); exit(1); }
+  char buf[4096];
+  while (fgets(buf, sizeof(buf), fp) != NULL) {
+    if (nr_line == MAX_LINE) { fprintf(stderr, "instpat-order: %s is too long\n", file); exit(1); }
+    line[nr_line ++] = strdup(buf);
+  }
+  fclose(fp);
+}
+
+static const char* skip_space(const char *s) {
+  while (*s == ' ' || *s == '\t') s ++;
+  return s;
+}
+
+static bool is_blank(const char *s) {
+  s = skip_space(s);
+  return *s == '\n' || *s == '\0' || strncmp(s, "//", 2) == 0;
+}
+
+// the change of the depth of parentheses by `s`, skipping literals and comments
+static int paren_delta(const char *s) {
+  int d = 0;
+  for (; *s != '\0'; s ++) {
+    if (*s == '/' && s[1] == '/') break;
+    if (*s == '"' || *s == '\'') {
+      char q = *s;
+      for (s ++; *s != '\0' && *s != q; s ++) if (*s == '\\' && s[1] != '\0') s ++;
+      if (*s == '\0') break;
+    }
+    else if (*s == '(') d ++;
+    else if (*s == ')') d --;
+  }
+  return d;
+}
+
+// the condition of a directive without comments and the newline
+static void directive_arg(char *dst, int size, const char *s) {
+  snprintf(dst, size, "%s", skip_space(s));
+  char *p = strstr(dst, "//");
+  if (p != NULL) *p = '\0';
+  p = strstr(dst, "/*");
+  if (p != NULL) *p = '\0';
+  for (p = dst + strlen(dst); p > dst && (p[-1] == '\n' || p[-1] == ' ' || p[-1] == '\t'); p --);
+  *p = '\0';
+}
+
+// some instruction may match both, with the patterns right-aligned like pattern_decode() does
+static bool may_overlap(const Pat *a, const Pat *b) {
+  if (a->pattern == NULL || b->pattern == NULL) return true;
+  int i = strlen(a->pattern) - 1, j = strlen(b->pattern) - 1;
+  while (i >= 0 && j >= 0) {
+    if (a->pattern[i] == ' ') { i --; continue; }
+    if (b->pattern[j] == ' ') { j --; continue; }
+    char x = a->pattern[i --], y = b->pattern[j --];
+    if (x != '?' && y != '?' && x != y) return false;
+  }
+  return true;
+}
+
+static void parse_pattern(Pat *p) {
+  const char *s = strstr(line[p->first], "INSTPAT(") + 8;
+  s = skip_space(s);
+  if (*s == '"') {
+    const char *q = strchr(s + 1, '"');
+    if (q != NULL) p->pattern = strndup(s + 1, q - s - 1);
+    s = (q == NULL ? s : q + 1);
+  }
+  s = strchr(s, ',');
+  if (s == NULL) return;
+  s = skip_space(s + 1);
+  int n = strcspn(s, " \t,)");
+  p->name = strndup(s, n);
+  int i;
+  for (i = 0; i < nr_stat; i ++) {
+    if (strcmp(stat[i].name, p->name) == 0 && p->pattern != NULL && strcmp(stat[i].pattern, p->pattern) == 0) {
+      p->count += stat[i].count;
+    }
+  }
+}
+
+static void emit_line_marker(int l) {
+  printf("#line %d \"%s\"\n", l + 1, source);
+}
+
+static void emit_pattern(const Pat *p) {
+  if (p->cond[0] != '\0') printf("#if %s\n", p->cond);
+  emit_line_marker(p->first);
+  int i;
+  for (i = 0; i < p->nr_line; i ++) fputs(line[p->first + i], stdout);
+  if (p->cond[0] != '\0') printf("#endif\n");
+}
+
+/* Reorder the block of lines [start, end), return false if it has anything
+ * which can not be reordered. */
+static bool order_block(int start, int end) {
+  static Pat pat[MAX_PAT];
+  // for each level of conditionals, the condition of the current branch and of any earlier ones
+  static char cur[MAX_DEPTH][MAX_COND], any[MAX_DEPTH][MAX_COND];
+  int depth = 0, nr_pat = 0, l, i;
+  for (l = start; l < end; l ++) {
+    const char *s = skip_space(line[l]);
+    char arg[MAX_COND / 4];
+    if (is_blank(s)) continue;
+    if (*s == '#') {
+      if (strchr(s, '\\') != NULL) return false;
+      s = skip_space(s + 1);
+      if (strncmp(s, "ifdef", 5) == 0 || strncmp(s, "ifndef", 6) == 0 || (strncmp(s, "if", 2) == 0 && (s[2] == ' ' || s[2] == '('))) {
+        if (depth == MAX_DEPTH) return false;
+        bool ifn = (s[2] == 'n'), ifd = (s[2] == 'd' || ifn);
+        directive_arg(arg, sizeof(arg), s + (ifn ? 6 : ifd ? 5 : 2));
+        snprintf(cur[depth], MAX_COND, ifd ? "%sdefined(%s)" : "%s(%s)", ifn ? "!" : "", arg);
+        strcpy(any[depth], cur[depth]);
+        depth ++;
+      } else if (strncmp(s, "elif", 4) == 0 && depth > 0) {
+        directive_arg(arg, sizeof(arg), s + 4);
+        snprintf(cur[depth - 1], MAX_COND, "!(%s) && (%s)", any[depth - 1], arg);
+        int len = strlen(any[depth - 1]);
+        snprintf(any[depth - 1] + len, MAX_COND - len, " || (%s)", arg);
+      } else if (strncmp(s, "else", 4) == 0 && depth > 0) {
+        snprintf(cur[depth - 1], MAX_COND, "!(%s)", any[depth - 1]);
+      } else if (strncmp(s, "endif", 5) == 0 && depth > 0) {
+        depth --;
+      } else return false;
+      continue;
+    }
+    if (strncmp(s, "INSTPAT(", 8) != 0 || nr_pat == MAX_PAT) return false;
+
+    Pat *p = &pat[nr_pat ++];
+    memset(p, 0, sizeof(*p));
+    p->first = l;
+    int d = paren_delta(line[l]);
+    while (d > 0 && l + 1 < end) d += paren_delta(line[++ l]);
+    if (d != 0) return false;
+    p->nr_line = l - p->first + 1;
+    for (i = 0; i < depth; i ++) {
+      int len = strlen(p->cond);
+      snprintf(p->cond + len, MAX_COND - len, "%s(%s)", (i == 0 ? "" : " && "), cur[i]);
+    }
+    parse_pattern(p);
+  }
+  if (depth != 0) return false;
+
+  int n;
+  for (n = 0; n < nr_pat; n ++) {
+    // the most frequent pattern with every earlier overlapping one emitted
+    int best = -1;
+    for (i = 0; i < nr_pat; i ++) {
+      if (pat[i].done) continue;
+      int j;
+      for (j = 0; j < i; j ++) {
+        if (!pat[j].done && may_overlap(&pat[j], &pat[i])) break;
+      }
+      if (j < i) continue;
+      if (best == -1 || pat[i].count > pat[best].count) best = i;
+    }
+    pat[best].done = true;
+    emit_pattern(&pat[best]);
+  }
+  for (i = 0; i < nr_pat; i ++) { free(pat[i].name); free(pat[i].pattern); }
+  return true;
+}
+
+int main(int argc, char *argv[]) {
+  if (argc != 3) {
+    fprintf(stderr, "usage: %s STAT SOURCE > OUTPUT\n", argv[0]);
+    return 1;
+  }
+  load_stat(argv[1]);
+  source = argv[2];
+  load_source(source);
+
+  emit_line_marker(0);
+  int l = 0;
+  while (l < nr_line) {
+    fputs(line[l], stdout);
+    if (strstr(line[l ++], "INSTPAT_START(") == NULL) continue;
+    int end;
+    for (end = l; end < nr_line && strstr(line[end], "INSTPAT_END(") == NULL; end ++);
+    if (end == nr_line) break;
+    if (order_block(l, end)) emit_line_marker(end);
+    else {
+      fprintf(stderr, "instpat-order: the block at %s:%d is kept in order\n", source, l);
+      for (; l < end; l ++) fputs(line[l], stdout);
+    }
+    l = end;
+  }
+  return 0;
+}
@@ -13,17 +13,20 @@
 * See the Mulan PSL v2 for more details.
 ***************************************************************************************/
 
-// from NEMU
-#include <memory/paddr.h>
-#include <isa-def.h>
-#include <difftest-def.h>
-
 #include <fcntl.h>
 #include <errno.h>
 #include <sys/ioctl.h>
 #include <sys/mman.h>
+#include <sys/time.h>
+#include <signal.h>
 #include <linux/kvm.h>
 
+// from NEMU, after <linux/kvm.h> whose fields clash with the names
+// of registers defined as macros in isa-def.h
+#include <memory/paddr.h>
+#include <isa-def.h>
+#include <difftest-def.h>
+
 /* CR0 bits */
 #define CR0_PE 1u
 #define CR0_PG (1u << 31)
@@ -59,6 +62,13 @@ enum {
 static struct vm vm;
 static struct vcpu vcpu;
 static FILE *log_fp = NULL; // only to pass linking
+// pages written when patching, which are not in the dirty log of KVM
+static uint64_t patch_dirty[(CONFIG_MSIZE / PAGE_SIZE + 63) / 64];
+
+static void patch_write32(uint32_t addr, uint32_t data) {
+  *(uint32_t *)(vm.mem + addr) = data;
+  patch_dirty[(addr / PAGE_SIZE) / 64] |= 1ull << ((addr / PAGE_SIZE) % 64);
+}
 
 // This should be called everytime after KVM_SET_REGS.
 // It seems that KVM_SET_REGS will clean the state of single step.
@@ -95,7 +105,7 @@ static void kvm_setsregs(const struct kvm_sregs *r) {
   }
 }
 
-static void* create_mem(int slot, uintptr_t base, size_t mem_size) {
+static void* create_mem(int slot, uintptr_t base, size_t mem_size, uint32_t flags) {
   void *mem = mmap(NULL, mem_size, PROT_READ | PROT_WRITE,
       MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
   if (mem == MAP_FAILED) {
@@ -107,7 +117,7 @@ static void* create_mem(int slot, uintptr_t base, size_t mem_size) {
 
   struct kvm_userspace_memory_region memreg;
   memreg.slot = slot;
-  memreg.flags = 0;
+  memreg.flags = flags;
   memreg.guest_phys_addr = base;
   memreg.memory_size = mem_size;
   memreg.userspace_addr = (unsigned long)mem;
@@ -150,8 +160,9 @@ static void vm_init(size_t mem_size) {
     assert(0);
   }
 
-  vm.mem = create_mem(0, 0, mem_size);
-  vm.mmio = create_mem(1, 0xa1000000, 0x1000);
+  // log the pages written by the guest for difftest_dirty_pages()
+  vm.mem = create_mem(0, 0, mem_size, KVM_MEM_LOG_DIRTY_PAGES);
+  vm.mmio = create_mem(1, 0xa1000000, 0x1000, 0);
 }
 
 static void vcpu_init() {
@@ -237,8 +248,8 @@ static int patching() {
   if (vm.mem[pc] == 0x9c) {  // pushf
     if (vcpu.int_wp_state == STATE_INT_INST) return 0;
     vcpu.kvm_run->s.regs.regs.rsp -= 4;
-    uint32_t esp = va2pa(vcpu.kvm_run->s.regs.regs.rsp);
-    *(uint32_t *)(vm.mem + esp) = vcpu.kvm_run->s.regs.regs.rflags & ~RFLAGS_FIX_MASK;
+    uint32_t sp = va2pa(vcpu.kvm_run->s.regs.regs.rsp);
+    patch_write32(sp, vcpu.kvm_run->s.regs.regs.rflags & ~RFLAGS_FIX_MASK);
     vcpu.kvm_run->s.regs.regs.rflags |= RFLAGS_TF;
     vcpu.kvm_run->s.regs.regs.rip ++;
     vcpu.kvm_run->kvm_dirty_regs = KVM_SYNC_X86_REGS;
@@ -246,8 +257,8 @@ static int patching() {
   }
   else if (vm.mem[pc] == 0x9d) {  // popf
     if (vcpu.int_wp_state == STATE_INT_INST) return 0;
-    uint32_t esp = va2pa(vcpu.kvm_run->s.regs.regs.rsp);
-    vcpu.kvm_run->s.regs.regs.rflags = *(uint32_t *)(vm.mem + esp) | RFLAGS_TF | 2;
+    uint32_t sp = va2pa(vcpu.kvm_run->s.regs.regs.rsp);
+    vcpu.kvm_run->s.regs.regs.rflags = *(uint32_t *)(vm.mem + sp) | RFLAGS_TF | 2;
     vcpu.kvm_run->s.regs.regs.rsp += 4;
     vcpu.kvm_run->s.regs.regs.rip ++;
     vcpu.kvm_run->kvm_dirty_regs = KVM_SYNC_X86_REGS;
@@ -265,8 +276,8 @@ static int patching() {
 }
 
 static void fix_push_sreg() {
-  uint32_t esp = va2pa(vcpu.kvm_run->s.regs.regs.rsp);
-  *(uint32_t *)(vm.mem + esp) &= 0x0000ffff;
+  uint32_t sp = va2pa(vcpu.kvm_run->s.regs.regs.rsp);
+  patch_write32(sp, *(uint32_t *)(vm.mem + sp) & 0x0000ffff);
 }
 
 static void patching_after(uint64_t last_pc) {
@@ -310,7 +321,7 @@ static void kvm_exec(uint64_t n) {
       if (vcpu.int_wp_state == STATE_INT_INST) {
         uint32_t eflag_offset = 8 + (vcpu.has_error_code ? 4 : 0);
         uint32_t eflag_addr = va2pa(vcpu.kvm_run->s.regs.regs.rsp + eflag_offset);
-        *(uint32_t *)(vm.mem + eflag_addr) &= ~RFLAGS_FIX_MASK;
+        patch_write32(eflag_addr, *(uint32_t *)(vm.mem + eflag_addr) & ~RFLAGS_FIX_MASK);
 
         Assert(vcpu.entry == vcpu.kvm_run->debug.arch.pc,
             "entry not match, right = 0x%llx, wrong = 0x%x", vcpu.kvm_run->debug.arch.pc, vcpu.entry);
@@ -328,6 +339,59 @@ static void kvm_exec(uint64_t n) {
   }
 }
 
+static void timeout_handler(int sig) {
+  // nothing to do, just to interrupt KVM_RUN with EINTR
+}
+
+static void set_timeout(long us) {
+  struct itimerval it = { .it_value = { .tv_sec = us / 1000000, .tv_usec = us % 1000000 } };
+  int ret = setitimer(ITIMER_REAL, &it, NULL);
+  assert(ret == 0);
+}
+
+// Run freely without single-stepping, until the instruction at `pc` is
+// about to be executed, the guest halts, or RUN_TO_TIMEOUT_US passes.
+// Special instructions can not be patched while running freely, so the
+// state reached may differ from the one by single-stepping.
+#define RUN_TO_TIMEOUT_US 100000
+static bool kvm_run_to(uint64_t pc) {
+  if (vcpu.int_wp_state != STATE_IDLE) return false;
+
+  struct kvm_guest_debug debug = {};
+  debug.control = KVM_GUESTDBG_ENABLE | KVM_GUESTDBG_USE_HW_BP;
+  debug.arch.debugreg[0] = pc;
+  debug.arch.debugreg[7] = 0x1;
+  if (ioctl(vcpu.fd, KVM_SET_GUEST_DEBUG, &debug) < 0) {
+    perror("KVM_SET_GUEST_DEBUG");
+    assert(0);
+  }
+  vcpu.kvm_run->s.regs.regs.rflags &= ~RFLAGS_TF;
+  vcpu.kvm_run->kvm_dirty_regs = KVM_SYNC_X86_REGS;
+
+  set_timeout(RUN_TO_TIMEOUT_US);
+  while (true) {
+    if (ioctl(vcpu.fd, KVM_RUN, 0) < 0) {
+      if (errno == EINTR) break;
+      perror("KVM_RUN");
+      assert(0);
+    }
+    uint32_t reason = vcpu.kvm_run->exit_reason;
+    if (reason == KVM_EXIT_DEBUG && vcpu.kvm_run->debug.arch.pc == pc) break;
+    if (reason == KVM_EXIT_HLT) break;
+    if (reason != KVM_EXIT_DEBUG) {
+      fprintf(stderr, "Got exit_reason %d at pc = 0x%llx while running to 0x%" PRIx64 "\n",
+          reason, vcpu.kvm_run->s.regs.regs.rip, pc);
+      assert(0);
+    }
+  }
+  set_timeout(0);
+
+  vcpu.kvm_run->s.regs.regs.rflags |= RFLAGS_TF;
+  vcpu.kvm_run->kvm_dirty_regs = KVM_SYNC_X86_REGS;
+  kvm_set_step_mode(false, 0);
+  return true;
+}
+
 static void run_protected_mode() {
   struct kvm_sregs sregs;
   kvm_getsregs(&sregs);
@@ -383,6 +447,28 @@ __EXPORT void difftest_exec(uint64_t n) {
   kvm_exec(n);
 }
 
+// Return false if REF can not run freely now, and then nothing is done.
+// Used when DUT knows `pc` is not reached until the end of a batch.
+__EXPORT bool difftest_run_to(uint64_t pc) {
+  return kvm_run_to(pc);
+}
+
+// Set the bits of pages written by the guest since the last call in
+// `bitmap`, one bit per page from CONFIG_MBASE.
+__EXPORT void difftest_dirty_pages(uint64_t *bitmap) {
+  static uint64_t log[ARRLEN(patch_dirty)];
+  struct kvm_dirty_log d = { .slot = 0, .dirty_bitmap = log };
+  if (ioctl(vm.fd, KVM_GET_DIRTY_LOG, &d) < 0) {
+    perror("KVM_GET_DIRTY_LOG");
+    assert(0);
+  }
+  int i;
+  for (i = 0; i < ARRLEN(log); i ++) {
+    bitmap[i] |= log[i] | patch_dirty[i];
+    patch_dirty[i] = 0;
+  }
+}
+
 __EXPORT void difftest_raise_intr(word_t NO) {
   uint32_t pgate_vaddr = vcpu.kvm_run->s.regs.sregs.idt.base + NO * 8;
   uint32_t pgate = va2pa(pgate_vaddr);
@@ -403,6 +489,11 @@ __EXPORT void difftest_raise_intr(word_t NO) {
 }
 
 __EXPORT void difftest_init(int port) {
+  assert(CONFIG_MBASE == 0);
+  struct sigaction sa = { .sa_handler = timeout_handler };
+  int ret = sigaction(SIGALRM, &sa, NULL);
+  assert(ret == 0);
+
   vm_init(CONFIG_MSIZE);
   vcpu_init();
   run_protected_mode();
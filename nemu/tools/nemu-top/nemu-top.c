@@ -0,0 +1,151 @@
+/***************************************************************************************
+* Copyright (c) 2014-2024 Zihao Yu, Nanjing University
+*
+* NEMU is licensed under Mulan PSL v2.
+* You can use this software according to the terms and conditions of the Mulan PSL v2.
+* You may obtain a copy of Mulan PSL v2 at:
+*          http://license.coscl.org.cn/MulanPSL2
+*
+* THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+* EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+* MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+*
+* See the Mulan PSL v2 for more details.
+***************************************************************************************/
+
+
+/* Show the live counters of a running NEMU built with CONFIG_LIVE.
+ *   usage: nemu-top [-1] [PID]
+ * refreshes the counters of NEMU with PID every second, or prints them once
+ * with -1. Without PID, the only NEMU publishing them is chosen, and all of
+ * them are listed if there are more. */
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+#include <live-def.h>
+
+static const char *state_name[] = { "running", "stop", "end", "abort", "quit" };
+
+// return the only NEMU publishing the counters, 0 if there are more, -1 if none
+static int find_pid() {
+  DIR *dir = opendir("/dev/shm");
+  if (dir == NULL) return -1;
+  const char *prefix = LIVE_SHM_PREFIX + 1;
+  struct dirent *e;
+  int pid[64], n = 0;
+  while ((e = readdir(dir)) != NULL && n < 64) {
+    if (strncmp(e->d_name, prefix, strlen(prefix)) != 0) continue;
+    int p = atoi(e->d_name + strlen(prefix));
+    // skip those left by NEMU killed
+    if (kill(p, 0) != 0 && errno == ESRCH) continue;
+    pid[n ++] = p;
+  }
+  closedir(dir);
+  if (n == 0) return -1;
+  if (n == 1) return pid[0];
+  printf("NEMU publishing live counters, choose one by PID:\n");
+  int i;
+  for (i = 0; i < n; i ++) printf("  %d\n", pid[i]);
+  return 0;
+}
+
+static const LiveCounters* open_live(int pid) {
+  char name[32];
+  snprintf(name, sizeof(name), LIVE_SHM_PREFIX "%d", pid);
+  int fd = shm_open(name, O_RDONLY, 0);
+  if (fd < 0) return NULL;
+  const LiveCounters *live = mmap(NULL, sizeof(LiveCounters), PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (live == MAP_FAILED) return NULL;
+  if (memcmp(live->magic, LIVE_MAGIC, sizeof(live->magic)) != 0 || live->version != LIVE_VERSION) {
+    fprintf(stderr, "/dev/shm%s is not the live counters of this version of NEMU\n", name);
+    exit(1);
+  }
+  __atomic_thread_fence(__ATOMIC_ACQUIRE);
+  return live;
+}
+
+static double rate(uint64_t hit, uint64_t total) {
+  return (total == 0 ? 0 : hit * 100.0 / total);
+}
+
+static void show(int pid, const LiveCounters *live, uint64_t *last_dev, double sec) {
+  static const char *tlb_name[LIVE_NR_TLB] = { "ifetch", "read", "write" };
+  uint32_t state = LIVE_LOAD(live->state);
+  uint64_t inst = LIVE_LOAD(live->guest_inst);
+  bool alive = !(kill(pid, 0) != 0 && errno == ESRCH);
+  printf("NEMU %d: %s\n", pid, (!alive ? "exited" :
+        (state < sizeof(state_name) / sizeof(state_name[0]) ? state_name[state] : "?")));
+  printf("guest instructions %20" PRIu64 "\n", inst);
+  printf("MIPS               %20.2f\n", LIVE_LOAD(live->inst_per_sec) / 1e6);
+  printf("difftest steps     %20" PRIu64 "\n", (uint64_t)LIVE_LOAD(live->difftest_step));
+  uint64_t decode_miss = LIVE_LOAD(live->decode_miss);
+  printf("decode cache hit   %19.2f%%\n", rate(inst > decode_miss ? inst - decode_miss : 0, inst));
+  int t;
+  for (t = 0; t < LIVE_NR_TLB; t ++) {
+    uint64_t hit = LIVE_LOAD(live->tlb_hit[t]), miss = LIVE_LOAD(live->tlb_miss[t]);
+    printf("TLB %-6s hit     %19.2f%%\n", tlb_name[t], rate(hit, hit + miss));
+  }
+  uint32_t i, nr_dev = LIVE_LOAD(live->nr_dev);
+  if (nr_dev > LIVE_NR_DEV) nr_dev = LIVE_NR_DEV;
+  printf("\n%-16s %16s %16s %12s\n", "device", "reads", "writes", "access/s");
+  for (i = 0; i < nr_dev; i ++) {
+    uint64_t r = LIVE_LOAD(live->dev[i].read), w = LIVE_LOAD(live->dev[i].write);
+    printf("%-16.*s %16" PRIu64 " %16" PRIu64 " %12.0f\n", LIVE_NAME_LEN, live->dev[i].name, r, w,
+        (sec > 0 ? (r + w - last_dev[i]) / sec : 0));
+    last_dev[i] = r + w;
+  }
+  uint32_t nr_mem = LIVE_LOAD(live->nr_mem);
+  if (nr_mem == 0) return;
+  if (nr_mem > LIVE_NR_MEM) nr_mem = LIVE_NR_MEM;
+  printf("\n%-16s %16s %16s\n", "host memory", "reserved (MB)", "resident (MB)");
+  for (i = 0; i < nr_mem; i ++) {
+    printf("%-16.*s %16.2f %16.2f\n", LIVE_NAME_LEN, live->mem[i].name,
+        LIVE_LOAD(live->mem[i].reserved) / 1048576.0, LIVE_LOAD(live->mem[i].resident) / 1048576.0);
+  }
+  printf("%-16s %16s %16.2f\n", "RSS", "", LIVE_LOAD(live->rss) / 1048576.0);
+}
+
+int main(int argc, char *argv[]) {
+  bool once = false;
+  int pid = -1, i;
+  for (i = 1; i < argc; i ++) {
+    if (strcmp(argv[i], "-1") == 0) once = true;
+    else pid = atoi(argv[i]);
+  }
+  if (pid < 0) {
+    pid = find_pid();
+    if (pid == 0) return 1;
+    if (pid < 0) {
+      fprintf(stderr, "No NEMU is publishing live counters, build it with CONFIG_LIVE\n");
+      return 1;
+    }
+  }
+  const LiveCounters *live = open_live(pid);
+  if (live == NULL) {
+    fprintf(stderr, "NEMU %d is not publishing live counters\n", pid);
+    return 1;
+  }
+
+  uint64_t last_dev[LIVE_NR_DEV] = {};
+  double sec = 0;
+  while (true) {
+    if (!once) printf("\33[H\33[2J");
+    show(pid, live, last_dev, sec);
+    fflush(stdout);
+    if (once || (kill(pid, 0) != 0 && errno == ESRCH)) break;
+    sleep(1);
+    sec = 1;
+  }
+  return 0;
+}
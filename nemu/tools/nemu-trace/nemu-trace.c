@@ -0,0 +1,438 @@
+/***************************************************************************************
+* Copyright (c) 2014-2024 Zihao Yu, Nanjing University
+*
+* NEMU is licensed under Mulan PSL v2.
+* You can use this software according to the terms and conditions of the Mulan PSL v2.
+* You may obtain a copy of Mulan PSL v2 at:
+*          http://license.coscl.org.cn/MulanPSL2
+*
+* THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+* EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+* MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+*
+* See the Mulan PSL v2 for more details.
+***************************************************************************************/
+
+
+/* Decode the binary trace files written by NEMU. FILE may be compressed by
+ * zlib.
+ *   usage: nemu-trace ITRACE_FILE [N]
+ * disassembles the file of --itrace into the same text as the textual
+ * itrace, only the last N instructions if N is given.
+ *   usage: nemu-trace FTRACE_FILE [folded|chrome]
+ * shows the file of --ftrace as indented call trees, as folded stacks
+ * weighted by the instructions executed in each, for flamegraph.pl, or as
+ * the JSON of Chrome trace events, where 1 us is 1 instruction. Records are
+ * converted while reading, so that the trace is never kept in memory.
+ *   usage: nemu-trace LOG_FILE
+ * formats the binary log of CONFIG_LOG_BINARY into text.
+ * A circular file of NEMU, whose name ends with ".ring", is read from its
+ * oldest record, and one holding neither trace, such as the log, is just
+ * written out in order. */
+
+#include <assert.h>
+#include <dlfcn.h>
+#include <errno.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <zlib.h>
+#include <capstone/capstone.h>
+#include <cpu/itrace.h>
+#include <cpu/ftrace.h>
+#include <tring-def.h>
+#include <blog-def.h>
+
+/* The trace is read by zlib, which also reads files not compressed, or
+ * from the mapping of a circular file, the header of the trace first and
+ * then its data in [ring.pos, ring.end). */
+static gzFile gz = NULL;
+static struct {
+  TRingHeader *h;
+  uint64_t header_pos, pos, end;
+} ring;
+
+static bool trace_open(const char *file) {
+  int fd = open(file, O_RDONLY);
+  if (fd < 0) return false;
+  char magic[8];
+  struct stat st;
+  if (read(fd, magic, sizeof(magic)) == sizeof(magic) && memcmp(magic, TRING_MAGIC, sizeof(magic)) == 0 &&
+      fstat(fd, &st) == 0) {
+    void *p = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED) return false;
+    ring.h = p;
+    if (ring.h->data_off + ring.h->data_size > st.st_size) { errno = EINVAL; return false; }
+    ring.pos = ring.h->begin;
+    ring.end = ring.h->end;
+    return true;
+  }
+  lseek(fd, 0, SEEK_SET);
+  gz = gzdopen(fd, "rb");
+  if (gz == NULL) return false;
+  gzbuffer(gz, 1 << 20);
+  return true;
+}
+
+static int trace_read(void *buf, int len) {
+  if (gz != NULL) return gzread(gz, buf, len);
+  int n = 0;
+  uint64_t k = ring.h->header_len - ring.header_pos;
+  if (k > 0) {
+    if (k > len) k = len;
+    memcpy(buf, (uint8_t *)(ring.h + 1) + ring.header_pos, k);
+    ring.header_pos += k;
+    n += k;
+  }
+  while (n < len && ring.pos < ring.end) {
+    uint64_t off = ring.pos % ring.h->data_size;
+    k = len - n;
+    if (k > ring.h->data_size - off) k = ring.h->data_size - off;
+    if (k > ring.end - ring.pos) k = ring.end - ring.pos;
+    memcpy((uint8_t *)buf + n, (uint8_t *)ring.h + ring.h->data_off + off, k);
+    ring.pos += k;
+    n += k;
+  }
+  return n;
+}
+
+// skip the part of the oldest record overwritten in a circular file
+static void trace_skip_to_record(int size) {
+  if (gz == NULL) ring.pos = (ring.pos + size - 1) / size * size;
+}
+
+static void trace_close() {
+  if (gz != NULL) gzclose(gz);
+}
+
+static bool (*cs_disasm_iter_dl)(csh handle, const uint8_t **code,
+    size_t *size, uint64_t *address, cs_insn *insn);
+static csh handle;
+static cs_insn *insn = NULL;
+
+/* A direct-mapped cache of the text of instructions as in NEMU, since a
+ * trace runs the same loops again and again. */
+#define CACHE_SIZE 4096
+static struct {
+  uint64_t pc;
+  uint8_t inst[15];
+  uint8_t ilen; // 0 for an empty entry
+  char str[96];
+} cache[CACHE_SIZE];
+
+static void init_disasm(ITraceHeader *h) {
+  void *dl_handle = dlopen(NEMU_HOME "/tools/capstone/repo/libcapstone.so.5", RTLD_LAZY);
+  if (dl_handle == NULL) {
+    fprintf(stderr, "%s, build it with `make -C $NEMU_HOME/tools/capstone'\n", dlerror());
+    exit(1);
+  }
+
+  cs_err (*cs_open_dl)(cs_arch arch, cs_mode mode, csh *handle) = dlsym(dl_handle, "cs_open");
+  cs_err (*cs_option_dl)(csh handle, cs_opt_type type, size_t value) = dlsym(dl_handle, "cs_option");
+  cs_insn *(*cs_malloc_dl)(csh handle) = dlsym(dl_handle, "cs_malloc");
+  cs_disasm_iter_dl = dlsym(dl_handle, "cs_disasm_iter");
+  assert(cs_open_dl && cs_option_dl && cs_malloc_dl && cs_disasm_iter_dl);
+
+  int ret = cs_open_dl(h->cs_arch, h->cs_mode, &handle);
+  assert(ret == CS_ERR_OK);
+  if (h->cs_syntax != 0) {
+    ret = cs_option_dl(handle, CS_OPT_SYNTAX, h->cs_syntax);
+    assert(ret == CS_ERR_OK);
+  }
+  // reused by every record, instead of allocating one by cs_disasm()
+  insn = cs_malloc_dl(handle);
+  assert(insn != NULL);
+}
+
+// return the text of the instruction in `r`, or NULL if it is invalid
+static const char *disassemble(bool x86, ITraceRecord *r) {
+  int idx = (r->pc ^ (r->pc >> 12)) % CACHE_SIZE;
+  if (cache[idx].pc == r->pc && cache[idx].ilen == r->ilen && memcmp(cache[idx].inst, r->inst, r->ilen) == 0) {
+    return cache[idx].str;
+  }
+  const uint8_t *code = r->inst;
+  size_t size = r->ilen;
+  uint64_t address = r->pc + (x86 ? r->ilen : 0);
+  if (!cs_disasm_iter_dl(handle, &code, &size, &address, insn) || size != 0) return NULL;
+  int len = snprintf(cache[idx].str, sizeof(cache[idx].str), "%s", insn->mnemonic);
+  if (insn->op_str[0] != '\0') {
+    snprintf(cache[idx].str + len, sizeof(cache[idx].str) - len, "\t%s", insn->op_str);
+  }
+  cache[idx].pc = r->pc;
+  cache[idx].ilen = r->ilen;
+  memcpy(cache[idx].inst, r->inst, r->ilen);
+  return cache[idx].str;
+}
+
+static void print_record(ITraceHeader *h, ITraceRecord *r) {
+  bool x86 = h->flags & ITRACE_FLAG_X86;
+  printf("0x%0*" PRIx64 ":", h->word_bytes * 2, r->pc);
+  int i;
+  for (i = 0; i < r->ilen; i ++) {
+    printf(" %02x", r->inst[x86 ? i : r->ilen - 1 - i]);
+  }
+  int space_len = (x86 ? 8 : 4) - r->ilen;
+  if (space_len < 0) space_len = 0;
+  printf("%*s", space_len * 3 + 1, "");
+
+  const char *str = disassemble(x86, r);
+  printf("%s\n", (str == NULL ? "(bad)" : str));
+}
+
+typedef struct {
+  uint64_t start, size;
+  char *name;
+} Symbol;
+
+static Symbol *sym = NULL;
+static uint32_t nr_sym = 0;
+
+static bool read_symbols(FTraceHeader *h) {
+  nr_sym = h->nr_sym;
+  sym = calloc(nr_sym + 1, sizeof(Symbol));
+  assert(sym != NULL);
+  uint32_t i;
+  for (i = 0; i < nr_sym; i ++) {
+    uint64_t x[2];
+    uint32_t len;
+    if (trace_read(x, sizeof(x)) != sizeof(x) || trace_read(&len, sizeof(len)) != sizeof(len)) return false;
+    sym[i].start = x[0];
+    sym[i].size = x[1];
+    sym[i].name = malloc(len + 1);
+    if (trace_read(sym[i].name, len) != len) return false;
+    sym[i].name[len] = '\0';
+  }
+  return true;
+}
+
+#define MAX_DEPTH 4096
+
+/* Folded stacks are kept in a hash table of the stack strings, with the
+ * number of instructions executed while each stack is on top. */
+#define HASH_SIZE 65536
+static struct {
+  char *stack;
+  uint64_t weight;
+} folded[HASH_SIZE];
+
+static void fold(const char *stack, uint64_t weight) {
+  if (weight == 0) return;
+  uint32_t hash = 5381, i;
+  const char *p;
+  for (p = stack; *p; p ++) hash = hash * 33 + (uint8_t)*p;
+  for (i = hash % HASH_SIZE; folded[i].stack != NULL; i = (i + 1) % HASH_SIZE) {
+    if (strcmp(folded[i].stack, stack) == 0) {
+      folded[i].weight += weight;
+      return;
+    }
+  }
+  folded[i].stack = strdup(stack);
+  folded[i].weight = weight;
+}
+
+enum { SHOW_TREE, SHOW_FOLDED, SHOW_CHROME };
+
+static void chrome_event(const char *name, char ph, uint64_t ts) {
+  static bool first = true;
+  printf("%s\n{\"name\":\"", (first ? "" : ","));
+  first = false;
+  for (; *name; name ++) {
+    if (*name == '"' || *name == '\\') putchar('\\');
+    putchar(*name);
+  }
+  printf("\",\"ph\":\"%c\",\"ts\":%" PRIu64 ",\"pid\":0,\"tid\":0}", ph, ts);
+}
+
+static void decode_ftrace(FTraceHeader *h, int mode) {
+  static uint32_t stack[MAX_DEPTH];
+  int depth = 0;
+  uint64_t last_inst = 0;
+  FTraceRecord r;
+  trace_skip_to_record(sizeof(r));
+  if (mode == SHOW_CHROME) printf("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+  while (trace_read(&r, sizeof(r)) == sizeof(r)) {
+    if (r.sym >= nr_sym) continue;
+    if (mode == SHOW_CHROME) {
+      // a return without its call is from frames dropped under deep recursion
+      if (r.type == FTRACE_CALL || depth > 0) chrome_event(sym[r.sym].name, (r.type == FTRACE_CALL ? 'B' : 'E'), r.nr_inst);
+      last_inst = r.nr_inst;
+    } else if (mode == SHOW_FOLDED) {
+      // the instructions since the last record were executed in the current stack
+      char buf[8192] = "[root]";
+      int i, p = strlen(buf);
+      for (i = 0; i < depth && p < sizeof(buf) - 256; i ++) {
+        p += snprintf(buf + p, sizeof(buf) - p, ";%s", sym[stack[i]].name);
+      }
+      fold(buf, r.nr_inst - last_inst);
+      last_inst = r.nr_inst;
+    } else {
+      int indent = (r.type == FTRACE_CALL ? depth : depth - 1);
+      if (indent < 0) indent = 0;
+      printf("0x%0*" PRIx64 ": %*s", h->word_bytes * 2, r.pc, indent * 2, "");
+      if (r.type == FTRACE_CALL) printf("call [%s@0x%" PRIx64 "]\n", sym[r.sym].name, sym[r.sym].start);
+      else printf("ret  [%s]\n", sym[r.sym].name);
+    }
+    if (r.type == FTRACE_CALL) {
+      if (depth < MAX_DEPTH) stack[depth ++] = r.sym;
+    } else if (depth > 0) depth --;
+  }
+  if (mode == SHOW_CHROME) {
+    // close the functions still running at the end
+    while (depth > 0) chrome_event(sym[stack[-- depth]].name, 'E', last_inst);
+    printf("\n]}\n");
+  }
+  if (mode == SHOW_FOLDED) {
+    int i;
+    for (i = 0; i < HASH_SIZE; i ++) {
+      if (folded[i].stack != NULL) printf("%s %" PRIu64 "\n", folded[i].stack, folded[i].weight);
+    }
+  }
+}
+
+static char **fmt = NULL;
+static uint32_t nr_fmt = 0;
+
+// format a message of the binary log with the arguments in [p, end)
+static void print_message(const char *f, const uint8_t *p, const uint8_t *end) {
+  char spec[64];
+  while (*f != '\0') {
+    const char *pct = strchr(f, '%');
+    if (pct == NULL) { fputs(f, stdout); break; }
+    fwrite(f, 1, pct - f, stdout);
+    int kind, n = blog_conversion(pct, &kind);
+    f = pct + n;
+    if (kind == BLOG_ARG_NONE) { putchar('%'); continue; }
+    if (n >= sizeof(spec) || p + (kind == BLOG_ARG_STR ? 4 : 8) > end) { printf("<broken>"); return; }
+    memcpy(spec, pct, n);
+    spec[n] = '\0';
+    uint64_t v;
+    if (kind == BLOG_ARG_STR) {
+      uint32_t len;
+      memcpy(&len, p, 4);
+      p += 4;
+      if (p + len > end) { printf("<broken>"); return; }
+      char *s = strndup((const char *)p, len);
+      printf(spec, s);
+      free(s);
+      p += len;
+      continue;
+    }
+    memcpy(&v, p, 8);
+    p += 8;
+    switch (kind) {
+      case BLOG_ARG_INT: printf(spec, (int)v); break;
+      case BLOG_ARG_LONG: printf(spec, (long long)v); break;
+      case BLOG_ARG_PTR: printf(spec, (void *)(uintptr_t)v); break;
+      case BLOG_ARG_DOUBLE: { double d; memcpy(&d, &v, 8); printf(spec, d); break; }
+    }
+  }
+}
+
+static void decode_log() {
+  BLogRecord r;
+  uint8_t *buf = NULL;
+  uint32_t size = 0;
+  while (trace_read(&r, sizeof(r)) == sizeof(r) && r.len >= sizeof(r)) {
+    uint32_t len = r.len - sizeof(r);
+    if (len + 1 > size) {
+      size = len + 1;
+      buf = realloc(buf, size);
+      assert(buf != NULL);
+    }
+    if (trace_read(buf, len) != len) break;
+    buf[len] = '\0';
+    if (r.id & BLOG_DEF) {
+      uint32_t id = r.id & ~BLOG_DEF;
+      if (id >= nr_fmt) {
+        fmt = realloc(fmt, sizeof(*fmt) * (id + 1));
+        assert(fmt != NULL);
+        memset(fmt + nr_fmt, 0, sizeof(*fmt) * (id + 1 - nr_fmt));
+        nr_fmt = id + 1;
+      }
+      fmt[id] = strdup((char *)buf);
+    } else if (r.id == 0) {
+      fwrite(buf, 1, len, stdout);
+    } else if (r.id < nr_fmt && fmt[r.id] != NULL) {
+      print_message(fmt[r.id], buf, buf + len);
+    } else {
+      printf("<message of undefined format %u>\n", r.id);
+    }
+  }
+  free(buf);
+}
+
+int main(int argc, char *argv[]) {
+  if (argc < 2) {
+    fprintf(stderr, "usage: %s ITRACE_FILE [N] | FTRACE_FILE [folded|chrome] | LOG_FILE\n", argv[0]);
+    return 1;
+  }
+  if (!trace_open(argv[1])) {
+    perror(argv[1]);
+    return 1;
+  }
+
+  char magic[8];
+  if (trace_read(magic, sizeof(magic)) != sizeof(magic)) magic[0] = '\0';
+  if (memcmp(magic, BLOG_MAGIC, sizeof(magic)) == 0) {
+    decode_log();
+    trace_close();
+    return 0;
+  }
+  if (memcmp(magic, FTRACE_MAGIC, sizeof(magic)) == 0) {
+    FTraceHeader fh;
+    memcpy(fh.magic, magic, sizeof(magic));
+    if (trace_read(&fh.word_bytes, sizeof(fh) - sizeof(magic)) != sizeof(fh) - sizeof(magic) ||
+        !read_symbols(&fh)) {
+      fprintf(stderr, "%s is broken\n", argv[1]);
+      return 1;
+    }
+    int mode = SHOW_TREE;
+    if (argc > 2 && strcmp(argv[2], "folded") == 0) mode = SHOW_FOLDED;
+    else if (argc > 2 && strcmp(argv[2], "chrome") == 0) mode = SHOW_CHROME;
+    decode_ftrace(&fh, mode);
+    trace_close();
+    return 0;
+  }
+
+  ITraceHeader h;
+  memcpy(h.magic, magic, sizeof(magic));
+  if (memcmp(magic, ITRACE_MAGIC, sizeof(magic)) ||
+      trace_read((char *)&h + sizeof(magic), sizeof(h) - sizeof(magic)) != sizeof(h) - sizeof(magic)) {
+    if (ring.h != NULL) {
+      // such as the log, written out from the oldest byte
+      ring.header_pos = 0;
+      ring.pos = ring.h->begin;
+      char buf[65536];
+      int n;
+      while ((n = trace_read(buf, sizeof(buf))) > 0) fwrite(buf, 1, n, stdout);
+      return 0;
+    }
+    fprintf(stderr, "%s is not a trace file of NEMU\n", argv[1]);
+    return 1;
+  }
+  init_disasm(&h);
+  trace_skip_to_record(sizeof(ITraceRecord));
+
+  ITraceRecord r;
+  if (argc > 2) {
+    // a compressed file can not be read backwards, so keep the last n records
+    long n = atol(argv[2]), nr = 0, i;
+    if (n <= 0) return 0;
+    ITraceRecord *last = malloc(sizeof(ITraceRecord) * n);
+    assert(last != NULL);
+    while (trace_read(&last[nr % n], sizeof(r)) == sizeof(r)) nr ++;
+    for (i = (nr > n ? nr - n : 0); i < nr; i ++) print_record(&h, &last[i % n]);
+    free(last);
+  } else {
+    while (trace_read(&r, sizeof(r)) == sizeof(r)) print_record(&h, &r);
+  }
+  trace_close();
+  return 0;
+}
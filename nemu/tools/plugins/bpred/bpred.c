@@ -0,0 +1,344 @@
+/***************************************************************************************
+* Copyright (c) 2014-2024 Zihao Yu, Nanjing University
+*
+* NEMU is licensed under Mulan PSL v2.
+* You can use this software according to the terms and conditions of the Mulan PSL v2.
+* You may obtain a copy of Mulan PSL v2 at:
+*          http://license.coscl.org.cn/MulanPSL2
+*
+* THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+* EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+* MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+*
+* See the Mulan PSL v2 for more details.
+***************************************************************************************/
+
+/* A plugin simulating branch prediction for riscv guests.
+ *   usage: --plugin=tools/plugins/bpred/build/bpred-so[,PREDICTOR]
+ * PREDICTOR of conditional branches is bimodal, gshare or tage (a TAGE with
+ * a bimodal base and 4 tagged tables), tage by default. Targets of indirect
+ * jumps come from a BTB, and returns from a RAS. The mispredictions per
+ * thousand instructions (MPKI) are reported in total and per function on
+ * stderr at exit.
+ *
+ * Branches are found in the instructions of each block when it is
+ * translated. The next pc after a branch, which tells its outcome, is
+ * caught by the hook on the entry of the next block, or on the instruction
+ * after the branch in the same block if it is not the last one. Most
+ * branches end their blocks, so a block costs a single callback.
+ */
+
+#include <nemu-plugin.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+enum { BR_COND, BR_JUMP, BR_CALL, BR_RET, BR_INDIRECT, BR_INDIRECT_CALL };
+
+typedef struct Func {
+  const char *name; // NULL for the code outside any function
+  uint64_t inst, cond, cond_miss, indirect, indirect_miss, ret, ret_miss;
+  struct Func *next;
+} Func;
+
+typedef struct {
+  uint64_t pc, fallthrough;
+  int kind;
+  int left; // instructions after it in the block
+  Func *func;
+} Branch;
+
+typedef struct {
+  int ninsn;
+  Func *func;
+} Block;
+
+static const NEMUPluginAPI *api = NULL;
+static Func *funcs = NULL;
+static Branch *pending = NULL; // executed, with the next pc unknown yet
+static uint64_t nr_cond = 0, nr_cond_miss = 0, nr_indirect = 0, nr_indirect_miss = 0;
+static uint64_t nr_ret = 0, nr_ret_miss = 0;
+
+// --- predictors of conditional branches ---
+
+enum { PRED_BIMODAL, PRED_GSHARE, PRED_TAGE };
+static int pred = PRED_TAGE;
+
+#define BIMODAL_BITS 12
+#define GSHARE_BITS 14
+static uint8_t bimodal[1 << BIMODAL_BITS]; // 2-bit counters, taken if >= 2
+static uint8_t gshare[1 << GSHARE_BITS];
+static uint64_t ghr = 0; // global history, the latest outcome in bit 0
+
+static inline void ctr_update(uint8_t *c, bool taken, int max) {
+  if (taken) { if (*c < max) (*c) ++; }
+  else if (*c > 0) (*c) --;
+}
+
+#define TAGE_TABLES 4
+#define TAGE_BITS 10
+#define TAGE_TAG_BITS 9
+static const int tage_hist[TAGE_TABLES] = { 5, 12, 27, 60 };
+
+typedef struct {
+  uint16_t tag;
+  uint8_t ctr; // 3-bit, taken if >= 4
+  uint8_t u; // useful, 2-bit
+} TageEntry;
+static TageEntry tage[TAGE_TABLES][1 << TAGE_BITS];
+static uint64_t tage_seed = 1;
+
+// the latest `len` bits of the history folded into `bits` bits
+static inline uint32_t fold(int len, int bits) {
+  uint64_t h = (len >= 64 ? ghr : ghr & ((1ull << len) - 1));
+  uint32_t r = 0;
+  for (; h != 0; h >>= bits) r ^= h & ((1u << bits) - 1);
+  return r;
+}
+
+static inline uint32_t tage_idx(int t, uint64_t pc) {
+  return ((pc >> 1) ^ (pc >> (TAGE_BITS + 1)) ^ fold(tage_hist[t], TAGE_BITS)) & ((1 << TAGE_BITS) - 1);
+}
+
+static inline uint16_t tage_tag(int t, uint64_t pc) {
+  return ((pc >> 1) ^ fold(tage_hist[t], TAGE_TAG_BITS) ^ (fold(tage_hist[t], TAGE_TAG_BITS - 1) << 1)) &
+    ((1 << TAGE_TAG_BITS) - 1);
+}
+
+static bool tage_predict_update(uint64_t pc, bool taken) {
+  uint32_t idx[TAGE_TABLES];
+  uint16_t tag[TAGE_TABLES];
+  int t, provider = -1, alt = -1;
+  for (t = TAGE_TABLES - 1; t >= 0; t --) {
+    idx[t] = tage_idx(t, pc);
+    tag[t] = tage_tag(t, pc);
+    if (tage[t][idx[t]].tag == tag[t]) {
+      if (provider == -1) provider = t;
+      else if (alt == -1) alt = t;
+    }
+  }
+  uint8_t *base = &bimodal[(pc >> 1) & ((1 << BIMODAL_BITS) - 1)];
+  bool alt_pred = (alt >= 0 ? tage[alt][idx[alt]].ctr >= 4 : *base >= 2);
+  bool pred_taken = (provider >= 0 ? tage[provider][idx[provider]].ctr >= 4 : alt_pred);
+
+  if (provider >= 0) {
+    TageEntry *e = &tage[provider][idx[provider]];
+    if (pred_taken != alt_pred) ctr_update(&e->u, pred_taken == taken, 3);
+    ctr_update(&e->ctr, taken, 7);
+  } else ctr_update(base, taken, 3);
+
+  // allocate an entry of a longer history on a misprediction
+  if (pred_taken != taken && provider < TAGE_TABLES - 1) {
+    bool done = false;
+    for (t = provider + 1; t < TAGE_TABLES && !done; t ++) {
+      TageEntry *e = &tage[t][idx[t]];
+      if (e->u == 0) {
+        *e = (TageEntry) { .tag = tag[t], .ctr = (taken ? 4 : 3), .u = 0 };
+        done = true;
+      }
+    }
+    if (!done) {
+      // age the candidates now and then, so that entries can be freed
+      tage_seed ^= tage_seed << 13; tage_seed ^= tage_seed >> 7; tage_seed ^= tage_seed << 17;
+      if ((tage_seed & 3) == 0) {
+        for (t = provider + 1; t < TAGE_TABLES; t ++) if (tage[t][idx[t]].u > 0) tage[t][idx[t]].u --;
+      }
+    }
+  }
+  return pred_taken;
+}
+
+// predict the branch at `pc`, and update the predictor with the outcome
+static bool cond_predict_update(uint64_t pc, bool taken) {
+  bool ret;
+  switch (pred) {
+    case PRED_BIMODAL: {
+      uint8_t *c = &bimodal[(pc >> 1) & ((1 << BIMODAL_BITS) - 1)];
+      ret = (*c >= 2);
+      ctr_update(c, taken, 3);
+      break;
+    }
+    case PRED_GSHARE: {
+      uint8_t *c = &gshare[((pc >> 1) ^ ghr) & ((1 << GSHARE_BITS) - 1)];
+      ret = (*c >= 2);
+      ctr_update(c, taken, 3);
+      break;
+    }
+    default: ret = tage_predict_update(pc, taken); break;
+  }
+  ghr = (ghr << 1) | taken;
+  return ret;
+}
+
+// --- BTB and RAS ---
+
+#define BTB_SIZE 512
+#define RAS_SIZE 16
+static struct { uint64_t pc, target; } btb[BTB_SIZE];
+static uint64_t ras[RAS_SIZE];
+static int ras_top = 0; // wraps around, overwriting the oldest
+
+static bool btb_predict_update(uint64_t pc, uint64_t target) {
+  int i = (pc >> 1) % BTB_SIZE;
+  bool hit = (btb[i].pc == pc && btb[i].target == target);
+  btb[i].pc = pc;
+  btb[i].target = target;
+  return hit;
+}
+
+static void ras_push(uint64_t ret) { ras[ras_top ++ % RAS_SIZE] = ret; }
+static uint64_t ras_pop() { return ras[-- ras_top % RAS_SIZE]; }
+
+// --- hooks ---
+
+static void resolve(uint64_t next) {
+  Branch *b = pending;
+  pending = NULL;
+  Func *f = b->func;
+  bool taken = (next != b->fallthrough);
+  // the instructions after a branch taken in the middle of a block are not executed
+  if (taken && b->left > 0) f->inst -= b->left;
+  switch (b->kind) {
+    case BR_COND:
+      nr_cond ++; f->cond ++;
+      if (cond_predict_update(b->pc, taken) != taken) { nr_cond_miss ++; f->cond_miss ++; }
+      break;
+    case BR_CALL: ras_push(b->fallthrough); break;
+    case BR_RET:
+      nr_ret ++; f->ret ++;
+      if (ras_top == 0 || ras_pop() != next) { nr_ret_miss ++; f->ret_miss ++; }
+      if (ras_top < 0) ras_top = 0;
+      break;
+    case BR_INDIRECT_CALL: ras_push(b->fallthrough); // fall through
+    case BR_INDIRECT:
+      nr_indirect ++; f->indirect ++;
+      if (!btb_predict_update(b->pc, next)) { nr_indirect_miss ++; f->indirect_miss ++; }
+      break;
+  }
+}
+
+static void on_block(uint64_t pc, void *udata) {
+  Block *b = udata;
+  if (pending != NULL) resolve(pc);
+  b->func->inst += b->ninsn;
+}
+
+static void on_branch(uint64_t pc, void *udata) {
+  pending = udata;
+}
+
+// the instruction after a branch in the same block, which is only reached by falling through
+static void on_fallthrough(uint64_t pc, void *udata) {
+  if (pending != NULL) resolve(pc);
+}
+
+static Func* func_get(uint64_t pc) {
+  const char *name = api->symbol(pc);
+  Func *f;
+  for (f = funcs; f != NULL; f = f->next) {
+    if (f->name == name || (f->name != NULL && name != NULL && strcmp(f->name, name) == 0)) return f;
+  }
+  f = calloc(1, sizeof(Func));
+  f->name = name;
+  f->next = funcs;
+  funcs = f;
+  return f;
+}
+
+static inline bool is_link(int r) { return r == 1 || r == 5; }
+
+// return the kind of the branch, or -1 if it is not a branch
+static int decode(const uint8_t *p, int size) {
+  if (size == 2) {
+    uint16_t c = p[0] | (p[1] << 8);
+    int op = c & 3, funct3 = c >> 13, rs1 = (c >> 7) & 0x1f, rs2 = (c >> 2) & 0x1f;
+    if (op == 1 && (funct3 == 6 || funct3 == 7)) return BR_COND; // c.beqz, c.bnez
+    if (op == 1 && funct3 == 5) return BR_JUMP; // c.j
+    if (op == 1 && funct3 == 1) return BR_CALL; // c.jal of RV32
+    if (op == 2 && funct3 == 4 && rs2 == 0 && rs1 != 0) {
+      if ((c >> 12) & 1) return BR_INDIRECT_CALL; // c.jalr
+      return (is_link(rs1) ? BR_RET : BR_INDIRECT); // c.jr
+    }
+    return -1;
+  }
+  if (size != 4) return -1;
+  uint32_t i = p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+  int opcode = i & 0x7f, rd = (i >> 7) & 0x1f, rs1 = (i >> 15) & 0x1f;
+  switch (opcode) {
+    case 0x63: return BR_COND;
+    case 0x6f: return (is_link(rd) ? BR_CALL : BR_JUMP);
+    case 0x67:
+      if (is_link(rd)) return BR_INDIRECT_CALL;
+      return (rd == 0 && is_link(rs1) ? BR_RET : BR_INDIRECT);
+  }
+  return -1;
+}
+
+static void block_trans(nemu_block *nb, void *udata) {
+  int n = api->block_ninsn(nb), i;
+  Block *b = malloc(sizeof(Block));
+  *b = (Block) { .ninsn = n, .func = func_get(api->block_vaddr(nb)) };
+  api->block_exec_cb(nb, on_block, b);
+  for (i = 0; i < n; i ++) {
+    nemu_insn *insn = api->block_insn(nb, i);
+    int kind = decode(api->insn_data(insn), api->insn_size(insn));
+    if (kind < 0) continue;
+    Branch *br = malloc(sizeof(Branch));
+    uint64_t pc = api->insn_vaddr(insn);
+    *br = (Branch) { .pc = pc, .fallthrough = pc + api->insn_size(insn), .kind = kind,
+      .left = n - i - 1, .func = b->func };
+    api->insn_exec_cb(insn, on_branch, br);
+    if (i + 1 < n) api->insn_exec_cb(api->block_insn(nb, i + 1), on_fallthrough, NULL);
+  }
+}
+
+static int func_cmp(const void *a, const void *b) {
+  const Func *x = *(Func * const *)a, *y = *(Func * const *)b;
+  uint64_t mx = x->cond_miss + x->indirect_miss + x->ret_miss, my = y->cond_miss + y->indirect_miss + y->ret_miss;
+  return (mx < my) - (mx > my);
+}
+
+static double mpki(uint64_t miss, uint64_t inst) { return (inst == 0 ? 0 : miss * 1000.0 / inst); }
+
+static void report(void *udata) {
+  if (pending != NULL) pending = NULL;
+  uint64_t inst = 0;
+  int n = 0, i;
+  Func *f;
+  for (f = funcs; f != NULL; f = f->next) { inst += f->inst; n ++; }
+  static const char *name[] = { "bimodal", "gshare", "tage" };
+  fprintf(stderr, "bpred: %s, %lu instructions\n", name[pred], (unsigned long)inst);
+  fprintf(stderr, "bpred: conditional %lu, mispredicted %lu, MPKI %.3f\n", (unsigned long)nr_cond,
+      (unsigned long)nr_cond_miss, mpki(nr_cond_miss, inst));
+  fprintf(stderr, "bpred: indirect %lu, mispredicted by BTB %lu, MPKI %.3f\n", (unsigned long)nr_indirect,
+      (unsigned long)nr_indirect_miss, mpki(nr_indirect_miss, inst));
+  fprintf(stderr, "bpred: return %lu, mispredicted by RAS %lu, MPKI %.3f\n", (unsigned long)nr_ret,
+      (unsigned long)nr_ret_miss, mpki(nr_ret_miss, inst));
+
+  Func **all = malloc(sizeof(Func *) * (n + 1));
+  for (f = funcs, i = 0; f != NULL; f = f->next) all[i ++] = f;
+  qsort(all, n, sizeof(Func *), func_cmp);
+  fprintf(stderr, "%-24s %14s %10s %10s %10s %10s\n", "function", "instructions", "cond", "indirect", "return", "MPKI");
+  for (i = 0; i < n && i < 20; i ++) {
+    f = all[i];
+    fprintf(stderr, "%-24s %14lu %10lu %10lu %10lu %10.3f\n", (f->name != NULL ? f->name : "(unknown)"),
+        (unsigned long)f->inst, (unsigned long)f->cond_miss, (unsigned long)f->indirect_miss,
+        (unsigned long)f->ret_miss, mpki(f->cond_miss + f->indirect_miss + f->ret_miss, f->inst));
+  }
+  free(all);
+}
+
+int nemu_plugin_install(const NEMUPluginAPI *a, const char *arg) {
+  if (a->version != NEMU_PLUGIN_VERSION) return 1;
+  api = a;
+  if (strcmp(arg, "bimodal") == 0) pred = PRED_BIMODAL;
+  else if (strcmp(arg, "gshare") == 0) pred = PRED_GSHARE;
+  else if (arg[0] != '\0' && strcmp(arg, "tage") != 0) {
+    fprintf(stderr, "bpred: unknown predictor '%s'\n", arg);
+    return 1;
+  }
+  api->register_block_trans(block_trans, NULL);
+  api->register_exit(report, NULL);
+  return 0;
+}
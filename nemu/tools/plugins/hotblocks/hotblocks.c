@@ -0,0 +1,75 @@
+/***************************************************************************************
+* Copyright (c) 2014-2024 Zihao Yu, Nanjing University
+*
+* NEMU is licensed under Mulan PSL v2.
+* You can use this software according to the terms and conditions of the Mulan PSL v2.
+* You may obtain a copy of Mulan PSL v2 at:
+*          http://license.coscl.org.cn/MulanPSL2
+*
+* THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+* EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+* MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+*
+* See the Mulan PSL v2 for more details.
+***************************************************************************************/
+
+/* An example of plugins, which counts the executions of each block and the
+ * memory accesses of each instruction by inline counters, and prints the
+ * blocks executing the most instructions at exit.
+ *   usage: --plugin=tools/plugins/hotblocks/build/hotblocks-so[,N]
+ * where N is the number of blocks printed, 10 by default.
+ */
+
+#include <nemu-plugin.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+typedef struct {
+  uint64_t pc;
+  int ninsn;
+  uint64_t exec, mem;
+} Block;
+
+static Block **block = NULL;
+static int nr_block = 0, max_block = 0, nr_report = 10;
+static const NEMUPluginAPI *api = NULL;
+
+static void block_trans(nemu_block *b, void *udata) {
+  if (nr_block == max_block) {
+    max_block = (max_block == 0 ? 1024 : max_block * 2);
+    block = realloc(block, sizeof(Block *) * max_block);
+  }
+  Block *p = calloc(1, sizeof(Block));
+  p->pc = api->block_vaddr(b);
+  p->ninsn = api->block_ninsn(b);
+  block[nr_block ++] = p;
+  api->block_exec_inline(b, &p->exec, 1);
+  int i;
+  for (i = 0; i < p->ninsn; i ++) api->insn_mem_inline(api->block_insn(b, i), &p->mem, 1);
+}
+
+static int block_cmp(const void *a, const void *b) {
+  const Block *x = *(Block * const *)a, *y = *(Block * const *)b;
+  uint64_t nx = x->exec * x->ninsn, ny = y->exec * y->ninsn;
+  return (nx < ny) - (nx > ny);
+}
+
+static void report(void *udata) {
+  qsort(block, nr_block, sizeof(Block *), block_cmp);
+  fprintf(stderr, "hotblocks: %d blocks translated, the hottest:\n", nr_block);
+  fprintf(stderr, "%18s %6s %14s %14s\n", "pc", "insns", "executions", "mem accesses");
+  int i;
+  for (i = 0; i < nr_block && i < nr_report; i ++) {
+    fprintf(stderr, "%#18lx %6d %14lu %14lu\n", (unsigned long)block[i]->pc, block[i]->ninsn,
+        (unsigned long)block[i]->exec, (unsigned long)block[i]->mem);
+  }
+}
+
+int nemu_plugin_install(const NEMUPluginAPI *a, const char *arg) {
+  if (a->version != NEMU_PLUGIN_VERSION) return 1;
+  api = a;
+  if (arg[0] != '\0') nr_report = atoi(arg);
+  api->register_block_trans(block_trans, NULL);
+  api->register_exit(report, NULL);
+  return 0;
+}
@@ -23,11 +23,14 @@ struct gdb_conn;
 
 uint16_t gdb_decode_hex(uint8_t msb, uint8_t lsb);
 uint64_t gdb_decode_hex_str(uint8_t *bytes);
+size_t gdb_decode_hex_buf(uint8_t *dst, const uint8_t *hex, size_t n);
 
 uint8_t hex_encode(uint8_t digit);
 
 struct gdb_conn *gdb_begin_inet(const char *addr, uint16_t port);
 
+struct gdb_conn *gdb_begin_unix(const char *path);
+
 void gdb_end(struct gdb_conn *conn);
 
 void gdb_send(struct gdb_conn *conn, const uint8_t *command, size_t size);
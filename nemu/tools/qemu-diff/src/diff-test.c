@@ -18,11 +18,11 @@
 #include <sys/prctl.h>
 #include <signal.h>
 
-bool gdb_connect_qemu(int);
+bool gdb_connect_qemu(const char *);
 bool gdb_memcpy_to_qemu(uint32_t, void *, int);
 bool gdb_getregs(union isa_gdb_regs *);
 bool gdb_setregs(union isa_gdb_regs *);
-bool gdb_si();
+bool gdb_step(uint64_t);
 void gdb_exit();
 
 void init_isa();
@@ -47,12 +47,18 @@ __EXPORT void difftest_regcpy(void *dut, bool direction) {
 }
 
 __EXPORT void difftest_exec(uint64_t n) {
-  while (n --) gdb_si();
+  gdb_step(n);
 }
 
+/* The gdbstub of QEMU is reached through a unix domain socket instead of
+ * the loopback TCP, which avoids the TCP stack on each round trip. The
+ * socket is named after `port`, which used to be the TCP port. */
 __EXPORT void difftest_init(int port) {
-  char buf[32];
-  sprintf(buf, "tcp::%d", port);
+  char path[64];
+  char buf[96];
+  sprintf(path, "/tmp/nemu-qemu-diff-%d.sock", port);
+  sprintf(buf, "unix:%s,server=on,wait=off", path);
+  unlink(path);
 
   int ppid_before_fork = getpid();
   int pid = fork();
@@ -84,8 +90,10 @@ __EXPORT void difftest_init(int port) {
   else {
     // father
 
-    gdb_connect_qemu(port);
-    printf("Connect to QEMU with %s successfully\n", buf);
+    gdb_connect_qemu(path);
+    printf("Connect to QEMU with %s successfully\n", path);
+    // QEMU keeps the socket open, so the name is not needed any more
+    unlink(path);
 
     atexit(gdb_exit);
 
@@ -17,70 +17,191 @@
 
 static struct gdb_conn *conn;
 
-bool gdb_connect_qemu(int port) {
-  // connect to gdbserver on localhost port 1234
-  while ((conn = gdb_begin_inet("127.0.0.1", port)) == NULL) {
+/* In no-ack mode, requests whose replies are not needed right away (steps
+ * and register writes) are sent without waiting, and their replies are
+ * only drained before the next request expecting an answer. Stepping and
+ * then reading the registers thus costs a single round trip. The number
+ * of requests in flight is limited, so that neither side blocks on a full
+ * socket buffer. */
+#define MAX_IN_FLIGHT 64
+// at most 2 bytes per byte of data within the 4096-byte packets of QEMU
+#define MEM_CHUNK 1900
+
+static bool pipelined = false;
+static int nr_in_flight = 0;
+static bool use_binary = true;
+// whether single registers can be written with the P packet, unknown until tried
+static int use_p = -1;
+
+// the registers of QEMU, valid until it executes again
+static union isa_gdb_regs regs_cache;
+static bool regs_valid = false;
+
+static void drain() {
+  while (nr_in_flight > 0) {
+    size_t size;
+    uint8_t *reply = gdb_recv(conn, &size);
+    if (reply[0] == 'E') {
+      printf("qemu-diff: request failed with %s\n", reply);
+      assert(0);
+    }
+    free(reply);
+    nr_in_flight --;
+  }
+}
+
+// send a request whose reply is checked by drain()
+static void post(const char *buf, size_t len) {
+  gdb_send(conn, (const uint8_t *)buf, len);
+  nr_in_flight ++;
+  if (!pipelined || nr_in_flight >= MAX_IN_FLIGHT) drain();
+}
+
+// send a request and wait for its reply
+static uint8_t *request(const char *buf, size_t len, size_t *size) {
+  gdb_send(conn, (const uint8_t *)buf, len);
+  drain();
+  return gdb_recv(conn, size);
+}
+
+bool gdb_connect_qemu(const char *path) {
+  // QEMU creates the socket after starting
+  while ((conn = gdb_begin_unix(path)) == NULL) {
     usleep(1);
   }
 
+  pipelined = !strcmp(gdb_start_noack(conn), "OK");
   return true;
 }
 
-static bool gdb_memcpy_to_qemu_small(uint32_t dest, void *src, int len) {
+static bool check_ok(uint8_t *reply) {
+  bool ok = !strcmp((const char*)reply, "OK");
+  free(reply);
+  return ok;
+}
+
+static bool gdb_memcpy_to_qemu_hex(uint32_t dest, void *src, int len) {
   char *buf = malloc(len * 2 + 128);
   assert(buf != NULL);
   int p = sprintf(buf, "M0x%x,%x:", dest, len);
   int i;
   for (i = 0; i < len; i ++) {
-    p += sprintf(buf + p, "%c%c", hex_encode(((uint8_t *)src)[i] >> 4), hex_encode(((uint8_t *)src)[i] & 0xf));
+    buf[p ++] = hex_encode(((uint8_t *)src)[i] >> 4);
+    buf[p ++] = hex_encode(((uint8_t *)src)[i] & 0xf);
   }
 
-  gdb_send(conn, (const uint8_t *)buf, strlen(buf));
+  size_t size;
+  uint8_t *reply = request(buf, p, &size);
   free(buf);
+  return check_ok(reply);
+}
 
-  size_t size;
-  uint8_t *reply = gdb_recv(conn, &size);
-  bool ok = !strcmp((const char*)reply, "OK");
-  free(reply);
+// the X packet carries raw bytes, with '#', '$', '}' and '*' escaped
+static bool gdb_memcpy_to_qemu_small(uint32_t dest, void *src, int len) {
+  if (!use_binary) return gdb_memcpy_to_qemu_hex(dest, src, len);
 
-  return ok;
+  char *buf = malloc(len * 2 + 128);
+  assert(buf != NULL);
+  int p = sprintf(buf, "X%x,%x:", dest, len);
+  int i;
+  for (i = 0; i < len; i ++) {
+    uint8_t c = ((uint8_t *)src)[i];
+    if (c == '#' || c == '$' || c == '}' || c == '*') {
+      buf[p ++] = '}';
+      c ^= 0x20;
+    }
+    buf[p ++] = c;
+  }
+
+  size_t size;
+  uint8_t *reply = request(buf, p, &size);
+  free(buf);
+  if (size == 0) {
+    // not supported by this gdbserver
+    free(reply);
+    use_binary = false;
+    return gdb_memcpy_to_qemu_hex(dest, src, len);
+  }
+  return check_ok(reply);
 }
 
 bool gdb_memcpy_to_qemu(uint32_t dest, void *src, int len) {
-  const int mtu = 1500;
   bool ok = true;
-  while (len > mtu) {
-    ok &= gdb_memcpy_to_qemu_small(dest, src, mtu);
-    dest += mtu;
-    src += mtu;
-    len -= mtu;
+  while (len > MEM_CHUNK) {
+    ok &= gdb_memcpy_to_qemu_small(dest, src, MEM_CHUNK);
+    dest += MEM_CHUNK;
+    src += MEM_CHUNK;
+    len -= MEM_CHUNK;
   }
   ok &= gdb_memcpy_to_qemu_small(dest, src, len);
   return ok;
 }
 
 bool gdb_getregs(union isa_gdb_regs *r) {
-  gdb_send(conn, (const uint8_t *)"g", 1);
+  if (regs_valid) {
+    *r = regs_cache;
+    return true;
+  }
+
   size_t size;
-  uint8_t *reply = gdb_recv(conn, &size);
+  uint8_t *reply = request("g", 1, &size);
 
-  int i;
-  uint8_t *p = reply;
-  uint8_t c;
-  for (i = 0; i < sizeof(union isa_gdb_regs) / sizeof(uint32_t); i ++) {
-    c = p[8];
-    p[8] = '\0';
-    r->array[i] = gdb_decode_hex_str(p);
-    p[8] = c;
-    p += 8;
-  }
+  // the registers are in target byte order as in gdb_setregs()
+  size_t n = size / 2;
+  if (n > sizeof(*r)) n = sizeof(*r);
+  n = gdb_decode_hex_buf((uint8_t *)r, reply, n);
+  memset((uint8_t *)r + n, 0, sizeof(*r) - n);
 
   free(reply);
 
+  regs_cache = *r;
+  regs_valid = true;
+  return true;
+}
+
+static void hex_word(char *buf, uint32_t w) {
+  int i;
+  for (i = 0; i < 4; i ++, w >>= 8) {
+    buf[i * 2] = hex_encode((w >> 4) & 0xf);
+    buf[i * 2 + 1] = hex_encode(w & 0xf);
+  }
+}
+
+/* Write the registers different from the cache one by one. The registers
+ * of the gdb stub are 32-bit words in the same order as the array, and
+ * their values are in target byte order as the G packet. Return false to
+ * fall back to the G packet. */
+static bool setregs_delta(union isa_gdb_regs *r) {
+  int nr = sizeof(union isa_gdb_regs) / sizeof(uint32_t);
+  int i, nr_diff = 0;
+  for (i = 0; i < nr; i ++) nr_diff += (r->array[i] != regs_cache.array[i]);
+  // each P packet is about 13 bytes, while the G packet is 8 bytes per register
+  if (nr_diff * 2 > nr) return false;
+
+  for (i = 0; i < nr; i ++) {
+    if (r->array[i] == regs_cache.array[i]) continue;
+    char buf[32];
+    int p = sprintf(buf, "P%x=", i);
+    hex_word(buf + p, r->array[i]);
+    p += 8;
+    if (use_p == -1) {
+      // probe once with a request waiting for its reply
+      size_t size;
+      uint8_t *reply = request(buf, p, &size);
+      use_p = !strcmp((const char *)reply, "OK");
+      free(reply);
+      if (!use_p) return false;
+    } else {
+      post(buf, p);
+    }
+    regs_cache.array[i] = r->array[i];
+  }
   return true;
 }
 
 bool gdb_setregs(union isa_gdb_regs *r) {
+  if (regs_valid && use_p != 0 && setregs_delta(r)) return true;
+
   int len = sizeof(union isa_gdb_regs);
   char *buf = malloc(len * 2 + 128);
   assert(buf != NULL);
@@ -90,26 +211,24 @@ bool gdb_setregs(union isa_gdb_regs *r) {
   int p = 1;
   int i;
   for (i = 0; i < len; i ++) {
-    p += sprintf(buf + p, "%c%c", hex_encode(((uint8_t *)src)[i] >> 4), hex_encode(((uint8_t *)src)[i] & 0xf));
+    buf[p ++] = hex_encode(((uint8_t *)src)[i] >> 4);
+    buf[p ++] = hex_encode(((uint8_t *)src)[i] & 0xf);
   }
 
-  gdb_send(conn, (const uint8_t *)buf, strlen(buf));
+  // a failure is caught by drain()
+  post(buf, p);
   free(buf);
 
-  size_t size;
-  uint8_t *reply = gdb_recv(conn, &size);
-  bool ok = !strcmp((const char*)reply, "OK");
-  free(reply);
-
-  return ok;
+  regs_cache = *r;
+  regs_valid = true;
+  return true;
 }
 
-bool gdb_si() {
-  char buf[] = "vCont;s:1";
-  gdb_send(conn, (const uint8_t *)buf, strlen(buf));
-  size_t size;
-  uint8_t *reply = gdb_recv(conn, &size);
-  free(reply);
+bool gdb_step(uint64_t n) {
+  // the gdb protocol has no step count, so the steps are pipelined instead
+  static const char buf[] = "vCont;s:1";
+  while (n --) post(buf, sizeof(buf) - 1);
+  regs_valid = false;
   return true;
 }
 
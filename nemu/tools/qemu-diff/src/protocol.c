@@ -18,8 +18,8 @@
  */
 
 #include "common.h"
-#include <ctype.h>
 #include <err.h>
+#include <errno.h>
 
 #include <arpa/inet.h>
 
@@ -28,34 +28,59 @@
 
 #include <sys/socket.h>
 #include <sys/types.h>
+#include <sys/un.h>
+
+/* Replies are read with recv() into a buffer large enough for a whole
+ * register dump, and scanned there, instead of through stdio one character
+ * at a time. */
+#define RECV_BUF_SIZE 16384
 
 struct gdb_conn {
-  FILE *in;
+  int fd;
   FILE *out;
   bool ack;
+  size_t in_pos, in_len;
+  uint8_t in_buf[RECV_BUF_SIZE];
 };
 
-
-static uint8_t
-hex_nibble(uint8_t hex) {
-  return isdigit(hex) ? hex - '0' : tolower(hex) - 'a' + 10;
-}
+// 0x10 | value for hex digits, 0 otherwise
+#define H(c, v) [c] = 0x10 | (v)
+static const uint8_t hex_table[256] = {
+  H('0', 0), H('1', 1), H('2', 2), H('3', 3), H('4', 4),
+  H('5', 5), H('6', 6), H('7', 7), H('8', 8), H('9', 9),
+  H('a', 10), H('b', 11), H('c', 12), H('d', 13), H('e', 14), H('f', 15),
+  H('A', 10), H('B', 11), H('C', 12), H('D', 13), H('E', 14), H('F', 15),
+};
+#undef H
 
 uint8_t hex_encode(uint8_t digit) {
   return digit > 9 ? 'a' + digit - 10 : '0' + digit;
 }
 
 uint16_t gdb_decode_hex(uint8_t msb, uint8_t lsb) {
-  if (!isxdigit(msb) || !isxdigit(lsb))
+  uint8_t h = hex_table[msb], l = hex_table[lsb];
+  if (!(h & l & 0x10))
     return UINT16_MAX;
-  return 16 * hex_nibble(msb) + hex_nibble(lsb);
+  return ((h & 0xf) << 4) | (l & 0xf);
+}
+
+size_t gdb_decode_hex_buf(uint8_t *dst, const uint8_t *hex, size_t n) {
+  size_t i;
+  for (i = 0; i < n; i ++) {
+    uint8_t h = hex_table[hex[2 * i]], l = hex_table[hex[2 * i + 1]];
+    if (!(h & l & 0x10))
+      break;
+    dst[i] = ((h & 0xf) << 4) | (l & 0xf);
+  }
+  return i;
 }
 
 uint64_t gdb_decode_hex_str(uint8_t *bytes) {
   uint64_t value = 0;
   uint64_t weight = 1;
-  while (isxdigit(bytes[0]) && isxdigit(bytes[1])) {
-    value += weight * gdb_decode_hex(bytes[0], bytes[1]);
+  uint16_t byte;
+  while ((byte = gdb_decode_hex(bytes[0], bytes[1])) != UINT16_MAX) {
+    value += weight * byte;
     bytes += 2;
     weight *= 16 * 16;
   }
@@ -69,17 +94,13 @@ static struct gdb_conn* gdb_begin(int fd) {
     err(1, "calloc");
 
   conn->ack = true;
+  conn->fd = fd;
 
   // duplicate the handle to separate read/write state
   int fd2 = dup(fd);
   if (fd2 < 0)
     err(1, "dup");
 
-  // open a FILE* for reading
-  conn->in = fdopen(fd, "rb");
-  if (conn->in == NULL)
-    err(1, "fdopen");
-
   // open a FILE* for writing
   conn->out = fdopen(fd2, "wb");
   if (conn->out == NULL)
@@ -128,13 +149,55 @@ struct gdb_conn* gdb_begin_inet(const char *addr, uint16_t port) {
   return gdb_begin(fd);
 }
 
+struct gdb_conn* gdb_begin_unix(const char *path) {
+  struct sockaddr_un sa = { .sun_family = AF_UNIX };
+  if (strlen(path) >= sizeof(sa.sun_path))
+    errx(1, "Socket path too long: %s", path);
+  strcpy(sa.sun_path, path);
+
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0)
+    err(1, "socket");
+  if (connect(fd, (const struct sockaddr *)&sa, sizeof(sa)) != 0) {
+    close(fd);
+    return NULL;
+  }
+
+  return gdb_begin(fd);
+}
 
 void gdb_end(struct gdb_conn *conn) {
-  fclose(conn->in);
+  close(conn->fd);
   fclose(conn->out);
   free(conn);
 }
 
+// refill the receive buffer, which must have been consumed
+static void recv_fill(struct gdb_conn *conn) {
+  ssize_t n;
+  do {
+    n = recv(conn->fd, conn->in_buf, sizeof(conn->in_buf), 0);
+  } while (n < 0 && errno == EINTR);
+  if (n < 0)
+    err(1, "recv");
+  else if (n == 0)
+    errx(0, "recv: Connection closed");
+  conn->in_pos = 0;
+  conn->in_len = n;
+}
+
+static uint8_t recv_peek(struct gdb_conn *conn) {
+  if (conn->in_pos == conn->in_len)
+    recv_fill(conn);
+  return conn->in_buf[conn->in_pos];
+}
+
+static uint8_t recv_char(struct gdb_conn *conn) {
+  uint8_t c = recv_peek(conn);
+  conn->in_pos ++;
+  return c;
+}
+
 static void send_packet(FILE *out, const uint8_t *command, size_t size) {
   // compute the checksum -- simple mod256 addition
   uint8_t sum = 0;
@@ -166,77 +229,103 @@ void gdb_send(struct gdb_conn *conn, const uint8_t *command, size_t size) {
       break;
 
     // look for '+' ACK or '-' NACK/resend
-    acked = fgetc(conn->in) == '+';
+    acked = recv_char(conn) == '+';
   } while (!acked);
 }
 
-static uint8_t* recv_packet(FILE *in, size_t *ret_size, bool* ret_sum_ok) {
+// make room for n more characters after the first i of the reply
+static uint8_t* reserve(uint8_t *reply, size_t *size, size_t i, size_t n) {
+  if (i + n <= *size)
+    return reply;
+  while (i + n > *size)
+    *size *= 2;
+  reply = realloc(reply, *size);
+  if (reply == NULL)
+    err(1, "realloc");
+  return reply;
+}
+
+static uint8_t* recv_packet(struct gdb_conn *conn, size_t *ret_size, bool* ret_sum_ok) {
   size_t i = 0;
   size_t size = 4096;
   uint8_t *reply = malloc(size);
   if (reply == NULL)
     err(1, "malloc");
 
-  int c;
+  uint8_t c;
   uint8_t sum = 0;
-  bool escape = false;
 
   // fast-forward to the first start of packet
-  while ((c = fgetc(in)) != EOF && c != '$');
+  for (;;) {
+    uint8_t *p = conn->in_buf + conn->in_pos;
+    uint8_t *start = memchr(p, '$', conn->in_len - conn->in_pos);
+    if (start != NULL) {
+      conn->in_pos += start - p + 1;
+      break;
+    }
+    recv_fill(conn);
+  }
 
-  while ((c = fgetc(in)) != EOF) {
-    sum += c;
+  for (;;) {
+    // copy the run of plain characters up to the next special one
+    const uint8_t *p = conn->in_buf + conn->in_pos;
+    size_t avail = conn->in_len - conn->in_pos;
+    size_t n;
+    for (n = 0; n < avail; n ++) {
+      c = p[n];
+      if (c == '$' || c == '#' || c == '}' || c == '*')
+        break;
+      sum += c;
+    }
+    reply = reserve(reply, &size, i, n);
+    memcpy(&reply[i], p, n);
+    i += n;
+    conn->in_pos += n;
+    if (n == avail) {
+      recv_fill(conn);
+      continue;
+    }
+
+    c = recv_char(conn);
     switch (c) {
       case '$': // new packet?  start over...
         i = 0;
         sum = 0;
-        escape = false;
         continue;
 
-      case '#': // end of packet
-        sum -= c; // not part of the checksum
+      case '#': // end of packet, the checksum is not part of the checksum
         {
-          uint8_t msb = fgetc(in);
-          uint8_t lsb = fgetc(in);
+          uint8_t msb = recv_char(conn);
+          uint8_t lsb = recv_char(conn);
           *ret_sum_ok = sum == gdb_decode_hex(msb, lsb);
         }
         *ret_size = i;
 
         // terminate it for good measure
-        if (i == size) {
-          reply = realloc(reply, size + 1);
-          if (reply == NULL)
-            err(1, "realloc");
-        }
+        reply = reserve(reply, &size, i, 1);
         reply[i] = '\0';
 
         return reply;
 
       case '}': // escape: next char is XOR 0x20
-        escape = true;
-        continue;
+        sum += c;
+        c = recv_char(conn);
+        sum += c;
+        c ^= 0x20;
+        break;
 
       case '*': // run-length-encoding
         // The next character tells how many times to repeat the last
         // character we saw.  The count is added to 29, so that the
         // minimum-beneficial RLE 3 is the first printable character ' '.
         // The count character can't be >126 or '$'/'#' packet markers.
-
+        sum += c;
         if (i > 0) { // need something to repeat!
-          int c2 = fgetc(in);
-          if (c2 < 29 || c2 > 126 || c2 == '$' || c2 == '#') {
-            // invalid count character!
-            ungetc(c2, in);
-          } else {
+          uint8_t c2 = recv_peek(conn);
+          if (!(c2 < 29 || c2 > 126 || c2 == '$' || c2 == '#')) {
             int count = c2 - 29;
-
-            // get a bigger buffer if needed
-            if (i + count > size) {
-              size *= 2;
-              reply = realloc(reply, size);
-              if (reply == NULL)
-                err(1, "realloc");
-            }
+            conn->in_pos ++;
+            reply = reserve(reply, &size, i, count);
 
             // fill the repeated character
             memset(&reply[i], reply[i - 1], count);
@@ -245,39 +334,21 @@ static uint8_t* recv_packet(FILE *in, size_t *ret_size, bool* ret_sum_ok) {
             continue;
           }
         }
-    }
-
-    // XOR an escaped character
-    if (escape) {
-      c ^= 0x20;
-      escape = false;
-    }
-
-    // get a bigger buffer if needed
-    if (i == size) {
-      size *= 2;
-      reply = realloc(reply, size);
-      if (reply == NULL)
-        err(1, "realloc");
+        // invalid count character, keep the '*' as it is
+        break;
     }
 
     // add one character
+    reply = reserve(reply, &size, i, 1);
     reply[i++] = c;
   }
-
-  if (ferror(in))
-    err(1, "recv");
-  else if (feof(in))
-    errx(0, "recv: Connection closed");
-  else
-    errx(1, "recv: Unknown connection error");
 }
 
 uint8_t* gdb_recv(struct gdb_conn *conn, size_t *size) {
   uint8_t *reply;
   bool acked = false;
   do {
-    reply = recv_packet(conn->in, size, &acked);
+    reply = recv_packet(conn, size, &acked);
 
     if (!conn->ack)
       break;
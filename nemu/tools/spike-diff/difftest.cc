@@ -16,6 +16,7 @@
 #include "mmu.h"
 #include "sim.h"
 #include "../../include/common.h"
+#include <algorithm>
 #include <difftest-def.h>
 
 #define NR_GPR MUXDEF(CONFIG_RVE, 16, 32)
@@ -70,20 +71,35 @@ void sim_t::diff_set_regs(void* diff_context) {
   state->pc = ctx->pc;
 }
 
-void sim_t::diff_memcpy(reg_t dest, void* src, size_t n) {
-  mmu_t* mmu = p->get_mmu();
-  for (size_t i = 0; i < n; i++) {
-    mmu->store<uint8_t>(dest+i, *((uint8_t*)src+i));
+// The host memory of spike is only contiguous within a page, so memory is
+// copied page by page, instead of byte by byte through the MMU.
+static void mem_copy(reg_t addr, uint8_t *buf, size_t n, bool to_ref) {
+  simif_t *sim = s;
+  while (n > 0) {
+    size_t len = std::min<size_t>(n, PGSIZE - addr % PGSIZE);
+    char *host = sim->addr_to_mem(addr);
+    assert(host != NULL);
+    if (to_ref) memcpy(host, buf, len);
+    else memcpy(buf, host, len);
+    addr += len;
+    buf += len;
+    n -= len;
   }
 }
 
+void sim_t::diff_memcpy(reg_t dest, void* src, size_t n) {
+  mem_copy(dest, (uint8_t *)src, n, true);
+  // the instructions decoded from the memory may be out of date
+  p->get_mmu()->flush_icache();
+}
+
 extern "C" {
 
 __EXPORT void difftest_memcpy(paddr_t addr, void *buf, size_t n, bool direction) {
   if (direction == DIFFTEST_TO_REF) {
     s->diff_memcpy(addr, buf, n);
   } else {
-    assert(0);
+    mem_copy(addr, (uint8_t *)buf, n, false);
   }
 }
 
@@ -99,6 +115,16 @@ __EXPORT void difftest_exec(uint64_t n) {
   s->diff_step(n);
 }
 
+// step `n` instructions, and write the registers after each of them to
+// `log`, DIFFTEST_REG_SIZE bytes each
+__EXPORT void difftest_exec_log(uint64_t n, void *log) {
+  uint8_t *ctx = (uint8_t *)log;
+  for (; n > 0; n --, ctx += DIFFTEST_REG_SIZE) {
+    s->diff_step(1);
+    s->diff_get_regs(ctx);
+  }
+}
+
 __EXPORT void difftest_init(int port) {
   difftest_htif_args.push_back("");
   const char *isa = "RV" MUXDEF(CONFIG_RV64, "64", "32") MUXDEF(CONFIG_RVE, "E", "I") "MAFDC";